@@ -38,6 +38,8 @@
   BOOL _selected;
   BOOL _highlighted;
   BOOL _neverShowPlaceholders;
+  BOOL _hasDisplayedContents;
+  CFTimeInterval _didEnterDisplayTime;
 }
 
 @end
@@ -263,6 +265,43 @@
   // To be overriden by subclasses
 }
 
+- (void)didEnterDisplayState
+{
+  [super didEnterDisplayState];
+  _didEnterDisplayTime = CACurrentMediaTime();
+  _hasDisplayedContents = NO;
+}
+
+- (void)didExitDisplayState
+{
+  [super didExitDisplayState];
+  _didEnterDisplayTime = 0;
+  _hasDisplayedContents = NO;
+}
+
+- (void)hierarchyDisplayDidFinish
+{
+  [super hierarchyDisplayDidFinish];
+  if (_didEnterDisplayTime > 0 && !_hasDisplayedContents) {
+    _hasDisplayedContents = YES;
+    _unreportedDisplayDuration = CACurrentMediaTime() - _didEnterDisplayTime;
+  }
+}
+
+- (BOOL)hasDisplayedContents
+{
+  ASDisplayNodeAssertMainThread();
+  if (_hasDisplayedContents) {
+    return YES;
+  }
+  // A cell without anything to draw never finishes displaying. Display starts with the next transaction, so once
+  // a frame has passed, nothing pending means there is nothing to wait for.
+  static const CFTimeInterval kFrameDuration = 1.0 / 60.0;
+  return (_didEnterDisplayTime > 0
+          && CACurrentMediaTime() - _didEnterDisplayTime > kFrameDuration
+          && (_pendingDisplayNodes == nil || _pendingDisplayNodes.isEmpty));
+}
+
 - (void)didEnterVisibleState
 {
   [super didEnterVisibleState];
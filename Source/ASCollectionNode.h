@@ -484,7 +484,8 @@ NS_ASSUME_NONNULL_BEGIN
  *
  * @param indexPath The index path of the requested item.
  *
- * @return The node for the given item, or @c nil if no item exists at the specified path.
+ * @return The node for the given item, or @c nil if no item exists at the specified path or the item is not
+ *   materialized yet (exp_windowed_reload).
  */
 - (nullable __kindof ASCellNode *)nodeForItemAtIndexPath:(NSIndexPath *)indexPath AS_WARN_UNUSED_RESULT;
 
@@ -777,6 +778,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (ASSizeRange)collectionNode:(ASCollectionNode *)collectionNode constrainedSizeForItemAtIndexPath:(NSIndexPath *)indexPath;
 
+/**
+ * Provides the estimated size of the items in the given section.
+ *
+ * With exp_windowed_reload, a reload only creates the nodes of the items around the visible ones in sections with a
+ * non-zero estimate. The other items are laid out with the estimated size until their nodes are created, as they
+ * come into range.
+ *
+ * @param collectionNode The sender.
+ *
+ * @param section The section of the items.
+ *
+ * @return The estimated size of the items, or CGSizeZero to create the nodes of all items in the section.
+ */
+- (CGSize)collectionNode:(ASCollectionNode *)collectionNode estimatedSizeForItemsInSection:(NSInteger)section;
+
 - (void)collectionNode:(ASCollectionNode *)collectionNode willDisplayItemWithNode:(ASCellNode *)node;
 
 - (void)collectionNode:(ASCollectionNode *)collectionNode didEndDisplayingItemWithNode:(ASCellNode *)node;
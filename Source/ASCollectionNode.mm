@@ -908,7 +908,8 @@
 - (ASCellNode *)nodeForItemAtIndexPath:(NSIndexPath *)indexPath
 {
   [self reloadDataInitiallyIfNeeded];
-  return [self.dataController.pendingMap elementForItemAtIndexPath:indexPath].node;
+  ASCollectionElement *element = [self.dataController.pendingMap elementForItemAtIndexPath:indexPath];
+  return element.isPlaceholder ? nil : element.node;
 }
 
 - (id)nodeModelForItemAtIndexPath:(NSIndexPath *)indexPath
@@ -23,6 +23,7 @@
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/ASElementMap.h>
+#import <AsyncDisplayKit/ASEqualityHelpers.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/UICollectionViewLayout+ASConvenience.h>
 #import <AsyncDisplayKit/ASRangeController.h>
@@ -115,6 +116,7 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   NSCountedSet<ASCollectionElement *> *_visibleElements;
   
   CGPoint _deceleratingVelocity;
+  CGPoint _targetContentOffset;
 
   BOOL _zeroContentInsets;
   
@@ -197,6 +199,7 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
     unsigned int collectionNodeShouldShowMenuForItem:1;
     unsigned int collectionNodeCanPerformActionForItem:1;
     unsigned int collectionNodePerformActionForItem:1;
+    unsigned int collectionNodeEstimatedSizeForItems:1;
     unsigned int collectionNodeWillBeginBatchFetch:1;
     unsigned int collectionNodeWillDisplaySupplementaryElement:1;
     unsigned int collectionNodeDidEndDisplayingSupplementaryElement:1;
@@ -561,6 +564,7 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
     _asyncDelegateFlags.collectionNodeShouldShowMenuForItem = [_asyncDelegate respondsToSelector:@selector(collectionNode:shouldShowMenuForItemAtIndexPath:)];
     _asyncDelegateFlags.collectionNodeCanPerformActionForItem = [_asyncDelegate respondsToSelector:@selector(collectionNode:canPerformAction:forItemAtIndexPath:sender:)];
     _asyncDelegateFlags.collectionNodePerformActionForItem = [_asyncDelegate respondsToSelector:@selector(collectionNode:performAction:forItemAtIndexPath:sender:)];
+    _asyncDelegateFlags.collectionNodeEstimatedSizeForItems = [_asyncDelegate respondsToSelector:@selector(collectionNode:estimatedSizeForItemsInSection:)];
     _asyncDelegateFlags.collectionNodeWillDisplaySupplementaryElement = [_asyncDelegate respondsToSelector:@selector(collectionNode:willDisplaySupplementaryElementWithNode:)];
     _asyncDelegateFlags.collectionNodeDidEndDisplayingSupplementaryElement = [_asyncDelegate respondsToSelector:@selector(collectionNode:didEndDisplayingSupplementaryElementWithNode:)];
     _asyncDelegateFlags.interop = [_asyncDelegate conformsToProtocol:@protocol(ASCollectionDelegateInterop)];
@@ -682,6 +686,10 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   if (element == nil) {
     return CGSizeZero;
   }
+  if (element.isPlaceholder) {
+    // The estimated size, the item is materialized when it comes into range.
+    return element.constrainedSize.max;
+  }
 
   ASCellNode *node = element.node;
   ASDisplayNodeAssertNotNil(node, @"Node must not be nil!");
@@ -715,7 +723,8 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
 
 - (ASCellNode *)nodeForItemAtIndexPath:(NSIndexPath *)indexPath
 {
-  return [_dataController.visibleMap elementForItemAtIndexPath:indexPath].node;
+  ASCollectionElement *element = [_dataController.visibleMap elementForItemAtIndexPath:indexPath];
+  return element.isPlaceholder ? nil : element.node;
 }
 
 - (NSIndexPath *)convertIndexPathFromCollectionNode:(NSIndexPath *)indexPath waitingIfNeeded:(BOOL)wait
@@ -1196,6 +1205,14 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
 {
   UICollectionViewCell *cell = nil;
   ASCollectionElement *element = [_dataController.visibleMap elementForItemAtIndexPath:indexPath];
+  if (element.isPlaceholder) {
+    // The layout has the estimated size so far.
+    CGSize estimatedSize = element.constrainedSize.max;
+    element = [_dataController materializedElementForItemAtIndexPath:indexPath];
+    if (!element.isPlaceholder && !CGSizeEqualToSize([self sizeForElement:element], estimatedSize)) {
+      [self nodesDidRelayout:@[element.node]];
+    }
+  }
   ASCellNode *node = element.node;
   ASWrapperCellNode *wrapperNode = (node.shouldUseUIKitCell ? (ASWrapperCellNode *)node : nil);
   BOOL shouldDequeueExternally = _asyncDataSourceFlags.interopAlwaysDequeue || (_asyncDataSourceFlags.interop && wrapperNode);
@@ -1236,7 +1253,7 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
 
   ASCollectionElement *element = cell.element;
   if (element) {
-    ASDisplayNodeAssertTrue([_dataController.visibleMap elementForItemAtIndexPath:indexPath] == element);
+    ASDisplayNodeAssertTrue(ASObjectIsEqual([_dataController.visibleMap elementForItemAtIndexPath:indexPath], element));
     [_visibleElements addObject:element];
   } else {
     ASDisplayNodeAssert(NO, @"Unexpected nil element for willDisplayCell: %@, %@, %@", rawCell, self, indexPath);
@@ -1663,6 +1680,8 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   if (_asyncDelegateFlags.scrollViewWillEndDragging) {
     [_asyncDelegate scrollViewWillEndDragging:scrollView withVelocity:velocity targetContentOffset:(targetContentOffset ? : &contentOffset)];
   }
+  // Read after the delegate, which may have changed the target.
+  _targetContentOffset = (targetContentOffset != NULL) ? *targetContentOffset : contentOffset;
 }
 
 - (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
@@ -1942,6 +1961,25 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   return ASCellLayoutModeIncludes(ASCellLayoutModeSerializeNodeCreation);
 }
 
+- (NSArray<NSIndexPath *> *)visibleIndexPathsForDataController:(ASDataController *)dataController
+{
+  return self.indexPathsForVisibleItems;
+}
+
+- (void)dataController:(ASDataController *)dataController didRelayoutNodes:(NSArray<ASCellNode *> *)nodesSizeChanged
+{
+  [self nodesDidRelayout:nodesSizeChanged];
+}
+
+- (CGSize)dataController:(ASDataController *)dataController estimatedSizeForItemsInSection:(NSInteger)section
+{
+  if (_asyncDelegateFlags.collectionNodeEstimatedSizeForItems) {
+    GET_COLLECTIONNODE_OR_RETURN(collectionNode, CGSizeZero);
+    return [_asyncDelegate collectionNode:collectionNode estimatedSizeForItemsInSection:section];
+  }
+  return CGSizeZero;
+}
+
 - (id)dataController:(ASDataController *)dataController nodeModelForItemAtIndexPath:(NSIndexPath *)indexPath
 {
   if (!_asyncDataSourceFlags.nodeModelForItem) {
@@ -2216,11 +2254,24 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   return self.scrollDirection;
 }
 
+- (ASScrollMotion)scrollMotionForRangeController:(ASRangeController *)rangeController
+{
+  return ASScrollMotionForScrollView(self, self.scrollableDirections, _targetContentOffset);
+}
+
 - (ASInterfaceState)interfaceStateForRangeController:(ASRangeController *)rangeController
 {
   return ASInterfaceStateForDisplayNode(self.collectionNode, self.window);
 }
 
+- (void)rangeController:(ASRangeController *)rangeController materializePlaceholdersAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+  __weak __typeof__(self) weakSelf = self;
+  [_dataController materializeItemsAtIndexPaths:indexPaths completion:^{
+    [weakSelf.rangeController setNeedsUpdate];
+  }];
+}
+
 - (NSString *)nameForRangeControllerDataSource
 {
   return self.asyncDataSource ? NSStringFromClass([self.asyncDataSource class]) : NSStringFromClass([self class]);
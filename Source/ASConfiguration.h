@@ -16,6 +16,51 @@ NS_ASSUME_NONNULL_BEGIN
 
 static NSInteger const ASConfigurationSchemaCurrentVersion = 1;
 
+/**
+ * Counters for the layout cache shared by all ASTextNode2 instances.
+ */
+typedef struct {
+  NSUInteger hitCount;
+  NSUInteger missCount;
+  NSUInteger evictionCount;
+  /// Estimated bytes currently held by the cache.
+  NSUInteger totalCost;
+} ASTextLayoutCacheStatistics;
+
+/**
+ * Counters for one shard of the renderer cache shared by all ASTextNode instances.
+ */
+typedef struct {
+  NSUInteger hitCount;
+  NSUInteger missCount;
+  /// Misses that waited for another thread creating the same renderer instead of creating one.
+  NSUInteger sharedMissCount;
+} ASTextRendererCacheStatistics;
+
+/**
+ * Counters for the per-node layout caches enabled by exp_node_layout_cache, summed over all nodes.
+ */
+typedef struct {
+  /// Layouts that were returned from the cache instead of being measured.
+  NSUInteger hitCount;
+  /// The hits that were measured for a different size range, with exp_node_layout_cache_fitting.
+  NSUInteger fittingHitCount;
+  NSUInteger missCount;
+} ASNodeLayoutCacheStatistics;
+
+/**
+ * Counters for the contents cache shared by all ASImageNode instances.
+ */
+typedef struct {
+  NSUInteger hitCount;
+  NSUInteger missCount;
+  /// Misses that waited for another thread rendering the same contents instead of rendering them.
+  NSUInteger sharedMissCount;
+  NSUInteger evictionCount;
+  /// Bytes of the decoded bitmaps held by the strong tier.
+  NSUInteger totalCost;
+} ASImageContentsCacheStatistics;
+
 AS_SUBCLASSING_RESTRICTED
 @interface ASConfiguration : NSObject <NSCopying>
 
@@ -39,6 +84,43 @@ AS_SUBCLASSING_RESTRICTED
  */
 @property (nonatomic) ASExperimentalFeatures experimentalFeatures;
 
+/**
+ * The byte budget of the ASTextNode2 layout cache, or 0 for the default (8 MB).
+ * Read once, the first time a text layout is cached.
+ */
+@property (nonatomic) NSUInteger textLayoutCacheByteLimit;
+
+/**
+ * A snapshot of the ASTextNode2 layout cache counters.
+ */
+@property (class, nonatomic, readonly) ASTextLayoutCacheStatistics textLayoutCacheStatistics;
+
+/**
+ * The number of shards of the ASTextNode renderer cache.
+ */
+@property (class, nonatomic, readonly) NSUInteger textRendererCacheShardCount;
+
+/**
+ * A snapshot of the counters of one shard of the ASTextNode renderer cache.
+ */
++ (ASTextRendererCacheStatistics)textRendererCacheStatisticsForShard:(NSUInteger)shard;
+
+/**
+ * A snapshot of the per-node layout cache counters.
+ */
+@property (class, nonatomic, readonly) ASNodeLayoutCacheStatistics nodeLayoutCacheStatistics;
+
+/**
+ * The byte budget of the ASImageNode contents that are kept after no node displays them anymore, or 0 for the default
+ * (16 MB). Read once, the first time image contents are cached.
+ */
+@property (nonatomic) NSUInteger imageContentsCacheByteLimit;
+
+/**
+ * A snapshot of the ASImageNode contents cache counters.
+ */
+@property (class, nonatomic, readonly) ASImageContentsCacheStatistics imageContentsCacheStatistics;
+
 @end
 
 /**
@@ -7,6 +7,10 @@
 //
 
 #import <AsyncDisplayKit/ASConfiguration.h>
+#import <AsyncDisplayKit/ASDisplayNodeLayout.h>
+#import <AsyncDisplayKit/ASImageContentsCache.h>
+#import <AsyncDisplayKit/ASTextKitRendererCache.h>
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
 
 /// Not too performance-sensitive here.
 
@@ -22,6 +26,8 @@
         NSLog(@"Texture warning: configuration schema is old version (%ld vs %ld)", (long)version, (long)ASConfigurationSchemaCurrentVersion);
       }
       self.experimentalFeatures = ASExperimentalFeaturesFromArray(featureStrings);
+      self.textLayoutCacheByteLimit = ASDynamicCast(dictionary[@"text_layout_cache_byte_limit"], NSNumber).unsignedIntegerValue;
+      self.imageContentsCacheByteLimit = ASDynamicCast(dictionary[@"image_contents_cache_byte_limit"], NSNumber).unsignedIntegerValue;
     } else {
       self.experimentalFeatures = kNilOptions;
     }
@@ -33,10 +39,45 @@
 {
   ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
   config.experimentalFeatures = self.experimentalFeatures;
+  config.textLayoutCacheByteLimit = self.textLayoutCacheByteLimit;
+  config.imageContentsCacheByteLimit = self.imageContentsCacheByteLimit;
   config.delegate = self.delegate;
   return config;
 }
 
++ (ASTextLayoutCacheStatistics)textLayoutCacheStatistics
+{
+  return ASTextLayoutCacheGetStatistics();
+}
+
++ (NSUInteger)textRendererCacheShardCount
+{
+#if AS_ENABLE_TEXTNODE
+  return ASTextKitRendererCacheShardCount;
+#else
+  return 0;
+#endif
+}
+
++ (ASTextRendererCacheStatistics)textRendererCacheStatisticsForShard:(NSUInteger)shard
+{
+#if AS_ENABLE_TEXTNODE
+  return ASTextKitRendererCacheGetStatistics(shard);
+#else
+  return {};
+#endif
+}
+
++ (ASNodeLayoutCacheStatistics)nodeLayoutCacheStatistics
+{
+  return ASDisplayNodeLayoutCacheGetStatistics();
+}
+
++ (ASImageContentsCacheStatistics)imageContentsCacheStatistics
+{
+  return ASImageContentsCacheGetStatistics();
+}
+
 @end
 
 //#define AS_FIXED_CONFIG_JSON "{ \"version\" : 1, \"experimental_features\": [ \"exp_text_node\" ] }"
@@ -36,6 +36,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 ASDK_EXTERN BOOL _ASActivateExperimentalFeature(ASExperimentalFeatures option);
 
+/**
+ * The text layout cache budget from the current configuration, or 0 if it doesn't specify one.
+ */
+ASDK_EXTERN NSUInteger ASConfigurationGetTextLayoutCacheByteLimit(void);
+
+/**
+ * The image contents cache budget from the current configuration, or 0 if it doesn't specify one.
+ */
+ASDK_EXTERN NSUInteger ASConfigurationGetImageContentsCacheByteLimit(void);
+
 /**
  * Notify the configuration delegate that the framework initialized, if needed.
  */
@@ -89,6 +89,16 @@ NS_INLINE ASConfigurationManager *ASConfigurationManagerGet() {
   return (enabled != 0);
 }
 
+- (NSUInteger)textLayoutCacheByteLimit
+{
+  return _config.textLayoutCacheByteLimit;
+}
+
+- (NSUInteger)imageContentsCacheByteLimit
+{
+  return _config.imageContentsCacheByteLimit;
+}
+
 // Define this even when !DEBUG, since we may run our tests in release mode.
 + (void)test_resetWithConfiguration:(ASConfiguration *)configuration
 {
@@ -104,6 +114,16 @@ BOOL _ASActivateExperimentalFeature(ASExperimentalFeatures feature)
   return [ASConfigurationManagerGet() activateExperimentalFeature:feature];
 }
 
+NSUInteger ASConfigurationGetTextLayoutCacheByteLimit()
+{
+  return [ASConfigurationManagerGet() textLayoutCacheByteLimit];
+}
+
+NSUInteger ASConfigurationGetImageContentsCacheByteLimit()
+{
+  return [ASConfigurationManagerGet() imageContentsCacheByteLimit];
+}
+
 void ASNotifyInitialized()
 {
   [ASConfigurationManagerGet() frameworkDidInitialize];
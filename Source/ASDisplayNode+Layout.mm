@@ -9,12 +9,14 @@
 
 #import <AsyncDisplayKit/ASAvailability.h>
 #import <AsyncDisplayKit/ASCollections.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
+#import <AsyncDisplayKit/ASPersistentLayoutCache.h>
 #import <AsyncDisplayKit/ASDisplayNode+Yoga.h>
 #import <AsyncDisplayKit/NSArray+Diffing.h>
 
@@ -33,6 +35,71 @@ using AS::MutexLocker;
 
 @end
 
+#pragma mark - Persistent Layout Cache
+
+using AS::PersistentLayoutCache;
+
+// Enough for tens of thousands of cells with a handful of subnodes each.
+static const size_t kASPersistentLayoutCacheCapacity = 4 * 1024 * 1024;
+
+/**
+ * The cache shared by all nodes, or nullptr if it can't be opened.
+ */
+static PersistentLayoutCache *ASGetPersistentLayoutCache()
+{
+  static PersistentLayoutCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSString *directory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+    NSString *path = [directory stringByAppendingPathComponent:@"ASPersistentLayoutCache"];
+    // Layouts also depend on the code of the app and the system, so start over whenever either of them changes.
+    NSDictionary *info = NSBundle.mainBundle.infoDictionary;
+    NSString *versions = [NSString stringWithFormat:@"%@ %@ %@", info[@"CFBundleShortVersionString"],
+                          info[(NSString *)kCFBundleVersionKey], NSProcessInfo.processInfo.operatingSystemVersionString];
+    const char *versionsString = versions.UTF8String;
+    const uint64_t salt = PersistentLayoutCache::hash(versionsString, strlen(versionsString));
+
+    auto newCache = new PersistentLayoutCache();
+    if (newCache->open(path.fileSystemRepresentation, salt, kASPersistentLayoutCacheCapacity)) {
+      cache = newCache;
+    } else {
+      os_log_error(ASLayoutLog(), "Failed to open the persistent layout cache at %@", path);
+      delete newCache;
+    }
+  });
+  return cache;
+}
+
+ASDISPLAYNODE_INLINE uint64_t ASPersistentLayoutHashString(const char *string, uint64_t hash)
+{
+  return string ? PersistentLayoutCache::hash(string, strlen(string), hash) : hash;
+}
+
+// The depth and index of a node in the subtree of a persisted layout share the low 32 bits of its element.
+static const NSUInteger kASPersistentLayoutMaxDepth = 0xFF;
+static const NSUInteger kASPersistentLayoutMaxIndex = 0xFFFFFF;
+
+/**
+ * Identifies a node in a persisted layout by its depth below the node the layout is for, its index in the subnodes of
+ * its supernode, and by its class in case the subnodes changed.
+ */
+ASDISPLAYNODE_INLINE uint64_t ASPersistentLayoutElement(ASDisplayNode *subnode, NSUInteger index, NSUInteger depth)
+{
+  const uint64_t classHash = ASPersistentLayoutHashString(class_getName(object_getClass(subnode)), PersistentLayoutCache::kHashSeed);
+  return (classHash << 32) | ((depth & kASPersistentLayoutMaxDepth) << 24) | (index & kASPersistentLayoutMaxIndex);
+}
+
+#pragma mark - Node Layout Cache
+
+static std::atomic<NSUInteger> gNodeLayoutCacheHitCount;
+static std::atomic<NSUInteger> gNodeLayoutCacheFittingHitCount;
+static std::atomic<NSUInteger> gNodeLayoutCacheMissCount;
+
+ASNodeLayoutCacheStatistics ASDisplayNodeLayoutCacheGetStatistics()
+{
+  return {gNodeLayoutCacheHitCount.load(), gNodeLayoutCacheFittingHitCount.load(), gNodeLayoutCacheMissCount.load()};
+}
+
 #pragma mark - ASDisplayNode (ASLayoutElement)
 
 @implementation ASDisplayNode (ASLayoutElement)
@@ -104,19 +171,246 @@ using AS::MutexLocker;
   } else if (_pendingDisplayNodeLayout.isValid(constrainedSize, parentSize, version)) {
     ASDisplayNodeAssertNotNil(_pendingDisplayNodeLayout.layout, @"-[ASDisplayNode layoutThatFits:parentSize:] _pendingDisplayNodeLayout.layout should not be nil! %@", self);
     layout = _pendingDisplayNodeLayout.layout;
+  } else if ((layout = [self _locked_cachedLayoutThatFits:constrainedSize parentSize:parentSize version:version])) {
+    _pendingDisplayNodeLayout = ASDisplayNodeLayout(layout, constrainedSize, parentSize, version);
   } else {
-    // Create a pending display node layout for the layout pass
-    layout = [self calculateLayoutThatFits:constrainedSize
-                          restrictedToSize:self.style.size
-                      relativeToParentSize:parentSize];
+    // Create a pending display node layout for the layout pass, from the persistent layout cache if possible
+    const uint64_t persistentKey = [self _locked_persistentLayoutKeyForConstrainedSize:constrainedSize parentSize:parentSize];
+    layout = [self _locked_persistentLayoutForKey:persistentKey constrainedSize:constrainedSize];
+    if (layout == nil) {
+      layout = [self calculateLayoutThatFits:constrainedSize
+                            restrictedToSize:self.style.size
+                        relativeToParentSize:parentSize];
+      [self _locked_storePersistentLayout:layout forKey:persistentKey];
+    }
     as_log_verbose(ASLayoutLog(), "Established pending layout for %@ in %s", self, sel_getName(_cmd));
     _pendingDisplayNodeLayout = ASDisplayNodeLayout(layout, constrainedSize, parentSize,version);
+    // The layout may have been invalidated while it was calculated, don't cache it past the clear then.
+    if (_layoutCache && version == _layoutVersion) {
+      _layoutCache->insert(_pendingDisplayNodeLayout);
+    }
     ASDisplayNodeAssertNotNil(layout, @"-[ASDisplayNode layoutThatFits:parentSize:] newly calculated layout should not be nil! %@", self);
   }
   
   return layout ?: [ASLayout layoutWithLayoutElement:self size:{0, 0}];
 }
 
+- (NSUInteger)layoutVersion
+{
+  return _layoutVersion.load();
+}
+
+/**
+ * Returns a layout from the node's layout cache, or nil. Creates the cache on the first call with
+ * exp_node_layout_cache, so that misses from then on are cached.
+ */
+- (ASLayout *)_locked_cachedLayoutThatFits:(ASSizeRange)constrainedSize parentSize:(CGSize)parentSize version:(NSUInteger)version
+{
+  DISABLED_ASAssertLocked(__instanceLock__);
+  if (!ASActivateExperimentalFeature(ASExperimentalNodeLayoutCache)) {
+    return nil;
+  }
+  if (!_layoutCache) {
+    _layoutCache.reset(new ASDisplayNodeLayoutCache());
+  }
+
+  BOOL fitting = NO;
+  const BOOL allowFitting = ASActivateExperimentalFeature(ASExperimentalNodeLayoutCacheFitting);
+  const ASDisplayNodeLayout *entry = _layoutCache->find(constrainedSize, parentSize, version, allowFitting, &fitting);
+  if (entry == NULL) {
+    gNodeLayoutCacheMissCount++;
+    return nil;
+  }
+  gNodeLayoutCacheHitCount++;
+  if (fitting) {
+    gNodeLayoutCacheFittingHitCount++;
+  }
+  return entry->layout;
+}
+
+#pragma mark Persistent Layout Cache
+
+/**
+ * Returns the key of the node's layout in the persistent layout cache, or 0 if it shouldn't use the cache.
+ */
+- (uint64_t)_locked_persistentLayoutKeyForConstrainedSize:(ASSizeRange)constrainedSize parentSize:(CGSize)parentSize
+{
+  if (!ASActivateExperimentalFeature(ASExperimentalPersistentLayoutCache)) {
+    return 0;
+  }
+  const uint64_t contentKey = [self persistentLayoutKey];
+  if (contentKey == 0 || _flags.automaticallyManagesSubnodes || ASGetPersistentLayoutCache() == nullptr) {
+    return 0;
+  }
+
+  uint64_t key = ASPersistentLayoutHashString(class_getName(object_getClass(self)), PersistentLayoutCache::kHashSeed);
+  key = PersistentLayoutCache::hash(&contentKey, sizeof(contentKey), key);
+
+  const ASPrimitiveTraitCollection traits = _primitiveTraitCollection;
+  const double sizes[] = {
+    constrainedSize.min.width, constrainedSize.min.height, constrainedSize.max.width, constrainedSize.max.height,
+    parentSize.width, parentSize.height, traits.displayScale, traits.containerSize.width, traits.containerSize.height
+  };
+  key = PersistentLayoutCache::hash(sizes, sizeof(sizes), key);
+  const int64_t traitValues[] = {
+    traits.horizontalSizeClass, traits.verticalSizeClass, traits.userInterfaceIdiom, traits.layoutDirection,
+    traits.userInterfaceStyle, traits.accessibilityContrast, traits.legibilityWeight
+  };
+  key = PersistentLayoutCache::hash(traitValues, sizeof(traitValues), key);
+  key = ASPersistentLayoutHashString(traits.preferredContentSizeCategory.UTF8String, key);
+  // 0 means no key.
+  return key ?: 1;
+}
+
+/**
+ * Returns the persisted layout for the key if it is still valid for the node's subtree and the constrained size.
+ *
+ * The frames are the flattened layouts of the nodes in the subtree, in pre-order and each relative to its supernode.
+ * Every node below this one gets its layout as its pending layout, so that applying the layout on the main thread
+ * doesn't measure them again.
+ */
+- (nullable ASLayout *)_locked_persistentLayoutForKey:(uint64_t)key constrainedSize:(ASSizeRange)constrainedSize
+{
+  if (key == 0) {
+    return nil;
+  }
+  PersistentLayoutCache::Entry entry;
+  if (!ASGetPersistentLayoutCache()->lookup(key, entry)) {
+    return nil;
+  }
+
+  const CGSize size = CGSizeMake(entry.width, entry.height);
+  if (!CGSizeEqualToSize(ASSizeRangeClamp(constrainedSize, size), size)) {
+    return nil;
+  }
+
+  // Match the frames to the subtree. parents[i] is the frame of the supernode of frame i, or -1 for this node.
+  const size_t count = entry.frames.size();
+  std::vector<ASDisplayNode *> nodes(count);
+  std::vector<NSArray<ASDisplayNode *> *> subnodes(count);
+  std::vector<NSInteger> parents(count);
+  std::vector<NSInteger> path = {-1};
+  NSArray<ASDisplayNode *> *ownSubnodes = _subnodes;
+  for (size_t i = 0; i < count; i++) {
+    const auto &frame = entry.frames[i];
+    const NSUInteger depth = (frame.element >> 24) & kASPersistentLayoutMaxDepth;
+    const NSUInteger index = frame.element & kASPersistentLayoutMaxIndex;
+    if (depth == 0 || depth > path.size()) {
+      return nil;
+    }
+    path.resize(depth);
+    const NSInteger parent = path.back();
+    if (parent >= 0 && subnodes[parent] == nil) {
+      ASDisplayNode *supernode = nodes[parent];
+      MutexLocker l(supernode->__instanceLock__);
+      subnodes[parent] = [supernode->_subnodes copy] ?: @[];
+    }
+    NSArray<ASDisplayNode *> *siblings = (parent >= 0 ? subnodes[parent] : ownSubnodes);
+    if (index >= siblings.count || ASPersistentLayoutElement(siblings[index], index, depth) != frame.element) {
+      return nil;
+    }
+    nodes[i] = siblings[index];
+    parents[i] = parent;
+    path.push_back(i);
+  }
+
+  // Each node's flattened layout has a sublayout without sublayouts for each of its subnodes, like
+  // -filteredNodeLayoutTree makes.
+  std::vector<NSMutableArray<ASLayout *> *> sublayouts(count + 1);
+  for (size_t i = 0; i < count; i++) {
+    const auto &frame = entry.frames[i];
+    NSMutableArray<ASLayout *> *&siblingLayouts = sublayouts[parents[i] + 1];
+    if (siblingLayouts == nil) {
+      siblingLayouts = [[NSMutableArray alloc] init];
+    }
+    [siblingLayouts addObject:[ASLayout layoutWithLayoutElement:nodes[i]
+                                                           size:CGSizeMake(frame.width, frame.height)
+                                                       position:CGPointMake(frame.x, frame.y)
+                                                     sublayouts:@[]]];
+  }
+  for (size_t i = 0; i < count; i++) {
+    const auto &frame = entry.frames[i];
+    const CGSize nodeSize = CGSizeMake(frame.width, frame.height);
+    ASLayout *nodeLayout = [ASLayout layoutWithLayoutElement:nodes[i] size:nodeSize sublayouts:sublayouts[i + 1] ?: @[]];
+    [nodeLayout retainSublayoutElements];
+    const CGSize parentSize = (parents[i] >= 0
+                               ? CGSizeMake(entry.frames[parents[i]].width, entry.frames[parents[i]].height)
+                               : size);
+    ASDisplayNode *node = nodes[i];
+    MutexLocker l(node->__instanceLock__);
+    node->_pendingDisplayNodeLayout = ASDisplayNodeLayout(nodeLayout, ASSizeRangeMake(nodeSize), parentSize, node->_layoutVersion);
+  }
+
+  ASLayout *layout = [ASLayout layoutWithLayoutElement:self size:size sublayouts:sublayouts[0] ?: @[]];
+  // All flattened layouts must retain sublayout elements until they are applied.
+  [layout retainSublayoutElements];
+  return layout;
+}
+
+/**
+ * Returns the layout the node had when its supernode's layout gave it the size, or nil.
+ */
+- (nullable ASLayout *)_persistentLayoutWithSize:(CGSize)size
+{
+  MutexLocker l(__instanceLock__);
+  const NSUInteger version = _layoutVersion;
+  if (_pendingDisplayNodeLayout.isValid(version) && CGSizeEqualToSize(_pendingDisplayNodeLayout.layout.size, size)) {
+    return _pendingDisplayNodeLayout.layout;
+  }
+  if (_calculatedDisplayNodeLayout.isValid(version) && CGSizeEqualToSize(_calculatedDisplayNodeLayout.layout.size, size)) {
+    return _calculatedDisplayNodeLayout.layout;
+  }
+  return nil;
+}
+
+/**
+ * Appends the frames of the sublayouts of the node's flattened layout, each followed by the frames of its subnode's
+ * own layout. Returns NO if a sublayout isn't one of the node's subnodes, or a subnode has no layout of its size.
+ */
+- (BOOL)_appendPersistentFramesOfLayout:(ASLayout *)layout depth:(NSUInteger)depth toEntry:(PersistentLayoutCache::Entry &)entry
+{
+  if (depth > kASPersistentLayoutMaxDepth) {
+    return NO;
+  }
+  NSArray<ASDisplayNode *> *subnodes;
+  {
+    MutexLocker l(__instanceLock__);
+    subnodes = [_subnodes copy];
+  }
+  for (ASLayout *sublayout in layout.sublayouts) {
+    const NSUInteger index = [subnodes indexOfObjectIdenticalTo:sublayout.layoutElement];
+    if (index == NSNotFound || index > kASPersistentLayoutMaxIndex) {
+      return NO;
+    }
+    ASDisplayNode *subnode = subnodes[index];
+    const CGRect frame = sublayout.frame;
+    entry.frames.push_back({frame.origin.x, frame.origin.y, frame.size.width, frame.size.height,
+                            ASPersistentLayoutElement(subnode, index, depth)});
+    ASLayout *subnodeLayout = [subnode _persistentLayoutWithSize:frame.size];
+    if (subnodeLayout == nil || ![subnode _appendPersistentFramesOfLayout:subnodeLayout depth:depth + 1 toEntry:entry]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+/**
+ * Stores a newly calculated layout of the node with the layouts of all nodes below it, if each of them has one.
+ */
+- (void)_locked_storePersistentLayout:(ASLayout *)layout forKey:(uint64_t)key
+{
+  if (key == 0 || layout == nil) {
+    return;
+  }
+
+  PersistentLayoutCache::Entry entry;
+  entry.width = layout.size.width;
+  entry.height = layout.size.height;
+  if ([self _appendPersistentFramesOfLayout:layout depth:1 toEntry:entry]) {
+    ASGetPersistentLayoutCache()->store(key, entry);
+  }
+}
+
 #pragma mark ASLayoutElementStyleExtensibility
 
 ASLayoutElementStyleExtensibilityForwarding
@@ -163,6 +163,22 @@ AS_CATEGORY_IMPLEMENTABLE
  */
 - (CGSize)calculateSizeThatFits:(CGSize)constrainedSize;
 
+/**
+ * @abstract Returns a hash of everything the receiver's layout depends on, so that its layouts can be reused across
+ * launches.
+ *
+ * @discussion Only used while the exp_persistent_layout_cache experiment is enabled. The default implementation
+ * returns 0, which means that the receiver's layouts are not persisted. Return a hash that is stable across launches,
+ * e.g. of the identifier and revision of the content the receiver displays, and that changes whenever anything that
+ * affects the layout changes. The receiver's class, the constrained size, the trait collection and the app version are
+ * added to it.
+ *
+ * A persisted layout only stores the frames of the receiver's subnodes, and is used without calculating the layout.
+ * The receiver must therefore already have all of its subnodes in their final order when it is measured, which rules
+ * out nodes that automatically manage their subnodes. The subnodes are measured when they are laid out.
+ */
+- (uint64_t)persistentLayoutKey;
+
 /**
  * @abstract Invalidate previously measured and cached layout.
  *
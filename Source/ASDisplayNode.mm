@@ -55,6 +55,73 @@ static ASDisplayNodeNonFatalErrorBlock _nonFatalErrorBlock = nil;
  * See ASDisplayNodeInternal.h for ivars
  */
 
+- (BOOL)_updateInterfaceStateWithPendingState:(ASInterfaceState)newPendingState oldState:(ASInterfaceState *)outOldState newState:(ASInterfaceState *)outNewState;
+- (void)_interfaceStateDidTransitionFromState:(ASInterfaceState)oldState toState:(ASInterfaceState)newState;
+- (void)_applyInterfaceStateToNodesAddedToSnapshot:(ASInterfaceState)newInterfaceState;
+
+@end
+
+/**
+ * Updates the interface state of all nodes before notifying any of them, in order, so that their callbacks see the
+ * new state on the whole subtree and no node is locked while they run. A node whose state was changed again by an
+ * earlier callback has been notified of that change already and is skipped.
+ */
+static void ASDisplayNodeApplyPendingInterfaceStates(const std::vector<ASDisplayNode *> &nodes, ASInterfaceState newPendingState)
+{
+  struct Transition {
+    ASDisplayNode *node;
+    ASInterfaceState oldState;
+    ASInterfaceState newState;
+  };
+  std::vector<Transition> transitions;
+  transitions.reserve(nodes.size());
+  for (ASDisplayNode *node : nodes) {
+    ASInterfaceState oldState;
+    ASInterfaceState newState;
+    if ([node _updateInterfaceStateWithPendingState:newPendingState oldState:&oldState newState:&newState]) {
+      transitions.push_back({node, oldState, newState});
+    }
+  }
+  for (const Transition &transition : transitions) {
+    if (transition.node.interfaceState == transition.newState) {
+      [transition.node _interfaceStateDidTransitionFromState:transition.oldState toState:transition.newState];
+    }
+  }
+}
+
+/**
+ * The nodes of a subtree whose pending interface states changed, applied together before the next CATransaction
+ * commit instead of each node being enqueued on its own.
+ */
+@interface _ASInterfaceStateBatch : NSObject <ASCATransactionQueueObserving>
+- (instancetype)initWithRootNode:(ASDisplayNode *)rootNode nodes:(std::vector<ASDisplayNode *> &&)nodes;
+@end
+
+@implementation _ASInterfaceStateBatch {
+  __weak ASDisplayNode *_rootNode;
+  std::vector<ASDisplayNode *> _nodes;
+}
+
+- (instancetype)initWithRootNode:(ASDisplayNode *)rootNode nodes:(std::vector<ASDisplayNode *> &&)nodes
+{
+  if (self = [super init]) {
+    _rootNode = rootNode;
+    _nodes = std::move(nodes);
+  }
+  return self;
+}
+
+- (void)prepareForCATransactionCommit
+{
+  ASDisplayNodeApplyPendingInterfaceStates(_nodes, ASInterfaceStateNone);
+  _nodes.clear();
+  ASDisplayNode *rootNode = _rootNode;
+  if (rootNode != nil) {
+    // The root's pending state is the latest one requested for the subtree.
+    [rootNode _applyInterfaceStateToNodesAddedToSnapshot:rootNode.pendingInterfaceState];
+  }
+}
+
 @end
 
 @implementation ASDisplayNode
@@ -502,11 +569,43 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__);
     [subnode _setSupernode:nil];
 
   [self scheduleIvarsForMainThreadDeallocation];
+  if (ASDisplayNodeThreadIsMain() && ASActivateExperimentalFeature(ASExperimentalBackgroundDeallocation)) {
+    [self _scheduleIvarsForBackgroundDeallocation];
+  }
 
   // TODO: Remove this? If supernode isn't already nil, this method isn't dealloc-safe anyway.
   [self _setSupernode:nil];
 }
 
+/**
+ * Hands the subtree and the layouts to the background deallocation queue, so that a node released on the main
+ * thread, e.g. while cells are reused, doesn't release them there. The views and layers of the subnodes come back to
+ * the main thread deallocation queue.
+ */
+- (void)_scheduleIvarsForBackgroundDeallocation
+{
+  ASDeallocQueue *queue = ASDeallocQueue.sharedDeallocationQueue;
+  id subnodes = _subnodes;
+  _subnodes = nil;
+  [queue releaseObjectInBackground:&subnodes];
+  id cachedSubnodes = _cachedSubnodes;
+  _cachedSubnodes = nil;
+  [queue releaseObjectInBackground:&cachedSubnodes];
+  id calculatedLayout = _calculatedDisplayNodeLayout.layout;
+  _calculatedDisplayNodeLayout.layout = nil;
+  [queue releaseObjectInBackground:&calculatedLayout];
+  id pendingLayout = _pendingDisplayNodeLayout.layout;
+  _pendingDisplayNodeLayout.layout = nil;
+  [queue releaseObjectInBackground:&pendingLayout];
+  id unflattenedLayout = _unflattenedLayout;
+  _unflattenedLayout = nil;
+  [queue releaseObjectInBackground:&unflattenedLayout];
+  if (_layoutCache) {
+    id cachedLayouts = _layoutCache->takeLayouts();
+    [queue releaseObjectInBackground:&cachedLayouts];
+  }
+}
+
 #pragma mark - Loading
 
 - (BOOL)_locked_shouldLoadViewOrLayer
@@ -991,6 +1090,11 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__);
   
   _unflattenedLayout = nil;
 
+  // Entries of older versions can't be used anymore, and their sublayouts would keep removed subnodes alive.
+  if (_layoutCache) {
+    _layoutCache->clear();
+  }
+
 #if YOGA
   [self invalidateCalculatedYogaLayout];
 #endif
@@ -1116,6 +1220,11 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__);
   return ASIsCGSizeValidForSize(constrainedSize) ? constrainedSize : CGSizeZero;
 }
 
+- (uint64_t)persistentLayoutKey
+{
+  return 0;
+}
+
 - (void)layout
 {
   // Hook for subclasses
@@ -2163,6 +2272,7 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
     }
     [_subnodes insertObject:subnode atIndex:subnodeIndex];
     _cachedSubnodes = nil;
+    _subnodesVersion++;
   __instanceLock__.unlock();
 
   // This call will apply our .hierarchyState to the new subnode.
@@ -2466,6 +2576,7 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   __instanceLock__.lock();
     [_subnodes removeObjectIdenticalTo:subnode];
     _cachedSubnodes = nil;
+    _subnodesVersion++;
   __instanceLock__.unlock();
 
   [subnode _setSupernode:nil];
@@ -2921,14 +3032,147 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   // setInterfaceState: skips this when handling range-managed nodes (our whole subtree has this set).
   // If our range manager intends for us to be displayed right now, and didn't before, get started!
   BOOL shouldScheduleDisplay = [self supportsRangeManagedInterfaceState] && [self shouldScheduleDisplayWithNewInterfaceState:newInterfaceState];
-  ASDisplayNodePerformBlockOnEveryNode(nil, self, YES, ^(ASDisplayNode *node) {
-    node.interfaceState = newInterfaceState;
-  });
+  if (ASDisplayNodeThreadIsMain() && ASActivateExperimentalFeature(ASExperimentalInterfaceStateSnapshot)) {
+    [self _setInterfaceStateOfSnapshot:newInterfaceState];
+  } else {
+    ASDisplayNodePerformBlockOnEveryNode(nil, self, YES, ^(ASDisplayNode *node) {
+      node.interfaceState = newInterfaceState;
+    });
+  }
   if (shouldScheduleDisplay) {
     [ASDisplayNode scheduleNodeForRecursiveDisplay:self];
   }
 }
 
+/**
+ * Sets the interface state of the nodes ASDisplayNodePerformBlockOnEveryNode would visit, from a snapshot of the
+ * subtree that is only taken again when it changed, and applies them in one pass. With coalescing, the states are
+ * applied together before the next CATransaction commit.
+ */
+- (void)_setInterfaceStateOfSnapshot:(ASInterfaceState)newInterfaceState
+{
+  ASDisplayNodeAssertMainThread();
+  std::vector<ASDisplayNode *> nodes;
+  if (![self _collectInterfaceStateSnapshotNodes:nodes]) {
+    _interfaceStateSnapshot.reset(new std::vector<ASInterfaceStateSnapshotEntry>());
+    [self _appendInterfaceStateSnapshotEntries:*_interfaceStateSnapshot];
+    nodes.clear();
+    [self _collectInterfaceStateSnapshotNodes:nodes];
+  }
+
+  if (!ASCATransactionQueueGet().enabled) {
+    ASDisplayNodeApplyPendingInterfaceStates(nodes, newInterfaceState);
+    [self _applyInterfaceStateToNodesAddedToSnapshot:newInterfaceState];
+    return;
+  }
+  std::vector<ASDisplayNode *> changedNodes;
+  for (ASDisplayNode *node : nodes) {
+    MutexLocker l(node->__instanceLock__);
+    if (node->_pendingInterfaceState != newInterfaceState) {
+      node->_pendingInterfaceState = newInterfaceState;
+      changedNodes.push_back(node);
+    }
+  }
+  if (!changedNodes.empty()) {
+    [ASCATransactionQueueGet() enqueue:[[_ASInterfaceStateBatch alloc] initWithRootNode:self nodes:std::move(changedNodes)]];
+  }
+}
+
+/**
+ * Callbacks of the pass may add or remove subnodes. Added ones adopt the pending state of their supernode, but not
+ * those below a foreign sublayer, so the snapshot is taken again for as long as it changed and the state is applied to
+ * the nodes that don't have it yet.
+ */
+- (void)_applyInterfaceStateToNodesAddedToSnapshot:(ASInterfaceState)newInterfaceState
+{
+  ASDisplayNodeAssertMainThread();
+  std::vector<ASDisplayNode *> nodes;
+  while (![self _collectInterfaceStateSnapshotNodes:nodes]) {
+    _interfaceStateSnapshot.reset(new std::vector<ASInterfaceStateSnapshotEntry>());
+    [self _appendInterfaceStateSnapshotEntries:*_interfaceStateSnapshot];
+    nodes.clear();
+    [self _collectInterfaceStateSnapshotNodes:nodes];
+    if (ASCATransactionQueueGet().enabled) {
+      for (ASDisplayNode *node : nodes) {
+        MutexLocker l(node->__instanceLock__);
+        node->_pendingInterfaceState = newInterfaceState;
+      }
+    }
+    ASDisplayNodeApplyPendingInterfaceStates(nodes, newInterfaceState);
+    nodes.clear();
+  }
+}
+
+/**
+ * Appends the entries of the subtree in pre-order.
+ */
+- (void)_appendInterfaceStateSnapshotEntries:(std::vector<ASInterfaceStateSnapshotEntry> &)entries
+{
+  ASInterfaceStateSnapshotEntry entry = {self, 0, -1, NO};
+  NSArray<ASDisplayNode *> *subnodes;
+  {
+    MutexLocker l(__instanceLock__);
+    entry.subnodesVersion = _subnodesVersion;
+    subnodes = [_subnodes copy];
+  }
+  if (_loaded(self) && !self.rasterizesSubtree) {
+    NSArray<CALayer *> *sublayers = _layer.sublayers;
+    entry.sublayerCount = sublayers.count;
+    for (CALayer *sublayer in sublayers) {
+      if (ASLayerToDisplayNode(sublayer).supernode != self) {
+        entry.hasForeignSublayers = YES;
+        break;
+      }
+    }
+  }
+  entries.push_back(entry);
+  for (ASDisplayNode *subnode in subnodes) {
+    [subnode _appendInterfaceStateSnapshotEntries:entries];
+  }
+}
+
+/**
+ * Collects the nodes of the snapshot and the nodes below their foreign sublayers, or returns NO if there is no
+ * snapshot or it is out of date.
+ */
+- (BOOL)_collectInterfaceStateSnapshotNodes:(std::vector<ASDisplayNode *> &)nodes
+{
+  if (!_interfaceStateSnapshot) {
+    return NO;
+  }
+  nodes.reserve(_interfaceStateSnapshot->size());
+  std::vector<ASDisplayNode *> *foreignNodes = &nodes;
+  for (const ASInterfaceStateSnapshotEntry &entry : *_interfaceStateSnapshot) {
+    ASDisplayNode *node = entry.node;
+    if (node == nil) {
+      return NO;
+    }
+    {
+      MutexLocker l(node->__instanceLock__);
+      if (node->_subnodesVersion != entry.subnodesVersion) {
+        return NO;
+      }
+    }
+    const BOOL visitsSublayers = _loaded(node) && !node->_flags.rasterizesSubtree;
+    if (visitsSublayers != (entry.sublayerCount >= 0)
+        || (visitsSublayers && node->_layer.sublayers.count != (NSUInteger)entry.sublayerCount)) {
+      return NO;
+    }
+    nodes.push_back(node);
+
+    if (entry.hasForeignSublayers) {
+      for (CALayer *sublayer in [node->_layer.sublayers copy]) {
+        if (ASLayerToDisplayNode(sublayer).supernode != node) {
+          ASDisplayNodePerformBlockOnEveryNode(sublayer, nil, YES, ^(ASDisplayNode *foreignNode) {
+            foreignNodes->push_back(foreignNode);
+          });
+        }
+      }
+    }
+  }
+  return YES;
+}
+
 - (ASInterfaceState)interfaceState
 {
   MutexLocker l(__instanceLock__);
@@ -2965,21 +3209,41 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   
   ASInterfaceState oldState = ASInterfaceStateNone;
   ASInterfaceState newState = ASInterfaceStateNone;
-  {
-    MutexLocker l(__instanceLock__);
-    // newPendingState will not be used when ASCATransactionQueue is enabled
-    // and use _pendingInterfaceState instead for interfaceState update.
-    if (!ASCATransactionQueueGet().enabled) {
-      _pendingInterfaceState = newPendingState;
-    }
-    oldState = _interfaceState;
-    newState = _pendingInterfaceState;
-    if (newState == oldState) {
-      return;
-    }
-    _interfaceState = newState;
-    _preExitingInterfaceState = ASInterfaceStateNone;
+  if ([self _updateInterfaceStateWithPendingState:newPendingState oldState:&oldState newState:&newState]) {
+    [self _interfaceStateDidTransitionFromState:oldState toState:newState];
   }
+}
+
+/**
+ * Applies the pending interface state, returning whether it changed. The first half of -applyPendingInterfaceState:,
+ * which doesn't call out, so that a whole subtree can be updated before any of its nodes is notified.
+ */
+- (BOOL)_updateInterfaceStateWithPendingState:(ASInterfaceState)newPendingState oldState:(ASInterfaceState *)outOldState newState:(ASInterfaceState *)outNewState
+{
+  MutexLocker l(__instanceLock__);
+  // newPendingState will not be used when ASCATransactionQueue is enabled
+  // and use _pendingInterfaceState instead for interfaceState update.
+  if (!ASCATransactionQueueGet().enabled) {
+    _pendingInterfaceState = newPendingState;
+  }
+  *outOldState = _interfaceState;
+  *outNewState = _pendingInterfaceState;
+  if (*outNewState == *outOldState) {
+    return NO;
+  }
+  _interfaceState = *outNewState;
+  _preExitingInterfaceState = ASInterfaceStateNone;
+  return YES;
+}
+
+/**
+ * Acts on an interface state change and calls the didEnter/Exit(.*)State methods. The second half of
+ * -applyPendingInterfaceState:.
+ */
+- (void)_interfaceStateDidTransitionFromState:(ASInterfaceState)oldState toState:(ASInterfaceState)newState
+{
+  ASDisplayNodeAssertMainThread();
+  DISABLED_ASAssertUnlocked(__instanceLock__);
 
   // It should never be possible for a node to be visible but not be allowed / expected to display.
   ASDisplayNodeAssertFalse(ASInterfaceStateIncludesVisible(newState) && !ASInterfaceStateIncludesDisplay(newState));
@@ -3416,6 +3680,12 @@ ASDISPLAYNODE_INLINE BOOL subtreeIsRasterized(ASDisplayNode *node) {
   [self _locked_applyPendingViewState];
 }
 
+- (uint64_t)pendingViewStateChangesMask
+{
+  MutexLocker l(__instanceLock__);
+  return _pendingViewState.changesMask;
+}
+
 - (void)_locked_applyPendingViewState
 {
   ASDisplayNodeAssertMainThread();
@@ -8,6 +8,7 @@
 //
 
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Ancestry.h>
 
@@ -24,6 +25,11 @@ void ASPerformMainThreadDeallocation(id _Nullable __strong * _Nonnull objectPtr)
   dispatch_once(&onceToken, ^{
     queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:nil];
     queue.batchSize = 10;
+    if (ASActivateExperimentalFeature(ASExperimentalTimeSlicedDeallocQueue) || ASActivateExperimentalFeature(ASExperimentalBackgroundDeallocation)) {
+      // Leave most of the frame to everything else. With background deallocation, only the objects that must be
+      // released on main end up here.
+      queue.timeBudget = 0.005;
+    }
   });
 
   if (objectPtr != NULL && *objectPtr != nil) {
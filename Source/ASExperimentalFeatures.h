@@ -35,6 +35,20 @@ typedef NS_OPTIONS(NSUInteger, ASExperimentalFeatures) {
   ASExperimentalLockTextRendererCache = 1 << 14,                            // exp_lock_text_renderer_cache
   ASExperimentalHierarchyDisplayDidFinishIsRecursive = 1 << 15,             // exp_hierarchy_display_did_finish_is_recursive
   ASExperimentalCheckBatchFetchingOnScroll = 1 << 16,                       // exp_check_batch_fetching_on_scroll
+  ASExperimentalIncrementalStackLayout = 1 << 17,                           // exp_incremental_stack_layout
+  ASExperimentalPersistentLayoutCache = 1 << 18,                            // exp_persistent_layout_cache
+  ASExperimentalAdaptiveRanges = 1 << 19,                                   // exp_adaptive_ranges
+  ASExperimentalBudgetedMainSerialQueue = 1 << 20,                          // exp_budgeted_main_serial_queue
+  ASExperimentalTimeSlicedDeallocQueue = 1 << 21,                           // exp_time_sliced_dealloc_queue
+  ASExperimentalNodeLayoutCache = 1 << 22,                                  // exp_node_layout_cache
+  ASExperimentalNodeLayoutCacheFitting = 1 << 23,                           // exp_node_layout_cache_fitting
+  ASExperimentalInterfaceStateSnapshot = 1 << 24,                           // exp_interface_state_snapshot
+  ASExperimentalTimeSlicedPendingState = 1 << 25,                           // exp_time_sliced_pending_state
+  ASExperimentalDownsampleNetworkImages = 1 << 26,                          // exp_downsample_network_images
+  ASExperimentalBackgroundDeallocation = 1 << 27,                           // exp_background_deallocation
+  ASExperimentalPipelinedCellAllocation = 1 << 28,                          // exp_pipelined_cell_allocation
+  ASExperimentalIncrementalRelayout = 1 << 29,                              // exp_incremental_relayout
+  ASExperimentalWindowedReload = 1 << 30,                                   // exp_windowed_reload
   ASExperimentalFeatureAll = 0xFFFFFFFF
 };
 
@@ -28,7 +28,21 @@ NSArray<NSString *> *ASExperimentalFeaturesGetNames(ASExperimentalFeatures flags
                                       @"exp_no_text_renderer_cache",
                                       @"exp_lock_text_renderer_cache",
                                       @"exp_hierarchy_display_did_finish_is_recursive",
-                                      @"exp_check_batch_fetching_on_scroll"]));
+                                      @"exp_check_batch_fetching_on_scroll",
+                                      @"exp_incremental_stack_layout",
+                                      @"exp_persistent_layout_cache",
+                                      @"exp_adaptive_ranges",
+                                      @"exp_budgeted_main_serial_queue",
+                                      @"exp_time_sliced_dealloc_queue",
+                                      @"exp_node_layout_cache",
+                                      @"exp_node_layout_cache_fitting",
+                                      @"exp_interface_state_snapshot",
+                                      @"exp_time_sliced_pending_state",
+                                      @"exp_downsample_network_images",
+                                      @"exp_background_deallocation",
+                                      @"exp_pipelined_cell_allocation",
+                                      @"exp_incremental_relayout",
+                                      @"exp_windowed_reload"]));
 
   if (flags == ASExperimentalFeatureAll) {
     return allNames;
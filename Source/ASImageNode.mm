@@ -17,6 +17,7 @@
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASGraphicsContext.h>
 #import <AsyncDisplayKit/ASLayout.h>
+#import <AsyncDisplayKit/ASRunLoopQueue.h>
 #import <AsyncDisplayKit/ASTextNode.h>
 #import <AsyncDisplayKit/ASImageNode+AnimatedImagePrivate.h>
 #import <AsyncDisplayKit/ASImageNode+CGExtras.h>
@@ -24,6 +25,7 @@
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
 #import <AsyncDisplayKit/ASHashing.h>
+#import <AsyncDisplayKit/ASImageContentsCache.h>
 #import <AsyncDisplayKit/ASWeakMap.h>
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
 
@@ -109,31 +111,15 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
 
 - (NSUInteger)hash
 {
-#pragma clang diagnostic push
-#pragma clang diagnostic warning "-Wpadded"
-  struct {
-    NSUInteger imageHash;
-    CGSize backingSize;
-    CGRect imageDrawRect;
-    NSInteger isOpaque;
-    NSUInteger backgroundColorHash;
-    NSUInteger tintColorHash;
-    void *willDisplayNodeContentWithRenderingContext;
-    void *didDisplayNodeContentWithRenderingContext;
-    void *imageModificationBlock;
-#pragma clang diagnostic pop
-  } data = {
-    _image.hash,
-    _backingSize,
-    _imageDrawRect,
-    _isOpaque,
-    _backgroundColor.hash,
-    _tintColor.hash,
-    (void *)_willDisplayNodeContentWithRenderingContext,
-    (void *)_didDisplayNodeContentWithRenderingContext,
-    (void *)_imageModificationBlock
-  };
-  return ASHashBytes(&data, sizeof(data));
+  return AS::hashFields(_image.hash,
+                        _backingSize,
+                        _imageDrawRect,
+                        _isOpaque,
+                        _backgroundColor.hash,
+                        _tintColor.hash,
+                        (__bridge void *)_willDisplayNodeContentWithRenderingContext,
+                        (__bridge void *)_didDisplayNodeContentWithRenderingContext,
+                        (__bridge void *)_imageModificationBlock);
 }
 
 @end
@@ -192,6 +178,13 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
 {
   // Invalidate all components around animated images
   [self invalidateAnimatedImage];
+
+  // Decoded images can be megabytes, don't free them on the main thread.
+  if (ASDisplayNodeThreadIsMain() && ASActivateExperimentalFeature(ASExperimentalBackgroundDeallocation)) {
+    id image = _image;
+    _image = nil;
+    [ASDeallocQueue.sharedDeallocationQueue releaseObjectInBackground:&image];
+  }
 }
 
 #pragma mark - Placeholder
@@ -443,37 +436,13 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
   return entry.value;
 }
 
-static ASWeakMap<ASImageNodeContentsKey *, UIImage *> *cache = nil;
-
 + (ASWeakMapEntry *)contentsForkey:(ASImageNodeContentsKey *)key drawParameters:(id)drawParameters isCancelled:(asdisplaynode_iscancelled_block_t)isCancelled
 {
-  static dispatch_once_t onceToken;
-  static AS::Mutex *cacheLock = nil;
-  dispatch_once(&onceToken, ^{
-    cacheLock = new AS::Mutex();
+  // Concurrent display passes for the same key share one draw, and the contents outlive this node for a while, so
+  // cells that scroll back into the display range don't draw again.
+  return ASImageContentsCacheGetEntry(key, ^UIImage *{
+    return [self createContentsForkey:key drawParameters:drawParameters isCancelled:isCancelled];
   });
-
-  {
-    AS::MutexLocker l(*cacheLock);
-    if (!cache) {
-      cache = [[ASWeakMap alloc] init];
-    }
-    ASWeakMapEntry *entry = [cache entryForKey:key];
-    if (entry != nil) {
-      return entry;
-    }
-  }
-
-  // cache miss
-  UIImage *contents = [self createContentsForkey:key drawParameters:drawParameters isCancelled:isCancelled];
-  if (contents == nil) { // If nil, we were cancelled
-    return nil;
-  }
-
-  {
-    AS::MutexLocker l(*cacheLock);
-    return [cache setObject:contents forKey:key];
-  }
 }
 
 + (UIImage *)createContentsForkey:(ASImageNodeContentsKey *)key drawParameters:(id)parameter isCancelled:(asdisplaynode_iscancelled_block_t)isCancelled
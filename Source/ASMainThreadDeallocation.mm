@@ -13,123 +13,94 @@
 #import <AsyncDisplayKit/ASLog.h>
 #import <AsyncDisplayKit/ASThread.h>
 
-@implementation NSObject (ASMainThreadIvarTeardown)
-
-- (void)scheduleIvarsForMainThreadDeallocation
-{
-  if (ASDisplayNodeThreadIsMain()) {
-    return;
-  }
-  
-  NSValue *ivarsObj = [[self class] _ivarsThatMayNeedMainDeallocation];
-  
-  // Unwrap the ivar array
-  unsigned int count = 0;
-  // Will be unused if assertions are disabled.
-  __unused int scanResult = sscanf(ivarsObj.objCType, "[%u^{objc_ivar}]", &count);
-  ASDisplayNodeAssert(scanResult == 1, @"Unexpected type in NSValue: %s", ivarsObj.objCType);
-  Ivar ivars[count];
-  [ivarsObj getValue:ivars];
-  
-  for (Ivar ivar : ivars) {
-    id value = object_getIvar(self, ivar);
-    if (value == nil) {
-      continue;
-    }
-    
-    if ([object_getClass(value) needsMainThreadDeallocation]) {
-      os_log_debug(ASMainThreadDeallocationLog(), "%@: Trampolining ivar '%s' value %@ for main deallocation.", self, ivar_getName(ivar), value);
-      
-      // Release the ivar's reference before handing the object to the queue so we
-      // don't risk holding onto it longer than the queue does.
-      object_setIvar(self, ivar, nil);
-      
-      ASPerformMainThreadDeallocation(&value);
-    } else {
-      os_log_debug(ASMainThreadDeallocationLog(), "%@: Not trampolining ivar '%s' value %@.", self, ivar_getName(ivar), value);
-    }
-  }
-}
+#import <unordered_map>
+#import <vector>
 
 /**
- * Returns an NSValue-wrapped array of all the ivars in this class or its superclasses
- * up through ASDisplayNode, that we expect may need to be deallocated on main.
- *
- * This method caches its results.
+ * Returns the ivars of this class and its superclasses that we expect may need to be deallocated on main.
  *
- * Result is of type NSValue<[Ivar]>
+ * Classes don't change their ivars, so the results are kept for good. Scanning runs outside of the lock, and if two
+ * threads scan the same class, the first result is kept.
  */
-+ (NSValue * _Nonnull)_ivarsThatMayNeedMainDeallocation NS_RETURNS_RETAINED
+static const std::vector<Ivar> &ASIvarsThatMayNeedMainDeallocation(Class cls)
 {
-  static NSCache<Class, NSValue *> *ivarsCache;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    ivarsCache = [[NSCache alloc] init];
-  });
-  
-  NSValue *result = [ivarsCache objectForKey:self];
-  if (result != nil) {
-    return result;
+  static AS::Mutex *lock = new AS::Mutex();
+  static auto *cache = new std::unordered_map<Class, std::vector<Ivar>>();
+  {
+    AS::MutexLocker l(*lock);
+    const auto it = cache->find(cls);
+    if (it != cache->end()) {
+      return it->second;
+    }
   }
-  
-  // Cache miss.
-  unsigned int resultCount = 0;
-  static const int kMaxDealloc2MainIvarsPerClassTree = 64;
-  Ivar resultIvars[kMaxDealloc2MainIvarsPerClassTree];
-  
-  // Get superclass results first.
-  Class c = class_getSuperclass(self);
-  if (c != [NSObject class]) {
-    NSValue *ivarsObj = [c _ivarsThatMayNeedMainDeallocation];
-    // Unwrap the ivar array and append it to our working array
-    unsigned int count = 0;
-    // Will be unused if assertions are disabled.
-    __unused int scanResult = sscanf(ivarsObj.objCType, "[%u^{objc_ivar}]", &count);
-    ASDisplayNodeAssert(scanResult == 1, @"Unexpected type in NSValue: %s", ivarsObj.objCType);
-    ASDisplayNodeCAssert(resultCount + count < kMaxDealloc2MainIvarsPerClassTree, @"More than %d dealloc2main ivars are not supported. Count: %d", kMaxDealloc2MainIvarsPerClassTree, resultCount + count);
-    [ivarsObj getValue:resultIvars + resultCount];
-    resultCount += count;
+
+  // Cache miss. Get superclass results first.
+  std::vector<Ivar> resultIvars;
+  Class superclass = class_getSuperclass(cls);
+  if (superclass != Nil && superclass != [NSObject class]) {
+    resultIvars = ASIvarsThatMayNeedMainDeallocation(superclass);
   }
-  
+
   // Now gather ivars from this particular class.
   unsigned int allMyIvarsCount;
-  Ivar *allMyIvars = class_copyIvarList(self, &allMyIvarsCount);
-  
+  Ivar *allMyIvars = class_copyIvarList(cls, &allMyIvarsCount);
+
   for (NSUInteger i = 0; i < allMyIvarsCount; i++) {
     Ivar ivar = allMyIvars[i];
-    
+
     // NOTE: Would be great to exclude weak/unowned ivars, since we don't
     // release them. Unfortunately the objc_ivar_management access is private and
     // class_getWeakIvarLayout does not have a well-defined structure.
-    
+
     const char *type = ivar_getTypeEncoding(ivar);
-    
+
     if (type != NULL && strcmp(type, @encode(id)) == 0) {
       // If it's `id` we have to include it just in case.
-      resultIvars[resultCount] = ivar;
-      resultCount += 1;
-      as_log_verbose(ASMainThreadDeallocationLog(), "%@: Marking ivar '%s' for possible main deallocation due to type id", self, ivar_getName(ivar));
+      resultIvars.push_back(ivar);
+      as_log_verbose(ASMainThreadDeallocationLog(), "%@: Marking ivar '%s' for possible main deallocation due to type id", cls, ivar_getName(ivar));
     } else {
       // If it's an ivar with a static type, check the type.
       Class c = ASGetClassFromType(type);
       if ([c needsMainThreadDeallocation]) {
-        resultIvars[resultCount] = ivar;
-        resultCount += 1;
-        as_log_verbose(ASMainThreadDeallocationLog(), "%@: Marking ivar '%s' for main deallocation due to class %@", self, ivar_getName(ivar), c);
+        resultIvars.push_back(ivar);
+        as_log_verbose(ASMainThreadDeallocationLog(), "%@: Marking ivar '%s' for main deallocation due to class %@", cls, ivar_getName(ivar), c);
       } else {
-        as_log_verbose(ASMainThreadDeallocationLog(), "%@: Skipping ivar '%s' for main deallocation.", self, ivar_getName(ivar));
+        as_log_verbose(ASMainThreadDeallocationLog(), "%@: Skipping ivar '%s' for main deallocation.", cls, ivar_getName(ivar));
       }
     }
   }
   free(allMyIvars);
-  
-  // Encode the type (array of Ivars) into a string and wrap it in an NSValue
-  char arrayType[32];
-  snprintf(arrayType, 32, "[%u^{objc_ivar}]", resultCount);
-  result = [NSValue valueWithBytes:resultIvars objCType:arrayType];
-  
-  [ivarsCache setObject:result forKey:self];
-  return result;
+
+  AS::MutexLocker l(*lock);
+  return cache->emplace(cls, std::move(resultIvars)).first->second;
+}
+
+@implementation NSObject (ASMainThreadIvarTeardown)
+
+- (void)scheduleIvarsForMainThreadDeallocation
+{
+  if (ASDisplayNodeThreadIsMain()) {
+    return;
+  }
+
+  for (Ivar ivar : ASIvarsThatMayNeedMainDeallocation(object_getClass(self))) {
+    id value = object_getIvar(self, ivar);
+    if (value == nil) {
+      continue;
+    }
+    
+    if ([object_getClass(value) needsMainThreadDeallocation]) {
+      os_log_debug(ASMainThreadDeallocationLog(), "%@: Trampolining ivar '%s' value %@ for main deallocation.", self, ivar_getName(ivar), value);
+      
+      // Release the ivar's reference before handing the object to the queue so we
+      // don't risk holding onto it longer than the queue does.
+      object_setIvar(self, ivar, nil);
+      
+      ASPerformMainThreadDeallocation(&value);
+    } else {
+      os_log_debug(ASMainThreadDeallocationLog(), "%@: Not trampolining ivar '%s' value %@.", self, ivar_getName(ivar), value);
+    }
+  }
 }
 
 @end
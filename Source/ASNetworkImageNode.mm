@@ -10,6 +10,7 @@
 #import <AsyncDisplayKit/ASNetworkImageNode.h>
 
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
@@ -18,6 +19,7 @@
 #import <AsyncDisplayKit/ASImageNode+Private.h>
 #import <AsyncDisplayKit/ASImageNode+AnimatedImagePrivate.h>
 #import <AsyncDisplayKit/ASImageContainerProtocolCategories.h>
+#import <AsyncDisplayKit/ASImageDownsampling.h>
 #import <AsyncDisplayKit/ASNetworkImageLoadInfo+Private.h>
 
 #if AS_PIN_REMOTE_IMAGE
@@ -41,6 +43,10 @@
   CGFloat _renderedImageQuality;
   CGFloat _downloadProgress;
 
+  // The pixels the image is loaded for, or CGSizeZero to load it at full size.
+  CGSize _targetPixelSize;
+  UIViewContentMode _targetContentMode;
+
     // Immutable and set on init only. We don't need to lock in this case.
   __weak id<ASImageDownloaderProtocol> _downloader;
 
@@ -65,9 +71,11 @@
       unsigned int downloaderImplementsAnimatedImage:1;
       unsigned int downloaderImplementsCancelWithResume:1;
       unsigned int downloaderImplementsDownloadWithPriority:1;
+      unsigned int downloaderImplementsDownloadWithTargetSize:1;
 
       unsigned int cacheSupportsClearing:1;
       unsigned int cacheSupportsSynchronousFetch:1;
+      unsigned int cacheSupportsTargetSize:1;
 
       unsigned int imageLoaded:1;
       unsigned int imageWasSetExternally:1;
@@ -97,9 +105,11 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
   _networkImageNodeFlags.downloaderImplementsAnimatedImage = [downloader respondsToSelector:@selector(animatedImageWithData:)];
   _networkImageNodeFlags.downloaderImplementsCancelWithResume = [downloader respondsToSelector:@selector(cancelImageDownloadWithResumePossibilityForIdentifier:)];
   _networkImageNodeFlags.downloaderImplementsDownloadWithPriority = [downloader respondsToSelector:@selector(downloadImageWithURL:shouldRetry:priority:callbackQueue:downloadProgress:completion:)];
+  _networkImageNodeFlags.downloaderImplementsDownloadWithTargetSize = [downloader respondsToSelector:@selector(downloadImageWithURL:shouldRetry:priority:targetPixelSize:contentMode:callbackQueue:downloadProgress:completion:)];
 
   _networkImageNodeFlags.cacheSupportsClearing = [cache respondsToSelector:@selector(clearFetchedImageFromCacheWithURL:)];
   _networkImageNodeFlags.cacheSupportsSynchronousFetch = [cache respondsToSelector:@selector(synchronouslyFetchedCachedImageWithURL:)];
+  _networkImageNodeFlags.cacheSupportsTargetSize = [cache respondsToSelector:@selector(cachedImageWithURL:targetPixelSize:contentMode:callbackQueue:completion:)];
   
   _networkImageNodeFlags.shouldCacheImage = YES;
   _networkImageNodeFlags.shouldRenderProgressImages = YES;
@@ -623,6 +633,8 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
     id downloadIdentifier;
     BOOL cancelAndReattempt = NO;
     ASInterfaceState interfaceState;
+    CGSize targetPixelSize;
+    UIViewContentMode targetContentMode;
 
     // Below, to avoid performance issues, we're calling downloadImageWithURL without holding the lock. This is a bit ugly because
     // We need to reobtain the lock after and ensure that the task we've kicked off still matches our URL. If not, we need to cancel
@@ -631,6 +643,8 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
       ASLockScopeSelf();
       url = self->_URL;
       interfaceState = self->_interfaceState;
+      targetPixelSize = self->_targetPixelSize;
+      targetContentMode = self->_targetContentMode;
     }
 
     dispatch_queue_t callbackQueue = [self callbackQueue];
@@ -647,7 +661,17 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
       }
     };
 
-    if (self->_networkImageNodeFlags.downloaderImplementsDownloadWithPriority) {
+    if (self->_networkImageNodeFlags.downloaderImplementsDownloadWithTargetSize && !CGSizeEqualToSize(targetPixelSize, CGSizeZero)) {
+      // Decode straight to the size we display the image at, instead of decoding it at full size.
+      downloadIdentifier = [self->_downloader downloadImageWithURL:url
+                                                       shouldRetry:[self shouldRetryImageDownload]
+                                                          priority:ASImageDownloaderPriorityWithInterfaceState(interfaceState)
+                                                   targetPixelSize:targetPixelSize
+                                                       contentMode:targetContentMode
+                                                     callbackQueue:callbackQueue
+                                                  downloadProgress:downloadProgress
+                                                        completion:completion];
+    } else if (self->_networkImageNodeFlags.downloaderImplementsDownloadWithPriority) {
       /*
         Decide a priority based on the current interface state of this node.
         It can happen that this method was called when the node entered preload state
@@ -705,10 +729,34 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
   });
 }
 
+/**
+ * The pixels the image will be drawn in, or CGSizeZero if the image should be loaded at full size: when the experiment
+ * is off, before the node has a size, or when the image is drawn at its own size anyway.
+ */
+- (CGSize)_targetPixelSize
+{
+  ASDisplayNodeAssertMainThread();
+  if (!ASActivateExperimentalFeature(ASExperimentalDownsampleNetworkImages)) {
+    return CGSizeZero;
+  }
+  if (!CGSizeEqualToSize(self.forcedSize, CGSizeZero) || self.forceUpscaling) {
+    return CGSizeZero;
+  }
+
+  const CGSize boundsSize = self.bounds.size;
+  const CGRect cropRect = self.isCropEnabled ? self.cropRect : CGRectZero;
+  const auto target = AS::ImageDownsampling::targetPixelSize(boundsSize.width, boundsSize.height, self.contentsScaleForDisplay,
+                                                              cropRect.size.width, cropRect.size.height);
+  return CGSizeMake(target.width, target.height);
+}
+
 - (void)_lazilyLoadImageIfNecessary
 {
   ASDisplayNodeAssertMainThread();
 
+  const CGSize targetPixelSize = [self _targetPixelSize];
+  const UIViewContentMode targetContentMode = self.contentMode;
+
   [self lock];
     __weak id<ASNetworkImageNodeDelegate> delegate = _delegate;
     BOOL delegateDidStartFetchingData = _networkImageNodeFlags.delegateDidStartFetchingData;
@@ -719,6 +767,8 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
     BOOL isImageLoaded = _networkImageNodeFlags.imageLoaded;
     __block NSURL *URL = _URL;
     id currentDownloadIdentifier = _downloadIdentifier;
+    _targetPixelSize = targetPixelSize;
+    _targetContentMode = targetContentMode;
   [self unlock];
   
   if (!isImageLoaded && URL != nil && currentDownloadIdentifier == nil) {
@@ -898,9 +948,17 @@ static std::atomic_bool _useMainThreadDelegateCallbacks(true);
         if (delegateWillLoadImageFromCache) {
           [delegate imageNodeWillLoadImageFromCache:self];
         }
-        [_cache cachedImageWithURL:URL
-                     callbackQueue:[self callbackQueue]
-                        completion:completion];
+        if (_networkImageNodeFlags.cacheSupportsTargetSize && !CGSizeEqualToSize(targetPixelSize, CGSizeZero)) {
+          [_cache cachedImageWithURL:URL
+                     targetPixelSize:targetPixelSize
+                         contentMode:targetContentMode
+                       callbackQueue:[self callbackQueue]
+                          completion:completion];
+        } else {
+          [_cache cachedImageWithURL:URL
+                       callbackQueue:[self callbackQueue]
+                          completion:completion];
+        }
       } else {
         if (delegateWillLoadImageFromNetwork) {
           [delegate imageNodeWillLoadImageFromNetwork:self];
@@ -43,6 +43,14 @@ AS_SUBCLASSING_RESTRICTED
 @property (readonly) BOOL isEmpty;
 
 @property (nonatomic) NSUInteger batchSize;           // Default == 1.
+
+/**
+ * If non-zero, each turn of the run loop processes as many items as fit in this much time, counted from when the
+ * run loop woke up, instead of batchSize items. The time per item is a moving average of the recent items, and at
+ * least one item is processed in each turn. Without a handler, this is the time to release the items.
+ * Default == 0.
+ */
+@property (nonatomic) CFTimeInterval timeBudget;
 @property (nonatomic) BOOL ensureExclusiveMembership; // Default == YES.  Set-like behavior.
 
 @end
@@ -67,6 +75,48 @@ AS_SUBCLASSING_RESTRICTED
 
 @end
 
+/**
+ * Counters of the background deallocation queue. Times are spent releasing objects on the drain thread.
+ */
+typedef struct {
+  /// Objects released.
+  NSUInteger objectCount;
+  /// Drains that released objects.
+  NSUInteger drainCount;
+  /// Objects that were handed over on the main thread.
+  NSUInteger mainThreadObjectCount;
+  /// The time spent releasing the objects handed over on the main thread, which it would have spent otherwise.
+  CFTimeInterval mainThreadReleaseTime;
+  /// The time spent releasing all objects.
+  CFTimeInterval releaseTime;
+} ASDeallocQueueStatistics;
+
+/**
+ * Releases objects on a low priority thread, in batches.
+ *
+ * Objects go into a lock-free list, and the drain thread takes all of them at once. Releasing a node there releases
+ * its subtree, its layouts and its images off the main thread. The views and layers of those nodes still go back to
+ * the main thread deallocation queue, see -scheduleIvarsForMainThreadDeallocation.
+ */
+AS_SUBCLASSING_RESTRICTED
+@interface ASDeallocQueue : NSObject
+
+@property (class, readonly) ASDeallocQueue *sharedDeallocationQueue;
+
+/**
+ * Takes over the caller's reference to the object and sets the pointer to nil.
+ */
+- (void)releaseObjectInBackground:(id _Nullable __strong * _Nonnull)objectPtr;
+
+/**
+ * Releases the objects handed over so far before returning.
+ */
+- (void)drain;
+
+@property (readonly) ASDeallocQueueStatistics statistics;
+
+@end
+
 extern ASCATransactionQueue *_ASSharedCATransactionQueue;
 extern dispatch_once_t _ASSharedCATransactionQueueOnceToken;
 
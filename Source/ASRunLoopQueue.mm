@@ -13,6 +13,9 @@
 #import <AsyncDisplayKit/ASRunLoopQueue.h>
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/ASSignpost.h>
+#import <QuartzCore/QuartzCore.h>
+#import <algorithm>
+#import <atomic>
 #import <vector>
 
 #define ASRunLoopQueueLoggingEnabled 0
@@ -43,16 +46,104 @@ static void runLoopSourceCallback(void *info) {
 
 #pragma mark - ASRunLoopQueue
 
+/// How much each processed item moves the average time per item.
+static const CFTimeInterval kItemDurationSmoothing = 0.2;
+
+namespace {
+
+/**
+ * A growable ring of strong or weak objects, oldest first. Taking an object leaves a nil tombstone, as does a weak
+ * object that was deallocated, and tombstones are skipped at the head, so nothing is ever moved to compact it.
+ */
+template <typename ObjectPointer>
+class ASRunLoopQueueRing {
+public:
+  /// The number of slots in use, including tombstones.
+  size_t size() const { return _count; }
+
+  void push(id object)
+  {
+    if (_count == _slots.size()) {
+      grow();
+    }
+    _slots[(_head + _count) & (_slots.size() - 1)] = object;
+    _count++;
+  }
+
+  /// Takes the oldest object, skipping tombstones. Returns nil if there is none.
+  id pop()
+  {
+    while (_count > 0) {
+      ObjectPointer &slot = _slots[_head];
+      id object = slot;
+      slot = nil;
+      _head = (_head + 1) & (_slots.size() - 1);
+      _count--;
+      if (object != nil) {
+        return object;
+      }
+    }
+    return nil;
+  }
+
+  /// Drops the tombstones at the head, so that an empty ring only counts as empty once they are gone.
+  void skipTombstones()
+  {
+    while (_count > 0 && _slots[_head] == nil) {
+      _head = (_head + 1) & (_slots.size() - 1);
+      _count--;
+    }
+  }
+
+  bool contains(id object) const
+  {
+    for (size_t i = 0; i < _count; i++) {
+      if (_slots[(_head + i) & (_slots.size() - 1)] == object) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  void grow()
+  {
+    std::vector<ObjectPointer> slots(std::max<size_t>(_slots.size() * 2, 16));
+    for (size_t i = 0; i < _count; i++) {
+      slots[i] = _slots[(_head + i) & (_slots.size() - 1)];
+    }
+    _slots.swap(slots);
+    _head = 0;
+  }
+
+  // The capacity is a power of 2.
+  std::vector<ObjectPointer> _slots;
+  size_t _head = 0;
+  size_t _count = 0;
+};
+
+} // namespace
+
 @interface ASRunLoopQueue () {
   CFRunLoopRef _runLoop;
   CFRunLoopSourceRef _runLoopSource;
   CFRunLoopObserverRef _runLoopObserver;
-  NSPointerArray *_internalQueue; // Use NSPointerArray so we can decide __strong or __weak per-instance.
+  // Only one of them is used, depending on whether the queue retains its objects.
+  BOOL _retainsObjects;
+  ASRunLoopQueueRing<__strong id> _strongItems;
+  ASRunLoopQueueRing<__weak id> _weakItems;
+  // The retained objects in the queue, for ensureExclusiveMembership. No retain, no release, pointer equality. A weak
+  // object's address may be reused after it is deallocated, so weak queues look for the object in the ring instead.
+  CFMutableSetRef _strongItemSet;
   AS::RecursiveMutex _internalQueueLock;
 
   // In order to not pollute the top-level activities, each queue has 1 root activity.
   os_activity_t _rootActivity;
 
+  // Only accessed on the run loop's thread.
+  CFTimeInterval _runLoopWakeTime;
+  CFTimeInterval _averageItemDuration;
+
 #if ASRunLoopQueueLoggingEnabled
   NSTimer *_runloopQueueLoggingTimer;
 #endif
@@ -60,16 +151,25 @@ static void runLoopSourceCallback(void *info) {
 
 @property (nonatomic) void (^queueConsumer)(id dequeuedItem, BOOL isQueueDrained);
 
+- (void)_runLoopSourceDidFire;
+
 @end
 
+static void runLoopQueueSourceCallback(void *info) {
+#if ASRunLoopQueueVerboseLoggingEnabled
+  NSLog(@"<%@> - Called runLoopQueueSourceCallback", info);
+#endif
+  [(__bridge ASRunLoopQueue *)info _runLoopSourceDidFire];
+}
+
 @implementation ASRunLoopQueue
 
 - (instancetype)initWithRunLoop:(CFRunLoopRef)runloop retainObjects:(BOOL)retainsObjects handler:(void (^)(id _Nullable, BOOL))handlerBlock
 {
   if (self = [super init]) {
     _runLoop = runloop;
-    NSPointerFunctionsOptions options = retainsObjects ? NSPointerFunctionsStrongMemory : NSPointerFunctionsWeakMemory;
-    _internalQueue = [[NSPointerArray alloc] initWithOptions:options];
+    _retainsObjects = retainsObjects;
+    _strongItemSet = CFSetCreateMutable(NULL, 0, NULL);
     _queueConsumer = handlerBlock;
     _batchSize = 1;
     _ensureExclusiveMembership = YES;
@@ -87,18 +187,22 @@ static void runLoopSourceCallback(void *info) {
     // unowned(__unsafe_unretained) allows us to avoid flagging the memory cycle detector.
     unowned __typeof__(self) weakSelf = self;
     void (^handlerBlock) (CFRunLoopObserverRef observer, CFRunLoopActivity activity) = ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
-      [weakSelf processQueue];
+      if (activity == kCFRunLoopAfterWaiting) {
+        // The start of this turn of the run loop, which the time budget counts from.
+        weakSelf->_runLoopWakeTime = CACurrentMediaTime();
+      } else {
+        [weakSelf processQueue];
+      }
     };
-    _runLoopObserver = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopBeforeWaiting, true, 0, handlerBlock);
+    _runLoopObserver = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopBeforeWaiting | kCFRunLoopAfterWaiting, true, 0, handlerBlock);
     CFRunLoopAddObserver(_runLoop, _runLoopObserver,  kCFRunLoopCommonModes);
     
     // It is not guaranteed that the runloop will turn if it has no scheduled work, and this causes processing of
     // the queue to stop. Attaching a custom loop source to the run loop and signal it if new work needs to be done
+    // The source is removed in -dealloc, so it doesn't retain self either.
     CFRunLoopSourceContext sourceContext = {};
-    sourceContext.perform = runLoopSourceCallback;
-#if ASRunLoopQueueLoggingEnabled
+    sourceContext.perform = runLoopQueueSourceCallback;
     sourceContext.info = (__bridge void *)self;
-#endif
     _runLoopSource = CFRunLoopSourceCreate(NULL, 0, &sourceContext);
     CFRunLoopAddSource(runloop, _runLoopSource, kCFRunLoopCommonModes);
 
@@ -123,84 +227,110 @@ static void runLoopSourceCallback(void *info) {
   }
   CFRelease(_runLoopObserver);
   _runLoopObserver = nil;
+
+  CFRelease(_strongItemSet);
 }
 
 #if ASRunLoopQueueLoggingEnabled
 - (void)checkRunLoop
 {
-    NSLog(@"<%@> - Jobs: %ld", self, _internalQueue.count);
+    NSLog(@"<%@> - Jobs: %ld", self, [self _itemCount]);
 }
 #endif
 
+/**
+ * A signaled source keeps the run loop from sleeping, so the next pass of the queue comes without an AfterWaiting
+ * activity. It starts a new turn all the same: everything else the run loop had to do ran in between.
+ */
+- (void)_runLoopSourceDidFire
+{
+  _runLoopWakeTime = CACurrentMediaTime();
+}
+
+/// The number of slots in use, including tombstones. Must be called with the lock held.
+- (size_t)_itemCount
+{
+  return _retainsObjects ? _strongItems.size() : _weakItems.size();
+}
+
+/**
+ * The number of items to process in this turn of the run loop. With a time budget, it is as many as fit in what is
+ * left of the budget at the recent average time per item, but at least one.
+ */
+- (NSInteger)_batchCountWithBudget:(CFTimeInterval)timeBudget
+{
+  if (timeBudget <= 0) {
+    return self.batchSize;
+  }
+  if (_averageItemDuration <= 0) {
+    // Measure one first.
+    return 1;
+  }
+  const CFTimeInterval elapsed = (_runLoopWakeTime > 0 ? CACurrentMediaTime() - _runLoopWakeTime : 0);
+  const CFTimeInterval remaining = timeBudget - elapsed;
+  return MAX(1, (NSInteger)(remaining / _averageItemDuration));
+}
+
 - (void)processQueue
 {
   BOOL hasExecutionBlock = (_queueConsumer != nil);
+  const CFTimeInterval timeBudget = self.timeBudget;
 
-  // If we have an execution block, this vector will be populated, otherwise remains empty.
-  // This is to avoid needlessly retaining/releasing the objects if we don't have a block.
+  // The objects are taken out of the queue, and released after they are processed. Without an execution block, this
+  // is when they are deallocated, which is measured with the time budget as well.
   std::vector<id> itemsToProcess;
 
   BOOL isQueueDrained = NO;
   {
     MutexLocker l(_internalQueueLock);
 
-    NSInteger internalQueueCount = _internalQueue.count;
     // Early-exit if the queue is empty.
-    if (internalQueueCount == 0) {
+    if ([self _itemCount] == 0) {
       return;
     }
 
     ASSignpostStart(RunLoopQueueBatch, self, "%s", object_getClassName(self));
 
-    // Snatch the next batch of items.
-    NSInteger maxCountToProcess = MIN(internalQueueCount, self.batchSize);
-
-    /**
-     * For each item in the next batch, if it's non-nil then NULL it out
-     * and if we have an execution block then add it in.
-     * This could be written a bunch of different ways but
-     * this particular one nicely balances readability, safety, and efficiency.
-     */
-    NSInteger foundItemCount = 0;
-    for (NSInteger i = 0; i < internalQueueCount && foundItemCount < maxCountToProcess; i++) {
-      /**
-       * It is safe to use unsafe_unretained here. If the queue is weak, the
-       * object will be added to the autorelease pool. If the queue is strong,
-       * it will retain the object until we transfer it (retain it) in itemsToProcess.
-       */
-      unowned id ptr = (__bridge id)[_internalQueue pointerAtIndex:i];
-      if (ptr != nil) {
-        foundItemCount++;
-        if (hasExecutionBlock) {
-          itemsToProcess.push_back(ptr);
-        }
-        [_internalQueue replacePointerAtIndex:i withPointer:NULL];
+    // Snatch the next batch of items, skipping weak objects that were deallocated.
+    const NSInteger maxCountToProcess = [self _batchCountWithBudget:timeBudget];
+    itemsToProcess.reserve(MIN((size_t)maxCountToProcess, [self _itemCount]));
+    while ((NSInteger)itemsToProcess.size() < maxCountToProcess) {
+      id object = (_retainsObjects ? _strongItems.pop() : _weakItems.pop());
+      if (object == nil) {
+        break;
       }
+      if (_retainsObjects) {
+        CFSetRemoveValue(_strongItemSet, (__bridge void *)object);
+      }
+      itemsToProcess.push_back(std::move(object));
     }
 
-    if (foundItemCount == 0) {
-      // If _internalQueue holds weak references, and all of them just become NULL, then the array
-      // is never marked as needsCompletion, and compact will return early, not removing the NULL's.
-      // Inserting a NULL here ensures the compaction will take place.
-      // See http://www.openradar.me/15396578 and https://stackoverflow.com/a/40274426/1136669
-      [_internalQueue addPointer:NULL];
+    // Weak objects that were deallocated after the last item must not keep the queue from counting as drained.
+    if (_retainsObjects) {
+      _strongItems.skipTombstones();
+    } else {
+      _weakItems.skipTombstones();
     }
-
-    [_internalQueue compact];
-    if (_internalQueue.count == 0) {
+    if ([self _itemCount] == 0) {
       isQueueDrained = YES;
     }
   }
 
-  // itemsToProcess will be empty if _queueConsumer == nil so no need to check again.
   const auto count = itemsToProcess.size();
   if (count > 0) {
     as_activity_scope_verbose(as_activity_create("Process run loop queue batch", _rootActivity, OS_ACTIVITY_FLAG_DEFAULT));
-    const auto itemsEnd = itemsToProcess.cend();
-    for (auto iterator = itemsToProcess.begin(); iterator < itemsEnd; iterator++) {
-      unowned id value = *iterator;
-      _queueConsumer(value, isQueueDrained && iterator == itemsEnd - 1);
-      as_log_verbose(ASDisplayLog(), "processed %@", value);
+    for (size_t i = 0; i < count; i++) {
+      const CFTimeInterval start = (timeBudget > 0 ? CACurrentMediaTime() : 0);
+      if (hasExecutionBlock) {
+        _queueConsumer(itemsToProcess[i], isQueueDrained && i == count - 1);
+        as_log_verbose(ASDisplayLog(), "processed %@", itemsToProcess[i]);
+      }
+      itemsToProcess[i] = nil;
+      if (timeBudget > 0) {
+        const CFTimeInterval duration = CACurrentMediaTime() - start;
+        const CFTimeInterval average = _averageItemDuration;
+        _averageItemDuration = (average > 0 ? average + kItemDurationSmoothing * (duration - average) : duration);
+      }
     }
     if (count > 1) {
       as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)count);
@@ -213,7 +343,8 @@ static void runLoopSourceCallback(void *info) {
     CFRunLoopWakeUp(_runLoop);
   }
   
-  ASSignpostEnd(RunLoopQueueBatch, self, "count: %d", (int)count);
+  // With a time budget, the interval from the start of the turn shows whether the batch overran the frame.
+  ASSignpostEnd(RunLoopQueueBatch, self, "count: %d, budget: %d us, since wake: %d us", (int)count, (int)(timeBudget * 1e6), (int)(_runLoopWakeTime > 0 ? (CACurrentMediaTime() - _runLoopWakeTime) * 1e6 : 0));
 }
 
 - (void)enqueue:(id)object
@@ -224,31 +355,29 @@ static void runLoopSourceCallback(void *info) {
   
   MutexLocker l(_internalQueueLock);
 
-  // Check if the object exists.
-  BOOL foundObject = NO;
-    
   if (_ensureExclusiveMembership) {
-    for (id currentObject in _internalQueue) {
-      if (currentObject == object) {
-        foundObject = YES;
-        break;
-      }
+    // Check if the object exists.
+    if (_retainsObjects ? CFSetContainsValue(_strongItemSet, (__bridge void *)object) : _weakItems.contains(object)) {
+      return;
     }
   }
 
-  if (!foundObject) {
-    [_internalQueue addPointer:(__bridge void *)object];
-    if (_internalQueue.count == 1) {
-      CFRunLoopSourceSignal(_runLoopSource);
-      CFRunLoopWakeUp(_runLoop);
-    }
+  if (_retainsObjects) {
+    _strongItems.push(object);
+    CFSetAddValue(_strongItemSet, (__bridge void *)object);
+  } else {
+    _weakItems.push(object);
+  }
+  if ([self _itemCount] == 1) {
+    CFRunLoopSourceSignal(_runLoopSource);
+    CFRunLoopWakeUp(_runLoop);
   }
 }
 
 - (BOOL)isEmpty
 {
   MutexLocker l(_internalQueueLock);
-  return _internalQueue.count == 0;
+  return [self _itemCount] == 0;
 }
 
 ASSynthesizeLockingMethodsWithMutex(_internalQueueLock)
@@ -428,3 +557,146 @@ dispatch_once_t _ASSharedCATransactionQueueOnceToken;
 }
 
 @end
+
+#pragma mark - ASDeallocQueue
+
+/// How long the drain thread waits after the first object, so that the objects after it are released in one batch.
+static const int64_t kDeallocQueueDrainDelay = 100 * NSEC_PER_MSEC;
+/// How many objects each DeallocQueueDrain signpost covers.
+static const size_t kDeallocQueueChunkSize = 100;
+
+namespace {
+
+struct ASDeallocQueueEntry {
+  /// The retained object.
+  void *object;
+  /// Whether the object was handed over on the main thread.
+  bool fromMainThread;
+  ASDeallocQueueEntry *next;
+};
+
+} // namespace
+
+@interface ASDeallocQueue () {
+  // A lock-free list, newest first. Producers push with a compare and swap, and the drain takes the whole list with
+  // an exchange. Entries are never popped one by one, so there is no ABA problem.
+  std::atomic<ASDeallocQueueEntry *> _head;
+  dispatch_queue_t _drainQueue;
+
+  AS::Mutex _statisticsLock;
+  ASDeallocQueueStatistics _statistics;
+}
+
+@end
+
+@implementation ASDeallocQueue
+
++ (ASDeallocQueue *)sharedDeallocationQueue NS_RETURNS_RETAINED
+{
+  static ASDeallocQueue *deallocQueue;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    deallocQueue = [[ASDeallocQueue alloc] init];
+  });
+  return deallocQueue;
+}
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _head.store(nullptr, std::memory_order_relaxed);
+    _drainQueue = dispatch_queue_create("org.AsyncDisplayKit.ASDeallocQueue", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0));
+  }
+  return self;
+}
+
+- (void)releaseObjectInBackground:(id __strong *)objectPtr
+{
+  if (objectPtr == NULL || *objectPtr == nil) {
+    return;
+  }
+
+  const auto entry = new ASDeallocQueueEntry{(__bridge_retained void *)*objectPtr, ASDisplayNodeThreadIsMain() ? true : false, nullptr};
+  *objectPtr = nil;
+
+  ASDeallocQueueEntry *head = _head.load(std::memory_order_relaxed);
+  do {
+    entry->next = head;
+  } while (!_head.compare_exchange_weak(head, entry, std::memory_order_release, std::memory_order_relaxed));
+
+  // The list is only empty when no drain is pending, so the first object schedules one.
+  if (head == nullptr) {
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, kDeallocQueueDrainDelay), _drainQueue, ^{
+      [self _drain];
+    });
+  }
+}
+
+- (void)drain
+{
+  dispatch_sync(_drainQueue, ^{
+    [self _drain];
+  });
+}
+
+- (ASDeallocQueueStatistics)statistics
+{
+  AS::MutexLocker l(_statisticsLock);
+  return _statistics;
+}
+
+/// Drain queue only.
+- (void)_drain
+{
+  ASDeallocQueueEntry *entry = _head.exchange(nullptr, std::memory_order_acquire);
+  if (entry == nullptr) {
+    return;
+  }
+
+  // Release in the order the objects were handed over.
+  ASDeallocQueueEntry *oldest = nullptr;
+  while (entry != nullptr) {
+    ASDeallocQueueEntry *next = entry->next;
+    entry->next = oldest;
+    oldest = entry;
+    entry = next;
+  }
+
+  NSUInteger count = 0;
+  NSUInteger mainThreadCount = 0;
+  CFTimeInterval releaseTime = 0;
+  CFTimeInterval mainThreadReleaseTime = 0;
+  entry = oldest;
+  while (entry != nullptr) {
+    ASSignpostStart(DeallocQueueDrain, self, "%s", object_getClassName(self));
+    size_t chunkCount = 0;
+    @autoreleasepool {
+      for (; entry != nullptr && chunkCount < kDeallocQueueChunkSize; chunkCount++) {
+        ASDeallocQueueEntry *next = entry->next;
+        const CFTimeInterval start = CACurrentMediaTime();
+        {
+          __unused id object = (__bridge_transfer id)entry->object;
+        }
+        const CFTimeInterval duration = CACurrentMediaTime() - start;
+        releaseTime += duration;
+        if (entry->fromMainThread) {
+          mainThreadCount++;
+          mainThreadReleaseTime += duration;
+        }
+        delete entry;
+        entry = next;
+      }
+    }
+    count += chunkCount;
+    ASSignpostEnd(DeallocQueueDrain, self, "count: %lu", (unsigned long)chunkCount);
+  }
+
+  AS::MutexLocker l(_statisticsLock);
+  _statistics.objectCount += count;
+  _statistics.drainCount += 1;
+  _statistics.mainThreadObjectCount += mainThreadCount;
+  _statistics.mainThreadReleaseTime += mainThreadReleaseTime;
+  _statistics.releaseTime += releaseTime;
+}
+
+@end
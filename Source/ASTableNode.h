@@ -392,7 +392,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly) NSArray<__kindof ASCellNode *> *visibleNodes NS_SWIFT_UI_ACTOR;
 
 /**
- * Retrieves the node for the row at the given index path.
+ * Retrieves the node for the row at the given index path, or nil if the row is not materialized yet (exp_windowed_reload).
  */
 - (nullable __kindof ASCellNode *)nodeForRowAtIndexPath:(NSIndexPath *)indexPath AS_WARN_UNUSED_RESULT;
 
@@ -662,7 +662,8 @@ ASLayoutElementCollectionTableSetTraitCollection(_environmentStateLock)
 - (ASCellNode *)nodeForRowAtIndexPath:(NSIndexPath *)indexPath
 {
   [self reloadDataInitiallyIfNeeded];
-  return [self.dataController.pendingMap elementForItemAtIndexPath:indexPath].node;
+  ASCollectionElement *element = [self.dataController.pendingMap elementForItemAtIndexPath:indexPath];
+  return element.isPlaceholder ? nil : element.node;
 }
 
 - (CGRect)rectForRowAtIndexPath:(NSIndexPath *)indexPath
@@ -22,6 +22,7 @@
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASElementMap.h>
+#import <AsyncDisplayKit/ASEqualityHelpers.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASTableNode+Beta.h>
@@ -188,6 +189,7 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   BOOL _automaticallyAdjustsContentOffset;
   
   CGPoint _deceleratingVelocity;
+  CGPoint _targetContentOffset;
 
   CGFloat _nodesConstrainedWidth;
   BOOL _queuedNodeHeightUpdate;
@@ -593,7 +595,8 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
 
 - (ASCellNode *)nodeForRowAtIndexPath:(NSIndexPath *)indexPath
 {
-  return [_dataController.visibleMap elementForItemAtIndexPath:indexPath].node;
+  ASCollectionElement *element = [_dataController.visibleMap elementForItemAtIndexPath:indexPath];
+  return element.isPlaceholder ? nil : element.node;
 }
 
 - (NSIndexPath *)convertIndexPathFromTableNode:(NSIndexPath *)indexPath waitingIfNeeded:(BOOL)wait
@@ -914,7 +917,7 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   _ASTableViewCell *cell = [self dequeueReusableCellWithIdentifier:kCellReuseIdentifier forIndexPath:indexPath];
   cell.delegate = self;
 
-  ASCollectionElement *element = [_dataController.visibleMap elementForItemAtIndexPath:indexPath];
+  ASCollectionElement *element = [_dataController materializedElementForItemAtIndexPath:indexPath];
   cell.element = element;
   ASCellNode *node = element.node;
   if (node) {
@@ -928,7 +931,8 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
 {
   CGFloat height = 0.0;
 
-  ASCollectionElement *element = [_dataController.visibleMap elementForItemAtIndexPath:indexPath];
+  // With estimated row heights, UITableView only asks for the rows it is about to show.
+  ASCollectionElement *element = [_dataController materializedElementForItemAtIndexPath:indexPath];
   if (element != nil) {
     ASCellNode *node = element.node;
     ASDisplayNodeAssertNotNil(node, @"Node must not be nil!");
@@ -1015,7 +1019,7 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
 {
   ASCollectionElement *element = cell.element;
   if (element) {
-    ASDisplayNodeAssertTrue([_dataController.visibleMap elementForItemAtIndexPath:indexPath] == element);
+    ASDisplayNodeAssertTrue(ASObjectIsEqual([_dataController.visibleMap elementForItemAtIndexPath:indexPath], element));
     [_visibleElements addObject:element];
   } else {
     ASDisplayNodeAssert(NO, @"Unexpected nil element for willDisplayCell: %@, %@, %@", cell, self, indexPath);
@@ -1294,6 +1298,8 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   if (_asyncDelegateFlags.scrollViewWillEndDragging) {
     [_asyncDelegate scrollViewWillEndDragging:scrollView withVelocity:velocity targetContentOffset:(targetContentOffset ? : &contentOffset)];
   }
+  // Read after the delegate, which may have changed the target.
+  _targetContentOffset = (targetContentOffset != NULL) ? *targetContentOffset : contentOffset;
 }
 
 - (void)scrollViewDidEndDecelerating:(UIScrollView *)scrollView
@@ -1529,11 +1535,24 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   return self.scrollDirection;
 }
 
+- (ASScrollMotion)scrollMotionForRangeController:(ASRangeController *)rangeController
+{
+  return ASScrollMotionForScrollView(self, self.scrollableDirections, _targetContentOffset);
+}
+
 - (ASInterfaceState)interfaceStateForRangeController:(ASRangeController *)rangeController
 {
   return ASInterfaceStateForDisplayNode(self.tableNode, self.window);
 }
 
+- (void)rangeController:(ASRangeController *)rangeController materializePlaceholdersAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+  __weak __typeof__(self) weakSelf = self;
+  [_dataController materializeItemsAtIndexPaths:indexPaths completion:^{
+    [weakSelf.rangeController setNeedsUpdate];
+  }];
+}
+
 - (NSString *)nameForRangeControllerDataSource
 {
   return self.asyncDataSource ? NSStringFromClass([self.asyncDataSource class]) : NSStringFromClass([self class]);
@@ -1706,6 +1725,30 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   return NO;
 }
 
+- (NSArray<NSIndexPath *> *)visibleIndexPathsForDataController:(ASDataController *)dataController
+{
+  return self.indexPathsForVisibleRows;
+}
+
+- (CGSize)dataController:(ASDataController *)dataController estimatedSizeForItemsInSection:(NSInteger)section
+{
+  // Without an estimate, UITableView asks for the height of every row, which needs every node.
+  CGFloat estimatedRowHeight = self.estimatedRowHeight;
+  if (estimatedRowHeight <= 0) {
+    return CGSizeZero;
+  }
+  return CGSizeMake(_nodesConstrainedWidth, estimatedRowHeight);
+}
+
+- (void)dataController:(ASDataController *)dataController didRelayoutNodes:(NSArray<ASCellNode *> *)nodesSizeChanged
+{
+  ASDisplayNodeAssertMainThread();
+  // The nodes are offscreen, so there is nothing to animate.
+  [UIView performWithoutAnimation:^{
+    [self requeryNodeHeights];
+  }];
+}
+
 - (BOOL)dataController:(ASDataController *)dataController shouldSynchronouslyProcessChangeSet:(_ASHierarchyChangeSet *)changeSet
 {
   // Reload data is expensive, don't block main while doing so.
@@ -28,10 +28,10 @@
 
 #import <AsyncDisplayKit/ASTextKitCoreTextAdditions.h>
 #import <AsyncDisplayKit/ASTextKitRenderer+Positioning.h>
+#import <AsyncDisplayKit/ASTextKitRendererCache.h>
 #import <AsyncDisplayKit/ASTextKitShadower.h>
 
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
-#import <AsyncDisplayKit/ASHashing.h>
 
 /**
  * If set, we will record all values set to attributedText into an array
@@ -50,87 +50,13 @@ static NSString *ASTextNodeTruncationTokenAttributeName = @"ASTextNodeTruncation
 
 #pragma mark - ASTextKitRenderer
 
-@interface ASTextNodeRendererKey : NSObject
-- (instancetype)initWithTextKitAttributes:(const ASTextKitAttributes &)attributes constrainedSize:(const CGSize)constrainedSize;
-@end
-
-@implementation ASTextNodeRendererKey {
-  ASTextKitAttributes _attributes;
-  CGSize _constrainedSize;
-}
-
-- (instancetype)initWithTextKitAttributes:(const ASTextKitAttributes &)attributes constrainedSize:(const CGSize)constrainedSize
-{
-  if (self = [super init]) {
-    _attributes = attributes;
-    _constrainedSize = constrainedSize;
-  }
-  return self;
-}
-
-- (NSUInteger)hash
-{
-#pragma clang diagnostic push
-#pragma clang diagnostic warning "-Wpadded"
-  struct {
-    size_t attributesHash;
-    CGSize constrainedSize;
-#pragma clang diagnostic pop
-  } data = {
-    _attributes.hash(),
-    _constrainedSize
-  };
-  return ASHashBytes(&data, sizeof(data));
-}
-
-- (BOOL)isEqual:(ASTextNodeRendererKey *)object
-{
-  if (self == object) {
-    return YES;
-  }
-  if (!object) {
-    return NO;
-  }
-  // NOTE: Skip the class check for this specialized, internal Key object.
-  
-  return _attributes == object->_attributes && CGSizeEqualToSize(_constrainedSize, object->_constrainedSize);
-}
-
-@end
-
-static NSCache *sharedRendererCache()
-{ 
- static dispatch_once_t onceToken;
- static NSCache *__rendererCache = nil;
- dispatch_once(&onceToken, ^{
-   __rendererCache = [[NSCache alloc] init];
-   __rendererCache.countLimit = 500; // 500 renders cache
- });
- return __rendererCache;
-}
-
 /**
  The concept here is that neither the node nor layout should ever have a strong reference to the renderer object.
  This is to reduce memory load when loading thousands and thousands of text nodes into memory at once. Instead
  we maintain a LRU renderer cache that is queried via a unique key based on text kit attributes and constrained size. 
- */
 
-static ASTextKitRenderer *_rendererForAttributes(ASTextKitAttributes attributes, CGSize constrainedSize)
-{
-  NSCache *cache = sharedRendererCache();
-  
-  ASTextNodeRendererKey *key = [[ASTextNodeRendererKey alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
-
-  ASTextKitRenderer *renderer = [cache objectForKey:key];
-  if (renderer == nil) {
-    renderer = [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
-    [cache setObject:renderer forKey:key];
-  }
-  
-  return renderer;
-}
-
-static AS::RecursiveMutex __sharedRendererCacheInstanceLock__;
+ The cache is sharded and safe to use from any thread, so exp_lock_text_renderer_cache has no effect anymore.
+ */
 
 static ASTextKitRenderer *rendererForAttributes(ASTextKitAttributes attributes, CGSize constrainedSize)
 {
@@ -138,13 +64,7 @@ static ASTextKitRenderer *rendererForAttributes(ASTextKitAttributes attributes,
   if (neverCache) {
     return [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
   }
-  
-  BOOL lockCache = ASActivateExperimentalFeature(ASExperimentalLockTextRendererCache);
-  if (lockCache) {
-    AS::MutexLocker l(__sharedRendererCacheInstanceLock__);
-    return _rendererForAttributes(attributes, constrainedSize);
-  }
-  return _rendererForAttributes(attributes, constrainedSize);
+  return ASTextKitRendererCacheGetRenderer(attributes, constrainedSize);
 }
 
 #pragma mark - ASTextNodeDrawParameter
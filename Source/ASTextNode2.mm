@@ -10,7 +10,6 @@
 #import <AsyncDisplayKit/ASTextNode.h>  // Definition of ASTextNodeDelegate
 
 #import <tgmath.h>
-#import <deque>
 
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
@@ -23,15 +22,7 @@
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
 
 #import <AsyncDisplayKit/ASTextLayout.h>
-
-@interface ASTextCacheValue : NSObject {
-  @package
-  AS::Mutex _m;
-  std::deque<std::tuple<CGSize, ASTextLayout *>> _layouts;
-}
-@end
-@implementation ASTextCacheValue
-@end
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
 
 /**
  * If set, we will record all values set to attributedText into an array
@@ -42,95 +33,6 @@
  */
 #define AS_TEXTNODE2_RECORD_ATTRIBUTED_STRINGS 0
 
-/**
- * If it can't find a compatible layout, this method creates one.
- *
- * NOTE: Be careful to copy `text` if needed.
- */
-static NS_RETURNS_RETAINED ASTextLayout *ASTextNodeCompatibleLayoutWithContainerAndText(ASTextContainer *container, NSAttributedString *text)  {
-  static dispatch_once_t onceToken;
-  static AS::Mutex *layoutCacheLock;
-  static NSCache<NSAttributedString *, ASTextCacheValue *> *textLayoutCache;
-  dispatch_once(&onceToken, ^{
-    layoutCacheLock = new AS::Mutex();
-    textLayoutCache = [[NSCache alloc] init];
-  });
-
-  layoutCacheLock->lock();
-
-  ASTextCacheValue *cacheValue = [textLayoutCache objectForKey:text];
-  if (cacheValue == nil) {
-    cacheValue = [[ASTextCacheValue alloc] init];
-    [textLayoutCache setObject:cacheValue forKey:[text copy]];
-  }
-
-  // Lock the cache item for the rest of the method. Only after acquiring can we release the NSCache.
-  AS::MutexLocker lock(cacheValue->_m);
-  layoutCacheLock->unlock();
-
-  CGRect containerBounds = (CGRect){ .size = container.size };
-  {
-    for (const auto &t : cacheValue->_layouts) {
-      CGSize constrainedSize = std::get<0>(t);
-      ASTextLayout *layout = std::get<1>(t);
-
-      CGSize layoutSize = layout.textBoundingSize;
-      // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
-      // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
-      //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
-      // 3. Thus, those two values (constrained width & returned width) form a range, where
-      //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
-      //    width is in that range, between the min and max of those two values.
-      CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(containerBounds, minRect)) {
-        continue;
-      }
-      CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(maxRect, containerBounds)) {
-        continue;
-      }
-      if (!CGSizeEqualToSize(container.size, constrainedSize)) {
-        continue;
-      }
-
-      // Now check container params.
-      ASTextContainer *otherContainer = layout.container;
-      if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
-        continue;
-      }
-      if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
-        continue;
-      }
-      if (container.truncationType != otherContainer.truncationType) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
-        continue;
-      }
-      // TODO: When we get a cache hit, move this entry to the front (LRU).
-      return layout;
-    }
-  }
-
-  // Cache Miss. Compute the text layout.
-  ASTextLayout *layout = [ASTextLayout layoutWithContainer:container text:text];
-
-  // Store the result in the cache.
-  {
-    // This is a critical section. However we also must hold the lock until this point, in case
-    // another thread requests this cache item while a layout is being calculated, so they don't race.
-    cacheValue->_layouts.push_front(std::make_tuple(container.size, layout));
-    if (cacheValue->_layouts.size() > 3) {
-      cacheValue->_layouts.pop_back();
-    }
-  }
-
-  return layout;
-}
-
 static const NSTimeInterval ASTextNodeHighlightFadeOutDuration = 0.15;
 static const NSTimeInterval ASTextNodeHighlightFadeInDuration = 0.1;
 static const CGFloat ASTextNodeHighlightLightOpacity = 0.11;
@@ -354,7 +256,7 @@ static NSArray *DefaultLinkAttributeNames() {
 
   NSMutableAttributedString *mutableText = [_attributedText mutableCopy];
   [self prepareAttributedString:mutableText isForIntrinsicSize:isCalculatingIntrinsicSize];
-  ASTextLayout *layout = ASTextNodeCompatibleLayoutWithContainerAndText(_textContainer, mutableText);
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout(_textContainer, mutableText);
   if (layout.truncatedLine != nil && layout.truncatedLine.size.width > layout.textBoundingSize.width) {
     return (CGSize) {MIN(constrainedSize.width, layout.truncatedLine.size.width), layout.textBoundingSize.height};
   }
@@ -564,7 +466,7 @@ static NSArray *DefaultLinkAttributeNames() {
   ASTextContainer *container = layoutDict[@"container"];
   NSAttributedString *text = layoutDict[@"text"];
   UIColor *bgColor = layoutDict[@"bgColor"];
-  ASTextLayout *layout = ASTextNodeCompatibleLayoutWithContainerAndText(container, text);
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout(container, text);
   
   if (isCancelledBlock()) {
     return;
@@ -645,7 +547,7 @@ static NSArray *DefaultLinkAttributeNames() {
   // See discussion in https://github.com/TextureGroup/Texture/pull/396
   ASTextContainer *containerCopy = [_textContainer copy];
   containerCopy.size = self.calculatedSize;
-  ASTextLayout *layout = ASTextNodeCompatibleLayoutWithContainerAndText(containerCopy, _attributedText);
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout(containerCopy, _attributedText);
 
   if ([self _locked_pointInsideAdditionalTruncationMessage:point withLayout:layout]) {
     if (inAdditionalTruncationMessageOut != NULL) {
@@ -903,7 +805,7 @@ static NSArray *DefaultLinkAttributeNames() {
         // See discussion in https://github.com/TextureGroup/Texture/pull/396
         ASTextContainer *textContainerCopy = [_textContainer copy];
         textContainerCopy.size = self.calculatedSize;
-        ASTextLayout *layout = ASTextNodeCompatibleLayoutWithContainerAndText(textContainerCopy, _attributedText);
+        ASTextLayout *layout = ASTextLayoutCacheGetLayout(textContainerCopy, _attributedText);
 
         NSArray<ASTextSelectionRect *> *highlightRects = [layout selectionRectsWithoutStartAndEndForRange:[ASTextRange rangeWithRange:highlightRange]];
         NSMutableArray *converted = [NSMutableArray arrayWithCapacity:highlightRects.count];
@@ -1083,7 +985,7 @@ static CGRect ASTextNodeAdjustRenderRectForShadowPadding(CGRect rendererRect, UI
       // See discussion in https://github.com/TextureGroup/Texture/pull/396
       ASTextContainer *containerCopy = [_textContainer copy];
       containerCopy.size = self.calculatedSize;
-      ASTextLayout *layout = ASTextNodeCompatibleLayoutWithContainerAndText(containerCopy, _attributedText);
+      ASTextLayout *layout = ASTextLayoutCacheGetLayout(containerCopy, _attributedText);
       visibleRange = layout.visibleRange;
     }
     NSRange truncationMessageRange = [self _additionalTruncationMessageRangeWithVisibleRange:visibleRange];
@@ -1363,7 +1265,7 @@ static NSAttributedString *DefaultTruncationAttributedString()
 {
   ASTextContainer *container = [_textContainer copy];
   container.size = size;
-  return ASTextNodeCompatibleLayoutWithContainerAndText(container, _attributedText);
+  return ASTextLayoutCacheGetLayout(container, _attributedText);
 }
 
 - (NSUInteger)maximumNumberOfLines
@@ -12,6 +12,10 @@ typedef NS_ENUM(uint32_t, ASSignpostName) {
   // Collection/Table
   ASSignpostDataControllerBatch = 300,    // Alloc/layout nodes before collection update.
   ASSignpostRangeControllerUpdate,        // Ranges update pass.
+  ASSignpostMainSerialQueueDrain,         // Blocks run by one drain of ASMainSerialQueue.
+  ASSignpostDataControllerVisibleCells,   // Part of a DataControllerBatch until the visible cells are ready.
+  ASSignpostDataControllerOffscreenCells, // Part of a DataControllerBatch after the visible cells are ready.
+  ASSignpostDataControllerRelayoutChunk,  // Background remeasurement of offscreen cells after a size change.
   
   // Rendering
   ASSignpostLayerDisplay = 325,           // Client display callout.
@@ -18,6 +18,24 @@ ASDK_EXTERN ASDirectionalScreenfulBuffer ASDirectionalScreenfulBufferVertical(AS
 
 ASDK_EXTERN CGRect CGRectExpandToRangeWithScrollableDirections(CGRect rect, ASRangeTuningParameters tuningParameters, ASScrollDirection scrollableDirections, ASScrollDirection scrollDirection);
 
+/**
+ * The motion of a scroll view along the scrollable direction it is moving in the most.
+ *
+ * @param targetContentOffset Where the current deceleration will come to rest, as reported to
+ * -scrollViewWillEndDragging:withVelocity:targetContentOffset:. Ignored unless the scroll view is decelerating.
+ */
+ASDK_EXTERN ASScrollMotion ASScrollMotionForScrollView(UIScrollView *scrollView, ASScrollDirection scrollableDirections, CGPoint targetContentOffset);
+
+/**
+ * Sizes a range for the current scroll motion, see ASExperimentalAdaptiveRanges.
+ *
+ * The leading buffer covers what scrolls into view within the lead time, and the rest of a deceleration so that the
+ * viewport it comes to rest at is in range. The trailing buffer never grows beyond the one in parameters. The range,
+ * including the viewport, is kept within maximumScreenfuls by trimming the trailing buffer first. Neither buffer
+ * shrinks below minimumParameters.
+ */
+ASDK_EXTERN ASRangeTuningParameters ASRangeTuningParametersAdaptedToScrollMotion(ASRangeTuningParameters parameters, ASRangeTuningParameters minimumParameters, ASScrollMotion motion, CFTimeInterval leadTime, CGFloat maximumScreenfuls);
+
 @interface ASAbstractLayoutController : NSObject <ASLayoutController>
 
 @end
@@ -10,6 +10,7 @@
 #import <AsyncDisplayKit/ASAbstractLayoutController.h>
 #import <AsyncDisplayKit/ASAbstractLayoutController+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASInternalHelpers.h>
 
 ASRangeTuningParameters const ASRangeTuningParametersZero = {};
 
@@ -80,6 +81,62 @@ CGRect CGRectExpandToRangeWithScrollableDirections(CGRect rect, ASRangeTuningPar
   return rect;
 }
 
+ASScrollMotion ASScrollMotionForScrollView(UIScrollView *scrollView, ASScrollDirection scrollableDirections, CGPoint targetContentOffset)
+{
+  ASDisplayNodeCAssertMainThread();
+  CGPoint velocity = CGPointZero;
+  CGPoint distance = CGPointZero;
+  if (scrollView.isTracking) {
+    velocity = [scrollView.panGestureRecognizer velocityInView:scrollView.superview];
+  } else if (scrollView.isDecelerating) {
+    CGPoint contentOffset = scrollView.contentOffset;
+    distance = CGPointMake(targetContentOffset.x - contentOffset.x, targetContentOffset.y - contentOffset.y);
+    // The velocity is multiplied by decelerationRate every millisecond, so v / (1000 * ln(1 / rate)) points are left.
+    CGFloat rate = MIN(MAX(scrollView.decelerationRate, 0.5), 0.9999);
+    CGFloat perSecond = 1000.0 * log(1.0 / rate);
+    velocity = CGPointMake(distance.x * perSecond, distance.y * perSecond);
+  }
+
+  BOOL horizontal = ASScrollDirectionContainsHorizontalDirection(scrollableDirections)
+                    && (ASScrollDirectionContainsVerticalDirection(scrollableDirections) == NO || fabs(velocity.x) > fabs(velocity.y));
+  CGSize size = scrollView.bounds.size;
+  CGFloat scale = scrollView.traitCollection.displayScale > 0 ? scrollView.traitCollection.displayScale : ASScreenScale();
+
+  ASScrollMotion motion;
+  motion.velocity = fabs(horizontal ? velocity.x : velocity.y);
+  motion.distanceToTarget = fabs(horizontal ? distance.x : distance.y);
+  motion.viewportLength = horizontal ? size.width : size.height;
+  motion.bytesPerScreenful = size.width * size.height * scale * scale * 4;
+  return motion;
+}
+
+ASRangeTuningParameters ASRangeTuningParametersAdaptedToScrollMotion(ASRangeTuningParameters parameters,
+                                                                     ASRangeTuningParameters minimumParameters,
+                                                                     ASScrollMotion motion, CFTimeInterval leadTime,
+                                                                     CGFloat maximumScreenfuls)
+{
+  if (motion.viewportLength <= 0) {
+    return parameters;
+  }
+
+  // The viewport a deceleration comes to rest at is in range once the leading buffer spans the distance to it.
+  CGFloat scrolledDuringLeadTime = motion.velocity * leadTime;
+  CGFloat leading = MAX(scrolledDuringLeadTime, motion.distanceToTarget) / motion.viewportLength;
+  CGFloat trailing = parameters.trailingBufferScreenfuls;
+
+  // The viewport takes up one of the screenfuls.
+  CGFloat buffers = MAX(maximumScreenfuls - 1.0, 0.0);
+  leading = MIN(leading, buffers - minimumParameters.trailingBufferScreenfuls);
+  leading = MAX(leading, minimumParameters.leadingBufferScreenfuls);
+  trailing = MIN(trailing, buffers - leading);
+  trailing = MAX(trailing, minimumParameters.trailingBufferScreenfuls);
+
+  ASRangeTuningParameters adapted;
+  adapted.leadingBufferScreenfuls = leading;
+  adapted.trailingBufferScreenfuls = trailing;
+  return adapted;
+}
+
 @interface ASAbstractLayoutController () {
   std::vector<std::vector<ASRangeTuningParameters>> _tuningParameters;
 }
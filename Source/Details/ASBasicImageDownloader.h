@@ -7,6 +7,7 @@
 //  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
 //
 
+#import <AsyncDisplayKit/ASImageDownloadTransport.h>
 #import <AsyncDisplayKit/ASImageProtocols.h>
 
 NS_ASSUME_NONNULL_BEGIN
@@ -28,6 +29,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (class, readonly) ASBasicImageDownloader *sharedImageDownloader;
 + (ASBasicImageDownloader *)sharedImageDownloader NS_RETURNS_RETAINED;
 
+/**
+ * Creates a downloader that moves bytes with the given transport, e.g. one that serves images from memory in tests.
+ *
+ * Requests for the same URL share a download. At most maximumConcurrentDownloads downloads run at a time, the rest wait
+ * in order of priority. Visible requests suspend preload downloads when no slot is free.
+ */
+- (instancetype)initWithTransport:(id<ASImageDownloadTransport>)transport maximumConcurrentDownloads:(NSUInteger)maximumConcurrentDownloads NS_DESIGNATED_INITIALIZER;
+
 + (instancetype)new __attribute__((unavailable("+[ASBasicImageDownloader sharedImageDownloader] must be used.")));
 - (instancetype)init __attribute__((unavailable("+[ASBasicImageDownloader sharedImageDownloader] must be used.")));
 
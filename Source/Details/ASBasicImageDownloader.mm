@@ -9,32 +9,63 @@
 
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
 
+#import <memory>
 #import <objc/runtime.h>
 
 #import <AsyncDisplayKit/ASBasicImageDownloaderInternal.h>
 #import <AsyncDisplayKit/ASImageContainerProtocolCategories.h>
+#import <AsyncDisplayKit/ASImageDecoding.h>
+#import <AsyncDisplayKit/ASImageDownloadScheduler.h>
 #import <AsyncDisplayKit/ASThread.h>
 
 using AS::MutexLocker;
+using AS::DownloadScheduling::Action;
+using AS::DownloadScheduling::Actions;
+using AS::DownloadScheduling::Priority;
+using AS::DownloadScheduling::RequestID;
+using AS::DownloadScheduling::Scheduler;
 
 #pragma mark -
 /**
  * Collection of properties associated with a download request.
  */
 
+NSString * const kASBasicImageDownloaderContextRequestID = @"kASBasicImageDownloaderContextRequestID";
 NSString * const kASBasicImageDownloaderContextCallbackQueue = @"kASBasicImageDownloaderContextCallbackQueue";
 NSString * const kASBasicImageDownloaderContextProgressBlock = @"kASBasicImageDownloaderContextProgressBlock";
 NSString * const kASBasicImageDownloaderContextCompletionBlock = @"kASBasicImageDownloaderContextCompletionBlock";
+NSString * const kASBasicImageDownloaderContextTargetPixelSize = @"kASBasicImageDownloaderContextTargetPixelSize";
+NSString * const kASBasicImageDownloaderContextContentMode = @"kASBasicImageDownloaderContextContentMode";
 
-static inline float NSURLSessionTaskPriorityWithImageDownloaderPriority(ASImageDownloaderPriority priority) {
+// Decoded variants are small, this holds a few screens of thumbnails.
+static NSUInteger const kASBasicImageDownloaderDecodedImageCacheByteLimit = 16 * 1024 * 1024;
+
+// NSURLSession's default connections per host on iOS. Tasks beyond that wait inside the session, where we can't
+// reorder them anymore.
+static NSUInteger const kASBasicImageDownloaderDefaultMaximumConcurrentDownloads = 6;
+
+static inline Priority ASDownloadSchedulingPriorityWithImageDownloaderPriority(ASImageDownloaderPriority priority) {
   switch (priority) {
     case ASImageDownloaderPriorityPreload:
-      return NSURLSessionTaskPriorityLow;
+      return Priority::Preload;
 
     case ASImageDownloaderPriorityImminent:
-      return NSURLSessionTaskPriorityDefault;
+      return Priority::Imminent;
 
     case ASImageDownloaderPriorityVisible:
+      return Priority::Visible;
+  }
+}
+
+static inline float NSURLSessionTaskPriorityWithDownloadSchedulingPriority(Priority priority) {
+  switch (priority) {
+    case Priority::Preload:
+      return NSURLSessionTaskPriorityLow;
+
+    case Priority::Imminent:
+      return NSURLSessionTaskPriorityDefault;
+
+    case Priority::Visible:
       return NSURLSessionTaskPriorityHigh;
   }
 }
@@ -42,6 +73,7 @@ static inline float NSURLSessionTaskPriorityWithImageDownloaderPriority(ASImageD
 @interface ASBasicImageDownloaderContext ()
 {
   BOOL _invalid;
+  BOOL _finished;
   AS::RecursiveMutex __instanceLock__;
 }
 
@@ -51,38 +83,15 @@ static inline float NSURLSessionTaskPriorityWithImageDownloaderPriority(ASImageD
 
 @implementation ASBasicImageDownloaderContext
 
-static NSMutableDictionary *currentRequests = nil;
-
-+ (AS::Mutex *)currentRequestLock
++ (NSCache<NSString *, UIImage *> *)decodedImageCache
 {
   static dispatch_once_t onceToken;
-  static AS::Mutex *currentRequestsLock;
+  static NSCache<NSString *, UIImage *> *decodedImageCache;
   dispatch_once(&onceToken, ^{
-    currentRequestsLock = new AS::Mutex();
+    decodedImageCache = [[NSCache alloc] init];
+    decodedImageCache.totalCostLimit = kASBasicImageDownloaderDecodedImageCacheByteLimit;
   });
-  return currentRequestsLock;
-}
-
-+ (ASBasicImageDownloaderContext *)contextForURL:(NSURL *)URL
-{
-  MutexLocker l(*self.currentRequestLock);
-  if (!currentRequests) {
-    currentRequests = [[NSMutableDictionary alloc] init];
-  }
-  ASBasicImageDownloaderContext *context = currentRequests[URL];
-  if (!context) {
-    context = [[ASBasicImageDownloaderContext alloc] initWithURL:URL];
-    currentRequests[URL] = context;
-  }
-  return context;
-}
-
-+ (void)cancelContextWithURL:(NSURL *)URL
-{
-  MutexLocker l(*self.currentRequestLock);
-  if (currentRequests) {
-    [currentRequests removeObjectForKey:URL];
-  }
+  return decodedImageCache;
 }
 
 - (instancetype)initWithURL:(NSURL *)URL
@@ -98,14 +107,13 @@ static NSMutableDictionary *currentRequests = nil;
 {
   MutexLocker l(__instanceLock__);
 
-  NSURLSessionTask *sessionTask = self.sessionTask;
-  if (sessionTask) {
-    [sessionTask cancel];
-    self.sessionTask = nil;
+  id<ASImageDownloadTask> downloadTask = self.downloadTask;
+  if (downloadTask) {
+    self.downloadTask = nil;
+    [downloadTask cancel];
   }
 
   _invalid = YES;
-  [self.class cancelContextWithURL:self.URL];
 }
 
 - (BOOL)isCancelled
@@ -114,12 +122,59 @@ static NSMutableDictionary *currentRequests = nil;
   return _invalid;
 }
 
+- (BOOL)startWithDownloadTask:(id<ASImageDownloadTask>)downloadTask
+{
+  MutexLocker l(__instanceLock__);
+  if (_invalid || _finished || self.downloadTask != nil) {
+    return NO;
+  }
+  self.downloadTask = downloadTask;
+  return YES;
+}
+
+- (void)suspendProducingResumeData:(void (^)(NSData * _Nullable resumeData))completionHandler
+{
+  id<ASImageDownloadTask> downloadTask;
+  {
+    MutexLocker l(__instanceLock__);
+    downloadTask = self.downloadTask;
+    self.downloadTask = nil;
+  }
+
+  if ([downloadTask respondsToSelector:@selector(cancelByProducingResumeData:)]) {
+    [downloadTask cancelByProducingResumeData:completionHandler];
+  } else {
+    [downloadTask cancel];
+  }
+}
+
+- (BOOL)finishWithDownloadTask:(id<ASImageDownloadTask>)downloadTask
+{
+  MutexLocker l(__instanceLock__);
+  // Stopped downloads report their cancellation late, ignore them.
+  if (_invalid || _finished || downloadTask == nil || self.downloadTask != downloadTask) {
+    return NO;
+  }
+  self.downloadTask = nil;
+  _finished = YES;
+  return YES;
+}
+
 - (void)addCallbackData:(NSDictionary *)callbackData
 {
   MutexLocker l(__instanceLock__);
   [self.callbackDatas addObject:callbackData];
 }
 
+- (void)removeCallbackDataWithRequestID:(NSNumber *)requestID
+{
+  MutexLocker l(__instanceLock__);
+  NSIndexSet *indexes = [self.callbackDatas indexesOfObjectsPassingTest:^BOOL(NSDictionary *callbackData, NSUInteger idx, BOOL *stop) {
+    return [callbackData[kASBasicImageDownloaderContextRequestID] isEqualToNumber:requestID];
+  }];
+  [self.callbackDatas removeObjectsAtIndexes:indexes];
+}
+
 - (void)performProgressBlocks:(CGFloat)progress
 {
   MutexLocker l(__instanceLock__);
@@ -135,12 +190,43 @@ static NSMutableDictionary *currentRequests = nil;
   }
 }
 
-- (void)completeWithImage:(UIImage *)image error:(NSError *)error
+- (void)completeWithData:(NSData *)data error:(NSError *)error
 {
-  MutexLocker l(__instanceLock__);
-  for (NSDictionary *callbackData in self.callbackDatas) {
+  NSArray<NSDictionary *> *callbackDatas;
+  {
+    MutexLocker l(__instanceLock__);
+    callbackDatas = [self.callbackDatas copy];
+    [self.callbackDatas removeAllObjects];
+  }
+
+  // Decode once per variant, outside of the lock.
+  NSMutableDictionary<NSString *, UIImage *> *images = [[NSMutableDictionary alloc] init];
+  for (NSDictionary *callbackData in callbackDatas) {
     ASImageDownloaderCompletion completionBlock = callbackData[kASBasicImageDownloaderContextCompletionBlock];
     dispatch_queue_t callbackQueue = callbackData[kASBasicImageDownloaderContextCallbackQueue];
+    NSValue *targetPixelSizeValue = callbackData[kASBasicImageDownloaderContextTargetPixelSize];
+    CGSize targetPixelSize = targetPixelSizeValue ? targetPixelSizeValue.CGSizeValue : CGSizeZero;
+    UIViewContentMode contentMode = (UIViewContentMode)[callbackData[kASBasicImageDownloaderContextContentMode] integerValue];
+
+    UIImage *image = nil;
+    if (data != nil) {
+      NSString *variantKey = ASImageDecodedVariantKey(self.URL, targetPixelSize, contentMode);
+      // Content modes that don't scale, and requests without a size, use the full size image, which isn't cached.
+      const BOOL isDownsampled = targetPixelSizeValue != nil && ![variantKey isEqualToString:self.URL.absoluteString];
+      image = images[variantKey];
+      if (image == nil && isDownsampled) {
+        image = ASImageDecodeWithData(data, targetPixelSize, contentMode);
+        CGImageRef imageRef = image.CGImage;
+        if (imageRef != NULL) {
+          [self.class.decodedImageCache setObject:image forKey:variantKey cost:CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef)];
+        }
+      } else if (image == nil) {
+        image = [UIImage imageWithData:data];
+      }
+      if (image != nil) {
+        images[variantKey] = image;
+      }
+    }
 
     if (completionBlock) {
       dispatch_async(callbackQueue, ^{
@@ -148,73 +234,97 @@ static NSMutableDictionary *currentRequests = nil;
       });
     }
   }
-
-  self.sessionTask = nil;
-  [self.callbackDatas removeAllObjects];
 }
 
-- (NSURLSessionTask *)createSessionTaskIfNecessaryWithBlock:(NSURLSessionTask *(^)())creationBlock {
-  {
-    MutexLocker l(__instanceLock__);
+@end
 
-    if (self.isCancelled) {
-      return nil;
-    }
 
-    if (self.sessionTask && (self.sessionTask.state == NSURLSessionTaskStateRunning)) {
-      return nil;
-    }
-  }
+#pragma mark -
+/**
+ * The download identifier handed out for each download request. Requests for the same URL share a context and a
+ * download, so cancelling one request doesn't stop the download for the others.
+ */
+@interface ASBasicImageDownloadRequest : NSObject
 
-  NSURLSessionTask *newTask = creationBlock();
+- (instancetype)initWithURL:(NSURL *)URL requestID:(RequestID)requestID;
 
-  {
-    MutexLocker l(__instanceLock__);
+@property (nonatomic, readonly) NSURL *URL;
+@property (nonatomic, readonly) RequestID requestID;
 
-    if (self.isCancelled) {
-      return nil;
-    }
+@end
 
-    if (self.sessionTask && (self.sessionTask.state == NSURLSessionTaskStateRunning)) {
-      return nil;
-    }
+@implementation ASBasicImageDownloadRequest
 
-    self.sessionTask = newTask;
-    
-    return self.sessionTask;
+- (instancetype)initWithURL:(NSURL *)URL requestID:(RequestID)requestID
+{
+  if (self = [super init]) {
+    _URL = URL;
+    _requestID = requestID;
   }
+  return self;
 }
 
 @end
 
 
 #pragma mark -
+/**
+ * The blocks and bytes of a session task, until it completes.
+ */
+@interface ASBasicImageDownloaderTaskHandler : NSObject
+
+@property (nonatomic, readonly) ASImageDownloadTransportProgress progress;
+@property (nonatomic, readonly) ASImageDownloadTransportCompletion completion;
+@property (nonatomic) NSData *data;
+
+@end
+
+@implementation ASBasicImageDownloaderTaskHandler
+
+- (instancetype)initWithProgress:(ASImageDownloadTransportProgress)progress completion:(ASImageDownloadTransportCompletion)completion
+{
+  if (self = [super init]) {
+    _progress = [progress copy];
+    _completion = [completion copy];
+  }
+  return self;
+}
+
+@end
+
 /**
  * NSURLSessionDownloadTask lacks a `userInfo` property, so add this association ourselves.
  */
-@interface NSURLRequest (ASBasicImageDownloader)
-@property (nonatomic) ASBasicImageDownloaderContext *asyncdisplaykit_context;
+@interface NSURLSessionTask (ASBasicImageDownloader)
+@property (nonatomic, nullable) ASBasicImageDownloaderTaskHandler *asyncdisplaykit_handler;
 @end
 
-@implementation NSURLRequest (ASBasicImageDownloader)
+@implementation NSURLSessionTask (ASBasicImageDownloader)
 
-static const void *ContextKey() {
-  return @selector(asyncdisplaykit_context);
+static const void *HandlerKey() {
+  return @selector(asyncdisplaykit_handler);
 }
 
-- (void)setAsyncdisplaykit_context:(ASBasicImageDownloaderContext *)asyncdisplaykit_context
+- (void)setAsyncdisplaykit_handler:(ASBasicImageDownloaderTaskHandler *)asyncdisplaykit_handler
 {
-  objc_setAssociatedObject(self, ContextKey(), asyncdisplaykit_context, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+  objc_setAssociatedObject(self, HandlerKey(), asyncdisplaykit_handler, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
-- (ASBasicImageDownloader *)asyncdisplaykit_context
+- (ASBasicImageDownloaderTaskHandler *)asyncdisplaykit_handler
 {
-  return objc_getAssociatedObject(self, ContextKey());
+  return objc_getAssociatedObject(self, HandlerKey());
 }
 @end
 
+@interface NSURLSessionDownloadTask (ASImageDownloadTask) <ASImageDownloadTask>
+@end
 
-#pragma mark -
-@interface ASBasicImageDownloader () <NSURLSessionDownloadDelegate>
+@implementation NSURLSessionDownloadTask (ASImageDownloadTask)
+@end
+
+/**
+ * The default transport, backed by an NSURLSession.
+ */
+@interface ASBasicImageDownloaderSessionTransport : NSObject <ASImageDownloadTransport, NSURLSessionDownloadDelegate>
 {
   NSOperationQueue *_sessionDelegateQueue;
   NSURLSession *_session;
@@ -222,6 +332,82 @@ static const void *ContextKey() {
 
 @end
 
+@implementation ASBasicImageDownloaderSessionTransport
+
+- (instancetype)init
+{
+  if (!(self = [super init]))
+    return nil;
+
+  _sessionDelegateQueue = [[NSOperationQueue alloc] init];
+  _session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]
+                                           delegate:self
+                                      delegateQueue:_sessionDelegateQueue];
+
+  return self;
+}
+
+- (id<ASImageDownloadTask>)downloadTaskWithURL:(NSURL *)URL
+                                    resumeData:(NSData *)resumeData
+                                      progress:(ASImageDownloadTransportProgress)progress
+                                    completion:(ASImageDownloadTransportCompletion)completion
+{
+  NSURLSessionDownloadTask *task = resumeData ? [_session downloadTaskWithResumeData:resumeData] : [_session downloadTaskWithURL:URL];
+  task.asyncdisplaykit_handler = [[ASBasicImageDownloaderTaskHandler alloc] initWithProgress:progress completion:completion];
+  return task;
+}
+
+#pragma mark NSURLSessionDownloadDelegate.
+
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask
+                                           didWriteData:(int64_t)bytesWritten
+                                      totalBytesWritten:(int64_t)totalBytesWritten
+                              totalBytesExpectedToWrite:(int64_t)totalBytesExpectedToWrite
+{
+  downloadTask.asyncdisplaykit_handler.progress(totalBytesWritten, totalBytesExpectedToWrite);
+}
+
+// invoked if the download succeeded with no error
+- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask
+                              didFinishDownloadingToURL:(NSURL *)location
+{
+  // The file is gone once we return.
+  downloadTask.asyncdisplaykit_handler.data = [NSData dataWithContentsOfURL:location];
+}
+
+// invoked unconditionally
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task
+                           didCompleteWithError:(NSError *)error
+{
+  ASBasicImageDownloaderTaskHandler *handler = task.asyncdisplaykit_handler;
+  task.asyncdisplaykit_handler = nil;
+  if (handler) {
+    handler.completion(error ? nil : handler.data, error);
+  }
+}
+
+@end
+
+
+#pragma mark -
+@interface ASBasicImageDownloader ()
+{
+  id<ASImageDownloadTransport> _transport;
+  // Actions are performed on this serial queue, in the order the scheduler emitted them. NSURLSessionDownloadTask
+  // does file I/O to create a temp directory, which must not happen on the main thread.
+  dispatch_queue_t _transportQueue;
+  // What stopped downloads produced to resume them from, by URL.
+  NSCache<NSURL *, NSData *> *_resumeData;
+
+  AS::Mutex _lock;
+  // Only access these while locked.
+  std::unique_ptr<Scheduler> _scheduler;
+  // The context of each download the scheduler has, by absolute URL string.
+  NSMutableDictionary<NSString *, ASBasicImageDownloaderContext *> *_contexts;
+}
+
+@end
+
 @implementation ASBasicImageDownloader
 
 + (ASBasicImageDownloader *)sharedImageDownloader
@@ -229,26 +415,47 @@ static const void *ContextKey() {
   static ASBasicImageDownloader *sharedImageDownloader = nil;
   static dispatch_once_t once = 0;
   dispatch_once(&once, ^{
-    sharedImageDownloader = [[ASBasicImageDownloader alloc] _init];
+    sharedImageDownloader = [[ASBasicImageDownloader alloc] initWithTransport:[[ASBasicImageDownloaderSessionTransport alloc] init]
+                                                   maximumConcurrentDownloads:kASBasicImageDownloaderDefaultMaximumConcurrentDownloads];
   });
   return sharedImageDownloader;
 }
 
 #pragma mark Lifecycle.
 
-- (instancetype)_init
+- (instancetype)initWithTransport:(id<ASImageDownloadTransport>)transport maximumConcurrentDownloads:(NSUInteger)maximumConcurrentDownloads
 {
   if (!(self = [super init]))
     return nil;
 
-  _sessionDelegateQueue = [[NSOperationQueue alloc] init];
-  _session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]
-                                           delegate:self
-                                      delegateQueue:_sessionDelegateQueue];
+  _transport = transport;
+  _transportQueue = dispatch_queue_create("org.AsyncDisplayKit.ASBasicImageDownloader.transportQueue", DISPATCH_QUEUE_SERIAL);
+  _resumeData = [[NSCache alloc] init];
+  _scheduler.reset(new Scheduler(maximumConcurrentDownloads));
+  _contexts = [[NSMutableDictionary alloc] init];
 
   return self;
 }
 
+- (ASBasicImageDownloaderContext *)contextForURL:(NSURL *)URL
+{
+  MutexLocker l(_lock);
+  return [self _locked_contextForURL:URL];
+}
+
+- (ASBasicImageDownloaderContext *)_locked_contextForURL:(NSURL *)URL
+{
+  DISABLED_ASAssertLocked(_lock);
+
+  NSString *key = URL.absoluteString;
+  ASBasicImageDownloaderContext *context = _contexts[key];
+  if (context == nil || context.isCancelled) {
+    context = [[ASBasicImageDownloaderContext alloc] initWithURL:URL];
+    _contexts[key] = context;
+  }
+  return context;
+}
+
 
 #pragma mark ASImageDownloaderProtocol.
 
@@ -273,83 +480,220 @@ static const void *ContextKey() {
                    downloadProgress:(ASImageDownloaderProgress)downloadProgress
                          completion:(ASImageDownloaderCompletion)completion
 {
-  ASBasicImageDownloaderContext *context = [ASBasicImageDownloaderContext contextForURL:URL];
-
-  // NSURLSessionDownloadTask will do file I/O to create a temp directory. If called on the main thread this will
-  // cause significant performance issues.
-  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-    // associate metadata with it
-    const auto callbackData = [[NSMutableDictionary alloc] init];
-    callbackData[kASBasicImageDownloaderContextCallbackQueue] = callbackQueue ? : dispatch_get_main_queue();
+  return [self _downloadImageWithURL:URL
+                            priority:priority
+                     targetPixelSize:nil
+                         contentMode:UIViewContentModeScaleToFill
+                       callbackQueue:callbackQueue
+                    downloadProgress:downloadProgress
+                          completion:completion];
+}
 
-    if (downloadProgress) {
-      callbackData[kASBasicImageDownloaderContextProgressBlock] = [downloadProgress copy];
-    }
+- (nullable id)downloadImageWithURL:(NSURL *)URL
+                        shouldRetry:(BOOL)shouldRetry
+                           priority:(ASImageDownloaderPriority)priority
+                    targetPixelSize:(CGSize)targetPixelSize
+                        contentMode:(UIViewContentMode)contentMode
+                      callbackQueue:(dispatch_queue_t)callbackQueue
+                   downloadProgress:(ASImageDownloaderProgress)downloadProgress
+                         completion:(ASImageDownloaderCompletion)completion
+{
+  NSString *variantKey = ASImageDecodedVariantKey(URL, targetPixelSize, contentMode);
+  if ([variantKey isEqualToString:URL.absoluteString]) {
+    return [self downloadImageWithURL:URL
+                          shouldRetry:shouldRetry
+                             priority:priority
+                        callbackQueue:callbackQueue
+                     downloadProgress:downloadProgress
+                           completion:completion];
+  }
 
+  UIImage *decodedImage = [ASBasicImageDownloaderContext.decodedImageCache objectForKey:variantKey];
+  if (decodedImage != nil) {
     if (completion) {
-      callbackData[kASBasicImageDownloaderContextCompletionBlock] = [completion copy];
+      dispatch_async(callbackQueue ? : dispatch_get_main_queue(), ^{
+        completion(decodedImage, nil, nil, nil);
+      });
     }
+    return nil;
+  }
 
-    [context addCallbackData:[[NSDictionary alloc] initWithDictionary:callbackData]];
+  return [self _downloadImageWithURL:URL
+                            priority:priority
+                     targetPixelSize:[NSValue valueWithCGSize:targetPixelSize]
+                         contentMode:contentMode
+                       callbackQueue:callbackQueue
+                    downloadProgress:downloadProgress
+                          completion:completion];
+}
+
+/**
+ * @param targetPixelSize A CGSize to decode the image for, or nil to decode it at full size.
+ */
+- (nullable id)_downloadImageWithURL:(NSURL *)URL
+                            priority:(ASImageDownloaderPriority)priority
+                     targetPixelSize:(nullable NSValue *)targetPixelSize
+                         contentMode:(UIViewContentMode)contentMode
+                       callbackQueue:(dispatch_queue_t)callbackQueue
+                    downloadProgress:(ASImageDownloaderProgress)downloadProgress
+                          completion:(ASImageDownloaderCompletion)completion
+{
+  // associate metadata with it
+  const auto callbackData = [[NSMutableDictionary alloc] init];
+  callbackData[kASBasicImageDownloaderContextCallbackQueue] = callbackQueue ? : dispatch_get_main_queue();
 
-    // Create new task if necessary
-    NSURLSessionDownloadTask *task = (NSURLSessionDownloadTask *)[context createSessionTaskIfNecessaryWithBlock:^(){return [self->_session downloadTaskWithURL:URL];}];
+  if (downloadProgress) {
+    callbackData[kASBasicImageDownloaderContextProgressBlock] = [downloadProgress copy];
+  }
 
-    if (task) {
-      task.priority = NSURLSessionTaskPriorityWithImageDownloaderPriority(priority);
-      task.originalRequest.asyncdisplaykit_context = context;
+  if (completion) {
+    callbackData[kASBasicImageDownloaderContextCompletionBlock] = [completion copy];
+  }
 
-      // start downloading
-      [task resume];
-    }
-  });
+  if (targetPixelSize) {
+    callbackData[kASBasicImageDownloaderContextTargetPixelSize] = targetPixelSize;
+    callbackData[kASBasicImageDownloaderContextContentMode] = @(contentMode);
+  }
 
-  return context;
+  MutexLocker l(_lock);
+  ASBasicImageDownloaderContext *context = [self _locked_contextForURL:URL];
+  Actions actions;
+  const RequestID requestID = _scheduler->addRequest(URL.absoluteString.UTF8String,
+                                                     ASDownloadSchedulingPriorityWithImageDownloaderPriority(priority),
+                                                     actions);
+  callbackData[kASBasicImageDownloaderContextRequestID] = @(requestID);
+  [context addCallbackData:[[NSDictionary alloc] initWithDictionary:callbackData]];
+  [self _locked_performActions:actions];
+
+  return [[ASBasicImageDownloadRequest alloc] initWithURL:URL requestID:requestID];
 }
 
 - (void)cancelImageDownloadForIdentifier:(id)downloadIdentifier
 {
-  ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloaderContext.class], @"unexpected downloadIdentifier");
-  ASBasicImageDownloaderContext *context = (ASBasicImageDownloaderContext *)downloadIdentifier;
+  [self _removeRequest:downloadIdentifier keepPartialData:NO];
+}
 
-  [context cancel];
+- (void)cancelImageDownloadWithResumePossibilityForIdentifier:(id)downloadIdentifier
+{
+  [self _removeRequest:downloadIdentifier keepPartialData:YES];
 }
 
+- (void)setPriority:(ASImageDownloaderPriority)priority withDownloadIdentifier:(id)downloadIdentifier
+{
+  ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloadRequest.class], @"unexpected downloadIdentifier");
+  ASBasicImageDownloadRequest *request = (ASBasicImageDownloadRequest *)downloadIdentifier;
 
-#pragma mark NSURLSessionDownloadDelegate.
+  MutexLocker l(_lock);
+  Actions actions;
+  _scheduler->setPriority(request.requestID, ASDownloadSchedulingPriorityWithImageDownloaderPriority(priority), actions);
+  [self _locked_performActions:actions];
+}
 
-- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask
-                                           didWriteData:(int64_t)bytesWritten
-                                      totalBytesWritten:(int64_t)totalBytesWritten
-                              totalBytesExpectedToWrite:(int64_t)totalBytesExpectedToWrite
+- (void)_removeRequest:(id)downloadIdentifier keepPartialData:(BOOL)keepPartialData
 {
-  ASBasicImageDownloaderContext *context = downloadTask.originalRequest.asyncdisplaykit_context;
-  [context performProgressBlocks:(CGFloat)totalBytesWritten / (CGFloat)totalBytesExpectedToWrite];
+  ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloadRequest.class], @"unexpected downloadIdentifier");
+  ASBasicImageDownloadRequest *request = (ASBasicImageDownloadRequest *)downloadIdentifier;
+
+  MutexLocker l(_lock);
+  [_contexts[request.URL.absoluteString] removeCallbackDataWithRequestID:@(request.requestID)];
+  Actions actions;
+  _scheduler->removeRequest(request.requestID, keepPartialData, actions);
+  [self _locked_performActions:actions];
 }
 
-// invoked if the download succeeded with no error
-- (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask
-                              didFinishDownloadingToURL:(NSURL *)location
+
+#pragma mark Scheduling.
+
+- (void)_locked_performActions:(const Actions &)actions
 {
-  ASBasicImageDownloaderContext *context = downloadTask.originalRequest.asyncdisplaykit_context;
-  if ([context isCancelled]) {
-    return;
+  DISABLED_ASAssertLocked(_lock);
+
+  for (const Action &action : actions) {
+    NSString *key = [NSString stringWithUTF8String:action.key.c_str()];
+    ASBasicImageDownloaderContext *context = _contexts[key];
+    if (context == nil) {
+      ASDisplayNodeFailAssert(@"No context for scheduled download of %@", key);
+      continue;
+    }
+    // Abandoned downloads are done with their context. The next request for the URL gets a new one.
+    if (!_scheduler->hasDownload(action.key)) {
+      [_contexts removeObjectForKey:key];
+    }
+
+    const Action::Type type = action.type;
+    const float taskPriority = NSURLSessionTaskPriorityWithDownloadSchedulingPriority(action.priority);
+    dispatch_async(_transportQueue, ^{
+      switch (type) {
+        case Action::Type::Start:
+          [self _startDownloadWithContext:context priority:taskPriority];
+          break;
+        case Action::Type::Suspend:
+          [context suspendProducingResumeData:^(NSData *resumeData) {
+            if (resumeData) {
+              [self->_resumeData setObject:resumeData forKey:context.URL];
+            }
+          }];
+          break;
+        case Action::Type::Cancel:
+          [context cancel];
+          break;
+        case Action::Type::Reprioritize:
+          context.downloadTask.priority = taskPriority;
+          break;
+      }
+    });
   }
+}
 
-  if (context) {
-    UIImage *image = [UIImage imageWithData:[NSData dataWithContentsOfURL:location]];
-    [context completeWithImage:image error:nil];
+- (void)_startDownloadWithContext:(ASBasicImageDownloaderContext *)context priority:(float)priority
+{
+  NSURL *URL = context.URL;
+  NSData *resumeData = [_resumeData objectForKey:URL];
+  if (resumeData) {
+    [_resumeData removeObjectForKey:URL];
+  }
+
+  // The transport may keep the blocks around, so they don't retain anything. A task is only current while its
+  // context holds it, so the weak reference tells whether a callback is still wanted.
+  __weak __typeof__(self) weakSelf = self;
+  __weak ASBasicImageDownloaderContext *weakContext = context;
+  __block __weak id<ASImageDownloadTask> weakTask = nil;
+  id<ASImageDownloadTask> task = [_transport downloadTaskWithURL:URL resumeData:resumeData progress:^(int64_t bytesReceived, int64_t bytesExpected) {
+    ASBasicImageDownloaderContext *strongContext = weakContext;
+    if (bytesExpected > 0 && strongContext.downloadTask == weakTask) {
+      [strongContext performProgressBlocks:(CGFloat)bytesReceived / (CGFloat)bytesExpected];
+    }
+  } completion:^(NSData *data, NSError *error) {
+    [weakSelf _finishDownloadWithContext:weakContext task:weakTask data:data error:error];
+  }];
+  weakTask = task;
+  task.priority = priority;
+
+  if ([context startWithDownloadTask:task]) {
+    [task resume];
+  } else {
+    [task cancel];
   }
 }
 
-// invoked unconditionally
-- (void)URLSession:(NSURLSession *)session task:(NSURLSessionDownloadTask *)task
-                           didCompleteWithError:(NSError *)error
+- (void)_finishDownloadWithContext:(ASBasicImageDownloaderContext *)context task:(id<ASImageDownloadTask>)task data:(NSData *)data error:(NSError *)error
 {
-  ASBasicImageDownloaderContext *context = task.originalRequest.asyncdisplaykit_context;
-  if (context && error) {
-    [context completeWithImage:nil error:error];
+  if (![context finishWithDownloadTask:task]) {
+    return;
+  }
+
+  {
+    MutexLocker l(_lock);
+    NSString *key = context.URL.absoluteString;
+    Actions actions;
+    _scheduler->finishDownload(key.UTF8String, actions);
+    if (_contexts[key] == context) {
+      [_contexts removeObjectForKey:key];
+    }
+    [self _locked_performActions:actions];
   }
+
+  [context completeWithData:data error:error];
 }
 
 @end
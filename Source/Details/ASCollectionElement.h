@@ -42,6 +42,13 @@ AS_SUBCLASSING_RESTRICTED
  */
 @property (nullable, readonly) ASCellNode *nodeIfAllocated;
 
+/**
+ * Whether the element stands in for an item that its element map hasn't materialized yet, see
+ * -[ASElementMap elementForItemAtIndexPath:]. The constrained size of a placeholder is the estimated size of the item,
+ * and its node is an empty cell node. Placeholders for the same item of the same map are equal.
+ */
+@property (readonly) BOOL isPlaceholder;
+
 @end
 
 NS_ASSUME_NONNULL_END
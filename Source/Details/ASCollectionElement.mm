@@ -9,6 +9,8 @@
 
 #import <AsyncDisplayKit/ASCollectionElement.h>
 #import <AsyncDisplayKit/ASCellNode+Internal.h>
+#import <AsyncDisplayKit/ASElementMapStorage.h>
+#import <AsyncDisplayKit/ASHashing.h>
 #import <AsyncDisplayKit/ASThread.h>
 
 @interface ASCollectionElement ()
@@ -21,6 +23,11 @@
 @implementation ASCollectionElement {
   AS::Mutex _lock;
   ASCellNode *_node;
+
+  // Placeholders only. The identifier of the map is never 0.
+  uint64_t _placeholderMapIdentifier;
+  NSInteger _placeholderSection;
+  NSInteger _placeholderItem;
 }
 
 - (instancetype)initWithNodeModel:(id)nodeModel
@@ -43,9 +50,68 @@
   return self;
 }
 
+- (instancetype)initPlaceholderWithConstrainedSize:(ASSizeRange)constrainedSize
+                                     mapIdentifier:(uint64_t)mapIdentifier
+                                           section:(NSInteger)section
+                                              item:(NSInteger)item
+{
+  self = [super init];
+  if (self) {
+    _constrainedSize = constrainedSize;
+    _traitCollection = ASPrimitiveTraitCollectionMakeDefault();
+    _placeholderMapIdentifier = mapIdentifier;
+    _placeholderSection = section;
+    _placeholderItem = item;
+  }
+  return self;
+}
+
+- (BOOL)isPlaceholder
+{
+  return _placeholderMapIdentifier != 0;
+}
+
+- (BOOL)isPlaceholderInMapWithIdentifier:(uint64_t)mapIdentifier section:(out NSInteger *)section item:(out NSInteger *)item
+{
+  if (_placeholderMapIdentifier == 0 || _placeholderMapIdentifier != mapIdentifier) {
+    return NO;
+  }
+  *section = _placeholderSection;
+  *item = _placeholderItem;
+  return YES;
+}
+
+- (BOOL)isEqual:(id)object
+{
+  if (self == object) {
+    return YES;
+  }
+  if (_placeholderMapIdentifier == 0) {
+    return NO;
+  }
+  ASCollectionElement *other = ASDynamicCast(object, ASCollectionElement);
+  return other != nil && other->_placeholderMapIdentifier == _placeholderMapIdentifier
+      && other->_placeholderSection == _placeholderSection && other->_placeholderItem == _placeholderItem;
+}
+
+- (NSUInteger)hash
+{
+  if (_placeholderMapIdentifier == 0) {
+    return [super hash];
+  }
+  return AS::hashFields(_placeholderMapIdentifier, _placeholderSection, _placeholderItem);
+}
+
 - (ASCellNode *)node
 {
   AS::MutexLocker l(_lock);
+  if (_node == nil && _placeholderMapIdentifier != 0) {
+    // Nothing should display a placeholder, but give callers that need a node one of the estimated size.
+    ASCellNode *node = [[ASCellNode alloc] init];
+    node.style.preferredSize = _constrainedSize.max;
+    node.collectionElement = self;
+    _node = node;
+  }
   if (_nodeBlock != nil) {
     ASCellNode *node = _nodeBlock();
     _nodeBlock = nil;
@@ -83,20 +83,7 @@
 
 - (NSUInteger)hash
 {
-  struct {
-    CGSize viewportSize;
-    ASScrollDirection scrollableDirections;
-    NSUInteger elementsHash;
-    NSUInteger layoutDelegateClassHash;
-    NSUInteger additionalInfoHash;
-  } data = {
-    _viewportSize,
-    _scrollableDirections,
-    _elements.hash,
-    _layoutDelegateClass.hash,
-    [_additionalInfo hash]
-  };
-  return ASHashBytes(&data, sizeof(data));
+  return AS::hashFields(_viewportSize, _scrollableDirections, _elements.hash, _layoutDelegateClass.hash, [_additionalInfo hash]);
 }
 
 @end
@@ -15,10 +15,11 @@
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
-#import <AsyncDisplayKit/ASPageTable.h>
+#import <AsyncDisplayKit/ASRectIndex.h>
 #import <AsyncDisplayKit/ASThread.h>
 
 #import <queue>
+#import <vector>
 
 @implementation NSMapTable (ASCollectionLayoutConvenience)
 
@@ -29,13 +30,36 @@
 
 @end
 
+static AS::RectIndex ASRectIndexMake(const std::vector<UICollectionViewLayoutAttributes *> &attributes)
+{
+  std::vector<AS::RectIndex::Rect> rects;
+  rects.reserve(attributes.size());
+  for (UICollectionViewLayoutAttributes *attrs : attributes) {
+    CGRect frame = attrs.frame;
+    rects.push_back({CGRectGetMinX(frame), CGRectGetMinY(frame), CGRectGetMaxX(frame), CGRectGetMaxY(frame)});
+  }
+  return AS::RectIndex(rects.data(), rects.size());
+}
+
+static AS::RectIndex::Rect ASRectIndexRectMake(CGRect rect)
+{
+  return {CGRectGetMinX(rect), CGRectGetMinY(rect), CGRectGetMaxX(rect), CGRectGetMaxY(rect)};
+}
+
 @implementation ASCollectionLayoutState {
   AS::Mutex __instanceLock__;
   CGSize _contentSize;
   ASCollectionLayoutContext *_context;
   NSMapTable<ASCollectionElement *, UICollectionViewLayoutAttributes *> *_elementToLayoutAttributesTable;
-  ASPageToLayoutAttributesTable *_pageToLayoutAttributesTable;
-  ASPageToLayoutAttributesTable *_unmeasuredPageToLayoutAttributesTable;
+
+  // All layout attributes, in the order _rectIndex refers to them.
+  std::vector<UICollectionViewLayoutAttributes *> _layoutAttributes;
+  AS::RectIndex _rectIndex;
+
+  // The layout attributes of unmeasured elements, each set to nil once it was returned. Guarded by __instanceLock__.
+  std::vector<UICollectionViewLayoutAttributes *> _unmeasuredLayoutAttributes;
+  AS::RectIndex _unmeasuredRectIndex;
+  NSUInteger _unmeasuredCount;
 }
 
 - (instancetype)initWithContext:(ASCollectionLayoutContext *)context
@@ -104,9 +128,19 @@ elementToLayoutAttributesTable:[NSMapTable elementToLayoutAttributesTable]];
     _context = context;
     _contentSize = contentSize;
     _elementToLayoutAttributesTable = [table copy]; // Copy the given table to make sure clients can't mutate it after this point.
-    CGSize pageSize = context.viewportSize;
-    _pageToLayoutAttributesTable = [ASPageTable pageTableWithLayoutAttributes:table.objectEnumerator contentSize:contentSize pageSize:pageSize];
-    _unmeasuredPageToLayoutAttributesTable = [ASCollectionLayoutState _unmeasuredLayoutAttributesTableFromTable:table contentSize:contentSize pageSize:pageSize];
+
+    // Index the frames once, on the layout thread, so that rect queries don't have to allocate or look at elements
+    // outside of the rect.
+    for (ASCollectionElement *element in _elementToLayoutAttributesTable) {
+      UICollectionViewLayoutAttributes *attrs = [_elementToLayoutAttributesTable objectForKey:element];
+      _layoutAttributes.push_back(attrs);
+      if (element.nodeIfAllocated == nil || CGSizeEqualToSize(element.nodeIfAllocated.calculatedSize, attrs.frame.size) == NO) {
+        _unmeasuredLayoutAttributes.push_back(attrs);
+      }
+    }
+    _rectIndex = ASRectIndexMake(_layoutAttributes);
+    _unmeasuredRectIndex = ASRectIndexMake(_unmeasuredLayoutAttributes);
+    _unmeasuredCount = _unmeasuredLayoutAttributes.size();
   }
   return self;
 }
@@ -146,108 +180,38 @@ elementToLayoutAttributesTable:[NSMapTable elementToLayoutAttributesTable]];
 
 - (NSArray<UICollectionViewLayoutAttributes *> *)layoutAttributesForElementsInRect:(CGRect)rect
 {
-  CGSize pageSize = _context.viewportSize;
-  NSPointerArray *pages = ASPageCoordinatesForPagesThatIntersectRect(rect, _contentSize, pageSize);
-  if (pages.count == 0) {
+  if (CGRectIsNull(rect) || _layoutAttributes.empty()) {
     return @[];
   }
 
-  // Use a set here because some items may span multiple pages
-  const auto result = [[NSMutableSet<UICollectionViewLayoutAttributes *> alloc] init];
-  for (id pagePtr in pages) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSArray<UICollectionViewLayoutAttributes *> *allAttrs = [_pageToLayoutAttributesTable objectForPage:page];
-    if (allAttrs.count > 0) {
-      CGRect pageRect = ASPageCoordinateGetPageRect(page, pageSize);
-
-      if (CGRectContainsRect(rect, pageRect)) {
-        [result addObjectsFromArray:allAttrs];
-      } else {
-        for (UICollectionViewLayoutAttributes *attrs in allAttrs) {
-          if (CGRectIntersectsRect(rect, attrs.frame)) {
-            [result addObject:attrs];
-          }
-        }
-      }
-    }
-  }
-
-  return [result allObjects];
+  NSMutableArray<UICollectionViewLayoutAttributes *> *result = [[NSMutableArray alloc] init];
+  _rectIndex.query(ASRectIndexRectMake(rect), [&](size_t i) {
+    [result addObject:_layoutAttributes[i]];
+  });
+  return result;
 }
 
-- (ASPageToLayoutAttributesTable *)getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:(CGRect)rect
+- (NSArray<UICollectionViewLayoutAttributes *> *)getAndRemoveUnmeasuredLayoutAttributesInRect:(CGRect)rect
 {
-  CGSize pageSize = _context.viewportSize;
-  CGSize contentSize = _contentSize;
-
   AS::MutexLocker l(__instanceLock__);
-  if (_unmeasuredPageToLayoutAttributesTable.count == 0 || CGRectIsNull(rect) || CGRectIsEmpty(rect) || CGSizeEqualToSize(CGSizeZero, contentSize) || CGSizeEqualToSize(CGSizeZero, pageSize)) {
+  if (_unmeasuredCount == 0 || CGRectIsNull(rect) || CGRectIsEmpty(rect)) {
     return nil;
   }
 
-  // Step 1: Determine all the pages that intersect the specified rect
-  NSPointerArray *pagesInRect = ASPageCoordinatesForPagesThatIntersectRect(rect, contentSize, pageSize);
-  if (pagesInRect.count == 0) {
-    return nil;
-  }
-
-  // Step 2: Filter out attributes in these pages that intersect the specified rect.
-  ASPageToLayoutAttributesTable *result = nil;
-  for (id pagePtr in pagesInRect) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSMutableArray *attrsInPage = [_unmeasuredPageToLayoutAttributesTable objectForPage:page];
-    if (attrsInPage.count == 0) {
-      continue;
-    }
-
-    NSMutableArray *intersectingAttrsInPage = nil;
-    CGRect pageRect = ASPageCoordinateGetPageRect(page, pageSize);
-    if (CGRectContainsRect(rect, pageRect)) {
-      // This page fits well within the specified rect. Simply return all of its attributes.
-      intersectingAttrsInPage = attrsInPage;
-    } else {
-      // The page intersects the specified rect. Some attributes in this page are returned, some are not.
-      for (UICollectionViewLayoutAttributes *attrs in attrsInPage) {
-        if (CGRectIntersectsRect(rect, attrs.frame)) {
-          if (intersectingAttrsInPage == nil) {
-            intersectingAttrsInPage = [[NSMutableArray alloc] init];
-          }
-          [intersectingAttrsInPage addObject:attrs];
-        }
-      }
+  NSMutableArray<UICollectionViewLayoutAttributes *> *result = nil;
+  _unmeasuredRectIndex.query(ASRectIndexRectMake(rect), [&](size_t i) {
+    UICollectionViewLayoutAttributes *attrs = _unmeasuredLayoutAttributes[i];
+    if (attrs == nil) {
+      return;
     }
-
-    if (intersectingAttrsInPage.count > 0) {
-      if (attrsInPage.count == intersectingAttrsInPage.count) {
-        [_unmeasuredPageToLayoutAttributesTable removeObjectForPage:page];
-      } else {
-        [attrsInPage removeObjectsInArray:intersectingAttrsInPage];
-      }
-      if (result == nil) {
-        result = [ASPageTable pageTableForStrongObjectPointers];
-      }
-      [result setObject:intersectingAttrsInPage forPage:page];
+    if (result == nil) {
+      result = [[NSMutableArray alloc] init];
     }
-  }
-
+    [result addObject:attrs];
+    _unmeasuredLayoutAttributes[i] = nil;
+    _unmeasuredCount--;
+  });
   return result;
 }
 
-#pragma mark - Private methods
-
-+ (ASPageToLayoutAttributesTable *)_unmeasuredLayoutAttributesTableFromTable:(NSMapTable<ASCollectionElement *, UICollectionViewLayoutAttributes *> *)table
-                                                                 contentSize:(CGSize)contentSize
-                                                                    pageSize:(CGSize)pageSize
-{
-  NSMutableArray<UICollectionViewLayoutAttributes *> *unmeasuredAttrs = [[NSMutableArray alloc] init];
-  for (ASCollectionElement *element in table) {
-    UICollectionViewLayoutAttributes *attrs = [table objectForKey:element];
-    if (element.nodeIfAllocated == nil || CGSizeEqualToSize(element.nodeIfAllocated.calculatedSize, attrs.frame.size) == NO) {
-      [unmeasuredAttrs addObject:attrs];
-    }
-  }
-
-  return [ASPageTable pageTableWithLayoutAttributes:unmeasuredAttrs contentSize:contentSize pageSize:pageSize];
-}
-
 @end
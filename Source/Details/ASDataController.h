@@ -97,6 +97,24 @@ ASDK_EXTERN NSString * const ASCollectionInvalidUpdateException;
 
 - (nullable id<ASSectionContext>)dataController:(ASDataController *)dataController contextForSection:(NSInteger)section;
 
+/**
+ * The index paths of the items on screen. With exp_pipelined_cell_allocation, the cells nearest to them are
+ * allocated and laid out first.
+ */
+- (NSArray<NSIndexPath *> *)visibleIndexPathsForDataController:(ASDataController *)dataController;
+
+/**
+ * Called on the main thread when a background chunk of an incremental relayout (exp_incremental_relayout) changed
+ * the size of some nodes. Their sizes should be requeried in one update.
+ */
+- (void)dataController:(ASDataController *)dataController didRelayoutNodes:(NSArray<ASCellNode *> *)nodesSizeChanged;
+
+/**
+ * The estimated size of the items in the section. With exp_windowed_reload, a reload only materializes the items
+ * around the visible ones in sections with a non-zero estimate, see -materializeItemsAtIndexPaths:completion:.
+ */
+- (CGSize)dataController:(ASDataController *)dataController estimatedSizeForItemsInSection:(NSInteger)section;
+
 @end
 
 /**
@@ -224,6 +242,21 @@ ASDK_EXTERN NSString * const ASCollectionInvalidUpdateException;
 
 - (void)updateWithChangeSet:(_ASHierarchyChangeSet *)changeSet;
 
+/**
+ * Materializes the placeholders at the given index paths of the visible map in the background. Once they are in
+ * the visible map, nodes whose size doesn't match the estimate are passed to -dataController:didRelayoutNodes: and
+ * the completion is called on the main thread.
+ *
+ * Does nothing while an update or another materialization is in flight, the caller should ask again afterwards.
+ */
+- (void)materializeItemsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths completion:(nullable void (^)(void))completion;
+
+/**
+ * Returns the item element of the visible map at the index path. A placeholder is materialized on the main thread
+ * first, unless the item is gone from the data source.
+ */
+- (nullable ASCollectionElement *)materializedElementForItemAtIndexPath:(NSIndexPath *)indexPath;
+
 /**
  * Re-measures all loaded nodes in the backing store.
  * 
@@ -232,6 +265,9 @@ ASDK_EXTERN NSString * const ASCollectionInvalidUpdateException;
  *
  * The invalidationBlock is called after flushing the ASMainSerialQueue, which ensures that any in-progress
  * layout calculations have been applied. The block will not be called if data hasn't been loaded.
+ *
+ * With exp_incremental_relayout, only the nodes in the display range are re-measured right away. The other nodes keep
+ * their current size until they are re-measured in background chunks, see -dataController:didRelayoutNodes:.
  */
 - (void)relayoutAllNodesWithInvalidationBlock:(nullable void (^)(void))invalidationBlock;
 
@@ -30,6 +30,11 @@
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
 
+#import <algorithm>
+#import <atomic>
+#import <memory>
+#import <vector>
+
 //#define LOG(...) NSLog(__VA_ARGS__)
 #define LOG(...)
 
@@ -43,6 +48,24 @@ typedef dispatch_block_t ASDataControllerCompletionBlock;
 
 typedef void (^ASDataControllerSynchronizationBlock)();
 
+/// The number of offscreen nodes that an incremental relayout measures before it hands their new sizes to the view.
+static const NSUInteger kASDataControllerRelayoutChunkSize = 64;
+
+/// An element whose node is remeasured with a new constrained size.
+struct ASDataControllerRelayout {
+  ASCollectionElement *element;
+  ASSizeRange constrainedSize;
+};
+
+/// The number of items before the first and after the last visible item that a windowed reload materializes.
+static const NSInteger kASDataControllerMaterializationWindow = 64;
+
+/// An element that was materialized in the visible map while updates were in flight, see -materializedElementForItemAtIndexPath:.
+struct ASDataControllerMaterialization {
+  ASCollectionElement *element;
+  NSIndexPath *indexPath;
+};
+
 @interface ASDataController () {
   id<ASDataControllerLayoutDelegate> _layoutDelegate;
 
@@ -62,6 +85,13 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   BOOL _synchronized;
   NSMutableSet<ASDataControllerSynchronizationBlock> *_onDidFinishSynchronizingBlocks;
 
+  NSUInteger _relayoutGeneration;             // Main thread only. Stale relayout chunks of older generations are dropped.
+
+  NSMutableArray<_ASHierarchyChangeSet *> *_changeSetsInFlight;   // Main thread only. Not in the visible map yet, oldest first.
+  NSUInteger _materializationGeneration;      // Main thread only. Bumped by updates, which drop background materializations.
+  BOOL _materializing;                        // Main thread only.
+  std::vector<ASDataControllerMaterialization> _carriedMaterializations;   // Main thread only. In visible map coordinates.
+
   struct {
     unsigned int supplementaryNodeKindsInSections:1;
     unsigned int supplementaryNodesOfKindInSection:1;
@@ -69,6 +99,8 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     unsigned int constrainedSizeForNodeAtIndexPath:1;
     unsigned int constrainedSizeForSupplementaryNodeOfKindAtIndexPath:1;
     unsigned int contextForSection:1;
+    unsigned int didRelayoutNodes:1;
+    unsigned int estimatedSizeForItemsInSection:1;
   } _dataSourceFlags;
 }
 
@@ -95,6 +127,8 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   _dataSourceFlags.constrainedSizeForNodeAtIndexPath = [_dataSource respondsToSelector:@selector(dataController:constrainedSizeForNodeAtIndexPath:)];
   _dataSourceFlags.constrainedSizeForSupplementaryNodeOfKindAtIndexPath = [_dataSource respondsToSelector:@selector(dataController:constrainedSizeForSupplementaryNodeOfKind:atIndexPath:)];
   _dataSourceFlags.contextForSection = [_dataSource respondsToSelector:@selector(dataController:contextForSection:)];
+  _dataSourceFlags.didRelayoutNodes = [_dataSource respondsToSelector:@selector(dataController:didRelayoutNodes:)];
+  _dataSourceFlags.estimatedSizeForItemsInSection = [_dataSource respondsToSelector:@selector(dataController:estimatedSizeForItemsInSection:)];
 
   self.visibleMap = self.pendingMap = [[ASElementMap alloc] init];
   
@@ -104,6 +138,8 @@ typedef void (^ASDataControllerSynchronizationBlock)();
 
   _synchronized = YES;
   _onDidFinishSynchronizingBlocks = [[NSMutableSet alloc] init];
+
+  _changeSetsInFlight = [[NSMutableArray alloc] init];
   
   const char *queueName = [[NSString stringWithFormat:@"org.AsyncDisplayKit.ASDataController.editingTransactionQueue:%p", self] cStringUsingEncoding:NSASCIIStringEncoding];
   _editingTransactionQueue = dispatch_queue_create(queueName, DISPATCH_QUEUE_SERIAL);
@@ -129,6 +165,66 @@ typedef void (^ASDataControllerSynchronizationBlock)();
 
 #pragma mark - Cell Layout
 
+/**
+ * Returns how many items away from the viewport each element is, 0 for the visible ones. Positions count items across
+ * sections, and a supplementary element takes the position of the item at its index path. Visible index paths must be
+ * in the coordinates of the map. Without visible index paths, e.g. on the first load, the first position counts as
+ * visible.
+ */
+static std::vector<NSUInteger> ASDistancesFromViewport(NSArray<ASCollectionElement *> *elements, ASElementMap *map, NSArray<NSIndexPath *> *visibleIndexPaths, NSUInteger *outViewportLength)
+{
+  const NSInteger sectionCount = map.numberOfSections;
+  std::vector<NSUInteger> sectionOffsets(sectionCount + 1, 0);
+  for (NSInteger section = 0; section < sectionCount; section++) {
+    sectionOffsets[section + 1] = sectionOffsets[section] + [map numberOfItemsInSection:section];
+  }
+  const auto position = [&](NSIndexPath *indexPath) -> NSUInteger {
+    if (indexPath == nil || sectionCount == 0) {
+      return 0;
+    }
+    const NSInteger section = MIN(MAX(indexPath.section, 0), sectionCount - 1);
+    return sectionOffsets[section] + (NSUInteger)MAX(indexPath.item, 0);
+  };
+
+  NSUInteger first = NSUIntegerMax;
+  NSUInteger last = 0;
+  for (NSIndexPath *indexPath in visibleIndexPaths) {
+    const NSUInteger p = position(indexPath);
+    first = MIN(first, p);
+    last = MAX(last, p);
+  }
+  if (first == NSUIntegerMax) {
+    first = 0;
+  }
+  *outViewportLength = last - first + 1;
+
+  std::vector<NSUInteger> distances;
+  distances.reserve(elements.count);
+  for (ASCollectionElement *element in elements) {
+    const NSUInteger p = position([map indexPathForElement:element]);
+    distances.push_back(p < first ? first - p : (p > last ? p - last : 0));
+  }
+  return distances;
+}
+
+/**
+ * Allocates the node of the element, and lays it out if its size range is valid.
+ */
+- (void)_allocateNodeFromElement:(ASCollectionElement *)element
+{
+  NSMutableDictionary *dict = [[NSThread currentThread] threadDictionary];
+  dict[ASThreadDictMaxConstraintSizeKey] =
+      [NSValue valueWithCGSize:element.constrainedSize.max];
+  unowned ASCellNode *node = element.node;
+  [dict removeObjectForKey:ASThreadDictMaxConstraintSizeKey];
+
+  // Layout the node if the size range is valid.
+  ASSizeRange sizeRange = element.constrainedSize;
+  if (ASSizeRangeHasSignificantArea(sizeRange)) {
+    [self _layoutNode:node withConstrainedSize:sizeRange];
+  }
+}
+
 /**
  * Allocates and layouts nodes from the given collection elements, and blocks the current thread while doing so.
  *
@@ -157,21 +253,88 @@ typedef void (^ASDataControllerSynchronizationBlock)();
         return;
       }
 
-      unowned ASCollectionElement *element = elements[i];
+      [self _allocateNodeFromElement:elements[i]];
+    };
+    
+    if (strictlyOnCurrentThread) {
+      for (NSUInteger i = 0; i < nodeCount; i++) {
+        work(i);
+      }
+    } else {
+      dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+      NSUInteger threadCount = 0;
+      if ([_dataSource dataControllerShouldSerializeNodeCreation:self]) {
+        threadCount = 1;
+      }
+      ASDispatchApply(nodeCount, queue, threadCount, work);
+    }
+  }
 
-      NSMutableDictionary *dict = [[NSThread currentThread] threadDictionary];
-      dict[ASThreadDictMaxConstraintSizeKey] =
-          [NSValue valueWithCGSize:element.constrainedSize.max];
-      unowned ASCellNode *node = element.node;
-      [dict removeObjectForKey:ASThreadDictMaxConstraintSizeKey];
+  ASSignpostEnd(DataControllerBatch, self, "count: %lu", (unsigned long)nodeCount);
+}
 
-      // Layout the node if the size range is valid.
-      ASSizeRange sizeRange = element.constrainedSize;
-      if (ASSizeRangeHasSignificantArea(sizeRange)) {
-        [self _layoutNode:node withConstrainedSize:sizeRange];
+/**
+ * Like -_allocateNodesFromElements:strictlyOnCurrentThread:, but starts with the elements nearest to the viewport.
+ *
+ * The update still waits for every element, because UICollectionViewFlowLayout and UITableView ask for the size of
+ * every item when it is applied. What changes is that the visible cells are ready first, which the
+ * DataControllerVisibleCells signpost measures. Batches far from the viewport keep user initiated QoS: the main thread
+ * may wait for any of them later, e.g. in -[ASCollectionView layoutSubviews], and wouldn't boost them.
+ *
+ * @param map The map the elements are in.
+ * @param visibleIndexPaths The index paths the collection shows, in the coordinates of the map.
+ */
+- (void)_allocateNodesNearestViewportFirstFromElements:(NSArray<ASCollectionElement *> *)elements
+                                                 inMap:(ASElementMap *)map
+                                     visibleIndexPaths:(NSArray<NSIndexPath *> *)visibleIndexPaths
+                               strictlyOnCurrentThread:(BOOL)strictlyOnCurrentThread
+{
+  const NSUInteger nodeCount = elements.count;
+  __weak id<ASDataControllerSource> weakDataSource = _dataSource;
+  if (nodeCount == 0 || weakDataSource == nil) {
+    return;
+  }
+
+  ASSignpostStart(DataControllerBatch, self, "%@", ASObjectDescriptionMakeTiny(weakDataSource));
+  ASSignpostStart(DataControllerVisibleCells, self, "%@", ASObjectDescriptionMakeTiny(weakDataSource));
+
+  // Dispatch apply hands out iterations in order, so sorting is enough for the workers to take the nearest first.
+  NSUInteger viewportLength = 0;
+  const std::vector<NSUInteger> distances = ASDistancesFromViewport(elements, map, visibleIndexPaths, &viewportLength);
+  std::vector<NSUInteger> order(nodeCount);
+  for (NSUInteger i = 0; i < nodeCount; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&distances](NSUInteger a, NSUInteger b) {
+    return distances[a] < distances[b];
+  });
+  const NSUInteger visibleCount = std::count(distances.begin(), distances.end(), 0);
+
+  {
+    as_activity_create_for_scope("Data controller batch");
+
+    std::atomic<NSUInteger> remainingVisibleCount(visibleCount);
+    std::atomic<NSUInteger> *remainingVisibleCountPtr = &remainingVisibleCount;
+    if (visibleCount == 0) {
+      ASSignpostEnd(DataControllerVisibleCells, self, "count: 0");
+      ASSignpostStart(DataControllerOffscreenCells, self, "%@", ASObjectDescriptionMakeTiny(weakDataSource));
+    }
+    const NSUInteger *orderPtr = order.data();
+    const NSUInteger *distancesPtr = distances.data();
+    void(^work)(size_t) = ^(size_t i) {
+      __strong id<ASDataControllerSource> strongDataSource = weakDataSource;
+      if (strongDataSource == nil) {
+        return;
+      }
+
+      const NSUInteger index = orderPtr[i];
+      [self _allocateNodeFromElement:elements[index]];
+      if (distancesPtr[index] == 0 && remainingVisibleCountPtr->fetch_sub(1) == 1) {
+        ASSignpostEnd(DataControllerVisibleCells, self, "count: %lu", (unsigned long)visibleCount);
+        ASSignpostStart(DataControllerOffscreenCells, self, "%@", ASObjectDescriptionMakeTiny(strongDataSource));
       }
     };
-    
+
     if (strictlyOnCurrentThread) {
       for (NSUInteger i = 0; i < nodeCount; i++) {
         work(i);
@@ -186,6 +349,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     }
   }
 
+  ASSignpostEnd(DataControllerOffscreenCells, self, "count: %lu", (unsigned long)(nodeCount - visibleCount));
   ASSignpostEnd(DataControllerBatch, self, "count: %lu", (unsigned long)nodeCount);
 }
 
@@ -383,50 +547,73 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   }
   
   LOG(@"Populating elements of kind: %@, for index paths: %@", kind, indexPaths);
-  id<ASDataControllerSource> dataSource = self.dataSource;
-  id<ASRangeManagingNode> node = self.node;
   BOOL shouldAsyncLayout = YES;
   for (NSIndexPath *indexPath in indexPaths) {
-    ASCellNodeBlock nodeBlock;
-    id nodeModel;
-    if (isRowKind) {
-      nodeModel = [dataSource dataController:self nodeModelForItemAtIndexPath:indexPath];
-      
-      // Get the prior element and attempt to update the existing cell node.
-      if (nodeModel != nil && !changeSet.includesReloadData) {
-        NSIndexPath *oldIndexPath = [changeSet oldIndexPathForNewIndexPath:indexPath];
-        if (oldIndexPath != nil) {
-          ASCollectionElement *oldElement = [previousMap elementForItemAtIndexPath:oldIndexPath];
-          ASCellNode *oldNode = oldElement.node;
-          if ([oldNode canUpdateToNodeModel:nodeModel]) {
-            // Just wrap the node in a block. The collection element will -setNodeModel:
-            nodeBlock = ^{
-              return oldNode;
-            };
-          }
+    ASCollectionElement *element = [self _elementOfKind:kind
+                                            atIndexPath:indexPath
+                                        traitCollection:traitCollection
+                                  shouldFetchSizeRanges:shouldFetchSizeRanges
+                                              changeSet:changeSet
+                                            previousMap:previousMap
+                                      shouldAsyncLayout:&shouldAsyncLayout];
+    [map insertElement:element atIndexPath:indexPath];
+    changeSet.countForAsyncLayout += (shouldAsyncLayout ? 1 : 0);
+  }
+}
+
+/**
+ * Returns a new element of a certain kind at an index path in the data source index space.
+ *
+ * @param changeSet The change set the element is created for, if any. Nodes of elements it moves are reused when possible.
+ * @param shouldAsyncLayout Passed on to the data source, which sets it to NO if the node should be laid out synchronously.
+ */
+- (ASCollectionElement *)_elementOfKind:(NSString *)kind
+                            atIndexPath:(NSIndexPath *)indexPath
+                        traitCollection:(ASPrimitiveTraitCollection)traitCollection
+                  shouldFetchSizeRanges:(BOOL)shouldFetchSizeRanges
+                              changeSet:(_ASHierarchyChangeSet *)changeSet
+                            previousMap:(ASElementMap *)previousMap
+                      shouldAsyncLayout:(BOOL *)shouldAsyncLayout
+{
+  id<ASDataControllerSource> dataSource = self.dataSource;
+  BOOL isRowKind = [kind isEqualToString:ASDataControllerRowNodeKind];
+  ASCellNodeBlock nodeBlock;
+  id nodeModel;
+  if (isRowKind) {
+    nodeModel = [dataSource dataController:self nodeModelForItemAtIndexPath:indexPath];
+
+    // Get the prior element and attempt to update the existing cell node. Placeholders have no node worth keeping.
+    if (nodeModel != nil && changeSet != nil && !changeSet.includesReloadData) {
+      NSIndexPath *oldIndexPath = [changeSet oldIndexPathForNewIndexPath:indexPath];
+      if (oldIndexPath != nil) {
+        ASCollectionElement *oldElement = [previousMap elementForItemAtIndexPath:oldIndexPath];
+        ASCellNode *oldNode = oldElement.isPlaceholder ? nil : oldElement.node;
+        if ([oldNode canUpdateToNodeModel:nodeModel]) {
+          // Just wrap the node in a block. The collection element will -setNodeModel:
+          nodeBlock = ^{
+            return oldNode;
+          };
         }
       }
-      if (nodeBlock == nil) {
-        nodeBlock = [dataSource dataController:self nodeBlockAtIndexPath:indexPath shouldAsyncLayout:&shouldAsyncLayout];
-      }
-    } else {
-      nodeBlock = [dataSource dataController:self supplementaryNodeBlockOfKind:kind atIndexPath:indexPath shouldAsyncLayout:&shouldAsyncLayout];
     }
-
-    ASSizeRange constrainedSize = ASSizeRangeUnconstrained;
-    if (shouldFetchSizeRanges) {
-      constrainedSize = [self constrainedSizeForNodeOfKind:kind atIndexPath:indexPath];
+    if (nodeBlock == nil) {
+      nodeBlock = [dataSource dataController:self nodeBlockAtIndexPath:indexPath shouldAsyncLayout:shouldAsyncLayout];
     }
-    
-    ASCollectionElement *element = [[ASCollectionElement alloc] initWithNodeModel:nodeModel
-                                                                        nodeBlock:nodeBlock
-                                                         supplementaryElementKind:isRowKind ? nil : kind
-                                                                  constrainedSize:constrainedSize
-                                                                       owningNode:node
-                                                                  traitCollection:traitCollection];
-    [map insertElement:element atIndexPath:indexPath];
-    changeSet.countForAsyncLayout += (shouldAsyncLayout ? 1 : 0);
+  } else {
+    nodeBlock = [dataSource dataController:self supplementaryNodeBlockOfKind:kind atIndexPath:indexPath shouldAsyncLayout:shouldAsyncLayout];
+  }
+
+  ASSizeRange constrainedSize = ASSizeRangeUnconstrained;
+  if (shouldFetchSizeRanges) {
+    constrainedSize = [self constrainedSizeForNodeOfKind:kind atIndexPath:indexPath];
   }
+
+  return [[ASCollectionElement alloc] initWithNodeModel:nodeModel
+                                              nodeBlock:nodeBlock
+                               supplementaryElementKind:isRowKind ? nil : kind
+                                        constrainedSize:constrainedSize
+                                             owningNode:self.node
+                                        traitCollection:traitCollection];
 }
 
 - (void)invalidateDataSourceItemCounts
@@ -586,6 +773,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   }
   
   [self invalidateDataSourceItemCounts];
+  _materializationGeneration++;
   
   // Attempt to mark the update completed. This is when update validation will occur inside the changeset.
   // If an invalid update exception is thrown, we catch it and inject our "validationErrorSource" object,
@@ -600,6 +788,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
       @throw e;
     }
   }
+  [_changeSetsInFlight addObject:changeSet];
 
   BOOL canDelegate = (self.layoutDelegate != nil);
   ASElementMap *newMap;
@@ -636,6 +825,17 @@ typedef void (^ASDataControllerSynchronizationBlock)();
 
   Class<ASDataControllerLayoutDelegate> layoutDelegateClass = [self.layoutDelegate class];
 
+  // The pipelined allocation needs to know what's on screen. The collection shows the items from before the change
+  // set, so their index paths are moved to where the change set puts them, e.g. down by the items inserted above.
+  const BOOL pipelined = !canDelegate && ASActivateExperimentalFeature(ASExperimentalPipelinedCellAllocation);
+  NSArray<NSIndexPath *> *visibleIndexPaths = nil;
+  if (pipelined && [_dataSource respondsToSelector:@selector(visibleIndexPathsForDataController:)]) {
+    visibleIndexPaths = [_dataSource visibleIndexPathsForDataController:self];
+    if (!changeSet.includesReloadData) {
+      visibleIndexPaths = ASArrayByFlatMapping(visibleIndexPaths, NSIndexPath *indexPath, [changeSet newIndexPathForOldIndexPath:indexPath]);
+    }
+  }
+
   // Step 3: Call the layout delegate if possible. Otherwise, allocate and layout all elements
   void (^step3)(BOOL) = ^(BOOL strictlyOnCurrentThread){
     if (canDelegate) {
@@ -655,8 +855,15 @@ typedef void (^ASDataControllerSynchronizationBlock)();
           [elementsToProcess addObject:element];
         }
       }
-      [self _allocateNodesFromElements:elementsToProcess
-               strictlyOnCurrentThread:strictlyOnCurrentThread];
+      if (pipelined) {
+        [self _allocateNodesNearestViewportFirstFromElements:elementsToProcess
+                                                       inMap:newMap
+                                           visibleIndexPaths:visibleIndexPaths
+                                     strictlyOnCurrentThread:strictlyOnCurrentThread];
+      } else {
+        [self _allocateNodesFromElements:elementsToProcess
+                 strictlyOnCurrentThread:strictlyOnCurrentThread];
+      }
     }
   };
 
@@ -695,7 +902,13 @@ typedef void (^ASDataControllerSynchronizationBlock)();
         // As a result, in a short intermidate time, the view will still be relying on the old data source state.
         // Thus, we can't just swap the new map immediately before step 4, but until this update block is executed.
         // (https://github.com/TextureGroup/Texture/issues/378)
-        self.visibleMap = newMap;
+        ASDisplayNodeAssert(self->_changeSetsInFlight.firstObject == changeSet, @"Change sets must be applied in order.");
+        [self->_changeSetsInFlight removeObjectAtIndex:0];
+        ASElementMap *map = [self _mapByCarryingMaterializationsThroughChangeSet:changeSet intoMap:newMap];
+        if (self.pendingMap == newMap) {
+          self.pendingMap = map;
+        }
+        self.visibleMap = map;
       }];
     }];
     --self->_editingTransactionGroupCount;
@@ -771,7 +984,11 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     NSUInteger sectionCount = [self itemCountsFromDataSource].size();
     if (sectionCount > 0) {
       NSIndexSet *sectionIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, sectionCount)];
-      [self _insertElementsIntoMap:map sections:sectionIndexes traitCollection:traitCollection shouldFetchSizeRanges:shouldFetchSizeRanges changeSet:changeSet previousMap:previousMap];
+      if (shouldFetchSizeRanges && _dataSourceFlags.estimatedSizeForItemsInSection && ASActivateExperimentalFeature(ASExperimentalWindowedReload)) {
+        [self _insertWindowedElementsIntoMap:map traitCollection:traitCollection changeSet:changeSet];
+      } else {
+        [self _insertElementsIntoMap:map sections:sectionIndexes traitCollection:traitCollection shouldFetchSizeRanges:shouldFetchSizeRanges changeSet:changeSet previousMap:previousMap];
+      }
     }
     // Return immediately because reloadData can't be used in conjuntion with other updates.
     return;
@@ -836,6 +1053,239 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   }
 }
 
+/**
+ * Inserts all sections for a reload, but only materializes the items within kASDataControllerMaterializationWindow
+ * of the visible ones. The other items of sections with an estimated size are left to placeholders of that size.
+ * Supplementary elements are all materialized.
+ */
+- (void)_insertWindowedElementsIntoMap:(ASMutableElementMap *)map
+                       traitCollection:(ASPrimitiveTraitCollection)traitCollection
+                             changeSet:(_ASHierarchyChangeSet *)changeSet
+{
+  ASDisplayNodeAssertMainThread();
+
+  id<ASDataControllerSource> dataSource = _dataSource;
+  const std::vector<NSInteger> counts = [self itemCountsFromDataSource];
+  const NSInteger sectionCount = counts.size();
+  if (sectionCount == 0 || dataSource == nil) {
+    return;
+  }
+
+  // Like ASDistancesFromViewport, the window counts items across sections. The visible index paths are from before
+  // the reload, so they only hint at where the viewport will be. Without them, the first item counts as visible.
+  std::vector<NSInteger> sectionOffsets(sectionCount + 1, 0);
+  for (NSInteger section = 0; section < sectionCount; section++) {
+    sectionOffsets[section + 1] = sectionOffsets[section] + counts[section];
+  }
+  NSInteger first = NSIntegerMax;
+  NSInteger last = 0;
+  if ([dataSource respondsToSelector:@selector(visibleIndexPathsForDataController:)]) {
+    for (NSIndexPath *indexPath in [dataSource visibleIndexPathsForDataController:self]) {
+      if (indexPath.section < sectionCount) {
+        const NSInteger position = sectionOffsets[indexPath.section] + MIN(indexPath.item, counts[indexPath.section]);
+        first = MIN(first, position);
+        last = MAX(last, position);
+      }
+    }
+  }
+  if (first == NSIntegerMax) {
+    first = 0;
+  }
+  const NSInteger windowStart = first - kASDataControllerMaterializationWindow;
+  const NSInteger windowEnd = last + kASDataControllerMaterializationWindow + 1;
+
+  // Items
+  NSIndexSet *sectionIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, sectionCount)];
+  [map insertEmptySectionsOfItemsAtIndexes:sectionIndexes];
+  for (NSInteger section = 0; section < sectionCount; section++) {
+    const NSInteger itemCount = counts[section];
+    const CGSize estimatedSize = [dataSource dataController:self estimatedSizeForItemsInSection:section];
+    NSInteger start = 0;
+    NSInteger end = itemCount;
+    if (!CGSizeEqualToSize(estimatedSize, CGSizeZero)) {
+      start = MIN(MAX(windowStart - sectionOffsets[section], 0), itemCount);
+      end = MIN(MAX(windowEnd - sectionOffsets[section], start), itemCount);
+    }
+
+    const ASSizeRange placeholderSize = ASSizeRangeMake(estimatedSize);
+    [map appendUnmaterializedItems:start toSection:section placeholderSize:placeholderSize];
+    const auto indexPaths = [[NSMutableArray<NSIndexPath *> alloc] initWithCapacity:end - start];
+    for (NSInteger item = start; item < end; item++) {
+      [indexPaths addObject:[NSIndexPath indexPathForItem:item inSection:section]];
+    }
+    [self _insertElementsIntoMap:map kind:ASDataControllerRowNodeKind atIndexPaths:indexPaths traitCollection:traitCollection shouldFetchSizeRanges:YES changeSet:changeSet previousMap:nil];
+    [map appendUnmaterializedItems:itemCount - end toSection:section placeholderSize:placeholderSize];
+  }
+
+  // Supplementaries
+  for (NSString *kind in [self supplementaryKindsInSections:sectionIndexes]) {
+    [self _insertElementsIntoMap:map kind:kind forSections:sectionIndexes traitCollection:traitCollection shouldFetchSizeRanges:YES changeSet:changeSet previousMap:nil];
+  }
+}
+
+#pragma mark - Materialization
+
+- (void)materializeItemsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths completion:(void (^)())completion
+{
+  ASDisplayNodeAssertMainThread();
+  // The visible map is only in the data source index space while no update is in flight.
+  if (_materializing || _changeSetsInFlight.count > 0 || _dataSource == nil) {
+    return;
+  }
+
+  ASElementMap *map = self.visibleMap;
+  ASPrimitiveTraitCollection traitCollection = [self.node primitiveTraitCollection];
+  const auto elements = [[NSMutableArray<ASCollectionElement *> alloc] init];
+  const auto elementIndexPaths = [[NSMutableArray<NSIndexPath *> alloc] init];
+  for (NSIndexPath *indexPath in indexPaths) {
+    if (![map elementForItemAtIndexPath:indexPath].isPlaceholder) {
+      continue;
+    }
+    BOOL shouldAsyncLayout = YES;
+    [elements addObject:[self _elementOfKind:ASDataControllerRowNodeKind
+                                 atIndexPath:indexPath
+                             traitCollection:traitCollection
+                       shouldFetchSizeRanges:YES
+                                   changeSet:nil
+                                 previousMap:nil
+                           shouldAsyncLayout:&shouldAsyncLayout]];
+    [elementIndexPaths addObject:indexPath];
+  }
+  if (elements.count == 0) {
+    return;
+  }
+
+  _materializing = YES;
+  const NSUInteger generation = _materializationGeneration;
+  __weak __typeof__(self) weakSelf = self;
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    [weakSelf _allocateNodesFromElements:elements strictlyOnCurrentThread:NO];
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      __typeof__(self) strongSelf = weakSelf;
+      if (strongSelf == nil) {
+        return;
+      }
+      strongSelf->_materializing = NO;
+      // An update replaced the map that the index paths are in.
+      if (strongSelf->_materializationGeneration != generation) {
+        return;
+      }
+
+      // The view used the estimated sizes of the placeholders so far.
+      id<ASDataControllerSource> dataSource = strongSelf->_dataSource;
+      NSMutableArray<ASCellNode *> *nodesSizeChanged = [[NSMutableArray alloc] init];
+      for (ASCollectionElement *element in [strongSelf _materializeElements:elements atIndexPaths:elementIndexPaths]) {
+        ASCellNode *node = element.nodeIfAllocated;
+        if (node != nil && ![dataSource dataController:strongSelf presentedSizeForElement:element matchesSize:node.frame.size]) {
+          [nodesSizeChanged addObject:node];
+        }
+      }
+      if (nodesSizeChanged.count > 0 && strongSelf->_dataSourceFlags.didRelayoutNodes) {
+        [dataSource dataController:strongSelf didRelayoutNodes:nodesSizeChanged];
+      }
+      if (completion) {
+        completion();
+      }
+    });
+  });
+}
+
+- (ASCollectionElement *)materializedElementForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+  ASDisplayNodeAssertMainThread();
+  ASCollectionElement *element = [self.visibleMap elementForItemAtIndexPath:indexPath];
+  if (!element.isPlaceholder || _dataSource == nil) {
+    return element;
+  }
+
+  // The data source is in the state of the latest update, so the index path is moved through the updates in flight.
+  NSIndexPath *dataSourceIndexPath = indexPath;
+  for (_ASHierarchyChangeSet *changeSet in _changeSetsInFlight) {
+    dataSourceIndexPath = [changeSet newIndexPathForOldIndexPath:dataSourceIndexPath];
+    if (dataSourceIndexPath == nil) {
+      // The item is deleted or reloaded, the view drops it soon.
+      return element;
+    }
+  }
+
+  BOOL shouldAsyncLayout = YES;
+  ASCollectionElement *materialized = [self _elementOfKind:ASDataControllerRowNodeKind
+                                               atIndexPath:dataSourceIndexPath
+                                           traitCollection:[self.node primitiveTraitCollection]
+                                     shouldFetchSizeRanges:YES
+                                                 changeSet:nil
+                                               previousMap:nil
+                                         shouldAsyncLayout:&shouldAsyncLayout];
+  [self _allocateNodeFromElement:materialized];
+  [self _materializeElements:@[materialized] atIndexPaths:@[indexPath]];
+  return materialized;
+}
+
+/**
+ * Puts the elements in place of the placeholders at the index paths of the visible map, and of the pending map, which
+ * is the same while no update is in flight. Otherwise, the elements are carried into the maps of the updates in flight
+ * as they become visible.
+ *
+ * @return The elements that were materialized. Placeholders that were materialized in the meantime are skipped.
+ */
+- (NSArray<ASCollectionElement *> *)_materializeElements:(NSArray<ASCollectionElement *> *)elements atIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+  ASDisplayNodeAssertMainThread();
+  const BOOL updatesInFlight = (_changeSetsInFlight.count > 0);
+  ASDisplayNodeAssert(updatesInFlight || self.pendingMap == self.visibleMap, @"Expected visible and pending maps to be synchronized: %@", self);
+
+  ASMutableElementMap *mutableMap = [self.visibleMap mutableCopy];
+  const auto materialized = [[NSMutableArray<ASCollectionElement *> alloc] init];
+  NSUInteger i = 0;
+  for (ASCollectionElement *element in elements) {
+    NSIndexPath *indexPath = indexPaths[i++];
+    if ([mutableMap materializeElement:element atIndexPath:indexPath]) {
+      [materialized addObject:element];
+      if (updatesInFlight) {
+        _carriedMaterializations.push_back({element, indexPath});
+      }
+    }
+  }
+  if (materialized.count > 0) {
+    ASElementMap *map = [mutableMap copy];
+    if (!updatesInFlight) {
+      self.pendingMap = map;
+    }
+    self.visibleMap = map;
+  }
+  return materialized;
+}
+
+/**
+ * Returns the map of the change set that is about to become visible, with the elements that were materialized in the
+ * visible map in the meantime.
+ */
+- (ASElementMap *)_mapByCarryingMaterializationsThroughChangeSet:(_ASHierarchyChangeSet *)changeSet intoMap:(ASElementMap *)map
+{
+  ASDisplayNodeAssertMainThread();
+  if (_carriedMaterializations.empty()) {
+    return map;
+  }
+
+  ASMutableElementMap *mutableMap = [map mutableCopy];
+  std::vector<ASDataControllerMaterialization> carried;
+  for (const auto &materialization : _carriedMaterializations) {
+    // Reloaded and deleted items are dropped.
+    NSIndexPath *indexPath = [changeSet newIndexPathForOldIndexPath:materialization.indexPath];
+    if (indexPath != nil && [mutableMap materializeElement:materialization.element atIndexPath:indexPath]) {
+      carried.push_back({materialization.element, indexPath});
+    }
+  }
+  // Once no update is in flight, the pending map has them too.
+  if (_changeSetsInFlight.count > 0) {
+    _carriedMaterializations = std::move(carried);
+  } else {
+    _carriedMaterializations.clear();
+  }
+  return [mutableMap copy];
+}
+
 #pragma mark - Relayout
 
 - (void)relayoutNodes:(id<NSFastEnumeration>)nodes nodesSizeChanged:(NSMutableArray<ASCellNode *> *)nodesSizesChanged
@@ -906,9 +1356,22 @@ typedef void (^ASDataControllerSynchronizationBlock)();
                          traitCollection:[self.node primitiveTraitCollection]
                    shouldFetchSizeRanges:YES
                              previousMap:_pendingMap];
+  // Placeholders take the new estimates. Their nodes are empty, so there is nothing to measure.
+  if (_pendingMap.hasPlaceholders) {
+    for (NSInteger section = 0; section < _pendingMap.numberOfSections; section++) {
+      [newMap setPlaceholderSize:ASSizeRangeMake([_dataSource dataController:self estimatedSizeForItemsInSection:section]) forSection:section];
+    }
+  }
   _pendingMap = [newMap copy];
   _visibleMap = _pendingMap;
 
+  // With incremental relayout, only the nodes in the display range are measured now. The others keep their current
+  // layout and constrained size, which the view keeps using as an estimate, until a background chunk remeasures them.
+  const BOOL incremental = ASActivateExperimentalFeature(ASExperimentalIncrementalRelayout);
+  _relayoutGeneration++;
+  std::vector<ASDataControllerRelayout> displayedRelayouts;
+  std::vector<ASDataControllerRelayout> offscreenRelayouts;
+
   for (ASCollectionElement *element in _visibleMap) {
     // Ignore this element if it is no longer in the latest data. It is still recognized in the UIKit world but will be deleted soon.
     NSIndexPath *indexPathInPendingMap = [_pendingMap indexPathForElement:element];
@@ -920,16 +1383,154 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     ASSizeRange newConstrainedSize = [self constrainedSizeForNodeOfKind:kind atIndexPath:indexPathInPendingMap];
 
     if (ASSizeRangeHasSignificantArea(newConstrainedSize)) {
-      element.constrainedSize = newConstrainedSize;
-
       // Node may not be allocated yet (e.g node virtualization or same size optimization)
       // Call context.nodeIfAllocated here to avoid premature node allocation and layout
       ASCellNode *node = element.nodeIfAllocated;
+      if (incremental && node != nil) {
+        if (ASInterfaceStateIncludesDisplay(node.interfaceState)) {
+          element.constrainedSize = newConstrainedSize;
+          displayedRelayouts.push_back({element, newConstrainedSize});
+        } else if (!ASSizeRangeEqualToSizeRange(element.constrainedSize, newConstrainedSize)) {
+          offscreenRelayouts.push_back({element, newConstrainedSize});
+        }
+        continue;
+      }
+
+      element.constrainedSize = newConstrainedSize;
       if (node) {
         [self _layoutNode:node withConstrainedSize:newConstrainedSize];
       }
     }
   }
+
+  if (incremental) {
+    [self _measureRelayouts:displayedRelayouts qos:QOS_CLASS_USER_INTERACTIVE];
+    for (const auto &relayout : displayedRelayouts) {
+      if (ASCellNode *node = relayout.element.nodeIfAllocated) {
+        [self _layoutNode:node withConstrainedSize:relayout.constrainedSize];
+      }
+    }
+    [self _scheduleOffscreenRelayouts:std::move(offscreenRelayouts)];
+  }
+}
+
+/**
+ * Measures the nodes of the given relayouts concurrently, and blocks the current thread while doing so.
+ * The frames of the nodes are left alone, the results only warm up their layout caches.
+ */
+- (void)_measureRelayouts:(const std::vector<ASDataControllerRelayout> &)relayouts qos:(qos_class_t)qos
+{
+  if (relayouts.empty()) {
+    return;
+  }
+  id<ASDataControllerSource> dataSource = _dataSource;
+  const ASDataControllerRelayout *relayoutsPtr = relayouts.data();
+  ASDispatchApply(relayouts.size(), dispatch_get_global_queue(qos, 0), 0, ^(size_t i) {
+    const ASDataControllerRelayout &relayout = relayoutsPtr[i];
+    ASCellNode *node = relayout.element.nodeIfAllocated;
+    if (node != nil && [dataSource dataController:self shouldEagerlyLayoutNode:node]) {
+      [node layoutThatFits:relayout.constrainedSize];
+    }
+  });
+}
+
+/**
+ * Remeasures the given offscreen nodes in chunks on a background queue, nearest to the visible items first.
+ * After each chunk, the new constrained sizes and frames are applied on the main thread and the data source is
+ * told which nodes changed size, so that it can requery them in one height-only update.
+ */
+- (void)_scheduleOffscreenRelayouts:(std::vector<ASDataControllerRelayout>)relayouts
+{
+  ASDisplayNodeAssertMainThread();
+  if (relayouts.empty()) {
+    return;
+  }
+
+  id<ASDataControllerSource> dataSource = _dataSource;
+  if ([dataSource respondsToSelector:@selector(visibleIndexPathsForDataController:)]) {
+    NSMutableArray<ASCollectionElement *> *elements = [[NSMutableArray alloc] initWithCapacity:relayouts.size()];
+    for (const auto &relayout : relayouts) {
+      [elements addObject:relayout.element];
+    }
+    NSUInteger viewportLength = 0;
+    const std::vector<NSUInteger> distances = ASDistancesFromViewport(elements, _pendingMap, [dataSource visibleIndexPathsForDataController:self], &viewportLength);
+    std::vector<NSUInteger> order(relayouts.size());
+    for (NSUInteger i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&distances](NSUInteger a, NSUInteger b) {
+      return distances[a] < distances[b];
+    });
+    std::vector<ASDataControllerRelayout> sorted;
+    sorted.reserve(relayouts.size());
+    for (NSUInteger index : order) {
+      sorted.push_back(std::move(relayouts[index]));
+    }
+    relayouts = std::move(sorted);
+  }
+
+  // Blocks copy captured C++ objects, so share the relayouts instead.
+  const auto sharedRelayouts = std::make_shared<std::vector<ASDataControllerRelayout>>(std::move(relayouts));
+  [self _relayoutOffscreenChunkAtIndex:0 ofRelayouts:sharedRelayouts generation:_relayoutGeneration];
+}
+
+- (void)_relayoutOffscreenChunkAtIndex:(NSUInteger)start
+                           ofRelayouts:(std::shared_ptr<std::vector<ASDataControllerRelayout>>)relayouts
+                            generation:(NSUInteger)generation
+{
+  __weak __typeof__(self) weakSelf = self;
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+    __typeof__(self) strongSelf = weakSelf;
+    if (strongSelf == nil) {
+      return;
+    }
+    const NSUInteger end = MIN(start + kASDataControllerRelayoutChunkSize, relayouts->size());
+    const std::vector<ASDataControllerRelayout> chunk(relayouts->begin() + start, relayouts->begin() + end);
+    ASSignpostStart(DataControllerRelayoutChunk, strongSelf, "count: %lu", (unsigned long)chunk.size());
+    [strongSelf _measureRelayouts:chunk qos:QOS_CLASS_UTILITY];
+    ASSignpostEnd(DataControllerRelayoutChunk, strongSelf, "count: %lu", (unsigned long)chunk.size());
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+      __typeof__(self) strongSelf = weakSelf;
+      // A newer relayout has taken over the remaining nodes.
+      if (strongSelf == nil || strongSelf->_relayoutGeneration != generation) {
+        return;
+      }
+      [strongSelf _applyOffscreenRelayouts:chunk];
+      if (end < relayouts->size()) {
+        [strongSelf _relayoutOffscreenChunkAtIndex:end ofRelayouts:relayouts generation:generation];
+      }
+    });
+  });
+}
+
+- (void)_applyOffscreenRelayouts:(const std::vector<ASDataControllerRelayout> &)relayouts
+{
+  ASDisplayNodeAssertMainThread();
+  id<ASDataControllerSource> dataSource = _dataSource;
+  const auto visibleMap = self.visibleMap;
+  const auto pendingMap = self.pendingMap;
+  NSMutableArray<ASCellNode *> *nodesSizeChanged = [[NSMutableArray alloc] init];
+  for (const auto &relayout : relayouts) {
+    ASCollectionElement *element = relayout.element;
+    ASCellNode *node = element.nodeIfAllocated;
+    // Skip elements that were deleted in the meantime, see -relayoutNodes:nodesSizeChanged:. Elements whose node was
+    // remeasured on the main thread already, e.g. because it was displayed, don't need a chunk either.
+    if (node == nil || [pendingMap indexPathForElement:element] == nil || [visibleMap indexPathForElement:element] == nil
+        || ASSizeRangeEqualToSizeRange(element.constrainedSize, relayout.constrainedSize)) {
+      continue;
+    }
+
+    element.constrainedSize = relayout.constrainedSize;
+    [self _layoutNode:node withConstrainedSize:relayout.constrainedSize];
+    if (![dataSource dataController:self presentedSizeForElement:element matchesSize:node.frame.size]) {
+      [nodesSizeChanged addObject:node];
+    }
+  }
+
+  if (nodesSizeChanged.count > 0 && _dataSourceFlags.didRelayoutNodes) {
+    [dataSource dataController:self didRelayoutNodes:nodesSizeChanged];
+  }
 }
 
 # pragma mark - ASPrimitiveTraitCollection
@@ -957,6 +1558,8 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   ASDisplayNodeAssertMainThread();
   if (_initialReloadDataHasBeenCalled) {
     [self waitUntilAllUpdatesAreProcessed];
+    _materializationGeneration++;
+    _carriedMaterializations.clear();
     self.visibleMap = self.pendingMap = [[ASElementMap alloc] init];
   }
 }
@@ -24,10 +24,18 @@ AS_SUBCLASSING_RESTRICTED
 @interface ASElementMap : NSObject <NSCopying, NSFastEnumeration>
 
 /**
- * The total number of elements in this map.
+ * The total number of elements in this map. Unmaterialized items are not counted.
  */
 @property (readonly) NSUInteger count;
 
+/**
+ * Whether some items in this map are not materialized yet. O(1)
+ *
+ * Lookups of such items return placeholder elements (see -[ASCollectionElement isPlaceholder]), and
+ * enumeration, @c count and @c itemElements skip them.
+ */
+@property (readonly) BOOL hasPlaceholders;
+
 /**
  * The number of sections (of items) in this map.
  */
@@ -76,7 +84,7 @@ AS_SUBCLASSING_RESTRICTED
 - (NSInteger)convertSection:(NSInteger)sectionIndex fromMap:(ASElementMap *)map;
 
 /**
- * Returns the index path for the given element. O(1)
+ * Returns the index path for the given element. O(1), once an O(N) index is built by the first call.
  */
 - (nullable NSIndexPath *)indexPathForElement:(ASCollectionElement *)element;
 
@@ -86,12 +94,12 @@ AS_SUBCLASSING_RESTRICTED
 - (nullable NSIndexPath *)indexPathForElementIfCell:(ASCollectionElement *)element;
 
 /**
- * Returns the item-element at the given index path. O(1)
+ * Returns the item-element at the given index path, or a placeholder if the item is not materialized. O(1)
  */
 - (nullable ASCollectionElement *)elementForItemAtIndexPath:(NSIndexPath *)indexPath;
 
 /**
- * Returns the element for the supplementary element of the given kind at the given index path. O(1)
+ * Returns the element for the supplementary element of the given kind at the given index path. O(log N)
  */
 - (nullable ASCollectionElement *)supplementaryElementOfKind:(NSString *)supplementaryElementKind atIndexPath:(NSIndexPath *)indexPath;
 
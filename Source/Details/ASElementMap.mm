@@ -10,85 +10,236 @@
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <UIKit/UIKit.h>
 #import <AsyncDisplayKit/ASCollectionElement.h>
-#import <AsyncDisplayKit/ASTwoDimensionalArrayUtils.h>
+#import <AsyncDisplayKit/ASCollections.h>
 #import <AsyncDisplayKit/ASMutableElementMap.h>
 #import <AsyncDisplayKit/ASSection.h>
 #import <AsyncDisplayKit/ASObjectDescriptionHelpers.h>
 
-@interface ASElementMap () <ASDescriptionProvider>
+#import <AsyncDisplayKit/ASElementMapStorage.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+#import <algorithm>
+#import <atomic>
+#import <iterator>
 
-@property (nonatomic, readonly) NSArray<ASSection *> *sections;
+namespace {
 
-// Element -> IndexPath
-@property (nonatomic, readonly) NSMapTable<ASCollectionElement *, NSIndexPath *> *elementToIndexPathMap;
+/**
+ * An open addressing hash table from element to its location in a map, so that finding an element's index path
+ * doesn't need any Foundation objects.
+ */
+class ElementIndex {
+public:
+  struct Location {
+    int32_t section;
+    int32_t item;
+  };
+
+  void build(const AS::ElementMapStorage &storage, NSUInteger count)
+  {
+    // At most half full, so that probe sequences stay short.
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+    _mask = capacity - 1;
+    _slots.assign(capacity, Slot{nil, {0, 0}});
+
+    int32_t section = 0;
+    for (const auto &itemSection : storage.itemSections) {
+      int32_t item = 0;
+      for (ASCollectionElement *element : itemSection->items) {
+        // Placeholders know where they are, unmaterialized items don't need slots.
+        if (element != nil) {
+          insert(element, {section, item});
+        }
+        item++;
+      }
+      section++;
+    }
+    for (const auto &supplementaryKind : storage.supplementaryKinds) {
+      for (const auto &supplementary : *supplementaryKind.elements) {
+        insert(supplementary.element, {(int32_t)supplementary.section, (int32_t)supplementary.item});
+      }
+    }
+  }
 
-// The items, in a 2D array
-@property (nonatomic, readonly) ASCollectionElementTwoDimensionalArray *sectionsOfItems;
+  const Location *find(ASCollectionElement *element) const
+  {
+    for (size_t i = hash(element) & _mask; _slots[i].element != nil; i = (i + 1) & _mask) {
+      if (_slots[i].element == element) {
+        return &_slots[i].location;
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  struct Slot {
+    unowned ASCollectionElement *element;
+    Location location;
+  };
+
+  std::vector<Slot> _slots;
+  size_t _mask = 0;
+
+  static size_t hash(ASCollectionElement *element)
+  {
+    // Objects are 16-byte aligned, drop the low bits and spread the rest.
+    return (size_t)(((uintptr_t)(__bridge void *)element >> 4) * 0x9E3779B97F4A7C15ULL >> 16);
+  }
+
+  void insert(ASCollectionElement *element, Location location)
+  {
+    size_t i = hash(element) & _mask;
+    while (_slots[i].element != nil && _slots[i].element != element) {
+      i = (i + 1) & _mask;
+    }
+    _slots[i] = {element, location};
+  }
+};
 
-@property (nonatomic, readonly) ASSupplementaryElementDictionary *supplementaryElements;
+} // namespace
 
+@interface ASElementMap () <ASDescriptionProvider>
 @end
 
-@implementation ASElementMap
+@implementation ASElementMap {
+  AS::ElementMapStorage _storage;
+
+  // The index of the first item of each section, and the total number of items at the end.
+  std::vector<NSInteger> _sectionOffsets;
+  NSUInteger _count;
+  NSInteger _placeholderCount;
+
+  // Tells this map's placeholders from those of other maps, never 0.
+  uint64_t _identifier;
+
+  // Built on first use, most maps are only used to look up elements by index path.
+  AS::Mutex _indexLock;
+  std::atomic<bool> _indexBuilt;
+  ElementIndex _index;
+}
 
 - (instancetype)init
 {
-  return [self initWithSections:@[] items:@[] supplementaryElements:@{}];
+  return [self initWithStorage:AS::ElementMapStorage()];
 }
 
 - (instancetype)initWithSections:(NSArray<ASSection *> *)sections items:(ASCollectionElementTwoDimensionalArray *)items supplementaryElements:(ASSupplementaryElementDictionary *)supplementaryElements
 {
-  NSCParameterAssert(items.count == sections.count);
+  AS::ElementMapStorage storage;
+  storage.sections.reserve(sections.count);
+  for (ASSection *section in sections) {
+    storage.sections.push_back(section);
+  }
+  storage.itemSections.reserve(items.count);
+  for (NSArray<ASCollectionElement *> *section in items) {
+    auto itemSection = std::make_shared<AS::ElementSection>();
+    itemSection->items.reserve(section.count);
+    for (ASCollectionElement *element in section) {
+      itemSection->items.push_back(element);
+    }
+    storage.itemSections.push_back(std::move(itemSection));
+  }
+  for (NSString *kind in supplementaryElements) {
+    NSDictionary<NSIndexPath *, ASCollectionElement *> *elements = supplementaryElements[kind];
+    auto supplementaries = std::make_shared<AS::SupplementaryElements>();
+    supplementaries->reserve(elements.count);
+    for (NSIndexPath *indexPath in elements) {
+      supplementaries->push_back({indexPath.section, indexPath.item, elements[indexPath]});
+    }
+    std::sort(supplementaries->begin(), supplementaries->end());
+    storage.supplementaryKinds.push_back({[kind copy], std::move(supplementaries)});
+  }
+  return [self initWithStorage:storage];
+}
+
+- (instancetype)initWithStorage:(const AS::ElementMapStorage &)storage
+{
+  NSCParameterAssert(storage.itemSections.size() == storage.sections.size());
 
   if (self = [super init]) {
-    _sections = [sections copy];
-    _sectionsOfItems = [[NSArray alloc] initWithArray:items copyItems:YES];
-    _supplementaryElements = [[NSDictionary alloc] initWithDictionary:supplementaryElements copyItems:YES];
-
-    // Setup our index path map
-    _elementToIndexPathMap = [NSMapTable mapTableWithKeyOptions:(NSMapTableStrongMemory | NSMapTableObjectPointerPersonality) valueOptions:NSMapTableCopyIn];
-    NSInteger s = 0;
-    for (NSArray *section in _sectionsOfItems) {
-      NSInteger i = 0;
-      for (ASCollectionElement *element in section) {
-        NSIndexPath *indexPath = [NSIndexPath indexPathForItem:i inSection:s];
-        [_elementToIndexPathMap setObject:indexPath forKey:element];
-        i++;
-      }
-      s++;
+    static std::atomic<uint64_t> identifiers(0);
+    _identifier = ++identifiers;
+    _storage = storage;
+
+    _sectionOffsets.reserve(_storage.itemSections.size() + 1);
+    NSInteger offset = 0;
+    _placeholderCount = 0;
+    for (const auto &itemSection : _storage.itemSections) {
+      _sectionOffsets.push_back(offset);
+      offset += itemSection->items.size();
+      _placeholderCount += itemSection->placeholderCount;
     }
-    for (NSDictionary *supplementariesForKind in [_supplementaryElements objectEnumerator]) {
-      [supplementariesForKind enumerateKeysAndObjectsUsingBlock:^(NSIndexPath *_Nonnull indexPath, ASCollectionElement * _Nonnull element, BOOL * _Nonnull stop) {
-        [_elementToIndexPathMap setObject:indexPath forKey:element];
-      }];
+    _sectionOffsets.push_back(offset);
+
+    _count = offset - _placeholderCount;
+    for (const auto &supplementaryKind : _storage.supplementaryKinds) {
+      _count += supplementaryKind.elements->size();
     }
   }
   return self;
 }
 
+- (const AS::ElementMapStorage &)storage
+{
+  return _storage;
+}
+
 - (NSUInteger)count
 {
-  return _elementToIndexPathMap.count;
+  return _count;
+}
+
+- (BOOL)hasPlaceholders
+{
+  return _placeholderCount > 0;
 }
 
 - (NSArray<NSIndexPath *> *)itemIndexPaths
 {
-  return ASIndexPathsForTwoDimensionalArray(_sectionsOfItems);
+  // Collections can have tens of thousands of items, so build these on the heap rather than the stack.
+  std::vector<NSIndexPath *> indexPaths;
+  indexPaths.reserve(_sectionOffsets.back());
+  NSInteger section = 0;
+  for (const auto &itemSection : _storage.itemSections) {
+    for (NSInteger item = 0; item < itemSection->items.size(); item++) {
+      indexPaths.push_back([NSIndexPath indexPathForItem:item inSection:section]);
+    }
+    section++;
+  }
+  return [NSArray arrayByTransferring:indexPaths.data() count:indexPaths.size()];
 }
 
 - (NSArray<ASCollectionElement *> *)itemElements
 {
-  return ASElementsInTwoDimensionalArray(_sectionsOfItems);
+  std::vector<ASCollectionElement *> elements;
+  elements.reserve(_sectionOffsets.back() - _placeholderCount);
+  for (const auto &itemSection : _storage.itemSections) {
+    if (itemSection->placeholderCount == 0) {
+      elements.insert(elements.end(), itemSection->items.begin(), itemSection->items.end());
+    } else {
+      std::copy_if(itemSection->items.begin(), itemSection->items.end(), std::back_inserter(elements), [](ASCollectionElement *element) {
+        return element != nil;
+      });
+    }
+  }
+  return [NSArray arrayByTransferring:elements.data() count:elements.size()];
 }
 
 - (NSInteger)numberOfSections
 {
-  return _sectionsOfItems.count;
+  return _storage.itemSections.size();
 }
 
 - (NSArray<NSString *> *)supplementaryElementKinds
 {
-  return _supplementaryElements.allKeys;
+  NSMutableArray<NSString *> *kinds = [[NSMutableArray alloc] initWithCapacity:_storage.supplementaryKinds.size()];
+  for (const auto &supplementaryKind : _storage.supplementaryKinds) {
+    [kinds addObject:supplementaryKind.kind];
+  }
+  return kinds;
 }
 
 - (NSInteger)numberOfItemsInSection:(NSInteger)section
@@ -97,7 +248,7 @@
     return 0;
   }
 
-  return _sectionsOfItems[section].count;
+  return _storage.itemSections[section]->items.size();
 }
 
 - (id<ASSectionContext>)contextForSection:(NSInteger)section
@@ -106,12 +257,23 @@
     return nil;
   }
 
-  return _sections[section].context;
+  return _storage.sections[section].context;
 }
 
 - (nullable NSIndexPath *)indexPathForElement:(ASCollectionElement *)element
 {
-  return element ? [_elementToIndexPathMap objectForKey:element] : nil;
+  if (element == nil) {
+    return nil;
+  }
+  if (element.isPlaceholder) {
+    NSInteger section, item;
+    if ([element isPlaceholderInMapWithIdentifier:_identifier section:&section item:&item]) {
+      return [NSIndexPath indexPathForItem:item inSection:section];
+    }
+    return nil;
+  }
+  const auto location = [self locationOfElement:element];
+  return location ? [NSIndexPath indexPathForItem:location->item inSection:location->section] : nil;
 }
 
 - (nullable NSIndexPath *)indexPathForElementIfCell:(ASCollectionElement *)element
@@ -130,12 +292,26 @@
     return nil;
   }
 
-  return _sectionsOfItems[section][item];
+  const AS::ElementSection &itemSection = *_storage.itemSections[section];
+  ASCollectionElement *element = itemSection.items[item];
+  if (element == nil) {
+    element = [[ASCollectionElement alloc] initPlaceholderWithConstrainedSize:itemSection.placeholderSize
+                                                                mapIdentifier:_identifier
+                                                                      section:section
+                                                                         item:item];
+  }
+  return element;
 }
 
 - (nullable ASCollectionElement *)supplementaryElementOfKind:(NSString *)supplementaryElementKind atIndexPath:(NSIndexPath *)indexPath
 {
-  return _supplementaryElements[supplementaryElementKind][indexPath];
+  const AS::SupplementaryElements *elements = _storage.supplementaryElements(supplementaryElementKind);
+  if (elements == nullptr || indexPath == nil) {
+    return nil;
+  }
+  const AS::SupplementaryElement key = {indexPath.section, indexPath.item, nil};
+  const auto it = std::lower_bound(elements->begin(), elements->end(), key);
+  return (it != elements->end() && it->section == key.section && it->item == key.item) ? it->element : nil;
 }
 
 - (ASCollectionElement *)elementForLayoutAttributes:(UICollectionViewLayoutAttributes *)layoutAttributes
@@ -162,6 +338,14 @@
   } else {
     // Item index path
     ASCollectionElement *element = [map elementForItemAtIndexPath:indexPath];
+    if (element.isPlaceholder && map != self) {
+      // Unmaterialized items have no identity, but a section that is shared by both maps has the same items.
+      NSInteger section = [self convertSection:indexPath.section fromMap:map];
+      if (section != NSNotFound && _storage.itemSections[section] == map->_storage.itemSections[indexPath.section]) {
+        return [NSIndexPath indexPathForItem:indexPath.item inSection:section];
+      }
+      return nil;
+    }
     return [self indexPathForElement:element];
   }
 }
@@ -172,8 +356,9 @@
     return NSNotFound;
   }
 
-  ASSection *section = map.sections[sectionIndex];
-  return [_sections indexOfObjectIdenticalTo:section];
+  ASSection *section = map->_storage.sections[sectionIndex];
+  const auto it = std::find(_storage.sections.begin(), _storage.sections.end(), section);
+  return it != _storage.sections.end() ? it - _storage.sections.begin() : NSNotFound;
 }
 
 #pragma mark - NSCopying
@@ -188,14 +373,51 @@
 
 - (id)mutableCopyWithZone:(NSZone *)zone
 {
-  return [[ASMutableElementMap alloc] initWithSections:_sections items:_sectionsOfItems supplementaryElements:_supplementaryElements];
+  return [[ASMutableElementMap alloc] initWithStorage:_storage];
 }
 
 #pragma mark - NSFastEnumeration
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id  _Nullable unowned [])buffer count:(NSUInteger)len
 {
-  return [_elementToIndexPathMap countByEnumeratingWithState:state objects:buffer count:len];
+  // Items in order, then the supplementary elements of each kind. state->state is the position of the next element.
+  // Unmaterialized items take a position but are skipped.
+  if (state->state == 0) {
+    state->mutationsPtr = &state->extra[0];
+  }
+  NSUInteger position = state->state;
+  NSUInteger count = 0;
+
+  const NSInteger itemCount = _sectionOffsets.back();
+  if (position < itemCount) {
+    NSInteger section = std::upper_bound(_sectionOffsets.begin(), _sectionOffsets.end(), (NSInteger)position) - _sectionOffsets.begin() - 1;
+    NSInteger item = position - _sectionOffsets[section];
+    while (count < len && position < itemCount) {
+      const auto &items = _storage.itemSections[section]->items;
+      for (; item < items.size() && count < len; item++, position++) {
+        if (items[item] != nil) {
+          buffer[count++] = items[item];
+        }
+      }
+      if (item == items.size()) {
+        section++;
+        item = 0;
+      }
+    }
+  }
+
+  NSUInteger kindOffset = itemCount;
+  for (const auto &supplementaryKind : _storage.supplementaryKinds) {
+    const auto &elements = *supplementaryKind.elements;
+    for (; count < len && position >= kindOffset && position < kindOffset + elements.size(); position++) {
+      buffer[count++] = elements[position - kindOffset].element;
+    }
+    kindOffset += elements.size();
+  }
+
+  state->state = position;
+  state->itemsPtr = buffer;
+  return count;
 }
 
 - (NSString *)smallDescription
@@ -203,8 +425,8 @@
   NSMutableArray *sectionDescriptions = [NSMutableArray array];
 
   NSUInteger i = 0;
-  for (NSArray *section in _sectionsOfItems) {
-    [sectionDescriptions addObject:[NSString stringWithFormat:@"<S%tu: %tu>", i, section.count]];
+  for (const auto &itemSection : _storage.itemSections) {
+    [sectionDescriptions addObject:[NSString stringWithFormat:@"<S%tu: %tu>", i, itemSection->items.size()]];
     i++;
   }
   return ASObjectDescriptionMakeWithoutObject(@[ @{ @"itemCounts": sectionDescriptions }]);
@@ -220,19 +442,47 @@
 - (NSMutableArray<NSDictionary *> *)propertiesForDescription
 {
   NSMutableArray *result = [NSMutableArray array];
-  [result addObject:@{ @"items" : _sectionsOfItems }];
-  [result addObject:@{ @"supplementaryElements" : _supplementaryElements }];
+  NSMutableArray *items = [NSMutableArray arrayWithCapacity:_storage.itemSections.size()];
+  for (const auto &itemSection : _storage.itemSections) {
+    NSMutableArray *section = [NSMutableArray arrayWithCapacity:itemSection->items.size()];
+    for (ASCollectionElement *element : itemSection->items) {
+      [section addObject:element ?: [NSNull null]];
+    }
+    [items addObject:section];
+  }
+  NSMutableDictionary *supplementaryElements = [NSMutableDictionary dictionary];
+  for (const auto &supplementaryKind : _storage.supplementaryKinds) {
+    NSMutableDictionary *elements = [NSMutableDictionary dictionaryWithCapacity:supplementaryKind.elements->size()];
+    for (const auto &supplementary : *supplementaryKind.elements) {
+      elements[[NSIndexPath indexPathForItem:supplementary.item inSection:supplementary.section]] = supplementary.element;
+    }
+    supplementaryElements[supplementaryKind.kind] = elements;
+  }
+  [result addObject:@{ @"items" : items }];
+  [result addObject:@{ @"supplementaryElements" : supplementaryElements }];
   return result;
 }
 
 #pragma mark - Internal
 
+- (const ElementIndex::Location *)locationOfElement:(ASCollectionElement *)element
+{
+  if (!_indexBuilt.load(std::memory_order_acquire)) {
+    AS::MutexLocker l(_indexLock);
+    if (!_indexBuilt.load(std::memory_order_relaxed)) {
+      _index.build(_storage, _count);
+      _indexBuilt.store(true, std::memory_order_release);
+    }
+  }
+  return _index.find(element);
+}
+
 /**
  * Fails assert + return NO if section is out of bounds.
  */
 - (BOOL)sectionIndexIsValid:(NSInteger)section assert:(BOOL)assert
 {
-  NSInteger sectionCount = _sectionsOfItems.count;
+  NSInteger sectionCount = _storage.itemSections.size();
   if (section >= sectionCount || section < 0) {
     if (assert) {
       ASDisplayNodeFailAssert(@"Invalid section index %ld when there are only %ld sections!", (long)section, (long)sectionCount);
@@ -259,7 +509,7 @@
     return NO;
   }
 
-  NSInteger itemCount = _sectionsOfItems[section].count;
+  NSInteger itemCount = _storage.itemSections[section]->items.size();
   NSInteger item = indexPath.item;
   if (item >= itemCount || item < 0) {
     if (assert) {
@@ -0,0 +1,139 @@
+//
+//  ASHasher.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * Fast, non-cryptographic hashing: AS::hashBytes for blobs, and AS::hashFields for structs, which hashes each field
+ * on its own so that padding bytes never affect the result.
+ *
+ * This is plain C++, so that it can be tested and benchmarked on any platform, see "./build.sh hashing". Hashes are
+ * not stable across versions of Texture, don't persist them.
+ *
+ * Example:
+ *  NSUInteger hash() const {
+ *    return AS::hashFields(attributedString.hash, lineBreakMode, maximumNumberOfLines, shadowOffset);
+ *  }
+ *
+ * Fields are hashed with AS::HashTraits<T>::hash(const T &), which is defined for integers, enums, floating point
+ * numbers and pointers, and specialized for CoreGraphics types in ASHashing.h and for the ASDimension.h structs in
+ * ASDimensionInternal.h. Objects have to be passed as their -hash.
+ */
+
+#ifdef __cplusplus
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace AS {
+
+/**
+ * Hashes length bytes with a wyhash style function: 16 bytes or fewer take a single 64x64->128-bit multiply, longer
+ * inputs are consumed 48 bytes at a time in three independent lanes.
+ */
+uint64_t hashBytes(const void *bytes, size_t length, uint64_t seed = 0);
+
+/** hashMix for targets without 128-bit integers, like 32-bit ones. */
+inline uint64_t hashMixWithoutInt128(uint64_t a, uint64_t b)
+{
+  const uint64_t aLow = static_cast<uint32_t>(a), aHigh = a >> 32;
+  const uint64_t bLow = static_cast<uint32_t>(b), bHigh = b >> 32;
+  const uint64_t low = aLow * bLow, middle1 = aHigh * bLow, middle2 = aLow * bHigh, high = aHigh * bHigh;
+  const uint64_t carry = ((low >> 32) + static_cast<uint32_t>(middle1) + static_cast<uint32_t>(middle2)) >> 32;
+  return (low + (middle1 << 32) + (middle2 << 32)) ^ (high + (middle1 >> 32) + (middle2 >> 32) + carry);
+}
+
+/** Multiplies a and b into 128 bits and folds the result to 64 bits. The core of hashBytes and Hasher. */
+inline uint64_t hashMix(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+  return hashMixWithoutInt128(a, b);
+#endif
+}
+
+template <typename T, typename Enable = void>
+struct HashTraits;
+
+template <typename T>
+struct HashTraits<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+  static uint64_t hash(T value) { return static_cast<uint64_t>(value); }
+};
+
+template <typename T>
+struct HashTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static uint64_t hash(T value)
+  {
+    // Floats and doubles that are equal hash the same, and so do 0 and -0.
+    const double widened = (value == 0 ? 0.0 : static_cast<double>(value));
+    uint64_t bits;
+    std::memcpy(&bits, &widened, sizeof(bits));
+    return bits;
+  }
+};
+
+template <typename T>
+struct HashTraits<T *> {
+  static uint64_t hash(const T *value) { return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)); }
+};
+
+template <>
+struct HashTraits<std::nullptr_t> {
+  static uint64_t hash(std::nullptr_t) { return 0; }
+};
+
+/**
+ * Combines the hashes of a sequence of fields. The order of the fields matters.
+ */
+class Hasher {
+public:
+  explicit Hasher(uint64_t seed = 0) : _state(seed) {}
+
+  template <typename T>
+  Hasher &add(const T &field)
+  {
+    _state = hashMix(_state ^ kSecret0, HashTraits<typename std::decay<T>::type>::hash(field) ^ kSecret1);
+    _count++;
+    return *this;
+  }
+
+  uint64_t finish() const { return hashMix(_state ^ kSecret2, _count ^ kSecret3); }
+
+  static const uint64_t kSecret0 = 0xa0761d6478bd642fULL;
+  static const uint64_t kSecret1 = 0xe7037ed1a0b428dbULL;
+  static const uint64_t kSecret2 = 0x8ebc6af09c88c6e3ULL;
+  static const uint64_t kSecret3 = 0x589965cc75374cc3ULL;
+
+private:
+  uint64_t _state;
+  uint64_t _count = 0;
+};
+
+/** Hashes the fields in order. */
+template <typename... Fields>
+uint64_t hashFields(const Fields &... fields)
+{
+  Hasher hasher;
+  const int expand[] = {0, (hasher.add(fields), 0)...};
+  (void)expand;
+  return hasher.finish();
+}
+
+/** A std::hash style functor for types with a HashTraits specialization. */
+template <typename T>
+struct Hash {
+  size_t operator()(const T &value) const { return static_cast<size_t>(Hasher().add(value).finish()); }
+};
+
+} // namespace AS
+
+#endif
@@ -0,0 +1,80 @@
+//
+//  ASHasher.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASHasher.h.
+#include "ASHasher.h"
+
+namespace AS {
+
+// Reads are little-endian, like all the platforms Texture runs on.
+static inline uint64_t read64(const uint8_t *p)
+{
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint64_t read32(const uint8_t *p)
+{
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/** Reads 1 to 3 bytes: the first, the middle and the last one. */
+static inline uint64_t read3(const uint8_t *p, size_t length)
+{
+  return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+}
+
+uint64_t hashBytes(const void *bytes, size_t length, uint64_t seed)
+{
+  const uint8_t *p = static_cast<const uint8_t *>(bytes);
+  seed ^= hashMix(seed ^ Hasher::kSecret0, Hasher::kSecret1);
+  uint64_t a;
+  uint64_t b;
+  if (length <= 16) {
+    if (length >= 4) {
+      // Two overlapping pairs of 4 byte reads cover 4 to 16 bytes.
+      const size_t offset = (length >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + offset);
+      b = (read32(p + length - 4) << 32) | read32(p + length - 4 - offset);
+    } else if (length > 0) {
+      a = read3(p, length);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t remaining = length;
+    if (remaining > 48) {
+      // The three lanes don't depend on each other, so their multiplies overlap.
+      uint64_t seed1 = seed;
+      uint64_t seed2 = seed;
+      do {
+        seed = hashMix(read64(p) ^ Hasher::kSecret1, read64(p + 8) ^ seed);
+        seed1 = hashMix(read64(p + 16) ^ Hasher::kSecret2, read64(p + 24) ^ seed1);
+        seed2 = hashMix(read64(p + 32) ^ Hasher::kSecret3, read64(p + 40) ^ seed2);
+        p += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (remaining > 16) {
+      seed = hashMix(read64(p) ^ Hasher::kSecret1, read64(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+    // The last 16 bytes, which may overlap the ones before.
+    a = read64(p + remaining - 16);
+    b = read64(p + remaining - 8);
+  }
+  return hashMix(hashMix(a ^ Hasher::kSecret1, b ^ seed) ^ Hasher::kSecret0 ^ length, Hasher::kSecret1);
+}
+
+} // namespace AS
@@ -7,14 +7,16 @@
 //
 
 #import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import <UIKit/UIGeometry.h>
 #import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASHasher.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
 /**
  * When std::hash is unavailable, this function will hash a bucket o' bits real fast.
- * The hashing algorithm is copied from CoreFoundation's private function CFHashBytes.
- * https://opensource.apple.com/source/CF/CF-1153.18/CFUtilities.c.auto.html
+ * It is AS::hashBytes, see ASHasher.h. In C++, prefer AS::hashFields, which doesn't hash padding.
  *
  * Simple example:
  *  CGRect myRect = { ... };
@@ -38,3 +40,31 @@ NS_ASSUME_NONNULL_BEGIN
 ASDK_EXTERN NSUInteger ASHashBytes(void *bytes, size_t length);
 
 NS_ASSUME_NONNULL_END
+
+#ifdef __cplusplus
+
+namespace AS {
+
+template <>
+struct HashTraits<CGPoint> {
+  static uint64_t hash(const CGPoint &point) { return hashFields(point.x, point.y); }
+};
+
+template <>
+struct HashTraits<CGSize> {
+  static uint64_t hash(const CGSize &size) { return hashFields(size.width, size.height); }
+};
+
+template <>
+struct HashTraits<CGRect> {
+  static uint64_t hash(const CGRect &rect) { return hashFields(rect.origin, rect.size); }
+};
+
+template <>
+struct HashTraits<UIEdgeInsets> {
+  static uint64_t hash(const UIEdgeInsets &insets) { return hashFields(insets.top, insets.left, insets.bottom, insets.right); }
+};
+
+} // namespace AS
+
+#endif
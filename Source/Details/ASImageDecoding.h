@@ -0,0 +1,33 @@
+//
+//  ASImageDecoding.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <UIKit/UIKit.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Decodes image data straight to the smallest size that still covers targetPixelSize in the given content mode,
+ * with ImageIO's thumbnail decoding, so that the full size bitmap is never created. Image downloaders and caches that
+ * receive a target pixel size from ASNetworkImageNode can use this.
+ *
+ * The returned image is decoded already, and has the point size of the full size image: its scale is raised instead,
+ * so that nodes which size themselves to their image lay out the same way.
+ *
+ * @param targetPixelSize The pixels the image is displayed in, or CGSizeZero to decode at full size.
+ * @return The decoded image, or nil if the data isn't an image.
+ */
+ASDK_EXTERN UIImage * _Nullable ASImageDecodeWithData(NSData *data, CGSize targetPixelSize, UIViewContentMode contentMode);
+
+/**
+ * A key for the variant of the image at URL that ASImageDecodeWithData decodes for targetPixelSize and contentMode.
+ * Close targets share a key, and ASImageDecodeWithData decodes them at the same size.
+ */
+ASDK_EXTERN NSString *ASImageDecodedVariantKey(NSURL *URL, CGSize targetPixelSize, UIViewContentMode contentMode);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,96 @@
+//
+//  ASImageDecoding.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASImageDecoding.h>
+
+#import <ImageIO/ImageIO.h>
+
+#import <AsyncDisplayKit/ASImageDownsampling.h>
+
+using namespace AS::ImageDownsampling;
+
+static ContentMode ASImageDownsamplingContentMode(UIViewContentMode contentMode)
+{
+  switch (contentMode) {
+    case UIViewContentModeScaleToFill:
+      return ContentMode::ScaleToFill;
+    case UIViewContentModeScaleAspectFit:
+      return ContentMode::ScaleAspectFit;
+    case UIViewContentModeScaleAspectFill:
+      return ContentMode::ScaleAspectFill;
+    default:
+      return ContentMode::Unscaled;
+  }
+}
+
+/**
+ * The bucketed target, so that close targets decode to the same size. Empty if the content mode doesn't scale.
+ */
+static PixelSize ASImageDownsamplingTarget(CGSize size, ContentMode contentMode)
+{
+  if (contentMode == ContentMode::Unscaled) {
+    return {0, 0};
+  }
+  return bucketedTargetSize(targetPixelSize(size.width, size.height, 1));
+}
+
+UIImage *ASImageDecodeWithData(NSData *data, CGSize targetPixelSize, UIViewContentMode contentMode)
+{
+  // Don't let the source keep its own decoded copy.
+  NSDictionary *sourceOptions = @{ (id)kCGImageSourceShouldCache : @NO };
+  CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, (__bridge CFDictionaryRef)sourceOptions);
+  if (source == NULL) {
+    return nil;
+  }
+
+  NSDictionary *properties = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(source, 0, NULL));
+  NSNumber *pixelWidth = properties[(id)kCGImagePropertyPixelWidth];
+  NSNumber *pixelHeight = properties[(id)kCGImagePropertyPixelHeight];
+  if (pixelWidth.unsignedIntValue == 0 || pixelHeight.unsignedIntValue == 0) {
+    CFRelease(source);
+    return nil;
+  }
+  PixelSize sourceSize = {pixelWidth.unsignedIntValue, pixelHeight.unsignedIntValue};
+  // The thumbnail is rotated to its EXIF orientation, and orientations 5 to 8 swap the sides.
+  NSInteger orientation = [properties[(id)kCGImagePropertyOrientation] integerValue];
+  if (orientation >= 5 && orientation <= 8) {
+    sourceSize = {sourceSize.height, sourceSize.width};
+  }
+
+  const ContentMode mode = ASImageDownsamplingContentMode(contentMode);
+  const PixelSize decodedSize = decodedPixelSize(sourceSize, ASImageDownsamplingTarget(targetPixelSize, mode), mode);
+
+  // JPEG decoders subsample while decoding thumbnails, so a full size bitmap never exists.
+  NSDictionary *thumbnailOptions = @{
+    (id)kCGImageSourceCreateThumbnailFromImageAlways : @YES,
+    (id)kCGImageSourceCreateThumbnailWithTransform : @YES,
+    (id)kCGImageSourceShouldCacheImmediately : @YES,
+    (id)kCGImageSourceThumbnailMaxPixelSize : @(maxPixelSize(decodedSize)),
+  };
+  CGImageRef imageRef = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)thumbnailOptions);
+  CFRelease(source);
+  if (imageRef == NULL) {
+    return nil;
+  }
+
+  // Keep the point size of the full size image.
+  const CGFloat scale = (CGFloat)sourceSize.width / (CGFloat)CGImageGetWidth(imageRef);
+  UIImage *image = [UIImage imageWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+  CGImageRelease(imageRef);
+  return image;
+}
+
+NSString *ASImageDecodedVariantKey(NSURL *URL, CGSize targetPixelSize, UIViewContentMode contentMode)
+{
+  const ContentMode mode = ASImageDownsamplingContentMode(contentMode);
+  const PixelSize target = ASImageDownsamplingTarget(targetPixelSize, mode);
+  if (target.isEmpty()) {
+    return URL.absoluteString;
+  }
+  return [NSString stringWithFormat:@"%@#%ux%u-%d", URL.absoluteString, target.width, target.height, (int)mode];
+}
@@ -0,0 +1,71 @@
+//
+//  ASImageDownloadTransport.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void(^ASImageDownloadTransportProgress)(int64_t bytesReceived, int64_t bytesExpected);
+
+/**
+ * @param data The downloaded bytes, or nil if the download failed.
+ * @param error The reason the download failed, if it did.
+ */
+typedef void(^ASImageDownloadTransportCompletion)(NSData * _Nullable data, NSError * _Nullable error);
+
+/**
+ * A download created by an ASImageDownloadTransport. NSURLSessionDownloadTask conforms to this protocol.
+ */
+@protocol ASImageDownloadTask <NSObject>
+
+/**
+ * A hint between 0.0 and 1.0, like NSURLSessionTaskPriorityLow to NSURLSessionTaskPriorityHigh.
+ */
+@property float priority;
+
+/**
+ * Starts or continues the download.
+ */
+- (void)resume;
+
+/**
+ * Stops the download. The completion of the download must not be called afterwards, or is ignored.
+ */
+- (void)cancel;
+
+@optional
+
+/**
+ * Stops the download, and hands out what is needed to continue it later, if the server allows that.
+ */
+- (void)cancelByProducingResumeData:(void (^)(NSData * _Nullable resumeData))completionHandler;
+
+@end
+
+/**
+ * Moves image bytes for ASBasicImageDownloader, which decides when downloads start, in which order, and when they stop.
+ * The default transport is backed by NSURLSession. Tests and benchmarks can provide their own, e.g. to serve images from
+ * memory with a given latency and throughput.
+ */
+@protocol ASImageDownloadTransport <NSObject>
+
+/**
+ * Creates a suspended download of URL. The downloader resumes it.
+ *
+ * @param resumeData What a previous download of URL produced when it was cancelled, if anything.
+ * @param progress Called as bytes arrive, on any queue.
+ * @param completion Called once when the download succeeds or fails, on any queue.
+ */
+- (id<ASImageDownloadTask>)downloadTaskWithURL:(NSURL *)URL
+                                    resumeData:(nullable NSData *)resumeData
+                                      progress:(ASImageDownloadTransportProgress)progress
+                                    completion:(ASImageDownloadTransportCompletion)completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -63,6 +63,24 @@ typedef void(^ASImageCacherCompletion)(id <ASImageContainerProtocol> _Nullable i
  */
 - (void)clearFetchedImageFromCacheWithURL:(NSURL *)URL;
 
+/**
+ @abstract Attempts to fetch an image with the given URL from the cache, decoded for the given size.
+ @param URL The URL of the image to retrieve from the cache.
+ @param targetPixelSize The pixels the image will be displayed in, with `contentMode`.
+ @param contentMode How the image will be scaled into `targetPixelSize`.
+ @param callbackQueue The queue to call `completion` on.
+ @param completion The block to be called when the cache has either hit or missed.
+ @discussion If implemented, this method is called instead of `cachedImageWithURL:callbackQueue:completion:` by nodes
+ that know their size. The cache may return an image that is larger than needed, but should avoid decoding the full
+ size image when a smaller one covers the target, and cache the smaller one. See ASImageDecodeWithData and
+ ASImageDecodedVariantKey.
+ */
+- (void)cachedImageWithURL:(NSURL *)URL
+           targetPixelSize:(CGSize)targetPixelSize
+               contentMode:(UIViewContentMode)contentMode
+             callbackQueue:(dispatch_queue_t)callbackQueue
+                completion:(ASImageCacherCompletion)completion;
+
 @end
 
 /**
@@ -147,6 +165,33 @@ typedef NS_ENUM(NSUInteger, ASImageDownloaderPriority) {
  */
 - (void)cancelImageDownloadWithResumePossibilityForIdentifier:(id)downloadIdentifier;
 
+/**
+ @abstract Downloads an image with the given URL, and decodes it for the given size.
+ @param URL The URL of the image to download.
+ @param shouldRetry Whether to attempt to retry downloading if the remote host is currently unreachable.
+ @param priority The priority at which the image should be downloaded.
+ @param targetPixelSize The pixels the image will be displayed in, with `contentMode`.
+ @param contentMode How the image will be scaled into `targetPixelSize`.
+ @param callbackQueue The queue to call `downloadProgressBlock` and `completion` on.
+ @param downloadProgress The block to be invoked when the download of `URL` progresses.
+ @param completion The block to be invoked when the download has completed, or has failed.
+ @discussion A 4000x3000 photo shown in a 100 pt thumbnail takes 48 MB decoded at full size, and under 1 MB decoded
+ for the thumbnail. The downloader may complete with a larger image than needed, but should decode straight to the
+ smallest size that covers the target, see ASImageDecodeWithData.
+ @note If this method is implemented, it will be called instead of the other download methods by nodes that know their
+ size.
+ @result An opaque identifier to be used in canceling the download, via `cancelImageDownloadForIdentifier:`. You must
+ retain the identifier if you wish to use it later.
+ */
+- (nullable id)downloadImageWithURL:(NSURL *)URL
+                        shouldRetry:(BOOL)shouldRetry
+                           priority:(ASImageDownloaderPriority)priority
+                    targetPixelSize:(CGSize)targetPixelSize
+                        contentMode:(UIViewContentMode)contentMode
+                      callbackQueue:(dispatch_queue_t)callbackQueue
+                   downloadProgress:(nullable ASImageDownloaderProgress)downloadProgress
+                         completion:(ASImageDownloaderCompletion)completion;
+
 /**
  @abstract Return an object that conforms to ASAnimatedImageProtocol
  @param animatedImageData Data that represents an animated image.
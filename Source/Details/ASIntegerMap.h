@@ -12,7 +12,11 @@
 NS_ASSUME_NONNULL_BEGIN
 
 /**
- * An objective-C wrapper for unordered_map.
+ * A map from integers to integers.
+ *
+ * Maps made by +mapForUpdateWithOldCount:deleted:inserted: store runs of shifted indexes, so their size depends on
+ * the number of changes rather than the number of items. Other maps store small, non-negative keys and values in a
+ * dense array and fall back to a hash map otherwise.
  */
 AS_SUBCLASSING_RESTRICTED
 @interface ASIntegerMap : NSObject <NSCopying>
@@ -50,6 +54,15 @@ AS_SUBCLASSING_RESTRICTED
  */
 - (NSInteger)integerForKey:(NSInteger)key;
 
+/**
+ * Replaces each integer in the buffer with its value in the map, or NSNotFound. Equivalent to calling
+ * -integerForKey: for each of them, but much faster for many keys, especially sorted ones.
+ *
+ * @param integers The keys to look up, which are replaced by their values.
+ * @param count The number of keys.
+ */
+- (void)mapIntegers:(NSInteger *)integers count:(NSUInteger)count;
+
 /**
  * Sets the value for a given key.
  *
@@ -8,22 +8,87 @@
 
 #import "ASIntegerMap.h"
 #import <AsyncDisplayKit/ASAssert.h>
+#import <algorithm>
 #import <unordered_map>
+#import <vector>
 #import <AsyncDisplayKit/ASObjectDescriptionHelpers.h>
 
+namespace {
+
 /**
- * This is just a friendly Objective-C interface to unordered_map<NSInteger, NSInteger>
+ * Consecutive keys that are shifted by the same amount: key + i -> value + i for i in [0, length).
+ */
+struct Run {
+  NSInteger key;
+  NSInteger length;
+  NSInteger value;
+};
+
+enum Form {
+  // Update maps. Sorted, disjoint runs, so memory and lookups depend on the number of changes, not on the item count.
+  FormRuns,
+  // Everything else with small, non-negative keys and values. Indexed by key, kAbsent marks missing keys.
+  FormDense,
+  // Keys or values that don't fit the dense form.
+  FormHash,
+};
+
+const int32_t kAbsent = -1;
+
+// Dense arrays grow to at most this many slots per key that is set, sparser maps use a hash map.
+const NSInteger kMaxDenseSlotsPerKey = 4;
+const NSInteger kMinDenseSlots = 64;
+
+/**
+ * Returns the ranges of [0, limit) that aren't in the index set, in ascending order.
+ */
+std::vector<NSRange> ASRangesNotInIndexSet(NSIndexSet *indexes, NSUInteger limit)
+{
+  __block std::vector<NSRange> result;
+  __block NSUInteger location = 0;
+  [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+    if (range.location >= limit) {
+      *stop = YES;
+      return;
+    }
+    if (range.location > location) {
+      result.push_back(NSMakeRange(location, range.location - location));
+    }
+    location = NSMaxRange(range);
+  }];
+  if (location < limit) {
+    result.push_back(NSMakeRange(location, limit - location));
+  }
+  return result;
+}
+
+} // namespace
+
+/**
+ * A map from integers to integers, see the forms above.
  */
 @interface ASIntegerMap () <ASDescriptionProvider>
 @end
 
 @implementation ASIntegerMap {
+  Form _form;
+  std::vector<Run> _runs;
+  std::vector<int32_t> _dense;
+  NSInteger _denseCount;
   std::unordered_map<NSInteger, NSInteger> _map;
   BOOL _isIdentity;
   BOOL _isEmpty;
   BOOL _immutable; // identity map and empty mape are immutable.
 }
 
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _form = FormDense;
+  }
+  return self;
+}
+
 #pragma mark - Singleton
 
 + (ASIntegerMap *)identityMap NS_RETURNS_RETAINED
@@ -60,32 +125,37 @@
     return ASIntegerMap.identityMap;
   }
 
-  ASIntegerMap *result = [[ASIntegerMap alloc] init];
-  // Start with the old indexes
-  NSMutableIndexSet *indexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, oldCount)];
-
-  // Descending order, shift deleted ranges left
-  [deletions enumerateRangesWithOptions:NSEnumerationReverse usingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    [indexes shiftIndexesStartingAtIndex:NSMaxRange(range) by:-range.length];
-  }];
-
-  // Ascending order, shift inserted ranges right
-  [insertions enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    [indexes shiftIndexesStartingAtIndex:range.location by:range.length];
-  }];
+  // The remaining old indexes, in order, move to the new indexes that weren't inserted, in order. Both are a handful of
+  // ranges, so walk them together rather than visiting every index.
+  const auto oldRanges = ASRangesNotInIndexSet(deletions, oldCount);
+  NSUInteger keptCount = 0;
+  for (const auto &range : oldRanges) {
+    keptCount += range.length;
+  }
+  const auto newRanges = ASRangesNotInIndexSet(insertions, keptCount + insertions.count);
 
-  __block NSInteger oldIndex = 0;
-  [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
-    // Note we advance oldIndex unconditionally, not newIndex
-    for (NSInteger newIndex = range.location; newIndex < NSMaxRange(range); oldIndex++) {
-      if ([deletions containsIndex:oldIndex]) {
-        // index was deleted, do nothing, just let oldIndex advance.
-      } else {
-        // assign the next index for this item.
-        result->_map[oldIndex] = newIndex++;
-      }
+  ASIntegerMap *result = [[ASIntegerMap alloc] init];
+  result->_form = FormRuns;
+  auto &runs = result->_runs;
+  runs.reserve(oldRanges.size() + newRanges.size());
+  auto oldRange = oldRanges.begin();
+  auto newRange = newRanges.begin();
+  NSUInteger oldOffset = 0;
+  NSUInteger newOffset = 0;
+  while (oldRange != oldRanges.end() && newRange != newRanges.end()) {
+    const NSUInteger length = MIN(oldRange->length - oldOffset, newRange->length - newOffset);
+    runs.push_back({(NSInteger)(oldRange->location + oldOffset), (NSInteger)length, (NSInteger)(newRange->location + newOffset)});
+    oldOffset += length;
+    newOffset += length;
+    if (oldOffset == oldRange->length) {
+      oldRange++;
+      oldOffset = 0;
     }
-  }];
+    if (newOffset == newRange->length) {
+      newRange++;
+      newOffset = 0;
+    }
+  }
   return result;
 }
 
@@ -97,8 +167,63 @@
     return NSNotFound;
   }
 
-  const auto result = _map.find(key);
-  return result != _map.end() ? result->second : NSNotFound;
+  switch (_form) {
+    case FormRuns: {
+      const Run *run = [self runForKey:key hint:nullptr];
+      return run ? run->value + (key - run->key) : NSNotFound;
+    }
+    case FormDense:
+      return (key >= 0 && key < (NSInteger)_dense.size() && _dense[key] != kAbsent) ? _dense[key] : NSNotFound;
+    case FormHash: {
+      const auto result = _map.find(key);
+      return result != _map.end() ? result->second : NSNotFound;
+    }
+  }
+}
+
+- (void)mapIntegers:(NSInteger *)integers count:(NSUInteger)count
+{
+  if (_isIdentity) {
+    return;
+  } else if (_isEmpty) {
+    std::fill(integers, integers + count, NSNotFound);
+    return;
+  }
+
+  switch (_form) {
+    case FormRuns: {
+      // Keys are usually sorted, so most of them are in the same run as the previous key.
+      const Run *run = nullptr;
+      for (NSUInteger i = 0; i < count; i++) {
+        const NSInteger key = integers[i];
+        if (run == nullptr || key < run->key || key - run->key >= run->length) {
+          run = [self runForKey:key hint:run];
+          if (run == nullptr) {
+            integers[i] = NSNotFound;
+            continue;
+          }
+        }
+        integers[i] = key + (run->value - run->key);
+      }
+      break;
+    }
+    case FormDense: {
+      const int32_t *dense = _dense.data();
+      const NSUInteger size = _dense.size();
+      for (NSUInteger i = 0; i < count; i++) {
+        const NSUInteger key = integers[i];
+        const int32_t value = key < size ? dense[key] : kAbsent;
+        integers[i] = value != kAbsent ? value : NSNotFound;
+      }
+      break;
+    }
+    case FormHash:
+      for (NSUInteger i = 0; i < count; i++) {
+        const auto result = _map.find(integers[i]);
+        integers[i] = result != _map.end() ? result->second : NSNotFound;
+      }
+      break;
+  }
 }
 
 - (void)setInteger:(NSInteger)value forKey:(NSInteger)key
@@ -108,6 +233,29 @@
     return;
   }
 
+  if (_form == FormRuns) {
+    [self convertToDenseForm];
+  }
+
+  if (_form == FormDense) {
+    const BOOL fitsValue = (value == NSNotFound || (value >= 0 && value < INT32_MAX));
+    const NSInteger maxSlots = MAX(kMinDenseSlots, (_denseCount + 1) * kMaxDenseSlotsPerKey);
+    if (fitsValue && key >= 0 && key < MIN(maxSlots, (NSInteger)INT32_MAX)) {
+      if (key >= (NSInteger)_dense.size()) {
+        _dense.resize(key + 1, kAbsent);
+      }
+      if (_dense[key] != kAbsent) {
+        _denseCount--;
+      }
+      _dense[key] = (value == NSNotFound ? kAbsent : (int32_t)value);
+      if (_dense[key] != kAbsent) {
+        _denseCount++;
+      }
+      return;
+    }
+    [self convertToHashForm];
+  }
+
   _map[key] = value;
 }
 
@@ -118,13 +266,90 @@
   }
 
   const auto result = [[ASIntegerMap alloc] init];
-  
-  for (const auto &e : _map) {
-    result->_map[e.second] = e.first;
+  if (_form == FormRuns) {
+    // Update maps are monotonic, so the swapped runs are sorted too.
+    result->_form = FormRuns;
+    result->_runs.reserve(_runs.size());
+    for (const auto &run : _runs) {
+      result->_runs.push_back({run.value, run.length, run.key});
+    }
+  } else {
+    for (const auto &e : [self sortedEntries]) {
+      [result setInteger:e.first forKey:e.second];
+    }
   }
   return result;
 }
 
+#pragma mark - Forms
+
+/**
+ * Returns the run that contains the key, or nullptr. The hint is a run to start searching from.
+ */
+- (const Run *)runForKey:(NSInteger)key hint:(const Run *)hint
+{
+  const auto begin = _runs.data();
+  const auto end = begin + _runs.size();
+  // Try the next run first, sorted keys move on to it.
+  if (hint != nullptr && hint + 1 < end && key >= hint[1].key && key - hint[1].key < hint[1].length) {
+    return hint + 1;
+  }
+  const auto next = std::upper_bound(begin, end, key, [](NSInteger k, const Run &run) {
+    return k < run.key;
+  });
+  if (next == begin) {
+    return nullptr;
+  }
+  const Run *run = next - 1;
+  return key - run->key < run->length ? run : nullptr;
+}
+
+- (std::vector<std::pair<NSInteger, NSInteger>>)sortedEntries
+{
+  std::vector<std::pair<NSInteger, NSInteger>> entries;
+  switch (_form) {
+    case FormRuns:
+      for (const auto &run : _runs) {
+        for (NSInteger i = 0; i < run.length; i++) {
+          entries.push_back({run.key + i, run.value + i});
+        }
+      }
+      break;
+    case FormDense:
+      entries.reserve(_denseCount);
+      for (NSInteger key = 0; key < (NSInteger)_dense.size(); key++) {
+        if (_dense[key] != kAbsent) {
+          entries.push_back({key, _dense[key]});
+        }
+      }
+      break;
+    case FormHash:
+      entries.assign(_map.begin(), _map.end());
+      std::sort(entries.begin(), entries.end());
+      break;
+  }
+  return entries;
+}
+
+- (void)convertToDenseForm
+{
+  const auto entries = [self sortedEntries];
+  _runs.clear();
+  _form = FormDense;
+  for (const auto &e : entries) {
+    [self setInteger:e.second forKey:e.first];
+  }
+}
+
+- (void)convertToHashForm
+{
+  const auto entries = [self sortedEntries];
+  _dense.clear();
+  _denseCount = 0;
+  _form = FormHash;
+  _map.insert(entries.begin(), entries.end());
+}
+
 #pragma mark - NSCopying
 
 - (id)copyWithZone:(NSZone *)zone
@@ -134,6 +359,10 @@
   }
 
   const auto newMap = [[ASIntegerMap allocWithZone:zone] init];
+  newMap->_form = _form;
+  newMap->_runs = _runs;
+  newMap->_dense = _dense;
+  newMap->_denseCount = _denseCount;
   newMap->_map = _map;
   return newMap;
 }
@@ -151,7 +380,7 @@
   } else {
     // { 1->2 3->4 5->6 }
     NSMutableString *str = [NSMutableString string];
-    for (const auto &e : _map) {
+    for (const auto &e : [self sortedEntries]) {
       [str appendFormat:@" %ld->%ld", (long)e.first, (long)e.second];
     }
     // Remove leading space
@@ -176,7 +405,7 @@
   }
 
   if (ASIntegerMap *otherMap = ASDynamicCast(object, ASIntegerMap)) {
-    return otherMap->_map == _map;
+    return [self sortedEntries] == [otherMap sortedEntries];
   }
   return NO;
 }
@@ -23,6 +23,17 @@ struct ASDirectionalScreenfulBuffer {
 };
 typedef struct ASDirectionalScreenfulBuffer ASDirectionalScreenfulBuffer;
 
+/**
+ * How a scroll view is moving along its scroll axis, used to size adaptive ranges.
+ */
+struct ASScrollMotion {
+  CGFloat velocity;           // Points per second, never negative.
+  CGFloat distanceToTarget;   // Points left until a deceleration comes to rest, 0 unless decelerating.
+  CGFloat viewportLength;     // The length of the viewport along the scroll axis, in points.
+  CGFloat bytesPerScreenful;  // The backing store memory of a viewport sized area.
+};
+typedef struct ASScrollMotion ASScrollMotion;
+
 @protocol ASLayoutController <NSObject>
 
 - (void)setTuningParameters:(ASRangeTuningParameters)tuningParameters forRangeMode:(ASLayoutRangeMode)rangeMode rangeType:(ASLayoutRangeType)rangeType;
@@ -35,6 +46,12 @@ typedef struct ASDirectionalScreenfulBuffer ASDirectionalScreenfulBuffer;
 
 @optional
 
+/**
+ * Like -allElementsForScrolling:rangeMode:displaySet:preloadSet:map:, but with tuning parameters chosen by the caller
+ * rather than those configured for a range mode. Used for adaptive ranges, see ASExperimentalAdaptiveRanges.
+ */
+- (void)allElementsForScrolling:(ASScrollDirection)scrollDirection displayTuningParameters:(ASRangeTuningParameters)displayTuningParameters preloadTuningParameters:(ASRangeTuningParameters)preloadTuningParameters displaySet:(NSHashTable<ASCollectionElement *> * _Nullable * _Nullable)displaySet preloadSet:(NSHashTable<ASCollectionElement *> * _Nullable * _Nullable)preloadSet map:(ASElementMap *)map;
+
 @end
 
 NS_ASSUME_NONNULL_END
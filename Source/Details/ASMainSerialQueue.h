@@ -10,10 +10,39 @@
 #import <Foundation/Foundation.h>
 #import <AsyncDisplayKit/ASBaseDefines.h>
 
+/**
+ * Counters of how the main serial queue kept up. Latency is from a block being scheduled until it starts running.
+ */
+typedef struct {
+  /// Blocks that ran.
+  NSUInteger blockCount;
+  /// The most blocks that were scheduled at once.
+  NSUInteger maximumDepth;
+  /// Drains that ran out of time and yielded to the run loop with blocks left.
+  NSUInteger yieldCount;
+  /// The recent average latency.
+  CFTimeInterval averageLatency;
+  /// The longest latency.
+  CFTimeInterval maximumLatency;
+} ASMainSerialQueueStatistics;
+
+/**
+ * Runs blocks on the main thread in the order they were scheduled.
+ *
+ * Blocks go into a bounded lock-free ring, and into an overflow list when it is full. A single main queue wakeup is
+ * pending while there are blocks, however many are scheduled. Scheduling a block on the main thread runs it, and the
+ * blocks before it, before returning.
+ *
+ * With exp_budgeted_main_serial_queue, the wakeup yields to the run loop once it has run blocks for a few
+ * milliseconds, and continues in a later wakeup.
+ */
 AS_SUBCLASSING_RESTRICTED
 @interface ASMainSerialQueue : NSObject
 
 @property (nonatomic, readonly) NSUInteger numberOfScheduledBlocks;
 - (void)performBlockOnMainThread:(dispatch_block_t)block;
 
+/// Main thread only.
+@property (nonatomic, readonly) ASMainSerialQueueStatistics statistics;
+
 @end
@@ -9,68 +9,257 @@
 
 #import <AsyncDisplayKit/ASMainSerialQueue.h>
 
+#import <QuartzCore/QuartzCore.h>
+#import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASSignpost.h>
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
-#import <queue>
+#import <atomic>
+#import <deque>
+
+/// How long a wakeup runs blocks with exp_budgeted_main_serial_queue before it yields to the run loop.
+static const CFTimeInterval kDrainBudget = 0.008;
+/// How much each block's latency moves the average latency.
+static const CFTimeInterval kLatencySmoothing = 0.1;
+
+namespace {
+
+struct ASMainSerialQueueEntry {
+  /// The retained block.
+  void *block;
+  CFTimeInterval scheduledTime;
+};
+
+/**
+ * A bounded multi-producer, single-consumer ring. Each slot has a sequence number that tells whether it is free for
+ * the producer at a position, or holds the entry for the consumer at a position. Producers claim positions with a
+ * compare and swap, so scheduling never takes a lock while the ring has room.
+ */
+class ASMainSerialQueueRing {
+public:
+  static const size_t kCapacity = 256;
+
+  ASMainSerialQueueRing()
+  {
+    for (size_t i = 0; i < kCapacity; i++) {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Returns false if the ring is full.
+  bool push(const ASMainSerialQueueEntry &entry)
+  {
+    size_t position = _tail.load(std::memory_order_relaxed);
+    while (true) {
+      Slot &slot = _slots[position % kCapacity];
+      const intptr_t difference = static_cast<intptr_t>(slot.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.entry = entry;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = _tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Consumer only. Returns false if the ring is empty, or if the next entry is still being written.
+  bool pop(ASMainSerialQueueEntry *entry)
+  {
+    Slot &slot = _slots[_head % kCapacity];
+    if (slot.sequence.load(std::memory_order_acquire) != _head + 1) {
+      return false;
+    }
+    *entry = slot.entry;
+    slot.sequence.store(_head + kCapacity, std::memory_order_release);
+    _head++;
+    return true;
+  }
+
+  /// Consumer only.
+  bool hasEntry() const
+  {
+    return _slots[_head % kCapacity].sequence.load(std::memory_order_acquire) == _head + 1;
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    ASMainSerialQueueEntry entry;
+  };
+
+  Slot _slots[kCapacity];
+  // Producers and the consumer write these, keep them on separate cache lines.
+  std::atomic<size_t> _tail{0};
+  char _padding[64];
+  size_t _head = 0;
+};
+
+} // namespace
 
 @interface ASMainSerialQueue ()
 {
-  AS::Mutex _serialQueueLock;
-  std::queue<dispatch_block_t> _blocks;
+  ASMainSerialQueueRing _ring;
+
+  // Once a block goes into the overflow list, the ones after it do too until it is empty, to keep the order.
+  AS::Mutex _overflowLock;
+  std::deque<ASMainSerialQueueEntry> _overflow;
+  std::atomic<NSUInteger> _overflowCount;
+
+  std::atomic<NSUInteger> _scheduledCount;
+  std::atomic<NSUInteger> _maximumDepth;
+  std::atomic<bool> _wakeupScheduled;
+
+  ASMainSerialQueueStatistics _statistics;
 }
 
 @end
 
 @implementation ASMainSerialQueue
 
+- (void)dealloc
+{
+  // Scheduled blocks keep the queue alive until they run, but release any that are left just in case.
+  ASMainSerialQueueEntry entry;
+  while ([self _popEntry:&entry]) {
+    CFBridgingRelease(entry.block);
+  }
+}
+
 - (NSUInteger)numberOfScheduledBlocks
 {
-  AS::MutexLocker l(_serialQueueLock);
-  return _blocks.size();
+  return _scheduledCount.load(std::memory_order_acquire);
+}
+
+- (ASMainSerialQueueStatistics)statistics
+{
+  ASDisplayNodeAssertMainThread();
+  ASMainSerialQueueStatistics statistics = _statistics;
+  statistics.maximumDepth = _maximumDepth.load(std::memory_order_relaxed);
+  return statistics;
 }
 
 - (void)performBlockOnMainThread:(dispatch_block_t)block
 {
-  {
-    AS::MutexLocker l(_serialQueueLock);
-    _blocks.push(block);
+  if (block == nil) {
+    return;
+  }
+
+  const NSUInteger depth = _scheduledCount.fetch_add(1, std::memory_order_acq_rel) + 1;
+  NSUInteger maximumDepth = _maximumDepth.load(std::memory_order_relaxed);
+  while (depth > maximumDepth && !_maximumDepth.compare_exchange_weak(maximumDepth, depth, std::memory_order_relaxed)) {
   }
 
-  [self runBlocks];
+  const ASMainSerialQueueEntry entry = { (__bridge_retained void *)[block copy], CACurrentMediaTime() };
+  if (_overflowCount.load(std::memory_order_acquire) > 0 || !_ring.push(entry)) {
+    AS::MutexLocker l(_overflowLock);
+    _overflow.push_back(entry);
+    _overflowCount.fetch_add(1, std::memory_order_release);
+  }
+
+  if (ASDisplayNodeThreadIsMain()) {
+    // Run it right away along with the blocks before it, like ASPerformBlockOnMainThread does.
+    [self _runBlocksUntil:0];
+  } else {
+    // Pairs with the fence in -_wakeup: either we see the flag cleared, or the main thread sees our block.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!_wakeupScheduled.exchange(true, std::memory_order_acq_rel)) {
+      [self _scheduleWakeup];
+    }
+  }
 }
 
-- (void)runBlocks
+- (void)_scheduleWakeup
 {
-  dispatch_block_t mainThread = ^{
-    AS::UniqueLock l(self->_serialQueueLock);
-    do {
-      if (self->_blocks.empty()) {
-        break;
-      }
-      dispatch_block_t block = self->_blocks.front();
-      self->_blocks.pop();
-      {
-        l.unlock();
-        block();
-        l.lock();
-      }
-    } while (true);
-  };
-  
-  ASPerformBlockOnMainThread(mainThread);
+  dispatch_async(dispatch_get_main_queue(), ^{
+    [self _wakeup];
+  });
 }
 
-- (NSString *)description
+- (void)_wakeup
+{
+  ASDisplayNodeAssertMainThread();
+  const CFTimeInterval deadline = ASActivateExperimentalFeature(ASExperimentalBudgetedMainSerialQueue) ? CACurrentMediaTime() + kDrainBudget : 0;
+  while (true) {
+    if (![self _runBlocksUntil:deadline]) {
+      // Out of time. The wakeup stays scheduled, so producers don't schedule another one.
+      _statistics.yieldCount++;
+      [self _scheduleWakeup];
+      return;
+    }
+    _wakeupScheduled.store(false, std::memory_order_release);
+    // A block scheduled after we found the queue empty, but before we cleared the flag, didn't schedule a wakeup.
+    // Without the fence, the check below could miss that block while its producer still sees the flag set.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (![self _hasBlocks] || _wakeupScheduled.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+}
+
+- (BOOL)_hasBlocks
 {
-  NSString *desc = [super description];
-  std::queue<dispatch_block_t> blocks = _blocks;
-  [desc stringByAppendingString:@" Blocks: "];
-  while (!blocks.empty()) {
-      dispatch_block_t block = blocks.front();
-      [desc stringByAppendingFormat:@"%@", block];
-      blocks.pop();
+  return _ring.hasEntry() || _overflowCount.load(std::memory_order_acquire) > 0;
+}
+
+- (BOOL)_popEntry:(ASMainSerialQueueEntry *)entry
+{
+  if (_ring.pop(entry)) {
+    return YES;
+  }
+  if (_overflowCount.load(std::memory_order_acquire) == 0) {
+    return NO;
   }
-  return desc;
+  AS::MutexLocker l(_overflowLock);
+  if (_overflow.empty()) {
+    return NO;
+  }
+  *entry = _overflow.front();
+  _overflow.pop_front();
+  _overflowCount.fetch_sub(1, std::memory_order_release);
+  return YES;
+}
+
+/**
+ * Runs blocks until there are none left, or until the deadline if it isn't 0. Returns whether it ran out of blocks.
+ */
+- (BOOL)_runBlocksUntil:(CFTimeInterval)deadline
+{
+  ASDisplayNodeAssertMainThread();
+  BOOL ranOutOfBlocks = YES;
+  NSUInteger count = 0;
+  ASSignpostStart(MainSerialQueueDrain, self, "%s", object_getClassName(self));
+  ASMainSerialQueueEntry entry;
+  while ([self _popEntry:&entry]) {
+    _scheduledCount.fetch_sub(1, std::memory_order_acq_rel);
+    const CFTimeInterval now = CACurrentMediaTime();
+    const CFTimeInterval latency = now - entry.scheduledTime;
+    _statistics.blockCount++;
+    _statistics.maximumLatency = MAX(_statistics.maximumLatency, latency);
+    const CFTimeInterval average = _statistics.averageLatency;
+    _statistics.averageLatency = (_statistics.blockCount > 1 ? average + kLatencySmoothing * (latency - average) : latency);
+
+    dispatch_block_t block = (__bridge_transfer dispatch_block_t)entry.block;
+    block();
+    count++;
+
+    if (deadline > 0 && CACurrentMediaTime() >= deadline) {
+      ranOutOfBlocks = ![self _hasBlocks];
+      break;
+    }
+  }
+  ASSignpostEnd(MainSerialQueueDrain, self, "count: %lu", (unsigned long)count);
+  return ranOutOfBlocks;
+}
+
+- (NSString *)description
+{
+  return [NSString stringWithFormat:@"%@ Blocks: %lu", [super description], (unsigned long)self.numberOfScheduledBlocks];
 }
 
 @end
@@ -24,6 +24,18 @@ NS_ASSUME_NONNULL_BEGIN
 @protocol ASRangeControllerDelegate;
 @protocol ASLayoutController;
 
+/**
+ * Counters of how well the ranges of a range controller kept up with scrolling.
+ */
+typedef struct {
+  /// Cells that entered the visible range.
+  NSUInteger visibleCount;
+  /// Cells that entered the visible range before they finished displaying.
+  NSUInteger visibleBeforeDisplayedCount;
+  /// The recent average time from a cell entering the display range until it finished displaying.
+  CFTimeInterval averageDisplayDuration;
+} ASRangeControllerStatistics;
+
 /**
  * Working range controller.
  *
@@ -102,6 +114,17 @@ AS_SUBCLASSING_RESTRICTED
  */
 @property (nonatomic) BOOL contentHasBeenScrolled;
 
+/**
+ * The backing store memory the display range may use with adaptive ranges, see ASExperimentalAdaptiveRanges.
+ * The preload range may span twice as many screenfuls. Defaults to 48 MB.
+ */
+@property (nonatomic) NSUInteger adaptiveRangeByteLimit;
+
+/**
+ * A snapshot of the counters of this range controller.
+ */
+@property (nonatomic, readonly) ASRangeControllerStatistics statistics;
+
 @end
 
 
@@ -140,6 +163,23 @@ AS_SUBCLASSING_RESTRICTED
 
 - (NSString *)nameForRangeControllerDataSource;
 
+@optional
+
+/**
+ * @param rangeController Sender.
+ *
+ * @return how the view using this range controller is scrolling. Ranges only adapt to data sources that implement this.
+ */
+- (ASScrollMotion)scrollMotionForRangeController:(ASRangeController *)rangeController;
+
+/**
+ * @param rangeController Sender.
+ *
+ * @param indexPaths The index paths of placeholders in the element map that are in range. Placeholders take no part
+ * in range updates until they are materialized, see -[ASCollectionElement isPlaceholder].
+ */
+- (void)rangeController:(ASRangeController *)rangeController materializePlaceholdersAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths;
+
 @end
 
 /**
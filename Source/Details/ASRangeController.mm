@@ -13,9 +13,11 @@
 #import <AsyncDisplayKit/ASAssert.h>
 #import <AsyncDisplayKit/ASCollectionElement.h>
 #import <AsyncDisplayKit/ASCollectionView.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h> // Required for interfaceState and hierarchyState setter methods.
 #import <AsyncDisplayKit/ASElementMap.h>
+#import <AsyncDisplayKit/ASImageContentsCache.h>
 #import <AsyncDisplayKit/ASSignpost.h>
 
 #import <AsyncDisplayKit/ASCellNode+Internal.h>
@@ -28,6 +30,20 @@
 #define ASRangeControllerAutomaticLowMemoryHandling 1
 #endif
 
+static NSUInteger const kDefaultAdaptiveRangeByteLimit = 48 * 1024 * 1024;
+
+// Assumed until the first cell finished displaying.
+static CFTimeInterval const kInitialDisplayDuration = 0.1;
+
+// The weight of each new display duration in the average.
+static CFTimeInterval const kDisplayDurationSmoothing = 0.2;
+
+// Display durations vary from cell to cell, start displaying this many average durations ahead.
+static CFTimeInterval const kDisplayLeadTimeFactor = 2.0;
+
+// Preloading has to start early enough for network requests to finish before display.
+static CFTimeInterval const kPreloadLeadTime = 1.0;
+
 @interface ASRangeController ()
 {
   BOOL _rangeIsValid;
@@ -39,6 +55,7 @@
   BOOL _preserveCurrentRangeMode;
   BOOL _didRegisterForNodeDisplayNotifications;
   CFTimeInterval _pendingDisplayNodesTimestamp;
+  ASRangeControllerStatistics _statistics;
 
   // If the user is not currently scrolling, we will keep our ranges
   // configured to match their previous scroll direction. Defaults
@@ -71,6 +88,7 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   _contentHasBeenScrolled = NO;
   _preserveCurrentRangeMode = NO;
   _previousScrollDirection = ASScrollDirectionDown | ASScrollDirectionRight;
+  _adaptiveRangeByteLimit = kDefaultAdaptiveRangeByteLimit;
   
   [[[self class] allRangeControllersWeakSet] addObject:self];
   
@@ -158,6 +176,10 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
 {
   _preserveCurrentRangeMode = YES;
   if (_currentRangeMode != rangeMode) {
+    if (rangeMode == ASLayoutRangeModeLowMemory) {
+      // Memory warnings and backgrounding get here, before the display range is emptied.
+      ASImageContentsCacheTrim();
+    }
     _currentRangeMode = rangeMode;
 
     [self setNeedsUpdate];
@@ -180,6 +202,40 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   }
 }
 
+- (ASRangeControllerStatistics)statistics
+{
+  ASDisplayNodeAssertMainThread();
+  return _statistics;
+}
+
+/**
+ * Sizes the Full ranges for the current scroll motion, see ASRangeTuningParametersAdaptedToScrollMotion. The display
+ * range starts far enough ahead for cells to finish displaying in the time recent cells took, and stays within the
+ * memory limit. The Minimum range mode's parameters are the smallest ranges used.
+ */
+- (void)_adaptDisplayTuningParameters:(ASRangeTuningParameters *)displayParameters preloadTuningParameters:(ASRangeTuningParameters *)preloadParameters
+{
+  ASScrollMotion motion = [_dataSource scrollMotionForRangeController:self];
+  if (motion.bytesPerScreenful <= 0) {
+    return;
+  }
+
+  CGFloat displayScreenfuls = MAX(_adaptiveRangeByteLimit / motion.bytesPerScreenful, 1.0);
+  CFTimeInterval displayDuration = (_statistics.averageDisplayDuration > 0 ? _statistics.averageDisplayDuration : kInitialDisplayDuration);
+  CFTimeInterval displayLeadTime = kDisplayLeadTimeFactor * displayDuration;
+
+  ASRangeTuningParameters minimumDisplay = [_layoutController tuningParametersForRangeMode:ASLayoutRangeModeMinimum rangeType:ASLayoutRangeTypeDisplay];
+  ASRangeTuningParameters minimumPreload = [_layoutController tuningParametersForRangeMode:ASLayoutRangeModeMinimum rangeType:ASLayoutRangeTypePreload];
+  ASRangeTuningParameters display = ASRangeTuningParametersAdaptedToScrollMotion(*displayParameters, minimumDisplay, motion, displayLeadTime, displayScreenfuls);
+  ASRangeTuningParameters preload = ASRangeTuningParametersAdaptedToScrollMotion(*preloadParameters, minimumPreload, motion, displayLeadTime + kPreloadLeadTime, 2 * displayScreenfuls);
+
+  // Cells are preloaded before they are displayed.
+  preload.leadingBufferScreenfuls = MAX(preload.leadingBufferScreenfuls, display.leadingBufferScreenfuls);
+  preload.trailingBufferScreenfuls = MAX(preload.trailingBufferScreenfuls, display.trailingBufferScreenfuls);
+  *displayParameters = display;
+  *preloadParameters = preload;
+}
+
 // Clear the visible bit from any nodes that disappeared since last update.
 // Currently we guarantee that nodes will not be marked visible when deallocated,
 // but it's OK to be in e.g. the preload range. So for the visible bit specifically,
@@ -237,7 +293,9 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
     // Those didEndDisplayingCell calls result in items being removed from the visibleElements returned by the _dataSource, even though the layout remains correct.
     visibleElements = [_layoutController elementsForScrolling:scrollDirection rangeMode:ASLayoutRangeModeVisibleOnly rangeType:ASLayoutRangeTypeDisplay map:map];
     for (ASCollectionElement *element in visibleElements) {
-      [newVisibleNodes addObject:element.node];
+      if (!element.isPlaceholder) {
+        [newVisibleNodes addObject:element.node];
+      }
     }
     [self _setVisibleNodes:newVisibleNodes];
     ASSignpostEnd(RangeControllerUpdate, _dataSource, "");
@@ -261,6 +319,14 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   ASRangeTuningParameters parametersDisplay = [_layoutController tuningParametersForRangeMode:rangeMode
                                                                                     rangeType:ASLayoutRangeTypeDisplay];
 
+  BOOL adaptiveRanges = (rangeMode == ASLayoutRangeModeFull
+                         && ASActivateExperimentalFeature(ASExperimentalAdaptiveRanges)
+                         && [_dataSource respondsToSelector:@selector(scrollMotionForRangeController:)]
+                         && [_layoutController respondsToSelector:@selector(allElementsForScrolling:displayTuningParameters:preloadTuningParameters:displaySet:preloadSet:map:)]);
+  if (adaptiveRanges) {
+    [self _adaptDisplayTuningParameters:&parametersDisplay preloadTuningParameters:&parametersPreload];
+  }
+
   // Preload can express the ultra-low-memory state with 0, 0 returned for its tuningParameters above, and will match Visible.
   // However, in this rangeMode, Display is not supposed to contain *any* paths -- not even the visible bounds. TuningParameters can't express this.
   BOOL emptyDisplayRange = (rangeMode == ASLayoutRangeModeLowMemory);
@@ -274,7 +340,9 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   NSHashTable<ASCollectionElement *> *displayElements = nil;
   NSHashTable<ASCollectionElement *> *preloadElements = nil;
   
-  if (optimizedLoadingOfBothRanges) {
+  if (adaptiveRanges) {
+    [_layoutController allElementsForScrolling:scrollDirection displayTuningParameters:parametersDisplay preloadTuningParameters:parametersPreload displaySet:&displayElements preloadSet:&preloadElements map:map];
+  } else if (optimizedLoadingOfBothRanges) {
     [_layoutController allElementsForScrolling:scrollDirection rangeMode:rangeMode displaySet:&displayElements preloadSet:&preloadElements map:map];
   } else {
     if (emptyDisplayRange == YES) {
@@ -319,11 +387,20 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   [allIndexPaths unionSet:_allPreviousIndexPaths];
   _allPreviousIndexPaths = allCurrentIndexPaths;
   
+  if (rangeMode == ASLayoutRangeModeLowMemory && _currentRangeMode != ASLayoutRangeModeLowMemory) {
+    // The display range is about to be emptied to save memory, don't keep image contents for cells that are gone.
+    ASImageContentsCacheTrim();
+  }
   _currentRangeMode = rangeMode;
   _preserveCurrentRangeMode = NO;
   
   if (!_rangeIsValid) {
-    [allIndexPaths addObjectsFromArray:map.itemIndexPaths];
+    // Placeholders have no state to reset, and there may be many more of them than elements.
+    if (map.hasPlaceholders) {
+      [allIndexPaths addObjectsFromArray:ASArrayByFlatMapping(map.itemElements, ASCollectionElement *element, [map indexPathForElement:element])];
+    } else {
+      [allIndexPaths addObjectsFromArray:map.itemIndexPaths];
+    }
   }
   
 #if ASRangeControllerLoggingEnabled
@@ -331,6 +408,7 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   NSMutableArray<NSIndexPath *> *modifiedIndexPaths = (ASRangeControllerLoggingEnabled ? [NSMutableArray array] : nil);
 #endif
 
+  NSMutableArray<NSIndexPath *> *placeholderIndexPaths = nil;
   for (NSIndexPath *indexPath in allIndexPaths) {
     // Before a node / indexPath is exposed to ASRangeController, ASDataController should have already measured it.
     // For consistency, make sure each node knows that it should measure itself if something changes.
@@ -365,17 +443,37 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
       }
     }
 
-    ASCellNode *node = [map elementForItemAtIndexPath:indexPath].nodeIfAllocated;
+    ASCollectionElement *element = [map elementForItemAtIndexPath:indexPath];
+    if (element.isPlaceholder) {
+      if (interfaceState != ASInterfaceStateMeasureLayout) {
+        placeholderIndexPaths = placeholderIndexPaths ?: [[NSMutableArray alloc] init];
+        [placeholderIndexPaths addObject:indexPath];
+      }
+      continue;
+    }
+    ASCellNode *node = element.nodeIfAllocated;
     if (node != nil) {
       ASDisplayNodeAssert(node.hierarchyState & ASHierarchyStateRangeManaged, @"All nodes reaching this point should be range-managed, or interfaceState may be incorrectly reset.");
       if (ASInterfaceStateIncludesVisible(interfaceState)) {
         [newVisibleNodes addObject:node];
       }
+      CFTimeInterval displayDuration = node.unreportedDisplayDuration;
+      if (displayDuration > 0) {
+        node.unreportedDisplayDuration = 0;
+        CFTimeInterval average = _statistics.averageDisplayDuration;
+        _statistics.averageDisplayDuration = (average > 0 ? average + kDisplayDurationSmoothing * (displayDuration - average) : displayDuration);
+      }
       // Skip the many method calls of the recursive operation if the top level cell node already has the right interfaceState.
       if (node.pendingInterfaceState != interfaceState) {
 #if ASRangeControllerLoggingEnabled
         [modifiedIndexPaths addObject:indexPath];
 #endif
+        if (ASInterfaceStateIncludesVisible(interfaceState) && !ASInterfaceStateIncludesVisible(node.pendingInterfaceState)) {
+          _statistics.visibleCount++;
+          if (!node.hasDisplayedContents) {
+            _statistics.visibleBeforeDisplayedCount++;
+          }
+        }
 
         BOOL nodeShouldScheduleDisplay = [node shouldScheduleDisplayWithNewInterfaceState:interfaceState];
         [node recursivelySetInterfaceState:interfaceState];
@@ -391,6 +489,10 @@ static UIApplicationState __ApplicationState = UIApplicationStateActive;
   }
 
   [self _setVisibleNodes:newVisibleNodes];
+
+  if (placeholderIndexPaths != nil && [_dataSource respondsToSelector:@selector(rangeController:materializePlaceholdersAtIndexPaths:)]) {
+    [_dataSource rangeController:self materializePlaceholdersAtIndexPaths:placeholderIndexPaths];
+  }
   
   // TODO: This code is for debugging only, but would be great to clean up with a delegate method implementation.
   if (ASDisplayNode.shouldShowRangeDebugOverlay) {
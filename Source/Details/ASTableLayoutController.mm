@@ -32,9 +32,13 @@
 
 - (NSHashTable<ASCollectionElement *> *)elementsForScrolling:(ASScrollDirection)scrollDirection rangeMode:(ASLayoutRangeMode)rangeMode rangeType:(ASLayoutRangeType)rangeType map:(ASElementMap *)map
 {
-  CGRect bounds = _tableView.bounds;
-
   ASRangeTuningParameters tuningParameters = [self tuningParametersForRangeMode:rangeMode rangeType:rangeType];
+  return [self elementsForScrolling:scrollDirection tuningParameters:tuningParameters map:map];
+}
+
+- (NSHashTable<ASCollectionElement *> *)elementsForScrolling:(ASScrollDirection)scrollDirection tuningParameters:(ASRangeTuningParameters)tuningParameters map:(ASElementMap *)map
+{
+  CGRect bounds = _tableView.bounds;
   CGRect rangeBounds = CGRectExpandToRangeWithScrollableDirections(bounds, tuningParameters, ASScrollDirectionVerticalDirections, scrollDirection);
   NSArray *array = [_tableView indexPathsForRowsInRect:rangeBounds];
   return ASPointerTableByFlatMapping(array, NSIndexPath *indexPath, [map elementForItemAtIndexPath:indexPath]);
@@ -51,4 +55,14 @@
   return;
 }
 
+- (void)allElementsForScrolling:(ASScrollDirection)scrollDirection displayTuningParameters:(ASRangeTuningParameters)displayTuningParameters preloadTuningParameters:(ASRangeTuningParameters)preloadTuningParameters displaySet:(NSHashTable<ASCollectionElement *> *__autoreleasing  _Nullable *)displaySet preloadSet:(NSHashTable<ASCollectionElement *> *__autoreleasing  _Nullable *)preloadSet map:(ASElementMap *)map
+{
+  if (displaySet == NULL || preloadSet == NULL) {
+    return;
+  }
+
+  *displaySet = [self elementsForScrolling:scrollDirection tuningParameters:displayTuningParameters map:map];
+  *preloadSet = [self elementsForScrolling:scrollDirection tuningParameters:preloadTuningParameters map:map];
+}
+
 @end
@@ -68,24 +68,24 @@
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
  * @discussion This compares the equality of each object with `isEqual:`.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * This diffing algorithm finds a longest common subsequence with Myers' linear-space algorithm to identify differences.
+ * It runs in O((m + n)D) time, where D is the number of differences, and O(m + n) memory.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions;
 
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
  * @discussion The `compareBlock` is used to identify the equality of the objects within the arrays.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * This diffing algorithm finds a longest common subsequence with Myers' linear-space algorithm to identify differences.
+ * It runs in O((m + n)D) time, where D is the number of differences, and O(m + n) memory.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions compareBlock:(BOOL (^)(id lhs, id rhs))comparison;
 
 /**
  * @abstract Compares two arrays, providing the insertion, deletion, and move indexes needed to transform into the target array.
  * @discussion This compares the equality of each object with `isEqual:`.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * This diffing algorithm finds a longest common subsequence with Myers' linear-space algorithm to identify differences.
+ * It runs in O((m + n)D) time, where D is the number of differences, and O(m + n) memory.
  * The moves are returned in ascending order of their destination index.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions moves:(NSArray<NSIndexPath *> **)moves;
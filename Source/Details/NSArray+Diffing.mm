@@ -10,7 +10,164 @@
 #import <AsyncDisplayKit/NSArray+Diffing.h>
 #import <UIKit/NSIndexPath+UIKitAdditions.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <algorithm>
 #import <unordered_map>
+#import <vector>
+
+/**
+ * Sub-problems whose (trimmed) size product is below this are solved with the classic LCS length matrix, which is
+ * faster for small inputs and matches the historical tie-breaking exactly.
+ */
+static const NSInteger kASDiffMatrixThreshold = 128 * 128;
+
+/**
+ * Computes a longest common subsequence between `a[0..n)` and `b[0..m)`, appending the matched indexes of `a` to
+ * `common` in ascending order. `equal(i, j)` compares `a[i]` with `b[j]`.
+ *
+ * Common suffixes and prefixes are stripped first, which covers most data source updates. Large remainders are split
+ * with Myers' linear-space divide and conquer ("An O(ND) Difference Algorithm and Its Variations", section 4b), which
+ * runs in O((n + m) * D) time and O(n + m) space, where D is the size of the edit script. Small remainders fall back
+ * to the LCS length matrix.
+ */
+template <typename Equal>
+class ASCommonSubsequence {
+public:
+  ASCommonSubsequence(const Equal &equal, std::vector<NSInteger> &common) : _equal(equal), _common(common) {}
+
+  void compute(NSInteger n, NSInteger m)
+  {
+    divide(0, n, 0, m);
+  }
+
+private:
+  const Equal &_equal;
+  std::vector<NSInteger> &_common;
+  std::vector<NSInteger> _forward;
+  std::vector<NSInteger> _backward;
+  std::vector<NSInteger> _matrix;
+
+  void divide(NSInteger aLo, NSInteger aHi, NSInteger bLo, NSInteger bHi)
+  {
+    // Common suffixes are matched exactly as the matrix backtrack would match them.
+    NSInteger suffix = 0;
+    while (aLo < aHi - suffix && bLo < bHi - suffix && _equal(aHi - suffix - 1, bHi - suffix - 1)) {
+      suffix++;
+    }
+    aHi -= suffix;
+    bHi -= suffix;
+    if ((aHi - aLo) * (bHi - bLo) <= kASDiffMatrixThreshold) {
+      matrix(aLo, aHi, bLo, bHi);
+    } else {
+      while (aLo < aHi && bLo < bHi && _equal(aLo, bLo)) {
+        _common.push_back(aLo);
+        aLo++;
+        bLo++;
+      }
+      if (aLo < aHi && bLo < bHi) {
+        NSInteger x = 0, y = 0, u = 0, v = 0;
+        middleSnake(aLo, aHi, bLo, bHi, &x, &y, &u, &v);
+        divide(aLo, aLo + x, bLo, bLo + y);
+        for (NSInteger i = x; i < u; i++) {
+          _common.push_back(aLo + i);
+        }
+        divide(aLo + u, aHi, bLo + v, bHi);
+      }
+    }
+    for (NSInteger i = aHi; i < aHi + suffix; i++) {
+      _common.push_back(i);
+    }
+  }
+
+  /**
+   * Finds the middle snake of an optimal edit path between a[aLo, aHi) and b[bLo, bHi), returned as the diagonal run
+   * from (x, y) to (u, v) in coordinates relative to (aLo, bLo). Both ranges must be non-empty.
+   */
+  void middleSnake(NSInteger aLo, NSInteger aHi, NSInteger bLo, NSInteger bHi,
+                   NSInteger *x, NSInteger *y, NSInteger *u, NSInteger *v)
+  {
+    const NSInteger n = aHi - aLo, m = bHi - bLo;
+    const NSInteger delta = n - m;
+    const bool odd = (delta & 1) != 0;
+    const NSInteger maxD = (n + m + 1) / 2;
+    const NSInteger offset = maxD + 1;
+    if ((NSInteger)_forward.size() < 2 * offset + 1) {
+      // The outermost call is the largest, so this only allocates once per diff.
+      _forward.resize(2 * offset + 1);
+      _backward.resize(2 * offset + 1);
+    }
+    NSInteger *vf = _forward.data() + offset;
+    NSInteger *vb = _backward.data() + offset;
+    vf[1] = 0;
+    vb[1] = 0;
+    for (NSInteger d = 0; d <= maxD; d++) {
+      for (NSInteger k = -d; k <= d; k += 2) {
+        NSInteger px = (k == -d || (k != d && vf[k - 1] < vf[k + 1])) ? vf[k + 1] : vf[k - 1] + 1;
+        NSInteger py = px - k;
+        const NSInteger sx = px, sy = py;
+        while (px < n && py < m && _equal(aLo + px, bLo + py)) {
+          px++; py++;
+        }
+        vf[k] = px;
+        const NSInteger c = delta - k;
+        if (odd && c >= -(d - 1) && c <= d - 1 && vf[k] + vb[c] >= n) {
+          *x = sx; *y = sy; *u = px; *v = py;
+          return;
+        }
+      }
+      for (NSInteger k = -d; k <= d; k += 2) {
+        NSInteger px = (k == -d || (k != d && vb[k - 1] < vb[k + 1])) ? vb[k + 1] : vb[k - 1] + 1;
+        NSInteger py = px - k;
+        const NSInteger sx = px, sy = py;
+        while (px < n && py < m && _equal(aHi - px - 1, bHi - py - 1)) {
+          px++; py++;
+        }
+        vb[k] = px;
+        const NSInteger c = delta - k;
+        if (!odd && c >= -d && c <= d && vb[k] + vf[c] >= n) {
+          *x = n - px; *y = m - py; *u = n - sx; *v = m - sy;
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * Bottom-up memoized LCS over a single contiguous allocation. Ties are broken exactly as the original
+   * implementation did.
+   */
+  void matrix(NSInteger aLo, NSInteger aHi, NSInteger bLo, NSInteger bHi)
+  {
+    const NSInteger n = aHi - aLo, m = bHi - bLo, stride = m + 1;
+    if (n == 0 || m == 0) {
+      return;
+    }
+    _matrix.assign((n + 1) * stride, 0);
+    NSInteger *lengths = _matrix.data();
+    for (NSInteger i = 1; i <= n; i++) {
+      for (NSInteger j = 1; j <= m; j++) {
+        if (_equal(aLo + i - 1, bLo + j - 1)) {
+          lengths[i * stride + j] = 1 + lengths[(i - 1) * stride + j - 1];
+        } else {
+          lengths[i * stride + j] = MAX(lengths[(i - 1) * stride + j], lengths[i * stride + j - 1]);
+        }
+      }
+    }
+    const size_t start = _common.size();
+    NSInteger i = n, j = m;
+    while (i > 0 && j > 0) {
+      if (_equal(aLo + i - 1, bLo + j - 1)) {
+        _common.push_back(aLo + i - 1);
+        i--; j--;
+      } else if (lengths[(i - 1) * stride + j] > lengths[i * stride + j - 1]) {
+        i--;
+      } else {
+        j--;
+      }
+    }
+    std::reverse(_common.begin() + start, _common.end());
+  }
+};
+
 
 @implementation NSArray (Diffing)
 
@@ -54,13 +211,18 @@ typedef BOOL (^compareBlock)(id _Nonnull lhs, id _Nonnull rhs);
   if (moves) {
     moveIndexPaths = [NSMutableArray new];
   }
-  NSMutableIndexSet *commonIndexes = [self _asdk_commonIndexesWithArray:array compareBlock:comparison];
+  // Sorted indexes (into self) of the longest common subsequence.
+  std::vector<NSInteger> common;
+  [self _asdk_commonIndexes:common withArray:array compareBlock:comparison];
 
   if (deletions || moves) {
     deletionIndexes = [NSMutableIndexSet indexSet];
     NSUInteger i = 0;
+    auto nextCommon = common.begin();
     for (id element in self) {
-      if (![commonIndexes containsIndex:i]) {
+      if (nextCommon != common.end() && *nextCommon == (NSInteger)i) {
+        ++nextCommon;
+      } else {
         [deletionIndexes addIndex:i];
       }
       if (moves) {
@@ -72,25 +234,26 @@ typedef BOOL (^compareBlock)(id _Nonnull lhs, id _Nonnull rhs);
 
   if (insertions || moves) {
     insertionIndexes = [NSMutableIndexSet indexSet];
-    NSArray *commonObjects = [self objectsAtIndexes:commonIndexes];
-    for (NSUInteger i = 0, j = 0; j < array.count; j++) {
-      auto moveFound = potentialMoves.find(array[j]);
+    NSUInteger arrayCount = array.count;
+    for (NSUInteger i = 0, j = 0; j < arrayCount; j++) {
+      id arrayObject = array[j];
+      auto moveFound = potentialMoves.find(arrayObject);
       NSUInteger movedFrom = NSNotFound;
       if (moveFound != potentialMoves.end() && moveFound->second != j) {
         movedFrom = moveFound->second;
         potentialMoves.erase(moveFound);
         [moveIndexPaths addObject:[NSIndexPath indexPathForItem:j inSection:movedFrom]];
       }
-      if (i < commonObjects.count && j < array.count && comparison(commonObjects[i], array[j])) {
+      if (i < common.size() && comparison(self[common[i]], arrayObject)) {
         i++;
       } else {
         if (movedFrom != NSNotFound) {
           // moves will coalesce a delete / insert - the insert is just not done, and here we remove the delete:
           [deletionIndexes removeIndex:movedFrom];
           // OR a move will have come from the LCS:
-          if ([commonIndexes containsIndex:movedFrom]) {
-            [commonIndexes removeIndex:movedFrom];
-            commonObjects = [self objectsAtIndexes:commonIndexes];
+          auto commonFound = std::lower_bound(common.begin(), common.end(), (NSInteger)movedFrom);
+          if (commonFound != common.end() && *commonFound == (NSInteger)movedFrom) {
+            common.erase(commonFound);
           }
         } else {
           [insertionIndexes addIndex:j];
@@ -104,59 +267,42 @@ typedef BOOL (^compareBlock)(id _Nonnull lhs, id _Nonnull rhs);
   if (insertions) {*insertions = insertionIndexes;}
 }
 
-// https://github.com/raywenderlich/swift-algorithm-club/tree/master/Longest%20Common%20Subsequence is not exactly this code (obviously), but
-// is a good commentary on the algorithm.
 - (NSMutableIndexSet *)_asdk_commonIndexesWithArray:(NSArray *)array compareBlock:(BOOL (^)(id lhs, id rhs))comparison
+{
+  std::vector<NSInteger> common;
+  [self _asdk_commonIndexes:common withArray:array compareBlock:comparison];
+
+  NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+  for (NSInteger i : common) {
+    [indexes addIndex:i];
+  }
+  return indexes;
+}
+
+- (void)_asdk_commonIndexes:(std::vector<NSInteger> &)common withArray:(NSArray *)array compareBlock:(BOOL (^)(id lhs, id rhs))comparison
 {
   NSAssert(comparison != nil, @"Comparison block is required");
 
   NSInteger selfCount = self.count;
   NSInteger arrayCount = array.count;
 
-  // Allocate the diff map in the heap so we don't blow the stack for large arrays.
-  NSInteger **lengths = NULL;
-  lengths = (NSInteger **)malloc(sizeof(NSInteger*) * (selfCount+1));
-  if (lengths == NULL) {
-    ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
-    return nil;
-  }
-  // Fill in a LCS length matrix:
-  for (NSInteger i = 0; i <= selfCount; i++) {
-    lengths[i] = (NSInteger *)malloc(sizeof(NSInteger) * (arrayCount+1));
-    if (lengths[i] == NULL) {
-      ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
-      return nil;
-    }
-    id selfObj = i > 0 ? self[i-1] : nil;
-    for (NSInteger j = 0; j <= arrayCount; j++) {
-      if (i == 0 || j == 0) {
-        lengths[i][j] = 0;
-      } else if (comparison(selfObj, array[j-1])) {
-        lengths[i][j] = 1 + lengths[i-1][j-1];
-      } else {
-        lengths[i][j] = MAX(lengths[i-1][j], lengths[i][j-1]);
-      }
-    }
-  }
-  // Backtrack to fill in indices based on length matrix:
-  NSMutableIndexSet *common = [NSMutableIndexSet indexSet];
-  NSInteger i = selfCount, j = arrayCount;
-  while(i > 0 && j > 0) {
-    if (comparison(self[i-1], array[j-1])) {
-      [common addIndex:(i-1)];
-      i--; j--;
-    } else if (lengths[i-1][j] > lengths[i][j-1]) {
-      i--;
-    } else {
-      j--;
-    }
-  }
+  // Pull the objects out once so the inner loops don't message the arrays.
+  std::vector<unowned id> selfObjects(selfCount);
+  std::vector<unowned id> arrayObjects(arrayCount);
+  [self getObjects:selfObjects.data() range:NSMakeRange(0, selfCount)];
+  [array getObjects:arrayObjects.data() range:NSMakeRange(0, arrayCount)];
 
-  for (NSInteger i = 0; i <= selfCount; i++) {
-    free(lengths[i]);
-  }
-  free(lengths);
-  return common;
+  // -isEqual: must return YES for identical objects, so we can skip the block for those. A custom comparison
+  // makes no such promise.
+  BOOL isDefaultCompare = (comparison == [NSArray defaultCompareBlock]);
+  auto equal = [&](NSInteger i, NSInteger j) -> bool {
+    unowned id lhs = selfObjects[i];
+    unowned id rhs = arrayObjects[j];
+    return (isDefaultCompare && lhs == rhs) || comparison(lhs, rhs);
+  };
+
+  common.reserve(MIN(selfCount, arrayCount));
+  ASCommonSubsequence<decltype(equal)>(equal, common).compute(selfCount, arrayCount);
 }
 
 static compareBlock defaultCompare = nil;
@@ -12,15 +12,12 @@
 #import <AsyncDisplayKit/_ASAsyncTransactionGroup.h>
 #import <AsyncDisplayKit/ASAssert.h>
 #import <AsyncDisplayKit/ASThread.h>
-#import <list>
-#import <map>
+#import <AsyncDisplayKit/_ASAsyncTransactionQueue.h>
 
 #ifndef __STRICT_ANSI__
   #warning "Texture must be compiled with std=c++11 to prevent layout issues. gnu++ is not supported. This is hopefully temporary."
 #endif
 
-ASDK_EXTERN NSRunLoopMode const UITrackingRunLoopMode;
-
 NSInteger const ASDefaultTransactionPriority = 0;
 
 @interface ASAsyncTransactionOperation : NSObject
@@ -61,260 +58,6 @@ NSInteger const ASDefaultTransactionPriority = 0;
 
 @end
 
-// Lightweight operation queue for _ASAsyncTransaction that limits number of spawned threads
-class ASAsyncTransactionQueue
-{
-public:
-  
-  // Similar to dispatch_group_t
-  class Group
-  {
-  public:
-    // call when group is no longer needed; after last scheduled operation the group will delete itself
-    virtual void release() = 0;
-    
-    // schedule block on given queue
-    virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block) = 0;
-    
-    // dispatch block on given queue when all previously scheduled blocks finished executing
-    virtual void notify(dispatch_queue_t queue, dispatch_block_t block) = 0;
-    
-    // used when manually executing blocks
-    virtual void enter() = 0;
-    virtual void leave() = 0;
-    
-    // wait until all scheduled blocks finished executing
-    virtual void wait() = 0;
-    
-  protected:
-    virtual ~Group() { }; // call release() instead
-  };
-  
-  // Create new group
-  Group *createGroup();
-  
-  static ASAsyncTransactionQueue &instance();
-  
-private:
-  
-  struct GroupNotify
-  {
-    dispatch_block_t _block;
-    dispatch_queue_t _queue;
-  };
-  
-  class GroupImpl : public Group
-  {
-  public:
-    GroupImpl(ASAsyncTransactionQueue &queue)
-      : _pendingOperations(0)
-      , _releaseCalled(false)
-      , _queue(queue)
-    {
-    }
-    
-    virtual void release();
-    virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block);
-    virtual void notify(dispatch_queue_t queue, dispatch_block_t block);
-    virtual void enter();
-    virtual void leave();
-    virtual void wait();
-    
-    int _pendingOperations;
-    std::list<GroupNotify> _notifyList;
-    std::condition_variable _condition;
-    BOOL _releaseCalled;
-    ASAsyncTransactionQueue &_queue;
-  };
-  
-  struct Operation
-  {
-    dispatch_block_t _block;
-    GroupImpl *_group;
-    NSInteger _priority;
-  };
-    
-  struct DispatchEntry // entry for each dispatch queue
-  {
-    typedef std::list<Operation> OperationQueue;
-    typedef std::list<OperationQueue::iterator> OperationIteratorList; // each item points to operation queue
-    typedef std::map<NSInteger, OperationIteratorList> OperationPriorityMap; // sorted by priority
-
-    OperationQueue _operationQueue;
-    OperationPriorityMap _operationPriorityMap;
-    int _threadCount;
-      
-    Operation popNextOperation(bool respectPriority);  // assumes locked mutex
-    void pushOperation(Operation operation);           // assumes locked mutex
-  };
-  
-  std::map<dispatch_queue_t, DispatchEntry> _entries;
-  std::mutex _mutex;
-};
-
-ASAsyncTransactionQueue::Group* ASAsyncTransactionQueue::createGroup()
-{
-  Group *res = new GroupImpl(*this);
-  return res;
-}
-
-void ASAsyncTransactionQueue::GroupImpl::release()
-{
-  std::lock_guard<std::mutex> l(_queue._mutex);
-  
-  if (_pendingOperations == 0)  {
-    delete this;
-  } else {
-    _releaseCalled = YES;
-  }
-}
-
-ASAsyncTransactionQueue::Operation ASAsyncTransactionQueue::DispatchEntry::popNextOperation(bool respectPriority)
-{
-  NSCAssert(!_operationQueue.empty() && !_operationPriorityMap.empty(), @"No scheduled operations available");
-
-  OperationQueue::iterator queueIterator;
-  OperationPriorityMap::iterator mapIterator;
-  
-  if (respectPriority) {
-    mapIterator = --_operationPriorityMap.end();  // highest priority "bucket"
-    queueIterator = *mapIterator->second.begin();
-  } else {
-    queueIterator = _operationQueue.begin();
-    mapIterator = _operationPriorityMap.find(queueIterator->_priority);
-  }
-  
-  // no matter what, first item in "bucket" must match item in queue
-  NSCAssert(mapIterator->second.front() == queueIterator, @"Queue inconsistency");
-  
-  Operation res = *queueIterator;
-  _operationQueue.erase(queueIterator);
-  
-  mapIterator->second.pop_front();
-  if (mapIterator->second.empty()) {
-    _operationPriorityMap.erase(mapIterator);
-  }
-
-  return res;
-}
-
-void ASAsyncTransactionQueue::DispatchEntry::pushOperation(ASAsyncTransactionQueue::Operation operation)
-{
-  _operationQueue.push_back(operation);
-
-  OperationIteratorList &list = _operationPriorityMap[operation._priority];
-  list.push_back(--_operationQueue.end());
-}
-
-void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block)
-{
-  ASAsyncTransactionQueue &q = _queue;
-  std::lock_guard<std::mutex> l(q._mutex);
-  
-  DispatchEntry &entry = q._entries[queue];
-  
-  Operation operation;
-  operation._block = block;
-  operation._group = this;
-  operation._priority = priority;
-  entry.pushOperation(operation);
-  
-  ++_pendingOperations; // enter group
-  
-#if ASDISPLAYNODE_DELAY_DISPLAY
-  NSUInteger maxThreads = 1;
-#else 
-  NSUInteger maxThreads = [NSProcessInfo processInfo].activeProcessorCount * 2;
-
-  // Bit questionable maybe - we can give main thread more CPU time during tracking.
-  if ([[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode])
-    --maxThreads;
-#endif
-  
-  if (entry._threadCount < maxThreads) { // we need to spawn another thread
-
-    // first thread will take operations in queue order (regardless of priority), other threads will respect priority
-    bool respectPriority = entry._threadCount > 0;
-    ++entry._threadCount;
-    
-    dispatch_async(queue, ^{
-      std::unique_lock<std::mutex> lock(q._mutex);
-      
-      // go until there are no more pending operations
-      while (!entry._operationQueue.empty()) {
-        Operation operation = entry.popNextOperation(respectPriority);
-        lock.unlock();
-        if (operation._block) {
-          operation._block();
-        }
-        operation._group->leave();
-        operation._block = nil; // the block must be freed while mutex is unlocked
-        lock.lock();
-      }
-      --entry._threadCount;
-      
-      if (entry._threadCount == 0) {
-        NSCAssert(entry._operationQueue.empty() || entry._operationPriorityMap.empty(), @"No working threads but operations are still scheduled"); // this shouldn't happen
-        q._entries.erase(queue);
-      }
-    });
-  }
-}
-
-void ASAsyncTransactionQueue::GroupImpl::notify(dispatch_queue_t queue, dispatch_block_t block)
-{
-  std::lock_guard<std::mutex> l(_queue._mutex);
-
-  if (_pendingOperations == 0) {
-    dispatch_async(queue, block);
-  } else {
-    _notifyList.push_back({block, queue});
-  }
-}
-
-void ASAsyncTransactionQueue::GroupImpl::enter()
-{
-  std::lock_guard<std::mutex> l(_queue._mutex);
-  ++_pendingOperations;
-}
-
-void ASAsyncTransactionQueue::GroupImpl::leave()
-{
-  std::lock_guard<std::mutex> l(_queue._mutex);
-  --_pendingOperations;
-  
-  if (_pendingOperations == 0) {
-    std::list<GroupNotify> notifyList;
-    _notifyList.swap(notifyList);
-    
-    for (GroupNotify & notify : notifyList) {
-      dispatch_async(notify._queue, notify._block);
-    }
-    
-    _condition.notify_one();
-    
-    // there was attempt to release the group before, but we still
-    // had operations scheduled so now is good time
-    if (_releaseCalled) {
-      delete this;
-    }
-  }
-}
-
-void ASAsyncTransactionQueue::GroupImpl::wait()
-{
-  std::unique_lock<std::mutex> lock(_queue._mutex);
-  while (_pendingOperations > 0) {
-    _condition.wait(lock);
-  }
-}
-
-ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
-{
-  static ASAsyncTransactionQueue *instance = new ASAsyncTransactionQueue();
-  return *instance;
-}
-
 @interface _ASAsyncTransaction ()
 @property ASAsyncTransactionState state;
 @end
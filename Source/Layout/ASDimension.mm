@@ -10,6 +10,7 @@
 #import <AsyncDisplayKit/ASDimension.h>
 
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
+#import <AsyncDisplayKit/ASLayoutCoreBridging.h>
 
 #pragma mark - ASDimension
 
@@ -60,36 +61,10 @@ ASSizeRange const ASSizeRangeZero = {};
 
 ASSizeRange const ASSizeRangeUnconstrained = { {0, 0}, { INFINITY, INFINITY }};
 
-struct _Range {
-  CGFloat min;
-  CGFloat max;
-  
-  /**
-   Intersects another dimension range. If the other range does not overlap, this size range "wins" by returning a
-   single point within its own range that is closest to the non-overlapping range.
-   */
-  _Range intersect(const _Range &other) const
-  {
-  CGFloat newMin = MAX(min, other.min);
-  CGFloat newMax = MIN(max, other.max);
-  if (newMin <= newMax) {
-    return {newMin, newMax};
-  } else {
-    // No intersection. If we're before the other range, return our max; otherwise our min.
-    if (min < other.min) {
-      return {max, max};
-    } else {
-      return {min, min};
-    }
-  }
-  }
-};
-
 ASSizeRange ASSizeRangeIntersect(ASSizeRange sizeRange, ASSizeRange otherSizeRange)
 {
-  const auto w = _Range({sizeRange.min.width, sizeRange.max.width}).intersect({otherSizeRange.min.width, otherSizeRange.max.width});
-  const auto h = _Range({sizeRange.min.height, sizeRange.max.height}).intersect({otherSizeRange.min.height, otherSizeRange.max.height});
-  return {{w.min, h.min}, {w.max, h.max}};
+  return ASSizeRangeFromASLayoutCoreSizeRange(AS::LayoutCore::intersect(ASLayoutCoreSizeRangeFromASSizeRange(sizeRange),
+                                                                         ASLayoutCoreSizeRangeFromASSizeRange(otherSizeRange)));
 }
 
 NSString *NSStringFromASSizeRange(ASSizeRange sizeRange)
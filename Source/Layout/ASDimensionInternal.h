@@ -99,3 +99,77 @@ ASDISPLAYNODE_INLINE AS_WARN_UNUSED_RESULT ASSizeRange ASLayoutElementSizeResolv
 
 
 NS_ASSUME_NONNULL_END
+
+#pragma mark - Hashing
+
+#ifdef __cplusplus
+
+#import <AsyncDisplayKit/ASHashing.h>
+#import <functional>
+
+namespace AS {
+
+template <>
+struct HashTraits<ASDimension> {
+  static uint64_t hash(const ASDimension &dimension) { return hashFields(dimension.unit, dimension.value); }
+};
+
+template <>
+struct HashTraits<ASLayoutSize> {
+  static uint64_t hash(const ASLayoutSize &size) { return hashFields(size.width, size.height); }
+};
+
+template <>
+struct HashTraits<ASSizeRange> {
+  static uint64_t hash(const ASSizeRange &range) { return hashFields(range.min, range.max); }
+};
+
+template <>
+struct HashTraits<ASLayoutElementSize> {
+  static uint64_t hash(const ASLayoutElementSize &size)
+  {
+    return hashFields(size.width, size.height, size.minWidth, size.maxWidth, size.minHeight, size.maxHeight);
+  }
+};
+
+} // namespace AS
+
+/**
+ * Lets the structs be keys of unordered containers. Equality is the same as the ASxxxEqualToxxx functions.
+ */
+namespace std {
+
+template <> struct hash<ASDimension> : AS::Hash<ASDimension> {};
+template <> struct hash<ASLayoutSize> : AS::Hash<ASLayoutSize> {};
+template <> struct hash<ASSizeRange> : AS::Hash<ASSizeRange> {};
+template <> struct hash<ASLayoutElementSize> : AS::Hash<ASLayoutElementSize> {};
+
+template <>
+struct equal_to<ASDimension> {
+  bool operator()(const ASDimension &lhs, const ASDimension &rhs) const { return ASDimensionEqualToDimension(lhs, rhs); }
+};
+
+template <>
+struct equal_to<ASLayoutSize> {
+  bool operator()(const ASLayoutSize &lhs, const ASLayoutSize &rhs) const
+  {
+    return ASDimensionEqualToDimension(lhs.width, rhs.width) && ASDimensionEqualToDimension(lhs.height, rhs.height);
+  }
+};
+
+template <>
+struct equal_to<ASSizeRange> {
+  bool operator()(const ASSizeRange &lhs, const ASSizeRange &rhs) const { return ASSizeRangeEqualToSizeRange(lhs, rhs); }
+};
+
+template <>
+struct equal_to<ASLayoutElementSize> {
+  bool operator()(const ASLayoutElementSize &lhs, const ASLayoutElementSize &rhs) const
+  {
+    return ASLayoutElementSizeEqualToLayoutElementSize(lhs, rhs);
+  }
+};
+
+} // namespace std
+
+#endif
@@ -12,6 +12,7 @@
 #import <AsyncDisplayKit/ASLayoutSpec+Subclasses.h>
 
 #import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASLayoutCoreBridging.h>
 
 @interface ASInsetLayoutSpec ()
 {
@@ -19,24 +20,6 @@
 }
 @end
 
-/* Returns f if f is finite, substitute otherwise */
-static CGFloat finite(CGFloat f, CGFloat substitute)
-{
-  return isinf(f) ? substitute : f;
-}
-
-/* Returns f if f is finite, 0 otherwise */
-static CGFloat finiteOrZero(CGFloat f)
-{
-  return finite(f, 0);
-}
-
-/* Returns the inset required to center 'inner' in 'outer' */
-static CGFloat centerInset(CGFloat outer, CGFloat inner)
-{
-  return ASRoundPixelValue((outer - inner) / 2);
-}
-
 @implementation ASInsetLayoutSpec
 
 - (instancetype)initWithInsets:(UIEdgeInsets)insets child:(id<ASLayoutElement>)child
@@ -74,47 +57,16 @@ static CGFloat centerInset(CGFloat outer, CGFloat inner)
     return [ASLayout layoutWithLayoutElement:self size:CGSizeZero];
   }
   
-  const CGFloat insetsX = (finiteOrZero(_insets.left) + finiteOrZero(_insets.right));
-  const CGFloat insetsY = (finiteOrZero(_insets.top) + finiteOrZero(_insets.bottom));
-
-  // if either x-axis inset is infinite, let child be intrinsic width
-  const CGFloat minWidth = (isinf(_insets.left) || isinf(_insets.right)) ? 0 : constrainedSize.min.width;
-  // if either y-axis inset is infinite, let child be intrinsic height
-  const CGFloat minHeight = (isinf(_insets.top) || isinf(_insets.bottom)) ? 0 : constrainedSize.min.height;
-
-  const ASSizeRange insetConstrainedSize = {
-    {
-      MAX(0, minWidth - insetsX),
-      MAX(0, minHeight - insetsY),
-    },
-    {
-      MAX(0, constrainedSize.max.width - insetsX),
-      MAX(0, constrainedSize.max.height - insetsY),
-    }
-  };
-  
-  const CGSize insetParentSize = {
-    MAX(0, parentSize.width - insetsX),
-    MAX(0, parentSize.height - insetsY)
-  };
+  const AS::LayoutCore::SizeRange coreConstrainedSize = ASLayoutCoreSizeRangeFromASSizeRange(constrainedSize);
+  const AS::LayoutCore::EdgeInsets insets = ASLayoutCoreEdgeInsetsFromUIEdgeInsets(_insets);
+  const ASSizeRange insetConstrainedSize = ASSizeRangeFromASLayoutCoreSizeRange(AS::LayoutCore::insetChildSizeRange(coreConstrainedSize, insets));
+  const CGSize insetParentSize = CGSizeFromASLayoutCoreSize(AS::LayoutCore::insetChildParentSize(ASLayoutCoreSizeFromCGSize(parentSize), insets));
   
   ASLayout *sublayout = [self.child layoutThatFits:insetConstrainedSize parentSize:insetParentSize];
 
-  const CGSize computedSize = ASSizeRangeClamp(constrainedSize, {
-    finite(sublayout.size.width + _insets.left + _insets.right, constrainedSize.max.width),
-    finite(sublayout.size.height + _insets.top + _insets.bottom, constrainedSize.max.height),
-  });
-
-  const CGFloat x = finite(_insets.left, constrainedSize.max.width -
-                           (finite(_insets.right,
-                                   centerInset(constrainedSize.max.width, sublayout.size.width)) + sublayout.size.width));
-
-  const CGFloat y = finite(_insets.top,
-                           constrainedSize.max.height -
-                           (finite(_insets.bottom,
-                                   centerInset(constrainedSize.max.height, sublayout.size.height)) + sublayout.size.height));
-  
-  sublayout.position = CGPointMake(x, y);
+  const AS::LayoutCore::Size childSize = ASLayoutCoreSizeFromCGSize(sublayout.size);
+  const CGSize computedSize = CGSizeFromASLayoutCoreSize(AS::LayoutCore::insetSize(coreConstrainedSize, insets, childSize));
+  sublayout.position = CGPointFromASLayoutCorePoint(AS::LayoutCore::insetChildPosition(coreConstrainedSize, insets, childSize, ASScreenScale()));
   
   return [ASLayout layoutWithLayoutElement:self size:computedSize sublayouts:@[sublayout]];
 }
@@ -10,7 +10,7 @@
 #import <AsyncDisplayKit/ASLayout.h>
 
 #import <atomic>
-#import <queue>
+#import <vector>
 
 #import <AsyncDisplayKit/ASCollections.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
@@ -202,18 +202,25 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
     unowned ASLayout *layout;
     CGPoint absolutePosition;
   };
-  
-  // Queue used to keep track of sublayouts while traversing this layout in a DFS fashion.
-  std::deque<Context> queue;
-  for (ASLayout *sublayout in _sublayouts) {
-    queue.push_back({sublayout, sublayout.position});
-  }
-  
+
+  // Every layout pass on a layout thread flattens its result, so reuse the traversal stack and the flattened
+  // sublayouts buffer of the thread instead of allocating them per pass. They are swapped out while in use, so that a
+  // nested call on the same thread gets buffers of its own.
+  static thread_local std::vector<Context> threadStack;
+  static thread_local std::vector<ASLayout *> threadFlattenedSublayouts;
+  std::vector<Context> stack;
   std::vector<ASLayout *> flattenedSublayouts;
-  
-  while (!queue.empty()) {
-    const Context context = std::move(queue.front());
-    queue.pop_front();
+  stack.swap(threadStack);
+  flattenedSublayouts.swap(threadFlattenedSublayouts);
+
+  // Stack used to keep track of sublayouts while traversing this layout in a DFS fashion.
+  for (ASLayout *sublayout in _sublayouts.reverseObjectEnumerator) {
+    stack.push_back({sublayout, sublayout.position});
+  }
+
+  while (!stack.empty()) {
+    const Context context = stack.back();
+    stack.pop_back();
     
     unowned ASLayout *layout = context.layout;
     // Direct ivar access to avoid retain/release, use existing +1.
@@ -232,17 +239,21 @@ static std::atomic_bool static_retainsSublayoutLayoutElements = ATOMIC_VAR_INIT(
         flattenedSublayouts.push_back(layout);
       }
     } else if (sublayoutsCount > 0) {
-      // Fast-reverse-enumerate the sublayouts array by copying it into a C-array and push_front'ing each into the queue.
+      // Fast-reverse-enumerate the sublayouts array by copying it into a C-array and pushing each onto the stack, so
+      // that they are popped in order.
       unowned ASLayout *rawSublayouts[sublayoutsCount];
       [layout->_sublayouts getObjects:rawSublayouts range:NSMakeRange(0, sublayoutsCount)];
       for (NSInteger i = sublayoutsCount - 1; i >= 0; i--) {
-        queue.push_front({rawSublayouts[i], absolutePosition + rawSublayouts[i].position});
+        stack.push_back({rawSublayouts[i], absolutePosition + rawSublayouts[i].position});
       }
     }
   }
   
   NSArray *array = [NSArray arrayByTransferring:flattenedSublayouts.data() count:flattenedSublayouts.size()];
-  // flattenedSublayouts is now all nils.
+  // flattenedSublayouts is now all nils, clearing it keeps the storage for the next pass.
+  flattenedSublayouts.clear();
+  threadStack.swap(stack);
+  threadFlattenedSublayouts.swap(flattenedSublayouts);
   
   ASLayout *layout = [ASLayout layoutWithLayoutElement:_layoutElement size:_size sublayouts:array];
   // All flattened layouts must retain sublayout elements until they are applied.
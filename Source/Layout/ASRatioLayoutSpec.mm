@@ -9,13 +9,12 @@
 
 #import <AsyncDisplayKit/ASRatioLayoutSpec.h>
 
-#import <algorithm>
 #import <tgmath.h>
-#import <vector>
 
 #import <AsyncDisplayKit/ASLayoutSpec+Subclasses.h>
 
 #import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASLayoutCoreBridging.h>
 
 #pragma mark - ASRatioLayoutSpec
 
@@ -57,30 +56,13 @@
 
 - (ASLayout *)calculateLayoutThatFits:(ASSizeRange)constrainedSize
 {
-  std::vector<CGSize> sizeOptions;
-  
-  if (ASPointsValidForSize(constrainedSize.max.width)) {
-    sizeOptions.push_back(ASSizeRangeClamp(constrainedSize, {
-      constrainedSize.max.width,
-      ASFloorPixelValue(_ratio * constrainedSize.max.width)
-    }));
-  }
-  
-  if (ASPointsValidForSize(constrainedSize.max.height)) {
-    sizeOptions.push_back(ASSizeRangeClamp(constrainedSize, {
-      ASFloorPixelValue(constrainedSize.max.height / _ratio),
-      constrainedSize.max.height
-    }));
-  }
-
-  // Choose the size closest to the desired ratio.
-  const auto &bestSize = std::max_element(sizeOptions.begin(), sizeOptions.end(), [&](const CGSize &a, const CGSize &b){
-    return std::fabs((a.height / a.width) - _ratio) > std::fabs((b.height / b.width) - _ratio);
-  });
+  AS::LayoutCore::Size bestSize;
+  const bool hasBestSize = AS::LayoutCore::ratioChildSize(ASLayoutCoreSizeRangeFromASSizeRange(constrainedSize), _ratio, ASScreenScale(), bestSize);
 
   // If there is no max size in *either* dimension, we can't apply the ratio, so just pass our size range through.
-  const ASSizeRange childRange = (bestSize == sizeOptions.end()) ? constrainedSize : ASSizeRangeIntersect(constrainedSize, ASSizeRangeMake(*bestSize, *bestSize));
-  const CGSize parentSize = (bestSize == sizeOptions.end()) ? ASLayoutElementParentSizeUndefined : *bestSize;
+  const CGSize childSize = CGSizeFromASLayoutCoreSize(bestSize);
+  const ASSizeRange childRange = hasBestSize ? ASSizeRangeIntersect(constrainedSize, ASSizeRangeMake(childSize, childSize)) : constrainedSize;
+  const CGSize parentSize = hasBestSize ? childSize : ASLayoutElementParentSizeUndefined;
   ASLayout *sublayout = [self.child layoutThatFits:childRange parentSize:parentSize];
   sublayout.position = CGPointZero;
   return [ASLayout layoutWithLayoutElement:self size:sublayout.size sublayouts:@[sublayout]];
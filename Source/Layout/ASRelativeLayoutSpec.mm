@@ -12,6 +12,7 @@
 #import <AsyncDisplayKit/ASLayoutSpec+Subclasses.h>
 
 #import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASLayoutCoreBridging.h>
 
 @implementation ASRelativeLayoutSpec
 
@@ -52,53 +53,21 @@
 
 - (ASLayout *)calculateLayoutThatFits:(ASSizeRange)constrainedSize
 {
-  // If we have a finite size in any direction, pass this so that the child can resolve percentages against it.
-  // Otherwise pass ASLayoutElementParentDimensionUndefined as the size will depend on the content
-  CGSize size = {
-    ASPointsValidForSize(constrainedSize.max.width) == NO ? ASLayoutElementParentDimensionUndefined : constrainedSize.max.width,
-    ASPointsValidForSize(constrainedSize.max.height) == NO ? ASLayoutElementParentDimensionUndefined : constrainedSize.max.height
-  };
-  
-  // Layout the child
-  const CGSize minChildSize = {
-    (_horizontalPosition != ASRelativeLayoutSpecPositionNone) ? 0 : constrainedSize.min.width,
-    (_verticalPosition != ASRelativeLayoutSpecPositionNone) ? 0 : constrainedSize.min.height,
-  };
-  ASLayout *sublayout = [self.child layoutThatFits:ASSizeRangeMake(minChildSize, constrainedSize.max) parentSize:size];
-  
-  // If we have an undetermined height or width, use the child size to define the layout size
-  size = ASSizeRangeClamp(constrainedSize, {
-    isfinite(size.width) == NO ? sublayout.size.width : size.width,
-    isfinite(size.height) == NO ? sublayout.size.height : size.height
-  });
-  
-  // If minimum size options are set, attempt to shrink the size to the size of the child
-  size = ASSizeRangeClamp(constrainedSize, {
-    MIN(size.width, (_sizingOption & ASRelativeLayoutSpecSizingOptionMinimumWidth) != 0 ? sublayout.size.width : size.width),
-    MIN(size.height, (_sizingOption & ASRelativeLayoutSpecSizingOptionMinimumHeight) != 0 ? sublayout.size.height : size.height)
-  });
-  
-  // Compute the position for the child on each axis according to layout parameters
-  CGFloat xPosition = [self proportionOfAxisForAxisPosition:_horizontalPosition];
-  CGFloat yPosition = [self proportionOfAxisForAxisPosition:_verticalPosition];
-  
-  sublayout.position = {
-    ASRoundPixelValue((size.width - sublayout.size.width) * xPosition),
-    ASRoundPixelValue((size.height - sublayout.size.height) * yPosition)
-  };
-  
-  return [ASLayout layoutWithLayoutElement:self size:size sublayouts:@[sublayout]];
-}
+  const auto horizontalPosition = static_cast<AS::LayoutCore::RelativePosition>(_horizontalPosition);
+  const auto verticalPosition = static_cast<AS::LayoutCore::RelativePosition>(_verticalPosition);
+  const AS::LayoutCore::SizeRange coreConstrainedSize = ASLayoutCoreSizeRangeFromASSizeRange(constrainedSize);
 
-- (CGFloat)proportionOfAxisForAxisPosition:(ASRelativeLayoutSpecPosition)position
-{
-  if (position == ASRelativeLayoutSpecPositionCenter) {
-    return 0.5f;
-  } else if (position == ASRelativeLayoutSpecPositionEnd) {
-    return 1.0f;
-  } else {
-    return 0.0f;
-  }
+  // Layout the child. If we have a finite size in any direction, pass this so that the child can resolve percentages
+  // against it. Otherwise pass ASLayoutElementParentDimensionUndefined as the size will depend on the content.
+  ASLayout *sublayout = [self.child layoutThatFits:ASSizeRangeFromASLayoutCoreSizeRange(AS::LayoutCore::relativeChildSizeRange(coreConstrainedSize, horizontalPosition, verticalPosition))
+                                        parentSize:CGSizeFromASLayoutCoreSize(AS::LayoutCore::relativeChildParentSize(coreConstrainedSize))];
+
+  // Use the child size for undetermined or minimum dimensions, then position the child according to layout parameters
+  const AS::LayoutCore::Size childSize = ASLayoutCoreSizeFromCGSize(sublayout.size);
+  const AS::LayoutCore::Size size = AS::LayoutCore::relativeSize(coreConstrainedSize, (unsigned)_sizingOption, childSize);
+  sublayout.position = CGPointFromASLayoutCorePoint(AS::LayoutCore::relativeChildPosition(size, childSize, horizontalPosition, verticalPosition, ASScreenScale()));
+  
+  return [ASLayout layoutWithLayoutElement:self size:CGSizeFromASLayoutCoreSize(size) sublayouts:@[sublayout]];
 }
 
 @end
@@ -13,13 +13,19 @@
 #import <vector>
 
 #import <AsyncDisplayKit/ASCollections.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
 #import <AsyncDisplayKit/ASLog.h>
 #import <AsyncDisplayKit/ASStackPositionedLayout.h>
+#import <AsyncDisplayKit/ASThread.h>
 
-@implementation ASStackLayoutSpec
+@implementation ASStackLayoutSpec {
+  // Child layouts from the previous pass, see ASExperimentalIncrementalStackLayout.
+  AS::Mutex _childMemosLock;
+  std::vector<ASStackLayoutSpecChildMemo> _childMemos;
+}
 
 - (instancetype)init
 {
@@ -133,17 +139,43 @@
  
   as_activity_scope_verbose(as_activity_create("Calculate stack layout", AS_ACTIVITY_CURRENT, OS_ACTIVITY_FLAG_DEFAULT));
   as_log_verbose(ASLayoutLog(), "Stack layout %@", self);
+  // When laying out incrementally, take the layouts of the previous pass so that children whose constrained size and
+  // layout version are unchanged are not measured again and only flexing and positioning are redone. The memos are
+  // moved out while we lay out, a concurrent pass on the same spec will simply measure everything.
+  const BOOL incremental = ASActivateExperimentalFeature(ASExperimentalIncrementalStackLayout);
+  std::vector<ASStackLayoutSpecChildMemo> childMemos;
+  if (incremental) {
+    {
+      AS::MutexLocker l(_childMemosLock);
+      childMemos.swap(_childMemos);
+    }
+    childMemos.resize(children.count);
+  }
+
   // Accessing the style and size property is pretty costly we create layout spec children we use to figure
   // out the layout for each child
+  NSUInteger childIndex = 0;
   const auto stackChildren = AS::map(children, [&](const id<ASLayoutElement> child) -> ASStackLayoutSpecChild {
     ASLayoutElementStyle *style = child.style;
-    return {child, style, style.size};
+    ASStackLayoutSpecChildMemo *memo = NULL;
+    if (incremental) {
+      memo = &childMemos[childIndex++];
+      if (memo->element != child) {
+        *memo = {child};
+      }
+    }
+    return {child, style, style.size, memo};
   });
   
   const ASStackLayoutSpecStyle style = {.direction = _direction, .spacing = _spacing, .justifyContent = _justifyContent, .alignItems = _alignItems, .flexWrap = _flexWrap, .alignContent = _alignContent, .lineSpacing = _lineSpacing};
   
   const auto unpositionedLayout = ASStackUnpositionedLayout::compute(stackChildren, style, constrainedSize, _concurrent);
   const auto positionedLayout = ASStackPositionedLayout::compute(unpositionedLayout, style, constrainedSize);
+
+  if (incremental) {
+    AS::MutexLocker l(_childMemosLock);
+    _childMemos.swap(childMemos);
+  }
   
   if (style.direction == ASStackLayoutDirectionVertical) {
     self.style.ascender = stackChildren.front().style.ascender;
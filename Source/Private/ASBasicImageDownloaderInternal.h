@@ -7,14 +7,23 @@
 //  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
 //
 
-@interface ASBasicImageDownloaderContext : NSObject
+#import <AsyncDisplayKit/ASBasicImageDownloader.h>
 
-+ (ASBasicImageDownloaderContext *)contextForURL:(NSURL *)URL;
+@interface ASBasicImageDownloaderContext : NSObject
 
 @property (nonatomic, readonly) NSURL *URL;
-@property (nonatomic, weak) NSURLSessionTask *sessionTask;
+@property (atomic) id<ASImageDownloadTask> downloadTask;
 
 - (BOOL)isCancelled;
 - (void)cancel;
 
 @end
+
+@interface ASBasicImageDownloader (Internal)
+
+/**
+ * The context of the download of URL. Requests for the same URL share it until the download finishes or is stopped.
+ */
+- (ASBasicImageDownloaderContext *)contextForURL:(NSURL *)URL;
+
+@end
@@ -55,6 +55,18 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, readonly) BOOL shouldUseUIKitCell;
 
+/**
+ * Whether the cell finished displaying since it last entered the display range. Cells that have nothing to draw count
+ * as displayed once a frame has passed without any display pending. Main thread only.
+ */
+@property (nonatomic, readonly) BOOL hasDisplayedContents;
+
+/**
+ * The time from the cell entering the display range until its hierarchy finished displaying, or 0 if that hasn't
+ * happened since the range controller last reset it. Main thread only.
+ */
+@property (nonatomic) CFTimeInterval unreportedDisplayDuration;
+
 @end
 
 @class ASWrapperCellNode;
@@ -22,7 +22,6 @@
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
-#import <AsyncDisplayKit/ASPageTable.h>
 
 static const ASRangeTuningParameters kASDefaultMeasureRangeTuningParameters = {
   .leadingBufferScreenfuls = 2.0,
@@ -296,39 +295,21 @@ static const ASScrollDirection kASStaticScrollDirection = (ASScrollDirectionRigh
   }
 
   // Step 2: Get layout attributes of all elements within the specified outer rect
-  ASPageToLayoutAttributesTable *attrsTable = [layout getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:rect];
-  if (attrsTable.count == 0) {
+  NSArray<UICollectionViewLayoutAttributes *> *attrsInRect = [layout getAndRemoveUnmeasuredLayoutAttributesInRect:rect];
+  if (attrsInRect.count == 0) {
     // No elements in this rect! Bail early
     return;
   }
 
   // Step 3: Split all those attributes into blocking and non-blocking buckets
-  // Use ordered sets here because some items may span multiple pages, and the sets will be accessed by indexes later on.
   ASCollectionLayoutContext *context = layout.context;
-  CGSize pageSize = context.viewportSize;
-  NSMutableOrderedSet<UICollectionViewLayoutAttributes *> *blockingAttrs = hasBlockingRect ? [NSMutableOrderedSet orderedSet] : nil;
-  NSMutableOrderedSet<UICollectionViewLayoutAttributes *> *nonBlockingAttrs = [NSMutableOrderedSet orderedSet];
-  for (id pagePtr in attrsTable) {
-    ASPageCoordinate page = (ASPageCoordinate)pagePtr;
-    NSArray<UICollectionViewLayoutAttributes *> *attrsInPage = [attrsTable objectForPage:page];
-    // Calculate the page's rect but only if it's going to be used.
-    CGRect pageRect = hasBlockingRect ? ASPageCoordinateGetPageRect(page, pageSize) : CGRectZero;
-
-    if (hasBlockingRect && CGRectContainsRect(blockingRect, pageRect)) {
-      // The page fits well within the blocking rect. All attributes in this page are blocking.
-      [blockingAttrs addObjectsFromArray:attrsInPage];
-    } else if (hasBlockingRect && CGRectIntersectsRect(blockingRect, pageRect)) {
-      // The page intersects the blocking rect. Some elements in this page are blocking, some are not.
-      for (UICollectionViewLayoutAttributes *attrs in attrsInPage) {
-        if (CGRectIntersectsRect(blockingRect, attrs.frame)) {
-          [blockingAttrs addObject:attrs];
-        } else {
-          [nonBlockingAttrs addObject:attrs];
-        }
-      }
+  NSMutableArray<UICollectionViewLayoutAttributes *> *blockingAttrs = hasBlockingRect ? [[NSMutableArray alloc] init] : nil;
+  NSMutableArray<UICollectionViewLayoutAttributes *> *nonBlockingAttrs = [[NSMutableArray alloc] init];
+  for (UICollectionViewLayoutAttributes *attrs in attrsInRect) {
+    if (hasBlockingRect && CGRectIntersectsRect(blockingRect, attrs.frame)) {
+      [blockingAttrs addObject:attrs];
     } else {
-      // The page doesn't intersect the blocking rect. All elements in this page are non-blocking.
-      [nonBlockingAttrs addObjectsFromArray:attrsInPage];
+      [nonBlockingAttrs addObject:attrs];
     }
   }
 
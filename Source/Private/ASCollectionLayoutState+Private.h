@@ -7,7 +7,6 @@
 //
 
 #import <AsyncDisplayKit/ASCollectionLayoutState.h>
-#import <AsyncDisplayKit/ASPageTable.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -18,7 +17,7 @@ NS_ASSUME_NONNULL_BEGIN
  *
  * @discussion This method is atomic and thread-safe
  */
-- (nullable ASPageToLayoutAttributesTable *)getAndRemoveUnmeasuredLayoutAttributesPageTableInRect:(CGRect)rect;
+- (nullable NSArray<UICollectionViewLayoutAttributes *> *)getAndRemoveUnmeasuredLayoutAttributesInRect:(CGRect)rect;
 
 @end
 
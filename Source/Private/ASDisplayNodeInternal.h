@@ -13,6 +13,8 @@
 //
 
 #import <atomic>
+#import <memory>
+#import <vector>
 #import <AsyncDisplayKit/ASDisplayNode.h>
 #import <AsyncDisplayKit/ASDisplayNode+Beta.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
@@ -57,6 +59,25 @@ typedef NS_OPTIONS(uint_least32_t, ASDisplayNodeAtomicFlags)
 // Can be called without the node's lock. Client is responsible for thread safety.
 #define _loaded(node) (node->_layer != nil)
 
+/**
+ * A node in the pre-ordered subtree snapshot that -recursivelySetInterfaceState: applies states to with
+ * exp_interface_state_snapshot. The snapshot follows subnodes, and is taken again once a node in it has different
+ * subnodes or one of the layers it visited has a different number of sublayers.
+ */
+struct ASInterfaceStateSnapshotEntry {
+  /// Weak, so that the snapshot doesn't keep removed subnodes alive or retain its own node. A deallocated node makes
+  /// the snapshot out of date.
+  __weak ASDisplayNode *node;
+  /// The node's _subnodesVersion.
+  NSUInteger subnodesVersion;
+  /// The number of sublayers of the node's layer, or -1 if it wasn't loaded or its subtree is rasterized, in which
+  /// case its sublayers are not visited.
+  NSInteger sublayerCount;
+  /// Whether the node's layer has sublayers that don't belong to its subnodes, e.g. the cells of a collection node.
+  /// Those aren't part of the snapshot and are visited whenever it is used.
+  BOOL hasForeignSublayers;
+};
+
 #define checkFlag(flag) ((_atomicFlags.load() & flag) != 0)
 // Returns the old value of the flag as a BOOL.
 #define setFlag(flag, x) (((x ? _atomicFlags.fetch_or(flag) \
@@ -162,6 +183,10 @@ static constexpr CACornerMask kASCACornerAllCorners =
 
   // Set this to nil whenever you modify _subnodes
   NSArray<ASDisplayNode *> *_cachedSubnodes;
+  // Increment this whenever you modify _subnodes
+  NSUInteger _subnodesVersion;
+  // Main thread only, see ASInterfaceStateSnapshotEntry.
+  std::unique_ptr<std::vector<ASInterfaceStateSnapshotEntry>> _interfaceStateSnapshot;
 
   std::atomic_uint _displaySentinel;
 
@@ -198,6 +223,8 @@ static constexpr CACornerMask kASCACornerAllCorners =
   ASLayoutTransition *_pendingLayoutTransition;
   ASDisplayNodeLayout _calculatedDisplayNodeLayout;
   ASDisplayNodeLayout _pendingDisplayNodeLayout;
+  /// Earlier layouts for other size ranges, created on first use with exp_node_layout_cache.
+  std::unique_ptr<ASDisplayNodeLayoutCache> _layoutCache;
   
   /// Sentinel for layout data. Incremented when we get -setNeedsLayout / -invalidateCalculatedLayout.
   /// Starts at 1.
@@ -346,6 +373,9 @@ static constexpr CACornerMask kASCACornerAllCorners =
 
 - (void)applyPendingViewState;
 
+/// The changesMask of the pending view state, 0 if there is none.
+- (uint64_t)pendingViewStateChangesMask;
+
 /**
  * Makes a local copy of the interface state delegates then calls the block on each.
  *
@@ -399,6 +429,11 @@ static constexpr CACornerMask kASCACornerAllCorners =
  */
 - (id<ASLayoutElement>)_locked_layoutElementThatFits:(ASSizeRange)constrainedSize;
 
+/**
+ * Returns the current layout version, which is incremented on -setNeedsLayout. Does not take the lock.
+ */
+- (NSUInteger)layoutVersion;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -9,9 +9,10 @@
 
 #pragma once
 
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASConfiguration.h>
 #import <AsyncDisplayKit/ASDimension.h>
-
-@class ASLayout;
+#import <AsyncDisplayKit/ASLayout.h>
 
 /*
  * Represents a connection between an ASLayout and a ASDisplayNode
@@ -56,3 +57,114 @@ struct ASDisplayNodeLayout {
     && ASSizeRangeEqualToSizeRange(constrainedSize, theConstrainedSize);
   }
 };
+
+/*
+ * A few layouts of a node for different size ranges, in addition to its calculated and pending layouts, so that
+ * a node that is measured at alternating size ranges (e.g. at its intrinsic size and then stretched by a stack) is not
+ * measured again each time. Enabled by exp_node_layout_cache.
+ *
+ * Entries are evicted with the clock algorithm: each entry has a referenced bit that is set when it is used, and the
+ * hand skips and clears referenced entries when looking for one to replace.
+ */
+struct ASDisplayNodeLayoutCache {
+  static const NSUInteger kCapacity = 4;
+
+  ASDisplayNodeLayoutCache() : _referenced{}, _hand(0) {};
+
+  /*
+   * Returns the entry for the given constrained size, parent size and version, or NULL.
+   *
+   * @param allowFitting Whether an entry measured for another size range can be returned if only the width bounds
+   * differ and its layout already satisfies the new range. This assumes that a node doesn't lay out differently with
+   * less room as long as its layout still fits, which holds for wrapping text.
+   * @param outFitting Set to whether the returned entry was measured for another size range.
+   */
+  const ASDisplayNodeLayout *find(ASSizeRange constrainedSize, CGSize parentSize, NSUInteger version, BOOL allowFitting, BOOL *outFitting) {
+    for (NSUInteger i = 0; i < kCapacity; i++) {
+      if (_entries[i].isValid(constrainedSize, parentSize, version)) {
+        _referenced[i] = YES;
+        *outFitting = NO;
+        return &_entries[i];
+      }
+    }
+    if (allowFitting) {
+      for (NSUInteger i = 0; i < kCapacity; i++) {
+        if (_entries[i].isValid(version) && fits(_entries[i], constrainedSize, parentSize)) {
+          _referenced[i] = YES;
+          *outFitting = YES;
+          return &_entries[i];
+        }
+      }
+    }
+    return NULL;
+  }
+
+  /*
+   * Adds the layout, replacing an entry for the same constrained and parent size or an outdated one if there is one.
+   */
+  void insert(const ASDisplayNodeLayout &layout) {
+    NSUInteger slot = kCapacity;
+    for (NSUInteger i = 0; i < kCapacity && slot == kCapacity; i++) {
+      const ASDisplayNodeLayout &entry = _entries[i];
+      if (entry.layout == nil || entry.version < layout.version
+          || (CGSizeEqualToSize(entry.parentSize, layout.parentSize) && ASSizeRangeEqualToSizeRange(entry.constrainedSize, layout.constrainedSize))) {
+        slot = i;
+      }
+    }
+    while (slot == kCapacity) {
+      if (_referenced[_hand]) {
+        _referenced[_hand] = NO;
+      } else {
+        slot = _hand;
+      }
+      _hand = (_hand + 1) % kCapacity;
+    }
+    _entries[slot] = layout;
+    _referenced[slot] = YES;
+  }
+
+  void clear() {
+    for (NSUInteger i = 0; i < kCapacity; i++) {
+      _entries[i] = ASDisplayNodeLayout();
+      _referenced[i] = NO;
+    }
+  }
+
+  /*
+   * Removes all entries and returns their layouts, so that they can be released elsewhere.
+   */
+  NSArray<ASLayout *> *takeLayouts() {
+    NSMutableArray<ASLayout *> *layouts = [[NSMutableArray alloc] initWithCapacity:kCapacity];
+    for (NSUInteger i = 0; i < kCapacity; i++) {
+      if (_entries[i].layout != nil) {
+        [layouts addObject:_entries[i].layout];
+      }
+    }
+    clear();
+    return layouts;
+  }
+
+private:
+  static BOOL fits(const ASDisplayNodeLayout &entry, ASSizeRange constrainedSize, CGSize parentSize) {
+    const ASSizeRange &measured = entry.constrainedSize;
+    const CGFloat width = entry.layout.size.width;
+    const CGFloat height = entry.layout.size.height;
+    return CGSizeEqualToSize(entry.parentSize, parentSize)
+    && measured.min.height == constrainedSize.min.height && measured.max.height == constrainedSize.max.height
+    && width >= constrainedSize.min.width && width <= constrainedSize.max.width
+    && height >= constrainedSize.min.height && height <= constrainedSize.max.height
+    // More room could change the layout, e.g. unwrap text, so the maximum width may only shrink. The layout must not
+    // have been clamped to a minimum width that changed.
+    && constrainedSize.max.width <= measured.max.width
+    && (width > measured.min.width || measured.min.width == constrainedSize.min.width);
+  }
+
+  ASDisplayNodeLayout _entries[kCapacity];
+  BOOL _referenced[kCapacity];
+  NSUInteger _hand;
+};
+
+/**
+ * The counters of all per-node layout caches.
+ */
+ASDK_EXTERN ASNodeLayoutCacheStatistics ASDisplayNodeLayoutCacheGetStatistics(void);
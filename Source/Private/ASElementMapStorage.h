@@ -0,0 +1,115 @@
+//
+//  ASElementMapStorage.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASCollectionElement.h>
+#import <AsyncDisplayKit/ASDimension.h>
+#import <AsyncDisplayKit/ASElementMap.h>
+#import <AsyncDisplayKit/ASMutableElementMap.h>
+
+#import <memory>
+#import <vector>
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace AS {
+
+/**
+ * The items of one section, in order. Items that aren't materialized yet are nil, the map hands out placeholders of
+ * the section's placeholder size for them.
+ */
+struct ElementSection {
+  std::vector<ASCollectionElement *> items;
+  ASSizeRange placeholderSize = {};
+  NSInteger placeholderCount = 0;
+};
+
+/**
+ * A supplementary element and its index path.
+ */
+struct SupplementaryElement {
+  NSInteger section;
+  NSInteger item;
+  ASCollectionElement *element;
+
+  bool operator<(const SupplementaryElement &other) const
+  {
+    return section < other.section || (section == other.section && item < other.item);
+  }
+};
+
+/**
+ * The supplementary elements of one kind, sorted by index path.
+ */
+typedef std::vector<SupplementaryElement> SupplementaryElements;
+
+struct SupplementaryKind {
+  NSString *kind;
+  std::shared_ptr<SupplementaryElements> elements;
+};
+
+/**
+ * The contents of an element map.
+ *
+ * Element maps share the item sections and supplementary kinds they didn't change: copying a map only copies the
+ * tables that point at them, so it is O(sections + kinds) rather than O(elements). Shared storage is never modified,
+ * a mutable map copies a section or a kind before its first change to it, see ASMutableElementMap.
+ */
+struct ElementMapStorage {
+  std::vector<ASSection *> sections;
+  std::vector<std::shared_ptr<ElementSection>> itemSections;
+  std::vector<SupplementaryKind> supplementaryKinds;
+
+  /** Returns the elements of the kind, or nullptr if there are none. */
+  const SupplementaryElements *supplementaryElements(NSString *kind) const
+  {
+    for (const auto &supplementaryKind : supplementaryKinds) {
+      if ([supplementaryKind.kind isEqualToString:kind]) {
+        return supplementaryKind.elements.get();
+      }
+    }
+    return nullptr;
+  }
+};
+
+} // namespace AS
+
+@interface ASElementMap (Storage)
+
+- (instancetype)initWithStorage:(const AS::ElementMapStorage &)storage;
+
+- (const AS::ElementMapStorage &)storage;
+
+@end
+
+@interface ASMutableElementMap (Storage)
+
+- (instancetype)initWithStorage:(const AS::ElementMapStorage &)storage;
+
+@end
+
+@interface ASCollectionElement (Placeholder)
+
+/**
+ * Creates the placeholder for the unmaterialized item at the given location of the map with the given identifier.
+ */
+- (instancetype)initPlaceholderWithConstrainedSize:(ASSizeRange)constrainedSize
+                                     mapIdentifier:(uint64_t)mapIdentifier
+                                           section:(NSInteger)section
+                                              item:(NSInteger)item;
+
+/**
+ * Returns whether the receiver is a placeholder of the map with the given identifier, and where it is in the map.
+ */
+- (BOOL)isPlaceholderInMapWithIdentifier:(uint64_t)mapIdentifier section:(out NSInteger *)section item:(out NSInteger *)item;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,58 @@
+//
+//  ASImageContentsCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <UIKit/UIKit.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASConfiguration.h>
+#import <AsyncDisplayKit/ASWeakMap.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The budget used when the configuration doesn't specify `imageContentsCacheByteLimit`.
+ */
+ASDK_EXTERN NSUInteger const ASImageContentsCacheDefaultByteLimit;
+
+/**
+ * Returns the cached contents for the given key, or renders and caches them. Returns nil if rendering returned nil,
+ * which means that it was cancelled.
+ *
+ * The cache has two tiers. A weak map holds every contents that some node retains the returned entry of, and a strong
+ * tier keeps the most recently used entries alive after their nodes let go of them, until their decoded bitmaps exceed
+ * the byte budget. So cells that scroll out of the display range and back don't draw their images again.
+ *
+ * Rendering happens outside of the lock. A thread that misses a key that another thread is rendering waits for it
+ * instead of drawing the same contents. If that render is cancelled, the waiting thread renders the contents itself.
+ *
+ * The key must implement `hash` and `isEqual:`, and is retained by the cache for as long as its entry is.
+ */
+ASDK_EXTERN ASWeakMapEntry<UIImage *> * _Nullable ASImageContentsCacheGetEntry(id key, UIImage * _Nullable (NS_NOESCAPE ^render)(void));
+
+/**
+ * The number of bytes of the decoded bitmap of an image. Used to charge entries against the byte budget.
+ */
+ASDK_EXTERN NSUInteger ASImageContentsCacheEstimatedCost(UIImage *image);
+
+/**
+ * Changes the byte budget of the strong tier, evicting the least recently used entries if needed. The budget is read
+ * from the configuration the first time contents are cached.
+ */
+ASDK_EXTERN void ASImageContentsCacheSetByteLimit(NSUInteger byteLimit);
+
+/**
+ * Empties the strong tier. Contents that nodes still use stay in the weak tier. Called when a range controller enters
+ * ASLayoutRangeModeLowMemory, and on memory warnings. Counters are not reset.
+ */
+ASDK_EXTERN void ASImageContentsCacheTrim(void);
+
+/**
+ * A snapshot of the cache counters.
+ */
+ASDK_EXTERN ASImageContentsCacheStatistics ASImageContentsCacheGetStatistics(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,216 @@
+//
+//  ASImageContentsCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASImageContentsCache.h>
+
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+#import <condition_variable>
+#import <list>
+#import <mutex>
+#import <unordered_map>
+#import <vector>
+
+NSUInteger const ASImageContentsCacheDefaultByteLimit = 16 * 1024 * 1024;
+
+/**
+ * Contents that a thread is rendering. Threads that miss the same key wait for it instead of rendering it again.
+ */
+@interface ASImageContentsCachePendingEntry : NSObject {
+@package
+  ASWeakMapEntry<UIImage *> *_entry; // nil if the render was cancelled.
+  BOOL _finished;
+}
+@end
+
+@implementation ASImageContentsCachePendingEntry
+@end
+
+namespace {
+
+struct ASImageContentsCacheStrongEntry {
+  ASWeakMapEntry<UIImage *> *entry;
+  NSUInteger cost;
+};
+
+class ASImageContentsCache {
+public:
+  explicit ASImageContentsCache(NSUInteger byteLimit)
+      : _byteLimit(byteLimit), _cost(0), _hits(0), _misses(0), _sharedMisses(0), _evictions(0)
+  {
+    _weakEntries = [[ASWeakMap alloc] init];
+    // Keys don't have to implement NSCopying, so not a dictionary.
+    _pendingEntries = [NSMapTable strongToStrongObjectsMapTable];
+  }
+
+  ASWeakMapEntry<UIImage *> *entry(id key, UIImage *(NS_NOESCAPE ^render)(void))
+  {
+    std::unique_lock<std::mutex> l(_mutex);
+    ASImageContentsCachePendingEntry *pending;
+    while (true) {
+      if (ASWeakMapEntry<UIImage *> *entry = [_weakEntries entryForKey:key]) {
+        _hits++;
+        std::vector<ASWeakMapEntry *> evicted;
+        use(entry, evicted);
+        l.unlock();
+        return entry;
+      }
+      pending = [_pendingEntries objectForKey:key];
+      if (pending == nil) {
+        break;
+      }
+      _condition.wait(l, [pending] { return pending->_finished; });
+      if (pending->_entry != nil) {
+        _sharedMisses++;
+        return pending->_entry;
+      }
+      // The other render was cancelled, look again.
+    }
+
+    _misses++;
+    pending = [[ASImageContentsCachePendingEntry alloc] init];
+    [_pendingEntries setObject:pending forKey:key];
+    l.unlock();
+
+    // Drawing takes milliseconds, don't block the other keys meanwhile.
+    UIImage *contents = render();
+
+    std::vector<ASWeakMapEntry *> evicted;
+    l.lock();
+    if (contents != nil) {
+      pending->_entry = [_weakEntries setObject:contents forKey:key];
+      use(pending->_entry, evicted);
+    }
+    pending->_finished = YES;
+    [_pendingEntries removeObjectForKey:key];
+    l.unlock();
+    _condition.notify_all();
+    return pending->_entry;
+  }
+
+  void setByteLimit(NSUInteger byteLimit)
+  {
+    std::vector<ASWeakMapEntry *> evicted;
+    std::lock_guard<std::mutex> l(_mutex);
+    _byteLimit = byteLimit;
+    trim(evicted);
+  }
+
+  void removeAll()
+  {
+    // Release the bitmaps after unlocking.
+    std::list<ASImageContentsCacheStrongEntry> removed;
+    std::lock_guard<std::mutex> l(_mutex);
+    removed.swap(_strongEntries);
+    _positions.clear();
+    _cost = 0;
+  }
+
+  ASImageContentsCacheStatistics statistics()
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    return {_hits, _misses, _sharedMisses, _evictions, _cost};
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  ASWeakMap<id, UIImage *> *_weakEntries;
+  NSMapTable<id, ASImageContentsCachePendingEntry *> *_pendingEntries;
+  // The strong tier, most recently used first. Retaining an entry keeps it in _weakEntries.
+  std::list<ASImageContentsCacheStrongEntry> _strongEntries;
+  std::unordered_map<const void *, std::list<ASImageContentsCacheStrongEntry>::iterator> _positions;
+  NSUInteger _byteLimit;
+  NSUInteger _cost;
+  NSUInteger _hits;
+  NSUInteger _misses;
+  NSUInteger _sharedMisses;
+  NSUInteger _evictions;
+
+  /**
+   * Moves the entry to the front of the strong tier, adding it if it was only held by nodes. Evicted entries are
+   * returned so that their bitmaps are released after unlocking.
+   */
+  void use(ASWeakMapEntry<UIImage *> *entry, std::vector<ASWeakMapEntry *> &evicted)
+  {
+    const auto position = _positions.find((__bridge const void *)entry);
+    if (position != _positions.end()) {
+      _strongEntries.splice(_strongEntries.begin(), _strongEntries, position->second);
+      return;
+    }
+    const NSUInteger cost = ASImageContentsCacheEstimatedCost(entry.value);
+    _strongEntries.push_front({entry, cost});
+    _positions[(__bridge const void *)entry] = _strongEntries.begin();
+    _cost += cost;
+    trim(evicted);
+  }
+
+  void trim(std::vector<ASWeakMapEntry *> &evicted)
+  {
+    while (_cost > _byteLimit && !_strongEntries.empty()) {
+      ASImageContentsCacheStrongEntry &last = _strongEntries.back();
+      evicted.push_back(last.entry);
+      _positions.erase((__bridge const void *)last.entry);
+      _cost -= last.cost;
+      _strongEntries.pop_back();
+      _evictions++;
+    }
+  }
+};
+
+} // namespace
+
+static ASImageContentsCache &ASImageContentsCacheGet()
+{
+  static ASImageContentsCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = new ASImageContentsCache(ASConfigurationGetImageContentsCacheByteLimit() ?: ASImageContentsCacheDefaultByteLimit);
+#if TARGET_OS_IOS || TARGET_OS_TV
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification *note) {
+                                                    ASImageContentsCacheTrim();
+                                                  }];
+#endif
+  });
+  return *cache;
+}
+
+ASWeakMapEntry<UIImage *> *ASImageContentsCacheGetEntry(id key, UIImage *(NS_NOESCAPE ^render)(void))
+{
+  return ASImageContentsCacheGet().entry(key, render);
+}
+
+NSUInteger ASImageContentsCacheEstimatedCost(UIImage *image)
+{
+  CGImageRef imageRef = image.CGImage;
+  if (imageRef != NULL) {
+    return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+  }
+  // Not backed by a bitmap yet, like CIImage backed images: assume 4 bytes per pixel.
+  const CGSize size = image.size;
+  const CGFloat scale = image.scale;
+  return (NSUInteger)(size.width * scale * size.height * scale * 4);
+}
+
+void ASImageContentsCacheSetByteLimit(NSUInteger byteLimit)
+{
+  ASImageContentsCacheGet().setByteLimit(byteLimit);
+}
+
+void ASImageContentsCacheTrim()
+{
+  ASImageContentsCacheGet().removeAll();
+}
+
+ASImageContentsCacheStatistics ASImageContentsCacheGetStatistics()
+{
+  return ASImageContentsCacheGet().statistics();
+}
@@ -0,0 +1,146 @@
+//
+//  ASImageDownloadScheduler.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * The scheduling core of ASBasicImageDownloader: which downloads run, in which order, and which are stopped.
+ *
+ * Requests for the same key (the URL) share one download. A download runs at the highest priority of its requests, at
+ * most maximumConcurrentDownloads run at once, and the rest wait in one FIFO queue per priority. A visible request
+ * that finds every slot taken preempts a running preload download, which is suspended and queued again at the front of
+ * its queue.
+ *
+ * The scheduler doesn't touch the network: each call appends what the caller has to do to its transport to a list of
+ * actions. It isn't thread safe, callers lock around it and perform the actions in order.
+ *
+ * Like the layout core, this is plain C++, so that it can be tested on any platform, see
+ * "./build.sh download-scheduling".
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace AS {
+namespace DownloadScheduling {
+
+/** Like ASImageDownloaderPriority, lowest first. */
+enum class Priority : uint8_t {
+  Preload,
+  Imminent,
+  Visible,
+};
+
+static constexpr size_t kPriorityCount = 3;
+
+typedef uint64_t RequestID;
+
+/** Something the caller has to do to its transport. */
+struct Action {
+  enum class Type : uint8_t {
+    /** Start the download, resuming it if there is partial data. */
+    Start,
+    /** Stop the running download, and keep its partial data to resume it later. */
+    Suspend,
+    /** Stop the running download, its partial data isn't needed. */
+    Cancel,
+    /** Move the running download to another priority. */
+    Reprioritize,
+  };
+
+  Type type;
+  std::string key;
+  /** The priority to start or move the download at. */
+  Priority priority;
+
+  bool operator==(const Action &other) const
+  {
+    return type == other.type && key == other.key && priority == other.priority;
+  }
+};
+
+/** Actions are appended in the order they have to be performed in. */
+typedef std::vector<Action> Actions;
+
+struct Statistics {
+  /** Requests added. */
+  uint64_t requests;
+  /** Requests that joined a download that was queued or running already. */
+  uint64_t coalesced;
+  /** Downloads started, including restarts of suspended downloads. */
+  uint64_t started;
+  /** Running downloads suspended to make room for visible ones. */
+  uint64_t preempted;
+  /** Downloads stopped because all of their requests were removed. */
+  uint64_t abandoned;
+};
+
+class Scheduler {
+public:
+  explicit Scheduler(size_t maximumConcurrentDownloads);
+
+  /** Adds a request for key, starting its download or joining the one in flight. Never returns 0. */
+  RequestID addRequest(const std::string &key, Priority priority, Actions &actions);
+
+  /** Moves a request to another priority, along with its download if the request was the one that set it. */
+  void setPriority(RequestID request, Priority priority, Actions &actions);
+
+  /**
+   * Removes a request. The download is stopped once it has no requests left: suspended if keepPartialData, so
+   * that adding a request for the key later can resume it, and cancelled otherwise. Unknown requests are ignored.
+   */
+  void removeRequest(RequestID request, bool keepPartialData, Actions &actions);
+
+  /**
+   * Ends the download of key, whether it succeeded or failed, and returns the requests to complete. A queued download
+   * can finish too: a transport may deliver the bytes before it performs the suspension that queued the download.
+   * Returns nothing if there is no download for key, e.g. for late callbacks of cancelled downloads.
+   */
+  std::vector<RequestID> finishDownload(const std::string &key, Actions &actions);
+
+  /** Whether key has requests, and so a download that is queued or running. */
+  bool hasDownload(const std::string &key) const { return _jobs.count(key) > 0; }
+  bool isRunning(const std::string &key) const;
+  size_t runningCount() const { return _running.size(); }
+  size_t queuedCount() const;
+  /** The priority of the download of key, which must be queued or running. */
+  Priority priority(const std::string &key) const;
+  const Statistics &statistics() const { return _statistics; }
+
+private:
+  struct Job {
+    std::vector<std::pair<RequestID, Priority>> requests;
+    Priority priority;
+    bool running;
+    std::list<std::string>::iterator queuePosition;
+  };
+
+  static Priority highestPriority(const Job &job);
+  void enqueue(const std::string &key, Job &job, bool atFront);
+  void dequeue(Job &job);
+  void updatePriority(const std::string &key, Job &job, Actions &actions);
+  void schedule(Actions &actions);
+  void start(const std::string &key, Job &job, Actions &actions);
+
+  size_t _maximumConcurrentDownloads;
+  // At most _maximumConcurrentDownloads keys, in start order.
+  std::vector<std::string> _running;
+  RequestID _nextRequestID;
+  std::unordered_map<std::string, Job> _jobs;
+  std::unordered_map<RequestID, std::string> _requestKeys;
+  std::list<std::string> _queues[kPriorityCount];
+  Statistics _statistics;
+};
+
+} // namespace DownloadScheduling
+} // namespace AS
@@ -0,0 +1,227 @@
+//
+//  ASImageDownloadScheduler.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASImageDownloadScheduler.h.
+#include "ASImageDownloadScheduler.h"
+
+#include <algorithm>
+
+namespace AS {
+namespace DownloadScheduling {
+
+static size_t indexOfPriority(Priority priority)
+{
+  return static_cast<size_t>(priority);
+}
+
+Scheduler::Scheduler(size_t maximumConcurrentDownloads)
+    : _maximumConcurrentDownloads(std::max<size_t>(maximumConcurrentDownloads, 1)), _nextRequestID(1), _statistics()
+{
+}
+
+RequestID Scheduler::addRequest(const std::string &key, Priority priority, Actions &actions)
+{
+  const RequestID request = _nextRequestID++;
+  _requestKeys.emplace(request, key);
+  _statistics.requests++;
+
+  const auto it = _jobs.find(key);
+  if (it != _jobs.end()) {
+    _statistics.coalesced++;
+    it->second.requests.emplace_back(request, priority);
+    updatePriority(key, it->second, actions);
+    return request;
+  }
+
+  Job &job = _jobs[key];
+  job.requests.emplace_back(request, priority);
+  job.priority = priority;
+  job.running = false;
+  enqueue(key, job, false);
+  schedule(actions);
+  return request;
+}
+
+void Scheduler::setPriority(RequestID request, Priority priority, Actions &actions)
+{
+  const auto keyIt = _requestKeys.find(request);
+  if (keyIt == _requestKeys.end()) {
+    return;
+  }
+  Job &job = _jobs.at(keyIt->second);
+  for (auto &entry : job.requests) {
+    if (entry.first == request) {
+      entry.second = priority;
+    }
+  }
+  updatePriority(keyIt->second, job, actions);
+}
+
+void Scheduler::removeRequest(RequestID request, bool keepPartialData, Actions &actions)
+{
+  const auto keyIt = _requestKeys.find(request);
+  if (keyIt == _requestKeys.end()) {
+    return;
+  }
+  const std::string key = keyIt->second;
+  _requestKeys.erase(keyIt);
+
+  Job &job = _jobs.at(key);
+  job.requests.erase(std::remove_if(job.requests.begin(), job.requests.end(),
+                                    [request](const std::pair<RequestID, Priority> &entry) {
+                                      return entry.first == request;
+                                    }),
+                     job.requests.end());
+  if (!job.requests.empty()) {
+    updatePriority(key, job, actions);
+    return;
+  }
+
+  if (job.running) {
+    _running.erase(std::find(_running.begin(), _running.end(), key));
+    actions.push_back({keepPartialData ? Action::Type::Suspend : Action::Type::Cancel, key, job.priority});
+    _statistics.abandoned++;
+  } else {
+    dequeue(job);
+  }
+  _jobs.erase(key);
+  schedule(actions);
+}
+
+std::vector<RequestID> Scheduler::finishDownload(const std::string &key, Actions &actions)
+{
+  std::vector<RequestID> requests;
+  const auto it = _jobs.find(key);
+  if (it == _jobs.end()) {
+    return requests;
+  }
+
+  requests.reserve(it->second.requests.size());
+  for (const auto &entry : it->second.requests) {
+    requests.push_back(entry.first);
+    _requestKeys.erase(entry.first);
+  }
+  if (it->second.running) {
+    _running.erase(std::find(_running.begin(), _running.end(), key));
+  } else {
+    dequeue(it->second);
+  }
+  _jobs.erase(it);
+  schedule(actions);
+  return requests;
+}
+
+bool Scheduler::isRunning(const std::string &key) const
+{
+  const auto it = _jobs.find(key);
+  return it != _jobs.end() && it->second.running;
+}
+
+size_t Scheduler::queuedCount() const
+{
+  size_t count = 0;
+  for (const auto &queue : _queues) {
+    count += queue.size();
+  }
+  return count;
+}
+
+Priority Scheduler::priority(const std::string &key) const
+{
+  return _jobs.at(key).priority;
+}
+
+Priority Scheduler::highestPriority(const Job &job)
+{
+  Priority priority = Priority::Preload;
+  for (const auto &entry : job.requests) {
+    priority = std::max(priority, entry.second);
+  }
+  return priority;
+}
+
+void Scheduler::enqueue(const std::string &key, Job &job, bool atFront)
+{
+  auto &queue = _queues[indexOfPriority(job.priority)];
+  job.queuePosition = queue.insert(atFront ? queue.begin() : queue.end(), key);
+}
+
+void Scheduler::dequeue(Job &job)
+{
+  _queues[indexOfPriority(job.priority)].erase(job.queuePosition);
+}
+
+void Scheduler::updatePriority(const std::string &key, Job &job, Actions &actions)
+{
+  const Priority priority = highestPriority(job);
+  if (priority == job.priority) {
+    return;
+  }
+
+  if (job.running) {
+    job.priority = priority;
+    actions.push_back({Action::Type::Reprioritize, key, priority});
+  } else {
+    dequeue(job);
+    job.priority = priority;
+    enqueue(key, job, false);
+  }
+  schedule(actions);
+}
+
+void Scheduler::schedule(Actions &actions)
+{
+  while (true) {
+    std::list<std::string> *queue = nullptr;
+    for (size_t i = kPriorityCount; i > 0; i--) {
+      if (!_queues[i - 1].empty()) {
+        queue = &_queues[i - 1];
+        break;
+      }
+    }
+    if (queue == nullptr) {
+      return;
+    }
+
+    if (_running.size() < _maximumConcurrentDownloads) {
+      const std::string key = queue->front();
+      start(key, _jobs.at(key), actions);
+      continue;
+    }
+
+    // Only visible requests preempt, and only preload downloads. The latest one has the least progress to lose.
+    if (queue != &_queues[indexOfPriority(Priority::Visible)]) {
+      return;
+    }
+    const auto victim = std::find_if(_running.rbegin(), _running.rend(), [this](const std::string &key) {
+      return _jobs.at(key).priority == Priority::Preload;
+    });
+    if (victim == _running.rend()) {
+      return;
+    }
+    const std::string key = *victim;
+    _running.erase(std::next(victim).base());
+    Job &job = _jobs.at(key);
+    job.running = false;
+    enqueue(key, job, true);
+    actions.push_back({Action::Type::Suspend, key, job.priority});
+    _statistics.preempted++;
+  }
+}
+
+void Scheduler::start(const std::string &key, Job &job, Actions &actions)
+{
+  dequeue(job);
+  job.running = true;
+  _running.push_back(key);
+  actions.push_back({Action::Type::Start, key, job.priority});
+  _statistics.started++;
+}
+
+} // namespace DownloadScheduling
+} // namespace AS
@@ -0,0 +1,77 @@
+//
+//  ASImageDownsampling.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * The sizing math of decoding images straight to the size they are displayed at, instead of decoding them at full
+ * size and scaling them down when drawing. See ASImageDecoding.h for the decoder.
+ *
+ * Like the layout core, this is plain C++, so that it can be tested on any platform, see
+ * "./build.sh image-downsampling".
+ */
+
+#include <cstdint>
+
+namespace AS {
+namespace ImageDownsampling {
+
+struct PixelSize {
+  uint32_t width;
+  uint32_t height;
+
+  bool isEmpty() const { return width == 0 || height == 0; }
+
+  bool operator==(const PixelSize &other) const { return width == other.width && height == other.height; }
+  bool operator!=(const PixelSize &other) const { return !(*this == other); }
+};
+
+/** How the decoded image is scaled into its target, like the UIViewContentMode values of the same names. */
+enum class ContentMode {
+  ScaleToFill,
+  ScaleAspectFit,
+  ScaleAspectFill,
+  /** Center, top, bottom-left and the others, which show the image at its own size. */
+  Unscaled,
+};
+
+/**
+ * The pixels an image is displayed in: the bounds in points times the contents scale, with each side rounded up.
+ *
+ * A crop rect that features a fraction of the image (cropWidth, cropHeight in (0, 1]) scales the whole image up, so
+ * the target grows by the inverse of the fraction. Pass 0 for no crop rect. Returns an empty size for empty bounds.
+ */
+PixelSize targetPixelSize(double boundsWidth, double boundsHeight, double scale, double cropWidth = 0,
+                          double cropHeight = 0);
+
+/**
+ * The size to decode a sourceSize image at so that it still covers target in the given content mode: the aspect ratio
+ * of the source is kept and each side is rounded up.
+ *
+ * Images are never upscaled: the source size is returned if the target is empty, the content mode doesn't scale, or
+ * the target needs at least the full size.
+ */
+PixelSize decodedPixelSize(PixelSize sourceSize, PixelSize target, ContentMode contentMode);
+
+/**
+ * The longer side of a decoded size, which is what thumbnail decoders are given (kCGImageSourceThumbnailMaxPixelSize).
+ */
+uint32_t maxPixelSize(PixelSize decodedSize);
+
+/**
+ * Rounds each side of a target up to the next step of a ladder whose steps are an eighth of the highest power of two
+ * at or below the side, and at least 16 pixels. Nodes of nearly the same size then share a decoded variant, and a side
+ * grows by at most 12.5% above 128 pixels.
+ */
+PixelSize bucketedTargetSize(PixelSize target);
+
+/** The bytes of a decoded bitmap of this size, at 4 bytes per pixel. */
+uint64_t decodedByteCount(PixelSize size);
+
+} // namespace ImageDownsampling
+} // namespace AS
@@ -0,0 +1,94 @@
+//
+//  ASImageDownsampling.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASImageDownsampling.h.
+#include "ASImageDownsampling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace AS {
+namespace ImageDownsampling {
+
+// Products of exact sizes and scales can land a hair above an integer, which must not round up to the next pixel.
+static const double kRoundingTolerance = 1e-6;
+
+static uint32_t pixelsRoundingUp(double value)
+{
+  if (!(value > 0)) {
+    return 0;
+  }
+  if (value >= UINT32_MAX) {
+    return UINT32_MAX;
+  }
+  return static_cast<uint32_t>(std::ceil(value - kRoundingTolerance));
+}
+
+PixelSize targetPixelSize(double boundsWidth, double boundsHeight, double scale, double cropWidth, double cropHeight)
+{
+  double width = boundsWidth * scale;
+  double height = boundsHeight * scale;
+  if (cropWidth > 0 && cropHeight > 0) {
+    width /= std::min(cropWidth, 1.0);
+    height /= std::min(cropHeight, 1.0);
+  }
+  const PixelSize target = {pixelsRoundingUp(width), pixelsRoundingUp(height)};
+  return target.isEmpty() ? PixelSize{0, 0} : target;
+}
+
+PixelSize decodedPixelSize(PixelSize sourceSize, PixelSize target, ContentMode contentMode)
+{
+  if (sourceSize.isEmpty() || target.isEmpty() || contentMode == ContentMode::Unscaled) {
+    return sourceSize;
+  }
+
+  const double widthScale = static_cast<double>(target.width) / sourceSize.width;
+  const double heightScale = static_cast<double>(target.height) / sourceSize.height;
+  // Fitting needs the image to reach the target on one side, filling and stretching on both.
+  const double scale = (contentMode == ContentMode::ScaleAspectFit ? std::min(widthScale, heightScale)
+                                                                   : std::max(widthScale, heightScale));
+  if (scale >= 1) {
+    return sourceSize;
+  }
+
+  const uint32_t width = std::max<uint32_t>(pixelsRoundingUp(sourceSize.width * scale), 1);
+  const uint32_t height = std::max<uint32_t>(pixelsRoundingUp(sourceSize.height * scale), 1);
+  return {std::min(width, sourceSize.width), std::min(height, sourceSize.height)};
+}
+
+uint32_t maxPixelSize(PixelSize decodedSize)
+{
+  return std::max(decodedSize.width, decodedSize.height);
+}
+
+static uint32_t bucketedSide(uint32_t side)
+{
+  if (side == 0) {
+    return 0;
+  }
+  uint32_t highestPowerOfTwo = 1;
+  while (highestPowerOfTwo <= side / 2) {
+    highestPowerOfTwo *= 2;
+  }
+  const uint64_t step = std::max<uint32_t>(highestPowerOfTwo / 8, 16);
+  const uint64_t bucketed = (side + step - 1) / step * step;
+  return static_cast<uint32_t>(std::min<uint64_t>(bucketed, UINT32_MAX));
+}
+
+PixelSize bucketedTargetSize(PixelSize target)
+{
+  return {bucketedSide(target.width), bucketedSide(target.height)};
+}
+
+uint64_t decodedByteCount(PixelSize size)
+{
+  return static_cast<uint64_t>(size.width) * size.height * 4;
+}
+
+} // namespace ImageDownsampling
+} // namespace AS
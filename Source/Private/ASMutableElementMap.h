@@ -9,6 +9,7 @@
 
 #import <Foundation/Foundation.h>
 #import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASDimension.h>
 #import <AsyncDisplayKit/ASElementMap.h>
 #import <AsyncDisplayKit/ASIntegerMap.h>
 
@@ -46,6 +47,24 @@ AS_SUBCLASSING_RESTRICTED
 
 - (void)insertElement:(ASCollectionElement *)element atIndexPath:(NSIndexPath *)indexPath;
 
+/**
+ * Appends items that are not materialized yet to the section. Until they are, the map hands out placeholders
+ * of the given size for them.
+ */
+- (void)appendUnmaterializedItems:(NSInteger)count toSection:(NSInteger)section placeholderSize:(ASSizeRange)placeholderSize;
+
+/**
+ * Puts the element in place of the unmaterialized item at the index path.
+ *
+ * @return NO if there is no unmaterialized item at the index path.
+ */
+- (BOOL)materializeElement:(ASCollectionElement *)element atIndexPath:(NSIndexPath *)indexPath;
+
+/**
+ * Sets the size of the placeholders of the section, e.g. after the estimates changed.
+ */
+- (void)setPlaceholderSize:(ASSizeRange)placeholderSize forSection:(NSInteger)section;
+
 /**
  * Update the index paths for all supplementary elements to account for section-level
  * deletes, moves, inserts. This must be called before adding new supplementary elements.
@@ -11,73 +11,142 @@
 
 #import <AsyncDisplayKit/ASCollectionElement.h>
 #import <AsyncDisplayKit/ASElementMap.h>
-#import <AsyncDisplayKit/ASTwoDimensionalArrayUtils.h>
+#import <AsyncDisplayKit/ASElementMapStorage.h>
+#import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASInternalHelpers.h>
 
-typedef NSMutableArray<NSMutableArray<ASCollectionElement *> *> ASMutableCollectionElementTwoDimensionalArray;
+#import <algorithm>
 
-typedef NSMutableDictionary<NSString *, NSMutableDictionary<NSIndexPath *, ASCollectionElement *> *> ASMutableSupplementaryElementDictionary;
+/**
+ * Removes the values at the indexes in one pass, rather than shifting the tail of the vector once per index.
+ */
+template <typename T>
+static void ASRemoveIndexes(std::vector<T> &values, NSIndexSet *indexes)
+{
+  NSUInteger removed = [indexes firstIndex];
+  if (removed == NSNotFound) {
+    return;
+  }
+  NSUInteger kept = removed;
+  for (NSUInteger i = removed; i < values.size(); i++) {
+    if (i == removed) {
+      removed = [indexes indexGreaterThanIndex:i];
+      continue;
+    }
+    values[kept++] = std::move(values[i]);
+  }
+  values.resize(MIN(kept, values.size()));
+}
 
 @implementation ASMutableElementMap {
-  ASMutableSupplementaryElementDictionary *_supplementaryElements;
-  NSMutableArray<ASSection *> *_sections;
-  ASMutableCollectionElementTwoDimensionalArray *_sectionsOfItems;
+  AS::ElementMapStorage _storage;
 }
 
 - (instancetype)initWithSections:(NSArray<ASSection *> *)sections items:(ASCollectionElementTwoDimensionalArray *)items supplementaryElements:(ASSupplementaryElementDictionary *)supplementaryElements
+{
+  return [self initWithStorage:[[ASElementMap alloc] initWithSections:sections items:items supplementaryElements:supplementaryElements].storage];
+}
+
+- (instancetype)initWithStorage:(const AS::ElementMapStorage &)storage
 {
   if (self = [super init]) {
-    _sections = [sections mutableCopy];
-    _sectionsOfItems = (ASMutableCollectionElementTwoDimensionalArray *)ASTwoDimensionalArrayDeepMutableCopy(items);
-    _supplementaryElements = [ASMutableElementMap deepMutableCopyOfElementsDictionary:supplementaryElements];
+    _storage = storage;
   }
   return self;
 }
 
 - (id)copyWithZone:(NSZone *)zone
 {
-  return [[ASElementMap alloc] initWithSections:_sections items:_sectionsOfItems supplementaryElements:_supplementaryElements];
+  return [[ASElementMap alloc] initWithStorage:_storage];
 }
 
 - (void)removeAllSections
 {
-  [_sections removeAllObjects];
+  _storage.sections.clear();
 }
 
 - (void)insertSection:(ASSection *)section atIndex:(NSInteger)index
 {
-  [_sections insertObject:section atIndex:index];
+  _storage.sections.insert(_storage.sections.begin() + index, section);
 }
 
 - (void)removeItemsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
 {
-  ASDeleteElementsInTwoDimensionalArrayAtIndexPaths(_sectionsOfItems, indexPaths);
+  if (indexPaths.count == 0) {
+    return;
+  }
+
+#if ASDISPLAYNODE_ASSERTIONS_ENABLED
+  NSArray *sortedIndexPaths = [indexPaths sortedArrayUsingSelector:@selector(asdk_inverseCompare:)];
+  ASDisplayNodeAssert([sortedIndexPaths isEqualToArray:indexPaths], @"Expected array of index paths to be sorted in descending order.");
+#endif
+
+  // The index paths are sorted, so the items of each section are removed together.
+  NSMutableIndexSet *items = [[NSMutableIndexSet alloc] init];
+  NSInteger section = NSNotFound;
+  for (NSIndexPath *indexPath in indexPaths) {
+    if (indexPath.section != section) {
+      [self removeItems:items inSection:section];
+      [items removeAllIndexes];
+      section = indexPath.section;
+      if (section >= _storage.itemSections.size()) {
+        ASDisplayNodeFailAssert(@"Invalid section index %ld – only %ld sections", (long)section, (long)_storage.itemSections.size());
+        section = NSNotFound;
+        continue;
+      }
+    }
+    if (section == NSNotFound) {
+      continue;
+    }
+    NSInteger item = indexPath.item;
+    if (item >= _storage.itemSections[section]->items.size()) {
+      ASDisplayNodeFailAssert(@"Invalid item index %ld – only %ld items in section %ld", (long)item, (long)_storage.itemSections[section]->items.size(), (long)section);
+      continue;
+    }
+    [items addIndex:item];
+  }
+  [self removeItems:items inSection:section];
 }
 
 - (void)removeSectionsAtIndexes:(NSIndexSet *)indexes
 {
-  [_sections removeObjectsAtIndexes:indexes];
+  ASRemoveIndexes(_storage.sections, indexes);
 }
 
 - (void)removeSupplementaryElementsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths kind:(NSString *)kind
 {
-  [_supplementaryElements[kind] removeObjectsForKeys:indexPaths];
+  if (indexPaths.count == 0 || _storage.supplementaryElements(kind) == nullptr) {
+    return;
+  }
+
+  std::vector<AS::SupplementaryElement> removed;
+  removed.reserve(indexPaths.count);
+  for (NSIndexPath *indexPath in indexPaths) {
+    removed.push_back({indexPath.section, indexPath.item, nil});
+  }
+  std::sort(removed.begin(), removed.end());
+
+  AS::SupplementaryElements &elements = [self mutableSupplementaryElementsOfKind:kind];
+  elements.erase(std::remove_if(elements.begin(), elements.end(), [&](const AS::SupplementaryElement &element) {
+    return std::binary_search(removed.begin(), removed.end(), element);
+  }), elements.end());
 }
 
 - (void)removeAllElements
 {
-  [_sectionsOfItems removeAllObjects];
-  [_supplementaryElements removeAllObjects];
+  _storage.itemSections.clear();
+  _storage.supplementaryKinds.clear();
 }
 
 - (void)removeSectionsOfItems:(NSIndexSet *)itemSections
 {
-  [_sectionsOfItems removeObjectsAtIndexes:itemSections];
+  ASRemoveIndexes(_storage.itemSections, itemSections);
 }
 
 - (void)insertEmptySectionsOfItemsAtIndexes:(NSIndexSet *)sections
 {
   [sections enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL * _Nonnull stop) {
-    [_sectionsOfItems insertObject:[[NSMutableArray alloc] init]  atIndex:idx];
+    _storage.itemSections.insert(_storage.itemSections.begin() + idx, std::make_shared<AS::ElementSection>());
   }];
 }
 
@@ -85,14 +154,53 @@ typedef NSMutableDictionary<NSString *, NSMutableDictionary<NSIndexPath *, ASCol
 {
   NSString *kind = element.supplementaryElementKind;
   if (kind == nil) {
-    [_sectionsOfItems[indexPath.section] insertObject:element atIndex:indexPath.item];
+    ASDisplayNodeAssertFalse(element.isPlaceholder);
+    AS::ElementSection &itemSection = [self mutableItemsInSection:indexPath.section];
+    itemSection.items.insert(itemSection.items.begin() + indexPath.item, element);
   } else {
-    NSMutableDictionary *supplementariesForKind = _supplementaryElements[kind];
-    if (supplementariesForKind == nil) {
-      supplementariesForKind = [[NSMutableDictionary alloc] init];
-      _supplementaryElements[kind] = supplementariesForKind;
+    AS::SupplementaryElements &elements = [self mutableSupplementaryElementsOfKind:kind];
+    const AS::SupplementaryElement supplementary = {indexPath.section, indexPath.item, element};
+    const auto it = std::lower_bound(elements.begin(), elements.end(), supplementary);
+    if (it != elements.end() && it->section == supplementary.section && it->item == supplementary.item) {
+      it->element = element;
+    } else {
+      elements.insert(it, supplementary);
     }
-    supplementariesForKind[indexPath] = element;
+  }
+}
+
+- (void)appendUnmaterializedItems:(NSInteger)count toSection:(NSInteger)section placeholderSize:(ASSizeRange)placeholderSize
+{
+  if (count == 0) {
+    return;
+  }
+  AS::ElementSection &itemSection = [self mutableItemsInSection:section];
+  ASDisplayNodeAssert(itemSection.placeholderCount == 0 || ASSizeRangeEqualToSizeRange(itemSection.placeholderSize, placeholderSize), @"Sections have one placeholder size.");
+  itemSection.items.resize(itemSection.items.size() + count, nil);
+  itemSection.placeholderSize = placeholderSize;
+  itemSection.placeholderCount += count;
+}
+
+- (BOOL)materializeElement:(ASCollectionElement *)element atIndexPath:(NSIndexPath *)indexPath
+{
+  ASDisplayNodeAssert(element.supplementaryElementKind == nil && !element.isPlaceholder, @"Only items are materialized: %@", element);
+  NSInteger section = indexPath.section;
+  NSInteger item = indexPath.item;
+  if (section >= _storage.itemSections.size() || item >= _storage.itemSections[section]->items.size()
+      || _storage.itemSections[section]->items[item] != nil) {
+    return NO;
+  }
+  AS::ElementSection &itemSection = [self mutableItemsInSection:section];
+  itemSection.items[item] = element;
+  itemSection.placeholderCount--;
+  return YES;
+}
+
+- (void)setPlaceholderSize:(ASSizeRange)placeholderSize forSection:(NSInteger)section
+{
+  const AS::ElementSection &itemSection = *_storage.itemSections[section];
+  if (itemSection.placeholderCount > 0 && !ASSizeRangeEqualToSizeRange(itemSection.placeholderSize, placeholderSize)) {
+    [self mutableItemsInSection:section].placeholderSize = placeholderSize;
   }
 }
 
@@ -103,41 +211,85 @@ typedef NSMutableDictionary<NSString *, NSMutableDictionary<NSIndexPath *, ASCol
     return;
   }
 
-  // For each element kind,
-  [_supplementaryElements enumerateKeysAndObjectsUsingBlock:^(NSString * _Nonnull key, NSMutableDictionary<NSIndexPath *,ASCollectionElement *> * _Nonnull supps, BOOL * _Nonnull stop) {
-    
-    // For each index path of that kind, move entries into a new dictionary.
-    // Note: it's tempting to update the dictionary in-place but because of the likely collision between old and new index paths,
-    // subtle bugs are possible. Note that this process is rare (only on section-level updates),
-    // that this work is done off-main, and that the typical supplementary element use case is just 1-per-section (header).
-    NSMutableDictionary *newSupps = [[NSMutableDictionary alloc] init];
-    [supps enumerateKeysAndObjectsUsingBlock:^(NSIndexPath * _Nonnull oldIndexPath, ASCollectionElement * _Nonnull obj, BOOL * _Nonnull stop) {
-      NSInteger oldSection = oldIndexPath.section;
-      NSInteger newSection = [mapping integerForKey:oldSection];
-      
-      if (oldSection == newSection) {
-        // Index path stayed the same, just copy it over.
-        newSupps[oldIndexPath] = obj;
-      } else if (newSection != NSNotFound) {
-        // Section index changed, move it.
-        NSIndexPath *newIndexPath = [NSIndexPath indexPathForItem:oldIndexPath.item inSection:newSection];
-        newSupps[newIndexPath] = obj;
+  std::vector<NSInteger> oldSections;
+  std::vector<NSInteger> newSections;
+  for (auto &supplementaryKind : _storage.supplementaryKinds) {
+    // The elements are sorted by section, so map each of their sections once, all together.
+    oldSections.clear();
+    for (const auto &supplementary : *supplementaryKind.elements) {
+      if (oldSections.empty() || oldSections.back() != supplementary.section) {
+        oldSections.push_back(supplementary.section);
       }
-    }];
-    [supps setDictionary:newSupps];
-  }];
+    }
+    newSections = oldSections;
+    [mapping mapIntegers:newSections.data() count:newSections.size()];
+
+    // Build the migrated elements separately, a section may move in front of one that comes before it now.
+    auto migrated = std::make_shared<AS::SupplementaryElements>();
+    migrated->reserve(supplementaryKind.elements->size());
+    size_t i = 0;
+    for (const auto &supplementary : *supplementaryKind.elements) {
+      if (oldSections[i] != supplementary.section) {
+        i++;
+      }
+      // Elements in deleted sections are dropped.
+      if (newSections[i] != NSNotFound) {
+        migrated->push_back({newSections[i], supplementary.item, supplementary.element});
+      }
+    }
+    if (!std::is_sorted(migrated->begin(), migrated->end())) {
+      std::sort(migrated->begin(), migrated->end());
+    }
+    supplementaryKind.elements = std::move(migrated);
+  }
 }
 
-#pragma mark - Helpers
+#pragma mark - Copy on write
 
-+ (ASMutableSupplementaryElementDictionary *)deepMutableCopyOfElementsDictionary:(ASSupplementaryElementDictionary *)originalDict
+/**
+ * Returns the items of the section for modification. Sections are shared with the maps this map was copied from and
+ * to, so a shared section is copied first.
+ */
+- (AS::ElementSection &)mutableItemsInSection:(NSInteger)section
 {
-  NSMutableDictionary *deepCopy = [[NSMutableDictionary alloc] initWithCapacity:originalDict.count];
-  [originalDict enumerateKeysAndObjectsUsingBlock:^(NSString * _Nonnull key, NSDictionary<NSIndexPath *,ASCollectionElement *> * _Nonnull obj, BOOL * _Nonnull stop) {
-    deepCopy[key] = [obj mutableCopy];
-  }];
-  
-  return deepCopy;
+  auto &items = _storage.itemSections[section];
+  if (items.use_count() != 1) {
+    items = std::make_shared<AS::ElementSection>(*items);
+  }
+  return *items;
+}
+
+/**
+ * Returns the supplementary elements of the kind for modification, adding the kind if there are none yet. Like
+ * sections, a shared kind is copied first.
+ */
+- (AS::SupplementaryElements &)mutableSupplementaryElementsOfKind:(NSString *)kind
+{
+  for (auto &supplementaryKind : _storage.supplementaryKinds) {
+    if ([supplementaryKind.kind isEqualToString:kind]) {
+      if (supplementaryKind.elements.use_count() != 1) {
+        supplementaryKind.elements = std::make_shared<AS::SupplementaryElements>(*supplementaryKind.elements);
+      }
+      return *supplementaryKind.elements;
+    }
+  }
+  _storage.supplementaryKinds.push_back({[kind copy], std::make_shared<AS::SupplementaryElements>()});
+  return *_storage.supplementaryKinds.back().elements;
+}
+
+- (void)removeItems:(NSIndexSet *)items inSection:(NSInteger)section
+{
+  if (items.count > 0) {
+    AS::ElementSection &itemSection = [self mutableItemsInSection:section];
+    if (itemSection.placeholderCount > 0) {
+      for (NSUInteger item = [items firstIndex]; item != NSNotFound; item = [items indexGreaterThanIndex:item]) {
+        if (itemSection.items[item] == nil) {
+          itemSection.placeholderCount--;
+        }
+      }
+    }
+    ASRemoveIndexes(itemSection.items, items);
+  }
 }
 
 @end
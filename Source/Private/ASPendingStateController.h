@@ -29,6 +29,13 @@ AS_SUBCLASSING_RESTRICTED
 
 @property (nonatomic, readonly) BOOL hasChanges;
 
+/**
+ * If non-zero, each scheduled flush applies the pending states of the visible nodes, and then of as many other nodes
+ * as fit in this much time. The rest are flushed in the next turn of the main queue, or by calling -flush.
+ * Default == 0.
+ */
+@property (nonatomic) CFTimeInterval timeBudget;
+
 /**
  Flush all pending states for nodes now. Any UIView/CALayer properties
  that have been set in the background will be applied to their
@@ -8,10 +8,16 @@
 //
 
 #import <AsyncDisplayKit/ASPendingStateController.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/ASWeakSet.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h> // Required for -applyPendingViewState; consider moving this to +FrameworkPrivate
 
+#import <QuartzCore/QuartzCore.h>
+#import <algorithm>
+#import <vector>
+
 @interface ASPendingStateController()
 {
   AS::Mutex _lock;
@@ -43,6 +49,10 @@
   static ASPendingStateController *controller = nil;
   dispatch_once(&onceToken, ^{
     controller = [[ASPendingStateController alloc] init];
+    if (ASActivateExperimentalFeature(ASExperimentalTimeSlicedPendingState)) {
+      // Leave most of the frame to everything else.
+      controller.timeBudget = 0.004;
+    }
   });
   return controller;
 }
@@ -59,6 +69,18 @@
 }
 
 - (void)flush
+{
+  [self _flushWithTimeBudget:0];
+}
+
+#pragma mark Private Methods
+
+/**
+ Applies the pending states of the visible nodes first, and then of the others, grouped by the properties
+ they set so that consecutive nodes run the same setters. With a time budget, nodes that aren't visible
+ and don't fit are registered again.
+ */
+- (void)_flushWithTimeBudget:(CFTimeInterval)timeBudget
 {
   ASDisplayNodeAssertMainThread();
   _lock.lock();
@@ -67,13 +89,34 @@
     _flags.pendingFlush = NO;
   _lock.unlock();
 
+  struct DirtyNode {
+    ASDisplayNode *node;
+    BOOL visible;
+    uint64_t changesMask;
+  };
+  std::vector<DirtyNode> nodes;
+  nodes.reserve(dirtyNodes.count);
   for (ASDisplayNode *node in dirtyNodes) {
-    [node applyPendingViewState];
+    nodes.push_back({node, ASInterfaceStateIncludesVisible(node.interfaceState), node.pendingViewStateChangesMask});
   }
-}
-
+  std::sort(nodes.begin(), nodes.end(), [](const DirtyNode &a, const DirtyNode &b) {
+    return a.visible != b.visible ? a.visible : a.changesMask < b.changesMask;
+  });
 
-#pragma mark Private Methods
+  const CFTimeInterval start = (timeBudget > 0 ? CACurrentMediaTime() : 0);
+  for (auto it = nodes.begin(); it != nodes.end(); it++) {
+    // At least one node is applied in each flush.
+    if (timeBudget > 0 && !it->visible && it != nodes.begin() && CACurrentMediaTime() - start >= timeBudget) {
+      AS::MutexLocker l(_lock);
+      for (; it != nodes.end(); it++) {
+        [_dirtyNodes addObject:it->node];
+      }
+      [self scheduleFlushIfNeeded];
+      break;
+    }
+    [it->node applyPendingViewState];
+  }
+}
 
 /**
  This method is assumed to be called with the lock held.
@@ -86,7 +129,7 @@
 
   _flags.pendingFlush = YES;
   dispatch_async(dispatch_get_main_queue(), ^{
-    [self flush];
+    [self _flushWithTimeBudget:self.timeBudget];
   });
 }
 
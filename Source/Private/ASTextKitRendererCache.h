@@ -0,0 +1,43 @@
+//
+//  ASTextKitRendererCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <AsyncDisplayKit/ASAvailability.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASConfiguration.h>
+
+#if AS_ENABLE_TEXTNODE
+
+#import <AsyncDisplayKit/ASTextKitAttributes.h>
+
+@class ASTextKitRenderer;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The number of shards of the renderer cache.
+ */
+ASDK_EXTERN NSUInteger const ASTextKitRendererCacheShardCount;
+
+/**
+ * Returns the cached renderer for the given attributes and constrained size, or creates and caches one.
+ *
+ * The cache is split into shards by the hash of the key, each with its own lock and NSCache. Renderers are created
+ * outside of the lock, and a thread that misses while another one is creating the same renderer waits for it, so that
+ * exactly one renderer is created.
+ */
+ASDK_EXTERN ASTextKitRenderer *ASTextKitRendererCacheGetRenderer(const ASTextKitAttributes &attributes, CGSize constrainedSize);
+
+/**
+ * The counters of the given shard, which must be less than ASTextKitRendererCacheShardCount.
+ */
+ASDK_EXTERN ASTextRendererCacheStatistics ASTextKitRendererCacheGetStatistics(NSUInteger shard);
+
+NS_ASSUME_NONNULL_END
+
+#endif
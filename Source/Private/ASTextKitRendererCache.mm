@@ -0,0 +1,191 @@
+//
+//  ASTextKitRendererCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTextKitRendererCache.h>
+
+#if AS_ENABLE_TEXTNODE
+
+#import <AsyncDisplayKit/ASHashing.h>
+#import <AsyncDisplayKit/ASTextKitRenderer.h>
+
+#import <condition_variable>
+#import <mutex>
+
+// Must be a power of two.
+NSUInteger const ASTextKitRendererCacheShardCount = 16;
+
+// The limit of the single cache this replaced.
+static NSUInteger const kASTextKitRendererCacheCountLimit = 500;
+
+@interface ASTextNodeRendererKey : NSObject
+- (instancetype)initWithTextKitAttributes:(const ASTextKitAttributes &)attributes constrainedSize:(const CGSize)constrainedSize;
+@end
+
+@implementation ASTextNodeRendererKey {
+  ASTextKitAttributes _attributes;
+  CGSize _constrainedSize;
+  NSUInteger _hash;
+}
+
+- (instancetype)initWithTextKitAttributes:(const ASTextKitAttributes &)attributes constrainedSize:(const CGSize)constrainedSize
+{
+  if (self = [super init]) {
+    _attributes = attributes;
+    _constrainedSize = constrainedSize;
+
+    // The hash picks the shard too, so compute it once.
+    _hash = AS::hashFields(_attributes.hash(), _constrainedSize);
+  }
+  return self;
+}
+
+- (NSUInteger)hash
+{
+  return _hash;
+}
+
+- (BOOL)isEqual:(ASTextNodeRendererKey *)object
+{
+  if (self == object) {
+    return YES;
+  }
+  if (!object) {
+    return NO;
+  }
+  // NOTE: Skip the class check for this specialized, internal Key object.
+  
+  return _hash == object->_hash && _attributes == object->_attributes && CGSizeEqualToSize(_constrainedSize, object->_constrainedSize);
+}
+
+@end
+
+/**
+ * A renderer that a thread is creating. Threads that miss the same key wait for it instead of creating another one.
+ */
+@interface ASTextKitRendererCachePendingEntry : NSObject {
+@package
+  ASTextKitRenderer *_renderer;
+  // Set when the creating thread is done, whether or not it produced a renderer.
+  BOOL _finished;
+}
+@end
+
+@implementation ASTextKitRendererCachePendingEntry
+@end
+
+namespace {
+
+class ASTextKitRendererCacheShard {
+public:
+  ASTextKitRendererCacheShard() : _hits(0), _misses(0), _sharedMisses(0)
+  {
+    _cache = [[NSCache alloc] init];
+    _cache.countLimit = kASTextKitRendererCacheCountLimit / ASTextKitRendererCacheShardCount;
+    _pendingEntries = [[NSMutableDictionary alloc] init];
+  }
+
+  ASTextKitRenderer *renderer(ASTextNodeRendererKey *key, const ASTextKitAttributes &attributes, CGSize constrainedSize)
+  {
+    std::unique_lock<std::mutex> l(_mutex);
+    if (ASTextKitRenderer *renderer = [_cache objectForKey:key]) {
+      _hits++;
+      return renderer;
+    }
+
+    if (ASTextKitRendererCachePendingEntry *entry = _pendingEntries[key]) {
+      _sharedMisses++;
+      _condition.wait(l, [entry] { return entry->_finished; });
+      if (entry->_renderer != nil) {
+        return entry->_renderer;
+      }
+      // The creating thread failed, create our own renderer.
+      l.unlock();
+      return [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
+    }
+
+    _misses++;
+    ASTextKitRendererCachePendingEntry *entry = [[ASTextKitRendererCachePendingEntry alloc] init];
+    _pendingEntries[key] = entry;
+    l.unlock();
+
+    // Wakes the waiting threads however this one leaves, so that they don't hang if creating the renderer throws.
+    PendingEntryFinisher finisher(*this, key, entry);
+
+    // Creating the renderer calculates its size, so don't block the other keys of this shard meanwhile.
+    ASTextKitRenderer *renderer = [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
+    finisher.renderer = renderer;
+    return renderer;
+  }
+
+  ASTextRendererCacheStatistics statistics()
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    return {_hits, _misses, _sharedMisses};
+  }
+
+private:
+  /// Publishes the renderer of a pending entry, or nil, when it goes out of scope.
+  struct PendingEntryFinisher {
+    PendingEntryFinisher(ASTextKitRendererCacheShard &shard, ASTextNodeRendererKey *key, ASTextKitRendererCachePendingEntry *entry)
+        : shard(shard), key(key), entry(entry) {}
+
+    ~PendingEntryFinisher()
+    {
+      {
+        std::lock_guard<std::mutex> l(shard._mutex);
+        entry->_renderer = renderer;
+        entry->_finished = YES;
+        [shard._pendingEntries removeObjectForKey:key];
+        if (renderer != nil) {
+          [shard._cache setObject:renderer forKey:key];
+        }
+      }
+      shard._condition.notify_all();
+    }
+
+    ASTextKitRendererCacheShard &shard;
+    ASTextNodeRendererKey *key;
+    ASTextKitRendererCachePendingEntry *entry;
+    ASTextKitRenderer *renderer = nil;
+  };
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  NSCache<ASTextNodeRendererKey *, ASTextKitRenderer *> *_cache;
+  NSMutableDictionary<ASTextNodeRendererKey *, ASTextKitRendererCachePendingEntry *> *_pendingEntries;
+  NSUInteger _hits;
+  NSUInteger _misses;
+  NSUInteger _sharedMisses;
+};
+
+} // namespace
+
+static ASTextKitRendererCacheShard *ASTextKitRendererCacheGetShards()
+{
+  static ASTextKitRendererCacheShard *shards;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    shards = new ASTextKitRendererCacheShard[ASTextKitRendererCacheShardCount];
+  });
+  return shards;
+}
+
+ASTextKitRenderer *ASTextKitRendererCacheGetRenderer(const ASTextKitAttributes &attributes, CGSize constrainedSize)
+{
+  ASTextNodeRendererKey *key = [[ASTextNodeRendererKey alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
+  ASTextKitRendererCacheShard &shard = ASTextKitRendererCacheGetShards()[key.hash & (ASTextKitRendererCacheShardCount - 1)];
+  return shard.renderer(key, attributes, constrainedSize);
+}
+
+ASTextRendererCacheStatistics ASTextKitRendererCacheGetStatistics(NSUInteger shard)
+{
+  NSCParameterAssert(shard < ASTextKitRendererCacheShardCount);
+  return ASTextKitRendererCacheGetShards()[shard].statistics();
+}
+
+#endif
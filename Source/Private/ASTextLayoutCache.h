@@ -0,0 +1,48 @@
+//
+//  ASTextLayoutCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASConfiguration.h>
+
+@class ASTextContainer, ASTextLayout;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The budget used when the configuration doesn't specify `textLayoutCacheByteLimit`.
+ */
+ASDK_EXTERN NSUInteger const ASTextLayoutCacheDefaultByteLimit;
+
+/**
+ * Returns a cached layout that is compatible with the given container and text, or creates and caches one.
+ *
+ * The cache is split into shards that are locked independently. Entries are keyed by the hash of the text plus the
+ * container size rounded to device pixels, are promoted on every hit, and are evicted least-recently-used first once a
+ * shard exceeds its share of the byte budget.
+ *
+ * NOTE: The text is copied before it is stored, so it is safe to pass a mutable string.
+ */
+ASDK_EXTERN ASTextLayout *ASTextLayoutCacheGetLayout(ASTextContainer *container, NSAttributedString *text);
+
+/**
+ * Estimated number of bytes retained by a layout. Used to charge entries against the cache budget.
+ */
+ASDK_EXTERN NSUInteger ASTextLayoutCacheEstimatedCost(ASTextLayout *layout);
+
+/**
+ * Counters aggregated across all shards.
+ */
+ASDK_EXTERN ASTextLayoutCacheStatistics ASTextLayoutCacheGetStatistics(void);
+
+/**
+ * Drops every cached layout. Counters are not reset.
+ */
+ASDK_EXTERN void ASTextLayoutCacheRemoveAllLayouts(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,314 @@
+//
+//  ASTextLayoutCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
+
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASEqualityHelpers.h>
+#import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+#import <climits>
+#import <unordered_map>
+
+NSUInteger const ASTextLayoutCacheDefaultByteLimit = 8 * 1024 * 1024;
+
+// Must be a power of two.
+static NSUInteger const kASTextLayoutCacheShardCount = 8;
+
+namespace {
+
+struct ASTextLayoutCacheKey {
+  NSUInteger textHash;
+  int32_t width;
+  int32_t height;
+
+  bool operator==(const ASTextLayoutCacheKey &other) const
+  {
+    return textHash == other.textHash && width == other.width && height == other.height;
+  }
+};
+
+struct ASTextLayoutCacheKeyHash {
+  size_t operator()(const ASTextLayoutCacheKey &key) const
+  {
+    NSUInteger hash = key.textHash;
+    hash = hash * 31 + (NSUInteger)key.width;
+    hash = hash * 31 + (NSUInteger)key.height;
+    return hash;
+  }
+};
+
+/**
+ * Rounds a container dimension to device pixels so that sizes which differ only by floating point noise share a key.
+ * Unbounded dimensions all map to the same value.
+ */
+static int32_t ASTextLayoutCacheQuantize(CGFloat value)
+{
+  CGFloat pixels = round(value * ASScreenScale());
+  if (pixels >= INT32_MAX || isnan(pixels)) {
+    return INT32_MAX;
+  }
+  return (int32_t)MAX(pixels, 0);
+}
+
+struct ASTextLayoutCacheEntry {
+  ASTextLayoutCacheKey key;
+  NSAttributedString *text;
+  ASTextLayout *layout;
+  NSUInteger cost;
+  ASTextLayoutCacheEntry *prev; // towards most recently used
+  ASTextLayoutCacheEntry *next; // towards least recently used
+};
+
+/**
+ * Returns whether `layout`, computed for its own container, can be used for `container`.
+ */
+static BOOL ASTextLayoutIsCompatible(ASTextLayout *layout, ASTextContainer *container)
+{
+  ASTextContainer *otherContainer = layout.container;
+  CGSize constrainedSize = otherContainer.size;
+  CGSize layoutSize = layout.textBoundingSize;
+  CGRect containerBounds = (CGRect){ .size = container.size };
+
+  // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
+  // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
+  //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
+  // 3. Thus, those two values (constrained width & returned width) form a range, where
+  //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
+  //    width is in that range, between the min and max of those two values.
+  CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(containerBounds, minRect)) {
+    return NO;
+  }
+  CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(maxRect, containerBounds)) {
+    return NO;
+  }
+
+  // Now check container params.
+  if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
+    return NO;
+  }
+  if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
+    return NO;
+  }
+  if (container.truncationType != otherContainer.truncationType) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
+    return NO;
+  }
+  return YES;
+}
+
+class ASTextLayoutCacheShard {
+public:
+  ASTextLayoutCacheShard() : _head(NULL), _tail(NULL), _cost(0), _costLimit(0), _hits(0), _misses(0), _evictions(0) {}
+
+  void setCostLimit(NSUInteger costLimit)
+  {
+    AS::MutexLocker l(_mutex);
+    _costLimit = costLimit;
+    trim();
+  }
+
+  ASTextLayout *find(const ASTextLayoutCacheKey &key, ASTextContainer *container, NSAttributedString *text, bool countMiss)
+  {
+    AS::MutexLocker l(_mutex);
+    auto range = _entries.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      ASTextLayoutCacheEntry *entry = it->second;
+      if (ASTextLayoutIsCompatible(entry->layout, container) && [entry->text isEqualToAttributedString:text]) {
+        _hits++;
+        moveToFront(entry);
+        return entry->layout;
+      }
+    }
+    if (countMiss) {
+      _misses++;
+    }
+    return nil;
+  }
+
+  void insert(const ASTextLayoutCacheKey &key, NSAttributedString *text, ASTextLayout *layout, NSUInteger cost)
+  {
+    AS::MutexLocker l(_mutex);
+    ASTextLayoutCacheEntry *entry = new ASTextLayoutCacheEntry{key, text, layout, cost, NULL, NULL};
+    _entries.emplace(key, entry);
+    linkAtFront(entry);
+    _cost += cost;
+    trim();
+  }
+
+  void removeAll()
+  {
+    AS::MutexLocker l(_mutex);
+    while (_tail != NULL) {
+      remove(_tail);
+    }
+  }
+
+  void addStatistics(ASTextLayoutCacheStatistics &statistics)
+  {
+    AS::MutexLocker l(_mutex);
+    statistics.hitCount += _hits;
+    statistics.missCount += _misses;
+    statistics.evictionCount += _evictions;
+    statistics.totalCost += _cost;
+  }
+
+private:
+  AS::Mutex _mutex;
+  std::unordered_multimap<ASTextLayoutCacheKey, ASTextLayoutCacheEntry *, ASTextLayoutCacheKeyHash> _entries;
+  ASTextLayoutCacheEntry *_head;
+  ASTextLayoutCacheEntry *_tail;
+  NSUInteger _cost;
+  NSUInteger _costLimit;
+  NSUInteger _hits;
+  NSUInteger _misses;
+  NSUInteger _evictions;
+
+  void linkAtFront(ASTextLayoutCacheEntry *entry)
+  {
+    entry->prev = NULL;
+    entry->next = _head;
+    if (_head != NULL) {
+      _head->prev = entry;
+    }
+    _head = entry;
+    if (_tail == NULL) {
+      _tail = entry;
+    }
+  }
+
+  void unlink(ASTextLayoutCacheEntry *entry)
+  {
+    if (entry->prev != NULL) {
+      entry->prev->next = entry->next;
+    } else {
+      _head = entry->next;
+    }
+    if (entry->next != NULL) {
+      entry->next->prev = entry->prev;
+    } else {
+      _tail = entry->prev;
+    }
+  }
+
+  void moveToFront(ASTextLayoutCacheEntry *entry)
+  {
+    if (entry != _head) {
+      unlink(entry);
+      linkAtFront(entry);
+    }
+  }
+
+  void remove(ASTextLayoutCacheEntry *entry)
+  {
+    auto range = _entries.equal_range(entry->key);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == entry) {
+        _entries.erase(it);
+        break;
+      }
+    }
+    unlink(entry);
+    _cost -= entry->cost;
+    delete entry;
+  }
+
+  // Always keeps the most recent entry, even if it alone is over budget.
+  void trim()
+  {
+    while (_cost > _costLimit && _tail != NULL && _tail != _head) {
+      remove(_tail);
+      _evictions++;
+    }
+  }
+};
+
+} // namespace
+
+static ASTextLayoutCacheShard *ASTextLayoutCacheGetShards()
+{
+  static ASTextLayoutCacheShard *shards;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    shards = new ASTextLayoutCacheShard[kASTextLayoutCacheShardCount];
+    NSUInteger byteLimit = ASConfigurationGetTextLayoutCacheByteLimit() ?: ASTextLayoutCacheDefaultByteLimit;
+    for (NSUInteger i = 0; i < kASTextLayoutCacheShardCount; i++) {
+      shards[i].setCostLimit(byteLimit / kASTextLayoutCacheShardCount);
+    }
+#if TARGET_OS_IOS || TARGET_OS_TV
+    // NSCache used to do this for us.
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification *note) {
+                                                    ASTextLayoutCacheRemoveAllLayouts();
+                                                  }];
+#endif
+  });
+  return shards;
+}
+
+ASTextLayout *ASTextLayoutCacheGetLayout(ASTextContainer *container, NSAttributedString *text)
+{
+  ASTextLayoutCacheShard *shards = ASTextLayoutCacheGetShards();
+  CGSize size = container.size;
+  ASTextLayoutCacheKey key = {text.hash, ASTextLayoutCacheQuantize(size.width), ASTextLayoutCacheQuantize(size.height)};
+  ASTextLayoutCacheShard &shard = shards[ASTextLayoutCacheKeyHash()(key) & (kASTextLayoutCacheShardCount - 1)];
+
+  if (ASTextLayout *layout = shard.find(key, container, text, true)) {
+    return layout;
+  }
+
+  // Cache Miss. Compute the text layout outside of the lock so other lookups in this shard can proceed.
+  NSAttributedString *textCopy = [text copy];
+  ASTextLayout *layout = [ASTextLayout layoutWithContainer:container text:textCopy];
+
+  // Another thread may have computed the same layout in the meantime. Prefer the cached one.
+  if (ASTextLayout *existing = shard.find(key, container, textCopy, false)) {
+    return existing;
+  }
+  shard.insert(key, textCopy, layout, ASTextLayoutCacheEstimatedCost(layout));
+  return layout;
+}
+
+NSUInteger ASTextLayoutCacheEstimatedCost(ASTextLayout *layout)
+{
+  // Rough footprint of an ASTextLayout: the object graph itself, a CTLine plus ASTextLine per line,
+  // and glyphs, positions and advances for every laid out character.
+  static NSUInteger const kBaseCost = 1024;
+  static NSUInteger const kLineCost = 256;
+  static NSUInteger const kCharacterCost = 48;
+  return kBaseCost + layout.lines.count * kLineCost + layout.visibleRange.length * kCharacterCost;
+}
+
+ASTextLayoutCacheStatistics ASTextLayoutCacheGetStatistics()
+{
+  ASTextLayoutCacheStatistics statistics = {0, 0, 0, 0};
+  ASTextLayoutCacheShard *shards = ASTextLayoutCacheGetShards();
+  for (NSUInteger i = 0; i < kASTextLayoutCacheShardCount; i++) {
+    shards[i].addStatistics(statistics);
+  }
+  return statistics;
+}
+
+void ASTextLayoutCacheRemoveAllLayouts()
+{
+  ASTextLayoutCacheShard *shards = ASTextLayoutCacheGetShards();
+  for (NSUInteger i = 0; i < kASTextLayoutCacheShardCount; i++) {
+    shards[i].removeAll();
+  }
+}
@@ -0,0 +1,405 @@
+//
+//  ASLayoutCore.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * The layout core is the arithmetic behind the layout specs, on plain value types and a plain node tree.
+ *
+ * It must not depend on Objective-C or on any Apple framework, so that it builds with nothing but a C++11 compiler.
+ * The layout core tests and benchmarks build and run on any platform, see "./build.sh layout-core". The layout specs
+ * delegate their math to it, so that layouts computed here match the ones computed on device.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace AS {
+namespace LayoutCore {
+
+#pragma mark - Values
+
+struct Size {
+  double width;
+  double height;
+};
+
+struct Point {
+  double x;
+  double y;
+};
+
+/** An inclusive range of sizes, see ASSizeRange. */
+struct SizeRange {
+  Size min;
+  Size max;
+};
+
+struct EdgeInsets {
+  double top;
+  double left;
+  double bottom;
+  double right;
+};
+
+/** A parent dimension that depends on the content, see ASLayoutElementParentDimensionUndefined. */
+const double kUndefined = std::numeric_limits<double>::quiet_NaN();
+const double kInfinity = std::numeric_limits<double>::infinity();
+
+const SizeRange kSizeRangeUnconstrained = {{0, 0}, {kInfinity, kInfinity}};
+
+inline bool operator==(const Size &lhs, const Size &rhs)
+{
+  return lhs.width == rhs.width && lhs.height == rhs.height;
+}
+
+inline bool operator==(const Point &lhs, const Point &rhs)
+{
+  return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+inline bool operator==(const SizeRange &lhs, const SizeRange &rhs)
+{
+  return lhs.min == rhs.min && lhs.max == rhs.max;
+}
+
+/** Clamps the size between the bounds of the range, see ASSizeRangeClamp. */
+Size clamp(const SizeRange &range, const Size &size);
+
+/**
+ * Intersects two size ranges. If they don't overlap in a dimension, the first range "wins" by returning the single
+ * point within its own range that is closest to the other range. See ASSizeRangeIntersect.
+ */
+SizeRange intersect(const SizeRange &range, const SizeRange &otherRange);
+
+/** Whether the value is a usable finite size, see ASPointsValidForSize. */
+bool isValidForSize(double points);
+
+/** Pixel rounding for the given screen scale, see ASFloorPixelValue and ASRoundPixelValue. */
+double floorPixelValue(double f, double scale);
+double roundPixelValue(double f, double scale);
+
+#pragma mark - Dimensions
+
+enum class DimensionUnit : int {
+  Auto,
+  Points,
+  Fraction,
+};
+
+/** See ASDimension. */
+struct Dimension {
+  DimensionUnit unit;
+  double value;
+
+  double resolve(double parentSize, double autoSize) const
+  {
+    switch (unit) {
+      case DimensionUnit::Auto:
+        return autoSize;
+      case DimensionUnit::Points:
+        return value;
+      case DimensionUnit::Fraction:
+        return value * parentSize;
+    }
+    return autoSize;
+  }
+};
+
+const Dimension kDimensionAuto = {DimensionUnit::Auto, 0};
+
+inline Dimension points(double value)
+{
+  return {DimensionUnit::Points, value};
+}
+
+inline Dimension fraction(double value)
+{
+  return {DimensionUnit::Fraction, value};
+}
+
+/** The size constraints of an element, see ASLayoutElementSize. */
+struct ElementSize {
+  Dimension width = kDimensionAuto;
+  Dimension height = kDimensionAuto;
+  Dimension minWidth = kDimensionAuto;
+  Dimension maxWidth = kDimensionAuto;
+  Dimension minHeight = kDimensionAuto;
+  Dimension maxHeight = kDimensionAuto;
+};
+
+/**
+ * Resolves the element size against the parent size. Auto min and max dimensions resolve to the auto range. Follows
+ * CSS: min overrides max overrides exact. See ASLayoutElementSizeResolveAutoSize.
+ */
+SizeRange resolve(const ElementSize &size, const Size &parentSize, const SizeRange &autoRange = kSizeRangeUnconstrained);
+
+#pragma mark - Layout Specs
+
+/** The size range the child of an inset spec is laid out in. */
+SizeRange insetChildSizeRange(const SizeRange &constrainedSize, const EdgeInsets &insets);
+
+/** The parent size the child of an inset spec resolves its dimensions against. */
+Size insetChildParentSize(const Size &parentSize, const EdgeInsets &insets);
+
+/** The size of an inset spec given the size of its child. */
+Size insetSize(const SizeRange &constrainedSize, const EdgeInsets &insets, const Size &childSize);
+
+/** The position of the child of an inset spec. Infinite insets center the child on that axis. */
+Point insetChildPosition(const SizeRange &constrainedSize, const EdgeInsets &insets, const Size &childSize, double scale);
+
+/**
+ * Picks the size closest to the ratio (height / width) that fits the constrained size. Returns false if there is no
+ * finite max size in either dimension, in which case the ratio can't be applied.
+ */
+bool ratioChildSize(const SizeRange &constrainedSize, double ratio, double scale, Size &outChildSize);
+
+/** See ASRelativeLayoutSpecPosition. */
+enum class RelativePosition : int {
+  None,
+  Start,
+  Center,
+  End,
+};
+
+/** See ASRelativeLayoutSpecSizingOption. */
+enum RelativeSizingOptions : unsigned {
+  RelativeSizingDefault = 0,
+  RelativeSizingMinimumWidth = 1 << 0,
+  RelativeSizingMinimumHeight = 1 << 1,
+};
+
+/** The parent size the child of a relative spec resolves its dimensions against. */
+Size relativeChildParentSize(const SizeRange &constrainedSize);
+
+/** The size range the child of a relative spec is laid out in. Positioned axes let the child be smaller. */
+SizeRange relativeChildSizeRange(const SizeRange &constrainedSize,
+                                 RelativePosition horizontalPosition,
+                                 RelativePosition verticalPosition);
+
+/** The size of a relative spec given the size of its child. */
+Size relativeSize(const SizeRange &constrainedSize, unsigned sizingOptions, const Size &childSize);
+
+/** The position of the child of a relative spec of the given size. */
+Point relativeChildPosition(const Size &size,
+                            const Size &childSize,
+                            RelativePosition horizontalPosition,
+                            RelativePosition verticalPosition,
+                            double scale);
+
+#pragma mark - Stack
+
+/** The raw values match ASStackLayoutDirection and the other stack enums. */
+enum class StackDirection : int { Vertical, Horizontal };
+enum class StackJustifyContent : int { Start, Center, End, SpaceBetween, SpaceAround };
+enum class StackAlignItems : int { Start, End, Center, Stretch, BaselineFirst, BaselineLast, NotSet };
+enum class StackAlignSelf : int { Auto, Start, End, Center, Stretch };
+enum class StackFlexWrap : int { NoWrap, Wrap };
+enum class StackAlignContent : int { Start, Center, End, SpaceBetween, SpaceAround, Stretch };
+
+/** The threshold that determines if a violation has actually occurred, see kViolationEpsilon. */
+const double kStackViolationEpsilon = 0.01;
+
+/**
+ * The distance to add to a sum to bring it within [min, max]. Positive if the sum is too small, negative if it is too
+ * large and zero otherwise. See ASStackUnpositionedLayout::computeStackViolation.
+ */
+double stackViolation(double sum, double min, double max);
+
+/** Offset of the first line and spacing between lines along the cross axis, see ASStackLayoutAlignContent. */
+void stackLineOffsetAndSpacing(size_t numberOfLines,
+                               double crossViolation,
+                               StackAlignContent alignContent,
+                               double &offset,
+                               double &spacing);
+
+/** Offset of the first item and spacing between items of a line, see ASStackLayoutJustifyContent. */
+void stackItemOffsetAndSpacing(size_t numberOfItems,
+                               double stackViolation,
+                               StackJustifyContent justifyContent,
+                               double &offset,
+                               double &spacing);
+
+#pragma mark - Node Tree
+
+enum class NodeType : int {
+  /** Measured by its measure function, see -calculateSizeThatFits:. */
+  Leaf,
+  Inset,
+  Ratio,
+  Relative,
+  Stack,
+};
+
+struct Node;
+
+/** Returns the size of a leaf for the max size it may take. The result is clamped to the constrained size. */
+typedef Size (*MeasureFunction)(const Node &node, const Size &maxSize, void *context);
+
+/** The parameters of a stack, see ASStackLayoutSpec. */
+struct StackStyle {
+  StackDirection direction = StackDirection::Horizontal;
+  double spacing = 0;
+  StackJustifyContent justifyContent = StackJustifyContent::Start;
+  StackAlignItems alignItems = StackAlignItems::Stretch;
+  StackFlexWrap flexWrap = StackFlexWrap::NoWrap;
+  StackAlignContent alignContent = StackAlignContent::Start;
+  double lineSpacing = 0;
+};
+
+/** The style of a node as a child of its parent, see ASLayoutElementStyle. */
+struct Style {
+  ElementSize size;
+  double spacingBefore = 0;
+  double spacingAfter = 0;
+  double flexGrow = 0;
+  double flexShrink = 0;
+  Dimension flexBasis = kDimensionAuto;
+  StackAlignSelf alignSelf = StackAlignSelf::Auto;
+  double ascender = 0;
+  double descender = 0;
+};
+
+/**
+ * A layout element. Only the fields of the node's type are used. Nodes don't own their children, so the same tree can
+ * be laid out any number of times and from any number of threads.
+ */
+struct Node {
+  NodeType type = NodeType::Leaf;
+  Style style;
+  std::vector<const Node *> children;
+
+  // Leaf
+  MeasureFunction measure = nullptr;
+  void *context = nullptr;
+
+  // Inset
+  EdgeInsets insets = {0, 0, 0, 0};
+
+  // Ratio
+  double ratio = 1;
+
+  // Relative
+  RelativePosition horizontalPosition = RelativePosition::None;
+  RelativePosition verticalPosition = RelativePosition::None;
+  unsigned sizingOptions = RelativeSizingDefault;
+
+  // Stack
+  StackStyle stack;
+};
+
+/** The computed layout of a node, see ASLayout. Positions are relative to the parent. */
+struct Layout {
+  const Node *node;
+  Size size;
+  Point position;
+  std::vector<Layout> sublayouts;
+};
+
+/**
+ * Lays out the node and its subtree within the constrained size. Dimensions relative to the parent resolve against
+ * parentSize, which may be kUndefined in either dimension. See -layoutThatFits:parentSize:.
+ *
+ * @param scale The screen scale that pixel rounding uses.
+ */
+Layout layout(const Node &node, const SizeRange &constrainedSize, const Size &parentSize, double scale);
+
+/** Lays out the node with its parent size being the max constrained size. */
+inline Layout layout(const Node &node, const SizeRange &constrainedSize, double scale)
+{
+  return layout(node, constrainedSize, constrainedSize.max, scale);
+}
+
+#pragma mark - Arena
+
+/**
+ * The computed layout of a node within a LayoutArena. Positions are relative to the parent. The frame's children are
+ * the childCount frames starting at firstChild, in the order of the node's children.
+ */
+struct Frame {
+  const Node *node;
+  Size size;
+  Point position;
+  uint32_t firstChild;
+  uint32_t childCount;
+};
+
+/**
+ * Contiguous storage for the frames of one layout pass.
+ *
+ * A Layout tree allocates a vector of sublayouts for every node with children, and frees all of them again when it
+ * goes away. An arena instead appends every frame to a single buffer, and drops all of them at once when the next pass
+ * starts, keeping the buffer. An arena that is reused across passes stops allocating once it has grown to fit the
+ * largest pass. Frames of children that were measured more than once, e.g. while flexing a stack, stay in the buffer
+ * until then.
+ *
+ * An arena is not thread safe, use one arena per thread.
+ */
+class LayoutArena {
+public:
+  /** The root frame of the last pass. Only valid until the next pass. */
+  const Frame &root() const
+  {
+    return _frames.back();
+  }
+
+  const Frame *childrenBegin(const Frame &frame) const
+  {
+    return _frames.data() + frame.firstChild;
+  }
+
+  const Frame *childrenEnd(const Frame &frame) const
+  {
+    return _frames.data() + frame.firstChild + frame.childCount;
+  }
+
+  /** The number of frames appended by the last pass, including superseded ones. */
+  size_t size() const
+  {
+    return _frames.size();
+  }
+
+  /** The number of frames that fit before the arena has to allocate. */
+  size_t capacity() const
+  {
+    return _frames.capacity();
+  }
+
+  /** Drops all frames at once, keeping the storage for the next pass. */
+  void reset()
+  {
+    _frames.clear();
+  }
+
+  /** Converts the frame and its subtree into a Layout tree, for callers that need to own the result. */
+  Layout materialize(const Frame &frame) const;
+
+  /** Appends the frames contiguously and returns the index of the first one. */
+  uint32_t append(const Frame *frames, size_t count);
+
+private:
+  std::vector<Frame> _frames;
+};
+
+/**
+ * Like layout(), but writes the frames into the arena instead of allocating a Layout tree. Resets the arena first, so
+ * the frames of the previous pass are dropped. Returns the root frame, which stays valid until the next pass.
+ */
+const Frame &layout(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, const Size &parentSize,
+                    double scale);
+
+/** Lays out the node into the arena with its parent size being the max constrained size. */
+inline const Frame &layout(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, double scale)
+{
+  return layout(arena, node, constrainedSize, constrainedSize.max, scale);
+}
+
+} // namespace LayoutCore
+} // namespace AS
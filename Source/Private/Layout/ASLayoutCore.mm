@@ -0,0 +1,928 @@
+//
+//  ASLayoutCore.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASLayoutCore.h.
+#include "ASLayoutCore.h"
+
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+namespace AS {
+namespace LayoutCore {
+
+#pragma mark - Values
+
+// Same as the MAX and MIN macros, including how NaN is treated, so that results match the layout specs exactly.
+static inline double maxOf(double a, double b)
+{
+  return a > b ? a : b;
+}
+
+static inline double minOf(double a, double b)
+{
+  return a < b ? a : b;
+}
+
+Size clamp(const SizeRange &range, const Size &size)
+{
+  return {maxOf(range.min.width, minOf(range.max.width, size.width)),
+          maxOf(range.min.height, minOf(range.max.height, size.height))};
+}
+
+/**
+ * Intersects one dimension. If the other range does not overlap, this range "wins" by returning a single point within
+ * its own range that is closest to the non-overlapping range.
+ */
+static void intersectDimension(double min, double max, double otherMin, double otherMax, double &outMin, double &outMax)
+{
+  const double newMin = maxOf(min, otherMin);
+  const double newMax = minOf(max, otherMax);
+  if (newMin <= newMax) {
+    outMin = newMin;
+    outMax = newMax;
+  } else if (min < otherMin) {
+    // No intersection. If we're before the other range, return our max; otherwise our min.
+    outMin = outMax = max;
+  } else {
+    outMin = outMax = min;
+  }
+}
+
+SizeRange intersect(const SizeRange &range, const SizeRange &otherRange)
+{
+  SizeRange result;
+  intersectDimension(range.min.width, range.max.width, otherRange.min.width, otherRange.max.width,
+                     result.min.width, result.max.width);
+  intersectDimension(range.min.height, range.max.height, otherRange.min.height, otherRange.max.height,
+                     result.min.height, result.max.height);
+  return result;
+}
+
+bool isValidForSize(double points)
+{
+  return ((std::isnormal(points) || points == 0.0) && points >= 0.0 && points < 10000000.0);
+}
+
+double floorPixelValue(double f, double scale)
+{
+  return std::floor((f + FLT_EPSILON) * scale) / scale;
+}
+
+double roundPixelValue(double f, double scale)
+{
+  return std::round(f * scale) / scale;
+}
+
+#pragma mark - Dimensions
+
+/** Follow CSS: min overrides max overrides exact. Exact may be NaN if it isn't set. */
+static void constrainDimension(double minVal, double exactVal, double maxVal, double &outMin, double &outMax)
+{
+  // Avoid use of min/max primitives since they're harder to reason about in the presence of NaN (in exactVal).
+  outMin = minVal;
+  outMax = maxVal;
+  if (maxVal <= minVal) {
+    // min overrides max and exactVal is irrelevant
+    outMax = minVal;
+    return;
+  }
+  if (std::isnan(exactVal)) {
+    // no exact value, so leave as a min/max range
+    return;
+  }
+  if (exactVal > maxVal) {
+    outMin = maxVal;
+  } else if (exactVal < minVal) {
+    outMax = minVal;
+  } else {
+    outMin = outMax = exactVal;
+  }
+}
+
+SizeRange resolve(const ElementSize &size, const Size &parentSize, const SizeRange &autoRange)
+{
+  SizeRange range;
+  constrainDimension(size.minWidth.resolve(parentSize.width, autoRange.min.width),
+                     size.width.resolve(parentSize.width, kUndefined),
+                     size.maxWidth.resolve(parentSize.width, autoRange.max.width),
+                     range.min.width, range.max.width);
+  constrainDimension(size.minHeight.resolve(parentSize.height, autoRange.min.height),
+                     size.height.resolve(parentSize.height, kUndefined),
+                     size.maxHeight.resolve(parentSize.height, autoRange.max.height),
+                     range.min.height, range.max.height);
+  return range;
+}
+
+#pragma mark - Inset
+
+/* Returns f if f is finite, substitute otherwise */
+static double finite(double f, double substitute)
+{
+  return std::isinf(f) ? substitute : f;
+}
+
+/* Returns f if f is finite, 0 otherwise */
+static double finiteOrZero(double f)
+{
+  return finite(f, 0);
+}
+
+/* Returns the inset required to center 'inner' in 'outer' */
+static double centerInset(double outer, double inner, double scale)
+{
+  return roundPixelValue((outer - inner) / 2, scale);
+}
+
+SizeRange insetChildSizeRange(const SizeRange &constrainedSize, const EdgeInsets &insets)
+{
+  const double insetsX = finiteOrZero(insets.left) + finiteOrZero(insets.right);
+  const double insetsY = finiteOrZero(insets.top) + finiteOrZero(insets.bottom);
+
+  // if either x-axis inset is infinite, let child be intrinsic width
+  const double minWidth = (std::isinf(insets.left) || std::isinf(insets.right)) ? 0 : constrainedSize.min.width;
+  // if either y-axis inset is infinite, let child be intrinsic height
+  const double minHeight = (std::isinf(insets.top) || std::isinf(insets.bottom)) ? 0 : constrainedSize.min.height;
+
+  return {
+    {maxOf(0, minWidth - insetsX), maxOf(0, minHeight - insetsY)},
+    {maxOf(0, constrainedSize.max.width - insetsX), maxOf(0, constrainedSize.max.height - insetsY)},
+  };
+}
+
+Size insetChildParentSize(const Size &parentSize, const EdgeInsets &insets)
+{
+  const double insetsX = finiteOrZero(insets.left) + finiteOrZero(insets.right);
+  const double insetsY = finiteOrZero(insets.top) + finiteOrZero(insets.bottom);
+  return {maxOf(0, parentSize.width - insetsX), maxOf(0, parentSize.height - insetsY)};
+}
+
+Size insetSize(const SizeRange &constrainedSize, const EdgeInsets &insets, const Size &childSize)
+{
+  return clamp(constrainedSize, {
+    finite(childSize.width + insets.left + insets.right, constrainedSize.max.width),
+    finite(childSize.height + insets.top + insets.bottom, constrainedSize.max.height),
+  });
+}
+
+Point insetChildPosition(const SizeRange &constrainedSize, const EdgeInsets &insets, const Size &childSize, double scale)
+{
+  const double x = finite(insets.left, constrainedSize.max.width -
+                          (finite(insets.right, centerInset(constrainedSize.max.width, childSize.width, scale)) + childSize.width));
+  const double y = finite(insets.top, constrainedSize.max.height -
+                          (finite(insets.bottom, centerInset(constrainedSize.max.height, childSize.height, scale)) + childSize.height));
+  return {x, y};
+}
+
+#pragma mark - Ratio
+
+bool ratioChildSize(const SizeRange &constrainedSize, double ratio, double scale, Size &outChildSize)
+{
+  Size sizeOptions[2];
+  size_t count = 0;
+
+  if (isValidForSize(constrainedSize.max.width)) {
+    sizeOptions[count++] = clamp(constrainedSize, {
+      constrainedSize.max.width,
+      floorPixelValue(ratio * constrainedSize.max.width, scale)
+    });
+  }
+
+  if (isValidForSize(constrainedSize.max.height)) {
+    sizeOptions[count++] = clamp(constrainedSize, {
+      floorPixelValue(constrainedSize.max.height / ratio, scale),
+      constrainedSize.max.height
+    });
+  }
+
+  if (count == 0) {
+    return false;
+  }
+
+  // Choose the size closest to the desired ratio. Ties go to the first option, like std::max_element.
+  const auto distance = [&](const Size &size) { return std::fabs((size.height / size.width) - ratio); };
+  outChildSize = sizeOptions[0];
+  if (count == 2 && distance(outChildSize) > distance(sizeOptions[1])) {
+    outChildSize = sizeOptions[1];
+  }
+  return true;
+}
+
+#pragma mark - Relative
+
+static double proportionOfAxisForPosition(RelativePosition position)
+{
+  switch (position) {
+    case RelativePosition::Center:
+      return 0.5;
+    case RelativePosition::End:
+      return 1.0;
+    case RelativePosition::None:
+    case RelativePosition::Start:
+      return 0.0;
+  }
+  return 0.0;
+}
+
+Size relativeChildParentSize(const SizeRange &constrainedSize)
+{
+  // If we have a finite size in any direction, pass this so that the child can resolve percentages against it.
+  // Otherwise pass kUndefined as the size will depend on the content.
+  return {
+    isValidForSize(constrainedSize.max.width) ? constrainedSize.max.width : kUndefined,
+    isValidForSize(constrainedSize.max.height) ? constrainedSize.max.height : kUndefined,
+  };
+}
+
+SizeRange relativeChildSizeRange(const SizeRange &constrainedSize,
+                                 RelativePosition horizontalPosition,
+                                 RelativePosition verticalPosition)
+{
+  return {
+    {
+      (horizontalPosition != RelativePosition::None) ? 0 : constrainedSize.min.width,
+      (verticalPosition != RelativePosition::None) ? 0 : constrainedSize.min.height,
+    },
+    constrainedSize.max
+  };
+}
+
+Size relativeSize(const SizeRange &constrainedSize, unsigned sizingOptions, const Size &childSize)
+{
+  const Size parentSize = relativeChildParentSize(constrainedSize);
+
+  // If we have an undetermined height or width, use the child size to define the layout size
+  Size size = clamp(constrainedSize, {
+    std::isfinite(parentSize.width) ? parentSize.width : childSize.width,
+    std::isfinite(parentSize.height) ? parentSize.height : childSize.height
+  });
+
+  // If minimum size options are set, attempt to shrink the size to the size of the child
+  return clamp(constrainedSize, {
+    minOf(size.width, (sizingOptions & RelativeSizingMinimumWidth) != 0 ? childSize.width : size.width),
+    minOf(size.height, (sizingOptions & RelativeSizingMinimumHeight) != 0 ? childSize.height : size.height)
+  });
+}
+
+Point relativeChildPosition(const Size &size,
+                            const Size &childSize,
+                            RelativePosition horizontalPosition,
+                            RelativePosition verticalPosition,
+                            double scale)
+{
+  return {
+    roundPixelValue((size.width - childSize.width) * proportionOfAxisForPosition(horizontalPosition), scale),
+    roundPixelValue((size.height - childSize.height) * proportionOfAxisForPosition(verticalPosition), scale)
+  };
+}
+
+#pragma mark - Stack
+
+double stackViolation(double sum, double min, double max)
+{
+  if (sum < min) {
+    return min - sum;
+  } else if (sum > max) {
+    return max - sum;
+  }
+  return 0;
+}
+
+void stackLineOffsetAndSpacing(size_t numberOfLines,
+                               double crossViolation,
+                               StackAlignContent alignContent,
+                               double &offset,
+                               double &spacing)
+{
+  // Handle edge cases
+  if (alignContent == StackAlignContent::SpaceBetween && (crossViolation < kStackViolationEpsilon || numberOfLines == 1)) {
+    alignContent = StackAlignContent::Start;
+  } else if (alignContent == StackAlignContent::SpaceAround && (crossViolation < kStackViolationEpsilon || numberOfLines == 1)) {
+    alignContent = StackAlignContent::Center;
+  }
+
+  offset = 0;
+  spacing = 0;
+
+  switch (alignContent) {
+    case StackAlignContent::Center:
+      offset = crossViolation / 2;
+      break;
+    case StackAlignContent::End:
+      offset = crossViolation;
+      break;
+    case StackAlignContent::SpaceBetween:
+      // Spacing between the lines, no spaces at the edges, evenly distributed
+      spacing = crossViolation / (numberOfLines - 1);
+      break;
+    case StackAlignContent::SpaceAround: {
+      // Spacing between lines are twice the spacing on the edges
+      const double spacingUnit = crossViolation / (numberOfLines * 2);
+      offset = spacingUnit;
+      spacing = spacingUnit * 2;
+      break;
+    }
+    case StackAlignContent::Start:
+    case StackAlignContent::Stretch:
+      break;
+  }
+}
+
+void stackItemOffsetAndSpacing(size_t numberOfItems,
+                               double stackViolation,
+                               StackJustifyContent justifyContent,
+                               double &offset,
+                               double &spacing)
+{
+  // Handle edge cases
+  if (justifyContent == StackJustifyContent::SpaceBetween && (stackViolation < kStackViolationEpsilon || numberOfItems == 1)) {
+    justifyContent = StackJustifyContent::Start;
+  } else if (justifyContent == StackJustifyContent::SpaceAround && (stackViolation < kStackViolationEpsilon || numberOfItems == 1)) {
+    justifyContent = StackJustifyContent::Center;
+  }
+
+  offset = 0;
+  spacing = 0;
+
+  switch (justifyContent) {
+    case StackJustifyContent::Center:
+      offset = stackViolation / 2;
+      break;
+    case StackJustifyContent::End:
+      offset = stackViolation;
+      break;
+    case StackJustifyContent::SpaceBetween:
+      // Spacing between the items, no spaces at the edges, evenly distributed
+      spacing = stackViolation / (numberOfItems - 1);
+      break;
+    case StackJustifyContent::SpaceAround: {
+      // Spacing between items are twice the spacing on the edges
+      const double spacingUnit = stackViolation / (numberOfItems * 2);
+      offset = spacingUnit;
+      spacing = spacingUnit * 2;
+      break;
+    }
+    case StackJustifyContent::Start:
+      break;
+  }
+}
+
+#pragma mark - Node Tree
+
+namespace {
+
+Frame layoutFrame(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, const Size &parentSize,
+                  double scale);
+
+/**
+ * Lays out a stack the way ASStackUnpositionedLayout and ASStackPositionedLayout do, on the node tree. Children are
+ * always measured serially.
+ */
+class StackLayout {
+public:
+  StackLayout(LayoutArena &arena, const Node &node, const SizeRange &sizeRange, double scale)
+  : _arena(arena), _style(node.stack), _vertical(node.stack.direction == StackDirection::Vertical), _sizeRange(sizeRange), _scale(scale)
+  {
+    // If we have a fixed size in either dimension, pass it to children so they can resolve percentages against it.
+    // Otherwise, we pass kUndefined since it will depend on the content.
+    _parentSize = {
+      (sizeRange.min.width == sizeRange.max.width) ? sizeRange.min.width : kUndefined,
+      (sizeRange.min.height == sizeRange.max.height) ? sizeRange.min.height : kUndefined,
+    };
+  }
+
+  Frame compute(const Node &node)
+  {
+    // We may be able to avoid some redundant layout passes
+    size_t flexibleChildren = 0;
+    for (const Node *child : node.children) {
+      flexibleChildren += isFlexibleInBothDirections(*child) ? 1 : 0;
+    }
+    const bool optimizedFlexing = (flexibleChildren == 1
+                                   && stackDimension(_sizeRange.min) == stackDimension(_sizeRange.max));
+
+    std::vector<Item> items;
+    items.reserve(node.children.size());
+    for (const Node *child : node.children) {
+      items.push_back({child, {child, {0, 0}, {0, 0}, 0, 0}});
+    }
+
+    layoutItemsAlongUnconstrainedStackDimension(items, optimizedFlexing);
+    std::vector<Line> lines = collectItemsIntoLines(std::move(items));
+    for (auto &line : lines) {
+      flexLineAlongStackDimension(line.items, optimizedFlexing);
+    }
+    computeLinesCrossSizeAndBaseline(lines);
+    stretchLinesAlongCrossDimension(lines);
+
+    double layoutStackDimensionSum = 0;
+    for (auto &line : lines) {
+      line.stackDimensionSum = itemsStackDimensionSum(line.items);
+      layoutStackDimensionSum = maxOf(line.stackDimensionSum, layoutStackDimensionSum);
+    }
+    const double layoutCrossDimensionSum = linesCrossDimensionSum(lines);
+
+    return position(node, lines, layoutStackDimensionSum, layoutCrossDimensionSum);
+  }
+
+private:
+  struct Item {
+    const Node *child;
+    Frame layout;
+  };
+
+  struct Line {
+    std::vector<Item> items;
+    double stackDimensionSum;
+    double crossSize;
+    double baseline;
+  };
+
+  LayoutArena &_arena;
+  const StackStyle &_style;
+  const bool _vertical;
+  const SizeRange _sizeRange;
+  const double _scale;
+  Size _parentSize;
+
+  double stackDimension(const Size &size) const
+  {
+    return _vertical ? size.height : size.width;
+  }
+
+  double crossDimension(const Size &size) const
+  {
+    return _vertical ? size.width : size.height;
+  }
+
+  Size directionSize(double stack, double cross) const
+  {
+    return _vertical ? Size{cross, stack} : Size{stack, cross};
+  }
+
+  Point directionPoint(double stack, double cross) const
+  {
+    return _vertical ? Point{cross, stack} : Point{stack, cross};
+  }
+
+  StackAlignItems alignment(const Node &child) const
+  {
+    switch (child.style.alignSelf) {
+      case StackAlignSelf::Center:
+        return StackAlignItems::Center;
+      case StackAlignSelf::End:
+        return StackAlignItems::End;
+      case StackAlignSelf::Start:
+        return StackAlignItems::Start;
+      case StackAlignSelf::Stretch:
+        return StackAlignItems::Stretch;
+      case StackAlignSelf::Auto:
+        return _style.alignItems;
+    }
+    return _style.alignItems;
+  }
+
+  static bool isFlexibleInBothDirections(const Node &child)
+  {
+    return child.style.flexGrow > 0 && child.style.flexShrink > 0;
+  }
+
+  bool isBaselineAligned(const Item &item) const
+  {
+    const StackAlignItems alignItems = alignment(*item.child);
+    return alignItems == StackAlignItems::BaselineFirst || alignItems == StackAlignItems::BaselineLast;
+  }
+
+  double baselineForItem(const Item &item) const
+  {
+    switch (alignment(*item.child)) {
+      case StackAlignItems::BaselineFirst:
+        return item.child->style.ascender;
+      case StackAlignItems::BaselineLast:
+        return crossDimension(item.layout.size) + item.child->style.descender;
+      default:
+        return 0;
+    }
+  }
+
+  Frame crossChildLayout(const Node &child, double stackMin, double stackMax, double crossMin, double crossMax) const
+  {
+    double childCrossMin = 0;
+    double childCrossMax = crossMax;
+    if (alignment(child) == StackAlignItems::Stretch) {
+      // stretched children will have a cross dimension of at least crossMin, unless they explicitly define a child
+      // size that is smaller than the constraint of the parent. They may have a cross direction max that is smaller
+      // than the minimum size constraint of the parent.
+      const SizeRange resolved = resolve(child.style.size, {kUndefined, kUndefined});
+      const double resolvedMin = crossDimension(resolved.min);
+      const double resolvedMax = crossDimension(resolved.max);
+      childCrossMin = resolvedMin != 0 ? resolvedMin : crossMin;
+      childCrossMax = resolvedMax == kInfinity ? crossMax : resolvedMax;
+    }
+    const SizeRange childSizeRange = {directionSize(stackMin, childCrossMin), directionSize(stackMax, childCrossMax)};
+    return layoutFrame(_arena, child, childSizeRange, _parentSize, _scale);
+  }
+
+  void layoutItemsAlongUnconstrainedStackDimension(std::vector<Item> &items, bool optimizedFlexing) const
+  {
+    const double minCrossDimension = crossDimension(_sizeRange.min);
+    const double maxCrossDimension = crossDimension(_sizeRange.max);
+    const double parentStackDimension = stackDimension(_parentSize);
+    for (auto &item : items) {
+      const Node &child = *item.child;
+      if (optimizedFlexing && isFlexibleInBothDirections(child)) {
+        item.layout = {&child, {0, 0}, {0, 0}, 0, 0};
+      } else {
+        item.layout = crossChildLayout(child,
+                                       child.style.flexBasis.resolve(parentStackDimension, 0),
+                                       child.style.flexBasis.resolve(parentStackDimension, kInfinity),
+                                       minCrossDimension,
+                                       maxCrossDimension);
+      }
+    }
+  }
+
+  double itemsStackDimensionSum(const std::vector<Item> &items) const
+  {
+    // Start from default spacing between each child, then sum up the children's spacing and dimensions.
+    double sum = items.empty() ? 0 : _style.spacing * (items.size() - 1);
+    for (const auto &item : items) {
+      sum = sum + item.child->style.spacingBefore + item.child->style.spacingAfter;
+    }
+    for (const auto &item : items) {
+      sum = sum + stackDimension(item.layout.size);
+    }
+    return sum;
+  }
+
+  double linesCrossDimensionSum(const std::vector<Line> &lines) const
+  {
+    double sum = lines.empty() ? 0 : _style.lineSpacing * (lines.size() - 1);
+    for (const auto &line : lines) {
+      sum = sum + line.crossSize;
+    }
+    return sum;
+  }
+
+  double computeStackViolation(double sum) const
+  {
+    return stackViolation(sum, stackDimension(_sizeRange.min), stackDimension(_sizeRange.max));
+  }
+
+  double computeCrossViolation(double sum) const
+  {
+    return stackViolation(sum, crossDimension(_sizeRange.min), crossDimension(_sizeRange.max));
+  }
+
+  std::vector<Line> collectItemsIntoLines(std::vector<Item> &&items) const
+  {
+    std::vector<Line> lines;
+    if (_style.flexWrap == StackFlexWrap::NoWrap) {
+      lines.push_back({std::move(items), 0, 0, 0});
+      return lines;
+    }
+
+    std::vector<Item> lineItems;
+    double lineStackDimensionSum = 0;
+    double interitemSpacing = 0;
+    for (auto &item : items) {
+      const double itemAndSpacingStackDimension = (item.child->style.spacingBefore + stackDimension(item.layout.size)
+                                                   + item.child->style.spacingAfter);
+      const bool negativeViolationIfAddItem = (computeStackViolation(lineStackDimensionSum + interitemSpacing + itemAndSpacingStackDimension) < 0);
+      if (negativeViolationIfAddItem && !lineItems.empty()) {
+        lines.push_back({std::move(lineItems), 0, 0, 0});
+        lineItems.clear();
+        lineStackDimensionSum = 0;
+        interitemSpacing = 0;
+      }
+      lineItems.push_back(std::move(item));
+      lineStackDimensionSum += interitemSpacing + itemAndSpacingStackDimension;
+      interitemSpacing = _style.spacing;
+    }
+    lines.push_back({std::move(lineItems), 0, 0, 0});
+    return lines;
+  }
+
+  void flexLineAlongStackDimension(std::vector<Item> &items, bool optimizedFlexing) const
+  {
+    const size_t count = items.size();
+    const double violation = computeStackViolation(itemsStackDimensionSum(items));
+    std::vector<double> adjustments(count);
+
+    double flexFactorSum = 0;
+    if (std::fabs(violation) >= kStackViolationEpsilon) {
+      const bool grow = violation > 0;
+      for (const auto &item : items) {
+        flexFactorSum += grow ? item.child->style.flexGrow : item.child->style.flexShrink;
+      }
+      if (flexFactorSum != 0 && grow) {
+        for (size_t i = 0; i < count; i++) {
+          adjustments[i] = std::floor(violation * (items[i].child->style.flexGrow / flexFactorSum));
+        }
+      } else if (flexFactorSum != 0) {
+        double scaledFlexShrinkFactorSum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+          adjustments[i] = stackDimension(items[i].layout.size) * (items[i].child->style.flexShrink / flexFactorSum);
+          scaledFlexShrinkFactorSum += adjustments[i];
+        }
+        for (size_t i = 0; i < count; i++) {
+          if (scaledFlexShrinkFactorSum == 0.0) {
+            adjustments[i] = 0.0;
+          } else {
+            adjustments[i] = -std::fabs((adjustments[i] / scaledFlexShrinkFactorSum) * violation);
+          }
+        }
+      }
+    }
+
+    // If no items are able to flex then there is nothing left to do with this line. Bail.
+    if (flexFactorSum == 0) {
+      // If optimized flexing was used then we have to clean up the unsized items and lay them out at zero size.
+      if (optimizedFlexing) {
+        for (auto &item : items) {
+          if (isFlexibleInBothDirections(*item.child)) {
+            item.layout = crossChildLayout(*item.child, 0, 0, crossDimension(_sizeRange.min), crossDimension(_sizeRange.max));
+          }
+        }
+      }
+      return;
+    }
+
+    // Compute any remaining violation to the first flexible item.
+    double remainingViolation = violation;
+    for (size_t i = 0; i < count; i++) {
+      remainingViolation -= adjustments[i];
+    }
+
+    size_t firstFlexItem = count;
+    for (size_t i = 0; i < count; i++) {
+      // Items are consider inflexible if they do not need to make a flex adjustment.
+      if (adjustments[i] != 0) {
+        firstFlexItem = i;
+        break;
+      }
+    }
+    if (firstFlexItem == count) {
+      return;
+    }
+    // Only apply the remaining violation for the first flexible item that has a flex grow factor.
+    const double firstFlexItemRemainingViolation = (items[firstFlexItem].child->style.flexGrow > 0 ? remainingViolation : 0);
+
+    for (size_t i = 0; i < count; i++) {
+      if (adjustments[i] != 0) {
+        auto &item = items[i];
+        const double flexedStackSize = (stackDimension(item.layout.size) + adjustments[i]
+                                        + (i == firstFlexItem ? firstFlexItemRemainingViolation : 0));
+        item.layout = crossChildLayout(*item.child,
+                                       maxOf(flexedStackSize, 0),
+                                       maxOf(flexedStackSize, 0),
+                                       crossDimension(_sizeRange.min),
+                                       crossDimension(_sizeRange.max));
+      }
+    }
+  }
+
+  void computeLinesCrossSizeAndBaseline(std::vector<Line> &lines) const
+  {
+    const bool isSingleLine = (lines.size() == 1);
+    const double minCrossSize = crossDimension(_sizeRange.min);
+    const double maxCrossSize = crossDimension(_sizeRange.max);
+
+    // If the stack is single-line and has a definite cross size, the cross size of the line is the stack's definite
+    // cross size.
+    if (isSingleLine && minCrossSize == maxCrossSize) {
+      auto &line = lines[0];
+      line.crossSize = minCrossSize;
+      for (const auto &item : line.items) {
+        if (isBaselineAligned(item)) {
+          line.baseline = maxOf(line.baseline, baselineForItem(item));
+        }
+      }
+      return;
+    }
+
+    for (auto &line : lines) {
+      double maxStartToBaselineDistance = 0;
+      double maxBaselineToEndDistance = 0;
+      double maxItemCrossSize = 0;
+      for (const auto &item : line.items) {
+        if (isBaselineAligned(item)) {
+          const double baseline = baselineForItem(item);
+          maxStartToBaselineDistance = maxOf(maxStartToBaselineDistance, baseline);
+          maxBaselineToEndDistance = maxOf(maxBaselineToEndDistance, crossDimension(item.layout.size) - baseline);
+        } else {
+          maxItemCrossSize = maxOf(maxItemCrossSize, crossDimension(item.layout.size));
+        }
+      }
+      line.crossSize = maxOf(maxStartToBaselineDistance + maxBaselineToEndDistance, maxItemCrossSize);
+      if (isSingleLine) {
+        // If the stack is single-line, then clamp the line’s cross-size to be within the stack's min and max
+        // cross-size properties.
+        line.crossSize = minOf(maxOf(minCrossSize, line.crossSize), maxCrossSize);
+      }
+      line.baseline = maxStartToBaselineDistance;
+    }
+  }
+
+  void stretchLinesAlongCrossDimension(std::vector<Line> &lines) const
+  {
+    const size_t numberOfLines = lines.size();
+    const double violation = computeCrossViolation(linesCrossDimensionSum(lines));
+    // Don't stretch if the stack is single line, because the line's cross size was clamped against the stack's
+    // constrained size.
+    const bool shouldStretchLines = (numberOfLines > 1
+                                     && _style.alignContent == StackAlignContent::Stretch
+                                     && violation > kStackViolationEpsilon);
+    const double extraCrossSizePerLine = violation / numberOfLines;
+    for (auto &line : lines) {
+      if (shouldStretchLines) {
+        line.crossSize += extraCrossSizePerLine;
+      }
+      for (auto &item : line.items) {
+        if (alignment(*item.child) != StackAlignItems::Stretch) {
+          continue;
+        }
+        const double stack = stackDimension(item.layout.size);
+        // Only stretch if violation is positive. Compare against the epsilon to avoid stretching against a tiny
+        // violation.
+        if (line.crossSize - crossDimension(item.layout.size) > kStackViolationEpsilon) {
+          item.layout = crossChildLayout(*item.child, stack, stack, line.crossSize, line.crossSize);
+        }
+      }
+    }
+  }
+
+  double crossOffsetForItem(const Item &item, const Line &line) const
+  {
+    switch (alignment(*item.child)) {
+      case StackAlignItems::End:
+        return line.crossSize - crossDimension(item.layout.size);
+      case StackAlignItems::Center:
+        return floorPixelValue((line.crossSize - crossDimension(item.layout.size)) / 2, _scale);
+      case StackAlignItems::BaselineFirst:
+      case StackAlignItems::BaselineLast:
+        return line.baseline - baselineForItem(item);
+      case StackAlignItems::Start:
+      case StackAlignItems::Stretch:
+      case StackAlignItems::NotSet:
+        return 0;
+    }
+    return 0;
+  }
+
+  Frame position(const Node &node, std::vector<Line> &lines, double stackDimensionSum, double crossDimensionSum) const
+  {
+    double crossOffset;
+    double crossSpacing;
+    stackLineOffsetAndSpacing(lines.size(), computeCrossViolation(crossDimensionSum), _style.alignContent,
+                              crossOffset, crossSpacing);
+
+    Frame result = {&node, clamp(_sizeRange, directionSize(stackDimensionSum, crossDimensionSum)), {0, 0}, 0, 0};
+    double cross = crossOffset;
+    bool firstLine = true;
+    for (auto &line : lines) {
+      if (!firstLine) {
+        cross += crossSpacing + _style.lineSpacing;
+      }
+      firstLine = false;
+
+      double stackOffset;
+      double stackSpacing;
+      stackItemOffsetAndSpacing(line.items.size(), computeStackViolation(line.stackDimensionSum), _style.justifyContent,
+                                stackOffset, stackSpacing);
+
+      double stack = stackOffset;
+      bool firstItem = true;
+      for (auto &item : line.items) {
+        stack += item.child->style.spacingBefore;
+        if (!firstItem) {
+          stack += _style.spacing + stackSpacing;
+        }
+        firstItem = false;
+        item.layout.position = directionPoint(stack, cross + crossOffsetForItem(item, line));
+        stack += stackDimension(item.layout.size) + item.child->style.spacingAfter;
+      }
+      cross += line.crossSize;
+    }
+
+    // Nothing is measured while positioning, so the children end up next to each other in the arena.
+    result.firstChild = static_cast<uint32_t>(_arena.size());
+    for (const auto &line : lines) {
+      for (const auto &item : line.items) {
+        _arena.append(&item.layout, 1);
+        result.childCount++;
+      }
+    }
+    return result;
+  }
+};
+
+/** Returns a frame for the node whose children have been appended to the arena. */
+Frame childFrame(LayoutArena &arena, const Node &node, const Size &size, const Frame &sublayout)
+{
+  return {&node, size, {0, 0}, arena.append(&sublayout, 1), 1};
+}
+
+Frame calculateLayout(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, double scale)
+{
+  if (node.type != NodeType::Leaf && node.children.empty()) {
+    // Specs without children take their min size.
+    return {&node, constrainedSize.min, {0, 0}, 0, 0};
+  }
+
+  switch (node.type) {
+    case NodeType::Leaf: {
+      const Size size = node.measure ? node.measure(node, constrainedSize.max, node.context)
+                                     : (isValidForSize(constrainedSize.max.width) && isValidForSize(constrainedSize.max.height)
+                                        ? constrainedSize.max : Size{0, 0});
+      return {&node, clamp(constrainedSize, size), {0, 0}, 0, 0};
+    }
+    case NodeType::Ratio: {
+      Size childSize;
+      const Frame sublayout = ratioChildSize(constrainedSize, node.ratio, scale, childSize)
+                              ? layoutFrame(arena, *node.children[0], intersect(constrainedSize, {childSize, childSize}), childSize, scale)
+                              : layoutFrame(arena, *node.children[0], constrainedSize, {kUndefined, kUndefined}, scale);
+      return childFrame(arena, node, sublayout.size, sublayout);
+    }
+    case NodeType::Relative: {
+      Frame sublayout = layoutFrame(arena,
+                                    *node.children[0],
+                                    relativeChildSizeRange(constrainedSize, node.horizontalPosition, node.verticalPosition),
+                                    relativeChildParentSize(constrainedSize),
+                                    scale);
+      const Size size = relativeSize(constrainedSize, node.sizingOptions, sublayout.size);
+      sublayout.position = relativeChildPosition(size, sublayout.size, node.horizontalPosition, node.verticalPosition, scale);
+      return childFrame(arena, node, size, sublayout);
+    }
+    case NodeType::Stack:
+      return StackLayout(arena, node, constrainedSize, scale).compute(node);
+    case NodeType::Inset:
+      break;
+  }
+  return {&node, {0, 0}, {0, 0}, 0, 0};
+}
+
+Frame layoutFrame(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, const Size &parentSize,
+                  double scale)
+{
+  // Like ASInsetLayoutSpec, insets don't restrict themselves to their own style size.
+  if (node.type == NodeType::Inset) {
+    if (node.children.empty()) {
+      return {&node, {0, 0}, {0, 0}, 0, 0};
+    }
+    Frame sublayout = layoutFrame(arena,
+                                  *node.children[0],
+                                  insetChildSizeRange(constrainedSize, node.insets),
+                                  insetChildParentSize(parentSize, node.insets),
+                                  scale);
+    sublayout.position = insetChildPosition(constrainedSize, node.insets, sublayout.size, scale);
+    return childFrame(arena, node, insetSize(constrainedSize, node.insets, sublayout.size), sublayout);
+  }
+
+  const SizeRange resolvedRange = intersect(constrainedSize, resolve(node.style.size, parentSize));
+  return calculateLayout(arena, node, resolvedRange, scale);
+}
+
+} // namespace
+
+#pragma mark - Arena
+
+uint32_t LayoutArena::append(const Frame *frames, size_t count)
+{
+  const size_t index = _frames.size();
+  _frames.insert(_frames.end(), frames, frames + count);
+  return static_cast<uint32_t>(index);
+}
+
+Layout LayoutArena::materialize(const Frame &frame) const
+{
+  Layout layout = {frame.node, frame.size, frame.position, {}};
+  layout.sublayouts.reserve(frame.childCount);
+  for (const Frame *child = childrenBegin(frame); child != childrenEnd(frame); child++) {
+    layout.sublayouts.push_back(materialize(*child));
+  }
+  return layout;
+}
+
+const Frame &layout(LayoutArena &arena, const Node &node, const SizeRange &constrainedSize, const Size &parentSize,
+                    double scale)
+{
+  arena.reset();
+  const Frame root = layoutFrame(arena, node, constrainedSize, parentSize, scale);
+  arena.append(&root, 1);
+  return arena.root();
+}
+
+Layout layout(const Node &node, const SizeRange &constrainedSize, const Size &parentSize, double scale)
+{
+  LayoutArena arena;
+  return arena.materialize(layout(arena, node, constrainedSize, parentSize, scale));
+}
+
+} // namespace LayoutCore
+} // namespace AS
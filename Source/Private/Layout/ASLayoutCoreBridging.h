@@ -0,0 +1,72 @@
+//
+//  ASLayoutCoreBridging.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASDimension.h>
+#import <AsyncDisplayKit/ASDimensionInternal.h>
+#import <AsyncDisplayKit/ASLayoutCore.h>
+
+/**
+ * Conversions between the UIKit and layout spec types and their layout core counterparts, see ASLayoutCore.h.
+ */
+
+ASDISPLAYNODE_INLINE AS::LayoutCore::Size ASLayoutCoreSizeFromCGSize(CGSize size)
+{
+  return {size.width, size.height};
+}
+
+ASDISPLAYNODE_INLINE CGSize CGSizeFromASLayoutCoreSize(AS::LayoutCore::Size size)
+{
+  return CGSizeMake(size.width, size.height);
+}
+
+ASDISPLAYNODE_INLINE CGPoint CGPointFromASLayoutCorePoint(AS::LayoutCore::Point point)
+{
+  return CGPointMake(point.x, point.y);
+}
+
+ASDISPLAYNODE_INLINE AS::LayoutCore::SizeRange ASLayoutCoreSizeRangeFromASSizeRange(ASSizeRange sizeRange)
+{
+  return {ASLayoutCoreSizeFromCGSize(sizeRange.min), ASLayoutCoreSizeFromCGSize(sizeRange.max)};
+}
+
+ASDISPLAYNODE_INLINE ASSizeRange ASSizeRangeFromASLayoutCoreSizeRange(AS::LayoutCore::SizeRange sizeRange)
+{
+  return {CGSizeFromASLayoutCoreSize(sizeRange.min), CGSizeFromASLayoutCoreSize(sizeRange.max)};
+}
+
+ASDISPLAYNODE_INLINE AS::LayoutCore::EdgeInsets ASLayoutCoreEdgeInsetsFromUIEdgeInsets(UIEdgeInsets insets)
+{
+  return {insets.top, insets.left, insets.bottom, insets.right};
+}
+
+ASDISPLAYNODE_INLINE AS::LayoutCore::Dimension ASLayoutCoreDimensionFromASDimension(ASDimension dimension)
+{
+  switch (dimension.unit) {
+    case ASDimensionUnitPoints:
+      return AS::LayoutCore::points(dimension.value);
+    case ASDimensionUnitFraction:
+      return AS::LayoutCore::fraction(dimension.value);
+    case ASDimensionUnitAuto:
+      return AS::LayoutCore::kDimensionAuto;
+  }
+}
+
+ASDISPLAYNODE_INLINE AS::LayoutCore::ElementSize ASLayoutCoreElementSizeFromASLayoutElementSize(ASLayoutElementSize size)
+{
+  AS::LayoutCore::ElementSize elementSize;
+  elementSize.width = ASLayoutCoreDimensionFromASDimension(size.width);
+  elementSize.height = ASLayoutCoreDimensionFromASDimension(size.height);
+  elementSize.minWidth = ASLayoutCoreDimensionFromASDimension(size.minWidth);
+  elementSize.maxWidth = ASLayoutCoreDimensionFromASDimension(size.maxWidth);
+  elementSize.minHeight = ASLayoutCoreDimensionFromASDimension(size.minHeight);
+  elementSize.maxHeight = ASLayoutCoreDimensionFromASDimension(size.maxHeight);
+  return elementSize;
+}
@@ -0,0 +1,115 @@
+//
+//  ASPersistentLayoutCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * A layout cache that outlives the process, so that layouts computed in one launch can be reused in the next.
+ *
+ * Like the layout core, this is plain C++ on top of POSIX, so that the file format can be tested on any platform, see
+ * "./build.sh layout-core".
+ *
+ * The file is a fixed size header, an open addressing table of keys and a data area that records are appended to:
+ *
+ *   FileHeader | Bucket[bucketCount] | data[dataCapacity]
+ *
+ * Each record is a RecordHeader followed by its frames. The file is memory mapped, so reads only touch the pages of
+ * the records that are looked up. Nothing in the file is trusted: a header that doesn't match the format version, the
+ * salt or the file size resets the file, and a record whose checksum doesn't match is treated as a miss. Once the data
+ * area or the table is full the whole file is reset, since layouts of old content are unlikely to be needed again.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace AS {
+
+class PersistentLayoutCache {
+public:
+  /** Bump whenever the layout of the file changes, so that files written by older versions are reset. */
+  static const uint32_t kFormatVersion = 1;
+
+  /** A frame of a flattened layout. The element is an identifier chosen by the caller. */
+  struct Frame {
+    double x;
+    double y;
+    double width;
+    double height;
+    uint64_t element;
+  };
+
+  /** A cached layout: the size of the root and the frames of its flattened sublayouts, and of theirs. */
+  struct Entry {
+    double width;
+    double height;
+    std::vector<Frame> frames;
+  };
+
+  PersistentLayoutCache() = default;
+  ~PersistentLayoutCache();
+
+  PersistentLayoutCache(const PersistentLayoutCache &) = delete;
+  PersistentLayoutCache &operator=(const PersistentLayoutCache &) = delete;
+
+  /**
+   * Opens or creates the cache file and maps it. An existing file is reused only if it was written with the same
+   * format version, salt and capacity, and is reset otherwise.
+   *
+   * @param salt Identifies everything outside of the keys that layouts depend on, e.g. the app and OS versions.
+   * @param dataCapacity The number of bytes available for records.
+   *
+   * @return Whether the cache can be used.
+   */
+  bool open(const char *path, uint64_t salt, size_t dataCapacity);
+
+  /** Unmaps and closes the file. Called by the destructor. */
+  void close();
+
+  bool isOpen() const;
+
+  /** Copies the entry stored for the key into outEntry. Returns false if there is none or if it is corrupt. */
+  bool lookup(uint64_t key, Entry &outEntry) const;
+
+  /** Stores the entry for the key, replacing any previous one. Returns false if the entry can't be stored. */
+  bool store(uint64_t key, const Entry &entry);
+
+  /** Removes all entries. */
+  void clear();
+
+  /** The number of distinct keys stored. The bytes of a replaced record stay in use until the next reset. */
+  size_t count() const;
+
+  /** Hashes bytes with 64-bit FNV-1a, continuing from the given hash. Stable across processes and platforms. */
+  static uint64_t hash(const void *bytes, size_t length, uint64_t hash = kHashSeed);
+
+  static const uint64_t kHashSeed = 14695981039346656037ULL;
+
+private:
+  struct FileHeader;
+  struct Bucket;
+  struct RecordHeader;
+
+  FileHeader *header() const;
+  Bucket *buckets() const;
+  uint8_t *data() const;
+  void reset();
+  static uint64_t headerChecksum(const FileHeader &header);
+  static uint64_t recordChecksum(const RecordHeader &record, const void *frames);
+
+  mutable std::mutex _mutex;
+  int _fd = -1;
+  void *_map = nullptr;
+  size_t _mapLength = 0;
+  uint64_t _salt = 0;
+  uint32_t _bucketCount = 0;
+  uint64_t _dataCapacity = 0;
+};
+
+} // namespace AS
@@ -0,0 +1,287 @@
+//
+//  ASPersistentLayoutCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASPersistentLayoutCache.h.
+#include "ASPersistentLayoutCache.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AS {
+
+// "ASPL", also tells apart files written with a different byte order.
+static const uint32_t kMagic = 0x4153504C;
+
+// Roughly one bucket per average sized record, at most half of them in use.
+static const size_t kBytesPerBucket = 256;
+static const uint32_t kMinimumBucketCount = 64;
+
+struct PersistentLayoutCache::FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t salt;
+  uint32_t bucketCount;
+  uint32_t reserved;
+  uint64_t dataCapacity;
+  uint64_t dataSize;
+  uint64_t count;
+  // Covers all of the fields above.
+  uint64_t checksum;
+};
+
+struct PersistentLayoutCache::Bucket {
+  uint64_t key;
+  // The offset of the record in the data area plus one, zero for empty buckets.
+  uint64_t offset;
+};
+
+struct PersistentLayoutCache::RecordHeader {
+  uint64_t key;
+  uint32_t frameCount;
+  uint32_t reserved;
+  double width;
+  double height;
+  // Covers all of the fields above and the frames.
+  uint64_t checksum;
+};
+
+PersistentLayoutCache::~PersistentLayoutCache()
+{
+  close();
+}
+
+uint64_t PersistentLayoutCache::hash(const void *bytes, size_t length, uint64_t hash)
+{
+  const uint8_t *p = static_cast<const uint8_t *>(bytes);
+  for (size_t i = 0; i < length; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+uint64_t PersistentLayoutCache::headerChecksum(const FileHeader &header)
+{
+  return hash(&header, offsetof(FileHeader, checksum));
+}
+
+uint64_t PersistentLayoutCache::recordChecksum(const RecordHeader &record, const void *frames)
+{
+  const uint64_t headerHash = hash(&record, offsetof(RecordHeader, checksum));
+  // An entry without frames has no frame bytes, and may pass a null pointer for them.
+  if (record.frameCount == 0) {
+    return headerHash;
+  }
+  return hash(frames, record.frameCount * sizeof(Frame), headerHash);
+}
+
+PersistentLayoutCache::FileHeader *PersistentLayoutCache::header() const
+{
+  return static_cast<FileHeader *>(_map);
+}
+
+PersistentLayoutCache::Bucket *PersistentLayoutCache::buckets() const
+{
+  return reinterpret_cast<Bucket *>(static_cast<uint8_t *>(_map) + sizeof(FileHeader));
+}
+
+uint8_t *PersistentLayoutCache::data() const
+{
+  return reinterpret_cast<uint8_t *>(buckets() + _bucketCount);
+}
+
+bool PersistentLayoutCache::open(const char *path, uint64_t salt, size_t dataCapacity)
+{
+  close();
+  std::lock_guard<std::mutex> l(_mutex);
+
+  uint32_t bucketCount = kMinimumBucketCount;
+  while (bucketCount < dataCapacity / kBytesPerBucket) {
+    bucketCount *= 2;
+  }
+  // Keep the data area 8-byte aligned for the records.
+  dataCapacity = (dataCapacity + 7) & ~static_cast<size_t>(7);
+  const size_t mapLength = sizeof(FileHeader) + bucketCount * sizeof(Bucket) + dataCapacity;
+
+  const int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  const bool sizeMatches = (static_cast<size_t>(st.st_size) == mapLength);
+  if (!sizeMatches && ftruncate(fd, mapLength) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(nullptr, mapLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+
+  _fd = fd;
+  _map = map;
+  _mapLength = mapLength;
+  _salt = salt;
+  _bucketCount = bucketCount;
+  _dataCapacity = dataCapacity;
+
+  const FileHeader &h = *header();
+  const bool valid = (sizeMatches
+                      && h.magic == kMagic
+                      && h.version == kFormatVersion
+                      && h.salt == salt
+                      && h.bucketCount == bucketCount
+                      && h.dataCapacity == dataCapacity
+                      && h.dataSize <= dataCapacity
+                      && h.count <= bucketCount
+                      && h.checksum == headerChecksum(h));
+  if (!valid) {
+    reset();
+  }
+  return true;
+}
+
+void PersistentLayoutCache::close()
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_map != nullptr) {
+    munmap(_map, _mapLength);
+    ::close(_fd);
+    _map = nullptr;
+    _fd = -1;
+  }
+}
+
+bool PersistentLayoutCache::isOpen() const
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  return _map != nullptr;
+}
+
+void PersistentLayoutCache::reset()
+{
+  std::memset(_map, 0, sizeof(FileHeader) + _bucketCount * sizeof(Bucket));
+  FileHeader &h = *header();
+  h.magic = kMagic;
+  h.version = kFormatVersion;
+  h.salt = _salt;
+  h.bucketCount = _bucketCount;
+  h.dataCapacity = _dataCapacity;
+  h.checksum = headerChecksum(h);
+}
+
+bool PersistentLayoutCache::lookup(uint64_t key, Entry &outEntry) const
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_map == nullptr) {
+    return false;
+  }
+
+  const uint64_t dataSize = header()->dataSize;
+  const uint32_t mask = _bucketCount - 1;
+  for (uint32_t i = 0, index = static_cast<uint32_t>(key) & mask; i < _bucketCount; i++, index = (index + 1) & mask) {
+    const Bucket &bucket = buckets()[index];
+    if (bucket.offset == 0) {
+      return false;
+    }
+    if (bucket.key != key) {
+      continue;
+    }
+
+    // Everything read from the file is validated before use, it may have been corrupted on disk.
+    const uint64_t offset = bucket.offset - 1;
+    if (offset > dataSize || dataSize - offset < sizeof(RecordHeader) || offset % 8 != 0) {
+      return false;
+    }
+    RecordHeader record;
+    std::memcpy(&record, data() + offset, sizeof(RecordHeader));
+    const uint8_t *frames = data() + offset + sizeof(RecordHeader);
+    if (record.key != key || (dataSize - offset - sizeof(RecordHeader)) / sizeof(Frame) < record.frameCount
+        || record.checksum != recordChecksum(record, frames)) {
+      return false;
+    }
+
+    outEntry.width = record.width;
+    outEntry.height = record.height;
+    outEntry.frames.resize(record.frameCount);
+    if (record.frameCount > 0) {
+      std::memcpy(outEntry.frames.data(), frames, record.frameCount * sizeof(Frame));
+    }
+    return true;
+  }
+  return false;
+}
+
+bool PersistentLayoutCache::store(uint64_t key, const Entry &entry)
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  const size_t recordSize = sizeof(RecordHeader) + entry.frames.size() * sizeof(Frame);
+  if (_map == nullptr || recordSize > _dataCapacity || entry.frames.size() > UINT32_MAX) {
+    return false;
+  }
+
+  FileHeader &h = *header();
+  if (h.dataSize + recordSize > _dataCapacity || h.count >= _bucketCount / 2) {
+    reset();
+  }
+
+  const uint32_t mask = _bucketCount - 1;
+  uint32_t index = static_cast<uint32_t>(key) & mask;
+  for (uint32_t i = 0; buckets()[index].offset != 0 && buckets()[index].key != key; i++) {
+    if (i == _bucketCount) {
+      // Only a corrupt table can be full, since it is reset once half of the buckets are in use.
+      reset();
+      index = static_cast<uint32_t>(key) & mask;
+      break;
+    }
+    index = (index + 1) & mask;
+  }
+
+  // Write the record before pointing the bucket at it, a record that is cut short by a crash fails its checksum.
+  const uint64_t offset = h.dataSize;
+  RecordHeader record = {key, static_cast<uint32_t>(entry.frames.size()), 0, entry.width, entry.height, 0};
+  record.checksum = recordChecksum(record, entry.frames.data());
+  std::memcpy(data() + offset, &record, sizeof(RecordHeader));
+  if (!entry.frames.empty()) {
+    std::memcpy(data() + offset + sizeof(RecordHeader), entry.frames.data(), entry.frames.size() * sizeof(Frame));
+  }
+
+  Bucket &bucket = buckets()[index];
+  if (bucket.offset == 0) {
+    h.count++;
+  }
+  bucket.key = key;
+  bucket.offset = offset + 1;
+  h.dataSize = offset + recordSize;
+  h.checksum = headerChecksum(h);
+  return true;
+}
+
+void PersistentLayoutCache::clear()
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  if (_map != nullptr) {
+    reset();
+  }
+}
+
+size_t PersistentLayoutCache::count() const
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  return _map != nullptr ? static_cast<size_t>(header()->count) : 0;
+}
+
+} // namespace AS
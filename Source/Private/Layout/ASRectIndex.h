@@ -0,0 +1,123 @@
+//
+//  ASRectIndex.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+/**
+ * An immutable spatial index over rects, answering which of them intersect a query rect.
+ *
+ * Like the layout core, this is plain C++, so that it can be tested and benchmarked on any platform, see
+ * "./build.sh layout-core".
+ *
+ * It is a packed R-tree: the rects are sorted along a Hilbert curve and grouped into leaves of kNodeSize, which are
+ * grouped into nodes of kNodeSize, up to a single root. All levels live in one array, leaves first. The rects below a
+ * node are contiguous in the sorted order, so a node that is entirely within the query reports its rects without
+ * looking at their descendants. Queries take O(log n + k) and don't allocate.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AS {
+
+class RectIndex {
+public:
+  static const uint32_t kNodeSize = 16;
+
+  struct Rect {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+
+    /** Like CGRectIntersectsRect, rects that only share an edge don't intersect. */
+    bool intersects(const Rect &other) const
+    {
+      return minX < other.maxX && other.minX < maxX && minY < other.maxY && other.minY < maxY;
+    }
+
+    bool contains(const Rect &other) const
+    {
+      return minX <= other.minX && other.maxX <= maxX && minY <= other.minY && other.maxY <= maxY;
+    }
+  };
+
+  RectIndex() = default;
+
+  /** Builds the index. Rects are identified by their index in the given array. */
+  RectIndex(const Rect *rects, size_t count);
+
+  size_t count() const { return _count; }
+
+  /** The memory used by the index. */
+  size_t byteSize() const;
+
+  /**
+   * Calls visitor(size_t index) once for each rect that intersects the query rect, in no particular order. Rects
+   * with zero width or height are reported if they are within the query rect.
+   */
+  template <typename Visitor>
+  void query(const Rect &rect, Visitor &&visitor) const
+  {
+    if (_nodes.empty() || !mayContainMatches(rect, _boxes.back())) {
+      return;
+    }
+
+    // Each level adds fewer than kNodeSize nodes to the stack, and 32-bit counts need at most 8 levels of nodes.
+    uint32_t stack[8 * kNodeSize];
+    size_t stackSize = 0;
+    stack[stackSize++] = static_cast<uint32_t>(_boxes.size() - 1);
+    while (stackSize > 0) {
+      const uint32_t position = stack[--stackSize];
+      const Node &node = _nodes[position - _count];
+      if (rect.contains(_boxes[position])) {
+        for (uint32_t i = node.firstRect; i < node.rectEnd; i++) {
+          visitor(static_cast<size_t>(_indices[i]));
+        }
+        continue;
+      }
+      for (uint32_t child = node.firstChild; child < node.childEnd; child++) {
+        const Rect &box = _boxes[child];
+        if (child < _count) {
+          if (rect.intersects(box) || rect.contains(box)) {
+            visitor(static_cast<size_t>(_indices[child]));
+          }
+        } else if (mayContainMatches(rect, box)) {
+          stack[stackSize++] = child;
+        }
+      }
+    }
+  }
+
+private:
+  struct Node {
+    // The range of its children in _boxes.
+    uint32_t firstChild;
+    uint32_t childEnd;
+    // The range of the sorted rects below it.
+    uint32_t firstRect;
+    uint32_t rectEnd;
+  };
+
+  /** Whether a rect within the box may intersect the query rect, including rects with zero width or height. */
+  static bool mayContainMatches(const Rect &rect, const Rect &box)
+  {
+    return rect.minX <= box.maxX && box.minX <= rect.maxX && rect.minY <= box.maxY && box.minY <= rect.maxY;
+  }
+
+  uint32_t _count = 0;
+  // The boxes of all levels: the sorted rects first, then the nodes of each level, the root last.
+  std::vector<Rect> _boxes;
+  // The index in the input of each sorted rect.
+  std::vector<uint32_t> _indices;
+  // The nodes, in the same order as their boxes.
+  std::vector<Node> _nodes;
+};
+
+} // namespace AS
@@ -0,0 +1,150 @@
+//
+//  ASRectIndex.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// This file has to stay plain C++, see ASRectIndex.h.
+#include "ASRectIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace AS {
+
+/**
+ * The position of (x, y) along a Hilbert curve over a 65536 x 65536 grid, so that rects that are close on screen are
+ * mostly close in the sorted order. See "Hilbert curve" on rawrunprotected.com for the derivation.
+ */
+static uint32_t hilbertValue(uint32_t x, uint32_t y)
+{
+  uint32_t a = x ^ y;
+  uint32_t b = 0xFFFF ^ a;
+  uint32_t c = 0xFFFF ^ (x | y);
+  uint32_t d = x & (y ^ 0xFFFF);
+
+  uint32_t A = a | (b >> 1);
+  uint32_t B = (a >> 1) ^ a;
+  uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+  uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+  a = A; b = B; c = C; d = D;
+  A = (a & (a >> 2)) ^ (b & (b >> 2));
+  B = (a & (b >> 2)) ^ (b & ((a ^ b) >> 2));
+  C ^= (a & (c >> 2)) ^ (b & (d >> 2));
+  D ^= (b & (c >> 2)) ^ ((a ^ b) & (d >> 2));
+
+  a = A; b = B; c = C; d = D;
+  A = (a & (a >> 4)) ^ (b & (b >> 4));
+  B = (a & (b >> 4)) ^ (b & ((a ^ b) >> 4));
+  C ^= (a & (c >> 4)) ^ (b & (d >> 4));
+  D ^= (b & (c >> 4)) ^ ((a ^ b) & (d >> 4));
+
+  a = A; b = B; c = C; d = D;
+  C ^= (a & (c >> 8)) ^ (b & (d >> 8));
+  D ^= (b & (c >> 8)) ^ ((a ^ b) & (d >> 8));
+
+  a = C ^ (C >> 1);
+  b = D ^ (D >> 1);
+
+  uint32_t i0 = x ^ y;
+  uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+  i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+  i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+  i0 = (i0 | (i0 << 2)) & 0x33333333;
+  i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+  i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+  i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+  i1 = (i1 | (i1 << 2)) & 0x33333333;
+  i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+  return (i1 << 1) | i0;
+}
+
+static uint32_t gridCoordinate(double value, double min, double extent)
+{
+  if (!(extent > 0)) {
+    return 0;
+  }
+  const double scaled = std::floor((value - min) / extent * 0xFFFF);
+  return static_cast<uint32_t>(std::min(std::max(scaled, 0.0), static_cast<double>(0xFFFF)));
+}
+
+static RectIndex::Rect unionRect(const RectIndex::Rect &a, const RectIndex::Rect &b)
+{
+  return {std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+}
+
+RectIndex::RectIndex(const Rect *rects, size_t count)
+{
+  // Indexes are 32-bit to keep the tree small.
+  _count = static_cast<uint32_t>(std::min<size_t>(count, UINT32_MAX / 2));
+  if (_count == 0) {
+    return;
+  }
+
+  Rect bounds = rects[0];
+  for (uint32_t i = 1; i < _count; i++) {
+    bounds = unionRect(bounds, rects[i]);
+  }
+  // Scale both axes alike: for a long scrolling layout the curve then mostly follows the scrolling direction, which
+  // keeps the nodes short along it.
+  const double extent = std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY);
+
+  // Ties keep the input order, which is usually the scrolling order for collection layouts.
+  std::vector<std::pair<uint32_t, uint32_t>> order(_count);
+  for (uint32_t i = 0; i < _count; i++) {
+    const Rect &rect = rects[i];
+    const uint32_t x = gridCoordinate((rect.minX + rect.maxX) / 2, bounds.minX, extent);
+    const uint32_t y = gridCoordinate((rect.minY + rect.maxY) / 2, bounds.minY, extent);
+    order[i] = {hilbertValue(x, y), i};
+  }
+  std::sort(order.begin(), order.end());
+
+  size_t capacity = _count;
+  for (size_t levelCount = _count; levelCount > 1 || capacity == _count; ) {
+    levelCount = (levelCount + kNodeSize - 1) / kNodeSize;
+    capacity += levelCount;
+  }
+  _boxes.reserve(capacity);
+  _indices.reserve(_count);
+  _nodes.reserve(capacity - _count);
+  for (const auto &entry : order) {
+    _boxes.push_back(rects[entry.second]);
+    _indices.push_back(entry.second);
+  }
+
+  // Group each level into nodes until there is a single root. The root is a node even if there is a single rect.
+  uint32_t levelStart = 0;
+  uint32_t levelEnd = _count;
+  do {
+    for (uint32_t first = levelStart; first < levelEnd; first += kNodeSize) {
+      const uint32_t end = std::min(first + kNodeSize, levelEnd);
+      Rect box = _boxes[first];
+      for (uint32_t child = first + 1; child < end; child++) {
+        box = unionRect(box, _boxes[child]);
+      }
+      Node node;
+      node.firstChild = first;
+      node.childEnd = end;
+      node.firstRect = (first < _count) ? first : _nodes[first - _count].firstRect;
+      node.rectEnd = (first < _count) ? end : _nodes[end - 1 - _count].rectEnd;
+      _boxes.push_back(box);
+      _nodes.push_back(node);
+    }
+    levelStart = levelEnd;
+    levelEnd = static_cast<uint32_t>(_boxes.size());
+  } while (levelEnd - levelStart > 1);
+}
+
+size_t RectIndex::byteSize() const
+{
+  return _boxes.capacity() * sizeof(Rect) + _indices.capacity() * sizeof(uint32_t) + _nodes.capacity() * sizeof(Node);
+}
+
+} // namespace AS
@@ -13,6 +13,7 @@
 #import <numeric>
 
 #import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASLayoutCore.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
 #import <AsyncDisplayKit/ASLayoutSpec+Subclasses.h>
 
@@ -44,38 +45,10 @@ static void crossOffsetAndSpacingForEachLine(const std::size_t numOfLines,
 {
   ASDisplayNodeCAssertTrue(numOfLines > 0);
   
-  // Handle edge cases
-  if (alignContent == ASStackLayoutAlignContentSpaceBetween && (crossViolation < kViolationEpsilon || numOfLines == 1)) {
-    alignContent = ASStackLayoutAlignContentStart;
-  } else if (alignContent == ASStackLayoutAlignContentSpaceAround && (crossViolation < kViolationEpsilon || numOfLines == 1)) {
-    alignContent = ASStackLayoutAlignContentCenter;
-  }
-  
-  offset = 0;
-  spacing = 0;
-  
-  switch (alignContent) {
-    case ASStackLayoutAlignContentCenter:
-      offset = crossViolation / 2;
-      break;
-    case ASStackLayoutAlignContentEnd:
-      offset = crossViolation;
-      break;
-    case ASStackLayoutAlignContentSpaceBetween:
-      // Spacing between the items, no spaces at the edges, evenly distributed
-      spacing = crossViolation / (numOfLines - 1);
-      break;
-    case ASStackLayoutAlignContentSpaceAround: {
-      // Spacing between items are twice the spacing on the edges
-      CGFloat spacingUnit = crossViolation / (numOfLines * 2);
-      offset = spacingUnit;
-      spacing = spacingUnit * 2;
-      break;
-    }
-    case ASStackLayoutAlignContentStart:
-    case ASStackLayoutAlignContentStretch:
-      break;
-  }
+  double lineOffset, lineSpacing;
+  AS::LayoutCore::stackLineOffsetAndSpacing(numOfLines, crossViolation, static_cast<AS::LayoutCore::StackAlignContent>(alignContent), lineOffset, lineSpacing);
+  offset = lineOffset;
+  spacing = lineSpacing;
 }
 
 static void stackOffsetAndSpacingForEachItem(const std::size_t numOfItems,
@@ -86,37 +59,10 @@ static void stackOffsetAndSpacingForEachItem(const std::size_t numOfItems,
 {
   ASDisplayNodeCAssertTrue(numOfItems > 0);
   
-  // Handle edge cases
-  if (justifyContent == ASStackLayoutJustifyContentSpaceBetween && (stackViolation < kViolationEpsilon || numOfItems == 1)) {
-    justifyContent = ASStackLayoutJustifyContentStart;
-  } else if (justifyContent == ASStackLayoutJustifyContentSpaceAround && (stackViolation < kViolationEpsilon || numOfItems == 1)) {
-    justifyContent = ASStackLayoutJustifyContentCenter;
-  }
-  
-  offset = 0;
-  spacing = 0;
-  
-  switch (justifyContent) {
-    case ASStackLayoutJustifyContentCenter:
-      offset = stackViolation / 2;
-      break;
-    case ASStackLayoutJustifyContentEnd:
-      offset = stackViolation;
-      break;
-    case ASStackLayoutJustifyContentSpaceBetween:
-      // Spacing between the items, no spaces at the edges, evenly distributed
-      spacing = stackViolation / (numOfItems - 1);
-      break;
-    case ASStackLayoutJustifyContentSpaceAround: {
-      // Spacing between items are twice the spacing on the edges
-      CGFloat spacingUnit = stackViolation / (numOfItems * 2);
-      offset = spacingUnit;
-      spacing = spacingUnit * 2;
-      break;
-    }
-    case ASStackLayoutJustifyContentStart:
-      break;
-  }
+  double itemOffset, itemSpacing;
+  AS::LayoutCore::stackItemOffsetAndSpacing(numOfItems, stackViolation, static_cast<AS::LayoutCore::StackJustifyContent>(justifyContent), itemOffset, itemSpacing);
+  offset = itemOffset;
+  spacing = itemSpacing;
 }
 
 static void positionItemsInLine(const ASStackUnpositionedLine &line,
@@ -16,6 +16,30 @@
 /** The threshold that determines if a violation has actually occurred. */
 ASDK_EXTERN CGFloat const kViolationEpsilon;
 
+/** A child layout from a previous pass, along with what it was measured against. */
+struct ASStackLayoutSpecMeasurement {
+  ASSizeRange sizeRange;
+  CGSize parentSize;
+  /** The layout version of the child at the time it was measured. */
+  NSUInteger version;
+  ASLayout *layout;
+};
+
+/**
+ * Remembers the layouts of one child across layout passes, so that a child whose constrained size and layout version
+ * did not change is not measured again. A stack measures each child up to three times per pass (intrinsic, flexed and
+ * stretched), so that's how many measurements are kept.
+ */
+struct ASStackLayoutSpecChildMemo {
+  static const NSUInteger kMeasurementCount = 3;
+
+  /** The child the measurements belong to. */
+  id<ASLayoutElement> element;
+  ASStackLayoutSpecMeasurement measurements[kMeasurementCount];
+  /** The measurement that is replaced next. */
+  NSUInteger nextMeasurement;
+};
+
 struct ASStackLayoutSpecChild {
   /** The original source child. */
   id<ASLayoutElement> element;
@@ -23,6 +47,8 @@ struct ASStackLayoutSpecChild {
   ASLayoutElementStyle *style;
   /** Size object of the element */
   ASLayoutElementSize size;
+  /** Layouts from previous passes, or NULL if the stack doesn't lay out incrementally. Not owned. */
+  ASStackLayoutSpecChildMemo *memo;
 };
 
 struct ASStackLayoutSpecItem {
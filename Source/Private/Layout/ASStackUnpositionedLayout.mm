@@ -13,10 +13,12 @@
 #import <numeric>
 
 #import <AsyncDisplayKit/ASDispatch.h>
+#import <AsyncDisplayKit/ASDisplayNodeInternal.h>
+#import <AsyncDisplayKit/ASLayoutCore.h>
 #import <AsyncDisplayKit/ASLayoutSpecUtilities.h>
 #import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
 
-CGFloat const kViolationEpsilon = 0.01;
+CGFloat const kViolationEpsilon = AS::LayoutCore::kStackViolationEpsilon;
 
 static CGFloat resolveCrossDimensionMaxForStretchChild(const ASStackLayoutSpecStyle &style,
                                                        const ASStackLayoutSpecChild &child,
@@ -42,6 +44,37 @@ static CGFloat resolveCrossDimensionMinForStretchChild(const ASStackLayoutSpecSt
           ASLayoutElementSizeResolve(child.style.size, ASLayoutElementParentSizeUndefined).min.height) ?: crossMin;
 }
 
+/**
+ Returns the layout of the child for the given size range, reusing a layout from a previous pass if the child has a
+ memo and neither the size range nor the layout version of the child changed since.
+
+ Only display nodes have a layout version. Layout specs are always measured, which is cheap for specs whose own children
+ are memoized.
+ */
+static ASLayout *measureChild(const ASStackLayoutSpecChild &child, const ASSizeRange &sizeRange, const CGSize parentSize)
+{
+  ASStackLayoutSpecChildMemo *memo = child.memo;
+  if (memo == NULL || child.element.layoutElementType != ASLayoutElementTypeDisplayNode) {
+    return [child.element layoutThatFits:sizeRange parentSize:parentSize];
+  }
+
+  // Read the version before measuring so that an invalidation during the measurement is not missed.
+  const NSUInteger version = [(ASDisplayNode *)child.element layoutVersion];
+  for (const auto &measurement : memo->measurements) {
+    if (measurement.layout != nil
+        && measurement.version == version
+        && CGSizeEqualToSize(measurement.parentSize, parentSize)
+        && ASSizeRangeEqualToSizeRange(measurement.sizeRange, sizeRange)) {
+      return measurement.layout;
+    }
+  }
+
+  ASLayout *layout = [child.element layoutThatFits:sizeRange parentSize:parentSize];
+  memo->measurements[memo->nextMeasurement] = {sizeRange, parentSize, version, layout};
+  memo->nextMeasurement = (memo->nextMeasurement + 1) % ASStackLayoutSpecChildMemo::kMeasurementCount;
+  return layout;
+}
+
 /**
  Sizes the child given the parameters specified, and returns the computed layout.
  */
@@ -62,7 +95,7 @@ static ASLayout *crossChildLayout(const ASStackLayoutSpecChild &child,
                                  resolveCrossDimensionMaxForStretchChild(style, child, stackMax, crossMax) :
                                  crossMax);
   const ASSizeRange childSizeRange = directionSizeRange(style.direction, stackMin, stackMax, childCrossMin, childCrossMax);
-  ASLayout *layout = [child.element layoutThatFits:childSizeRange parentSize:parentSize];
+  ASLayout *layout = measureChild(child, childSizeRange, parentSize);
   ASDisplayNodeCAssertNotNil(layout, @"ASLayout returned from -layoutThatFits:parentSize: must not be nil: %@", child.element);
   return layout ? : [ASLayout layoutWithLayoutElement:child.element size:{0, 0}];
 }
@@ -154,14 +187,9 @@ CGFloat ASStackUnpositionedLayout::computeCrossViolation(const CGFloat crossDime
                                                          const ASStackLayoutSpecStyle &style,
                                                          const ASSizeRange &sizeRange)
 {
-  const CGFloat minCrossDimension = crossDimension(style.direction, sizeRange.min);
-  const CGFloat maxCrossDimension = crossDimension(style.direction, sizeRange.max);
-  if (crossDimensionSum < minCrossDimension) {
-    return minCrossDimension - crossDimensionSum;
-  } else if (crossDimensionSum > maxCrossDimension) {
-    return maxCrossDimension - crossDimensionSum;
-  }
-  return 0;
+  return AS::LayoutCore::stackViolation(crossDimensionSum,
+                                        crossDimension(style.direction, sizeRange.min),
+                                        crossDimension(style.direction, sizeRange.max));
 }
 
 /**
@@ -335,91 +363,74 @@ static void computeLinesCrossSizeAndBaseline(std::vector<ASStackUnpositionedLine
   }
 }
 
-/**
- Returns a lambda that computes the relevant flex factor based on the given violation.
- @param violation The amount that the stack layout violates its size range.  See header for sign interpretation.
- */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexFactorInViolationDirection(const CGFloat violation)
-{
-  if (std::fabs(violation) < kViolationEpsilon) {
-    return [](const ASStackLayoutSpecItem &item) { return 0.0; };
-  } else if (violation > 0) {
-    return [](const ASStackLayoutSpecItem &item) { return item.child.style.flexGrow; };
-  } else {
-    return [](const ASStackLayoutSpecItem &item) { return item.child.style.flexShrink; };
-  }
-}
-
-static inline CGFloat scaledFlexShrinkFactor(const ASStackLayoutSpecItem &item,
-                                             const ASStackLayoutSpecStyle &style,
-                                             const CGFloat flexFactorSum)
+template <bool Vertical>
+ASDISPLAYNODE_INLINE CGFloat stackDimension(const CGSize size)
 {
-  return stackDimension(style.direction, item.layout.size) * (item.child.style.flexShrink / flexFactorSum);
+  return Vertical ? size.height : size.width;
 }
 
 /**
- Returns a lambda that computes a flex shrink adjustment for a given item based on the provided violation.
- @param items The unpositioned items from the original unconstrained layout pass.
- @param style The layout style to be applied to all children.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex shrink adjustment, if any, for a particular item.
+ Struct-of-arrays view of the items of one line that are being flexed. The arrays live in a buffer owned by the caller,
+ so resolving the flexible lengths doesn't allocate.
  */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexShrinkAdjustment(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                  const ASStackLayoutSpecStyle &style,
-                                                                                  const CGFloat violation,
-                                                                                  const CGFloat flexFactorSum)
-{
-  const CGFloat scaledFlexShrinkFactorSum = std::accumulate(items.begin(), items.end(), 0.0, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-    return x + scaledFlexShrinkFactor(item, style, flexFactorSum);
-  });
-  return [style, scaledFlexShrinkFactorSum, violation, flexFactorSum](const ASStackLayoutSpecItem &item) {
-    if (scaledFlexShrinkFactorSum == 0.0) {
-      return (CGFloat)0.0;
-    }
-    
-    const CGFloat scaledFlexShrinkFactorRatio = scaledFlexShrinkFactor(item, style, flexFactorSum) / scaledFlexShrinkFactorSum;
-    // The item should shrink proportionally to the scaled flex shrink factor ratio computed above.
-    // Unlike the flex grow adjustment the flex shrink adjustment needs to take the size of each item into account.
-    return -std::fabs(scaledFlexShrinkFactorRatio * violation);
-  };
-}
+struct ASStackFlexLine {
+  /** The size of each item along the stack dimension, before flexing. */
+  CGFloat *sizes;
+  /** The flex grow or flex shrink factor of each item, depending on the direction of the violation. */
+  CGFloat *factors;
+  /** The amount each item grows (positive) or shrinks (negative) by. */
+  CGFloat *adjustments;
+};
 
 /**
- Returns a lambda that computes a flex grow adjustment for a given item based on the provided violation.
- @param items The unpositioned items from the original unconstrained layout pass.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex grow adjustment, if any, for a particular item.
- */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexGrowAdjustment(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                const CGFloat violation,
-                                                                                const CGFloat flexFactorSum)
-{
-  // To compute the flex grow adjustment distribute the violation proportionally based on each item's flex grow factor.
-  return [violation, flexFactorSum](const ASStackLayoutSpecItem &item) {
-    return std::floor(violation * (item.child.style.flexGrow / flexFactorSum));
-  };
-}
+ Fills in the flex adjustment of every item for the given violation and returns the sum of the items' flex factors.
+ If the sum is zero no item can flex and the adjustments are left undefined.
+
+ Grow distributes the violation proportionally based on each item's flex grow factor. Shrink distributes it based on
+ each item's flex shrink factor scaled by the item's size, so that larger items shrink more.
 
-/**
- Returns a lambda that computes a flex adjustment for a given item based on the provided violation.
  @param items The unpositioned items from the original unconstrained layout pass.
- @param style The layout style to be applied to all children.
- @param violation The amount that the stack layout violates its size range.
- @param flexFactorSum The sum of each item's flex factor as determined by the provided violation.
- @return A lambda capable of computing the flex adjustment for a particular item.
+ @param line The buffers to fill in, each with room for all items.
+ @param violation The amount that the stack layout violates its size range. Positive if Grow, negative otherwise.
  */
-static std::function<CGFloat(const ASStackLayoutSpecItem &)> flexAdjustmentInViolationDirection(const std::vector<ASStackLayoutSpecItem> &items,
-                                                                                                const ASStackLayoutSpecStyle &style,
-                                                                                                const CGFloat violation,
-                                                                                                const CGFloat flexFactorSum)
+template <bool Vertical, bool Grow>
+static CGFloat computeFlexAdjustments(const std::vector<ASStackLayoutSpecItem> &items,
+                                      const ASStackFlexLine &line,
+                                      const CGFloat violation)
 {
-  if (violation > 0) {
-    return flexGrowAdjustment(items, violation, flexFactorSum);
+  const size_t count = items.size();
+  // The flex factor sum is needed to determine if flexing is necessary.
+  CGFloat flexFactorSum = 0.0;
+  for (size_t i = 0; i < count; i++) {
+    const auto &item = items[i];
+    line.sizes[i] = stackDimension<Vertical>(item.layout.size);
+    line.factors[i] = Grow ? item.child.style.flexGrow : item.child.style.flexShrink;
+    flexFactorSum += line.factors[i];
+  }
+  if (flexFactorSum == 0) {
+    return flexFactorSum;
+  }
+
+  if (Grow) {
+    for (size_t i = 0; i < count; i++) {
+      line.adjustments[i] = std::floor(violation * (line.factors[i] / flexFactorSum));
+    }
   } else {
-    return flexShrinkAdjustment(items, style, violation, flexFactorSum);
+    CGFloat scaledFlexShrinkFactorSum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+      line.adjustments[i] = line.sizes[i] * (line.factors[i] / flexFactorSum);
+      scaledFlexShrinkFactorSum += line.adjustments[i];
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (scaledFlexShrinkFactorSum == 0.0) {
+        line.adjustments[i] = 0.0;
+      } else {
+        const CGFloat scaledFlexShrinkFactorRatio = line.adjustments[i] / scaledFlexShrinkFactorSum;
+        line.adjustments[i] = -std::fabs(scaledFlexShrinkFactorRatio * violation);
+      }
+    }
   }
+  return flexFactorSum;
 }
 
 ASDISPLAYNODE_INLINE BOOL isFlexibleInBothDirections(const ASStackLayoutSpecChild &child)
@@ -521,14 +532,9 @@ CGFloat ASStackUnpositionedLayout::computeStackViolation(const CGFloat stackDime
                                                          const ASStackLayoutSpecStyle &style,
                                                          const ASSizeRange &sizeRange)
 {
-  const CGFloat minStackDimension = stackDimension(style.direction, sizeRange.min);
-  const CGFloat maxStackDimension = stackDimension(style.direction, sizeRange.max);
-  if (stackDimensionSum < minStackDimension) {
-    return minStackDimension - stackDimensionSum;
-  } else if (stackDimensionSum > maxStackDimension) {
-    return maxStackDimension - stackDimensionSum;
-  }
-  return 0;
+  return AS::LayoutCore::stackViolation(stackDimensionSum,
+                                        stackDimension(style.direction, sizeRange.min),
+                                        stackDimension(style.direction, sizeRange.max));
 }
 
 /**
@@ -545,9 +551,82 @@ ASDISPLAYNODE_INLINE BOOL useOptimizedFlexing(const std::vector<ASStackLayoutSpe
               stackDimension(style.direction, sizeRange.max)));
 }
 
+/**
+ Flexes the items of one line in the stack axis to resolve a min or max stack size violation, see
+ flexLinesAlongStackDimension.
+
+ @param buffer room for three values per item, see ASStackFlexLine
+ */
+template <bool Vertical>
+static void flexLineAlongStackDimension(std::vector<ASStackLayoutSpecItem> &items,
+                                        const ASStackLayoutSpecStyle &style,
+                                        const BOOL concurrent,
+                                        const ASSizeRange &sizeRange,
+                                        const CGSize parentSize,
+                                        const BOOL useOptimizedFlexing,
+                                        CGFloat *buffer)
+{
+  const size_t count = items.size();
+  const ASStackFlexLine line = {buffer, buffer + count, buffer + 2 * count};
+  const CGFloat violation = ASStackUnpositionedLayout::computeStackViolation(computeItemsStackDimensionSum(items, style), style, sizeRange);
+
+  CGFloat flexFactorSum = 0;
+  if (std::fabs(violation) >= kViolationEpsilon) {
+    flexFactorSum = (violation > 0
+                     ? computeFlexAdjustments<Vertical, true>(items, line, violation)
+                     : computeFlexAdjustments<Vertical, false>(items, line, violation));
+  }
+
+  // If no items are able to flex then there is nothing left to do with this line. Bail.
+  if (flexFactorSum == 0) {
+    // If optimized flexing was used then we have to clean up the unsized items and lay them out at zero size.
+    if (useOptimizedFlexing) {
+      layoutFlexibleChildrenAtZeroSize(items, style, concurrent, sizeRange, parentSize);
+    }
+    return;
+  }
+
+  // Compute any remaining violation to the first flexible item.
+  CGFloat remainingViolation = violation;
+  for (size_t i = 0; i < count; i++) {
+    remainingViolation -= line.adjustments[i];
+  }
+
+  size_t firstFlexItem = -1;
+  for (size_t i = 0; i < count; i++) {
+    // Items are consider inflexible if they do not need to make a flex adjustment.
+    if (line.adjustments[i] != 0) {
+      firstFlexItem = i;
+      break;
+    }
+  }
+  if (firstFlexItem == -1) {
+    return;
+  }
+  // Only apply the remaining violation for the first flexible item that has a flex grow factor.
+  const CGFloat firstFlexItemRemainingViolation = (items[firstFlexItem].child.style.flexGrow > 0 ? remainingViolation : 0);
+
+  const CGFloat *sizes = line.sizes;
+  const CGFloat *adjustments = line.adjustments;
+  dispatchApplyIfNeeded(count, concurrent, ^(size_t i) {
+    // Items are consider inflexible if they do not need to make a flex adjustment.
+    if (adjustments[i] != 0) {
+      auto &item = items[i];
+      const CGFloat flexedStackSize = sizes[i] + adjustments[i] + (i == firstFlexItem ? firstFlexItemRemainingViolation : 0);
+      item.layout = crossChildLayout(item.child,
+                                     style,
+                                     MAX(flexedStackSize, 0),
+                                     MAX(flexedStackSize, 0),
+                                     crossDimension(style.direction, sizeRange.min),
+                                     crossDimension(style.direction, sizeRange.max),
+                                     parentSize);
+    }
+  });
+}
+
 /**
  Flexes children in the stack axis to resolve a min or max stack size violation. First, determines which children are
- flexible (see computeStackViolation and isFlexibleInViolationDirection). Then computes how much to flex each flexible child
+ flexible (see computeStackViolation and computeFlexAdjustments). Then computes how much to flex each flexible child
  and performs re-layout. Note that there may still be a non-zero violation even after flexing.
 
  The actual CSS flexbox spec describes an iterative looping algorithm here, which may be adopted in t5837937:
@@ -565,92 +644,58 @@ static void flexLinesAlongStackDimension(std::vector<ASStackUnpositionedLine> &l
                                          const CGSize parentSize,
                                          const BOOL useOptimizedFlexing)
 {
+  // Lines of up to kInlineFlexCapacity items are flexed without touching the heap.
+  static const size_t kInlineFlexCapacity = 128;
+  CGFloat inlineBuffer[3 * kInlineFlexCapacity];
+  std::vector<CGFloat> heapBuffer;
+  CGFloat *buffer = inlineBuffer;
+
+  size_t maxLineCount = 0;
+  for (const auto &line : lines) {
+    maxLineCount = MAX(maxLineCount, line.items.size());
+  }
+  if (maxLineCount > kInlineFlexCapacity) {
+    heapBuffer.resize(3 * maxLineCount);
+    buffer = heapBuffer.data();
+  }
+
   for (auto &line : lines) {
-    auto &items = line.items;
-    const CGFloat violation = ASStackUnpositionedLayout::computeStackViolation(computeItemsStackDimensionSum(items, style), style, sizeRange);
-    std::function<CGFloat(const ASStackLayoutSpecItem &)> flexFactor = flexFactorInViolationDirection(violation);
-    // The flex factor sum is needed to determine if flexing is necessary.
-    // This value is also needed if the violation is positive and flexible items need to grow, so keep it around.
-    const CGFloat flexFactorSum = std::accumulate(items.begin(), items.end(), 0.0, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-      return x + flexFactor(item);
-    });
-    
-    // If no items are able to flex then there is nothing left to do with this line. Bail.
-    if (flexFactorSum == 0) {
-      // If optimized flexing was used then we have to clean up the unsized items and lay them out at zero size.
-      if (useOptimizedFlexing) {
-        layoutFlexibleChildrenAtZeroSize(items, style, concurrent, sizeRange, parentSize);
-      }
-      continue;
-    }
-    
-    std::function<CGFloat(const ASStackLayoutSpecItem &)> flexAdjustment = flexAdjustmentInViolationDirection(items,
-                                                                                                              style,
-                                                                                                              violation,
-                                                                                                              flexFactorSum);
-    // Compute any remaining violation to the first flexible item.
-    const CGFloat remainingViolation = std::accumulate(items.begin(), items.end(), violation, [&](CGFloat x, const ASStackLayoutSpecItem &item) {
-      return x - flexAdjustment(item);
-    });
-    
-    size_t firstFlexItem = -1;
-    for(size_t i = 0; i < items.size(); i++) {
-      // Items are consider inflexible if they do not need to make a flex adjustment.
-      if (flexAdjustment(items[i]) != 0) {
-        firstFlexItem = i;
-        break;
-      }
-    }
-    if (firstFlexItem == -1) {
-      continue;
+    if (style.direction == ASStackLayoutDirectionVertical) {
+      flexLineAlongStackDimension<true>(line.items, style, concurrent, sizeRange, parentSize, useOptimizedFlexing, buffer);
+    } else {
+      flexLineAlongStackDimension<false>(line.items, style, concurrent, sizeRange, parentSize, useOptimizedFlexing, buffer);
     }
-    
-    dispatchApplyIfNeeded(items.size(), concurrent, ^(size_t i) {
-      auto &item = items[i];
-      const CGFloat currentFlexAdjustment = flexAdjustment(item);
-      // Items are consider inflexible if they do not need to make a flex adjustment.
-      if (currentFlexAdjustment != 0) {
-        const CGFloat originalStackSize = stackDimension(style.direction, item.layout.size);
-        // Only apply the remaining violation for the first flexible item that has a flex grow factor.
-        const CGFloat flexedStackSize = originalStackSize + currentFlexAdjustment + (i == firstFlexItem && item.child.style.flexGrow > 0 ? remainingViolation : 0);
-        item.layout = crossChildLayout(item.child,
-                                       style,
-                                       MAX(flexedStackSize, 0),
-                                       MAX(flexedStackSize, 0),
-                                       crossDimension(style.direction, sizeRange.min),
-                                       crossDimension(style.direction, sizeRange.max),
-                                       parentSize);
-      }
-    });
   }
 }
 
 /**
  https://www.w3.org/TR/css-flexbox-1/#algo-line-break
  */
-static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(const std::vector<ASStackLayoutSpecItem> &items,
+static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(std::vector<ASStackLayoutSpecItem> &&items,
                                                                      const ASStackLayoutSpecStyle &style,
                                                                      const ASSizeRange &sizeRange)
 {
+  std::vector<ASStackUnpositionedLine> lines;
+
   //TODO if infinite max stack size, fast path
   if (style.flexWrap == ASStackLayoutFlexWrapNoWrap) {
-    return std::vector<ASStackUnpositionedLine> (1, {.items = std::move(items)});
+    lines.push_back({.items = std::move(items)});
+    return lines;
   }
   
-  std::vector<ASStackUnpositionedLine> lines;
   std::vector<ASStackLayoutSpecItem> lineItems;
   CGFloat lineStackDimensionSum = 0;
   CGFloat interitemSpacing = 0;
 
   for(auto it = items.begin(); it != items.end(); ++it) {
-    const auto &item = *it;
+    auto &item = *it;
     const CGFloat itemStackDimension = stackDimension(style.direction, item.layout.size);
     const CGFloat itemAndSpacingStackDimension = item.child.style.spacingBefore + itemStackDimension + item.child.style.spacingAfter;
     const BOOL negativeViolationIfAddItem = (ASStackUnpositionedLayout::computeStackViolation(lineStackDimensionSum + interitemSpacing + itemAndSpacingStackDimension, style, sizeRange) < 0);
     const BOOL breakCurrentLine = negativeViolationIfAddItem && !lineItems.empty();
     
     if (breakCurrentLine) {
-      lines.push_back({.items = std::vector<ASStackLayoutSpecItem> (lineItems)});
+      lines.push_back({.items = std::move(lineItems)});
       lineItems.clear();
       lineStackDimensionSum = 0;
       interitemSpacing = 0;
@@ -662,7 +707,7 @@ static std::vector<ASStackUnpositionedLine> collectChildrenIntoLines(const std::
   }
   
   // Handle last line
-  lines.push_back({.items = std::vector<ASStackLayoutSpecItem> (lineItems)});
+  lines.push_back({.items = std::move(lineItems)});
   
   return lines;
 }
@@ -731,7 +776,7 @@ ASStackUnpositionedLayout ASStackUnpositionedLayout::compute(const std::vector<A
                                               optimizedFlexing);
   
   // Collect items into lines (https://www.w3.org/TR/css-flexbox-1/#algo-line-break)
-  std::vector<ASStackUnpositionedLine> lines = collectChildrenIntoLines(items, style, sizeRange);
+  std::vector<ASStackUnpositionedLine> lines = collectChildrenIntoLines(std::move(items), style, sizeRange);
   
   // Resolve the flexible lengths (https://www.w3.org/TR/css-flexbox-1/#resolve-flexible-lengths)
   flexLinesAlongStackDimension(lines, style, concurrent, sizeRange, parentSize, optimizedFlexing);
@@ -0,0 +1,174 @@
+//
+//  _ASAsyncTransactionQueue.h
+//  Texture
+//
+//  Copyright (c) Facebook, Inc. and its affiliates.  All rights reserved.
+//  Changes after 4/13/2017 are: Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+#if defined(__cplusplus)
+
+#import <atomic>
+#import <condition_variable>
+#import <list>
+#import <memory>
+#import <mutex>
+#import <vector>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Lightweight operation queue for _ASAsyncTransaction that limits number of spawned threads.
+ *
+ * Every target dispatch queue gets a fixed set of worker slots. Producers hand new operations to the slots round-robin,
+ * and each slot has its own lock and its own pool of operation nodes, so producers and workers rarely contend. A worker
+ * drains its own slot and steals from the other slots once it runs dry. The first worker takes operations in queue
+ * order (regardless of priority), the other workers take the highest priority operation available in any slot.
+ */
+class ASAsyncTransactionQueue
+{
+public:
+
+  // Similar to dispatch_group_t
+  class Group
+  {
+  public:
+    // call when group is no longer needed; after last scheduled operation the group will delete itself
+    virtual void release() = 0;
+
+    // schedule block on given queue
+    virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block) = 0;
+
+    // dispatch block on given queue when all previously scheduled blocks finished executing
+    virtual void notify(dispatch_queue_t queue, dispatch_block_t block) = 0;
+
+    // used when manually executing blocks
+    virtual void enter() = 0;
+    virtual void leave() = 0;
+
+    // wait until all scheduled blocks finished executing
+    virtual void wait() = 0;
+
+  protected:
+    virtual ~Group() { }; // call release() instead
+  };
+
+  // Create new group
+  Group *createGroup();
+
+  static ASAsyncTransactionQueue &instance();
+
+private:
+
+  ASAsyncTransactionQueue() : _lastEntry(nullptr) {}
+
+  struct GroupNotify
+  {
+    dispatch_block_t _block;
+    dispatch_queue_t _queue;
+  };
+
+  class GroupImpl : public Group
+  {
+  public:
+    GroupImpl(ASAsyncTransactionQueue &queue)
+      : _pendingOperations(0)
+      , _retainCount(1)
+      , _queue(queue)
+    {
+    }
+
+    virtual void release();
+    virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block);
+    virtual void notify(dispatch_queue_t queue, dispatch_block_t block);
+    virtual void enter();
+    virtual void leave();
+    virtual void wait();
+
+    // One reference for the owner (dropped by release()) and one per pending operation.
+    void retain();
+    void releaseReference();
+
+    std::atomic<int> _pendingOperations;
+    std::atomic<int> _retainCount;
+    std::mutex _notifyMutex; // guards _notifyList, used with _condition
+    std::list<GroupNotify> _notifyList;
+    std::condition_variable _condition;
+    ASAsyncTransactionQueue &_queue;
+  };
+
+  struct Operation
+  {
+    dispatch_block_t _block;
+    GroupImpl *_group;
+    NSInteger _priority;
+    uint64_t _sequence;
+    Operation *_next;
+  };
+
+  // FIFO list of the operations with one priority
+  struct Bucket
+  {
+    NSInteger _priority;
+    Operation *_head;
+    Operation *_tail;
+  };
+
+  // Work queue owned by at most one worker at a time; other workers may steal from it.
+  struct Slot
+  {
+    Slot();
+    ~Slot();
+
+    void push(Operation *operation);                  // assumes locked mutex
+    Operation *pop(bool respectPriority);             // assumes locked mutex
+    Operation *dequeueFreeOperation();                // assumes locked mutex
+    void recycle(Operation *operation);               // assumes locked mutex
+    void publish();                                   // assumes locked mutex
+
+    AS::Mutex _mutex;
+    std::vector<Bucket> _buckets;                     // sorted by ascending priority
+    Operation *_freeList;                             // pooled operation nodes
+
+    // Snapshot of the slot's head operations, read without the lock to choose which slot to take work from.
+    std::atomic<uint64_t> _oldestSequence;
+    std::atomic<NSInteger> _highestPriority;
+
+    std::atomic<bool> _active;                        // a worker currently owns this slot
+  };
+
+  struct DispatchEntry // entry for each dispatch queue
+  {
+    DispatchEntry(dispatch_queue_t queue, NSUInteger slotCount);
+
+    void pushOperation(dispatch_block_t block, GroupImpl *group, NSInteger priority);
+    bool popNextOperation(NSUInteger slot, bool respectPriority, dispatch_block_t &block, GroupImpl *&group);
+    void spawnWorkerIfNeeded(NSUInteger maxThreads);
+    NSInteger claimSlot();
+    void work(NSUInteger slot);
+
+    dispatch_queue_t _queue;
+    NSUInteger _slotCount;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<NSUInteger> _nextSlot;                // round-robin cursor for producers
+    std::atomic<NSUInteger> _workerCount;
+    std::atomic<NSInteger> _queuedCount;              // pushed but not yet popped
+    std::atomic<uint64_t> _nextSequence;
+  };
+
+  DispatchEntry &entryForQueue(dispatch_queue_t queue);
+
+  // Entries are never destroyed, so they can be looked up without holding a lock.
+  std::atomic<DispatchEntry *> _lastEntry;
+  std::vector<DispatchEntry *> _entries;
+  AS::Mutex _entriesMutex;
+};
+
+NS_ASSUME_NONNULL_END
+
+#endif
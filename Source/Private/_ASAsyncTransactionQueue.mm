@@ -0,0 +1,369 @@
+//
+//  _ASAsyncTransactionQueue.mm
+//  Texture
+//
+//  Copyright (c) Facebook, Inc. and its affiliates.  All rights reserved.
+//  Changes after 4/13/2017 are: Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/_ASAsyncTransactionQueue.h>
+#import <AsyncDisplayKit/ASAssert.h>
+#import <algorithm>
+#import <limits>
+
+ASDK_EXTERN NSRunLoopMode const UITrackingRunLoopMode;
+
+static uint64_t const kASEmptySlotSequence = std::numeric_limits<uint64_t>::max();
+static NSInteger const kASEmptySlotPriority = std::numeric_limits<NSInteger>::min();
+
+#pragma mark - Group
+
+ASAsyncTransactionQueue::Group* ASAsyncTransactionQueue::createGroup()
+{
+  Group *res = new GroupImpl(*this);
+  return res;
+}
+
+void ASAsyncTransactionQueue::GroupImpl::retain()
+{
+  _retainCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ASAsyncTransactionQueue::GroupImpl::releaseReference()
+{
+  if (_retainCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+void ASAsyncTransactionQueue::GroupImpl::release()
+{
+  // If operations are still scheduled, the last one to leave deletes the group.
+  releaseReference();
+}
+
+void ASAsyncTransactionQueue::GroupImpl::schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block)
+{
+  enter();
+
+  DispatchEntry &entry = _queue.entryForQueue(queue);
+  entry.pushOperation(block, this, priority);
+
+#if ASDISPLAYNODE_DELAY_DISPLAY
+  NSUInteger maxThreads = 1;
+#else
+  NSUInteger maxThreads = [NSProcessInfo processInfo].activeProcessorCount * 2;
+
+  // Bit questionable maybe - we can give main thread more CPU time during tracking.
+  if ([[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode])
+    --maxThreads;
+#endif
+
+  entry.spawnWorkerIfNeeded(maxThreads);
+}
+
+void ASAsyncTransactionQueue::GroupImpl::notify(dispatch_queue_t queue, dispatch_block_t block)
+{
+  std::lock_guard<std::mutex> l(_notifyMutex);
+
+  if (_pendingOperations.load() == 0) {
+    dispatch_async(queue, block);
+  } else {
+    _notifyList.push_back({block, queue});
+  }
+}
+
+void ASAsyncTransactionQueue::GroupImpl::enter()
+{
+  retain();
+  _pendingOperations.fetch_add(1);
+}
+
+void ASAsyncTransactionQueue::GroupImpl::leave()
+{
+  if (_pendingOperations.fetch_sub(1) == 1) {
+    std::list<GroupNotify> notifyList;
+    {
+      std::lock_guard<std::mutex> l(_notifyMutex);
+      _notifyList.swap(notifyList);
+      _condition.notify_all();
+    }
+
+    for (GroupNotify & notify : notifyList) {
+      dispatch_async(notify._queue, notify._block);
+    }
+  }
+
+  // If release() was called before, this is where the group gets deleted.
+  releaseReference();
+}
+
+void ASAsyncTransactionQueue::GroupImpl::wait()
+{
+  std::unique_lock<std::mutex> lock(_notifyMutex);
+  while (_pendingOperations.load() > 0) {
+    _condition.wait(lock);
+  }
+}
+
+#pragma mark - Slot
+
+ASAsyncTransactionQueue::Slot::Slot()
+  : _freeList(NULL)
+  , _oldestSequence(kASEmptySlotSequence)
+  , _highestPriority(kASEmptySlotPriority)
+  , _active(false)
+{
+  // Display priorities take very few distinct values, so this is usually the only allocation the buckets need.
+  _buckets.reserve(4);
+}
+
+ASAsyncTransactionQueue::Slot::~Slot()
+{
+  while (_freeList != NULL) {
+    Operation *next = _freeList->_next;
+    delete _freeList;
+    _freeList = next;
+  }
+}
+
+ASAsyncTransactionQueue::Operation *ASAsyncTransactionQueue::Slot::dequeueFreeOperation()
+{
+  Operation *operation = _freeList;
+  if (operation != NULL) {
+    _freeList = operation->_next;
+  } else {
+    operation = new Operation();
+  }
+  operation->_next = NULL;
+  return operation;
+}
+
+void ASAsyncTransactionQueue::Slot::recycle(Operation *operation)
+{
+  operation->_block = nil;
+  operation->_group = NULL;
+  operation->_next = _freeList;
+  _freeList = operation;
+}
+
+void ASAsyncTransactionQueue::Slot::push(Operation *operation)
+{
+  auto bucket = std::lower_bound(_buckets.begin(), _buckets.end(), operation->_priority, [](const Bucket &b, NSInteger priority) {
+    return b._priority < priority;
+  });
+  if (bucket == _buckets.end() || bucket->_priority != operation->_priority) {
+    bucket = _buckets.insert(bucket, {operation->_priority, NULL, NULL});
+  }
+
+  if (bucket->_tail != NULL) {
+    bucket->_tail->_next = operation;
+  } else {
+    bucket->_head = operation;
+  }
+  bucket->_tail = operation;
+  publish();
+}
+
+ASAsyncTransactionQueue::Operation *ASAsyncTransactionQueue::Slot::pop(bool respectPriority)
+{
+  if (_buckets.empty()) {
+    return NULL;
+  }
+
+  auto bucket = _buckets.end() - 1; // highest priority "bucket"
+  if (!respectPriority) {
+    for (auto it = _buckets.begin(); it != _buckets.end(); ++it) {
+      if (it->_head->_sequence < bucket->_head->_sequence) {
+        bucket = it;
+      }
+    }
+  }
+
+  Operation *operation = bucket->_head;
+  bucket->_head = operation->_next;
+  if (bucket->_head == NULL) {
+    _buckets.erase(bucket);
+  }
+  publish();
+  return operation;
+}
+
+void ASAsyncTransactionQueue::Slot::publish()
+{
+  uint64_t oldestSequence = kASEmptySlotSequence;
+  for (const Bucket &bucket : _buckets) {
+    oldestSequence = std::min(oldestSequence, bucket._head->_sequence);
+  }
+  _oldestSequence.store(oldestSequence, std::memory_order_release);
+  _highestPriority.store(_buckets.empty() ? kASEmptySlotPriority : _buckets.back()._priority, std::memory_order_release);
+}
+
+#pragma mark - Dispatch Entry
+
+ASAsyncTransactionQueue::DispatchEntry::DispatchEntry(dispatch_queue_t queue, NSUInteger slotCount)
+  : _queue(queue)
+  , _slotCount(slotCount)
+  , _slots(new Slot[slotCount])
+  , _nextSlot(0)
+  , _workerCount(0)
+  , _queuedCount(0)
+  , _nextSequence(0)
+{
+}
+
+void ASAsyncTransactionQueue::DispatchEntry::pushOperation(dispatch_block_t block, GroupImpl *group, NSInteger priority)
+{
+  Slot &slot = _slots[_nextSlot.fetch_add(1, std::memory_order_relaxed) % _slotCount];
+  {
+    AS::MutexLocker l(slot._mutex);
+    Operation *operation = slot.dequeueFreeOperation();
+    operation->_block = block;
+    operation->_group = group;
+    operation->_priority = priority;
+    operation->_sequence = _nextSequence.fetch_add(1, std::memory_order_relaxed);
+    slot.push(operation);
+  }
+  // Must come after the push is visible, see work().
+  _queuedCount.fetch_add(1);
+}
+
+bool ASAsyncTransactionQueue::DispatchEntry::popNextOperation(NSUInteger slotIndex, bool respectPriority, dispatch_block_t &block, GroupImpl *&group)
+{
+  while (_queuedCount.load() > 0) {
+    // Pick the slot with the best head operation for our policy, preferring our own slot on ties.
+    NSUInteger victim = slotIndex;
+    if (respectPriority) {
+      NSInteger best = _slots[slotIndex]._highestPriority.load(std::memory_order_acquire);
+      for (NSUInteger i = 0; i < _slotCount; i++) {
+        NSInteger priority = _slots[i]._highestPriority.load(std::memory_order_acquire);
+        if (priority > best) {
+          best = priority;
+          victim = i;
+        }
+      }
+    } else {
+      uint64_t best = _slots[slotIndex]._oldestSequence.load(std::memory_order_acquire);
+      for (NSUInteger i = 0; i < _slotCount; i++) {
+        uint64_t sequence = _slots[i]._oldestSequence.load(std::memory_order_acquire);
+        if (sequence < best) {
+          best = sequence;
+          victim = i;
+        }
+      }
+    }
+
+    Slot &slot = _slots[victim];
+    AS::MutexLocker l(slot._mutex);
+    Operation *operation = slot.pop(respectPriority);
+    if (operation != NULL) {
+      _queuedCount.fetch_sub(1);
+      block = operation->_block;
+      group = operation->_group;
+      slot.recycle(operation);
+      return true;
+    }
+    // Someone else took it between the snapshot and the lock. Look again.
+  }
+  return false;
+}
+
+NSInteger ASAsyncTransactionQueue::DispatchEntry::claimSlot()
+{
+  // Scan from the front so that the first worker always gets slot 0.
+  for (NSUInteger i = 0; i < _slotCount; i++) {
+    bool expected = false;
+    if (_slots[i]._active.compare_exchange_strong(expected, true)) {
+      return i;
+    }
+  }
+  ASDisplayNodeCFailAssert(@"Worker count is out of sync with the claimed slots");
+  return NSNotFound;
+}
+
+void ASAsyncTransactionQueue::DispatchEntry::spawnWorkerIfNeeded(NSUInteger maxThreads)
+{
+  maxThreads = MIN(maxThreads, _slotCount);
+  NSUInteger workerCount = _workerCount.load();
+  while (workerCount < maxThreads) {
+    if (_workerCount.compare_exchange_weak(workerCount, workerCount + 1)) { // we need to spawn another thread
+      NSInteger slot = claimSlot();
+      dispatch_async(_queue, ^{
+        work(slot);
+      });
+      return;
+    }
+  }
+}
+
+void ASAsyncTransactionQueue::DispatchEntry::work(NSUInteger slot)
+{
+  while (true) {
+    // first thread will take operations in queue order (regardless of priority), other threads will respect priority
+    bool respectPriority = (slot != 0);
+
+    // go until there are no more pending operations
+    dispatch_block_t block;
+    GroupImpl *group = NULL;
+    while (popNextOperation(slot, respectPriority, block, group)) {
+      if (block) {
+        block();
+      }
+      group->leave();
+      block = nil; // release the block before picking up the next operation
+    }
+
+    _slots[slot]._active.store(false);
+    NSUInteger workerCount = _workerCount.fetch_sub(1) - 1;
+
+    // A producer that saw a full worker count before our decrement relies on us to pick up its operation. Since both
+    // sides use sequentially consistent operations, either it sees our decrement and spawns, or we see its operation.
+    if (_queuedCount.load() == 0) {
+      return;
+    }
+    do {
+      if (workerCount >= _slotCount) {
+        return;
+      }
+    } while (!_workerCount.compare_exchange_weak(workerCount, workerCount + 1));
+    slot = claimSlot();
+  }
+}
+
+#pragma mark - Queue
+
+ASAsyncTransactionQueue::DispatchEntry &ASAsyncTransactionQueue::entryForQueue(dispatch_queue_t queue)
+{
+  // Nearly all operations go to the display queue, so remember the last entry.
+  DispatchEntry *entry = _lastEntry.load(std::memory_order_acquire);
+  if (entry != NULL && entry->_queue == queue) {
+    return *entry;
+  }
+
+  AS::MutexLocker l(_entriesMutex);
+  entry = NULL;
+  for (DispatchEntry *e : _entries) {
+    if (e->_queue == queue) {
+      entry = e;
+      break;
+    }
+  }
+  if (entry == NULL) {
+#if ASDISPLAYNODE_DELAY_DISPLAY
+    NSUInteger slotCount = 1;
+#else
+    NSUInteger slotCount = [NSProcessInfo processInfo].activeProcessorCount * 2;
+#endif
+    entry = new DispatchEntry(queue, slotCount);
+    _entries.push_back(entry);
+  }
+  _lastEntry.store(entry, std::memory_order_release);
+  return *entry;
+}
+
+ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
+{
+  static ASAsyncTransactionQueue *instance = new ASAsyncTransactionQueue();
+  return *instance;
+}
@@ -51,18 +51,7 @@
 
 - (NSUInteger)hash
 {
-  struct {
-    CGSize itemSize;
-    CGFloat minimumLineSpacing;
-    CGFloat minimumInteritemSpacing;
-    UIEdgeInsets sectionInset;
-  } data = {
-    _itemSize,
-    _minimumLineSpacing,
-    _minimumInteritemSpacing,
-    _sectionInset,
-  };
-  return ASHashBytes(&data, sizeof(data));
+  return AS::hashFields(_itemSize, _minimumLineSpacing, _minimumInteritemSpacing, _sectionInset);
 }
 
 @end
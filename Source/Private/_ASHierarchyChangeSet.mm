@@ -12,7 +12,9 @@
 #import <AsyncDisplayKit/ASCollections.h>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
 #import <AsyncDisplayKit/ASDisplayNode+Beta.h>
+#import <numeric>
 #import <unordered_map>
+#import <vector>
 #import <AsyncDisplayKit/ASDataController.h>
 
 // If assertions are enabled and they haven't forced us to suppress the exception,
@@ -281,9 +283,13 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType)
     _itemMappings = [[NSMutableArray alloc] init];
     const auto insertMap = [_ASHierarchyItemChange sectionToIndexSetMapFromChanges:_originalInsertItemChanges];
     const auto deleteMap = [_ASHierarchyItemChange sectionToIndexSetMapFromChanges:_originalDeleteItemChanges];
+    // Map all sections at once rather than messaging the section mapping for each of them.
+    std::vector<NSInteger> newSections(_oldItemCounts.size());
+    std::iota(newSections.begin(), newSections.end(), 0);
+    [self.sectionMapping mapIntegers:newSections.data() count:newSections.size()];
     NSInteger oldSection = 0;
     for (NSInteger oldCount : _oldItemCounts) {
-      NSInteger newSection = [self newSectionForOldSection:oldSection];
+      NSInteger newSection = newSections[oldSection];
       ASIntegerMap *table;
       if (newSection == NSNotFound) {
         table = ASIntegerMap.emptyMap;
@@ -303,8 +309,11 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType)
 
   if (_reverseItemMappings == nil) {
     _reverseItemMappings = [[NSMutableArray alloc] init];
+    std::vector<NSInteger> oldSections(_newItemCounts.size());
+    std::iota(oldSections.begin(), oldSections.end(), 0);
+    [self.reverseSectionMapping mapIntegers:oldSections.data() count:oldSections.size()];
     for (NSInteger newSection = 0; newSection < _newItemCounts.size(); newSection++) {
-      NSInteger oldSection = [self oldSectionForNewSection:newSection];
+      NSInteger oldSection = oldSections[newSection];
       ASIntegerMap *table;
       if (oldSection == NSNotFound) {
         table = ASIntegerMap.emptyMap;
@@ -36,6 +36,11 @@
 
 @property (nonatomic, readonly) BOOL hasChanges;
 
+/**
+ * A bit for each kind of property that has been set. States with the same mask are applied with the same setters.
+ */
+@property (nonatomic, readonly) uint64_t changesMask;
+
 - (void)clearChanges;
 
 @end
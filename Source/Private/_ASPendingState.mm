@@ -13,88 +13,110 @@
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 
-#define __shouldSetNeedsDisplayForView(view) (flags.needsDisplay \
-  || (flags.setOpaque && _flags.opaque != (view).opaque)\
-  || (flags.setBackgroundColor && ![backgroundColor isEqual:(view).backgroundColor])\
-  || (flags.setTintColor && ![tintColor isEqual:(view).tintColor]))
-
-#define __shouldSetNeedsDisplayForLayer(layer) (flags.needsDisplay \
-  || (flags.setOpaque && _flags.opaque != (layer).opaque)\
-  || (flags.setBackgroundColor && ![backgroundColor isEqual:[UIColor colorWithCGColor:(layer).backgroundColor]]))
-
-typedef struct {
+/**
+ * The properties that have been set, in the order they are applied. Each is a bit in ASPendingStateFlags, so that
+ * applying a state only visits the bits that are set, which are usually a few.
+ */
+typedef NS_ENUM(uint8_t, ASPendingStateFlag) {
   // Properties
-  int needsDisplay:1;
-  int needsLayout:1;
-  int layoutIfNeeded:1;
-  
+  ASPendingStateNeedsDisplay,
+
   // Flags indicating that a given property should be applied to the view at creation
-  int setClipsToBounds:1;
-  int setOpaque:1;
-  int setNeedsDisplayOnBoundsChange:1;
-  int setAutoresizesSubviews:1;
-  int setAutoresizingMask:1;
-  int setFrame:1;
-  int setBounds:1;
-  int setBackgroundColor:1;
-  int setTintColor:1;
-  int setHidden:1;
-  int setAlpha:1;
-  int setCornerRadius:1;
-  int setContentMode:1;
-  int setNeedsDisplay:1;
-  int setAnchorPoint:1;
-  int setPosition:1;
-  int setZPosition:1;
-  int setTransform:1;
-  int setSublayerTransform:1;
-  int setContents:1;
-  int setContentsGravity:1;
-  int setContentsRect:1;
-  int setContentsCenter:1;
-  int setContentsScale:1;
-  int setRasterizationScale:1;
-  int setUserInteractionEnabled:1;
-  int setExclusiveTouch:1;
-  int setShadowColor:1;
-  int setShadowOpacity:1;
-  int setShadowOffset:1;
-  int setShadowRadius:1;
-  int setBorderWidth:1;
-  int setBorderColor:1;
-  int setAsyncTransactionContainer:1;
-  int setAllowsGroupOpacity:1;
-  int setAllowsEdgeAntialiasing:1;
-  int setEdgeAntialiasingMask:1;
-  int setIsAccessibilityElement:1;
-  int setAccessibilityLabel:1;
-  int setAccessibilityAttributedLabel:1;
-  int setAccessibilityHint:1;
-  int setAccessibilityAttributedHint:1;
-  int setAccessibilityValue:1;
-  int setAccessibilityAttributedValue:1;
-  int setAccessibilityTraits:1;
-  int setAccessibilityFrame:1;
-  int setAccessibilityLanguage:1;
-  int setAccessibilityElementsHidden:1;
-  int setAccessibilityViewIsModal:1;
-  int setShouldGroupAccessibilityChildren:1;
-  int setAccessibilityIdentifier:1;
-  int setAccessibilityNavigationStyle:1;
-  int setAccessibilityCustomActions:1;
-  int setAccessibilityHeaderElements:1;
-  int setAccessibilityActivationPoint:1;
-  int setAccessibilityPath:1;
-  int setSemanticContentAttribute:1;
-  int setLayoutMargins:1;
-  int setPreservesSuperviewLayoutMargins:1;
-  int setInsetsLayoutMarginsFromSafeArea:1;
-  int setActions:1;
-  int setMaskedCorners : 1;
-} ASPendingStateFlags;
-
-
-static constexpr ASPendingStateFlags kZeroFlags = {0};
+  ASPendingStateSetAnchorPoint,
+  ASPendingStateSetPosition,
+  ASPendingStateSetZPosition,
+  ASPendingStateSetBounds,
+  ASPendingStateSetTransform,
+  ASPendingStateSetSublayerTransform,
+  ASPendingStateSetContents,
+  ASPendingStateSetContentsGravity,
+  ASPendingStateSetContentsRect,
+  ASPendingStateSetContentsCenter,
+  ASPendingStateSetContentsScale,
+  ASPendingStateSetRasterizationScale,
+  ASPendingStateSetClipsToBounds,
+  ASPendingStateSetBackgroundColor,
+  ASPendingStateSetTintColor,
+  ASPendingStateSetOpaque,
+  ASPendingStateSetHidden,
+  ASPendingStateSetAlpha,
+  ASPendingStateSetCornerRadius,
+  ASPendingStateSetMaskedCorners,
+  ASPendingStateSetContentMode, // After contentsGravity, which it overrides.
+  ASPendingStateSetUserInteractionEnabled,
+  ASPendingStateSetExclusiveTouch,
+  ASPendingStateSetShadowColor,
+  ASPendingStateSetShadowOpacity,
+  ASPendingStateSetShadowOffset,
+  ASPendingStateSetShadowRadius,
+  ASPendingStateSetBorderWidth,
+  ASPendingStateSetBorderColor,
+  ASPendingStateSetAutoresizingMask,
+  ASPendingStateSetAutoresizesSubviews,
+  ASPendingStateSetNeedsDisplayOnBoundsChange,
+  ASPendingStateSetAllowsGroupOpacity,
+  ASPendingStateSetAllowsEdgeAntialiasing,
+  ASPendingStateSetEdgeAntialiasingMask,
+  ASPendingStateSetAsyncTransactionContainer,
+  ASPendingStateSetLayoutMargins,
+  ASPendingStateSetPreservesSuperviewLayoutMargins,
+  ASPendingStateSetInsetsLayoutMarginsFromSafeArea,
+  ASPendingStateSetSemanticContentAttribute,
+  ASPendingStateSetIsAccessibilityElement,
+  ASPendingStateSetAccessibilityLabel,
+  ASPendingStateSetAccessibilityHint,
+  ASPendingStateSetAccessibilityValue,
+  ASPendingStateSetAccessibilityAttributedLabel,
+  ASPendingStateSetAccessibilityAttributedHint,
+  ASPendingStateSetAccessibilityAttributedValue,
+  ASPendingStateSetAccessibilityTraits,
+  ASPendingStateSetAccessibilityFrame,
+  ASPendingStateSetAccessibilityLanguage,
+  ASPendingStateSetAccessibilityElementsHidden,
+  ASPendingStateSetAccessibilityViewIsModal,
+  ASPendingStateSetShouldGroupAccessibilityChildren,
+  ASPendingStateSetAccessibilityIdentifier,
+  ASPendingStateSetAccessibilityNavigationStyle,
+  ASPendingStateSetAccessibilityCustomActions,
+  ASPendingStateSetAccessibilityHeaderElements,
+  ASPendingStateSetAccessibilityActivationPoint,
+  ASPendingStateSetAccessibilityPath,
+  ASPendingStateSetActions, // Last, so that the layer's other properties aren't animated with the new actions.
+
+  // Applied after all others.
+  ASPendingStateSetFrame,
+  ASPendingStateNeedsLayout,
+  ASPendingStateLayoutIfNeeded,
+  ASPendingStateFlagCount
+};
+
+typedef uint64_t ASPendingStateFlags;
+static_assert(ASPendingStateFlagCount <= 64, "ASPendingStateFlags has a bit for each flag");
+
+static constexpr ASPendingStateFlags ASPendingStateMask(ASPendingStateFlag flag)
+{
+  return 1ULL << flag;
+}
+
+// Applied around the others instead of in order.
+static constexpr ASPendingStateFlags kASPendingStateUnorderedFlags = ASPendingStateMask(ASPendingStateNeedsDisplay)
+  | ASPendingStateMask(ASPendingStateSetFrame) | ASPendingStateMask(ASPendingStateNeedsLayout)
+  | ASPendingStateMask(ASPendingStateLayoutIfNeeded);
+
+// Applied to layers with ASPendingStateApplyMetricsToLayer.
+static constexpr ASPendingStateFlags kASPendingStateLayerMetricsFlags = ASPendingStateMask(ASPendingStateSetPosition)
+  | ASPendingStateMask(ASPendingStateSetBounds);
+
+#define __hasFlag(flags, flag) (((flags) & ASPendingStateMask(flag)) != 0)
+
+#define __shouldSetNeedsDisplayForView(view) (__hasFlag(flags, ASPendingStateNeedsDisplay) \
+  || (__hasFlag(flags, ASPendingStateSetOpaque) && _flags.opaque != (view).opaque)\
+  || (__hasFlag(flags, ASPendingStateSetBackgroundColor) && ![backgroundColor isEqual:(view).backgroundColor])\
+  || (__hasFlag(flags, ASPendingStateSetTintColor) && ![tintColor isEqual:(view).tintColor]))
+
+#define __shouldSetNeedsDisplayForLayer(layer) (__hasFlag(flags, ASPendingStateNeedsDisplay) \
+  || (__hasFlag(flags, ASPendingStateSetOpaque) && _flags.opaque != (layer).opaque)\
+  || (__hasFlag(flags, ASPendingStateSetBackgroundColor) && ![backgroundColor isEqual:[UIColor colorWithCGColor:(layer).backgroundColor]]))
 
 @implementation _ASPendingState
 {
@@ -177,16 +199,16 @@ static constexpr ASPendingStateFlags kZeroFlags = {0};
  */
 ASDISPLAYNODE_INLINE void ASPendingStateApplyMetricsToLayer(_ASPendingState *state, CALayer *layer) {
   ASPendingStateFlags flags = state->_stateToApplyFlags;
-  if (flags.setFrame) {
+  if (__hasFlag(flags, ASPendingStateSetFrame)) {
     CGRect _bounds = CGRectZero;
     CGPoint _position = CGPointZero;
     ASBoundsAndPositionForFrame(state->frame, layer.bounds.origin, layer.anchorPoint, &_bounds, &_position);
     layer.bounds = _bounds;
     layer.position = _position;
   } else {
-    if (flags.setBounds)
+    if (__hasFlag(flags, ASPendingStateSetBounds))
       layer.bounds = state->bounds;
-    if (flags.setPosition)
+    if (__hasFlag(flags, ASPendingStateSetPosition))
       layer.position = state->position;
   }
 }
@@ -259,7 +281,6 @@ static CGColorRef blackColorRef = NULL;
   alpha = 1.0f;
   cornerRadius = 0.0f;
   contentMode = UIViewContentModeScaleToFill;
-  _stateToApplyFlags.needsDisplay = NO;
   anchorPoint = CGPointMake(0.5, 0.5);
   position = CGPointZero;
   zPosition = 0.0;
@@ -308,23 +329,23 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setNeedsDisplay
 {
-  _stateToApplyFlags.needsDisplay = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateNeedsDisplay);
 }
 
 - (void)setNeedsLayout
 {
-  _stateToApplyFlags.needsLayout = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateNeedsLayout);
 }
 
 - (void)layoutIfNeeded
 {
-  _stateToApplyFlags.layoutIfNeeded = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateLayoutIfNeeded);
 }
 
 - (void)setClipsToBounds:(BOOL)flag
 {
   _flags.clipsToBounds = flag;
-  _stateToApplyFlags.setClipsToBounds = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetClipsToBounds);
 }
 
 - (BOOL)clipsToBounds
@@ -335,7 +356,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setOpaque:(BOOL)flag
 {
   _flags.opaque = flag;
-  _stateToApplyFlags.setOpaque = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetOpaque);
 }
 
 - (BOOL)isOpaque
@@ -346,7 +367,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setNeedsDisplayOnBoundsChange:(BOOL)flag
 {
   _flags.needsDisplayOnBoundsChange = flag;
-  _stateToApplyFlags.setNeedsDisplayOnBoundsChange = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetNeedsDisplayOnBoundsChange);
 }
 
 - (BOOL)needsDisplayOnBoundsChange
@@ -357,7 +378,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAllowsGroupOpacity:(BOOL)flag
 {
   _flags.allowsGroupOpacity = flag;
-  _stateToApplyFlags.setAllowsGroupOpacity = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAllowsGroupOpacity);
 }
 
 - (BOOL)allowsGroupOpacity
@@ -368,7 +389,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAllowsEdgeAntialiasing:(BOOL)flag
 {
   _flags.allowsEdgeAntialiasing = flag;
-  _stateToApplyFlags.setAllowsEdgeAntialiasing = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAllowsEdgeAntialiasing);
 }
 
 - (BOOL)allowsEdgeAntialiasing
@@ -379,13 +400,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setEdgeAntialiasingMask:(CAEdgeAntialiasingMask)mask
 {
   edgeAntialiasingMask = mask;
-  _stateToApplyFlags.setEdgeAntialiasingMask = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetEdgeAntialiasingMask);
 }
 
 - (void)setAutoresizesSubviews:(BOOL)flag
 {
   _flags.autoresizesSubviews = flag;
-  _stateToApplyFlags.setAutoresizesSubviews = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAutoresizesSubviews);
 }
 
 - (BOOL)autoresizesSubviews
@@ -396,13 +417,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAutoresizingMask:(UIViewAutoresizing)mask
 {
   autoresizingMask = mask;
-  _stateToApplyFlags.setAutoresizingMask = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAutoresizingMask);
 }
 
 - (void)setFrame:(CGRect)newFrame
 {
   frame = newFrame;
-  _stateToApplyFlags.setFrame = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetFrame);
 }
 
 - (void)setBounds:(CGRect)newBounds
@@ -413,7 +434,7 @@ static CGColorRef blackColorRef = NULL;
   if (isnan(newBounds.size.height))
     newBounds.size.height = 0.0;
   bounds = newBounds;
-  _stateToApplyFlags.setBounds = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetBounds);
 }
 
 - (UIColor *)backgroundColor
@@ -427,7 +448,7 @@ static CGColorRef blackColorRef = NULL;
     return;
   }
   backgroundColor = color;
-  _stateToApplyFlags.setBackgroundColor = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetBackgroundColor);
 }
 
 - (UIColor *)tintColor
@@ -441,13 +462,13 @@ static CGColorRef blackColorRef = NULL;
     return;
   }
   tintColor = newTintColor;
-  _stateToApplyFlags.setTintColor = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetTintColor);
 }
 
 - (void)setHidden:(BOOL)flag
 {
   _flags.hidden = flag;
-  _stateToApplyFlags.setHidden = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetHidden);
 }
 
 - (BOOL)isHidden
@@ -458,31 +479,31 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAlpha:(CGFloat)newAlpha
 {
   alpha = newAlpha;
-  _stateToApplyFlags.setAlpha = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAlpha);
 }
 
 - (void)setCornerRadius:(CGFloat)newCornerRadius
 {
   cornerRadius = newCornerRadius;
-  _stateToApplyFlags.setCornerRadius = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetCornerRadius);
 }
 
 - (void)setMaskedCorners:(CACornerMask)newMaskedCorners
 {
   maskedCorners = newMaskedCorners;
-  _stateToApplyFlags.setMaskedCorners = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetMaskedCorners);
 }
 
 - (void)setContentMode:(UIViewContentMode)newContentMode
 {
   contentMode = newContentMode;
-  _stateToApplyFlags.setContentMode = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContentMode);
 }
 
 - (void)setAnchorPoint:(CGPoint)newAnchorPoint
 {
   anchorPoint = newAnchorPoint;
-  _stateToApplyFlags.setAnchorPoint = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAnchorPoint);
 }
 
 - (void)setPosition:(CGPoint)newPosition
@@ -493,25 +514,25 @@ static CGColorRef blackColorRef = NULL;
   if (isnan(newPosition.y))
     newPosition.y = 0.0;
   position = newPosition;
-  _stateToApplyFlags.setPosition = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetPosition);
 }
 
 - (void)setZPosition:(CGFloat)newPosition
 {
   zPosition = newPosition;
-  _stateToApplyFlags.setZPosition = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetZPosition);
 }
 
 - (void)setTransform:(CATransform3D)newTransform
 {
   transform = newTransform;
-  _stateToApplyFlags.setTransform = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetTransform);
 }
 
 - (void)setSublayerTransform:(CATransform3D)newSublayerTransform
 {
   sublayerTransform = newSublayerTransform;
-  _stateToApplyFlags.setSublayerTransform = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetSublayerTransform);
 }
 
 - (void)setContents:(id)newContents
@@ -521,43 +542,43 @@ static CGColorRef blackColorRef = NULL;
   }
 
   contents = newContents;
-  _stateToApplyFlags.setContents = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContents);
 }
 
 - (void)setContentsGravity:(NSString *)newContentsGravity
 {
   contentsGravity = newContentsGravity;
-  _stateToApplyFlags.setContentsGravity = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContentsGravity);
 }
 
 - (void)setContentsRect:(CGRect)newContentsRect
 {
   contentsRect = newContentsRect;
-  _stateToApplyFlags.setContentsRect = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContentsRect);
 }
 
 - (void)setContentsCenter:(CGRect)newContentsCenter
 {
   contentsCenter = newContentsCenter;
-  _stateToApplyFlags.setContentsCenter = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContentsCenter);
 }
 
 - (void)setContentsScale:(CGFloat)newContentsScale
 {
   contentsScale = newContentsScale;
-  _stateToApplyFlags.setContentsScale = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetContentsScale);
 }
 
 - (void)setRasterizationScale:(CGFloat)newRasterizationScale
 {
   rasterizationScale = newRasterizationScale;
-  _stateToApplyFlags.setRasterizationScale = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetRasterizationScale);
 }
 
 - (void)setUserInteractionEnabled:(BOOL)flag
 {
   _flags.userInteractionEnabled = flag;
-  _stateToApplyFlags.setUserInteractionEnabled = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetUserInteractionEnabled);
 }
 
 - (BOOL)isUserInteractionEnabled
@@ -568,7 +589,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setExclusiveTouch:(BOOL)flag
 {
   _flags.exclusiveTouch = flag;
-  _stateToApplyFlags.setExclusiveTouch = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetExclusiveTouch);
 }
 
 - (BOOL)isExclusiveTouch
@@ -588,31 +609,31 @@ static CGColorRef blackColorRef = NULL;
   shadowColor = color;
   CGColorRetain(shadowColor);
 
-  _stateToApplyFlags.setShadowColor = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetShadowColor);
 }
 
 - (void)setShadowOpacity:(CGFloat)newOpacity
 {
   shadowOpacity = newOpacity;
-  _stateToApplyFlags.setShadowOpacity = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetShadowOpacity);
 }
 
 - (void)setShadowOffset:(CGSize)newOffset
 {
   shadowOffset = newOffset;
-  _stateToApplyFlags.setShadowOffset = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetShadowOffset);
 }
 
 - (void)setShadowRadius:(CGFloat)newRadius
 {
   shadowRadius = newRadius;
-  _stateToApplyFlags.setShadowRadius = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetShadowRadius);
 }
 
 - (void)setBorderWidth:(CGFloat)newWidth
 {
   borderWidth = newWidth;
-  _stateToApplyFlags.setBorderWidth = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetBorderWidth);
 }
 
 - (void)setBorderColor:(CGColorRef)color
@@ -627,13 +648,13 @@ static CGColorRef blackColorRef = NULL;
   borderColor = color;
   CGColorRetain(borderColor);
 
-  _stateToApplyFlags.setBorderColor = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetBorderColor);
 }
 
 - (void)asyncdisplaykit_setAsyncTransactionContainer:(BOOL)flag
 {
   _flags.asyncTransactionContainer = flag;
-  _stateToApplyFlags.setAsyncTransactionContainer = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAsyncTransactionContainer);
 }
 
 - (BOOL)asyncdisplaykit_isAsyncTransactionContainer
@@ -644,13 +665,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setLayoutMargins:(UIEdgeInsets)margins
 {
   layoutMargins = margins;
-  _stateToApplyFlags.setLayoutMargins = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetLayoutMargins);
 }
 
 - (void)setPreservesSuperviewLayoutMargins:(BOOL)flag
 {
   _flags.preservesSuperviewLayoutMargins = flag;
-  _stateToApplyFlags.setPreservesSuperviewLayoutMargins = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetPreservesSuperviewLayoutMargins);
 }
 
 - (BOOL)preservesSuperviewLayoutMargins
@@ -661,7 +682,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setInsetsLayoutMarginsFromSafeArea:(BOOL)flag
 {
   _flags.insetsLayoutMarginsFromSafeArea = flag;
-  _stateToApplyFlags.setInsetsLayoutMarginsFromSafeArea = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetInsetsLayoutMarginsFromSafeArea);
 }
 
 - (BOOL)insetsLayoutMarginsFromSafeArea
@@ -671,13 +692,13 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setSemanticContentAttribute:(UISemanticContentAttribute)attribute API_AVAILABLE(ios(9.0), tvos(9.0)) {
   semanticContentAttribute = attribute;
-  _stateToApplyFlags.setSemanticContentAttribute = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetSemanticContentAttribute);
 }
 
 - (void)setActions:(NSDictionary<NSString *,id<CAAction>> *)actionsArg
 {
   actions = [actionsArg copy];
-  _stateToApplyFlags.setActions = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetActions);
 }
 
 - (BOOL)isAccessibilityElement
@@ -688,12 +709,12 @@ static CGColorRef blackColorRef = NULL;
 - (void)setIsAccessibilityElement:(BOOL)newIsAccessibilityElement
 {
   _flags.isAccessibilityElement = newIsAccessibilityElement;
-  _stateToApplyFlags.setIsAccessibilityElement = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetIsAccessibilityElement);
 }
 
 - (NSString *)accessibilityLabel
 {
-  if (_stateToApplyFlags.setAccessibilityAttributedLabel) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityAttributedLabel)) {
     return accessibilityAttributedLabel.string;
   }
   return accessibilityLabel;
@@ -702,13 +723,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityLabel:(NSString *)newAccessibilityLabel
 {
   ASCompareAssignCopy(accessibilityLabel, newAccessibilityLabel);
-  _stateToApplyFlags.setAccessibilityLabel = YES;
-  _stateToApplyFlags.setAccessibilityAttributedLabel = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityLabel);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityAttributedLabel);
 }
 
 - (NSAttributedString *)accessibilityAttributedLabel
 {
-  if (_stateToApplyFlags.setAccessibilityLabel) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityLabel)) {
     return [[NSAttributedString alloc] initWithString:accessibilityLabel];
   }
   return accessibilityAttributedLabel;
@@ -717,13 +738,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityAttributedLabel:(NSAttributedString *)newAccessibilityAttributedLabel
 {
   ASCompareAssignCopy(accessibilityAttributedLabel, newAccessibilityAttributedLabel);
-  _stateToApplyFlags.setAccessibilityAttributedLabel = YES;
-  _stateToApplyFlags.setAccessibilityLabel = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityAttributedLabel);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityLabel);
 }
 
 - (NSString *)accessibilityHint
 {
-  if (_stateToApplyFlags.setAccessibilityAttributedHint) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityAttributedHint)) {
     return accessibilityAttributedHint.string;
   }
   return accessibilityHint;
@@ -732,13 +753,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityHint:(NSString *)newAccessibilityHint
 {
   ASCompareAssignCopy(accessibilityHint, newAccessibilityHint);
-  _stateToApplyFlags.setAccessibilityHint = YES;
-  _stateToApplyFlags.setAccessibilityAttributedHint = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityHint);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityAttributedHint);
 }
 
 - (NSAttributedString *)accessibilityAttributedHint
 {
-  if (_stateToApplyFlags.setAccessibilityHint) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityHint)) {
     return [[NSAttributedString alloc] initWithString:accessibilityHint];
   }
   return accessibilityAttributedHint;
@@ -747,13 +768,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityAttributedHint:(NSAttributedString *)newAccessibilityAttributedHint
 {
   ASCompareAssignCopy(accessibilityAttributedHint, newAccessibilityAttributedHint);
-  _stateToApplyFlags.setAccessibilityAttributedHint = YES;
-  _stateToApplyFlags.setAccessibilityHint = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityAttributedHint);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityHint);
 }
 
 - (NSString *)accessibilityValue
 {
-  if (_stateToApplyFlags.setAccessibilityAttributedValue) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityAttributedValue)) {
     return accessibilityAttributedValue.string;
   }
   return accessibilityValue;
@@ -762,13 +783,13 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityValue:(NSString *)newAccessibilityValue
 {
   ASCompareAssignCopy(accessibilityValue, newAccessibilityValue);
-  _stateToApplyFlags.setAccessibilityValue = YES;
-  _stateToApplyFlags.setAccessibilityAttributedValue = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityValue);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityAttributedValue);
 }
 
 - (NSAttributedString *)accessibilityAttributedValue
 {
-  if (_stateToApplyFlags.setAccessibilityValue) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityValue)) {
     return [[NSAttributedString alloc] initWithString:accessibilityValue];
   }
   return accessibilityAttributedValue;
@@ -777,8 +798,8 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityAttributedValue:(NSAttributedString *)newAccessibilityAttributedValue
 {
   ASCompareAssignCopy(accessibilityAttributedValue, newAccessibilityAttributedValue);
-  _stateToApplyFlags.setAccessibilityAttributedValue = YES;
-  _stateToApplyFlags.setAccessibilityValue = NO;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityAttributedValue);
+  _stateToApplyFlags &= ~ASPendingStateMask(ASPendingStateSetAccessibilityValue);
 }
 
 - (UIAccessibilityTraits)accessibilityTraits
@@ -789,7 +810,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityTraits:(UIAccessibilityTraits)newAccessibilityTraits
 {
   accessibilityTraits = newAccessibilityTraits;
-  _stateToApplyFlags.setAccessibilityTraits = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityTraits);
 }
 
 - (CGRect)accessibilityFrame
@@ -800,7 +821,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityFrame:(CGRect)newAccessibilityFrame
 {
   accessibilityFrame = newAccessibilityFrame;
-  _stateToApplyFlags.setAccessibilityFrame = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityFrame);
 }
 
 - (NSString *)accessibilityLanguage
@@ -810,7 +831,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityLanguage:(NSString *)newAccessibilityLanguage
 {
-  _stateToApplyFlags.setAccessibilityLanguage = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityLanguage);
   accessibilityLanguage = newAccessibilityLanguage;
 }
 
@@ -822,7 +843,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityElementsHidden:(BOOL)newAccessibilityElementsHidden
 {
   _flags.accessibilityElementsHidden = newAccessibilityElementsHidden;
-  _stateToApplyFlags.setAccessibilityElementsHidden = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityElementsHidden);
 }
 
 - (BOOL)accessibilityViewIsModal
@@ -833,7 +854,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setAccessibilityViewIsModal:(BOOL)newAccessibilityViewIsModal
 {
   _flags.accessibilityViewIsModal = newAccessibilityViewIsModal;
-  _stateToApplyFlags.setAccessibilityViewIsModal = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityViewIsModal);
 }
 
 - (BOOL)shouldGroupAccessibilityChildren
@@ -844,7 +865,7 @@ static CGColorRef blackColorRef = NULL;
 - (void)setShouldGroupAccessibilityChildren:(BOOL)newShouldGroupAccessibilityChildren
 {
   _flags.shouldGroupAccessibilityChildren = newShouldGroupAccessibilityChildren;
-  _stateToApplyFlags.setShouldGroupAccessibilityChildren = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetShouldGroupAccessibilityChildren);
 }
 
 - (NSString *)accessibilityIdentifier
@@ -854,7 +875,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityIdentifier:(NSString *)newAccessibilityIdentifier
 {
-  _stateToApplyFlags.setAccessibilityIdentifier = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityIdentifier);
   if (accessibilityIdentifier != newAccessibilityIdentifier) {
     accessibilityIdentifier = [newAccessibilityIdentifier copy];
   }
@@ -867,7 +888,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityNavigationStyle:(UIAccessibilityNavigationStyle)newAccessibilityNavigationStyle
 {
-  _stateToApplyFlags.setAccessibilityNavigationStyle = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityNavigationStyle);
   accessibilityNavigationStyle = newAccessibilityNavigationStyle;
 }
 
@@ -878,7 +899,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityCustomActions:(NSArray *)newAccessibilityCustomActions
 {
-  _stateToApplyFlags.setAccessibilityCustomActions = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityCustomActions);
   if (accessibilityCustomActions != newAccessibilityCustomActions) {
     accessibilityCustomActions = [newAccessibilityCustomActions copy];
   }
@@ -893,7 +914,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityHeaderElements:(NSArray *)newAccessibilityHeaderElements
 {
-  _stateToApplyFlags.setAccessibilityHeaderElements = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityHeaderElements);
   if (accessibilityHeaderElements != newAccessibilityHeaderElements) {
     accessibilityHeaderElements = [newAccessibilityHeaderElements copy];
   }
@@ -902,7 +923,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (CGPoint)accessibilityActivationPoint
 {
-  if (_stateToApplyFlags.setAccessibilityActivationPoint) {
+  if (_stateToApplyFlags & ASPendingStateMask(ASPendingStateSetAccessibilityActivationPoint)) {
     return accessibilityActivationPoint;
   }
   
@@ -912,7 +933,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityActivationPoint:(CGPoint)newAccessibilityActivationPoint
 {
-  _stateToApplyFlags.setAccessibilityActivationPoint = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityActivationPoint);
   accessibilityActivationPoint = newAccessibilityActivationPoint;
 }
 
@@ -923,7 +944,7 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)setAccessibilityPath:(UIBezierPath *)newAccessibilityPath
 {
-  _stateToApplyFlags.setAccessibilityPath = YES;
+  _stateToApplyFlags |= ASPendingStateMask(ASPendingStateSetAccessibilityPath);
   if (accessibilityPath != newAccessibilityPath) {
     accessibilityPath = newAccessibilityPath;
   }
@@ -937,106 +958,111 @@ static CGColorRef blackColorRef = NULL;
     [layer setNeedsDisplay];
   }
 
-  if (flags.setAnchorPoint)
-    layer.anchorPoint = anchorPoint;
-
-  if (flags.setZPosition)
-    layer.zPosition = zPosition;
-
-  if (flags.setTransform)
-    layer.transform = transform;
-
-  if (flags.setSublayerTransform)
-    layer.sublayerTransform = sublayerTransform;
-
-  if (flags.setContents)
-    layer.contents = contents;
-
-  if (flags.setContentsGravity)
-    layer.contentsGravity = contentsGravity;
-
-  if (flags.setContentsRect)
-    layer.contentsRect = contentsRect;
-
-  if (flags.setContentsCenter)
-    layer.contentsCenter = contentsCenter;
-
-  if (flags.setContentsScale)
-    layer.contentsScale = contentsScale;
-
-  if (flags.setRasterizationScale)
-    layer.rasterizationScale = rasterizationScale;
-
-  if (flags.setClipsToBounds)
-    layer.masksToBounds = _flags.clipsToBounds;
-
-  if (flags.setBackgroundColor)
-    layer.backgroundColor = backgroundColor.CGColor;
-
-  if (flags.setOpaque)
-    layer.opaque = _flags.opaque;
-
-  if (flags.setHidden)
-    layer.hidden = _flags.hidden;
-
-  if (flags.setAlpha)
-    layer.opacity = alpha;
-
-  if (flags.setCornerRadius)
-    layer.cornerRadius = cornerRadius;
-
-  if (flags.setMaskedCorners) {
-    layer.maskedCorners = maskedCorners;
+  // Visit only the flags that are set, lowest first. View properties are skipped.
+  for (ASPendingStateFlags remaining = flags & ~(kASPendingStateUnorderedFlags | kASPendingStateLayerMetricsFlags); remaining != 0; remaining &= remaining - 1) {
+    switch ((ASPendingStateFlag)__builtin_ctzll(remaining)) {
+      case ASPendingStateSetAnchorPoint:
+        layer.anchorPoint = anchorPoint;
+        break;
+      case ASPendingStateSetZPosition:
+        layer.zPosition = zPosition;
+        break;
+      case ASPendingStateSetTransform:
+        layer.transform = transform;
+        break;
+      case ASPendingStateSetSublayerTransform:
+        layer.sublayerTransform = sublayerTransform;
+        break;
+      case ASPendingStateSetContents:
+        layer.contents = contents;
+        break;
+      case ASPendingStateSetContentsGravity:
+        layer.contentsGravity = contentsGravity;
+        break;
+      case ASPendingStateSetContentsRect:
+        layer.contentsRect = contentsRect;
+        break;
+      case ASPendingStateSetContentsCenter:
+        layer.contentsCenter = contentsCenter;
+        break;
+      case ASPendingStateSetContentsScale:
+        layer.contentsScale = contentsScale;
+        break;
+      case ASPendingStateSetRasterizationScale:
+        layer.rasterizationScale = rasterizationScale;
+        break;
+      case ASPendingStateSetClipsToBounds:
+        layer.masksToBounds = _flags.clipsToBounds;
+        break;
+      case ASPendingStateSetBackgroundColor:
+        layer.backgroundColor = backgroundColor.CGColor;
+        break;
+      case ASPendingStateSetOpaque:
+        layer.opaque = _flags.opaque;
+        ASDisplayNodeAssert(layer.opaque == _flags.opaque, @"Didn't set opaque as desired");
+        break;
+      case ASPendingStateSetHidden:
+        layer.hidden = _flags.hidden;
+        break;
+      case ASPendingStateSetAlpha:
+        layer.opacity = alpha;
+        break;
+      case ASPendingStateSetCornerRadius:
+        layer.cornerRadius = cornerRadius;
+        break;
+      case ASPendingStateSetMaskedCorners:
+        layer.maskedCorners = maskedCorners;
+        break;
+      case ASPendingStateSetContentMode:
+        layer.contentsGravity = ASDisplayNodeCAContentsGravityFromUIContentMode(contentMode);
+        break;
+      case ASPendingStateSetShadowColor:
+        layer.shadowColor = shadowColor;
+        break;
+      case ASPendingStateSetShadowOpacity:
+        layer.shadowOpacity = shadowOpacity;
+        break;
+      case ASPendingStateSetShadowOffset:
+        layer.shadowOffset = shadowOffset;
+        break;
+      case ASPendingStateSetShadowRadius:
+        layer.shadowRadius = shadowRadius;
+        break;
+      case ASPendingStateSetBorderWidth:
+        layer.borderWidth = borderWidth;
+        break;
+      case ASPendingStateSetBorderColor:
+        layer.borderColor = borderColor;
+        break;
+      case ASPendingStateSetNeedsDisplayOnBoundsChange:
+        layer.needsDisplayOnBoundsChange = _flags.needsDisplayOnBoundsChange;
+        break;
+      case ASPendingStateSetAllowsGroupOpacity:
+        layer.allowsGroupOpacity = _flags.allowsGroupOpacity;
+        break;
+      case ASPendingStateSetAllowsEdgeAntialiasing:
+        layer.allowsEdgeAntialiasing = _flags.allowsEdgeAntialiasing;
+        break;
+      case ASPendingStateSetEdgeAntialiasingMask:
+        layer.edgeAntialiasingMask = edgeAntialiasingMask;
+        break;
+      case ASPendingStateSetAsyncTransactionContainer:
+        layer.asyncdisplaykit_asyncTransactionContainer = _flags.asyncTransactionContainer;
+        break;
+      case ASPendingStateSetActions:
+        layer.actions = actions;
+        break;
+      default:
+        break;
+    }
   }
 
-  if (flags.setContentMode)
-    layer.contentsGravity = ASDisplayNodeCAContentsGravityFromUIContentMode(contentMode);
-
-  if (flags.setShadowColor)
-    layer.shadowColor = shadowColor;
-
-  if (flags.setShadowOpacity)
-    layer.shadowOpacity = shadowOpacity;
-
-  if (flags.setShadowOffset)
-    layer.shadowOffset = shadowOffset;
-
-  if (flags.setShadowRadius)
-    layer.shadowRadius = shadowRadius;
-
-  if (flags.setBorderWidth)
-    layer.borderWidth = borderWidth;
-
-  if (flags.setBorderColor)
-    layer.borderColor = borderColor;
-
-  if (flags.setNeedsDisplayOnBoundsChange)
-    layer.needsDisplayOnBoundsChange = _flags.needsDisplayOnBoundsChange;
-  
-  if (flags.setAllowsGroupOpacity)
-    layer.allowsGroupOpacity = _flags.allowsGroupOpacity;
-
-  if (flags.setAllowsEdgeAntialiasing)
-    layer.allowsEdgeAntialiasing = _flags.allowsEdgeAntialiasing;
-
-  if (flags.setEdgeAntialiasingMask)
-    layer.edgeAntialiasingMask = edgeAntialiasingMask;
-
-  if (flags.setAsyncTransactionContainer)
-    layer.asyncdisplaykit_asyncTransactionContainer = _flags.asyncTransactionContainer;
-
-  if (flags.setOpaque)
-    ASDisplayNodeAssert(layer.opaque == _flags.opaque, @"Didn't set opaque as desired");
-
-  if (flags.setActions)
-    layer.actions = actions;
-
   ASPendingStateApplyMetricsToLayer(self, layer);
   
-  if (flags.needsLayout)
+  if (__hasFlag(flags, ASPendingStateNeedsLayout))
     [layer setNeedsLayout];
   
-  if (flags.layoutIfNeeded)
+  if (__hasFlag(flags, ASPendingStateLayoutIfNeeded))
     [layer layoutIfNeeded];
 }
 
@@ -1057,199 +1083,199 @@ static CGColorRef blackColorRef = NULL;
     [view setNeedsDisplay];
   }
 
-  if (flags.setAnchorPoint)
-    layer.anchorPoint = anchorPoint;
-
-  if (flags.setPosition)
-    layer.position = position;
-
-  if (flags.setZPosition)
-    layer.zPosition = zPosition;
-
-  if (flags.setBounds)
-    view.bounds = bounds;
-
-  if (flags.setTransform)
-    layer.transform = transform;
-
-  if (flags.setSublayerTransform)
-    layer.sublayerTransform = sublayerTransform;
-
-  if (flags.setContents)
-    layer.contents = contents;
-
-  if (flags.setContentsGravity)
-    layer.contentsGravity = contentsGravity;
-
-  if (flags.setContentsRect)
-    layer.contentsRect = contentsRect;
-
-  if (flags.setContentsCenter)
-    layer.contentsCenter = contentsCenter;
-
-  if (flags.setContentsScale)
-    layer.contentsScale = contentsScale;
-
-  if (flags.setRasterizationScale)
-    layer.rasterizationScale = rasterizationScale;
-
-  if (flags.setActions)
-    layer.actions = actions;
-
-  if (flags.setClipsToBounds)
-    view.clipsToBounds = _flags.clipsToBounds;
-
-  if (flags.setBackgroundColor) {
-    view.backgroundColor = backgroundColor;
-    layer.backgroundColor = backgroundColor.CGColor;
-  }
-
-  if (flags.setTintColor)
-    view.tintColor = tintColor;
-
-  if (flags.setOpaque) {
-    view.opaque = _flags.opaque;
-    layer.opaque = _flags.opaque;
-  }
-
-  if (flags.setHidden)
-    view.hidden = _flags.hidden;
-
-  if (flags.setAlpha)
-    view.alpha = alpha;
-
-  if (flags.setCornerRadius)
-    layer.cornerRadius = cornerRadius;
-
-  if (flags.setContentMode)
-    view.contentMode = contentMode;
-
-  if (flags.setUserInteractionEnabled)
-    view.userInteractionEnabled = _flags.userInteractionEnabled;
-
-  #if TARGET_OS_IOS
-  if (flags.setExclusiveTouch)
-    view.exclusiveTouch = _flags.exclusiveTouch;
-  #endif
-    
-  if (flags.setShadowColor)
-    layer.shadowColor = shadowColor;
-
-  if (flags.setShadowOpacity)
-    layer.shadowOpacity = shadowOpacity;
-
-  if (flags.setShadowOffset)
-    layer.shadowOffset = shadowOffset;
-
-  if (flags.setShadowRadius)
-    layer.shadowRadius = shadowRadius;
-
-  if (flags.setBorderWidth)
-    layer.borderWidth = borderWidth;
-
-  if (flags.setBorderColor)
-    layer.borderColor = borderColor;
-
-  if (flags.setAutoresizingMask)
-    view.autoresizingMask = autoresizingMask;
-
-  if (flags.setAutoresizesSubviews)
-    view.autoresizesSubviews = _flags.autoresizesSubviews;
-
-  if (flags.setNeedsDisplayOnBoundsChange)
-    layer.needsDisplayOnBoundsChange = _flags.needsDisplayOnBoundsChange;
-  
-  if (flags.setAllowsGroupOpacity)
-    layer.allowsGroupOpacity = _flags.allowsGroupOpacity;
-
-  if (flags.setAllowsEdgeAntialiasing)
-    layer.allowsEdgeAntialiasing = _flags.allowsEdgeAntialiasing;
-
-  if (flags.setEdgeAntialiasingMask)
-    layer.edgeAntialiasingMask = edgeAntialiasingMask;
-
-  if (flags.setAsyncTransactionContainer)
-    view.asyncdisplaykit_asyncTransactionContainer = _flags.asyncTransactionContainer;
-
-  if (flags.setOpaque)
-    ASDisplayNodeAssert(layer.opaque == _flags.opaque, @"Didn't set opaque as desired");
-
-  if (flags.setLayoutMargins)
-    view.layoutMargins = layoutMargins;
-
-  if (flags.setPreservesSuperviewLayoutMargins)
-    view.preservesSuperviewLayoutMargins = _flags.preservesSuperviewLayoutMargins;
-
-  if (flags.setInsetsLayoutMarginsFromSafeArea) {
-    view.insetsLayoutMarginsFromSafeArea = _flags.insetsLayoutMarginsFromSafeArea;
-  }
-
-  if (flags.setSemanticContentAttribute) {
-    view.semanticContentAttribute = semanticContentAttribute;
-  }
-
-  if (flags.setIsAccessibilityElement)
-    view.isAccessibilityElement = _flags.isAccessibilityElement;
-
-  if (flags.setAccessibilityLabel)
-    view.accessibilityLabel = accessibilityLabel;
-
-  if (flags.setAccessibilityHint)
-    view.accessibilityHint = accessibilityHint;
-
-  if (flags.setAccessibilityValue)
-    view.accessibilityValue = accessibilityValue;
-
-  if (flags.setAccessibilityAttributedLabel) {
-    view.accessibilityAttributedLabel = accessibilityAttributedLabel;
-  }
-  if (flags.setAccessibilityAttributedHint) {
-    view.accessibilityAttributedHint = accessibilityAttributedHint;
-  }
-  if (flags.setAccessibilityAttributedValue) {
-    view.accessibilityAttributedValue = accessibilityAttributedValue;
-  }
-
-  if (flags.setAccessibilityTraits)
-    view.accessibilityTraits = accessibilityTraits;
-
-  if (flags.setAccessibilityFrame)
-    view.accessibilityFrame = accessibilityFrame;
-
-  if (flags.setAccessibilityLanguage)
-    view.accessibilityLanguage = accessibilityLanguage;
-
-  if (flags.setAccessibilityElementsHidden)
-    view.accessibilityElementsHidden = _flags.accessibilityElementsHidden;
-
-  if (flags.setAccessibilityViewIsModal)
-    view.accessibilityViewIsModal = _flags.accessibilityViewIsModal;
-
-  if (flags.setShouldGroupAccessibilityChildren)
-    view.shouldGroupAccessibilityChildren = _flags.shouldGroupAccessibilityChildren;
-
-  if (flags.setAccessibilityIdentifier)
-    view.accessibilityIdentifier = accessibilityIdentifier;
-  
-  if (flags.setAccessibilityNavigationStyle)
-    view.accessibilityNavigationStyle = accessibilityNavigationStyle;
-
-  if (flags.setAccessibilityCustomActions) {
-    view.accessibilityCustomActions = accessibilityCustomActions;
-  }
-
+  // Visit only the flags that are set, lowest first.
+  for (ASPendingStateFlags remaining = flags & ~kASPendingStateUnorderedFlags; remaining != 0; remaining &= remaining - 1) {
+    switch ((ASPendingStateFlag)__builtin_ctzll(remaining)) {
+      case ASPendingStateSetAnchorPoint:
+        layer.anchorPoint = anchorPoint;
+        break;
+      case ASPendingStateSetPosition:
+        layer.position = position;
+        break;
+      case ASPendingStateSetZPosition:
+        layer.zPosition = zPosition;
+        break;
+      case ASPendingStateSetBounds:
+        view.bounds = bounds;
+        break;
+      case ASPendingStateSetTransform:
+        layer.transform = transform;
+        break;
+      case ASPendingStateSetSublayerTransform:
+        layer.sublayerTransform = sublayerTransform;
+        break;
+      case ASPendingStateSetContents:
+        layer.contents = contents;
+        break;
+      case ASPendingStateSetContentsGravity:
+        layer.contentsGravity = contentsGravity;
+        break;
+      case ASPendingStateSetContentsRect:
+        layer.contentsRect = contentsRect;
+        break;
+      case ASPendingStateSetContentsCenter:
+        layer.contentsCenter = contentsCenter;
+        break;
+      case ASPendingStateSetContentsScale:
+        layer.contentsScale = contentsScale;
+        break;
+      case ASPendingStateSetRasterizationScale:
+        layer.rasterizationScale = rasterizationScale;
+        break;
+      case ASPendingStateSetClipsToBounds:
+        view.clipsToBounds = _flags.clipsToBounds;
+        break;
+      case ASPendingStateSetBackgroundColor:
+        view.backgroundColor = backgroundColor;
+        layer.backgroundColor = backgroundColor.CGColor;
+        break;
+      case ASPendingStateSetTintColor:
+        view.tintColor = tintColor;
+        break;
+      case ASPendingStateSetOpaque:
+        view.opaque = _flags.opaque;
+        layer.opaque = _flags.opaque;
+        ASDisplayNodeAssert(layer.opaque == _flags.opaque, @"Didn't set opaque as desired");
+        break;
+      case ASPendingStateSetHidden:
+        view.hidden = _flags.hidden;
+        break;
+      case ASPendingStateSetAlpha:
+        view.alpha = alpha;
+        break;
+      case ASPendingStateSetCornerRadius:
+        layer.cornerRadius = cornerRadius;
+        break;
+      case ASPendingStateSetContentMode:
+        view.contentMode = contentMode;
+        break;
+      case ASPendingStateSetUserInteractionEnabled:
+        view.userInteractionEnabled = _flags.userInteractionEnabled;
+        break;
+#if TARGET_OS_IOS
+      case ASPendingStateSetExclusiveTouch:
+        view.exclusiveTouch = _flags.exclusiveTouch;
+        break;
+#endif
+      case ASPendingStateSetShadowColor:
+        layer.shadowColor = shadowColor;
+        break;
+      case ASPendingStateSetShadowOpacity:
+        layer.shadowOpacity = shadowOpacity;
+        break;
+      case ASPendingStateSetShadowOffset:
+        layer.shadowOffset = shadowOffset;
+        break;
+      case ASPendingStateSetShadowRadius:
+        layer.shadowRadius = shadowRadius;
+        break;
+      case ASPendingStateSetBorderWidth:
+        layer.borderWidth = borderWidth;
+        break;
+      case ASPendingStateSetBorderColor:
+        layer.borderColor = borderColor;
+        break;
+      case ASPendingStateSetAutoresizingMask:
+        view.autoresizingMask = autoresizingMask;
+        break;
+      case ASPendingStateSetAutoresizesSubviews:
+        view.autoresizesSubviews = _flags.autoresizesSubviews;
+        break;
+      case ASPendingStateSetNeedsDisplayOnBoundsChange:
+        layer.needsDisplayOnBoundsChange = _flags.needsDisplayOnBoundsChange;
+        break;
+      case ASPendingStateSetAllowsGroupOpacity:
+        layer.allowsGroupOpacity = _flags.allowsGroupOpacity;
+        break;
+      case ASPendingStateSetAllowsEdgeAntialiasing:
+        layer.allowsEdgeAntialiasing = _flags.allowsEdgeAntialiasing;
+        break;
+      case ASPendingStateSetEdgeAntialiasingMask:
+        layer.edgeAntialiasingMask = edgeAntialiasingMask;
+        break;
+      case ASPendingStateSetAsyncTransactionContainer:
+        view.asyncdisplaykit_asyncTransactionContainer = _flags.asyncTransactionContainer;
+        break;
+      case ASPendingStateSetLayoutMargins:
+        view.layoutMargins = layoutMargins;
+        break;
+      case ASPendingStateSetPreservesSuperviewLayoutMargins:
+        view.preservesSuperviewLayoutMargins = _flags.preservesSuperviewLayoutMargins;
+        break;
+      case ASPendingStateSetInsetsLayoutMarginsFromSafeArea:
+        view.insetsLayoutMarginsFromSafeArea = _flags.insetsLayoutMarginsFromSafeArea;
+        break;
+      case ASPendingStateSetSemanticContentAttribute:
+        view.semanticContentAttribute = semanticContentAttribute;
+        break;
+      case ASPendingStateSetIsAccessibilityElement:
+        view.isAccessibilityElement = _flags.isAccessibilityElement;
+        break;
+      case ASPendingStateSetAccessibilityLabel:
+        view.accessibilityLabel = accessibilityLabel;
+        break;
+      case ASPendingStateSetAccessibilityHint:
+        view.accessibilityHint = accessibilityHint;
+        break;
+      case ASPendingStateSetAccessibilityValue:
+        view.accessibilityValue = accessibilityValue;
+        break;
+      case ASPendingStateSetAccessibilityAttributedLabel:
+        view.accessibilityAttributedLabel = accessibilityAttributedLabel;
+        break;
+      case ASPendingStateSetAccessibilityAttributedHint:
+        view.accessibilityAttributedHint = accessibilityAttributedHint;
+        break;
+      case ASPendingStateSetAccessibilityAttributedValue:
+        view.accessibilityAttributedValue = accessibilityAttributedValue;
+        break;
+      case ASPendingStateSetAccessibilityTraits:
+        view.accessibilityTraits = accessibilityTraits;
+        break;
+      case ASPendingStateSetAccessibilityFrame:
+        view.accessibilityFrame = accessibilityFrame;
+        break;
+      case ASPendingStateSetAccessibilityLanguage:
+        view.accessibilityLanguage = accessibilityLanguage;
+        break;
+      case ASPendingStateSetAccessibilityElementsHidden:
+        view.accessibilityElementsHidden = _flags.accessibilityElementsHidden;
+        break;
+      case ASPendingStateSetAccessibilityViewIsModal:
+        view.accessibilityViewIsModal = _flags.accessibilityViewIsModal;
+        break;
+      case ASPendingStateSetShouldGroupAccessibilityChildren:
+        view.shouldGroupAccessibilityChildren = _flags.shouldGroupAccessibilityChildren;
+        break;
+      case ASPendingStateSetAccessibilityIdentifier:
+        view.accessibilityIdentifier = accessibilityIdentifier;
+        break;
+      case ASPendingStateSetAccessibilityNavigationStyle:
+        view.accessibilityNavigationStyle = accessibilityNavigationStyle;
+        break;
+      case ASPendingStateSetAccessibilityCustomActions:
+        view.accessibilityCustomActions = accessibilityCustomActions;
+        break;
 #if TARGET_OS_TV
-  if (flags.setAccessibilityHeaderElements)
-    view.accessibilityHeaderElements = accessibilityHeaderElements;
+      case ASPendingStateSetAccessibilityHeaderElements:
+        view.accessibilityHeaderElements = accessibilityHeaderElements;
+        break;
 #endif
-  
-  if (flags.setAccessibilityActivationPoint)
-    view.accessibilityActivationPoint = accessibilityActivationPoint;
-  
-  if (flags.setAccessibilityPath)
-    view.accessibilityPath = accessibilityPath;
+      case ASPendingStateSetAccessibilityActivationPoint:
+        view.accessibilityActivationPoint = accessibilityActivationPoint;
+        break;
+      case ASPendingStateSetAccessibilityPath:
+        view.accessibilityPath = accessibilityPath;
+        break;
+      case ASPendingStateSetActions:
+        layer.actions = actions;
+        break;
+      default:
+        break;
+    }
+  }
 
-  if (flags.setFrame && specialPropertiesHandling) {
+  if (__hasFlag(flags, ASPendingStateSetFrame) && specialPropertiesHandling) {
     // Frame is only defined when transform is identity because we explicitly diverge from CALayer behavior and define frame without transform
 //#if DEBUG
 //    // Checking if the transform is identity is expensive, so disable when unnecessary. We have assertions on in Release, so DEBUG is the only way I know of.
@@ -1260,10 +1286,10 @@ static CGColorRef blackColorRef = NULL;
     ASPendingStateApplyMetricsToLayer(self, layer);
   }
   
-  if (flags.needsLayout)
+  if (__hasFlag(flags, ASPendingStateNeedsLayout))
     [view setNeedsLayout];
   
-  if (flags.layoutIfNeeded)
+  if (__hasFlag(flags, ASPendingStateLayoutIfNeeded))
     [view layoutIfNeeded];
 }
 
@@ -1381,22 +1407,27 @@ static CGColorRef blackColorRef = NULL;
 
 - (void)clearChanges
 {
-  _stateToApplyFlags = kZeroFlags;
+  _stateToApplyFlags = 0;
 }
 
 - (BOOL)hasSetNeedsLayout
 {
-  return _stateToApplyFlags.needsLayout;
+  return (_stateToApplyFlags & ASPendingStateMask(ASPendingStateNeedsLayout)) != 0;
 }
 
 - (BOOL)hasSetNeedsDisplay
 {
-  return _stateToApplyFlags.needsDisplay;
+  return (_stateToApplyFlags & ASPendingStateMask(ASPendingStateNeedsDisplay)) != 0;
 }
 
 - (BOOL)hasChanges
 {
-  return memcmp(&_stateToApplyFlags, &kZeroFlags, sizeof(ASPendingStateFlags));
+  return _stateToApplyFlags != 0;
+}
+
+- (uint64_t)changesMask
+{
+  return _stateToApplyFlags;
 }
 
 - (void)dealloc
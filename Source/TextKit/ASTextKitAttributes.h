@@ -13,6 +13,8 @@
 
 #import <AsyncDisplayKit/ASAvailability.h>
 
+#import <functional>
+
 #if AS_ENABLE_TEXTNODE
 
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
@@ -131,4 +133,10 @@ struct ASTextKitAttributes {
   size_t hash() const;
 };
 
+namespace std {
+template <> struct hash<ASTextKitAttributes> {
+  size_t operator()(const ASTextKitAttributes &attributes) const { return attributes.hash(); }
+};
+}
+
 #endif
@@ -13,7 +13,10 @@
 #if AS_ENABLE_TEXTNODE
 
 #import <tgmath.h>
+#import <vector>
 
+#import <AsyncDisplayKit/ASEqualityHelpers.h>
+#import <AsyncDisplayKit/ASHashing.h>
 #import <AsyncDisplayKit/ASLayoutManager.h>
 #import <AsyncDisplayKit/ASTextKitContext.h>
 #import <AsyncDisplayKit/ASThread.h>
@@ -24,8 +27,102 @@
 @interface ASTextKitFontSizeAdjuster()
 @property (nonatomic, readonly) NSLayoutManager *sizingLayoutManager;
 @property (nonatomic, readonly) NSTextContainer *sizingTextContainer;
+@property (nonatomic, readonly) NSTextStorage *sizingTextStorage;
 @end
 
+/**
+ * Everything the scale factor depends on, so that text that is measured again, e.g. when a cell is reloaded, doesn't
+ * lay out each of its scale factors again.
+ */
+AS_SUBCLASSING_RESTRICTED
+@interface _ASTextKitFontSizeAdjusterKey : NSObject
+- (instancetype)initWithAttributedString:(NSAttributedString *)attributedString
+                         constrainedSize:(CGSize)constrainedSize
+                              attributes:(const ASTextKitAttributes &)attributes;
+@end
+
+@implementation _ASTextKitFontSizeAdjusterKey
+{
+  NSAttributedString *_attributedString;
+  CGSize _constrainedSize;
+  NSArray *_scaleFactors;
+  NSUInteger _maximumNumberOfLines;
+  NSLineBreakMode _lineBreakMode;
+  NSArray *_exclusionPaths;
+  NSUInteger _hash;
+}
+
+- (instancetype)initWithAttributedString:(NSAttributedString *)attributedString
+                         constrainedSize:(CGSize)constrainedSize
+                              attributes:(const ASTextKitAttributes &)attributes
+{
+  if (self = [super init]) {
+    _attributedString = attributedString;
+    _constrainedSize = constrainedSize;
+    _scaleFactors = attributes.pointSizeScaleFactors;
+    _maximumNumberOfLines = attributes.maximumNumberOfLines;
+    _lineBreakMode = attributes.lineBreakMode;
+    _exclusionPaths = attributes.exclusionPaths;
+
+    _hash = AS::hashFields(attributedString.hash, constrainedSize, _scaleFactors.hash, _maximumNumberOfLines, _lineBreakMode);
+  }
+  return self;
+}
+
+- (NSUInteger)hash
+{
+  return _hash;
+}
+
+- (BOOL)isEqual:(id)object
+{
+  if (self == object) {
+    return YES;
+  }
+  if (![object isKindOfClass:[_ASTextKitFontSizeAdjusterKey class]]) {
+    return NO;
+  }
+  _ASTextKitFontSizeAdjusterKey *other = object;
+  return _hash == other->_hash
+    && CGSizeEqualToSize(_constrainedSize, other->_constrainedSize)
+    && _maximumNumberOfLines == other->_maximumNumberOfLines
+    && _lineBreakMode == other->_lineBreakMode
+    && ASObjectIsEqual(_scaleFactors, other->_scaleFactors)
+    && ASObjectIsEqual(_exclusionPaths, other->_exclusionPaths)
+    && [_attributedString isEqualToAttributedString:other->_attributedString];
+}
+
+@end
+
+/** The scale factor for each key. */
+static NSCache<_ASTextKitFontSizeAdjusterKey *, NSNumber *> *ASTextKitFontSizeAdjusterScaleFactorCache()
+{
+  static NSCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.name = @"org.TextureGroup.Texture.fontSizeAdjusterScaleFactorCache";
+    cache.countLimit = 200;
+  });
+  return cache;
+}
+
+/**
+ * The unscaled width of the longest word of each string, or a negative width if it has no words. The width doesn't
+ * depend on the constrained size, so it is reused when the same text is measured at other sizes.
+ */
+static NSCache<NSAttributedString *, NSNumber *> *ASTextKitFontSizeAdjusterLongestWordWidthCache()
+{
+  static NSCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.name = @"org.TextureGroup.Texture.fontSizeAdjusterLongestWordWidthCache";
+    cache.countLimit = 200;
+  });
+  return cache;
+}
+
 @implementation ASTextKitFontSizeAdjuster
 {
   __weak ASTextKitContext *_context;
@@ -37,6 +134,7 @@
 
 @synthesize sizingLayoutManager = _sizingLayoutManager;
 @synthesize sizingTextContainer = _sizingTextContainer;
+@synthesize sizingTextStorage = _sizingTextStorage;
 
 - (instancetype)initWithContext:(ASTextKitContext *)context
                 constrainedSize:(CGSize)constrainedSize
@@ -90,40 +188,6 @@
   [attrString endEditing];
 }
 
-- (NSUInteger)lineCountForString:(NSAttributedString *)attributedString
-{
-  NSUInteger lineCount = 0;
-  
-  NSLayoutManager *sizingLayoutManager = [self sizingLayoutManager];
-  NSTextContainer *sizingTextContainer = [self sizingTextContainer];
-  
-  NSTextStorage *textStorage = [[NSTextStorage alloc] initWithAttributedString:attributedString];
-  [textStorage addLayoutManager:sizingLayoutManager];
-  
-  [sizingLayoutManager ensureLayoutForTextContainer:sizingTextContainer];
-  for (NSRange lineRange = { 0, 0 }; NSMaxRange(lineRange) < [sizingLayoutManager numberOfGlyphs] && lineCount <= _attributes.maximumNumberOfLines; lineCount++) {
-    [sizingLayoutManager lineFragmentRectForGlyphAtIndex:NSMaxRange(lineRange) effectiveRange:&lineRange];
-  }
-  
-  [textStorage removeLayoutManager:sizingLayoutManager];
-  return lineCount;
-}
-
-- (CGSize)boundingBoxForString:(NSAttributedString *)attributedString
-{
-  NSLayoutManager *sizingLayoutManager = [self sizingLayoutManager];
-  NSTextContainer *sizingTextContainer = [self sizingTextContainer];
-  
-  NSTextStorage *textStorage = [[NSTextStorage alloc] initWithAttributedString:attributedString];
-  [textStorage addLayoutManager:sizingLayoutManager];
-  
-  [sizingLayoutManager ensureLayoutForTextContainer:sizingTextContainer];
-  CGRect textRect = [sizingLayoutManager boundingRectForGlyphRange:NSMakeRange(0, [textStorage length])
-                                                   inTextContainer:sizingTextContainer];
-  [textStorage removeLayoutManager:sizingLayoutManager];
-  return textRect.size;
-}
-
 - (NSLayoutManager *)sizingLayoutManager
 {
   AS::MutexLocker l(__instanceLock__);
@@ -144,11 +208,92 @@
       _sizingTextContainer.exclusionPaths = _attributes.exclusionPaths;
     }
     [_sizingLayoutManager addTextContainer:_sizingTextContainer];
+
+    // The storage stays attached to the layout manager, each probe only replaces its contents.
+    _sizingTextStorage = [[NSTextStorage alloc] init];
+    [_sizingTextStorage addLayoutManager:_sizingLayoutManager];
   }
   
   return _sizingLayoutManager;
 }
 
+- (NSTextStorage *)sizingTextStorage
+{
+  [self sizingLayoutManager];
+  AS::MutexLocker l(__instanceLock__);
+  return _sizingTextStorage;
+}
+
+/**
+ * Lays out the string at the given scale once, for both the line count, counted up to one more than the maximum
+ * number of lines, and the height.
+ */
+- (void)measureString:(NSAttributedString *)attributedString
+      withScaleFactor:(CGFloat)scaleFactor
+            lineCount:(NSUInteger *)lineCount
+               height:(CGFloat *)height
+{
+  NSMutableAttributedString *scaledString = [[NSMutableAttributedString alloc] initWithAttributedString:attributedString];
+  [[self class] adjustFontSizeForAttributeString:scaledString withScaleFactor:scaleFactor];
+
+  NSLayoutManager *sizingLayoutManager = [self sizingLayoutManager];
+  NSTextContainer *sizingTextContainer = [self sizingTextContainer];
+  NSTextStorage *sizingTextStorage = [self sizingTextStorage];
+  [sizingTextStorage setAttributedString:scaledString];
+
+  [sizingLayoutManager ensureLayoutForTextContainer:sizingTextContainer];
+  NSUInteger count = 0;
+  for (NSRange lineRange = { 0, 0 }; NSMaxRange(lineRange) < [sizingLayoutManager numberOfGlyphs] && count <= _attributes.maximumNumberOfLines; count++) {
+    [sizingLayoutManager lineFragmentRectForGlyphAtIndex:NSMaxRange(lineRange) effectiveRange:&lineRange];
+  }
+  *lineCount = count;
+
+  CGRect textRect = [sizingLayoutManager boundingRectForGlyphRange:NSMakeRange(0, [sizingTextStorage length])
+                                                   inTextContainer:sizingTextContainer];
+  *height = textRect.size.height;
+}
+
+/**
+ * The width of the longest run of characters between whitespace, i.e. of the longest of the string's
+ * componentsSeparatedByCharactersInSet:whitespaceCharacterSet, the first one if there are several.
+ */
++ (CGFloat)longestWordWidthForString:(NSAttributedString *)attributedString
+{
+  NSCache<NSAttributedString *, NSNumber *> *cache = ASTextKitFontSizeAdjusterLongestWordWidthCache();
+  if (NSNumber *width = [cache objectForKey:attributedString]) {
+    return width.doubleValue;
+  }
+
+  NSString *str = attributedString.string;
+  const NSUInteger length = str.length;
+  std::vector<unichar> characters(length);
+  [str getCharacters:characters.data() range:NSMakeRange(0, length)];
+
+  // Whitespace characters are all in the BMP, so checking each UTF-16 unit finds the same words without creating them.
+  NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+  NSRange longestWordRange = NSMakeRange(0, 0);
+  NSUInteger wordStart = 0;
+  for (NSUInteger i = 0; i <= length; i++) {
+    if (i < length && ![whitespace characterIsMember:characters[i]]) {
+      continue;
+    }
+    if (i - wordStart > longestWordRange.length) {
+      longestWordRange = NSMakeRange(wordStart, i - wordStart);
+    }
+    wordStart = i + 1;
+  }
+
+  CGFloat width = -1;
+  if (longestWordRange.length > 0) {
+    // Measure the first occurrence of the word, which is what was measured when the words were split.
+    NSRange range = [str rangeOfString:[str substringWithRange:longestWordRange]];
+    NSAttributedString *attrString = [attributedString attributedSubstringFromRange:range];
+    width = [attrString boundingRectWithSize:CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX) options:NSStringDrawingUsesLineFragmentOrigin context:nil].size.width;
+  }
+  [cache setObject:@(width) forKey:attributedString];
+  return width;
+}
+
 - (CGFloat)scaleFactor
 {
   if (_measured) {
@@ -163,78 +308,109 @@
   
   __block CGFloat adjustedScale = 1.0;
   
-  // We add the scale factor of 1 to our scaleFactors array so that in the first iteration of the loop below, we are
-  // actually determining if we need to scale at all. If something doesn't fit, we will continue to iterate our scale factors.
-  NSArray *scaleFactors = [@[@(1)] arrayByAddingObjectsFromArray:_attributes.pointSizeScaleFactors];
-  
   [_context performBlockWithLockedTextKitComponents:^(NSLayoutManager *layoutManager, NSTextStorage *textStorage, NSTextContainer *textContainer) {
-    
-    // Check for two different situations (and correct for both)
-    // 1. The longest word in the string fits without being wrapped
-    // 2. The entire text fits in the given constrained size.
-    
-    NSString *str = textStorage.string;
-    NSArray *words = [str componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
-    NSString *longestWordNeedingResize = @"";
-    for (NSString *word in words) {
-      if ([word length] > [longestWordNeedingResize length]) {
-        longestWordNeedingResize = word;
-      }
-    }
-    
-    // check to see if we may need to shrink for any of these things
-    BOOL longestWordFits = [longestWordNeedingResize length] ? NO : YES;
-    BOOL maxLinesFits = self->_attributes.maximumNumberOfLines > 0 ? NO : YES;
-    BOOL heightFits = isinf(self->_constrainedSize.height) ? YES : NO;
-
-    CGSize longestWordSize = CGSizeZero;
-    if (longestWordFits == NO) {
-        NSRange longestWordRange = [str rangeOfString:longestWordNeedingResize];
-        NSAttributedString *attrString = [textStorage attributedSubstringFromRange:longestWordRange];
-        longestWordSize = [attrString boundingRectWithSize:CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX) options:NSStringDrawingUsesLineFragmentOrigin context:nil].size;
-    }
-    
-    // we may need to shrink for some reason, so let's iterate through our scale factors to see if we actually need to shrink
-    // Note: the first scale factor in the array is 1.0 so will make sure that things don't fit without shrinking
-    for (NSNumber *adjustedScaleObj in scaleFactors) {
-      if (longestWordFits && maxLinesFits && heightFits) {
-        break;
-      }
-      
-      adjustedScale = [adjustedScaleObj floatValue];
-      
-      if (longestWordFits == NO) {
-        // we need to check the longest word to make sure it fits
-        longestWordFits = std::ceil((longestWordSize.width * adjustedScale) <= self->_constrainedSize.width);
-      }
-      
-      // if the longest word fits, go ahead and check max line and height. If it didn't fit continue to the next scale factor
-      if (longestWordFits == YES) {
-        
-        // scale our string by the current scale factor
-        NSMutableAttributedString *scaledString = [[NSMutableAttributedString alloc] initWithAttributedString:textStorage];
-        [[self class] adjustFontSizeForAttributeString:scaledString withScaleFactor:adjustedScale];
-        
-        // check to see if this scaled string fit in the max lines
-        if (maxLinesFits == NO) {
-          maxLinesFits = ([self lineCountForString:scaledString] <= self->_attributes.maximumNumberOfLines);
-        }
-        
-        // if max lines still doesn't fit, continue without checking that we fit in the constrained height
-        if (maxLinesFits == YES && heightFits == NO) {
-          // max lines fit so make sure that we fit in the constrained height.
-          CGSize stringSize = [self boundingBoxForString:scaledString];
-          heightFits = (stringSize.height <= self->_constrainedSize.height);
-        }
-      }
+    NSAttributedString *attributedString = [textStorage copy];
+    _ASTextKitFontSizeAdjusterKey *key = [[_ASTextKitFontSizeAdjusterKey alloc] initWithAttributedString:attributedString
+                                                                                          constrainedSize:self->_constrainedSize
+                                                                                               attributes:self->_attributes];
+    NSCache<_ASTextKitFontSizeAdjusterKey *, NSNumber *> *cache = ASTextKitFontSizeAdjusterScaleFactorCache();
+    if (NSNumber *cachedScale = [cache objectForKey:key]) {
+      adjustedScale = cachedScale.doubleValue;
+      return;
     }
-   
+    adjustedScale = [self scaleFactorForAttributedString:attributedString];
+    [cache setObject:@(adjustedScale) forKey:key];
   }];
   _measured = YES;
   _scaleFactor = adjustedScale;
   return _scaleFactor;
 }
 
+- (CGFloat)scaleFactorForAttributedString:(NSAttributedString *)attributedString
+{
+  // We add the scale factor of 1 so that we first determine if we need to scale at all.
+  std::vector<CGFloat> scaleFactors(1, 1.0);
+  BOOL descending = YES;
+  for (NSNumber *scaleFactor in _attributes.pointSizeScaleFactors) {
+    const CGFloat scale = [scaleFactor floatValue];
+    descending = descending && scale < scaleFactors.back();
+    scaleFactors.push_back(scale);
+  }
+  const NSUInteger count = scaleFactors.size();
+
+  // Check for two different situations (and correct for both)
+  // 1. The longest word in the string fits without being wrapped
+  // 2. The entire text fits in the given constrained size.
+  // We use the first scale factor at which the longest word fits, then the first one from there at which the text
+  // fits in the max lines, then the first one from there at which it fits in the constrained height. If one of them
+  // is never met, the smallest scale factor is used.
+
+  NSUInteger wordFitIndex = 0;
+  const CGFloat longestWordWidth = [[self class] longestWordWidthForString:attributedString];
+  if (longestWordWidth >= 0) {
+    while (wordFitIndex < count && !((longestWordWidth * scaleFactors[wordFitIndex]) <= _constrainedSize.width)) {
+      wordFitIndex++;
+    }
+  }
+
+  // Each scale factor is laid out at most once, for both the line count and the height.
+  struct Measurement {
+    BOOL measured;
+    NSUInteger lineCount;
+    CGFloat height;
+  };
+  std::vector<Measurement> measurements(count, Measurement{NO, 0, 0});
+  const auto measurementAtIndex = [&](NSUInteger i) -> const Measurement & {
+    Measurement &measurement = measurements[i];
+    if (!measurement.measured) {
+      [self measureString:attributedString withScaleFactor:scaleFactors[i] lineCount:&measurement.lineCount height:&measurement.height];
+      measurement.measured = YES;
+    }
+    return measurement;
+  };
+
+  const NSUInteger maximumNumberOfLines = _attributes.maximumNumberOfLines;
+  const CGFloat constrainedHeight = _constrainedSize.height;
+  const auto fitsAtIndex = [&](NSUInteger i, bool checkLines) -> bool {
+    const Measurement &measurement = measurementAtIndex(i);
+    return checkLines ? measurement.lineCount <= maximumNumberOfLines : measurement.height <= constrainedHeight;
+  };
+
+  // The first index from start at which the text fits, or count if there is none. Smaller text never takes more lines
+  // or height, so for descending scale factors whether it fits only changes once and we can bisect. Otherwise, check
+  // each one in order.
+  const auto firstFittingIndex = [&](NSUInteger start, bool checkLines) -> NSUInteger {
+    if (!descending) {
+      while (start < count && !fitsAtIndex(start, checkLines)) {
+        start++;
+      }
+      return start;
+    }
+    NSUInteger end = count;
+    while (start < end) {
+      const NSUInteger middle = start + (end - start) / 2;
+      if (fitsAtIndex(middle, checkLines)) {
+        end = middle;
+      } else {
+        start = middle + 1;
+      }
+    }
+    return start;
+  };
+
+  NSUInteger maxLinesFitIndex = wordFitIndex;
+  if (maximumNumberOfLines > 0 && maxLinesFitIndex < count) {
+    maxLinesFitIndex = firstFittingIndex(maxLinesFitIndex, true);
+  }
+
+  NSUInteger heightFitIndex = maxLinesFitIndex;
+  if (!isinf(constrainedHeight) && heightFitIndex < count) {
+    heightFitIndex = firstFittingIndex(heightFitIndex, false);
+  }
+
+  return scaleFactors[MIN(heightFitIndex, count - 1)];
+}
+
 @end
 
 #endif
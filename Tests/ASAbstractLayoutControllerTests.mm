@@ -0,0 +1,71 @@
+//
+//  ASAbstractLayoutControllerTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTestCase.h"
+
+#import <AsyncDisplayKit/ASAbstractLayoutController.h>
+
+static ASRangeTuningParameters const kParameters = { .leadingBufferScreenfuls = 1.0, .trailingBufferScreenfuls = 0.5 };
+static ASRangeTuningParameters const kMinimumParameters = { .leadingBufferScreenfuls = 0.25, .trailingBufferScreenfuls = 0.25 };
+
+static ASScrollMotion ASScrollMotionMake(CGFloat velocity, CGFloat distanceToTarget)
+{
+  ASScrollMotion motion;
+  motion.velocity = velocity;
+  motion.distanceToTarget = distanceToTarget;
+  motion.viewportLength = 800;
+  motion.bytesPerScreenful = 800 * 400 * 4;
+  return motion;
+}
+
+@interface ASAbstractLayoutControllerTests : ASTestCase
+
+@end
+
+@implementation ASAbstractLayoutControllerTests
+
+- (void)testThatARangeAtRestShrinksToTheMinimumAhead
+{
+  ASRangeTuningParameters adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(0, 0), 0.2, 10);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 0.25, 0.001);
+  XCTAssertEqualWithAccuracy(adapted.trailingBufferScreenfuls, 0.5, 0.001);
+}
+
+- (void)testThatTheLeadingBufferCoversTheLeadTime
+{
+  // 2000 points per second for 0.6 seconds is 1.5 viewports.
+  ASRangeTuningParameters adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(2000, 0), 0.6, 10);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 1.5, 0.001);
+  XCTAssertEqualWithAccuracy(adapted.trailingBufferScreenfuls, 0.5, 0.001);
+}
+
+- (void)testThatTheLeadingBufferCoversTheLandingViewport
+{
+  ASRangeTuningParameters adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(2000, 2400), 0.2, 10);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 3.0, 0.001);
+}
+
+- (void)testThatTheRangeStaysWithinTheMaximumByTrimmingTheTrailingBufferFirst
+{
+  ASRangeTuningParameters adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(2000, 2000), 0.2, 4);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 2.5, 0.001);
+  XCTAssertEqualWithAccuracy(adapted.trailingBufferScreenfuls, 0.5, 0.001);
+
+  adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(2000, 8000), 0.2, 4);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 2.75, 0.001);
+  XCTAssertEqualWithAccuracy(adapted.trailingBufferScreenfuls, 0.25, 0.001);
+}
+
+- (void)testThatTheMinimumWinsOverTheMaximum
+{
+  ASRangeTuningParameters adapted = ASRangeTuningParametersAdaptedToScrollMotion(kParameters, kMinimumParameters, ASScrollMotionMake(2000, 8000), 0.2, 1);
+  XCTAssertEqualWithAccuracy(adapted.leadingBufferScreenfuls, 0.25, 0.001);
+  XCTAssertEqualWithAccuracy(adapted.trailingBufferScreenfuls, 0.25, 0.001);
+}
+
+@end
@@ -30,15 +30,15 @@
 - (void)testContextCreation
 {
   NSURL *url = [self randomURL];
-  ASBasicImageDownloaderContext *c1 = [ASBasicImageDownloaderContext contextForURL:url];
-  ASBasicImageDownloaderContext *c2 = [ASBasicImageDownloaderContext contextForURL:url];
+  ASBasicImageDownloaderContext *c1 = [ASBasicImageDownloader.sharedImageDownloader contextForURL:url];
+  ASBasicImageDownloaderContext *c2 = [ASBasicImageDownloader.sharedImageDownloader contextForURL:url];
   XCTAssert(c1 == c2, @"Context objects are not the same");
 }
 
 - (void)testContextInvalidation
 {
   NSURL *url = [self randomURL];
-  ASBasicImageDownloaderContext *context = [ASBasicImageDownloaderContext contextForURL:url];
+  ASBasicImageDownloaderContext *context = [ASBasicImageDownloader.sharedImageDownloader contextForURL:url];
   [context cancel];
   XCTAssert([context isCancelled], @"Context should be cancelled");
 }
@@ -47,7 +47,7 @@
 - (void)testAsyncContextInvalidation
 {
   NSURL *url = [self randomURL];
-  ASBasicImageDownloaderContext *context = [ASBasicImageDownloaderContext contextForURL:url];
+  ASBasicImageDownloaderContext *context = [ASBasicImageDownloader.sharedImageDownloader contextForURL:url];
   XCTestExpectation *expectation = [self expectationWithDescription:@"Context invalidation"];
 
   dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
@@ -63,9 +63,9 @@
 - (void)testContextSessionCanceled
 {
   NSURL *url = [self randomURL];
-  id task = [OCMockObject mockForClass:[NSURLSessionTask class]];
-  ASBasicImageDownloaderContext *context = [ASBasicImageDownloaderContext contextForURL:url];
-  context.sessionTask = task;
+  id task = [OCMockObject mockForProtocol:@protocol(ASImageDownloadTask)];
+  ASBasicImageDownloaderContext *context = [ASBasicImageDownloader.sharedImageDownloader contextForURL:url];
+  context.downloadTask = task;
 
   [[task expect] cancel];
 
@@ -10,6 +10,89 @@
 #import <XCTest/XCTest.h>
 
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
+#import <AsyncDisplayKit/ASImageDecoding.h>
+
+/**
+ * A download served from memory, which the test finishes.
+ */
+@interface ASTestImageDownloadTask : NSObject <ASImageDownloadTask>
+@property float priority;
+@property (nonatomic, readonly) NSURL *URL;
+@property (nonatomic, readonly) NSData *resumeData;
+@property (nonatomic, readonly) ASImageDownloadTransportCompletion completion;
+@property (nonatomic, readonly, getter=isResumed) BOOL resumed;
+@property (nonatomic, readonly, getter=isCancelled) BOOL cancelled;
+@end
+
+@implementation ASTestImageDownloadTask
+
+- (instancetype)initWithURL:(NSURL *)URL resumeData:(NSData *)resumeData completion:(ASImageDownloadTransportCompletion)completion
+{
+  if (self = [super init]) {
+    _URL = URL;
+    _resumeData = resumeData;
+    _completion = [completion copy];
+  }
+  return self;
+}
+
+- (void)resume
+{
+  _resumed = YES;
+}
+
+- (void)cancel
+{
+  _cancelled = YES;
+}
+
+- (void)cancelByProducingResumeData:(void (^)(NSData * _Nullable))completionHandler
+{
+  _cancelled = YES;
+  completionHandler([self.URL.absoluteString dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+@end
+
+@interface ASTestImageDownloadTransport : NSObject <ASImageDownloadTransport>
+/** Every task created so far, in order. */
+@property (readonly) NSArray<ASTestImageDownloadTask *> *tasks;
+/** The tasks that were resumed and not cancelled. */
+@property (readonly) NSArray<ASTestImageDownloadTask *> *resumedTasks;
+@end
+
+@implementation ASTestImageDownloadTransport
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _tasks = @[];
+  }
+  return self;
+}
+
+- (id<ASImageDownloadTask>)downloadTaskWithURL:(NSURL *)URL resumeData:(NSData *)resumeData progress:(ASImageDownloadTransportProgress)progress completion:(ASImageDownloadTransportCompletion)completion
+{
+  ASTestImageDownloadTask *task = [[ASTestImageDownloadTask alloc] initWithURL:URL resumeData:resumeData completion:completion];
+  @synchronized (self) {
+    _tasks = [_tasks arrayByAddingObject:task];
+  }
+  return task;
+}
+
+- (NSArray<ASTestImageDownloadTask *> *)tasks
+{
+  @synchronized (self) {
+    return _tasks;
+  }
+}
+
+- (NSArray<ASTestImageDownloadTask *> *)resumedTasks
+{
+  return [self.tasks filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"resumed == YES && cancelled == NO"]];
+}
+
+@end
 
 @interface ASBasicImageDownloaderTests : XCTestCase
 
@@ -46,4 +129,183 @@
   [self waitForExpectationsWithTimeout:30 handler:nil];
 }
 
+- (void)testDecodingForATargetKeepsThePointSize
+{
+  NSURL *URL = [[NSBundle bundleForClass:[self class]] URLForResource:@"logo-square"
+                                                        withExtension:@"png"
+                                                         subdirectory:@"TestResources"];
+  NSData *data = [NSData dataWithContentsOfURL:URL];
+  UIImage *fullImage = [UIImage imageWithData:data];
+
+  UIImage *image = ASImageDecodeWithData(data, CGSizeMake(100, 100), UIViewContentModeScaleAspectFill);
+  XCTAssertNotNil(image);
+  XCTAssertGreaterThanOrEqual(CGImageGetWidth(image.CGImage), 100);
+  XCTAssertLessThan(CGImageGetWidth(image.CGImage), CGImageGetWidth(fullImage.CGImage) / 4);
+  XCTAssertEqualWithAccuracy(image.size.width, fullImage.size.width, 1);
+  XCTAssertEqualWithAccuracy(image.size.height, fullImage.size.height, 1);
+
+  // Unscaled content modes and unknown targets decode at full size.
+  XCTAssertEqual(CGImageGetWidth(ASImageDecodeWithData(data, CGSizeMake(100, 100), UIViewContentModeCenter).CGImage), CGImageGetWidth(fullImage.CGImage));
+  XCTAssertEqual(CGImageGetWidth(ASImageDecodeWithData(data, CGSizeZero, UIViewContentModeScaleAspectFill).CGImage), CGImageGetWidth(fullImage.CGImage));
+  XCTAssertNil(ASImageDecodeWithData([NSData data], CGSizeMake(100, 100), UIViewContentModeScaleAspectFill));
+}
+
+- (void)testDownloadingForATargetCompletesWithADownsampledImage
+{
+  XCTestExpectation *expectation = [self expectationWithDescription:@"ASBasicImageDownloader completion handler should be called"];
+
+  ASBasicImageDownloader *downloader = [ASBasicImageDownloader sharedImageDownloader];
+  NSURL *URL = [[NSBundle bundleForClass:[self class]] URLForResource:@"logo-square-black"
+                                                        withExtension:@"png"
+                                                         subdirectory:@"TestResources"];
+
+  [downloader downloadImageWithURL:URL
+                       shouldRetry:YES
+                          priority:ASImageDownloaderPriorityVisible
+                   targetPixelSize:CGSizeMake(64, 64)
+                       contentMode:UIViewContentModeScaleAspectFit
+                     callbackQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+                  downloadProgress:nil
+                        completion:^(id<ASImageContainerProtocol>  _Nullable image, NSError * _Nullable error, id  _Nullable downloadIdentifier, id _Nullable userInfo) {
+                          XCTAssertNil(error);
+                          XCTAssertLessThanOrEqual(CGImageGetWidth(image.asdk_image.CGImage), 80);
+                          [expectation fulfill];
+                        }];
+
+  [self waitForExpectationsWithTimeout:30 handler:nil];
+}
+
+- (void)testDownloadingForAnUnscaledContentModeCompletesWithTheFullImage
+{
+  XCTestExpectation *expectation = [self expectationWithDescription:@"ASBasicImageDownloader completion handler should be called"];
+
+  ASBasicImageDownloader *downloader = [ASBasicImageDownloader sharedImageDownloader];
+  NSURL *URL = [[NSBundle bundleForClass:[self class]] URLForResource:@"logo-square"
+                                                        withExtension:@"png"
+                                                         subdirectory:@"TestResources"];
+  UIImage *fullImage = [UIImage imageWithData:[NSData dataWithContentsOfURL:URL]];
+
+  [downloader downloadImageWithURL:URL
+                       shouldRetry:YES
+                          priority:ASImageDownloaderPriorityVisible
+                   targetPixelSize:CGSizeMake(64, 64)
+                       contentMode:UIViewContentModeCenter
+                     callbackQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+                  downloadProgress:nil
+                        completion:^(id<ASImageContainerProtocol>  _Nullable image, NSError * _Nullable error, id  _Nullable downloadIdentifier, id _Nullable userInfo) {
+                          XCTAssertNil(error);
+                          XCTAssertEqual(CGImageGetWidth(image.asdk_image.CGImage), CGImageGetWidth(fullImage.CGImage));
+                          [expectation fulfill];
+                        }];
+
+  [self waitForExpectationsWithTimeout:30 handler:nil];
+}
+
+#pragma mark Scheduling
+
+- (NSURL *)URLWithIndex:(NSUInteger)index
+{
+  return [NSURL URLWithString:[NSString stringWithFormat:@"https://example.com/%lu.png", (unsigned long)index]];
+}
+
+/** The downloader talks to its transport on a queue of its own, this waits until it did what the test expects. */
+- (void)waitUntil:(BOOL (^)(void))condition
+{
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (!condition() && deadline.timeIntervalSinceNow > 0) {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  }
+  XCTAssertTrue(condition());
+}
+
+- (id)downloadURL:(NSURL *)URL priority:(ASImageDownloaderPriority)priority downloader:(ASBasicImageDownloader *)downloader completion:(ASImageDownloaderCompletion)completion
+{
+  return [downloader downloadImageWithURL:URL
+                              shouldRetry:NO
+                                 priority:priority
+                            callbackQueue:dispatch_get_main_queue()
+                         downloadProgress:nil
+                               completion:completion];
+}
+
+- (void)testRequestsForTheSameURLShareADownload
+{
+  ASTestImageDownloadTransport *transport = [[ASTestImageDownloadTransport alloc] init];
+  ASBasicImageDownloader *downloader = [[ASBasicImageDownloader alloc] initWithTransport:transport maximumConcurrentDownloads:2];
+  XCTestExpectation *cancelledExpectation = [self expectationWithDescription:@"Cancelled request must not complete"];
+  cancelledExpectation.inverted = YES;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Remaining request completes"];
+
+  NSURL *URL = [self URLWithIndex:0];
+  id cancelledIdentifier = [self downloadURL:URL priority:ASImageDownloaderPriorityVisible downloader:downloader completion:^(id<ASImageContainerProtocol> image, NSError *error, id downloadIdentifier, id userInfo) {
+    [cancelledExpectation fulfill];
+  }];
+  [self downloadURL:URL priority:ASImageDownloaderPriorityVisible downloader:downloader completion:^(id<ASImageContainerProtocol> image, NSError *error, id downloadIdentifier, id userInfo) {
+    [expectation fulfill];
+  }];
+  // Cancelling one request keeps the download of the other.
+  [downloader cancelImageDownloadForIdentifier:cancelledIdentifier];
+
+  [self waitUntil:^BOOL{
+    return transport.resumedTasks.count == 1;
+  }];
+  XCTAssertEqual(transport.tasks.count, 1);
+  transport.resumedTasks.firstObject.completion([NSData data], nil);
+
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testVisibleRequestsSuspendPreloadDownloads
+{
+  ASTestImageDownloadTransport *transport = [[ASTestImageDownloadTransport alloc] init];
+  ASBasicImageDownloader *downloader = [[ASBasicImageDownloader alloc] initWithTransport:transport maximumConcurrentDownloads:2];
+
+  for (NSUInteger i = 0; i < 4; i++) {
+    [self downloadURL:[self URLWithIndex:i] priority:ASImageDownloaderPriorityPreload downloader:downloader completion:nil];
+  }
+  [self waitUntil:^BOOL{
+    return transport.resumedTasks.count == 2;
+  }];
+  XCTAssertEqual(transport.tasks.count, 2);
+
+  // The latest preload download makes room, and continues from its partial data when a slot frees up.
+  NSURL *visibleURL = [self URLWithIndex:4];
+  [self downloadURL:visibleURL priority:ASImageDownloaderPriorityVisible downloader:downloader completion:nil];
+  [self waitUntil:^BOOL{
+    return [transport.resumedTasks.lastObject.URL isEqual:visibleURL];
+  }];
+  XCTAssertTrue(transport.tasks[1].isCancelled);
+  XCTAssertEqual(transport.resumedTasks.count, 2);
+
+  transport.resumedTasks.lastObject.completion([NSData data], nil);
+  NSURL *suspendedURL = [self URLWithIndex:1];
+  [self waitUntil:^BOOL{
+    return [transport.resumedTasks.lastObject.URL isEqual:suspendedURL];
+  }];
+  XCTAssertEqualObjects(transport.resumedTasks.lastObject.resumeData, [suspendedURL.absoluteString dataUsingEncoding:NSUTF8StringEncoding]);
+}
+
+- (void)testCancellingWithResumePossibilityKeepsPartialData
+{
+  ASTestImageDownloadTransport *transport = [[ASTestImageDownloadTransport alloc] init];
+  ASBasicImageDownloader *downloader = [[ASBasicImageDownloader alloc] initWithTransport:transport maximumConcurrentDownloads:2];
+  NSURL *URL = [self URLWithIndex:0];
+
+  id identifier = [self downloadURL:URL priority:ASImageDownloaderPriorityPreload downloader:downloader completion:nil];
+  [self waitUntil:^BOOL{
+    return transport.resumedTasks.count == 1;
+  }];
+  [downloader cancelImageDownloadWithResumePossibilityForIdentifier:identifier];
+  [self waitUntil:^BOOL{
+    return transport.resumedTasks.count == 0;
+  }];
+
+  [self downloadURL:URL priority:ASImageDownloaderPriorityPreload downloader:downloader completion:nil];
+  [self waitUntil:^BOOL{
+    return transport.resumedTasks.count == 1;
+  }];
+  XCTAssertEqual(transport.tasks.count, 2);
+  XCTAssertNotNil(transport.resumedTasks.firstObject.resumeData);
+}
+
 @end
@@ -40,6 +40,41 @@
 
 @end
 
+/// Records the names of the properties that are set on it, in order.
+@interface ASBridgedPropertiesTestLayer : CALayer
+@property (nonatomic, readonly) NSMutableArray<NSString *> *setPropertyNames;
+@end
+
+@implementation ASBridgedPropertiesTestLayer
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _setPropertyNames = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)setActions:(NSDictionary<NSString *,id<CAAction>> *)actions
+{
+  [_setPropertyNames addObject:@"actions"];
+  [super setActions:actions];
+}
+
+- (void)setOpacity:(float)opacity
+{
+  [_setPropertyNames addObject:@"opacity"];
+  [super setOpacity:opacity];
+}
+
+- (void)setBorderWidth:(CGFloat)borderWidth
+{
+  [_setPropertyNames addObject:@"borderWidth"];
+  [super setBorderWidth:borderWidth];
+}
+
+@end
+
 @interface ASBridgedPropertiesTestNode : ASDisplayNode
 @property (nullable, nonatomic, copy) dispatch_block_t onDealloc;
 @end
@@ -241,6 +276,74 @@ static inline void ASDispatchSyncOnOtherThread(dispatch_block_t block) {
   XCTAssertTrue(node.layer.needsDisplay);
 }
 
+- (void)testThatPendingStatesApplyTheChangedLayerPropertiesInOrder
+{
+  ASDisplayNode *node = [ASDisplayNode new];
+  node.layerBacked = YES;
+  [node layer];
+  ASDispatchSyncOnOtherThread(^{
+    node.contentsGravity = kCAGravityTop;
+    node.contentMode = UIViewContentModeCenter;
+    node.shadowOpacity = 0.5;
+    node.cornerRadius = 4;
+    node.frame = CGRectMake(10, 20, 30, 40);
+  });
+  [[ASPendingStateController sharedInstance] flush];
+  // contentMode is applied after contentsGravity, regardless of the order they were set in.
+  XCTAssertEqualObjects(node.layer.contentsGravity, kCAGravityCenter);
+  XCTAssertEqual(node.layer.shadowOpacity, 0.5);
+  XCTAssertEqual(node.layer.cornerRadius, 4);
+  XCTAssertTrue(CGRectEqualToRect(node.layer.frame, CGRectMake(10, 20, 30, 40)));
+  XCTAssertFalse(ASDisplayNodeGetPendingState(node).hasChanges);
+}
+
+- (void)testThatPendingStatesApplyActionsAfterTheOtherLayerProperties
+{
+  _ASPendingState *pendingState = [_ASPendingState new];
+  pendingState.actions = @{ @"opacity" : [NSNull null] };
+  pendingState.alpha = 0.5;
+  pendingState.borderWidth = 2;
+  ASBridgedPropertiesTestLayer *layer = [ASBridgedPropertiesTestLayer layer];
+  [pendingState applyToLayer:layer];
+  // The other properties are not animated with the new actions.
+  XCTAssertEqualObjects(layer.setPropertyNames, (@[ @"opacity", @"borderWidth", @"actions" ]));
+}
+
+- (void)testThatAFlushWithATimeBudgetAppliesVisibleNodesFirst
+{
+  ASPendingStateController *ctrl = [ASPendingStateController sharedInstance];
+  ctrl.timeBudget = DBL_MIN;
+  NSMutableArray<ASDisplayNode *> *hiddenNodes = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 2; i++) {
+    ASDisplayNode *hiddenNode = [ASDisplayNode new];
+    [hiddenNode view];
+    [hiddenNodes addObject:hiddenNode];
+  }
+  ASDisplayNode *visibleNode = [ASDisplayNode new];
+  [visibleNode view];
+  [visibleNode recursivelySetInterfaceState:ASInterfaceStateInHierarchy];
+  ASDispatchSyncOnOtherThread(^{
+    for (ASDisplayNode *hiddenNode in hiddenNodes) {
+      hiddenNode.alpha = 0;
+    }
+    visibleNode.alpha = 0;
+  });
+
+  // The budget is over after the visible node, and the others are left for the next flush.
+  [self waitForMainDispatchQueueToFlush];
+  XCTAssertEqual(visibleNode.alpha, 0);
+  for (ASDisplayNode *hiddenNode in hiddenNodes) {
+    XCTAssertEqual(hiddenNode.alpha, 1);
+  }
+  XCTAssertTrue(ctrl.test_isFlushScheduled);
+
+  ctrl.timeBudget = 0;
+  [ctrl flush];
+  for (ASDisplayNode *hiddenNode in hiddenNodes) {
+    XCTAssertEqual(hiddenNode.alpha, 0);
+  }
+}
+
 /// [XCTExpectation expectationWithPredicate:] should handle this
 /// but under Xcode 7.2.1 its polling interval is 1 second
 /// which makes the tests really slow and I'm impatient.
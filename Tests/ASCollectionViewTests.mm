@@ -689,6 +689,34 @@
   XCTAssertNil(cell.indexPath, @"Expected the cell's indexPath to be nil once the section that contains the node is deleted.");
 }
 
+- (void)testThatPipelinedCellAllocationLaysOutEveryCell
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalPipelinedCellAllocation;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  updateValidationTestPrologue
+  NSInteger sectionCount = del->_itemCounts.size();
+
+  // Insert at the top, so the visible cells are not the first ones in the change set.
+  del->_itemCounts[0] += 5;
+  NSMutableArray<NSIndexPath *> *indexPaths = [NSMutableArray array];
+  for (NSInteger item = 0; item < 5; item++) {
+    [indexPaths addObject:[NSIndexPath indexPathForItem:item inSection:0]];
+  }
+  [cn insertItemsAtIndexPaths:indexPaths];
+  [cn waitUntilAllUpdatesAreProcessed];
+
+  for (NSInteger section = 0; section < sectionCount; section++) {
+    XCTAssertEqual([cn numberOfItemsInSection:section], del->_itemCounts[section]);
+    for (NSInteger item = 0; item < del->_itemCounts[section]; item++) {
+      ASCellNode *node = [cn nodeForItemAtIndexPath:[NSIndexPath indexPathForItem:item inSection:section]];
+      XCTAssertNotNil(node);
+      XCTAssertNotNil(node.calculatedLayout, @"Expected every cell to be laid out once the update is processed.");
+    }
+  }
+}
+
 /**
  * https://github.com/facebook/AsyncDisplayKit/issues/2011
  *
@@ -108,7 +108,7 @@ static ASExperimentalFeatures features[] = {
 {
   // Throw in a bad bit.
   ASExperimentalFeatures allFeatures = [self allFeatures];
-  ASExperimentalFeatures featuresWithBadBit = allFeatures | (1 << 22);
+  ASExperimentalFeatures featuresWithBadBit = allFeatures | (1 << 30);
   NSArray *expectedNames = [ASConfigurationTests names];
   XCTAssertEqualObjects(expectedNames, ASExperimentalFeaturesGetNames(featuresWithBadBit));
 }
@@ -137,4 +137,24 @@ static ASExperimentalFeatures features[] = {
   }
 }
 
+- (void)testTextLayoutCacheByteLimitFromDictionary
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:@{
+    @"version" : @(ASConfigurationSchemaCurrentVersion),
+    @"text_layout_cache_byte_limit" : @(1024 * 1024)
+  }];
+  XCTAssertEqual(config.textLayoutCacheByteLimit, 1024 * 1024);
+  XCTAssertEqual([config copy].textLayoutCacheByteLimit, 1024 * 1024);
+}
+
+- (void)testImageContentsCacheByteLimitFromDictionary
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:@{
+    @"version" : @(ASConfigurationSchemaCurrentVersion),
+    @"image_contents_cache_byte_limit" : @(4 * 1024 * 1024)
+  }];
+  XCTAssertEqual(config.imageContentsCacheByteLimit, 4 * 1024 * 1024);
+  XCTAssertEqual([config copy].imageContentsCacheByteLimit, 4 * 1024 * 1024);
+}
+
 @end
@@ -9,11 +9,132 @@
 
 #import "ASXCTExtensions.h"
 #import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
+#import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <stdatomic.h>
 
 #import "ASLayoutSpecSnapshotTestsHelper.h"
 
+/**
+ * Stacks two fixed size subnodes, and counts how often it had to build its layout spec.
+ */
+@interface ASDisplayNodePersistentLayoutTestNode : ASDisplayNode
+@property (nonatomic) uint64_t contentKey;
+@property (nonatomic) NSUInteger layoutSpecCount;
+@property (nonatomic, readonly) ASDisplayNode *first;
+@property (nonatomic, readonly) ASDisplayNode *second;
+@end
+
+@implementation ASDisplayNodePersistentLayoutTestNode
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _first = [[ASDisplayNode alloc] init];
+    _first.style.preferredSize = CGSizeMake(40, 20);
+    _second = [[ASDisplayNode alloc] init];
+    _second.style.preferredSize = CGSizeMake(30, 10);
+    [self addSubnode:_first];
+    [self addSubnode:_second];
+  }
+  return self;
+}
+
+- (uint64_t)persistentLayoutKey
+{
+  return _contentKey;
+}
+
+- (ASLayoutSpec *)layoutSpecThatFits:(ASSizeRange)constrainedSize
+{
+  _layoutSpecCount += 1;
+  return [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionVertical
+                                                 spacing:5
+                                          justifyContent:ASStackLayoutJustifyContentStart
+                                              alignItems:ASStackLayoutAlignItemsEnd
+                                                children:@[_first, _second]];
+}
+
+@end
+
+/**
+ * A fixed size leaf that counts how often it was measured.
+ */
+@interface ASDisplayNodePersistentLayoutTestLeafNode : ASDisplayNode
+@property (atomic) NSUInteger measurementCount;
+@end
+
+@implementation ASDisplayNodePersistentLayoutTestLeafNode
+
+- (CGSize)calculateSizeThatFits:(CGSize)constrainedSize
+{
+  self.measurementCount += 1;
+  return CGSizeMake(30, 15);
+}
+
+@end
+
+/**
+ * Insets a leaf, and counts how often it had to build its layout spec.
+ */
+@interface ASDisplayNodePersistentLayoutTestInsetNode : ASDisplayNode
+@property (atomic) NSUInteger layoutSpecCount;
+@property (nonatomic, readonly) ASDisplayNodePersistentLayoutTestLeafNode *leaf;
+@end
+
+@implementation ASDisplayNodePersistentLayoutTestInsetNode
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _leaf = [[ASDisplayNodePersistentLayoutTestLeafNode alloc] init];
+    [self addSubnode:_leaf];
+  }
+  return self;
+}
+
+- (ASLayoutSpec *)layoutSpecThatFits:(ASSizeRange)constrainedSize
+{
+  self.layoutSpecCount += 1;
+  return [ASInsetLayoutSpec insetLayoutSpecWithInsets:UIEdgeInsetsMake(4, 8, 4, 8) child:_leaf];
+}
+
+@end
+
+/**
+ * A cell like node two levels above its leaf.
+ */
+@interface ASDisplayNodePersistentLayoutNestedTestNode : ASDisplayNode
+@property (nonatomic) uint64_t contentKey;
+@property (atomic) NSUInteger layoutSpecCount;
+@property (nonatomic, readonly) ASDisplayNodePersistentLayoutTestInsetNode *inset;
+@end
+
+@implementation ASDisplayNodePersistentLayoutNestedTestNode
+
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _inset = [[ASDisplayNodePersistentLayoutTestInsetNode alloc] init];
+    [self addSubnode:_inset];
+  }
+  return self;
+}
+
+- (uint64_t)persistentLayoutKey
+{
+  return _contentKey;
+}
+
+- (ASLayoutSpec *)layoutSpecThatFits:(ASSizeRange)constrainedSize
+{
+  self.layoutSpecCount += 1;
+  return [ASInsetLayoutSpec insetLayoutSpecWithInsets:UIEdgeInsetsMake(10, 10, 10, 10) child:_inset];
+}
+
+@end
+
 @interface ASDisplayNodeLayoutTests : XCTestCase
 @end
 
@@ -172,4 +293,83 @@
   }];
 }
 
+- (void)testThatPersistedLayoutIsReusedWithoutCalculatingIt
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
+  config.experimentalFeatures = ASExperimentalPersistentLayoutCache;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  // The cache outlives test runs, so use content that can't have been laid out before.
+  const uint64_t contentKey = ((uint64_t)arc4random() << 32) | arc4random() | 1;
+  const ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(100, 0), CGSizeMake(100, INFINITY));
+
+  ASDisplayNodePersistentLayoutTestNode *node = [[ASDisplayNodePersistentLayoutTestNode alloc] init];
+  node.contentKey = contentKey;
+  ASLayout *layout = [node layoutThatFits:sizeRange];
+  XCTAssertEqual(node.layoutSpecCount, 1);
+
+  // Like a cell created on the next launch.
+  ASDisplayNodePersistentLayoutTestNode *nextNode = [[ASDisplayNodePersistentLayoutTestNode alloc] init];
+  nextNode.contentKey = contentKey;
+  ASLayout *persistedLayout = [nextNode layoutThatFits:sizeRange];
+  XCTAssertEqual(nextNode.layoutSpecCount, 0);
+  ASXCTAssertEqualSizes(persistedLayout.size, layout.size);
+  XCTAssertEqual(persistedLayout.sublayouts.count, 2);
+  XCTAssertEqual(persistedLayout.sublayouts[0].layoutElement, nextNode.first);
+  XCTAssertEqual(persistedLayout.sublayouts[1].layoutElement, nextNode.second);
+  ASXCTAssertEqualRects(persistedLayout.sublayouts[0].frame, layout.sublayouts[0].frame);
+  ASXCTAssertEqualRects(persistedLayout.sublayouts[1].frame, CGRectMake(70, 25, 30, 10));
+
+  // Other content or another size range are calculated.
+  ASDisplayNodePersistentLayoutTestNode *otherNode = [[ASDisplayNodePersistentLayoutTestNode alloc] init];
+  otherNode.contentKey = contentKey + 2;
+  [otherNode layoutThatFits:sizeRange];
+  XCTAssertEqual(otherNode.layoutSpecCount, 1);
+  [nextNode layoutThatFits:ASSizeRangeMake(CGSizeMake(200, 0), CGSizeMake(200, INFINITY))];
+  XCTAssertEqual(nextNode.layoutSpecCount, 1);
+
+  // Subnodes that don't match the persisted layout anymore are calculated.
+  ASDisplayNodePersistentLayoutTestNode *changedNode = [[ASDisplayNodePersistentLayoutTestNode alloc] init];
+  changedNode.contentKey = contentKey;
+  [changedNode.second removeFromSupernode];
+  [changedNode layoutThatFits:sizeRange];
+  XCTAssertEqual(changedNode.layoutSpecCount, 1);
+
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+}
+
+- (void)testThatPersistedLayoutOfNestedNodesIsAppliedWithoutMeasuringThem
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
+  config.experimentalFeatures = ASExperimentalPersistentLayoutCache;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  const uint64_t contentKey = ((uint64_t)arc4random() << 32) | arc4random() | 1;
+  const ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(100, 0), CGSizeMake(100, INFINITY));
+
+  ASDisplayNodePersistentLayoutNestedTestNode *node = [[ASDisplayNodePersistentLayoutNestedTestNode alloc] init];
+  node.contentKey = contentKey;
+  ASLayout *layout = [node layoutThatFits:sizeRange];
+  XCTAssertEqual(node.inset.leaf.measurementCount, 1);
+
+  ASDisplayNodePersistentLayoutNestedTestNode *nextNode = [[ASDisplayNodePersistentLayoutNestedTestNode alloc] init];
+  nextNode.contentKey = contentKey;
+  ASLayout *persistedLayout = [nextNode layoutThatFits:sizeRange];
+  ASXCTAssertEqualSizes(persistedLayout.size, layout.size);
+
+  // Applying the layout on the main thread finds the layouts of the nodes below, and measures none of them.
+  nextNode.frame = CGRectMake(0, 0, persistedLayout.size.width, persistedLayout.size.height);
+  [nextNode.view layoutIfNeeded];
+  XCTAssertEqual(nextNode.layoutSpecCount, 0);
+  XCTAssertEqual(nextNode.inset.layoutSpecCount, 0);
+  XCTAssertEqual(nextNode.inset.leaf.measurementCount, 0);
+  node.frame = nextNode.frame;
+  [node.view layoutIfNeeded];
+  ASXCTAssertEqualRects(nextNode.inset.frame, node.inset.frame);
+  ASXCTAssertEqualRects(nextNode.inset.leaf.frame, node.inset.leaf.frame);
+  ASXCTAssertEqualRects(nextNode.inset.leaf.frame, CGRectMake(8, 4, 64, 15));
+
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+}
+
 @end
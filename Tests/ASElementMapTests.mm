@@ -0,0 +1,220 @@
+//
+//  ASElementMapTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTestCase.h"
+
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASCollectionElement.h>
+#import <AsyncDisplayKit/ASMutableElementMap.h>
+#import <AsyncDisplayKit/ASSection.h>
+
+static NSString * const kHeaderKind = @"header";
+
+@interface ASElementMapTests : ASTestCase
+
+@end
+
+@implementation ASElementMapTests
+
+- (ASCollectionElement *)elementOfKind:(NSString *)kind
+{
+  id<ASRangeManagingNode> owningNode = nil;
+  return [[ASCollectionElement alloc] initWithNodeModel:nil
+                                              nodeBlock:^{ return [[ASCellNode alloc] init]; }
+                               supplementaryElementKind:kind
+                                        constrainedSize:ASSizeRangeZero
+                                             owningNode:owningNode
+                                        traitCollection:ASPrimitiveTraitCollectionMakeDefault()];
+}
+
+/// A map with a section per count, each with a header.
+- (ASElementMap *)mapWithItemCounts:(NSArray<NSNumber *> *)itemCounts
+{
+  NSMutableArray *sections = [NSMutableArray array];
+  NSMutableArray *items = [NSMutableArray array];
+  NSMutableDictionary *headers = [NSMutableDictionary dictionary];
+  [itemCounts enumerateObjectsUsingBlock:^(NSNumber *count, NSUInteger s, BOOL *stop) {
+    [sections addObject:[[ASSection alloc] initWithSectionID:s context:nil]];
+    NSMutableArray *section = [NSMutableArray array];
+    for (NSInteger i = 0; i < count.integerValue; i++) {
+      [section addObject:[self elementOfKind:nil]];
+    }
+    [items addObject:section];
+    headers[[NSIndexPath indexPathForItem:0 inSection:s]] = [self elementOfKind:kHeaderKind];
+  }];
+  return [[ASElementMap alloc] initWithSections:sections items:items supplementaryElements:@{ kHeaderKind : headers }];
+}
+
+- (void)testThatElementsAreFoundByIndexPathAndViceVersa
+{
+  ASElementMap *map = [self mapWithItemCounts:@[ @2, @0, @3 ]];
+  XCTAssertEqual(map.count, 8);
+  XCTAssertEqual(map.numberOfSections, 3);
+  XCTAssertEqual(map.itemElements.count, 5);
+  XCTAssertEqualObjects(map.supplementaryElementKinds, @[ kHeaderKind ]);
+
+  NSIndexPath *indexPath = [NSIndexPath indexPathForItem:2 inSection:2];
+  ASCollectionElement *element = [map elementForItemAtIndexPath:indexPath];
+  XCTAssertEqualObjects([map indexPathForElement:element], indexPath);
+  XCTAssertEqualObjects(map.itemIndexPaths.lastObject, indexPath);
+
+  NSIndexPath *headerIndexPath = [NSIndexPath indexPathForItem:0 inSection:1];
+  ASCollectionElement *header = [map supplementaryElementOfKind:kHeaderKind atIndexPath:headerIndexPath];
+  XCTAssertNotNil(header);
+  XCTAssertEqualObjects([map indexPathForElement:header], headerIndexPath);
+  XCTAssertNil([map indexPathForElementIfCell:header]);
+  XCTAssertNil([map indexPathForElement:[self elementOfKind:nil]]);
+
+  NSMutableSet *enumerated = [NSMutableSet set];
+  for (ASCollectionElement *e in map) {
+    [enumerated addObject:e];
+  }
+  XCTAssertEqual(enumerated.count, 8);
+}
+
+- (void)testThatMutatingACopyDoesNotChangeTheOriginal
+{
+  ASElementMap *map = [self mapWithItemCounts:@[ @3, @3 ]];
+  ASCollectionElement *last = [map elementForItemAtIndexPath:[NSIndexPath indexPathForItem:2 inSection:1]];
+
+  ASMutableElementMap *mutableMap = [map mutableCopy];
+  [mutableMap removeItemsAtIndexPaths:@[ [NSIndexPath indexPathForItem:0 inSection:1] ]];
+  ASCollectionElement *inserted = [self elementOfKind:nil];
+  [mutableMap insertElement:inserted atIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]];
+  ASElementMap *newMap = [mutableMap copy];
+
+  XCTAssertEqual([map numberOfItemsInSection:0], 3);
+  XCTAssertEqual([map numberOfItemsInSection:1], 3);
+  XCTAssertEqualObjects([map indexPathForElement:last], [NSIndexPath indexPathForItem:2 inSection:1]);
+  XCTAssertNil([map indexPathForElement:inserted]);
+
+  XCTAssertEqual([newMap numberOfItemsInSection:0], 4);
+  XCTAssertEqual([newMap numberOfItemsInSection:1], 2);
+  XCTAssertEqualObjects([newMap indexPathForElement:last], [NSIndexPath indexPathForItem:1 inSection:1]);
+  XCTAssertEqualObjects([newMap indexPathForElement:inserted], [NSIndexPath indexPathForItem:0 inSection:0]);
+  XCTAssertEqualObjects([newMap convertIndexPath:[NSIndexPath indexPathForItem:2 inSection:1] fromMap:map], [NSIndexPath indexPathForItem:1 inSection:1]);
+}
+
+- (void)testThatUnmaterializedItemsArePlaceholders
+{
+  const ASSizeRange estimate = ASSizeRangeMake(CGSizeMake(320, 44));
+  ASMutableElementMap *mutableMap = [[self mapWithItemCounts:@[ @1, @0 ]] mutableCopy];
+  [mutableMap appendUnmaterializedItems:3 toSection:1 placeholderSize:estimate];
+  ASElementMap *map = [mutableMap copy];
+
+  XCTAssertTrue(map.hasPlaceholders);
+  XCTAssertEqual([map numberOfItemsInSection:1], 3);
+  XCTAssertEqual(map.count, 3);
+  XCTAssertEqual(map.itemElements.count, 1);
+  XCTAssertEqual(map.itemIndexPaths.count, 4);
+
+  NSIndexPath *indexPath = [NSIndexPath indexPathForItem:1 inSection:1];
+  ASCollectionElement *placeholder = [map elementForItemAtIndexPath:indexPath];
+  XCTAssertTrue(placeholder.isPlaceholder);
+  XCTAssertTrue(ASSizeRangeEqualToSizeRange(placeholder.constrainedSize, estimate));
+  XCTAssertEqualObjects([map elementForItemAtIndexPath:indexPath], placeholder);
+  XCTAssertEqual([map elementForItemAtIndexPath:indexPath].hash, placeholder.hash);
+  XCTAssertNotEqualObjects([map elementForItemAtIndexPath:[NSIndexPath indexPathForItem:2 inSection:1]], placeholder);
+  XCTAssertEqualObjects([map indexPathForElement:placeholder], indexPath);
+  XCTAssertNil([[mutableMap copy] indexPathForElement:placeholder]);
+  XCTAssertFalse([map elementForItemAtIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]].isPlaceholder);
+
+  NSUInteger enumeratedCount = 0;
+  for (ASCollectionElement *element in map) {
+    XCTAssertFalse(element.isPlaceholder);
+    enumeratedCount++;
+  }
+  XCTAssertEqual(enumeratedCount, 3);
+}
+
+- (void)testThatMaterializingACopyDoesNotChangeTheOriginal
+{
+  const ASSizeRange estimate = ASSizeRangeMake(CGSizeMake(320, 44));
+  ASMutableElementMap *mutableMap = [[self mapWithItemCounts:@[ @0, @0 ]] mutableCopy];
+  [mutableMap appendUnmaterializedItems:3 toSection:0 placeholderSize:estimate];
+  [mutableMap appendUnmaterializedItems:3 toSection:1 placeholderSize:estimate];
+  ASElementMap *map = [mutableMap copy];
+
+  NSIndexPath *indexPath = [NSIndexPath indexPathForItem:1 inSection:0];
+  ASCollectionElement *element = [self elementOfKind:nil];
+  mutableMap = [map mutableCopy];
+  XCTAssertTrue([mutableMap materializeElement:element atIndexPath:indexPath]);
+  XCTAssertFalse([mutableMap materializeElement:[self elementOfKind:nil] atIndexPath:indexPath]);
+  ASElementMap *newMap = [mutableMap copy];
+
+  XCTAssertTrue([map elementForItemAtIndexPath:indexPath].isPlaceholder);
+  XCTAssertEqual(map.itemElements.count, 0);
+  XCTAssertEqual([newMap elementForItemAtIndexPath:indexPath], element);
+  XCTAssertEqualObjects([newMap indexPathForElement:element], indexPath);
+  XCTAssertEqualObjects(newMap.itemElements, @[ element ]);
+
+  // Placeholders have no identity, so only the ones of sections that both maps share convert.
+  NSIndexPath *unchanged = [NSIndexPath indexPathForItem:2 inSection:1];
+  XCTAssertEqualObjects([newMap convertIndexPath:unchanged fromMap:map], unchanged);
+  XCTAssertNil([newMap convertIndexPath:[NSIndexPath indexPathForItem:2 inSection:0] fromMap:map]);
+
+  // Removed placeholders are no longer unmaterialized.
+  mutableMap = [newMap mutableCopy];
+  [mutableMap removeItemsAtIndexPaths:@[ [NSIndexPath indexPathForItem:2 inSection:1], [NSIndexPath indexPathForItem:1 inSection:1],
+                                         [NSIndexPath indexPathForItem:0 inSection:1], [NSIndexPath indexPathForItem:2 inSection:0],
+                                         [NSIndexPath indexPathForItem:0 inSection:0] ]];
+  ASElementMap *materializedMap = [mutableMap copy];
+  XCTAssertFalse(materializedMap.hasPlaceholders);
+  XCTAssertEqualObjects([materializedMap indexPathForElement:element], [NSIndexPath indexPathForItem:0 inSection:0]);
+}
+
+- (void)testThatSupplementaryElementsFollowTheirSections
+{
+  ASElementMap *map = [self mapWithItemCounts:@[ @1, @1, @1 ]];
+  ASCollectionElement *firstHeader = [map supplementaryElementOfKind:kHeaderKind atIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]];
+  ASCollectionElement *lastHeader = [map supplementaryElementOfKind:kHeaderKind atIndexPath:[NSIndexPath indexPathForItem:0 inSection:2]];
+
+  // Delete section 1 and insert a new section in front.
+  NSIndexSet *deleted = [NSIndexSet indexSetWithIndex:1];
+  NSIndexSet *inserted = [NSIndexSet indexSetWithIndex:0];
+  ASMutableElementMap *mutableMap = [map mutableCopy];
+  [mutableMap removeSectionsOfItems:deleted];
+  [mutableMap removeSectionsAtIndexes:deleted];
+  [mutableMap insertEmptySectionsOfItemsAtIndexes:inserted];
+  [mutableMap insertSection:[[ASSection alloc] initWithSectionID:3 context:nil] atIndex:0];
+  [mutableMap migrateSupplementaryElementsWithSectionMapping:[ASIntegerMap mapForUpdateWithOldCount:3 deleted:deleted inserted:inserted]];
+  ASElementMap *newMap = [mutableMap copy];
+
+  XCTAssertEqual(newMap.numberOfSections, 3);
+  XCTAssertEqual([newMap numberOfItemsInSection:0], 0);
+  XCTAssertEqualObjects([newMap indexPathForElement:firstHeader], [NSIndexPath indexPathForItem:0 inSection:1]);
+  XCTAssertEqualObjects([newMap indexPathForElement:lastHeader], [NSIndexPath indexPathForItem:0 inSection:2]);
+  XCTAssertNil([newMap supplementaryElementOfKind:kHeaderKind atIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]]);
+  XCTAssertEqual([newMap convertSection:2 fromMap:map], 2);
+  XCTAssertEqual([newMap convertSection:1 fromMap:map], NSNotFound);
+  XCTAssertEqualObjects([map supplementaryElementOfKind:kHeaderKind atIndexPath:[NSIndexPath indexPathForItem:0 inSection:0]], firstHeader);
+}
+
+- (void)testPerformanceOfUpdatingALargeMap
+{
+  NSMutableArray *itemCounts = [NSMutableArray array];
+  for (NSInteger i = 0; i < 50; i++) {
+    [itemCounts addObject:@1000];
+  }
+  ASElementMap *map = [self mapWithItemCounts:itemCounts];
+  NSIndexPath *indexPath = [NSIndexPath indexPathForItem:999 inSection:49];
+
+  // One update in a 50k item collection: copy, change one section, migrate headers and convert an index path.
+  [self measureBlock:^{
+    ASElementMap *newMap = map;
+    for (NSInteger i = 0; i < 10; i++) {
+      ASMutableElementMap *mutableMap = [newMap mutableCopy];
+      [mutableMap insertElement:[self elementOfKind:nil] atIndexPath:[NSIndexPath indexPathForItem:0 inSection:i]];
+      [mutableMap migrateSupplementaryElementsWithSectionMapping:[ASIntegerMap mapForUpdateWithOldCount:50 deleted:nil inserted:nil]];
+      newMap = [mutableMap copy];
+      XCTAssertNotNil([newMap convertIndexPath:indexPath fromMap:map]);
+    }
+  }];
+}
+
+@end
@@ -0,0 +1,162 @@
+//
+//  ASImageContentsCacheTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/ASImageContentsCache.h>
+
+#import <atomic>
+
+static UIImage *ASImageContentsCacheTestImage()
+{
+  UIGraphicsBeginImageContextWithOptions(CGSizeMake(16, 16), YES, 1);
+  UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  return image;
+}
+
+@interface ASImageContentsCacheTests : XCTestCase
+@end
+
+@implementation ASImageContentsCacheTests
+
+- (void)setUp
+{
+  [super setUp];
+  ASImageContentsCacheTrim();
+  ASImageContentsCacheSetByteLimit(ASImageContentsCacheDefaultByteLimit);
+}
+
+- (void)tearDown
+{
+  ASImageContentsCacheTrim();
+  ASImageContentsCacheSetByteLimit(ASImageContentsCacheDefaultByteLimit);
+  [super tearDown];
+}
+
+- (void)testContentsOutliveTheirEntryWithinTheBudget
+{
+  NSObject *key = [[NSObject alloc] init];
+  __block NSUInteger renderCount = 0;
+  UIImage *(^render)(void) = ^{
+    renderCount++;
+    return ASImageContentsCacheTestImage();
+  };
+
+  __weak UIImage *weakContents;
+  @autoreleasepool {
+    weakContents = ASImageContentsCacheGetEntry(key, render).value;
+  }
+  // No node holds the entry anymore, the strong tier does.
+  XCTAssertNotNil(weakContents);
+
+  ASImageContentsCacheStatistics before = ASImageContentsCacheGetStatistics();
+  XCTAssertEqual(ASImageContentsCacheGetEntry(key, render).value, weakContents);
+  XCTAssertEqual(renderCount, 1);
+  XCTAssertEqual(ASImageContentsCacheGetStatistics().hitCount, before.hitCount + 1);
+}
+
+- (void)testLeastRecentlyUsedContentsAreEvictedOverTheBudget
+{
+  UIImage *image = ASImageContentsCacheTestImage();
+  ASImageContentsCacheSetByteLimit(2 * ASImageContentsCacheEstimatedCost(image));
+  NSArray<NSObject *> *keys = @[ [[NSObject alloc] init], [[NSObject alloc] init], [[NSObject alloc] init] ];
+  __block NSUInteger renderCount = 0;
+  UIImage *(^render)(void) = ^{
+    renderCount++;
+    return ASImageContentsCacheTestImage();
+  };
+
+  @autoreleasepool {
+    (void)ASImageContentsCacheGetEntry(keys[0], render);
+    (void)ASImageContentsCacheGetEntry(keys[1], render);
+    // Using the first key again makes the second one the least recently used.
+    (void)ASImageContentsCacheGetEntry(keys[0], render);
+    (void)ASImageContentsCacheGetEntry(keys[2], render);
+  }
+  XCTAssertEqual(renderCount, 3);
+  XCTAssertEqual(ASImageContentsCacheGetStatistics().totalCost, 2 * ASImageContentsCacheEstimatedCost(image));
+
+  @autoreleasepool {
+    (void)ASImageContentsCacheGetEntry(keys[0], render);
+    (void)ASImageContentsCacheGetEntry(keys[2], render);
+  }
+  XCTAssertEqual(renderCount, 3);
+  @autoreleasepool {
+    (void)ASImageContentsCacheGetEntry(keys[1], render);
+  }
+  XCTAssertEqual(renderCount, 4);
+}
+
+- (void)testTrimKeepsContentsThatAreInUse
+{
+  NSObject *usedKey = [[NSObject alloc] init];
+  NSObject *unusedKey = [[NSObject alloc] init];
+  __block NSUInteger renderCount = 0;
+  UIImage *(^render)(void) = ^{
+    renderCount++;
+    return ASImageContentsCacheTestImage();
+  };
+
+  ASWeakMapEntry<UIImage *> *usedEntry = ASImageContentsCacheGetEntry(usedKey, render);
+  @autoreleasepool {
+    (void)ASImageContentsCacheGetEntry(unusedKey, render);
+  }
+  ASImageContentsCacheTrim();
+  XCTAssertEqual(ASImageContentsCacheGetStatistics().totalCost, 0);
+
+  XCTAssertEqual(ASImageContentsCacheGetEntry(usedKey, render), usedEntry);
+  XCTAssertEqual(renderCount, 2);
+  @autoreleasepool {
+    (void)ASImageContentsCacheGetEntry(unusedKey, render);
+  }
+  XCTAssertEqual(renderCount, 3);
+}
+
+- (void)testConcurrentMissesRenderOnce
+{
+  NSObject *key = [[NSObject alloc] init];
+  std::atomic<NSUInteger> renderCount(0);
+  std::atomic<NSUInteger> *renderCountPointer = &renderCount;
+  NSMutableArray<UIImage *> *contents = [NSMutableArray array];
+  NSLock *contentsLock = [[NSLock alloc] init];
+
+  dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+    UIImage *image = ASImageContentsCacheGetEntry(key, ^{
+      renderCountPointer->fetch_add(1);
+      // Long enough for the other threads to miss while drawing.
+      [NSThread sleepForTimeInterval:0.1];
+      return ASImageContentsCacheTestImage();
+    }).value;
+    [contentsLock lock];
+    [contents addObject:image];
+    [contentsLock unlock];
+  });
+
+  XCTAssertEqual(renderCount.load(), 1);
+  XCTAssertEqual(contents.count, 8);
+  for (UIImage *image in contents) {
+    XCTAssertEqual(image, contents.firstObject);
+  }
+}
+
+- (void)testCancelledRenderIsNotCached
+{
+  NSObject *key = [[NSObject alloc] init];
+  XCTAssertNil(ASImageContentsCacheGetEntry(key, ^UIImage *{
+    return nil;
+  }));
+
+  __block BOOL rendered = NO;
+  XCTAssertNotNil(ASImageContentsCacheGetEntry(key, ^{
+    rendered = YES;
+    return ASImageContentsCacheTestImage();
+  }));
+  XCTAssertTrue(rendered);
+}
+
+@end
@@ -9,6 +9,46 @@
 #import "ASTestCase.h"
 #import "ASIntegerMap.h"
 
+#import <unordered_map>
+#import <vector>
+
+/// The update used by the benchmarks: every 10th item deleted, every 7th inserted.
+static void ASGetBenchmarkUpdate(NSInteger count, NSIndexSet **deleted, NSIndexSet **inserted)
+{
+  NSMutableIndexSet *deletes = [NSMutableIndexSet indexSet];
+  NSMutableIndexSet *inserts = [NSMutableIndexSet indexSet];
+  for (NSInteger i = 0; i < count; i += 10) {
+    [deletes addIndex:i];
+  }
+  for (NSInteger i = 0; i < count; i += 7) {
+    [inserts addIndex:i];
+  }
+  *deleted = deletes;
+  *inserted = inserts;
+}
+
+/// How the map was built before it stored runs, for comparison.
+static std::unordered_map<NSInteger, NSInteger> ASUnorderedMapForUpdate(NSInteger oldCount, NSIndexSet *deletions, NSIndexSet *insertions)
+{
+  NSMutableIndexSet *indexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, oldCount)];
+  [deletions enumerateRangesWithOptions:NSEnumerationReverse usingBlock:^(NSRange range, BOOL * _Nonnull stop) {
+    [indexes shiftIndexesStartingAtIndex:NSMaxRange(range) by:-range.length];
+  }];
+  [insertions enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
+    [indexes shiftIndexesStartingAtIndex:range.location by:range.length];
+  }];
+  __block std::unordered_map<NSInteger, NSInteger> map;
+  __block NSInteger oldIndex = 0;
+  [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL * _Nonnull stop) {
+    for (NSInteger newIndex = range.location; newIndex < NSMaxRange(range); oldIndex++) {
+      if (![deletions containsIndex:oldIndex]) {
+        map[oldIndex] = newIndex++;
+      }
+    }
+  }];
+  return map;
+}
+
 @interface ASIntegerMapTests : ASTestCase
 
 @end
@@ -110,4 +150,128 @@
   XCTAssertEqual([map integerForKey:5], NSNotFound);
 }
 
+#pragma mark - Forms
+
+- (void)testThatUpdateMapsMatchTheUnorderedMapImplementation
+{
+  NSIndexSet *deleted, *inserted;
+  ASGetBenchmarkUpdate(1000, &deleted, &inserted);
+  ASIntegerMap *map = [ASIntegerMap mapForUpdateWithOldCount:1000 deleted:deleted inserted:inserted];
+  const auto expected = ASUnorderedMapForUpdate(1000, deleted, inserted);
+
+  std::vector<NSInteger> keys(1002);
+  for (NSInteger i = 0; i < keys.size(); i++) {
+    keys[i] = i - 1;
+  }
+  std::vector<NSInteger> values = keys;
+  [map mapIntegers:values.data() count:values.size()];
+  ASIntegerMap *inverse = [map inverseMap];
+  for (NSInteger i = 0; i < keys.size(); i++) {
+    const auto it = expected.find(keys[i]);
+    const NSInteger value = (it != expected.end() ? it->second : NSNotFound);
+    XCTAssertEqual([map integerForKey:keys[i]], value);
+    XCTAssertEqual(values[i], value);
+    if (value != NSNotFound) {
+      XCTAssertEqual([inverse integerForKey:value], keys[i]);
+    }
+  }
+}
+
+- (void)testThatSparseKeysAndLargeValuesAreStored
+{
+  ASIntegerMap *map = [[ASIntegerMap alloc] init];
+  [map setInteger:3 forKey:1];
+  [map setInteger:5 forKey:2];
+  ASIntegerMap *denseMap = [map copy];
+  [map setInteger:-1 forKey:1000000];
+  [map setInteger:NSIntegerMax - 1 forKey:-7];
+
+  XCTAssertEqual([map integerForKey:1], 3);
+  XCTAssertEqual([map integerForKey:2], 5);
+  XCTAssertEqual([map integerForKey:1000000], -1);
+  XCTAssertEqual([map integerForKey:-7], NSIntegerMax - 1);
+  XCTAssertEqual([map integerForKey:0], NSNotFound);
+  XCTAssertEqual([denseMap integerForKey:1000000], NSNotFound);
+  XCTAssertNotEqualObjects(map, denseMap);
+
+  NSInteger keys[] = { 2, -7, 0, 1 };
+  [map mapIntegers:keys count:4];
+  XCTAssertEqual(keys[0], 5);
+  XCTAssertEqual(keys[1], NSIntegerMax - 1);
+  XCTAssertEqual(keys[2], NSNotFound);
+  XCTAssertEqual(keys[3], 3);
+
+  // Update maps become regular maps once they are changed.
+  ASIntegerMap *updateMap = [ASIntegerMap mapForUpdateWithOldCount:2 deleted:[NSIndexSet indexSetWithIndex:0] inserted:nil];
+  [updateMap setInteger:7 forKey:0];
+  XCTAssertEqual([updateMap integerForKey:0], 7);
+  XCTAssertEqual([updateMap integerForKey:1], 0);
+}
+
+#pragma mark - Performance
+
+- (void)measureUnorderedMapWithCount:(NSInteger)count
+{
+  NSIndexSet *deleted, *inserted;
+  ASGetBenchmarkUpdate(count, &deleted, &inserted);
+  [self measureBlock:^{
+    const auto map = ASUnorderedMapForUpdate(count, deleted, inserted);
+    NSInteger sum = 0;
+    for (NSInteger i = 0; i < count; i++) {
+      const auto it = map.find(i);
+      sum += (it != map.end() ? it->second : 0);
+    }
+    XCTAssertGreaterThan(sum, 0);
+  }];
+}
+
+- (void)measureIntegerMapWithCount:(NSInteger)count
+{
+  NSIndexSet *deleted, *inserted;
+  ASGetBenchmarkUpdate(count, &deleted, &inserted);
+  [self measureBlock:^{
+    ASIntegerMap *map = [ASIntegerMap mapForUpdateWithOldCount:count deleted:deleted inserted:inserted];
+    std::vector<NSInteger> values(count);
+    for (NSInteger i = 0; i < count; i++) {
+      values[i] = i;
+    }
+    [map mapIntegers:values.data() count:count];
+    NSInteger sum = 0;
+    for (NSInteger value : values) {
+      sum += (value != NSNotFound ? value : 0);
+    }
+    XCTAssertGreaterThan(sum, 0);
+  }];
+}
+
+- (void)testPerformanceOfUnorderedMap1k
+{
+  [self measureUnorderedMapWithCount:1000];
+}
+
+- (void)testPerformanceOfIntegerMap1k
+{
+  [self measureIntegerMapWithCount:1000];
+}
+
+- (void)testPerformanceOfUnorderedMap10k
+{
+  [self measureUnorderedMapWithCount:10000];
+}
+
+- (void)testPerformanceOfIntegerMap10k
+{
+  [self measureIntegerMapWithCount:10000];
+}
+
+- (void)testPerformanceOfUnorderedMap100k
+{
+  [self measureUnorderedMapWithCount:100000];
+}
+
+- (void)testPerformanceOfIntegerMap100k
+{
+  [self measureIntegerMapWithCount:100000];
+}
+
 @end
@@ -0,0 +1,226 @@
+//
+//  ASInterfaceStatePerformanceTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+#import "ASPerformanceTestContext.h"
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
+
+#import "ASTestCase.h"
+
+static NSString *const kTestCaseRecursive = @"Recursive";
+static NSString *const kTestCaseSnapshot = @"Snapshot";
+static NSUInteger const kCellCount = 20;
+static NSUInteger const kCellChildCount = 12;
+static NSUInteger const kCellGrandchildCount = 10;
+
+static ASInterfaceState const kASInterfaceStateOffscreen = ASInterfaceStateMeasureLayout | ASInterfaceStatePreload | ASInterfaceStateDisplay;
+static ASInterfaceState const kASInterfaceStateOnscreen = kASInterfaceStateOffscreen | ASInterfaceStateVisible;
+
+/**
+ * Counts its visibility callbacks, and records whether its subnodes were visible already when it became visible.
+ */
+@interface ASInterfaceStateTestNode : ASDisplayNode
+@property (nonatomic) NSUInteger enterVisibleCount;
+@property (nonatomic) NSUInteger exitVisibleCount;
+@property (nonatomic) BOOL subnodesWereVisible;
+@property (nonatomic, copy) void (^didEnterVisibleBlock)(ASInterfaceStateTestNode *node);
+@end
+
+@implementation ASInterfaceStateTestNode
+
+- (void)didEnterVisibleState
+{
+  [super didEnterVisibleState];
+  _enterVisibleCount++;
+  _subnodesWereVisible = YES;
+  for (ASDisplayNode *subnode in self.subnodes) {
+    _subnodesWereVisible = _subnodesWereVisible && subnode.isVisible;
+  }
+  if (_didEnterVisibleBlock) {
+    _didEnterVisibleBlock(self);
+  }
+}
+
+- (void)didExitVisibleState
+{
+  [super didExitVisibleState];
+  _exitVisibleCount++;
+}
+
+@end
+
+@interface ASInterfaceStatePerformanceTests : ASTestCase
+@end
+
+@implementation ASInterfaceStatePerformanceTests
+
+- (void)tearDown
+{
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [super tearDown];
+}
+
+- (void)setSnapshotEnabled:(BOOL)enabled
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
+  config.experimentalFeatures = enabled ? ASExperimentalInterfaceStateSnapshot : kNilOptions;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+}
+
+/**
+ * A cell with kCellChildCount children of kCellGrandchildCount nodes each, like a cell with a header, a few rows of
+ * text and buttons.
+ */
++ (ASCellNode *)cellWithNodes:(NSMutableArray<ASInterfaceStateTestNode *> *)nodes
+{
+  ASCellNode *cell = [[ASCellNode alloc] init];
+  for (NSUInteger i = 0; i < kCellChildCount; i++) {
+    ASInterfaceStateTestNode *child = [[ASInterfaceStateTestNode alloc] init];
+    [nodes addObject:child];
+    for (NSUInteger j = 0; j < kCellGrandchildCount; j++) {
+      ASInterfaceStateTestNode *grandchild = [[ASInterfaceStateTestNode alloc] init];
+      [nodes addObject:grandchild];
+      [child addSubnode:grandchild];
+    }
+    [cell addSubnode:child];
+  }
+  return cell;
+}
+
+- (void)testSnapshotReachesTheSameNodesAsTheRecursion
+{
+  [self setSnapshotEnabled:YES];
+  NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+  ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+
+  // A node whose view was added without -addSubnode: is only reachable through the layers.
+  [cell view];
+  ASInterfaceStateTestNode *foreignNode = [[ASInterfaceStateTestNode alloc] init];
+  [nodes.firstObject.view addSubview:foreignNode.view];
+  [nodes addObject:foreignNode];
+
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+  for (ASInterfaceStateTestNode *node in nodes) {
+    XCTAssertEqual(node.enterVisibleCount, 2);
+    XCTAssertEqual(node.exitVisibleCount, 1);
+    XCTAssertEqual(node.interfaceState, kASInterfaceStateOnscreen);
+  }
+}
+
+- (void)testSnapshotIsTakenAgainAfterSubnodesChange
+{
+  [self setSnapshotEnabled:YES];
+  NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+  ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+
+  ASInterfaceStateTestNode *removedNode = nodes.lastObject;
+  [removedNode removeFromSupernode];
+  NSUInteger removedNodeExitVisibleCount = removedNode.exitVisibleCount;
+  ASInterfaceStateTestNode *insertedNode = [[ASInterfaceStateTestNode alloc] init];
+  [nodes.firstObject addSubnode:insertedNode];
+
+  [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+  XCTAssertEqual(removedNode.exitVisibleCount, removedNodeExitVisibleCount);
+  XCTAssertEqual(insertedNode.interfaceState, kASInterfaceStateOffscreen);
+}
+
+- (void)testSnapshotDoesNotKeepRemovedNodes
+{
+  [self setSnapshotEnabled:YES];
+  NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+  ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+
+  __weak ASInterfaceStateTestNode *weakRemovedNode;
+  @autoreleasepool {
+    ASInterfaceStateTestNode *removedNode = nodes.lastObject;
+    weakRemovedNode = removedNode;
+    [nodes removeLastObject];
+    [removedNode removeFromSupernode];
+  }
+  XCTAssertNil(weakRemovedNode);
+
+  [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+  for (ASInterfaceStateTestNode *node in nodes) {
+    XCTAssertEqual(node.interfaceState, kASInterfaceStateOffscreen);
+  }
+}
+
+- (void)testSnapshotReachesNodesAddedByCallbacks
+{
+  [self setSnapshotEnabled:YES];
+  NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+  ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+  [cell view];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+
+  // A node added without -addSubnode: doesn't adopt the state of the node it was added to.
+  ASInterfaceStateTestNode *addedNode = [[ASInterfaceStateTestNode alloc] init];
+  nodes.firstObject.didEnterVisibleBlock = ^(ASInterfaceStateTestNode *node) {
+    [node.view addSubview:addedNode.view];
+  };
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+  XCTAssertEqual(addedNode.interfaceState, kASInterfaceStateOnscreen);
+  XCTAssertEqual(addedNode.enterVisibleCount, 1);
+}
+
+- (void)testSnapshotCallbacksSeeTheNewStateOfTheWholeSubtree
+{
+  [self setSnapshotEnabled:YES];
+  NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+  ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+  [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+  for (ASInterfaceStateTestNode *node in nodes) {
+    XCTAssertTrue(node.subnodesWereVisible);
+  }
+}
+
+- (void)testPerformance_CellsEnteringAndLeavingTheVisibleRange
+{
+  ASPerformanceTestContext *ctx = [[ASPerformanceTestContext alloc] init];
+  for (NSString *caseName in @[ kTestCaseRecursive, kTestCaseSnapshot ]) {
+    [self setSnapshotEnabled:(caseName == kTestCaseSnapshot)];
+    NSMutableArray<ASInterfaceStateTestNode *> *nodes = [NSMutableArray array];
+    NSMutableArray<ASCellNode *> *cells = [NSMutableArray array];
+    for (NSUInteger i = 0; i < kCellCount; i++) {
+      ASCellNode *cell = [ASInterfaceStatePerformanceTests cellWithNodes:nodes];
+      // Cells in the visible range are loaded, so their layers are visited.
+      [cell view];
+      [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+      [cells addObject:cell];
+    }
+
+    [ctx addCaseWithName:caseName block:^(NSUInteger i, dispatch_block_t  _Nonnull startMeasuring, dispatch_block_t  _Nonnull stopMeasuring) {
+      startMeasuring();
+      for (ASCellNode *cell in cells) {
+        [cell recursivelySetInterfaceState:kASInterfaceStateOnscreen];
+      }
+      for (ASCellNode *cell in cells) {
+        [cell recursivelySetInterfaceState:kASInterfaceStateOffscreen];
+      }
+      stopMeasuring();
+    }];
+
+    NSUInteger enterVisibleCount = 0;
+    for (ASInterfaceStateTestNode *node in nodes) {
+      enterVisibleCount += node.enterVisibleCount;
+    }
+    ctx.results[caseName].userInfo[@"enterVisibleCount"] = @(enterVisibleCount);
+  }
+
+  XCTAssertTrue([ctx areAllUserInfosEqual]);
+  XCTAssertGreaterThan(ctx.results[kTestCaseSnapshot].relativePerformance, 1.0);
+}
+
+@end
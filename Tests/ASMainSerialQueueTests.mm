@@ -0,0 +1,123 @@
+//
+//  ASMainSerialQueueTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTestCase.h"
+
+#import <AsyncDisplayKit/ASConfiguration.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASMainSerialQueue.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+#import "ASDisplayNodeTestsHelper.h"
+
+@interface ASMainSerialQueueTests : ASTestCase
+
+@end
+
+/// Runs the block on a background thread and waits for it. dispatch_sync could run it on the main thread.
+static void ASRunOnBackgroundThreadAndWait(dispatch_block_t block)
+{
+  dispatch_group_t group = dispatch_group_create();
+  dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), block);
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+}
+
+@implementation ASMainSerialQueueTests
+
+- (void)tearDown
+{
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [super tearDown];
+}
+
+- (void)testThatBlocksFromEachThreadRunInOrderIncludingOverflow
+{
+  ASMainSerialQueue *queue = [[ASMainSerialQueue alloc] init];
+  // More blocks than fit in the ring from each thread.
+  const NSInteger threadCount = 4;
+  const NSInteger blockCount = 1000;
+  NSMutableArray<NSMutableArray<NSNumber *> *> *ran = [NSMutableArray array];
+  for (NSInteger i = 0; i < threadCount; i++) {
+    [ran addObject:[NSMutableArray array]];
+  }
+
+  dispatch_group_t group = dispatch_group_create();
+  for (NSInteger thread = 0; thread < threadCount; thread++) {
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+      for (NSInteger i = 0; i < blockCount; i++) {
+        [queue performBlockOnMainThread:^{
+          XCTAssertTrue(ASDisplayNodeThreadIsMain());
+          [ran[thread] addObject:@(i)];
+        }];
+      }
+    });
+  }
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+  XCTAssertTrue(ASDisplayNodeRunRunLoopUntilBlockIsTrue(^BOOL{
+    return queue.numberOfScheduledBlocks == 0;
+  }));
+  for (NSInteger thread = 0; thread < threadCount; thread++) {
+    XCTAssertEqual(ran[thread].count, blockCount);
+    for (NSInteger i = 0; i < (NSInteger)ran[thread].count; i++) {
+      XCTAssertEqualObjects(ran[thread][i], @(i));
+    }
+  }
+  XCTAssertEqual(queue.statistics.blockCount, threadCount * blockCount);
+  XCTAssertGreaterThan(queue.statistics.maximumDepth, 0);
+}
+
+- (void)testThatSchedulingOnTheMainThreadRunsTheEarlierBlocksFirst
+{
+  ASMainSerialQueue *queue = [[ASMainSerialQueue alloc] init];
+  NSMutableArray<NSNumber *> *ran = [NSMutableArray array];
+  ASRunOnBackgroundThreadAndWait(^{
+    [queue performBlockOnMainThread:^{
+      [ran addObject:@1];
+    }];
+  });
+  XCTAssertEqual(queue.numberOfScheduledBlocks, 1);
+
+  [queue performBlockOnMainThread:^{
+    [ran addObject:@2];
+  }];
+  XCTAssertEqualObjects(ran, (@[@1, @2]));
+  XCTAssertEqual(queue.numberOfScheduledBlocks, 0);
+
+  // The pending wakeup finds nothing left to run.
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  XCTAssertEqualObjects(ran, (@[@1, @2]));
+}
+
+- (void)testThatABudgetedDrainYieldsToTheRunLoop
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
+  config.experimentalFeatures = ASExperimentalBudgetedMainSerialQueue;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  ASMainSerialQueue *queue = [[ASMainSerialQueue alloc] init];
+  NSMutableArray<NSNumber *> *ran = [NSMutableArray array];
+  ASRunOnBackgroundThreadAndWait(^{
+    for (NSInteger i = 0; i < 4; i++) {
+      [queue performBlockOnMainThread:^{
+        // Longer than the budget.
+        usleep(10000);
+        [ran addObject:@(i)];
+      }];
+    }
+  });
+
+  XCTAssertTrue(ASDisplayNodeRunRunLoopUntilBlockIsTrue(^BOOL{
+    return queue.numberOfScheduledBlocks == 0;
+  }));
+  XCTAssertEqualObjects(ran, (@[@0, @1, @2, @3]));
+  XCTAssertEqual(queue.statistics.yieldCount, 3);
+  XCTAssertGreaterThanOrEqual(queue.statistics.maximumLatency, 0.03);
+}
+
+@end
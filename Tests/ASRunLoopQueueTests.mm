@@ -25,6 +25,18 @@ static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run
 }
 @end
 
+/** Records the thread it was deallocated on. */
+@interface DeallocThreadObject : NSObject
+@property (nonatomic) void (^deallocBlock)(BOOL isMainThread);
+@end
+
+@implementation DeallocThreadObject
+- (void)dealloc
+{
+  _deallocBlock([NSThread isMainThread]);
+}
+@end
+
 @interface ASRunLoopQueueTests : ASTestCase
 
 @end
@@ -122,6 +134,143 @@ static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run
   XCTAssertTrue(isQueueDrainedWhenProcessingB);
 }
 
+#pragma mark time budget tests
+
+/// The number of turns of the main run loop, while ASRunLoopQueueRunUntilEmpty runs it. A turn that only polls,
+/// because a source was signaled, counts as well.
+static NSInteger gRunLoopTurn = 0;
+
+/// Runs the main run loop until the queue is empty, and returns how many items were processed in each turn of it.
+static NSArray<NSNumber *> *ASRunLoopQueueRunUntilEmpty(ASRunLoopQueue *queue, NSArray<NSNumber *> *processedTurns)
+{
+  gRunLoopTurn = 0;
+  CFRunLoopObserverRef observer = CFRunLoopObserverCreateWithHandler(NULL, kCFRunLoopBeforeSources, true, 0, ^(CFRunLoopObserverRef observer, CFRunLoopActivity activity) {
+    gRunLoopTurn++;
+  });
+  CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+  ASDisplayNodeRunRunLoopUntilBlockIsTrue(^BOOL{
+    return queue.isEmpty;
+  });
+  CFRunLoopObserverInvalidate(observer);
+  CFRelease(observer);
+
+  NSCountedSet<NSNumber *> *counts = [[NSCountedSet alloc] initWithArray:processedTurns];
+  NSMutableArray<NSNumber *> *result = [NSMutableArray array];
+  for (NSNumber *processedTurn in [[counts allObjects] sortedArrayUsingSelector:@selector(compare:)]) {
+    [result addObject:@([counts countForObject:processedTurn])];
+  }
+  return result;
+}
+
+- (void)testTimeBudgetedQueueProcessesCheapItemsTogether
+{
+  NSMutableArray<NSNumber *> *processedTurns = [NSMutableArray array];
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [processedTurns addObject:@(gRunLoopTurn)];
+  }];
+  queue.timeBudget = 0.01;
+  for (NSInteger i = 0; i < 100; i++) {
+    [queue enqueue:[[NSObject alloc] init]];
+  }
+  NSArray<NSNumber *> *counts = ASRunLoopQueueRunUntilEmpty(queue, processedTurns);
+
+  XCTAssertEqual(processedTurns.count, 100);
+  // The first item is measured on its own, then many more fit in the budget than the batch size of 1.
+  XCTAssertEqualObjects(counts.firstObject, @1);
+  XCTAssertGreaterThan([[counts valueForKeyPath:@"@max.self"] integerValue], 1);
+}
+
+- (void)testTimeBudgetedQueueSpreadsExpensiveItemsOverTurns
+{
+  NSMutableArray<NSNumber *> *processedTurns = [NSMutableArray array];
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [NSThread sleepForTimeInterval:0.004];
+    [processedTurns addObject:@(gRunLoopTurn)];
+  }];
+  queue.batchSize = 100;
+  queue.timeBudget = 0.01;
+  for (NSInteger i = 0; i < 8; i++) {
+    [queue enqueue:[[NSObject alloc] init]];
+  }
+  NSArray<NSNumber *> *counts = ASRunLoopQueueRunUntilEmpty(queue, processedTurns);
+
+  XCTAssertEqual(processedTurns.count, 8);
+  // The time budget wins over the batch size, and at most two 4ms items fit in 10ms.
+  for (NSNumber *count in counts) {
+    XCTAssertLessThanOrEqual(count.integerValue, 2);
+  }
+}
+
+- (void)testTimeBudgetedDeallocationQueueSpreadsReleasesOverTurns
+{
+  NSMutableArray<NSNumber *> *processedTurns = [NSMutableArray array];
+  // Like the queue of ASPerformMainThreadDeallocation, which only releases its items.
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:nil];
+  queue.batchSize = 10;
+  queue.timeBudget = 0.005;
+  @autoreleasepool {
+    for (NSInteger i = 0; i < 20; i++) {
+      DeallocThreadObject *object = [[DeallocThreadObject alloc] init];
+      object.deallocBlock = ^(BOOL isMainThread) {
+        [NSThread sleepForTimeInterval:0.001];
+        [processedTurns addObject:@(gRunLoopTurn)];
+      };
+      [queue enqueue:object];
+    }
+  }
+  NSArray<NSNumber *> *counts = ASRunLoopQueueRunUntilEmpty(queue, processedTurns);
+
+  XCTAssertEqual(processedTurns.count, 20);
+  // A batch of 10 1ms releases doesn't fit in 5ms, so the queue is released over several turns.
+  XCTAssertGreaterThan(counts.count, 2);
+  for (NSNumber *count in counts) {
+    XCTAssertLessThanOrEqual(count.integerValue, 6);
+  }
+}
+
+- (void)testWeakQueueSkipsDeallocatedObjects
+{
+  NSMutableArray *processed = [NSMutableArray array];
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:NO handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [processed addObject:dequeuedItem];
+  }];
+  queue.batchSize = 10;
+  id objectA = [[NSObject alloc] init];
+  id objectC = [[NSObject alloc] init];
+  @autoreleasepool {
+    [queue enqueue:objectA];
+    id objectB = [[NSObject alloc] init];
+    [queue enqueue:objectB];
+    [queue enqueue:objectC];
+    objectB = nil;
+  }
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:kRunLoopRunTime]];
+  XCTAssertEqualObjects(processed, (@[objectA, objectC]));
+  XCTAssertTrue(queue.isEmpty);
+}
+
+- (void)testWeakQueueIsDrainedWhenTheLastObjectWasDeallocated
+{
+  NSMutableArray *processed = [NSMutableArray array];
+  __block BOOL isQueueDrainedWhenProcessingA = NO;
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:NO handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [processed addObject:dequeuedItem];
+    isQueueDrainedWhenProcessingA = isQueueDrained;
+  }];
+  queue.batchSize = 10;
+  id objectA = [[NSObject alloc] init];
+  @autoreleasepool {
+    [queue enqueue:objectA];
+    id objectB = [[NSObject alloc] init];
+    [queue enqueue:objectB];
+    objectB = nil;
+  }
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:kRunLoopRunTime]];
+  XCTAssertEqualObjects(processed, (@[objectA]));
+  XCTAssertTrue(isQueueDrainedWhenProcessingA);
+  XCTAssertTrue(queue.isEmpty);
+}
+
 #pragma mark strong/weak tests
 
 - (void)testStrongQueueRetainsObjects
@@ -198,4 +347,49 @@ static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run
   XCTAssertTrue(queue.enabled);
 }
 
+#pragma mark ASDeallocQueue
+
+- (void)testDeallocQueueReleasesObjectsOffTheMainThread
+{
+  ASDeallocQueue *queue = ASDeallocQueue.sharedDeallocationQueue;
+  const ASDeallocQueueStatistics before = queue.statistics;
+
+  __block NSInteger deallocCount = 0;
+  __block BOOL deallocatedOnMain = NO;
+  for (NSInteger i = 0; i < 3; i++) {
+    DeallocThreadObject *object = [[DeallocThreadObject alloc] init];
+    object.deallocBlock = ^(BOOL isMainThread) {
+      deallocCount++;
+      deallocatedOnMain |= isMainThread;
+    };
+    id objectToRelease = object;
+    object = nil;
+    [queue releaseObjectInBackground:&objectToRelease];
+    XCTAssertNil(objectToRelease);
+  }
+  XCTAssertEqual(deallocCount, 0);
+
+  [queue drain];
+  XCTAssertEqual(deallocCount, 3);
+  XCTAssertFalse(deallocatedOnMain);
+
+  const ASDeallocQueueStatistics after = queue.statistics;
+  XCTAssertEqual(after.objectCount - before.objectCount, 3);
+  XCTAssertEqual(after.mainThreadObjectCount - before.mainThreadObjectCount, 3);
+  XCTAssertGreaterThan(after.drainCount, before.drainCount);
+  XCTAssertGreaterThanOrEqual(after.releaseTime, after.mainThreadReleaseTime);
+}
+
+- (void)testDeallocQueueIgnoresNil
+{
+  ASDeallocQueue *queue = ASDeallocQueue.sharedDeallocationQueue;
+  [queue drain];
+  const ASDeallocQueueStatistics before = queue.statistics;
+  id object = nil;
+  [queue releaseObjectInBackground:&object];
+  [queue drain];
+  XCTAssertEqual(queue.statistics.objectCount, before.objectCount);
+  XCTAssertEqual(queue.statistics.drainCount, before.drainCount);
+}
+
 @end
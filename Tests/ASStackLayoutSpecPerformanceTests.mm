@@ -0,0 +1,382 @@
+//
+//  ASStackLayoutSpecPerformanceTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+#import "ASPerformanceTestContext.h"
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+#import "ASTestCase.h"
+#import "ASXCTExtensions.h"
+
+static NSString *const kTestCaseFull = @"Full";
+static NSString *const kTestCaseIncremental = @"Incremental";
+static NSString *const kTestCaseUncached = @"Uncached";
+static NSString *const kTestCaseCached = @"Cached";
+static NSUInteger const kStackChildCount = 200;
+static NSUInteger const kStackDepth = 6;
+
+/**
+ * Measures a short string like a text node would, and counts how often it was asked to.
+ */
+@interface ASStackLayoutSpecPerformanceTestNode : ASDisplayNode
+@property (nonatomic, copy) NSString *text;
+@property (atomic) NSUInteger measurementCount;
+@end
+
+@implementation ASStackLayoutSpecPerformanceTestNode
+
+- (CGSize)calculateSizeThatFits:(CGSize)constrainedSize
+{
+  self.measurementCount += 1;
+  CGRect rect = [_text boundingRectWithSize:constrainedSize
+                                    options:NSStringDrawingUsesLineFragmentOrigin
+                                 attributes:@{ NSFontAttributeName : [UIFont systemFontOfSize:15] }
+                                    context:nil];
+  return CGSizeMake(ceil(rect.size.width), ceil(rect.size.height));
+}
+
+@end
+
+@interface ASStackLayoutSpecPerformanceTests : ASTestCase
+@end
+
+@implementation ASStackLayoutSpecPerformanceTests
+
+- (void)tearDown
+{
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [super tearDown];
+}
+
+- (void)setExperimentalFeatures:(ASExperimentalFeatures)features
+{
+  ASConfiguration *config = [[ASConfiguration alloc] initWithDictionary:nil];
+  config.experimentalFeatures = features;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+}
+
+- (void)setIncrementalStackLayoutEnabled:(BOOL)enabled
+{
+  [self setExperimentalFeatures:enabled ? ASExperimentalIncrementalStackLayout : kNilOptions];
+}
+
+/**
+ * A cell-like vertical stack: every child is measured at its intrinsic width and then stretched to the full width, so
+ * each child's own cached layout gets replaced on every pass.
+ */
++ (ASStackLayoutSpec *)stackWithChildren:(NSArray<ASStackLayoutSpecPerformanceTestNode *> **)outChildren
+{
+  NSMutableArray<ASStackLayoutSpecPerformanceTestNode *> *children = [NSMutableArray array];
+  for (NSUInteger i = 0; i < kStackChildCount; i++) {
+    ASStackLayoutSpecPerformanceTestNode *child = [[ASStackLayoutSpecPerformanceTestNode alloc] init];
+    child.text = [NSString stringWithFormat:@"Row %lu liked by %lu people", (unsigned long)i, (unsigned long)i * 7];
+    [children addObject:child];
+  }
+  *outChildren = children;
+  return [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionVertical
+                                                 spacing:4
+                                          justifyContent:ASStackLayoutJustifyContentStart
+                                              alignItems:ASStackLayoutAlignItemsStretch
+                                                children:children];
+}
+
+- (void)testIncrementalStackLayoutOnlyMeasuresInvalidatedChildren
+{
+  [self setIncrementalStackLayoutEnabled:YES];
+  NSArray<ASStackLayoutSpecPerformanceTestNode *> *children;
+  ASStackLayoutSpec *stack = [ASStackLayoutSpecPerformanceTests stackWithChildren:&children];
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(320, 0), CGSizeMake(320, CGFLOAT_MAX));
+
+  [stack layoutThatFits:sizeRange];
+  for (ASStackLayoutSpecPerformanceTestNode *child in children) {
+    child.measurementCount = 0;
+  }
+
+  ASStackLayoutSpecPerformanceTestNode *changedChild = children[10];
+  changedChild.text = @"Row 10 liked by 71 people";
+  [changedChild setNeedsLayout];
+  ASLayout *incrementalLayout = [stack layoutThatFits:sizeRange];
+
+  for (ASStackLayoutSpecPerformanceTestNode *child in children) {
+    if (child == changedChild) {
+      XCTAssertGreaterThan(child.measurementCount, 0);
+    } else {
+      XCTAssertEqual(child.measurementCount, 0, @"Unchanged child was measured again: %@", child.text);
+    }
+  }
+
+  // A full pass over the same children has to agree with the incremental one.
+  [self setIncrementalStackLayoutEnabled:NO];
+  ASLayout *fullLayout = [stack layoutThatFits:sizeRange];
+  ASXCTAssertEqualSizes(incrementalLayout.size, fullLayout.size);
+  XCTAssertEqual(incrementalLayout.sublayouts.count, fullLayout.sublayouts.count);
+  for (NSUInteger i = 0; i < fullLayout.sublayouts.count; i++) {
+    ASXCTAssertEqualRects(incrementalLayout.sublayouts[i].frame, fullLayout.sublayouts[i].frame);
+  }
+}
+
+- (void)testPerformance_200ChildStackWithOneChangedChild
+{
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(320, 0), CGSizeMake(320, CGFLOAT_MAX));
+  __block CGSize fullSize, incrementalSize;
+
+  ASPerformanceTestContext *ctx = [[ASPerformanceTestContext alloc] init];
+  for (NSString *caseName in @[ kTestCaseFull, kTestCaseIncremental ]) {
+    [self setIncrementalStackLayoutEnabled:(caseName == kTestCaseIncremental)];
+    NSArray<ASStackLayoutSpecPerformanceTestNode *> *children;
+    ASStackLayoutSpec *stack = [ASStackLayoutSpecPerformanceTests stackWithChildren:&children];
+    __block CGSize size = [stack layoutThatFits:sizeRange].size;
+
+    [ctx addCaseWithName:caseName block:^(NSUInteger i, dispatch_block_t  _Nonnull startMeasuring, dispatch_block_t  _Nonnull stopMeasuring) {
+      [children[i % kStackChildCount] setNeedsLayout];
+      startMeasuring();
+      size = [stack layoutThatFits:sizeRange].size;
+      stopMeasuring();
+    }];
+    if (caseName == kTestCaseFull) {
+      fullSize = size;
+    } else {
+      incrementalSize = size;
+    }
+  }
+
+  ASXCTAssertEqualSizes(fullSize, incrementalSize);
+  XCTAssertGreaterThan(ctx.results[kTestCaseIncremental].relativePerformance, 1.0);
+}
+
+#pragma mark Microbenchmarks
+
+/**
+ * Lays out a horizontal stack of fixed size children. From 10 children on it overflows its width, so every pass has to
+ * flex: without wrapping all children shrink, with wrapping the children are broken into lines which then grow. A
+ * single child fits and measures the fixed cost of a pass. Children cache their own layouts, so this mostly measures
+ * the stack algorithm itself. The fastest run is reported per laid out child, to compare the child counts.
+ */
+- (void)measureStackLayoutWithChildCount:(NSUInteger)childCount flexWrap:(ASStackLayoutFlexWrap)flexWrap
+{
+  NSMutableArray<ASDisplayNode *> *children = [NSMutableArray arrayWithCapacity:childCount];
+  for (NSUInteger i = 0; i < childCount; i++) {
+    ASDisplayNode *child = [[ASDisplayNode alloc] init];
+    child.style.preferredSize = CGSizeMake(40 + (i % 3) * 10, 20);
+    child.style.flexShrink = 1;
+    child.style.flexGrow = (i % 2);
+    [children addObject:child];
+  }
+  ASStackLayoutSpec *stack = [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionHorizontal
+                                                                     spacing:2
+                                                              justifyContent:ASStackLayoutJustifyContentStart
+                                                                  alignItems:ASStackLayoutAlignItemsStart
+                                                                    flexWrap:flexWrap
+                                                                alignContent:ASStackLayoutAlignContentStart
+                                                                    children:children];
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeMake(375, 0), CGSizeMake(375, CGFLOAT_MAX));
+
+  // Keep the number of laid out children per run roughly constant.
+  NSUInteger iterations = MAX(100000 / childCount, (NSUInteger)10);
+  __block ASLayout *layout = [stack layoutThatFits:sizeRange];
+  __block CFTimeInterval fastestRun = DBL_MAX;
+  [self measureBlock:^{
+    CFTimeInterval start = CACurrentMediaTime();
+    for (NSUInteger i = 0; i < iterations; i++) {
+      @autoreleasepool {
+        layout = [stack layoutThatFits:sizeRange];
+      }
+    }
+    fastestRun = MIN(fastestRun, CACurrentMediaTime() - start);
+  }];
+
+  XCTAssertEqual(layout.sublayouts.count, childCount);
+  NSString *report = [NSString stringWithFormat:@"%.1f ns per child", fastestRun * 1e9 / (iterations * childCount)];
+  [XCTContext runActivityNamed:report block:^(id<XCTActivity> activity) {
+    XCTAttachment *attachment = [XCTAttachment attachmentWithString:report];
+    attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+    [activity addAttachment:attachment];
+  }];
+}
+
+- (void)testPerformance_1Child
+{
+  [self measureStackLayoutWithChildCount:1 flexWrap:ASStackLayoutFlexWrapNoWrap];
+}
+
+- (void)testPerformance_1ChildWrapping
+{
+  [self measureStackLayoutWithChildCount:1 flexWrap:ASStackLayoutFlexWrapWrap];
+}
+
+- (void)testPerformance_10Children
+{
+  [self measureStackLayoutWithChildCount:10 flexWrap:ASStackLayoutFlexWrapNoWrap];
+}
+
+- (void)testPerformance_10ChildrenWrapping
+{
+  [self measureStackLayoutWithChildCount:10 flexWrap:ASStackLayoutFlexWrapWrap];
+}
+
+- (void)testPerformance_1000Children
+{
+  [self measureStackLayoutWithChildCount:1000 flexWrap:ASStackLayoutFlexWrapNoWrap];
+}
+
+- (void)testPerformance_1000ChildrenWrapping
+{
+  [self measureStackLayoutWithChildCount:1000 flexWrap:ASStackLayoutFlexWrapWrap];
+}
+
+#pragma mark Node Layout Cache
+
+/**
+ * Nested nodes that each stack a leaf above the next level in a vertical stack that stretches both to its width. The
+ * leaves are wider the further out they are, so each level is measured at its intrinsic width and then stretched to
+ * the width of every leaf around it, and each leaf is asked for a layout at several size ranges on every pass.
+ */
++ (ASDisplayNode *)deepStackWithDepth:(NSUInteger)depth
+                               leaves:(NSMutableArray<ASStackLayoutSpecPerformanceTestNode *> *)leaves
+                           containers:(NSMutableArray<ASDisplayNode *> *)containers
+{
+  ASStackLayoutSpecPerformanceTestNode *leaf = [[ASStackLayoutSpecPerformanceTestNode alloc] init];
+  leaf.text = [@"" stringByPaddingToLength:depth * 6 withString:@"Level " startingAtIndex:0];
+  [leaves addObject:leaf];
+  ASDisplayNode *next = depth > 1 ? [self deepStackWithDepth:depth - 1 leaves:leaves containers:containers] : nil;
+
+  ASDisplayNode *container = [[ASDisplayNode alloc] init];
+  container.automaticallyManagesSubnodes = YES;
+  container.layoutSpecBlock = ^ASLayoutSpec *(__kindof ASDisplayNode *node, ASSizeRange constrainedSize) {
+    return [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionVertical
+                                                   spacing:4
+                                            justifyContent:ASStackLayoutJustifyContentStart
+                                                alignItems:ASStackLayoutAlignItemsStretch
+                                                  children:next ? @[ leaf, next ] : @[ leaf ]];
+  };
+  [containers addObject:container];
+  return container;
+}
+
++ (NSUInteger)measurementCountOfLeaves:(NSArray<ASStackLayoutSpecPerformanceTestNode *> *)leaves
+{
+  NSUInteger count = 0;
+  for (ASStackLayoutSpecPerformanceTestNode *leaf in leaves) {
+    count += leaf.measurementCount;
+    leaf.measurementCount = 0;
+  }
+  return count;
+}
+
+- (void)testNodeLayoutCacheAvoidsMeasuringUnchangedLeavesAgain
+{
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeZero, CGSizeMake(320, CGFLOAT_MAX));
+  CGSize sizes[2];
+  NSUInteger measurementCounts[2];
+  for (NSUInteger i = 0; i < 2; i++) {
+    [self setExperimentalFeatures:(i == 1) ? ASExperimentalNodeLayoutCache : kNilOptions];
+    NSMutableArray<ASStackLayoutSpecPerformanceTestNode *> *leaves = [NSMutableArray array];
+    NSMutableArray<ASDisplayNode *> *containers = [NSMutableArray array];
+    ASDisplayNode *root = [ASStackLayoutSpecPerformanceTests deepStackWithDepth:kStackDepth leaves:leaves containers:containers];
+    [root layoutThatFits:sizeRange];
+    [ASStackLayoutSpecPerformanceTests measurementCountOfLeaves:leaves];
+
+    // Only the containers changed, so the leaves are asked for the same size ranges as before.
+    for (ASDisplayNode *container in containers) {
+      [container setNeedsLayout];
+    }
+    ASNodeLayoutCacheStatistics before = ASConfiguration.nodeLayoutCacheStatistics;
+    sizes[i] = [root layoutThatFits:sizeRange].size;
+    measurementCounts[i] = [ASStackLayoutSpecPerformanceTests measurementCountOfLeaves:leaves];
+    ASNodeLayoutCacheStatistics after = ASConfiguration.nodeLayoutCacheStatistics;
+    if (i == 1) {
+      XCTAssertGreaterThanOrEqual(after.hitCount - before.hitCount, kStackDepth);
+      XCTAssertEqual(after.fittingHitCount, before.fittingHitCount);
+    }
+  }
+
+  XCTAssertGreaterThan(measurementCounts[0], 0);
+  XCTAssertEqual(measurementCounts[1], 0);
+  ASXCTAssertEqualSizes(sizes[0], sizes[1]);
+}
+
+- (void)testNodeLayoutCacheIsInvalidatedBySetNeedsLayout
+{
+  [self setExperimentalFeatures:ASExperimentalNodeLayoutCache];
+  ASStackLayoutSpecPerformanceTestNode *node = [[ASStackLayoutSpecPerformanceTestNode alloc] init];
+  node.text = @"Short";
+  ASSizeRange narrow = ASSizeRangeMake(CGSizeZero, CGSizeMake(100, CGFLOAT_MAX));
+  ASSizeRange wide = ASSizeRangeMake(CGSizeZero, CGSizeMake(200, CGFLOAT_MAX));
+  [node layoutThatFits:narrow];
+  [node layoutThatFits:wide];
+  [node layoutThatFits:narrow];
+  XCTAssertEqual(node.measurementCount, 2);
+
+  node.text = @"A longer text that wraps";
+  [node setNeedsLayout];
+  [node layoutThatFits:narrow];
+  XCTAssertEqual(node.measurementCount, 3);
+}
+
+- (void)testNodeLayoutCacheFittingReusesLayoutsThatStillFit
+{
+  [self setExperimentalFeatures:ASExperimentalNodeLayoutCache | ASExperimentalNodeLayoutCacheFitting];
+  ASStackLayoutSpecPerformanceTestNode *node = [[ASStackLayoutSpecPerformanceTestNode alloc] init];
+  node.text = @"Short";
+  ASLayout *layout = [node layoutThatFits:ASSizeRangeMake(CGSizeZero, CGSizeMake(300, CGFLOAT_MAX))];
+  XCTAssertEqual(node.measurementCount, 1);
+
+  // Less room that still fits the layout reuses it, more room might unwrap text and doesn't.
+  ASNodeLayoutCacheStatistics before = ASConfiguration.nodeLayoutCacheStatistics;
+  XCTAssertEqual([node layoutThatFits:ASSizeRangeMake(CGSizeZero, CGSizeMake(250, CGFLOAT_MAX))], layout);
+  XCTAssertEqual(node.measurementCount, 1);
+  XCTAssertEqual(ASConfiguration.nodeLayoutCacheStatistics.fittingHitCount - before.fittingHitCount, 1);
+
+  [node layoutThatFits:ASSizeRangeMake(CGSizeZero, CGSizeMake(400, CGFLOAT_MAX))];
+  XCTAssertEqual(node.measurementCount, 2);
+}
+
+- (void)testPerformance_DeepStretchedStack
+{
+  ASSizeRange sizeRange = ASSizeRangeMake(CGSizeZero, CGSizeMake(320, CGFLOAT_MAX));
+  __block CGSize uncachedSize, cachedSize;
+
+  ASPerformanceTestContext *ctx = [[ASPerformanceTestContext alloc] init];
+  for (NSString *caseName in @[ kTestCaseUncached, kTestCaseCached ]) {
+    [self setExperimentalFeatures:(caseName == kTestCaseCached) ? ASExperimentalNodeLayoutCache : kNilOptions];
+    NSMutableArray<ASStackLayoutSpecPerformanceTestNode *> *leaves = [NSMutableArray array];
+    NSMutableArray<ASDisplayNode *> *containers = [NSMutableArray array];
+    ASDisplayNode *root = [ASStackLayoutSpecPerformanceTests deepStackWithDepth:kStackDepth leaves:leaves containers:containers];
+    __block CGSize size = CGSizeZero;
+    __block NSUInteger measurementCount = 0;
+    ASNodeLayoutCacheStatistics before = ASConfiguration.nodeLayoutCacheStatistics;
+
+    [ctx addCaseWithName:caseName block:^(NSUInteger i, dispatch_block_t  _Nonnull startMeasuring, dispatch_block_t  _Nonnull stopMeasuring) {
+      for (ASDisplayNode *container in containers) {
+        [container setNeedsLayout];
+      }
+      startMeasuring();
+      size = [root layoutThatFits:sizeRange].size;
+      stopMeasuring();
+      measurementCount += [ASStackLayoutSpecPerformanceTests measurementCountOfLeaves:leaves];
+    }];
+
+    // The measure calls the cache avoided show up as fewer leaf measurements and as hits.
+    ASPerformanceTestResult *result = ctx.results[caseName];
+    result.userInfo[@"leafMeasurements"] = @(measurementCount);
+    result.userInfo[@"layoutCacheHits"] = @(ASConfiguration.nodeLayoutCacheStatistics.hitCount - before.hitCount);
+    if (caseName == kTestCaseUncached) {
+      uncachedSize = size;
+    } else {
+      cachedSize = size;
+    }
+  }
+
+  ASXCTAssertEqualSizes(uncachedSize, cachedSize);
+  XCTAssertLessThan([ctx.results[kTestCaseCached].userInfo[@"leafMeasurements"] unsignedIntegerValue],
+                    [ctx.results[kTestCaseUncached].userInfo[@"leafMeasurements"] unsignedIntegerValue]);
+  XCTAssertGreaterThan(ctx.results[kTestCaseCached].relativePerformance, 1.0);
+}
+
+@end
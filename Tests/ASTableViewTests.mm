@@ -462,6 +462,102 @@
   [self triggerSizeChangeAndAssertRelayoutAllNodesForTableView:tableView newSize:tableViewFinalSize];
 }
 
+- (void)testIncrementalRelayoutRemeasuresOffscreenRowsInTheBackground
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalIncrementalRelayout;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  CGSize tableViewFinalSize = CGSizeMake(100, 500);
+  ASTestTableView *tableView = [[ASTestTableView alloc] __initWithFrame:CGRectMake(0, 0, tableViewFinalSize.height, tableViewFinalSize.width)
+                                                                  style:UITableViewStylePlain];
+  ASTableViewFilledDataSource *dataSource = [ASTableViewFilledDataSource new];
+  tableView.asyncDelegate = dataSource;
+  tableView.asyncDataSource = dataSource;
+  [self triggerFirstLayoutMeasurementForTableView:tableView];
+
+  CGRect frame = tableView.frame;
+  frame.size = tableViewFinalSize;
+  tableView.frame = frame;
+  [tableView layoutIfNeeded];
+  [tableView waitUntilAllUpdatesAreCommitted];
+
+  // Rows outside of the display range are remeasured in background chunks.
+  NSPredicate *allNodesRemeasured = [NSPredicate predicateWithBlock:^BOOL(ASTestTableView *tableView, NSDictionary *bindings) {
+    for (NSInteger section = 0; section < [tableView numberOfSections]; section++) {
+      for (NSInteger row = 0; row < [tableView numberOfRowsInSection:section]; row++) {
+        ASCellNode *node = [tableView nodeForRowAtIndexPath:[NSIndexPath indexPathForRow:row inSection:section]];
+        if (node.constrainedSizeForCalculatedLayout.max.width != tableViewFinalSize.width) {
+          return NO;
+        }
+      }
+    }
+    return YES;
+  }];
+  [self expectationForPredicate:allNodesRemeasured evaluatedWithObject:tableView handler:nil];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertEqual(tableView.testDataController.numberOfAllNodesRelayouts, 1);
+}
+
+- (void)testWindowedReloadMaterializesRowsAroundTheViewport
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalWindowedReload;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  ATableViewTestController *testController = [[ATableViewTestController alloc] initWithNibName:nil bundle:nil];
+  ASTableNode *tableNode = testController.tableNode;
+  ASTableViewFilledDataSource *dataSource = testController.dataSource;
+  dataSource.numberOfSections = 1;
+  dataSource.rowsPerSection = 10000;
+  __block NSInteger nodeBlockCount = 0;
+  dataSource.nodeBlockForItem = ^(NSIndexPath *indexPath) {
+    nodeBlockCount++;
+    return (ASCellNodeBlock)^{
+      ASTestTextCellNode *textCellNode = [[ASTestTextCellNode alloc] init];
+      textCellNode.text = indexPath.description;
+      return textCellNode;
+    };
+  };
+  tableNode.view.estimatedRowHeight = 44;
+
+  UIWindow *window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]];
+  window.rootViewController = testController;
+  [window makeKeyAndVisible];
+
+  ASRangeTuningParameters preloadParams = { .leadingBufferScreenfuls = 1, .trailingBufferScreenfuls = 1 };
+  [tableNode setTuningParameters:preloadParams forRangeMode:ASLayoutRangeModeMinimum rangeType:ASLayoutRangeTypePreload];
+  [tableNode updateCurrentRangeWithMode:ASLayoutRangeModeMinimum];
+
+  [tableNode reloadData];
+  [tableNode waitUntilAllUpdatesAreProcessed];
+  [tableNode.view layoutIfNeeded];
+
+  // Only the rows around the first ones get nodes, the others are placeholders of the estimated height.
+  XCTAssertEqual([tableNode numberOfRowsInSection:0], 10000);
+  XCTAssertLessThan(nodeBlockCount, 200);
+  XCTAssertNotNil([tableNode nodeForRowAtIndexPath:[NSIndexPath indexPathForRow:0 inSection:0]]);
+  XCTAssertNil([tableNode nodeForRowAtIndexPath:[NSIndexPath indexPathForRow:5000 inSection:0]]);
+
+  // Rows that scroll into view are materialized as UITableView asks for them.
+  NSIndexPath *middle = [NSIndexPath indexPathForRow:5000 inSection:0];
+  [tableNode scrollToRowAtIndexPath:middle atScrollPosition:UITableViewScrollPositionTop animated:NO];
+  [tableNode.view layoutIfNeeded];
+  XCTAssertNotNil([tableNode nodeForRowAtIndexPath:middle]);
+  XCTAssertGreaterThan(tableNode.visibleNodes.count, 0);
+
+  // The rows in the preload range below them are materialized in the background.
+  NSIndexPath *lastVisible = [[tableNode indexPathsForVisibleRows] sortedArrayUsingSelector:@selector(compare:)].lastObject;
+  NSIndexPath *belowViewport = [NSIndexPath indexPathForRow:lastVisible.row + 2 inSection:0];
+  NSPredicate *preloaded = [NSPredicate predicateWithBlock:^BOOL(ASTableNode *tableNode, NSDictionary *bindings) {
+    return [tableNode nodeForRowAtIndexPath:belowViewport] != nil;
+  }];
+  [self expectationForPredicate:preloaded evaluatedWithObject:tableNode handler:nil];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertNil([tableNode nodeForRowAtIndexPath:[NSIndexPath indexPathForRow:9000 inSection:0]]);
+  XCTAssertLessThan(nodeBlockCount, 400);
+}
+
 - (void)testRelayoutVisibleRowsWhenEditingModeIsChanged
 {
   CGSize tableViewSize = CGSizeMake(100, 500);
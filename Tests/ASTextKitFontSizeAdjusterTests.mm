@@ -6,11 +6,92 @@
 //  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
 //
 
+#import <AsyncDisplayKit/ASLayoutManager.h>
+#import <AsyncDisplayKit/ASTextKitContext.h>
 #import <AsyncDisplayKit/ASTextKitFontSizeAdjuster.h>
 #import <XCTest/XCTest.h>
 
 #if AS_ENABLE_TEXTNODE
 
+/**
+ * The scale factor search before it bisected, laying out the text at each scale factor in order until it fits.
+ */
+static CGFloat ASLinearScaleFactor(NSAttributedString *string, CGSize constrainedSize, const ASTextKitAttributes &attributes)
+{
+  if (attributes.pointSizeScaleFactors.count == 0 || isinf(constrainedSize.width)) {
+    return 1.0;
+  }
+
+  NSArray *words = [string.string componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+  NSString *longestWord = @"";
+  for (NSString *word in words) {
+    if (word.length > longestWord.length) {
+      longestWord = word;
+    }
+  }
+  CGSize longestWordSize = CGSizeZero;
+  if (longestWord.length > 0) {
+    NSAttributedString *wordString = [string attributedSubstringFromRange:[string.string rangeOfString:longestWord]];
+    longestWordSize = [wordString boundingRectWithSize:CGSizeMake(CGFLOAT_MAX, CGFLOAT_MAX) options:NSStringDrawingUsesLineFragmentOrigin context:nil].size;
+  }
+
+  BOOL longestWordFits = longestWord.length == 0;
+  BOOL maxLinesFits = attributes.maximumNumberOfLines == 0;
+  BOOL heightFits = isinf(constrainedSize.height);
+  CGFloat adjustedScale = 1.0;
+  for (NSNumber *scaleFactor in [@[@(1)] arrayByAddingObjectsFromArray:attributes.pointSizeScaleFactors]) {
+    if (longestWordFits && maxLinesFits && heightFits) {
+      break;
+    }
+    adjustedScale = [scaleFactor floatValue];
+    if (!longestWordFits) {
+      longestWordFits = (longestWordSize.width * adjustedScale) <= constrainedSize.width;
+    }
+    if (!longestWordFits) {
+      continue;
+    }
+
+    NSMutableAttributedString *scaledString = [string mutableCopy];
+    [ASTextKitFontSizeAdjuster adjustFontSizeForAttributeString:scaledString withScaleFactor:adjustedScale];
+    NSTextStorage *textStorage = [[NSTextStorage alloc] initWithAttributedString:scaledString];
+    NSLayoutManager *layoutManager = [[ASLayoutManager alloc] init];
+    layoutManager.usesFontLeading = NO;
+    NSTextContainer *textContainer = [[NSTextContainer alloc] initWithSize:CGSizeMake(constrainedSize.width, CGFLOAT_MAX)];
+    textContainer.lineFragmentPadding = 0;
+    textContainer.lineBreakMode = attributes.lineBreakMode;
+    [layoutManager addTextContainer:textContainer];
+    [textStorage addLayoutManager:layoutManager];
+    [layoutManager ensureLayoutForTextContainer:textContainer];
+
+    if (!maxLinesFits) {
+      NSUInteger lineCount = 0;
+      for (NSRange lineRange = { 0, 0 }; NSMaxRange(lineRange) < [layoutManager numberOfGlyphs] && lineCount <= attributes.maximumNumberOfLines; lineCount++) {
+        [layoutManager lineFragmentRectForGlyphAtIndex:NSMaxRange(lineRange) effectiveRange:&lineRange];
+      }
+      maxLinesFits = lineCount <= attributes.maximumNumberOfLines;
+    }
+    if (maxLinesFits && !heightFits) {
+      CGRect textRect = [layoutManager boundingRectForGlyphRange:NSMakeRange(0, textStorage.length) inTextContainer:textContainer];
+      heightFits = textRect.size.height <= constrainedSize.height;
+    }
+  }
+  return adjustedScale;
+}
+
+static CGFloat ASAdjustedScaleFactor(NSAttributedString *string, CGSize constrainedSize, const ASTextKitAttributes &attributes)
+{
+  ASTextKitContext *context = [[ASTextKitContext alloc] initWithAttributedString:string
+                                                                       tintColor:nil
+                                                                   lineBreakMode:attributes.lineBreakMode
+                                                            maximumNumberOfLines:attributes.maximumNumberOfLines
+                                                                  exclusionPaths:attributes.exclusionPaths
+                                                                 constrainedSize:constrainedSize];
+  ASTextKitFontSizeAdjuster *adjuster = [[ASTextKitFontSizeAdjuster alloc] initWithContext:context
+                                                                           constrainedSize:constrainedSize
+                                                                         textKitAttributes:attributes];
+  return [adjuster scaleFactor];
+}
+
 @interface ASFontSizeAdjusterTests : XCTestCase
 
 @end
@@ -46,6 +127,53 @@
   XCTAssertEqual(adjustedParagraphStyle.maximumLineHeight, 7.0);
 }
 
+- (void)testScaleFactorMatchesLinearSearch
+{
+  NSArray<NSString *> *texts = @[
+    @"",
+    @"Hi",
+    @"Supercalifragilisticexpialidocious",
+    @"Lorem ipsum dolor sit amet, consectetur adipiscing elit",
+    @"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.",
+  ];
+  NSMutableArray<NSNumber *> *manyScaleFactors = [NSMutableArray array];
+  for (NSInteger i = 1; i < 60; i++) {
+    [manyScaleFactors addObject:@(1.0 - i * 0.0125)];
+  }
+  NSArray<NSArray<NSNumber *> *> *scaleFactorLists = @[
+    @[@0.9, @0.8, @0.7, @0.6, @0.5],
+    manyScaleFactors,
+    // Not descending, which is searched in order.
+    @[@0.5, @0.9, @0.7],
+  ];
+  NSArray<NSValue *> *sizes = @[
+    [NSValue valueWithCGSize:CGSizeMake(80, 30)],
+    [NSValue valueWithCGSize:CGSizeMake(200, 40)],
+    [NSValue valueWithCGSize:CGSizeMake(320, CGFLOAT_MAX)],
+    [NSValue valueWithCGSize:CGSizeMake(320, INFINITY)],
+  ];
+
+  for (NSString *text in texts) {
+    NSAttributedString *string = [[NSAttributedString alloc] initWithString:text attributes:@{ NSFontAttributeName: [UIFont systemFontOfSize:28] }];
+    for (NSArray<NSNumber *> *scaleFactors in scaleFactorLists) {
+      for (NSValue *size in sizes) {
+        for (NSUInteger maximumNumberOfLines : {0, 1, 2}) {
+          ASTextKitAttributes attributes {};
+          attributes.attributedString = string;
+          attributes.lineBreakMode = NSLineBreakByWordWrapping;
+          attributes.maximumNumberOfLines = maximumNumberOfLines;
+          attributes.pointSizeScaleFactors = scaleFactors;
+
+          const CGFloat expected = ASLinearScaleFactor(string, size.CGSizeValue, attributes);
+          XCTAssertEqual(ASAdjustedScaleFactor(string, size.CGSizeValue, attributes), expected, @"%@ in %@ with %lu lines", text, size, (unsigned long)maximumNumberOfLines);
+          // Measured again, the result comes from the cache.
+          XCTAssertEqual(ASAdjustedScaleFactor(string, size.CGSizeValue, attributes), expected);
+        }
+      }
+    }
+  }
+}
+
 @end
 
 #endif
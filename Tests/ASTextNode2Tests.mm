@@ -13,6 +13,8 @@
 #import <AsyncDisplayKit/ASDisplayNode+Beta.h>
 #import <AsyncDisplayKit/ASTextNode2.h>
 #import <AsyncDisplayKit/ASTextNode+Beta.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
 
 #import "ASTestCase.h"
 
@@ -130,4 +132,36 @@
   XCTAssertTrue(sizeWithEmptyString.width == 0);
 }
 
+- (void)testLayoutCacheHitsForEveryMeasuredWidth
+{
+  ASTextLayoutCacheRemoveAllLayouts();
+  NSAttributedString *text = [[NSAttributedString alloc] initWithString:[NSUUID UUID].UUIDString];
+
+  // Measure the same string at more widths than the old per-string cache could hold.
+  NSMutableArray<ASTextLayout *> *layouts = [NSMutableArray array];
+  for (CGFloat width = 50; width <= 300; width += 50) {
+    ASTextContainer *container = [ASTextContainer containerWithSize:CGSizeMake(width, CGFLOAT_MAX)];
+    [layouts addObject:ASTextLayoutCacheGetLayout(container, text)];
+  }
+
+  ASTextLayoutCacheStatistics before = ASConfiguration.textLayoutCacheStatistics;
+  NSUInteger i = 0;
+  for (CGFloat width = 50; width <= 300; width += 50) {
+    ASTextContainer *container = [ASTextContainer containerWithSize:CGSizeMake(width, CGFLOAT_MAX)];
+    XCTAssertEqual(ASTextLayoutCacheGetLayout(container, text), layouts[i++]);
+  }
+  ASTextLayoutCacheStatistics after = ASConfiguration.textLayoutCacheStatistics;
+  XCTAssertEqual(after.hitCount - before.hitCount, layouts.count);
+  XCTAssertEqual(after.missCount, before.missCount);
+}
+
+- (void)testLayoutCacheDoesNotMatchDifferentStringsWithEqualSizes
+{
+  ASTextContainer *container = [ASTextContainer containerWithSize:CGSizeMake(100, CGFLOAT_MAX)];
+  ASTextLayout *first = ASTextLayoutCacheGetLayout(container, [[NSAttributedString alloc] initWithString:@"first"]);
+  ASTextLayout *second = ASTextLayoutCacheGetLayout(container, [[NSAttributedString alloc] initWithString:@"second"]);
+  XCTAssertNotEqual(first, second);
+  XCTAssertEqualObjects(second.text.string, @"second");
+}
+
 @end
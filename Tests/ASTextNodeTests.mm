@@ -16,6 +16,7 @@
 #import <AsyncDisplayKit/ASLayout.h>
 #import <AsyncDisplayKit/ASTextNode.h>
 #import <AsyncDisplayKit/ASTextNode+Beta.h>
+#import <AsyncDisplayKit/ASTextKitRendererCache.h>
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
 
 #import "ASTestCase.h"
@@ -346,6 +347,39 @@
   exp = nil;
   [textNodeBucket removeAllObjects];
 }
+
+- (void)testRendererCacheCreatesEachRendererOnce
+{
+  ASTextKitAttributes attributes;
+  attributes.attributedString = [[NSAttributedString alloc] initWithString:[NSUUID UUID].UUIDString];
+  const CGSize constrainedSize = CGSizeMake(100, CGFLOAT_MAX);
+
+  NSUInteger missCount = 0;
+  NSUInteger hitCount = 0;
+  for (NSUInteger shard = 0; shard < ASConfiguration.textRendererCacheShardCount; shard++) {
+    ASTextRendererCacheStatistics statistics = [ASConfiguration textRendererCacheStatisticsForShard:shard];
+    missCount -= statistics.missCount;
+    hitCount -= statistics.hitCount + statistics.sharedMissCount;
+  }
+
+  NSMutableSet *renderers = [NSMutableSet set];
+  NSLock *lock = [[NSLock alloc] init];
+  dispatch_apply(20, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+    ASTextKitRenderer *renderer = ASTextKitRendererCacheGetRenderer(attributes, constrainedSize);
+    [lock lock];
+    [renderers addObject:renderer];
+    [lock unlock];
+  });
+
+  for (NSUInteger shard = 0; shard < ASConfiguration.textRendererCacheShardCount; shard++) {
+    ASTextRendererCacheStatistics statistics = [ASConfiguration textRendererCacheStatisticsForShard:shard];
+    missCount += statistics.missCount;
+    hitCount += statistics.hitCount + statistics.sharedMissCount;
+  }
+  XCTAssertEqual(renderers.count, 1);
+  XCTAssertEqual(missCount, 1);
+  XCTAssertEqual(hitCount, 19);
+}
 #endif
 
 @end
@@ -8,6 +8,11 @@
 
 #import "ASTestCase.h"
 #import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/_ASAsyncTransactionQueue.h>
+#import <algorithm>
+#import <atomic>
+#import <vector>
+#import <QuartzCore/QuartzCore.h>
 
 @interface ASTransactionTests : ASTestCase
 
@@ -81,4 +86,63 @@
   XCTAssertNil(weakTransaction);
 }
 
+- (void)testGroupRunsEveryOperationFromConcurrentProducers
+{
+  ASAsyncTransactionQueue::Group *group = ASAsyncTransactionQueue::instance().createGroup();
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  size_t const producerCount = 8;
+  size_t const operationsPerProducer = 1000;
+  // Blocks can't capture C++ atomics by reference, so capture a pointer.
+  std::atomic<size_t> executed(0);
+  std::atomic<size_t> *executedPtr = &executed;
+
+  dispatch_apply(producerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t producer) {
+    for (size_t i = 0; i < operationsPerProducer; i++) {
+      group->schedule(i % 3, queue, ^{
+        executedPtr->fetch_add(1);
+      });
+    }
+  });
+
+  XCTestExpectation *notified = [self expectationWithDescription:@"Group notified"];
+  group->notify(dispatch_get_main_queue(), ^{
+    [notified fulfill];
+  });
+  group->wait();
+  XCTAssertEqual(executed.load(), producerCount * operationsPerProducer);
+  [self waitForExpectationsWithTimeout:3 handler:nil];
+  group->release();
+}
+
+- (void)testSchedulingLatencyFromManyProducers
+{
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  size_t const operationsPerProducer = 2000;
+
+  for (size_t producerCount : {1, 2, 4, 8, 16}) {
+    ASAsyncTransactionQueue::Group *group = ASAsyncTransactionQueue::instance().createGroup();
+    size_t const operationCount = producerCount * operationsPerProducer;
+    // Time from schedule() to the start of the operation, one slot per operation. Negative until it ran.
+    std::vector<CFTimeInterval> latencies(operationCount, -1);
+    CFTimeInterval *latencyBuffer = latencies.data();
+
+    dispatch_apply(producerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t producer) {
+      for (size_t i = 0; i < operationsPerProducer; i++) {
+        size_t index = producer * operationsPerProducer + i;
+        CFTimeInterval scheduled = CACurrentMediaTime();
+        group->schedule(i % 2, queue, ^{
+          latencyBuffer[index] = CACurrentMediaTime() - scheduled;
+        });
+      }
+    });
+    group->wait();
+    group->release();
+
+    std::sort(latencies.begin(), latencies.end());
+    XCTAssertGreaterThanOrEqual(latencies.front(), 0, @"Not every operation ran with %zu producers", producerCount);
+    // Generous, so that it only fails if operations wait on each other instead of running as they are scheduled.
+    XCTAssertLessThan(latencies[(operationCount * 99) / 100], 0.5, @"p99 scheduling latency with %zu producers", producerCount);
+  }
+}
+
 @end
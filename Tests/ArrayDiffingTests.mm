@@ -308,4 +308,92 @@
     pending = @[];
   }
 }
+
+#pragma mark - Performance
+
+/**
+ * Builds a pair of arrays of `count` elements that differ by roughly 1% inserts, deletes and swaps, similar to a
+ * large batched reload.
+ */
+static void ASMakeDiffingBenchmarkArrays(NSUInteger count, NSArray **outOriginal, NSArray **outPending)
+{
+  NSMutableArray<NSNumber *> *original = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    [original addObject:@(i)];
+  }
+  NSMutableArray<NSNumber *> *pending = [original mutableCopy];
+  NSUInteger nextValue = count;
+  for (NSUInteger edit = 0; edit < count / 100; edit++) {
+    NSUInteger index = arc4random_uniform((uint32_t)pending.count);
+    switch (edit % 3) {
+      case 0:
+        [pending insertObject:@(nextValue++) atIndex:index];
+        break;
+      case 1:
+        [pending removeObjectAtIndex:index];
+        break;
+      default:
+        [pending exchangeObjectAtIndex:index withObjectAtIndex:arc4random_uniform((uint32_t)pending.count)];
+        break;
+    }
+  }
+  *outOriginal = original;
+  *outPending = pending;
+}
+
+- (void)testDiffingPerformanceWith10kElements
+{
+  NSArray *original, *pending;
+  ASMakeDiffingBenchmarkArrays(10000, &original, &pending);
+  [self measureBlock:^{
+    NSIndexSet *insertions, *deletions;
+    NSArray<NSIndexPath *> *moves;
+    [original asdk_diffWithArray:pending insertions:&insertions deletions:&deletions moves:&moves];
+  }];
+}
+
+- (void)testDiffingPerformanceWith100kElements
+{
+  NSArray *original, *pending;
+  ASMakeDiffingBenchmarkArrays(100000, &original, &pending);
+  [self measureBlock:^{
+    NSIndexSet *insertions, *deletions;
+    [original asdk_diffWithArray:pending insertions:&insertions deletions:&deletions];
+  }];
+}
+
+- (void)testDiffingLargeArraysProducesMinimalDiff
+{
+  // Delete every 97th element and insert a new one after every 89th, without reordering. The common
+  // subsequence is everything that was not deleted, so the edit distance is known exactly.
+  const NSUInteger count = 10000;
+  NSMutableArray<NSNumber *> *original = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray<NSNumber *> *pending = [NSMutableArray arrayWithCapacity:count];
+  NSUInteger expectedDeletions = 0, expectedInsertions = 0;
+  for (NSUInteger i = 0; i < count; i++) {
+    [original addObject:@(i)];
+    if (i % 97 == 0) {
+      expectedDeletions++;
+    } else {
+      [pending addObject:@(i)];
+    }
+    if (i % 89 == 0) {
+      [pending addObject:@(count + i)];
+      expectedInsertions++;
+    }
+  }
+
+  NSIndexSet *insertions, *deletions;
+  [original asdk_diffWithArray:pending insertions:&insertions deletions:&deletions];
+  XCTAssertEqual(deletions.count, expectedDeletions);
+  XCTAssertEqual(insertions.count, expectedInsertions);
+
+  // Applying the diff must leave exactly the common subsequence, in order.
+  NSMutableArray *remaining = [original mutableCopy];
+  [remaining removeObjectsAtIndexes:deletions];
+  NSMutableArray *pendingCommon = [pending mutableCopy];
+  [pendingCommon removeObjectsAtIndexes:insertions];
+  XCTAssertEqualObjects(remaining, pendingCommon);
+}
+
 @end
@@ -0,0 +1,238 @@
+//
+//  ASImageDownloadSchedulerBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Flings through a feed of image cells against a stand-in server, and reports how long visible cells stay blank and
+// how many bytes are thrown away, for downloads that all start right away and are dropped when their cell leaves the
+// preload range, like ASBasicImageDownloader did before, and for downloads run by the scheduler.
+//
+// The server has a fixed latency per download and a link whose bandwidth is shared by the running downloads. Time is
+// simulated in milliseconds, so the numbers are the same on every machine. See "./build.sh download-scheduling".
+//
+// Usage: ASImageDownloadSchedulerBenchmark [milliseconds per cell while flinging]
+
+#include "ASImageDownloadScheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace AS::DownloadScheduling;
+
+namespace {
+
+struct Feed {
+  int cellCount;
+  /** How many cells are visible at once. */
+  int visibleCells;
+  /** How many cells ahead of the visible ones are preloaded. */
+  int leadingCells;
+  /** How many cells behind the visible ones are preloaded. Further cells cancel their downloads. */
+  int trailingCells;
+};
+
+/** Flings over flingCells cells, rests, and flings again. */
+struct Scroll {
+  int flingCells;
+  int flingMillisecondsPerCell;
+  int restMilliseconds;
+
+  int firstVisibleCell(int time) const
+  {
+    const int cycle = flingCells * flingMillisecondsPerCell + restMilliseconds;
+    const int inCycle = std::min(time % cycle, flingCells * flingMillisecondsPerCell);
+    return time / cycle * flingCells + inCycle / flingMillisecondsPerCell;
+  }
+};
+
+struct Server {
+  int latencyMilliseconds;
+  double bytesPerMillisecond;
+  double bytesPerImage;
+};
+
+struct Strategy {
+  const char *name;
+  size_t maximumConcurrentDownloads;
+  bool prioritize;
+  bool keepPartialData;
+};
+
+struct Result {
+  double meanBlankMilliseconds;
+  int p95BlankMilliseconds;
+  double wastedMegabytes;
+  int loadedImages;
+};
+
+struct Download {
+  int startTime;
+  double bytesLeft;
+};
+
+std::string keyForCell(int cell)
+{
+  return std::to_string(cell);
+}
+
+Result simulate(const Feed &feed, const Scroll &scroll, const Server &server, const Strategy &strategy)
+{
+  Scheduler scheduler(strategy.maximumConcurrentDownloads);
+  std::map<std::string, Download> running;
+  // What the server would resume from, for downloads stopped with their partial data.
+  std::map<std::string, double> partialBytesLeft;
+  std::vector<RequestID> requests(feed.cellCount, 0);
+  std::vector<bool> loaded(feed.cellCount, false);
+  std::vector<int> blankMilliseconds(feed.cellCount, -1);
+  double wastedBytes = 0;
+  int loadedImages = 0;
+
+  int time = 0;
+  const auto stop = [&](const std::string &key, bool keepPartialData) {
+    const Download &download = running.at(key);
+    if (keepPartialData) {
+      partialBytesLeft[key] = download.bytesLeft;
+    } else {
+      wastedBytes += server.bytesPerImage - download.bytesLeft;
+    }
+    running.erase(key);
+  };
+  const auto apply = [&](const Actions &actions) {
+    for (const Action &action : actions) {
+      switch (action.type) {
+        case Action::Type::Start: {
+          const auto partial = partialBytesLeft.find(action.key);
+          running[action.key] = {time, partial != partialBytesLeft.end() ? partial->second : server.bytesPerImage};
+          if (partial != partialBytesLeft.end()) {
+            partialBytesLeft.erase(partial);
+          }
+          break;
+        }
+        case Action::Type::Suspend:
+          stop(action.key, true);
+          break;
+        case Action::Type::Cancel:
+          stop(action.key, false);
+          break;
+        case Action::Type::Reprioritize:
+          // The link is shared evenly, priorities only decide which downloads run.
+          break;
+      }
+    }
+  };
+
+  const int endTime = [&] {
+    int t = 0;
+    while (scroll.firstVisibleCell(t) + feed.visibleCells + feed.leadingCells < feed.cellCount) {
+      t++;
+    }
+    return t;
+  }();
+
+  int previousFirstVisible = -1;
+  for (; time < endTime; time++) {
+    const int firstVisible = scroll.firstVisibleCell(time);
+    if (firstVisible != previousFirstVisible) {
+      previousFirstVisible = firstVisible;
+      Actions actions;
+      const int preloadStart = std::max(firstVisible - feed.trailingCells, 0);
+      const int preloadEnd = std::min(firstVisible + feed.visibleCells + feed.leadingCells, feed.cellCount);
+      // Cells that left the preload range.
+      for (int cell = std::max(preloadStart - scroll.flingCells, 0); cell < preloadStart; cell++) {
+        if (requests[cell] != 0) {
+          scheduler.removeRequest(requests[cell], strategy.keepPartialData, actions);
+          requests[cell] = 0;
+        }
+      }
+      for (int cell = preloadStart; cell < preloadEnd; cell++) {
+        const bool visible = cell >= firstVisible && cell < firstVisible + feed.visibleCells;
+        const Priority priority = (visible && strategy.prioritize) ? Priority::Visible : Priority::Preload;
+        if (loaded[cell]) {
+          continue;
+        } else if (requests[cell] == 0) {
+          requests[cell] = scheduler.addRequest(keyForCell(cell), priority, actions);
+        } else {
+          scheduler.setPriority(requests[cell], priority, actions);
+        }
+      }
+      apply(actions);
+    }
+
+    for (int cell = firstVisible; cell < firstVisible + feed.visibleCells; cell++) {
+      blankMilliseconds[cell] = std::max(blankMilliseconds[cell], 0) + (loaded[cell] ? 0 : 1);
+    }
+
+    // Share the link between the downloads that are past their latency.
+    int transferring = 0;
+    for (const auto &entry : running) {
+      transferring += (time - entry.second.startTime >= server.latencyMilliseconds);
+    }
+    std::vector<std::string> finished;
+    for (auto &entry : running) {
+      if (time - entry.second.startTime >= server.latencyMilliseconds) {
+        entry.second.bytesLeft -= server.bytesPerMillisecond / transferring;
+        if (entry.second.bytesLeft <= 0) {
+          finished.push_back(entry.first);
+        }
+      }
+    }
+    for (const auto &key : finished) {
+      running.erase(key);
+      Actions actions;
+      scheduler.finishDownload(key, actions);
+      apply(actions);
+      const int cell = std::atoi(key.c_str());
+      loaded[cell] = true;
+      requests[cell] = 0;
+      loadedImages++;
+    }
+  }
+
+  std::vector<int> blanks;
+  for (int blank : blankMilliseconds) {
+    if (blank >= 0) {
+      blanks.push_back(blank);
+    }
+  }
+  std::sort(blanks.begin(), blanks.end());
+  double total = 0;
+  for (int blank : blanks) {
+    total += blank;
+  }
+  return {total / blanks.size(), blanks[blanks.size() * 95 / 100], wastedBytes / 1e6, loadedImages};
+}
+
+} // namespace
+
+int main(int argc, const char *argv[])
+{
+  const int flingMillisecondsPerCell = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 10;
+  const Feed feed = {2000, 4, 12, 4};
+  const Scroll scroll = {60, flingMillisecondsPerCell, 1500};
+  // 80 ms to the first byte, 4 MB/s, 150 KB thumbnails: one image alone takes about 120 ms.
+  const Server server = {80, 4000, 150000};
+
+  const Strategy strategies[] = {
+    {"Start right away, drop on exit", static_cast<size_t>(feed.cellCount), false, false},
+    {"6 at a time, FIFO", 6, false, true},
+    {"6 at a time, prioritized", 6, true, true},
+    {"12 at a time, prioritized", 12, true, true},
+  };
+
+  std::printf("Flinging over %d cells at %d ms per cell, resting %d ms\n", scroll.flingCells,
+              scroll.flingMillisecondsPerCell, scroll.restMilliseconds);
+  std::printf("%-32s %11s %11s %11s %8s\n", "", "mean blank", "p95 blank", "wasted", "loaded");
+  for (const Strategy &strategy : strategies) {
+    const Result result = simulate(feed, scroll, server, strategy);
+    std::printf("%-32s %8.1f ms %8d ms %8.1f MB %8d\n", strategy.name, result.meanBlankMilliseconds,
+                result.p95BlankMilliseconds, result.wastedMegabytes, result.loadedImages);
+  }
+  return 0;
+}
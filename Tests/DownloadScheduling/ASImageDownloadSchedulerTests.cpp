@@ -0,0 +1,308 @@
+//
+//  ASImageDownloadSchedulerTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the download scheduler, so that they run on any platform. See
+// "./build.sh download-scheduling".
+
+#include "ASImageDownloadScheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace AS::DownloadScheduling;
+
+static int failureCount = 0;
+
+#define ASDSAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+static Action start(const std::string &key, Priority priority)
+{
+  return {Action::Type::Start, key, priority};
+}
+
+static Action suspend(const std::string &key, Priority priority)
+{
+  return {Action::Type::Suspend, key, priority};
+}
+
+static Action cancel(const std::string &key, Priority priority)
+{
+  return {Action::Type::Cancel, key, priority};
+}
+
+static Action reprioritize(const std::string &key, Priority priority)
+{
+  return {Action::Type::Reprioritize, key, priority};
+}
+
+static void testRequestsForTheSameKeyShareADownload()
+{
+  Scheduler scheduler(4);
+  Actions actions;
+  const RequestID first = scheduler.addRequest("a", Priority::Preload, actions);
+  const RequestID second = scheduler.addRequest("a", Priority::Preload, actions);
+  ASDSAssert(first != 0 && second != 0 && first != second);
+  ASDSAssert((actions == Actions{start("a", Priority::Preload)}));
+  ASDSAssert(scheduler.statistics().coalesced == 1);
+
+  Actions finishActions;
+  ASDSAssert((scheduler.finishDownload("a", finishActions) == std::vector<RequestID>{first, second}));
+  ASDSAssert(finishActions.empty());
+  ASDSAssert(scheduler.runningCount() == 0);
+  // Late callbacks of finished downloads are ignored.
+  ASDSAssert(scheduler.finishDownload("a", finishActions).empty());
+}
+
+static void testConcurrencyIsBounded()
+{
+  Scheduler scheduler(2);
+  Actions actions;
+  for (const char *key : {"a", "b", "c", "d"}) {
+    scheduler.addRequest(key, Priority::Imminent, actions);
+  }
+  ASDSAssert(actions.size() == 2);
+  ASDSAssert(scheduler.runningCount() == 2);
+  ASDSAssert(scheduler.queuedCount() == 2);
+
+  Actions finishActions;
+  scheduler.finishDownload("a", finishActions);
+  ASDSAssert((finishActions == Actions{start("c", Priority::Imminent)}));
+  ASDSAssert(scheduler.isRunning("c") && !scheduler.isRunning("d"));
+}
+
+static void testHigherPrioritiesStartFirst()
+{
+  Scheduler scheduler(1);
+  Actions actions;
+  scheduler.addRequest("running", Priority::Imminent, actions);
+  scheduler.addRequest("preload", Priority::Preload, actions);
+  scheduler.addRequest("imminent", Priority::Imminent, actions);
+
+  Actions finishActions;
+  scheduler.finishDownload("running", finishActions);
+  ASDSAssert((finishActions == Actions{start("imminent", Priority::Imminent)}));
+}
+
+static void testVisibleRequestsPreemptPreloadDownloads()
+{
+  Scheduler scheduler(2);
+  Actions actions;
+  scheduler.addRequest("early", Priority::Preload, actions);
+  scheduler.addRequest("late", Priority::Preload, actions);
+  scheduler.addRequest("queued", Priority::Preload, actions);
+
+  Actions visibleActions;
+  scheduler.addRequest("visible", Priority::Visible, visibleActions);
+  // The latest preload download is suspended, and resumes before the ones queued after it.
+  ASDSAssert((visibleActions == Actions{suspend("late", Priority::Preload), start("visible", Priority::Visible)}));
+  ASDSAssert(scheduler.statistics().preempted == 1);
+
+  ASDSAssert(!scheduler.isRunning("late") && scheduler.hasDownload("late"));
+
+  Actions finishActions;
+  scheduler.finishDownload("visible", finishActions);
+  ASDSAssert((finishActions == Actions{start("late", Priority::Preload)}));
+
+  // Imminent requests wait for a slot.
+  Actions imminentActions;
+  scheduler.addRequest("imminent", Priority::Imminent, imminentActions);
+  ASDSAssert(imminentActions.empty());
+}
+
+static void testQueuedDownloadsCanFinish()
+{
+  Scheduler scheduler(1);
+  Actions actions;
+  const RequestID preload = scheduler.addRequest("preload", Priority::Preload, actions);
+  scheduler.addRequest("visible", Priority::Visible, actions);
+  ASDSAssert(!scheduler.isRunning("preload"));
+
+  // The transport finished the preload download before it was suspended.
+  Actions finishActions;
+  ASDSAssert((scheduler.finishDownload("preload", finishActions) == std::vector<RequestID>{preload}));
+  ASDSAssert(finishActions.empty());
+  ASDSAssert(!scheduler.hasDownload("preload") && scheduler.queuedCount() == 0);
+}
+
+static void testPriorityChangesMoveDownloads()
+{
+  Scheduler scheduler(1);
+  Actions actions;
+  const RequestID running = scheduler.addRequest("running", Priority::Imminent, actions);
+  scheduler.addRequest("first", Priority::Preload, actions);
+  const RequestID second = scheduler.addRequest("second", Priority::Preload, actions);
+
+  Actions raiseActions;
+  scheduler.setPriority(second, Priority::Imminent, raiseActions);
+  ASDSAssert(raiseActions.empty());
+  ASDSAssert(scheduler.priority("second") == Priority::Imminent);
+
+  Actions runningActions;
+  scheduler.setPriority(running, Priority::Visible, runningActions);
+  ASDSAssert((runningActions == Actions{reprioritize("running", Priority::Visible)}));
+
+  Actions finishActions;
+  scheduler.finishDownload("running", finishActions);
+  ASDSAssert((finishActions == Actions{start("second", Priority::Imminent)}));
+}
+
+static void testADownloadRunsAtItsHighestRequest()
+{
+  Scheduler scheduler(1);
+  Actions actions;
+  const RequestID preload = scheduler.addRequest("a", Priority::Preload, actions);
+  const RequestID visible = scheduler.addRequest("a", Priority::Visible, actions);
+  ASDSAssert((actions == Actions{start("a", Priority::Preload), reprioritize("a", Priority::Visible)}));
+
+  // Removing the visible request drops the download back to preload, but keeps it running.
+  Actions removeActions;
+  scheduler.removeRequest(visible, false, removeActions);
+  ASDSAssert((removeActions == Actions{reprioritize("a", Priority::Preload)}));
+  ASDSAssert(scheduler.isRunning("a"));
+
+  Actions finishActions;
+  ASDSAssert((scheduler.finishDownload("a", finishActions) == std::vector<RequestID>{preload}));
+}
+
+static void testRemovingTheLastRequestStopsTheDownload()
+{
+  Scheduler scheduler(1);
+  Actions actions;
+  const RequestID suspended = scheduler.addRequest("suspended", Priority::Visible, actions);
+  const RequestID queued = scheduler.addRequest("queued", Priority::Visible, actions);
+  const RequestID next = scheduler.addRequest("next", Priority::Visible, actions);
+
+  Actions removeQueuedActions;
+  scheduler.removeRequest(queued, true, removeQueuedActions);
+  ASDSAssert(removeQueuedActions.empty());
+
+  Actions suspendActions;
+  scheduler.removeRequest(suspended, true, suspendActions);
+  ASDSAssert((suspendActions == Actions{suspend("suspended", Priority::Visible), start("next", Priority::Visible)}));
+
+  Actions cancelActions;
+  scheduler.removeRequest(next, false, cancelActions);
+  ASDSAssert((cancelActions == Actions{cancel("next", Priority::Visible)}));
+  ASDSAssert(scheduler.runningCount() == 0 && scheduler.queuedCount() == 0);
+  ASDSAssert(scheduler.statistics().abandoned == 2);
+
+  // Unknown and removed requests are ignored.
+  Actions ignoredActions;
+  scheduler.removeRequest(next, false, ignoredActions);
+  scheduler.setPriority(12345, Priority::Visible, ignoredActions);
+  ASDSAssert(ignoredActions.empty());
+}
+
+/** Drives the scheduler like a transport would, and checks that every request completes once. */
+static void testRandomOperationsKeepTheInvariants()
+{
+  const size_t maximumConcurrentDownloads = 3;
+  Scheduler scheduler(maximumConcurrentDownloads);
+  std::mt19937 random(42);
+  std::map<RequestID, std::string> pending;
+  std::set<std::string> transportRunning;
+  uint64_t completed = 0, removed = 0;
+
+  const auto apply = [&](const Actions &actions) {
+    for (const Action &action : actions) {
+      switch (action.type) {
+        case Action::Type::Start:
+          ASDSAssert(transportRunning.insert(action.key).second);
+          break;
+        case Action::Type::Suspend:
+        case Action::Type::Cancel:
+          ASDSAssert(transportRunning.erase(action.key) == 1);
+          break;
+        case Action::Type::Reprioritize:
+          ASDSAssert(transportRunning.count(action.key) == 1);
+          break;
+      }
+    }
+  };
+
+  Actions actions;
+  for (int step = 0; step < 20000; step++) {
+    // Actions of several calls can be collected and performed together.
+    if (random() % 3 == 0) {
+      apply(actions);
+      actions.clear();
+    }
+    const unsigned operation = random() % 4;
+    if (operation == 0 || pending.empty()) {
+      const std::string key(1, static_cast<char>('a' + random() % 12));
+      const RequestID request = scheduler.addRequest(key, static_cast<Priority>(random() % kPriorityCount), actions);
+      ASDSAssert(pending.count(request) == 0);
+      pending[request] = key;
+    } else if (operation == 1) {
+      auto it = pending.begin();
+      std::advance(it, random() % pending.size());
+      scheduler.setPriority(it->first, static_cast<Priority>(random() % kPriorityCount), actions);
+    } else if (operation == 2) {
+      auto it = pending.begin();
+      std::advance(it, random() % pending.size());
+      scheduler.removeRequest(it->first, random() % 2, actions);
+      pending.erase(it);
+      removed++;
+    } else if (!transportRunning.empty()) {
+      // Only downloads the transport runs can finish.
+      apply(actions);
+      actions.clear();
+      auto it = transportRunning.begin();
+      std::advance(it, random() % transportRunning.size());
+      const std::string key = *it;
+      transportRunning.erase(it);
+      for (RequestID request : scheduler.finishDownload(key, actions)) {
+        ASDSAssert(pending.count(request) == 1 && pending[request] == key);
+        pending.erase(request);
+        completed++;
+      }
+    }
+
+    ASDSAssert(scheduler.runningCount() <= maximumConcurrentDownloads);
+    if (actions.empty()) {
+      ASDSAssert(scheduler.runningCount() == transportRunning.size());
+    }
+    ASDSAssert(scheduler.queuedCount() == 0 || scheduler.runningCount() == maximumConcurrentDownloads);
+  }
+
+  apply(actions);
+  ASDSAssert(scheduler.runningCount() == transportRunning.size());
+
+  const Statistics &statistics = scheduler.statistics();
+  ASDSAssert(statistics.requests == completed + removed + pending.size());
+  ASDSAssert(completed > 0 && statistics.preempted > 0 && statistics.coalesced > 0);
+}
+
+int main()
+{
+  testRequestsForTheSameKeyShareADownload();
+  testConcurrencyIsBounded();
+  testHigherPrioritiesStartFirst();
+  testVisibleRequestsPreemptPreloadDownloads();
+  testQueuedDownloadsCanFinish();
+  testPriorityChangesMoveDownloads();
+  testADownloadRunsAtItsHighestRequest();
+  testRemovingTheLastRequestStopsTheDownload();
+  testRandomOperationsKeepTheInvariants();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d download scheduling assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All download scheduling tests passed\n");
+  return 0;
+}
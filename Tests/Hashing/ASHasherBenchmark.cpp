@@ -0,0 +1,140 @@
+//
+//  ASHasherBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Hashes blobs of the sizes Texture's cache keys have, and fills hash tables with struct keys, both with the hashing
+// kernel and with the byte-at-a-time ELF hash that ASHashBytes used before. See "./build.sh hashing".
+//
+// Usage: ASHasherBenchmark [iterations]
+
+#include "ASHasher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+/** CoreFoundation's CFHashBytes, which ASHashBytes was a copy of. */
+uint64_t elfHash(const void *bytes, size_t length)
+{
+  const uint8_t *p = static_cast<const uint8_t *>(bytes);
+  uint32_t h = 0;
+  for (size_t i = 0; i < length; i++) {
+    uint32_t t1 = (h << 4) + p[i];
+    const uint32_t t2 = t1 & 0xF0000000;
+    if (t2) {
+      t1 ^= (t2 >> 24);
+    }
+    t1 &= ~t2;
+    h = t1;
+  }
+  return h;
+}
+
+// Keeps the compiler from dropping the hashing.
+volatile uint64_t gSink;
+
+template <typename HashFunction>
+double nanosecondsPerHash(HashFunction hash, const std::vector<uint8_t> &buffer, size_t length, size_t iterations)
+{
+  uint64_t sink = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    // Vary the start so that the hashes depend on each other less.
+    sink ^= hash(buffer.data() + (i & 63), length);
+  }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  gSink = sink;
+  return elapsed * 1e9 / iterations;
+}
+
+/** Like the text renderer keys: an attributes hash, a constrained size and a few options. */
+struct Key {
+  uint64_t attributesHash;
+  double width;
+  double height;
+  int32_t lineBreakMode;
+  // 4 bytes of padding, zeroed by the constructor.
+  Key(uint64_t attributesHash, double width, double height, int32_t lineBreakMode)
+  {
+    std::memset(this, 0, sizeof(*this));
+    this->attributesHash = attributesHash;
+    this->width = width;
+    this->height = height;
+    this->lineBreakMode = lineBreakMode;
+  }
+  bool operator==(const Key &other) const
+  {
+    return attributesHash == other.attributesHash && width == other.width && height == other.height
+        && lineBreakMode == other.lineBreakMode;
+  }
+};
+
+struct ELFKeyHash {
+  size_t operator()(const Key &key) const { return elfHash(&key, sizeof(key)); }
+};
+
+struct FieldsKeyHash {
+  size_t operator()(const Key &key) const
+  {
+    return AS::hashFields(key.attributesHash, key.width, key.height, key.lineBreakMode);
+  }
+};
+
+template <typename KeyHash>
+void benchmarkTable(const char *name, const std::vector<Key> &keys)
+{
+  const auto start = std::chrono::steady_clock::now();
+  std::unordered_set<Key, KeyHash> table(keys.begin(), keys.end());
+  size_t found = 0;
+  for (const Key &key : keys) {
+    found += table.count(key);
+  }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t longestChain = 0;
+  for (size_t bucket = 0; bucket < table.bucket_count(); bucket++) {
+    longestChain = std::max(longestChain, table.bucket_size(bucket));
+  }
+  std::printf("table %-12s: %8.1f ns per insert + lookup, longest bucket %zu (%zu found)\n", name,
+              elapsed * 1e9 / keys.size(), longestChain, found);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+  std::vector<uint8_t> buffer(4096 + 64);
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+  }
+  for (size_t length : {8, 16, 24, 32, 48, 72, 104, 256, 1024, 4096}) {
+    const size_t count = std::max<size_t>(iterations * 16 / length, 1000);
+    const double kernel = nanosecondsPerHash([](const void *p, size_t n) { return AS::hashBytes(p, n); }, buffer, length, count);
+    const double elf = nanosecondsPerHash(elfHash, buffer, length, count);
+    std::printf("%5zu bytes: hashBytes %7.2f ns (%5.2f GB/s), ELF %8.2f ns (%5.2f GB/s)\n", length, kernel,
+                length / kernel, elf, length / elf);
+  }
+
+  // Texts measured at a few widths, most of them by many cells: the ELF hash only keeps 28 bits and mixes the
+  // trailing bytes poorly.
+  std::vector<Key> keys;
+  for (uint64_t text = 0; text < iterations / 8; text++) {
+    for (double width : {320.0, 375.0, 414.0, 768.0}) {
+      keys.emplace_back(text * 0x9E3779B97F4A7C15ULL, width, 10000.0, 0);
+    }
+  }
+  benchmarkTable<ELFKeyHash>("ELF bytes", keys);
+  benchmarkTable<FieldsKeyHash>("hashFields", keys);
+  return 0;
+}
@@ -0,0 +1,250 @@
+//
+//  ASHasherTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the hashing kernel and the quality of its hashes, so that they run on any platform. See
+// "./build.sh hashing".
+
+#include "ASHasher.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+static int failureCount = 0;
+
+#define ASHAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+static int popcount(uint64_t value)
+{
+  return __builtin_popcountll(value);
+}
+
+/** The number of distinct hashes, which is the number of keys minus the collisions. */
+static size_t distinctCount(const std::vector<uint64_t> &hashes, uint64_t mask = ~0ULL)
+{
+  std::unordered_set<uint64_t> distinct;
+  for (uint64_t hash : hashes) {
+    distinct.insert(hash & mask);
+  }
+  return distinct.size();
+}
+
+/**
+ * The largest number of keys in one of 2^bits buckets picked by the low bits, which is what hash tables use. For
+ * random hashes and 4 keys per bucket on average, it stays below 20.
+ */
+static size_t maxBucketLoad(const std::vector<uint64_t> &hashes, int bits)
+{
+  std::vector<size_t> buckets(size_t(1) << bits);
+  for (uint64_t hash : hashes) {
+    buckets[hash & ((uint64_t(1) << bits) - 1)]++;
+  }
+  return *std::max_element(buckets.begin(), buckets.end());
+}
+
+static void testHashBytesIsDeterministicAndSeeded()
+{
+  const char *text = "The quick brown fox jumps over the lazy dog";
+  const size_t length = std::strlen(text);
+  ASHAssert(AS::hashBytes(text, length) == AS::hashBytes(std::string(text).data(), length));
+  ASHAssert(AS::hashBytes(text, length, 1) != AS::hashBytes(text, length, 2));
+  ASHAssert(AS::hashBytes(text, length) != AS::hashBytes(text, length - 1));
+}
+
+static void testEveryLengthHashesDifferently()
+{
+  // Zeros of each length, and prefixes of the same buffer, exercise each read pattern and the length mixing.
+  std::vector<uint8_t> zeros(300, 0);
+  std::vector<uint8_t> bytes(300);
+  for (size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<uint8_t>(i * 131 + 7);
+  }
+  std::vector<uint64_t> hashes = {AS::hashBytes(nullptr, 0)};
+  for (size_t length = 1; length <= bytes.size(); length++) {
+    hashes.push_back(AS::hashBytes(zeros.data(), length));
+    hashes.push_back(AS::hashBytes(bytes.data(), length));
+  }
+  ASHAssert(distinctCount(hashes) == hashes.size());
+}
+
+static void testEveryByteMatters()
+{
+  // Changing any single byte of inputs of each read pattern changes the hash.
+  for (size_t length : {1, 3, 4, 8, 15, 16, 17, 47, 48, 49, 97, 200}) {
+    std::vector<uint8_t> bytes(length, 0x5a);
+    const uint64_t hash = AS::hashBytes(bytes.data(), length);
+    for (size_t i = 0; i < length; i++) {
+      bytes[i] ^= 1;
+      ASHAssert(AS::hashBytes(bytes.data(), length) != hash);
+      bytes[i] ^= 1;
+    }
+  }
+}
+
+static void testAvalanche()
+{
+  // Flipping one input bit flips about half of the output bits, for each input bit and each read pattern.
+  std::mt19937_64 random(11);
+  for (size_t length : {4, 8, 12, 16, 24, 32, 64, 100}) {
+    double totalFlipped = 0;
+    int samples = 0;
+    int worstBit = 64;
+    for (int trial = 0; trial < 50; trial++) {
+      std::vector<uint8_t> bytes(length);
+      for (auto &byte : bytes) {
+        byte = static_cast<uint8_t>(random());
+      }
+      const uint64_t hash = AS::hashBytes(bytes.data(), length);
+      for (size_t bit = 0; bit < length * 8; bit++) {
+        bytes[bit / 8] ^= (1 << (bit % 8));
+        const int flipped = popcount(hash ^ AS::hashBytes(bytes.data(), length));
+        bytes[bit / 8] ^= (1 << (bit % 8));
+        totalFlipped += flipped;
+        samples++;
+        worstBit = std::min(worstBit, flipped);
+      }
+    }
+    const double average = totalFlipped / samples;
+    ASHAssert(average > 31 && average < 33);
+    ASHAssert(worstBit > 8);
+  }
+}
+
+static void testSequentialIntegersDontCollide()
+{
+  // Dense integer keys, like indexes and enum combinations, are the usual worst case of weak hashes.
+  const size_t count = 1 << 20;
+  std::vector<uint64_t> bytesHashes;
+  std::vector<uint64_t> fieldHashes;
+  for (uint64_t i = 0; i < count; i++) {
+    bytesHashes.push_back(AS::hashBytes(&i, sizeof(i)));
+    fieldHashes.push_back(AS::hashFields(i));
+  }
+  ASHAssert(distinctCount(bytesHashes) == count);
+  ASHAssert(distinctCount(fieldHashes) == count);
+  // 2^32 buckets: random hashes have about count^2 / 2^33 = 128 collisions.
+  ASHAssert(count - distinctCount(bytesHashes, 0xFFFFFFFF) < 200);
+  ASHAssert(count - distinctCount(fieldHashes, 0xFFFFFFFF) < 200);
+  ASHAssert(maxBucketLoad(bytesHashes, 18) < 20);
+  ASHAssert(maxBucketLoad(fieldHashes, 18) < 20);
+}
+
+static void testSimilarStringsDontCollide()
+{
+  const size_t count = 1 << 18;
+  std::vector<uint64_t> hashes;
+  for (size_t i = 0; i < count; i++) {
+    const std::string key = "ASCellNode-section-" + std::to_string(i % 64) + "-item-" + std::to_string(i / 64);
+    hashes.push_back(AS::hashBytes(key.data(), key.size()));
+  }
+  ASHAssert(distinctCount(hashes) == count);
+  ASHAssert(maxBucketLoad(hashes, 16) < 20);
+}
+
+static void testSizesDontCollide()
+{
+  // Layout keys: sizes on a half point grid, like the constrained sizes of text and cells.
+  std::vector<uint64_t> hashes;
+  for (int width = 0; width < 1024; width++) {
+    for (int height = 0; height < 256; height++) {
+      hashes.push_back(AS::hashFields(width / 2.0, height / 2.0));
+    }
+  }
+  ASHAssert(distinctCount(hashes) == hashes.size());
+  ASHAssert(maxBucketLoad(hashes, 16) < 20);
+}
+
+struct PaddedKey {
+  uint8_t flag;
+  // 7 bytes of padding on 64-bit platforms.
+  double value;
+  uint16_t count;
+};
+
+static void testHashFieldsIgnoresPadding()
+{
+  PaddedKey a;
+  PaddedKey b;
+  std::memset(&a, 0x00, sizeof(a));
+  std::memset(&b, 0xFF, sizeof(b));
+  a.flag = b.flag = 1;
+  a.value = b.value = 2.5;
+  a.count = b.count = 3;
+  ASHAssert(AS::hashFields(a.flag, a.value, a.count) == AS::hashFields(b.flag, b.value, b.count));
+  // Which the bytes don't.
+  ASHAssert(AS::hashBytes(&a, sizeof(a)) != AS::hashBytes(&b, sizeof(b)));
+}
+
+static void testHashFieldsTreatsEqualValuesAlike()
+{
+  ASHAssert(AS::hashFields(0.0) == AS::hashFields(-0.0));
+  ASHAssert(AS::hashFields(1.5f) == AS::hashFields(1.5));
+  ASHAssert(AS::hashFields(uint8_t(7)) == AS::hashFields(uint64_t(7)));
+  enum Unit { Points = 1 };
+  ASHAssert(AS::hashFields(Points) == AS::hashFields(1));
+  int value = 0;
+  ASHAssert(AS::hashFields(&value) == AS::hashFields(&value));
+  ASHAssert(AS::hashFields(static_cast<int *>(nullptr)) == AS::hashFields(nullptr));
+}
+
+static void testHashFieldsDependsOnOrderAndCount()
+{
+  ASHAssert(AS::hashFields(1, 2) != AS::hashFields(2, 1));
+  ASHAssert(AS::hashFields(1, 0) != AS::hashFields(0, 1));
+  ASHAssert(AS::hashFields(0) != AS::hashFields(0, 0));
+  ASHAssert(AS::hashFields() != AS::hashFields(0));
+  ASHAssert(AS::Hash<int>()(5) == AS::Hasher().add(5).finish());
+}
+
+static void testMixWithoutInt128MatchesInt128()
+{
+  std::mt19937_64 random(3);
+  const uint64_t edges[] = {0, 1, 0xFFFFFFFFULL, 0x100000000ULL, ~0ULL, ~0ULL - 1};
+  for (uint64_t a : edges) {
+    for (uint64_t b : edges) {
+      ASHAssert(AS::hashMix(a, b) == AS::hashMixWithoutInt128(a, b));
+    }
+  }
+  for (int i = 0; i < 100000; i++) {
+    const uint64_t a = random();
+    const uint64_t b = random();
+    ASHAssert(AS::hashMix(a, b) == AS::hashMixWithoutInt128(a, b));
+  }
+}
+
+int main()
+{
+  testHashBytesIsDeterministicAndSeeded();
+  testEveryLengthHashesDifferently();
+  testEveryByteMatters();
+  testAvalanche();
+  testSequentialIntegersDontCollide();
+  testSimilarStringsDontCollide();
+  testSizesDontCollide();
+  testHashFieldsIgnoresPadding();
+  testHashFieldsTreatsEqualValuesAlike();
+  testHashFieldsDependsOnOrderAndCount();
+  testMixWithoutInt128MatchesInt128();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d hashing assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All hashing tests passed\n");
+  return 0;
+}
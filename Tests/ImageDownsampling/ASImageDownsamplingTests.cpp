@@ -0,0 +1,138 @@
+//
+//  ASImageDownsamplingTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the image downsampling math, so that they run on any platform. See
+// "./build.sh image-downsampling".
+
+#include "ASImageDownsampling.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace AS::ImageDownsampling;
+
+static int failureCount = 0;
+
+#define ASIDAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+static const PixelSize kPhoto = {4000, 3000};
+
+static void testTargetPixelSize()
+{
+  ASIDAssert((targetPixelSize(100, 100, 3) == PixelSize{300, 300}));
+  // Partial pixels are rounded up, floating point noise is not.
+  ASIDAssert((targetPixelSize(100.2, 50, 2) == PixelSize{201, 100}));
+  ASIDAssert((targetPixelSize(1.0 / 3.0, 1.0 / 3.0, 3) == PixelSize{1, 1}));
+  // A crop rect that features the right half of the image scales it up twice as much horizontally.
+  ASIDAssert((targetPixelSize(100, 100, 2, 0.5, 1) == PixelSize{400, 200}));
+  ASIDAssert((targetPixelSize(100, 100, 2, 0, 0) == PixelSize{200, 200}));
+  ASIDAssert(targetPixelSize(0, 100, 2).isEmpty());
+  ASIDAssert(targetPixelSize(100, 100, 0).isEmpty());
+}
+
+static void testAspectFillCoversTheTarget()
+{
+  // The 100 pt thumbnail of a 4000 x 3000 photo at 3x: 48 MB decoded at full size, 480 KB decoded to fill.
+  const PixelSize decoded = decodedPixelSize(kPhoto, {300, 300}, ContentMode::ScaleAspectFill);
+  ASIDAssert((decoded == PixelSize{400, 300}));
+  ASIDAssert(decodedByteCount(kPhoto) == 48000000);
+  ASIDAssert(decodedByteCount(decoded) == 480000);
+  ASIDAssert(maxPixelSize(decoded) == 400);
+}
+
+static void testAspectFitReachesTheTargetOnOneSide()
+{
+  ASIDAssert((decodedPixelSize(kPhoto, {300, 300}, ContentMode::ScaleAspectFit) == PixelSize{300, 225}));
+  ASIDAssert((decodedPixelSize({3000, 4000}, {300, 300}, ContentMode::ScaleAspectFit) == PixelSize{225, 300}));
+}
+
+static void testScaleToFillCoversBothSides()
+{
+  // Stretching to a wide target needs the full width, and more height than the target.
+  ASIDAssert((decodedPixelSize(kPhoto, {800, 100}, ContentMode::ScaleToFill) == PixelSize{800, 600}));
+}
+
+static void testSidesAreRoundedUp()
+{
+  // 1000 x 333 scaled by 0.3 is 300 x 99.9.
+  ASIDAssert((decodedPixelSize({1000, 333}, {300, 10}, ContentMode::ScaleAspectFill) == PixelSize{300, 100}));
+  // Extreme aspect ratios keep at least a pixel.
+  ASIDAssert((decodedPixelSize({10000, 1}, {10, 10}, ContentMode::ScaleAspectFit) == PixelSize{10, 1}));
+}
+
+static void testNeverUpscales()
+{
+  const PixelSize small = {200, 100};
+  ASIDAssert(decodedPixelSize(small, {300, 300}, ContentMode::ScaleAspectFill) == small);
+  ASIDAssert(decodedPixelSize(small, {300, 300}, ContentMode::ScaleAspectFit) == small);
+  ASIDAssert(decodedPixelSize(small, {200, 100}, ContentMode::ScaleToFill) == small);
+  // Filling a tall target needs the full height.
+  ASIDAssert(decodedPixelSize(kPhoto, {100, 3000}, ContentMode::ScaleAspectFill) == kPhoto);
+}
+
+static void testUnknownTargetsAndUnscaledModesDecodeAtFullSize()
+{
+  ASIDAssert(decodedPixelSize(kPhoto, {0, 0}, ContentMode::ScaleAspectFill) == kPhoto);
+  ASIDAssert(decodedPixelSize(kPhoto, {300, 300}, ContentMode::Unscaled) == kPhoto);
+  ASIDAssert((decodedPixelSize({0, 0}, {300, 300}, ContentMode::ScaleAspectFill) == PixelSize{0, 0}));
+}
+
+static void testDecodedSizeIsMonotonicInTheTarget()
+{
+  PixelSize previous = {0, 0};
+  for (uint32_t side = 1; side <= 5000; side++) {
+    const PixelSize decoded = decodedPixelSize(kPhoto, {side, side}, ContentMode::ScaleAspectFill);
+    ASIDAssert(decoded.width >= previous.width && decoded.height >= previous.height);
+    ASIDAssert(decoded.width >= std::min(side, kPhoto.width) && decoded.height >= std::min(side, kPhoto.height));
+    previous = decoded;
+  }
+}
+
+static void testBucketsShareVariantsAndWasteLittle()
+{
+  ASIDAssert((bucketedTargetSize({0, 0}) == PixelSize{0, 0}));
+  ASIDAssert((bucketedTargetSize({300, 298}) == PixelSize{320, 320}));
+  ASIDAssert((bucketedTargetSize({1, 128}) == PixelSize{16, 128}));
+
+  uint32_t previous = 0;
+  for (uint32_t side = 1; side <= 20000; side++) {
+    const uint32_t bucketed = bucketedTargetSize({side, side}).width;
+    ASIDAssert(bucketed >= side);
+    ASIDAssert(bucketed >= previous);
+    ASIDAssert(side <= 128 || bucketed * 8 <= side * 9);
+    // Bucketing a bucket doesn't move it.
+    ASIDAssert(bucketedTargetSize({bucketed, bucketed}).width == bucketed);
+    previous = bucketed;
+  }
+}
+
+int main()
+{
+  testTargetPixelSize();
+  testAspectFillCoversTheTarget();
+  testAspectFitReachesTheTargetOnOneSide();
+  testScaleToFillCoversBothSides();
+  testSidesAreRoundedUp();
+  testNeverUpscales();
+  testUnknownTargetsAndUnscaledModesDecodeAtFullSize();
+  testDecodedSizeIsMonotonicInTheTarget();
+  testBucketsShareVariantsAndWasteLittle();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d image downsampling assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All image downsampling tests passed\n");
+  return 0;
+}
@@ -0,0 +1,218 @@
+//
+//  ASLayoutCoreBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Lays out feed-like trees with the layout core and reports the time and the number of heap allocations per node, both
+// for Layout trees and for a reused LayoutArena. Runs on any platform, so that changes to the layout math can be
+// measured without a device. See "./build.sh layout-core".
+//
+// Usage: ASLayoutCoreBenchmark [iterations]
+
+#include "ASLayoutCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+using namespace AS::LayoutCore;
+
+// Counts every heap allocation made through operator new, which is what the layout core allocates with.
+static size_t gAllocationCount = 0;
+
+void *operator new(size_t size)
+{
+  gAllocationCount++;
+  if (void *pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  std::abort();
+}
+
+void operator delete(void *pointer) noexcept
+{
+  std::free(pointer);
+}
+
+namespace {
+
+/** Approximates a text node with 7pt wide glyphs and 18pt lines, wrapping at the max width. */
+Size measureText(const Node &node, const Size &maxSize, void *context)
+{
+  const double length = static_cast<double>(reinterpret_cast<size_t>(context));
+  const double glyphsPerLine = std::max(1.0, std::floor(maxSize.width / 7));
+  const double lines = std::ceil(length / glyphsPerLine);
+  return {std::min(length, glyphsPerLine) * 7, lines * 18};
+}
+
+/** Owns the nodes of a tree, nodes only point at each other. */
+struct Tree {
+  std::deque<Node> nodes;
+  const Node *root;
+
+  Node *add(NodeType type)
+  {
+    nodes.emplace_back();
+    nodes.back().type = type;
+    return &nodes.back();
+  }
+
+  Node *text(size_t length)
+  {
+    Node *node = add(NodeType::Leaf);
+    node->measure = measureText;
+    node->context = reinterpret_cast<void *>(length);
+    node->style.flexShrink = 1;
+    return node;
+  }
+};
+
+/**
+ * A vertical stack of cells, each an inset horizontal stack of a square avatar and a column of a title, a body and an
+ * action row.
+ */
+Tree makeFeed(size_t cellCount)
+{
+  Tree tree;
+  Node *feed = tree.add(NodeType::Stack);
+  feed->stack.direction = StackDirection::Vertical;
+  feed->stack.spacing = 1;
+
+  for (size_t i = 0; i < cellCount; i++) {
+    Node *avatar = tree.add(NodeType::Leaf);
+    avatar->style.size.width = points(44);
+    Node *avatarRatio = tree.add(NodeType::Ratio);
+    avatarRatio->children = {avatar};
+
+    Node *like = tree.add(NodeType::Leaf);
+    like->style.size.width = points(24);
+    like->style.size.height = points(24);
+    Node *likeCount = tree.text(3 + i % 4);
+    Node *spacer = tree.add(NodeType::Leaf);
+    spacer->style.flexGrow = 1;
+    spacer->style.size.height = points(1);
+    Node *share = tree.add(NodeType::Leaf);
+    share->style.size.width = points(24);
+    share->style.size.height = points(24);
+    Node *actions = tree.add(NodeType::Stack);
+    actions->stack.spacing = 8;
+    actions->stack.alignItems = StackAlignItems::Center;
+    actions->children = {like, likeCount, spacer, share};
+
+    Node *column = tree.add(NodeType::Stack);
+    column->stack.direction = StackDirection::Vertical;
+    column->stack.spacing = 4;
+    column->style.flexShrink = 1;
+    column->style.flexGrow = 1;
+    column->children = {tree.text(12 + i % 20), tree.text(40 + (i * 37) % 200), actions};
+
+    Node *row = tree.add(NodeType::Stack);
+    row->stack.spacing = 10;
+    row->stack.alignItems = StackAlignItems::Start;
+    row->children = {avatarRatio, column};
+
+    Node *badge = tree.add(NodeType::Leaf);
+    badge->style.size.width = points(8);
+    badge->style.size.height = points(8);
+    Node *badgeCorner = tree.add(NodeType::Relative);
+    badgeCorner->horizontalPosition = RelativePosition::End;
+    badgeCorner->verticalPosition = RelativePosition::Start;
+    badgeCorner->children = {badge};
+
+    Node *content = tree.add(NodeType::Stack);
+    content->stack.direction = StackDirection::Vertical;
+    content->children = {badgeCorner, row};
+
+    Node *cell = tree.add(NodeType::Inset);
+    cell->insets = {12, 16, 12, 16};
+    cell->children = {content};
+    feed->children.push_back(cell);
+  }
+
+  tree.root = feed;
+  return tree;
+}
+
+size_t countLayouts(const Layout &layout)
+{
+  size_t count = 1;
+  for (const auto &sublayout : layout.sublayouts) {
+    count += countLayouts(sublayout);
+  }
+  return count;
+}
+
+size_t countFrames(const LayoutArena &arena, const Frame &frame)
+{
+  size_t count = 1;
+  for (const Frame *child = arena.childrenBegin(frame); child != arena.childrenEnd(frame); child++) {
+    count += countFrames(arena, *child);
+  }
+  return count;
+}
+
+void report(const char *name, size_t cellCount, size_t iterations, size_t nodeCount, size_t allocations,
+            double elapsed, double checksum)
+{
+  std::printf("%5zu cells, %-6s: %8.1f ns per node, %10.1f us per layout, %6.2f allocations per node (checksum %.0f)\n",
+              cellCount, name, elapsed * 1e9 / nodeCount, elapsed * 1e6 / iterations,
+              static_cast<double>(allocations) / nodeCount, checksum);
+}
+
+void benchmark(size_t cellCount, size_t iterations)
+{
+  const Tree tree = makeFeed(cellCount);
+  const double widths[] = {320, 375, 414};
+
+  {
+    size_t nodeCount = 0;
+    double checksum = 0;
+    const size_t allocationCount = gAllocationCount;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      const double width = widths[i % 3];
+      const Layout layout = AS::LayoutCore::layout(*tree.root, {{width, 0}, {width, kInfinity}}, 2);
+      nodeCount += countLayouts(layout);
+      checksum += layout.size.height;
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("tree", cellCount, iterations, nodeCount, gAllocationCount - allocationCount, elapsed, checksum);
+  }
+
+  {
+    // Like a layout thread, reuse one arena for every pass.
+    LayoutArena arena;
+    size_t nodeCount = 0;
+    double checksum = 0;
+    const size_t allocationCount = gAllocationCount;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      const double width = widths[i % 3];
+      const Frame &root = AS::LayoutCore::layout(arena, *tree.root, {{width, 0}, {width, kInfinity}}, 2);
+      nodeCount += countFrames(arena, root);
+      checksum += root.size.height;
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("arena", cellCount, iterations, nodeCount, gAllocationCount - allocationCount, elapsed, checksum);
+  }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+  const size_t cellCounts[] = {1, 10, 100, 1000};
+  for (size_t cellCount : cellCounts) {
+    // Keep the number of laid out cells per run roughly constant.
+    benchmark(cellCount, std::max<size_t>(iterations * 10 / cellCount, 3));
+  }
+  return 0;
+}
@@ -0,0 +1,380 @@
+//
+//  ASLayoutCoreTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the layout core, so that they run on any platform. See "./build.sh layout-core".
+
+#include "ASLayoutCore.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace AS::LayoutCore;
+
+static int failureCount = 0;
+
+#define ASLCAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+#define ASLCAssertEqualSizes(size, w, h) ASLCAssert((size).width == (w) && (size).height == (h))
+#define ASLCAssertEqualPoints(point, px, py) ASLCAssert((point).x == (px) && (point).y == (py))
+
+static const SizeRange kRange200x100 = {{0, 0}, {200, 100}};
+
+static Node leaf(double width, double height)
+{
+  Node node;
+  node.style.size.width = points(width);
+  node.style.size.height = points(height);
+  return node;
+}
+
+static Size measureFixedSize(const Node &node, const Size &maxSize, void *context)
+{
+  return *static_cast<Size *>(context);
+}
+
+static Node stack(StackDirection direction, const std::vector<const Node *> &children)
+{
+  Node node;
+  node.type = NodeType::Stack;
+  node.stack.direction = direction;
+  node.children = children;
+  return node;
+}
+
+#pragma mark - Values
+
+static void testIntersect()
+{
+  const SizeRange overlapping = intersect({{0, 0}, {100, 100}}, {{50, 50}, {200, 200}});
+  ASLCAssert(overlapping == (SizeRange{{50, 50}, {100, 100}}));
+
+  // Without overlap, the first range wins with its point closest to the other range.
+  const SizeRange before = intersect({{0, 0}, {10, 10}}, {{20, 20}, {30, 30}});
+  ASLCAssert(before == (SizeRange{{10, 10}, {10, 10}}));
+  const SizeRange after = intersect({{20, 20}, {30, 30}}, {{0, 0}, {10, 10}});
+  ASLCAssert(after == (SizeRange{{20, 20}, {20, 20}}));
+}
+
+static void testResolveElementSize()
+{
+  ElementSize size;
+  size.width = points(100);
+  size.minWidth = points(150);
+  size.height = fraction(0.5);
+  const SizeRange range = resolve(size, {kUndefined, 200});
+
+  // Min overrides exact.
+  ASLCAssertEqualSizes(range.min, 150, 100);
+  ASLCAssertEqualSizes(range.max, 150, 100);
+
+  // Unset dimensions are unconstrained.
+  const SizeRange autoRange = resolve(ElementSize(), {100, 100});
+  ASLCAssert(autoRange == kSizeRangeUnconstrained);
+}
+
+static void testPixelRounding()
+{
+  ASLCAssert(floorPixelValue(10.3, 2) == 10);
+  ASLCAssert(floorPixelValue(10.6, 2) == 10.5);
+  ASLCAssert(roundPixelValue(39.5, 1) == 40);
+  ASLCAssert(roundPixelValue(39.5, 2) == 39.5);
+  ASLCAssert(isValidForSize(0) && isValidForSize(100));
+  ASLCAssert(!isValidForSize(kInfinity) && !isValidForSize(-1) && !isValidForSize(kUndefined));
+}
+
+#pragma mark - Layout Specs
+
+static void testInset()
+{
+  const Node child = leaf(50, 50);
+  Node inset;
+  inset.type = NodeType::Inset;
+  inset.insets = {10, 20, 30, 40};
+  inset.children = {&child};
+
+  const Layout layout = AS::LayoutCore::layout(inset, kRange200x100, 2);
+  ASLCAssertEqualSizes(layout.size, 110, 90);
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 50, 50);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 20, 10);
+}
+
+static void testInfiniteInsetsCenterTheChild()
+{
+  const Node child = leaf(50, 50);
+  Node inset;
+  inset.type = NodeType::Inset;
+  inset.insets = {0, kInfinity, 0, kInfinity};
+  inset.children = {&child};
+
+  const Layout layout = AS::LayoutCore::layout(inset, {{100, 100}, {100, 100}}, 2);
+  ASLCAssertEqualSizes(layout.size, 100, 100);
+  // The child is intrinsic horizontally, but has to fill the exact height.
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 50, 100);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 25, 0);
+}
+
+static void testRatio()
+{
+  const Node child;
+  Node ratio;
+  ratio.type = NodeType::Ratio;
+  ratio.ratio = 0.5;
+  ratio.children = {&child};
+
+  const Layout layout = AS::LayoutCore::layout(ratio, {{0, 0}, {100, kInfinity}}, 2);
+  ASLCAssertEqualSizes(layout.size, 100, 50);
+
+  // Of the two options, the one closer to the ratio wins.
+  Size childSize;
+  ASLCAssert(ratioChildSize({{0, 0}, {100, 100}}, 2, 2, childSize));
+  ASLCAssertEqualSizes(childSize, 50, 100);
+  ASLCAssert(!ratioChildSize(kSizeRangeUnconstrained, 2, 2, childSize));
+}
+
+static void testRelative()
+{
+  const Node child = leaf(50, 21);
+  Node relative;
+  relative.type = NodeType::Relative;
+  relative.horizontalPosition = RelativePosition::End;
+  relative.verticalPosition = RelativePosition::Center;
+  relative.children = {&child};
+
+  Layout layout = AS::LayoutCore::layout(relative, kRange200x100, 2);
+  ASLCAssertEqualSizes(layout.size, 200, 100);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 150, 39.5);
+
+  layout = AS::LayoutCore::layout(relative, kRange200x100, 1);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 150, 40);
+
+  relative.sizingOptions = RelativeSizingMinimumWidth | RelativeSizingMinimumHeight;
+  layout = AS::LayoutCore::layout(relative, kRange200x100, 2);
+  ASLCAssertEqualSizes(layout.size, 50, 21);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 0, 0);
+}
+
+#pragma mark - Stack
+
+static void testStackJustifyAndAlignCenter()
+{
+  const Node first = leaf(50, 20);
+  const Node second = leaf(30, 40);
+  Node node = stack(StackDirection::Horizontal, {&first, &second});
+  node.stack.spacing = 10;
+  node.stack.justifyContent = StackJustifyContent::Center;
+  node.stack.alignItems = StackAlignItems::Center;
+
+  const Layout layout = AS::LayoutCore::layout(node, {{200, 0}, {200, 100}}, 2);
+  ASLCAssertEqualSizes(layout.size, 200, 40);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 55, 10);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 115, 0);
+}
+
+static void testStackFlexShrink()
+{
+  Node first = leaf(90, 10);
+  Node second = leaf(30, 10);
+  first.style.flexShrink = 1;
+  second.style.flexShrink = 1;
+  Node node = stack(StackDirection::Horizontal, {&first, &second});
+  node.stack.alignItems = StackAlignItems::Start;
+
+  // Larger children shrink more.
+  const Layout layout = AS::LayoutCore::layout(node, {{100, 0}, {100, 100}}, 2);
+  ASLCAssertEqualSizes(layout.size, 100, 10);
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 75, 10);
+  ASLCAssertEqualSizes(layout.sublayouts[1].size, 25, 10);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 75, 0);
+}
+
+static void testStackFlexGrowGivesRemainderToFirstFlexibleChild()
+{
+  Node first = leaf(10, 10);
+  Node second = leaf(10, 10);
+  first.style.flexGrow = 1;
+  second.style.flexGrow = 2;
+  Node node = stack(StackDirection::Horizontal, {&first, &second});
+  node.stack.alignItems = StackAlignItems::Start;
+
+  // 80 points are distributed as floor(80 / 3) and floor(160 / 3), the leftover point goes to the first child.
+  const Layout layout = AS::LayoutCore::layout(node, {{100, 0}, {100, 100}}, 2);
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 37, 10);
+  ASLCAssertEqualSizes(layout.sublayouts[1].size, 63, 10);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 37, 0);
+}
+
+static void testStackWrapsIntoLines()
+{
+  const Node child = leaf(40, 10);
+  Node node = stack(StackDirection::Horizontal, {&child, &child, &child, &child});
+  node.stack.alignItems = StackAlignItems::Start;
+  node.stack.flexWrap = StackFlexWrap::Wrap;
+  node.stack.lineSpacing = 5;
+
+  Layout layout = AS::LayoutCore::layout(node, {{0, 0}, {100, kInfinity}}, 2);
+  ASLCAssertEqualSizes(layout.size, 80, 25);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 0, 0);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 40, 0);
+  ASLCAssertEqualPoints(layout.sublayouts[2].position, 0, 15);
+  ASLCAssertEqualPoints(layout.sublayouts[3].position, 40, 15);
+
+  node.stack.alignContent = StackAlignContent::End;
+  layout = AS::LayoutCore::layout(node, {{0, 45}, {100, kInfinity}}, 2);
+  ASLCAssertEqualSizes(layout.size, 80, 45);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 0, 20);
+  ASLCAssertEqualPoints(layout.sublayouts[3].position, 40, 35);
+}
+
+static void testStackStretchesChildren()
+{
+  Size firstSize = {30, 20};
+  Size secondSize = {60, 10};
+  Node first;
+  first.measure = measureFixedSize;
+  first.context = &firstSize;
+  Node second;
+  second.measure = measureFixedSize;
+  second.context = &secondSize;
+  const Node node = stack(StackDirection::Vertical, {&first, &second});
+
+  const Layout layout = AS::LayoutCore::layout(node, {{0, 0}, {100, kInfinity}}, 2);
+  ASLCAssertEqualSizes(layout.size, 60, 30);
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 60, 20);
+  ASLCAssertEqualSizes(layout.sublayouts[1].size, 60, 10);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 0, 20);
+}
+
+static void testStackBaselineAlignment()
+{
+  Node first = leaf(20, 30);
+  Node second = leaf(20, 10);
+  first.style.ascender = 20;
+  second.style.ascender = 5;
+  Node node = stack(StackDirection::Horizontal, {&first, &second});
+  node.stack.alignItems = StackAlignItems::BaselineFirst;
+
+  const Layout layout = AS::LayoutCore::layout(node, kRange200x100, 2);
+  ASLCAssertEqualSizes(layout.size, 40, 30);
+  ASLCAssertEqualPoints(layout.sublayouts[0].position, 0, 0);
+  ASLCAssertEqualPoints(layout.sublayouts[1].position, 20, 15);
+}
+
+static void testStackFlexBasisResolvesAgainstParent()
+{
+  Node child;
+  child.style.flexBasis = fraction(0.25);
+  Node node = stack(StackDirection::Horizontal, {&child});
+  node.stack.alignItems = StackAlignItems::Start;
+
+  const Layout layout = AS::LayoutCore::layout(node, {{200, 0}, {200, 100}}, 2);
+  ASLCAssertEqualSizes(layout.sublayouts[0].size, 50, 100);
+  ASLCAssertEqualSizes(layout.size, 200, 100);
+}
+
+static void testEmptyStackTakesMinSize()
+{
+  const Node node = stack(StackDirection::Vertical, {});
+  const Layout layout = AS::LayoutCore::layout(node, {{10, 20}, {100, 100}}, 2);
+  ASLCAssertEqualSizes(layout.size, 10, 20);
+  ASLCAssert(layout.sublayouts.empty());
+}
+
+#pragma mark - Arena
+
+static void testArenaMatchesLayoutTree()
+{
+  Node first = leaf(90, 10);
+  first.style.flexShrink = 1;
+  const Node second = leaf(30, 10);
+  Node inner = stack(StackDirection::Horizontal, {&first, &second});
+  inner.style.flexShrink = 1;
+  Node inset;
+  inset.type = NodeType::Inset;
+  inset.insets = {1, 2, 3, 4};
+  inset.children = {&inner};
+  const Node outer = stack(StackDirection::Vertical, {&inset, &second});
+
+  const Layout layout = AS::LayoutCore::layout(outer, {{0, 0}, {100, kInfinity}}, 2);
+  LayoutArena arena;
+  const Frame &root = AS::LayoutCore::layout(arena, outer, {{0, 0}, {100, kInfinity}}, 2);
+  ASLCAssert(&root == &arena.root());
+  ASLCAssert(root.childCount == 2);
+
+  const Layout materialized = arena.materialize(root);
+  ASLCAssert(materialized.size == layout.size);
+  ASLCAssert(materialized.sublayouts.size() == 2);
+  const Layout &insetLayout = materialized.sublayouts[0];
+  ASLCAssert(insetLayout.node == &inset);
+  ASLCAssert(insetLayout.sublayouts.size() == 1);
+  ASLCAssert(insetLayout.sublayouts[0].position == layout.sublayouts[0].sublayouts[0].position);
+  ASLCAssertEqualSizes(insetLayout.sublayouts[0].sublayouts[0].size, 64, 10);
+  ASLCAssertEqualPoints(insetLayout.sublayouts[0].sublayouts[1].position, 64, 0);
+  ASLCAssert(materialized.sublayouts[1].position == layout.sublayouts[1].position);
+}
+
+static void testArenaReusesStorage()
+{
+  const Node content = leaf(90, 10);
+  Node first;
+  first.type = NodeType::Inset;
+  first.children = {&content};
+  first.style.flexShrink = 1;
+  const Node second = leaf(30, 10);
+  const Node node = stack(StackDirection::Horizontal, {&first, &second});
+
+  LayoutArena arena;
+  AS::LayoutCore::layout(arena, node, {{0, 0}, {100, 100}}, 2);
+  // The flexed inset was measured twice, the frame of its content from the first measurement stays in the arena until
+  // the next pass.
+  const size_t size = arena.size();
+  ASLCAssert(size == 5);
+  const size_t capacity = arena.capacity();
+
+  const Frame &root = AS::LayoutCore::layout(arena, node, {{0, 0}, {100, 100}}, 2);
+  ASLCAssert(arena.size() == size);
+  ASLCAssert(arena.capacity() == capacity);
+  ASLCAssertEqualSizes(arena.childrenBegin(root)[0].size, 70, 10);
+
+  arena.reset();
+  ASLCAssert(arena.size() == 0);
+  ASLCAssert(arena.capacity() == capacity);
+}
+
+int main()
+{
+  testIntersect();
+  testResolveElementSize();
+  testPixelRounding();
+  testInset();
+  testInfiniteInsetsCenterTheChild();
+  testRatio();
+  testRelative();
+  testStackJustifyAndAlignCenter();
+  testStackFlexShrink();
+  testStackFlexGrowGivesRemainderToFirstFlexibleChild();
+  testStackWrapsIntoLines();
+  testStackStretchesChildren();
+  testStackBaselineAlignment();
+  testStackFlexBasisResolvesAgainstParent();
+  testEmptyStackTakesMinSize();
+  testArenaMatchesLayoutTree();
+  testArenaReusesStorage();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d layout core assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All layout core tests passed\n");
+  return 0;
+}
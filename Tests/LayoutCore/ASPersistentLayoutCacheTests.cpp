@@ -0,0 +1,365 @@
+//
+//  ASPersistentLayoutCacheTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the persistent layout cache file format, so that they run on any platform. See
+// "./build.sh layout-core".
+
+#include "ASPersistentLayoutCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using AS::PersistentLayoutCache;
+
+static int failureCount = 0;
+
+#define ASPLCAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+static const uint64_t kSalt = 42;
+static const size_t kCapacity = 4096;
+
+// With kCapacity, the file has a 56 byte header and 64 buckets of 16 bytes before the data area. Records have a 40
+// byte header before their frames.
+static const long kDataOffset = 56 + 64 * 16;
+static const long kRecordHeaderSize = 40;
+
+static std::string temporaryPath()
+{
+  char path[] = "/tmp/ASPersistentLayoutCacheTests.XXXXXX";
+  const int fd = mkstemp(path);
+  ASPLCAssert(fd >= 0);
+  close(fd);
+  return path;
+}
+
+static PersistentLayoutCache::Entry makeEntry(double width, size_t frameCount)
+{
+  PersistentLayoutCache::Entry entry;
+  entry.width = width;
+  entry.height = 2 * width;
+  for (size_t i = 0; i < frameCount; i++) {
+    const double d = static_cast<double>(i);
+    entry.frames.push_back({d, d + 0.5, width - d, 10, i});
+  }
+  return entry;
+}
+
+static bool isEqual(const PersistentLayoutCache::Entry &lhs, const PersistentLayoutCache::Entry &rhs)
+{
+  if (lhs.width != rhs.width || lhs.height != rhs.height || lhs.frames.size() != rhs.frames.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.frames.size(); i++) {
+    const auto &a = lhs.frames[i];
+    const auto &b = rhs.frames[i];
+    if (a.x != b.x || a.y != b.y || a.width != b.width || a.height != b.height || a.element != b.element) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void overwriteByte(const std::string &path, long offset)
+{
+  FILE *file = std::fopen(path.c_str(), "r+b");
+  ASPLCAssert(file != nullptr);
+  std::fseek(file, offset, SEEK_SET);
+  const int byte = std::fgetc(file);
+  std::fseek(file, offset, SEEK_SET);
+  std::fputc(byte ^ 0xFF, file);
+  std::fclose(file);
+}
+
+static void truncateFile(const std::string &path, long length)
+{
+  ASPLCAssert(truncate(path.c_str(), length) == 0);
+}
+
+#pragma mark - Tests
+
+static void testRoundTrip()
+{
+  const std::string path = temporaryPath();
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+
+  const auto entry = makeEntry(320, 5);
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.store(1, entry));
+  ASPLCAssert(cache.store(2, makeEntry(375, 0)));
+  ASPLCAssert(cache.lookup(1, result));
+  ASPLCAssert(isEqual(result, entry));
+  ASPLCAssert(cache.lookup(2, result));
+  ASPLCAssert(isEqual(result, makeEntry(375, 0)));
+  ASPLCAssert(cache.count() == 2);
+  std::remove(path.c_str());
+}
+
+static void testEntriesSurviveReopening()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(7, makeEntry(414, 3)));
+  }
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(cache.lookup(7, result));
+  ASPLCAssert(isEqual(result, makeEntry(414, 3)));
+  std::remove(path.c_str());
+}
+
+static void testStoringAgainReplacesEntry()
+{
+  const std::string path = temporaryPath();
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  ASPLCAssert(cache.store(1, makeEntry(320, 2)));
+  ASPLCAssert(cache.store(1, makeEntry(375, 4)));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(cache.lookup(1, result));
+  ASPLCAssert(isEqual(result, makeEntry(375, 4)));
+  ASPLCAssert(cache.count() == 1);
+  std::remove(path.c_str());
+}
+
+static void testEntryWithoutFrames()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(3, makeEntry(320, 2)));
+    ASPLCAssert(cache.store(3, makeEntry(375, 0)));
+  }
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result = makeEntry(100, 1);
+  ASPLCAssert(cache.lookup(3, result));
+  ASPLCAssert(result.frames.empty());
+  ASPLCAssert(isEqual(result, makeEntry(375, 0)));
+  std::remove(path.c_str());
+}
+
+static void testCollidingKeys()
+{
+  const std::string path = temporaryPath();
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  // Both keys start probing at the same bucket.
+  ASPLCAssert(cache.store(3, makeEntry(1, 1)));
+  ASPLCAssert(cache.store(3 + 64, makeEntry(2, 1)));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(cache.lookup(3, result) && result.width == 1);
+  ASPLCAssert(cache.lookup(3 + 64, result) && result.width == 2);
+  ASPLCAssert(!cache.lookup(3 + 128, result));
+  std::remove(path.c_str());
+}
+
+static void testFullCacheResets()
+{
+  const std::string path = temporaryPath();
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  // Each entry takes 40 + 10 * 40 bytes, so the tenth doesn't fit anymore.
+  for (uint64_t key = 1; key <= 10; key++) {
+    ASPLCAssert(cache.store(key, makeEntry(key, 10)));
+  }
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.lookup(10, result));
+  ASPLCAssert(cache.count() == 1);
+  // Entries that can never fit are rejected.
+  ASPLCAssert(!cache.store(11, makeEntry(11, 1000)));
+  std::remove(path.c_str());
+}
+
+static void testSaltMismatchResets()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 1)));
+  }
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt + 1, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.count() == 0);
+  std::remove(path.c_str());
+}
+
+static void testCapacityChangeResets()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 1)));
+  }
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity * 2));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  std::remove(path.c_str());
+}
+
+static void testCorruptHeaderResets()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 1)));
+  }
+  // The data size.
+  overwriteByte(path, 32);
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.count() == 0);
+  ASPLCAssert(cache.store(1, makeEntry(320, 1)));
+  ASPLCAssert(cache.lookup(1, result));
+  std::remove(path.c_str());
+}
+
+static void testCorruptRecordIsAMiss()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 2)));
+    ASPLCAssert(cache.store(2, makeEntry(375, 2)));
+  }
+  // A byte of the first frame of the first record.
+  overwriteByte(path, kDataOffset + kRecordHeaderSize + 3);
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.lookup(2, result));
+  ASPLCAssert(isEqual(result, makeEntry(375, 2)));
+  std::remove(path.c_str());
+}
+
+static void testCorruptBucketIsAMiss()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 2)));
+  }
+  // The high byte of the offset of bucket 1, pointing it far outside the data area.
+  overwriteByte(path, 56 + 16 + 15);
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  std::remove(path.c_str());
+}
+
+static void testTruncatedFileResets()
+{
+  const std::string path = temporaryPath();
+  {
+    PersistentLayoutCache cache;
+    ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+    ASPLCAssert(cache.store(1, makeEntry(320, 2)));
+  }
+  truncateFile(path, kDataOffset + 10);
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(cache.store(1, makeEntry(320, 2)));
+  ASPLCAssert(cache.lookup(1, result));
+  std::remove(path.c_str());
+}
+
+static void testGarbageFileResets()
+{
+  const std::string path = temporaryPath();
+  FILE *file = std::fopen(path.c_str(), "wb");
+  for (int i = 0; i < 8192; i++) {
+    std::fputc(i * 31, file);
+  }
+  std::fclose(file);
+
+  PersistentLayoutCache cache;
+  ASPLCAssert(cache.open(path.c_str(), kSalt, kCapacity));
+  ASPLCAssert(cache.count() == 0);
+  std::remove(path.c_str());
+}
+
+static void testUnopenedCacheMisses()
+{
+  PersistentLayoutCache cache;
+  PersistentLayoutCache::Entry result;
+  ASPLCAssert(!cache.isOpen());
+  ASPLCAssert(!cache.store(1, makeEntry(320, 1)));
+  ASPLCAssert(!cache.lookup(1, result));
+  ASPLCAssert(!cache.open("/nonexistent-directory/cache", kSalt, kCapacity));
+}
+
+static void testHashIsStable()
+{
+  // Keys are persisted, so the hash must never change.
+  ASPLCAssert(PersistentLayoutCache::hash("", 0) == 14695981039346656037ULL);
+  ASPLCAssert(PersistentLayoutCache::hash("a", 1) == 0xaf63dc4c8601ec8cULL);
+  const uint64_t partial = PersistentLayoutCache::hash("ab", 2);
+  ASPLCAssert(PersistentLayoutCache::hash("c", 1, partial) == PersistentLayoutCache::hash("abc", 3));
+}
+
+int main()
+{
+  testRoundTrip();
+  testEntriesSurviveReopening();
+  testStoringAgainReplacesEntry();
+  testEntryWithoutFrames();
+  testCollidingKeys();
+  testFullCacheResets();
+  testSaltMismatchResets();
+  testCapacityChangeResets();
+  testCorruptHeaderResets();
+  testCorruptRecordIsAMiss();
+  testCorruptBucketIsAMiss();
+  testTruncatedFileResets();
+  testGarbageFileResets();
+  testUnopenedCacheMisses();
+  testHashIsStable();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d persistent layout cache assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All persistent layout cache tests passed\n");
+  return 0;
+}
@@ -0,0 +1,168 @@
+//
+//  ASRectIndexBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Queries 100k item collection layouts with viewport sized rects while scrolling through them, both with the rect
+// index and with the page buckets ASCollectionLayoutState used before, and reports the time and the number of heap
+// allocations per query. See "./build.sh layout-core".
+//
+// Usage: ASRectIndexBenchmark [queries]
+
+#include "ASRectIndex.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using AS::RectIndex;
+
+static size_t gAllocationCount = 0;
+
+void *operator new(size_t size)
+{
+  gAllocationCount++;
+  if (void *pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  std::abort();
+}
+
+void operator delete(void *pointer) noexcept
+{
+  std::free(pointer);
+}
+
+namespace {
+
+const double kViewportWidth = 375;
+const double kViewportHeight = 812;
+
+/** A single column of rows of varying height. */
+std::vector<RectIndex::Rect> makeList(size_t count)
+{
+  std::vector<RectIndex::Rect> rects;
+  double y = 0;
+  for (size_t i = 0; i < count; i++) {
+    const double height = 60 + (i * 37) % 140;
+    rects.push_back({0, y, kViewportWidth, y + height});
+    y += height;
+  }
+  return rects;
+}
+
+/** Two columns of tiles of varying height, each placed in the shorter column, with a full width header every 50. */
+std::vector<RectIndex::Rect> makeMasonry(size_t count)
+{
+  std::vector<RectIndex::Rect> rects;
+  double columns[2] = {0, 0};
+  const double columnWidth = kViewportWidth / 2;
+  for (size_t i = 0; i < count; i++) {
+    if (i % 50 == 0) {
+      const double y = std::max(columns[0], columns[1]);
+      rects.push_back({0, y, kViewportWidth, y + 44});
+      columns[0] = columns[1] = y + 44;
+      continue;
+    }
+    const int column = columns[0] <= columns[1] ? 0 : 1;
+    const double height = 120 + (i * 53) % 300;
+    rects.push_back({column * columnWidth, columns[column], (column + 1) * columnWidth, columns[column] + height});
+    columns[column] += height;
+  }
+  return rects;
+}
+
+/** Buckets rects by viewport sized pages, like ASPageTable, and deduplicates results spanning pages with a set. */
+class PageBuckets {
+public:
+  explicit PageBuckets(const std::vector<RectIndex::Rect> &rects) : _rects(rects)
+  {
+    for (size_t i = 0; i < rects.size(); i++) {
+      const RectIndex::Rect &rect = rects[i];
+      for (long page = pageForY(rect.minY); page <= pageForY(rect.maxY); page++) {
+        _pages[page].push_back(i);
+      }
+    }
+  }
+
+  template <typename Visitor>
+  void query(const RectIndex::Rect &rect, Visitor &&visitor) const
+  {
+    std::unordered_set<size_t> result;
+    for (long page = pageForY(rect.minY); page <= pageForY(rect.maxY); page++) {
+      const auto it = _pages.find(page);
+      if (it == _pages.end()) {
+        continue;
+      }
+      for (size_t i : it->second) {
+        if (rect.intersects(_rects[i])) {
+          result.insert(i);
+        }
+      }
+    }
+    for (size_t i : result) {
+      visitor(i);
+    }
+  }
+
+private:
+  static long pageForY(double y)
+  {
+    return static_cast<long>(std::floor(y / kViewportHeight));
+  }
+
+  const std::vector<RectIndex::Rect> &_rects;
+  std::unordered_map<long, std::vector<size_t>> _pages;
+};
+
+template <typename Index>
+void run(const char *layoutName, const char *indexName, const Index &index, double contentHeight, size_t queries)
+{
+  size_t resultCount = 0;
+  const size_t allocationCount = gAllocationCount;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < queries; i++) {
+    // Scroll through the whole content, querying the viewport grown by a preload range.
+    const double y = std::fmod(i * 997.0, contentHeight);
+    index.query({0, y - kViewportHeight, kViewportWidth, y + 2 * kViewportHeight}, [&](size_t) { resultCount++; });
+  }
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-8s %-13s: %8.1f ns per query, %6.2f allocations per query, %5.1f results per query\n", layoutName,
+              indexName, elapsed * 1e9 / queries, static_cast<double>(gAllocationCount - allocationCount) / queries,
+              static_cast<double>(resultCount) / queries);
+}
+
+void benchmark(const char *layoutName, const std::vector<RectIndex::Rect> &rects, size_t queries)
+{
+  double contentHeight = 0;
+  for (const auto &rect : rects) {
+    contentHeight = std::max(contentHeight, rect.maxY);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const RectIndex index(rects.data(), rects.size());
+  const double buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-8s %zu items, index built in %.1f ms, %.1f bytes per item\n", layoutName, rects.size(),
+              buildTime * 1e3, static_cast<double>(index.byteSize()) / rects.size());
+
+  run(layoutName, "rect index", index, contentHeight, queries);
+  run(layoutName, "page buckets", PageBuckets(rects), contentHeight, queries);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  const size_t queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  benchmark("list", makeList(100000), queries);
+  benchmark("masonry", makeMasonry(100000), queries);
+  return 0;
+}
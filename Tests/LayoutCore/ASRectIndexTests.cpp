@@ -0,0 +1,146 @@
+//
+//  ASRectIndexTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Plain C++ tests for the rect index, so that they run on any platform. See "./build.sh layout-core".
+
+#include "ASRectIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using AS::RectIndex;
+
+static int failureCount = 0;
+
+#define ASRIAssert(condition) \
+  do { \
+    if (!(condition)) { \
+      std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+      failureCount++; \
+    } \
+  } while (0)
+
+static std::vector<size_t> query(const RectIndex &index, const RectIndex::Rect &rect)
+{
+  std::vector<size_t> result;
+  index.query(rect, [&](size_t i) { result.push_back(i); });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+static std::vector<size_t> bruteForce(const std::vector<RectIndex::Rect> &rects, const RectIndex::Rect &rect)
+{
+  std::vector<size_t> result;
+  for (size_t i = 0; i < rects.size(); i++) {
+    if (rect.intersects(rects[i]) || rect.contains(rects[i])) {
+      result.push_back(i);
+    }
+  }
+  return result;
+}
+
+static void testEmptyIndex()
+{
+  RectIndex empty;
+  ASRIAssert(empty.count() == 0);
+  ASRIAssert(query(empty, {0, 0, 100, 100}).empty());
+
+  RectIndex alsoEmpty(nullptr, 0);
+  ASRIAssert(query(alsoEmpty, {0, 0, 100, 100}).empty());
+}
+
+static void testSingleRect()
+{
+  const RectIndex::Rect rect = {10, 10, 20, 20};
+  RectIndex index(&rect, 1);
+  ASRIAssert(index.count() == 1);
+  ASRIAssert(query(index, {0, 0, 15, 15}) == std::vector<size_t>{0});
+  ASRIAssert(query(index, {0, 0, 100, 100}) == std::vector<size_t>{0});
+  ASRIAssert(query(index, {12, 12, 13, 13}) == std::vector<size_t>{0});
+  ASRIAssert(query(index, {30, 30, 40, 40}).empty());
+}
+
+static void testSharedEdgesDontIntersect()
+{
+  // A column of 100 point tall rows.
+  std::vector<RectIndex::Rect> rows;
+  for (int i = 0; i < 100; i++) {
+    rows.push_back({0, i * 100.0, 320, (i + 1) * 100.0});
+  }
+  RectIndex index(rows.data(), rows.size());
+  ASRIAssert(query(index, {0, 1000, 320, 1200}) == (std::vector<size_t>{10, 11}));
+  ASRIAssert(query(index, {0, 999, 320, 1001}) == (std::vector<size_t>{9, 10}));
+  ASRIAssert(query(index, {320, 0, 400, 10000}).empty());
+}
+
+static void testZeroSizedRectsWithinTheQueryAreReported()
+{
+  const std::vector<RectIndex::Rect> rects = {{50, 50, 50, 50}, {0, 10, 100, 10}, {200, 200, 200, 200}};
+  RectIndex index(rects.data(), rects.size());
+  ASRIAssert(query(index, {0, 0, 100, 100}) == (std::vector<size_t>{0, 1}));
+}
+
+static void testMatchesBruteForce()
+{
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> position(0, 10000);
+  std::uniform_real_distribution<double> length(0, 400);
+  for (size_t count : {1, 15, 16, 17, 255, 256, 257, 5000}) {
+    std::vector<RectIndex::Rect> rects;
+    for (size_t i = 0; i < count; i++) {
+      const double x = position(random) / 10;
+      const double y = position(random);
+      // Some rects are zero sized, as are elements that haven't been measured.
+      const double width = (i % 10 == 0) ? 0 : length(random);
+      rects.push_back({x, y, x + width, y + length(random)});
+    }
+    RectIndex index(rects.data(), rects.size());
+    ASRIAssert(index.count() == count);
+    for (int i = 0; i < 200; i++) {
+      const double x = position(random) / 10;
+      const double y = position(random);
+      const RectIndex::Rect rect = {x, y, x + length(random), y + 4 * length(random)};
+      ASRIAssert(query(index, rect) == bruteForce(rects, rect));
+    }
+    // A query that contains everything.
+    ASRIAssert(query(index, {-1, -1, 20000, 20000}).size() == count);
+  }
+}
+
+static void testEachRectIsReportedOnce()
+{
+  // Rects that span many others, like full width headers in a masonry layout.
+  std::vector<RectIndex::Rect> rects;
+  for (int i = 0; i < 1000; i++) {
+    const double y = (i / 3) * 50.0;
+    rects.push_back(i % 100 == 0 ? RectIndex::Rect{0, y, 320, y + 2000} : RectIndex::Rect{(i % 3) * 100.0, y, (i % 3) * 100.0 + 100, y + 80});
+  }
+  RectIndex index(rects.data(), rects.size());
+  const std::vector<size_t> result = query(index, {0, 3000, 320, 9000});
+  ASRIAssert(std::adjacent_find(result.begin(), result.end()) == result.end());
+  ASRIAssert(result == bruteForce(rects, {0, 3000, 320, 9000}));
+}
+
+int main()
+{
+  testEmptyIndex();
+  testSingleRect();
+  testSharedEdgesDontIntersect();
+  testZeroSizedRectsWithinTheQueryAreReported();
+  testMatchesBruteForce();
+  testEachRectIsReportedOnce();
+
+  if (failureCount > 0) {
+    std::fprintf(stderr, "%d rect index assertion(s) failed\n", failureCount);
+    return 1;
+  }
+  std::printf("All rect index tests passed\n");
+  return 0;
+}
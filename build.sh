@@ -267,6 +267,74 @@ carthage|all)
     success="1"
     ;;
 
+layout-core|all)
+    echo "Building & testing the layout core."
+
+    # The layout core, the persistent layout cache and the rect index are plain C++, so this only needs a C++11
+    # compiler and works on any platform.
+    build_dir=$(mktemp -d)
+    for target in ASLayoutCoreTests ASPersistentLayoutCacheTests ASRectIndexTests ASLayoutCoreBenchmark ASRectIndexBenchmark; do
+        ${CXX:-c++} -std=c++11 -O2 -fno-exceptions -Wall -Wno-unknown-pragmas -Wno-unused-parameter \
+            -ISource/Private/Layout \
+            -x c++ Source/Private/Layout/ASLayoutCore.mm Source/Private/Layout/ASPersistentLayoutCache.mm \
+            Source/Private/Layout/ASRectIndex.mm \
+            -x none "Tests/LayoutCore/${target}.cpp" \
+            -o "${build_dir}/${target}"
+        "${build_dir}/${target}"
+    done
+    rm -rf "$build_dir"
+    success="1"
+    ;;
+
+hashing|all)
+    echo "Building & testing the hashing kernel."
+
+    # Like the layout core, the hashing kernel is plain C++ and works on any platform.
+    build_dir=$(mktemp -d)
+    for target in ASHasherTests ASHasherBenchmark; do
+        ${CXX:-c++} -std=c++11 -O2 -fno-exceptions -Wall -Wno-unknown-pragmas \
+            -ISource/Details \
+            -x c++ Source/Details/ASHasher.mm \
+            -x none "Tests/Hashing/${target}.cpp" \
+            -o "${build_dir}/${target}"
+        "${build_dir}/${target}"
+    done
+    rm -rf "$build_dir"
+    success="1"
+    ;;
+
+image-downsampling|all)
+    echo "Building & testing the image downsampling math."
+
+    # Like the layout core, the downsampling math is plain C++ and works on any platform.
+    build_dir=$(mktemp -d)
+    ${CXX:-c++} -std=c++11 -O2 -fno-exceptions -Wall -Wno-unknown-pragmas \
+        -ISource/Private \
+        -x c++ Source/Private/ASImageDownsampling.mm \
+        -x none Tests/ImageDownsampling/ASImageDownsamplingTests.cpp \
+        -o "${build_dir}/ASImageDownsamplingTests"
+    "${build_dir}/ASImageDownsamplingTests"
+    rm -rf "$build_dir"
+    success="1"
+    ;;
+
+download-scheduling|all)
+    echo "Building & testing the image download scheduler."
+
+    # Like the layout core, the download scheduler is plain C++ and works on any platform.
+    build_dir=$(mktemp -d)
+    for target in ASImageDownloadSchedulerTests ASImageDownloadSchedulerBenchmark; do
+        ${CXX:-c++} -std=c++11 -O2 -fno-exceptions -Wall -Wno-unknown-pragmas \
+            -ISource/Private \
+            -x c++ Source/Private/ASImageDownloadScheduler.mm \
+            -x none "Tests/DownloadScheduling/${target}.cpp" \
+            -o "${build_dir}/${target}"
+        "${build_dir}/${target}"
+    done
+    rm -rf "$build_dir"
+    success="1"
+    ;;
+
 *)
     echo "Unrecognized mode '$MODE'."
     ;;